@@ -673,6 +673,9 @@ class CYCLES_RENDER_PT_performance_final_render(CyclesButtonsPanel, Panel):
         col = layout.column()
 
         col.prop(rd, "use_save_buffers")
+        sub = col.column()
+        sub.active = rd.use_save_buffers
+        sub.prop(rd, "use_stream_output")
         col.prop(rd, "use_persistent_data", text="Persistent Images")
 
 
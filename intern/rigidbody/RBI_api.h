@@ -237,6 +237,14 @@ rbCollisionShape *RB_shape_new_trimesh(rbMeshData *mesh);
 /* 2b - GImpact Meshes */
 rbCollisionShape *RB_shape_new_gimpact_mesh(rbMeshData *mesh);
 
+/* Setup (Instances) -------------- */
+
+/* Create a shape which shares the geometry of a convex hull or triangle mesh shape,
+ * so it doesn't have to be computed again. Scaling and margin are still per shape,
+ * the mesh data is freed with the last shape using it.
+ * Returns NULL for other shape types. */
+rbCollisionShape *RB_shape_new_instance(rbCollisionShape *shape);
+
 
 /* Cleanup --------------------------- */
 
@@ -99,6 +99,9 @@ struct rbMeshData {
 	rbTri *triangles;
 	int num_vertices;
 	int num_triangles;
+	/* number of shapes using this data, shapes instanced from a triangle mesh also share its BVH */
+	int users;
+	btBvhTriangleMeshShape *bvh_shape;
 };
 
 struct rbCollisionShape {
@@ -721,12 +724,16 @@ rbMeshData *RB_trimesh_data_new(int num_tris, int num_verts)
 	mesh->triangles = new rbTri[num_tris];
 	mesh->num_vertices = num_verts;
 	mesh->num_triangles = num_tris;
+	mesh->users = 0;
+	mesh->bvh_shape = NULL;
 	
 	return mesh;
 }
 
 static void RB_trimesh_data_delete(rbMeshData *mesh)
 {
+	if (mesh->bvh_shape)
+		delete mesh->bvh_shape;
 	delete mesh->index_array;
 	delete[] mesh->vertices;
 	delete[] mesh->triangles;
@@ -765,6 +772,8 @@ rbCollisionShape *RB_shape_new_trimesh(rbMeshData *mesh)
 	
 	shape->cshape = new btScaledBvhTriangleMeshShape(unscaledShape, btVector3(1.0f, 1.0f, 1.0f));
 	shape->mesh = mesh;
+	mesh->bvh_shape = unscaledShape;
+	mesh->users++;
 	return shape;
 }
 
@@ -800,19 +809,56 @@ rbCollisionShape *RB_shape_new_gimpact_mesh(rbMeshData *mesh)
 	
 	shape->cshape = gimpactShape;
 	shape->mesh = mesh;
+	mesh->users++;
 	return shape;
 }
 
-/* Cleanup --------------------------- */
+/* Setup (Instances) -------------- */
 
-void RB_shape_delete(rbCollisionShape *shape)
+rbCollisionShape *RB_shape_new_instance(rbCollisionShape *source)
 {
-	if (shape->cshape->getShapeType() == SCALED_TRIANGLE_MESH_SHAPE_PROXYTYPE) {
-		btBvhTriangleMeshShape *child_shape = ((btScaledBvhTriangleMeshShape *)shape->cshape)->getChildShape();
-		if (child_shape)
-			delete child_shape;
+	btCollisionShape *cshape = NULL;
+	
+	switch (source->cshape->getShapeType()) {
+		case CONVEX_HULL_SHAPE_PROXYTYPE:
+		{
+			/* copy the points, that's cheap compared to computing the hull again */
+			btConvexHullShape *hull_shape = (btConvexHullShape *)source->cshape;
+			cshape = new btConvexHullShape(&(hull_shape->getUnscaledPoints()[0].getX()), hull_shape->getNumPoints());
+			break;
+		}
+		case SCALED_TRIANGLE_MESH_SHAPE_PROXYTYPE:
+			/* the scaled wrapper only holds the scaling, the BVH is shared */
+			if (source->mesh && source->mesh->bvh_shape)
+				cshape = new btScaledBvhTriangleMeshShape(source->mesh->bvh_shape, btVector3(1.0f, 1.0f, 1.0f));
+			break;
+		case GIMPACT_SHAPE_PROXYTYPE:
+		{
+			/* GImpact keeps scaling and bounds in the shape, only the mesh data can be shared */
+			btGImpactMeshShape *gimpactShape = new btGImpactMeshShape(source->mesh->index_array);
+			gimpactShape->updateBound();
+			cshape = gimpactShape;
+			break;
+		}
 	}
+	
+	if (cshape == NULL)
+		return NULL;
+	
+	rbCollisionShape *shape = new rbCollisionShape;
+	shape->cshape = cshape;
+	shape->mesh = source->mesh;
 	if (shape->mesh)
+		shape->mesh->users++;
+	return shape;
+}
+
+/* Cleanup --------------------------- */
+
+void RB_shape_delete(rbCollisionShape *shape)
+{
+	/* the BVH of triangle meshes is freed with the mesh data, which may be shared */
+	if (shape->mesh && --shape->mesh->users == 0)
 		RB_trimesh_data_delete(shape->mesh);
 	delete shape->cshape;
 	delete shape;
@@ -0,0 +1,258 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): Blender Foundation
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file smoke/intern/BRICK_GRID.cpp
+ *  \ingroup smoke
+ */
+
+#include "BRICK_GRID.h"
+
+#include <cmath>
+#include <cstring>
+
+#if PARALLEL==1
+#include <omp.h>
+#endif // PARALLEL
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+BRICK_GRID::BRICK_GRID(int xRes, int yRes, int zRes) :
+	_xRes(xRes), _yRes(yRes), _zRes(zRes)
+{
+	_xBricks = (xRes + BRICK_SIZE - 1) >> BRICK_SHIFT;
+	_yBricks = (yRes + BRICK_SIZE - 1) >> BRICK_SHIFT;
+	_zBricks = (zRes + BRICK_SIZE - 1) >> BRICK_SHIFT;
+	_slabBricks = _xBricks * _yBricks;
+	_totalBricks = _slabBricks * _zBricks;
+
+	_active = new unsigned char[_totalBricks];
+	setAll(true);
+}
+
+BRICK_GRID::~BRICK_GRID()
+{
+	delete[] _active;
+}
+
+void BRICK_GRID::setAll(bool active)
+{
+	memset(_active, active ? 1 : 0, _totalBricks);
+}
+
+int BRICK_GRID::totalActive() const
+{
+	int total = 0;
+
+	for (int i = 0; i < _totalBricks; i++)
+		total += _active[i];
+
+	return total;
+}
+
+//////////////////////////////////////////////////////////////////////
+// activate bricks with non empty cells, one layer of bricks per thread
+//////////////////////////////////////////////////////////////////////
+void BRICK_GRID::markField(const float* field, float threshold)
+{
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static)
+#endif
+	for (int bz = 0; bz < _zBricks; bz++)
+	{
+		const int zBegin = bz << BRICK_SHIFT;
+		const int zEnd = (zBegin + BRICK_SIZE < _zRes) ? zBegin + BRICK_SIZE : _zRes;
+
+		for (int z = zBegin; z < zEnd; z++)
+			for (int y = 0; y < _yRes; y++)
+			{
+				const float* row = field + ((size_t)z * _yRes + y) * _xRes;
+				unsigned char* active = _active + (y >> BRICK_SHIFT) * _xBricks + bz * _slabBricks;
+
+				for (int bx = 0; bx < _xBricks; bx++)
+				{
+					if (active[bx])
+						continue;
+
+					const int xBegin = bx << BRICK_SHIFT;
+					const int xEnd = (xBegin + BRICK_SIZE < _xRes) ? xBegin + BRICK_SIZE : _xRes;
+
+					for (int x = xBegin; x < xEnd; x++)
+						if (fabsf(row[x]) > threshold) {
+							active[bx] = 1;
+							break;
+						}
+				}
+			}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// largest velocity component per brick
+//////////////////////////////////////////////////////////////////////
+void BRICK_GRID::maxVelocity(const float* velx, const float* vely, const float* velz, float* maxVel) const
+{
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static)
+#endif
+	for (int bz = 0; bz < _zBricks; bz++)
+	{
+		const int zBegin = bz << BRICK_SHIFT;
+		const int zEnd = (zBegin + BRICK_SIZE < _zRes) ? zBegin + BRICK_SIZE : _zRes;
+		float* layer = maxVel + bz * _slabBricks;
+
+		for (int i = 0; i < _slabBricks; i++)
+			layer[i] = 0.0f;
+
+		for (int z = zBegin; z < zEnd; z++)
+			for (int y = 0; y < _yRes; y++)
+			{
+				const size_t index = ((size_t)z * _yRes + y) * _xRes;
+				float* row = layer + (y >> BRICK_SHIFT) * _xBricks;
+
+				for (int x = 0; x < _xRes; x++)
+				{
+					float vel = fabsf(velx[index + x]);
+					vel = (fabsf(vely[index + x]) > vel) ? fabsf(vely[index + x]) : vel;
+					vel = (fabsf(velz[index + x]) > vel) ? fabsf(velz[index + x]) : vel;
+
+					float& brickVel = row[x >> BRICK_SHIFT];
+					brickVel = (vel > brickVel) ? vel : brickVel;
+				}
+			}
+	}
+}
+
+float BRICK_GRID::maxInRange(const float* values, int bx, int by, int bz, int radius) const
+{
+	const int xBegin = (bx - radius > 0) ? bx - radius : 0;
+	const int yBegin = (by - radius > 0) ? by - radius : 0;
+	const int zBegin = (bz - radius > 0) ? bz - radius : 0;
+	const int xEnd = (bx + radius < _xBricks - 1) ? bx + radius : _xBricks - 1;
+	const int yEnd = (by + radius < _yBricks - 1) ? by + radius : _yBricks - 1;
+	const int zEnd = (bz + radius < _zBricks - 1) ? bz + radius : _zBricks - 1;
+	float result = 0.0f;
+
+	for (int z = zBegin; z <= zEnd; z++)
+		for (int y = yBegin; y <= yEnd; y++)
+			for (int x = xBegin; x <= xEnd; x++)
+			{
+				const float value = values[x + y * _xBricks + z * _slabBricks];
+				result = (value > result) ? value : result;
+			}
+
+	return result;
+}
+
+//////////////////////////////////////////////////////////////////////
+// activate every brick that has an active brick within its reach
+// (in cells), counting active bricks in boxes with a summed volume
+// table
+//////////////////////////////////////////////////////////////////////
+void BRICK_GRID::dilate(const float* reach)
+{
+	const int sx = _xBricks + 1, sy = _yBricks + 1, sz = _zBricks + 1;
+	int* sum = new int[sx * sy * sz];
+
+	memset(sum, 0, sizeof(int) * sx * sy);
+	for (int z = 1; z < sz; z++)
+	{
+		for (int x = 0; x < sx; x++)
+			sum[x + z * sx * sy] = 0;
+
+		for (int y = 1; y < sy; y++)
+		{
+			int* s = sum + y * sx + z * sx * sy;
+			const unsigned char* active = _active + (y - 1) * _xBricks + (z - 1) * _slabBricks;
+
+			s[0] = 0;
+			for (int x = 1; x < sx; x++)
+				s[x] = active[x - 1] + s[x - 1] + s[x - sx] + s[x - sx * sy]
+				       - s[x - 1 - sx] - s[x - 1 - sx * sy] - s[x - sx - sx * sy]
+				       + s[x - 1 - sx - sx * sy];
+		}
+	}
+
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static)
+#endif
+	for (int bz = 0; bz < _zBricks; bz++)
+		for (int by = 0; by < _yBricks; by++)
+			for (int bx = 0; bx < _xBricks; bx++)
+			{
+				const int index = bx + by * _xBricks + bz * _slabBricks;
+				const int radius = (int)ceilf(reach[index] / BRICK_SIZE);
+
+				const int x0 = (bx - radius > 0) ? bx - radius : 0;
+				const int y0 = (by - radius > 0) ? by - radius : 0;
+				const int z0 = (bz - radius > 0) ? bz - radius : 0;
+				const int x1 = (bx + radius + 1 < sx) ? bx + radius + 1 : sx - 1;
+				const int y1 = (by + radius + 1 < sy) ? by + radius + 1 : sy - 1;
+				const int z1 = (bz + radius + 1 < sz) ? bz + radius + 1 : sz - 1;
+
+				const int count =
+					sum[x1 + y1 * sx + z1 * sx * sy] - sum[x0 + y1 * sx + z1 * sx * sy] -
+					sum[x1 + y0 * sx + z1 * sx * sy] - sum[x1 + y1 * sx + z0 * sx * sy] +
+					sum[x0 + y0 * sx + z1 * sx * sy] + sum[x0 + y1 * sx + z0 * sx * sy] +
+					sum[x1 + y0 * sx + z0 * sx * sy] - sum[x0 + y0 * sx + z0 * sx * sy];
+
+				_active[index] = (count > 0) ? 1 : 0;
+			}
+
+	delete[] sum;
+}
+
+//////////////////////////////////////////////////////////////////////
+// A MacCormack step traces back from a cell with the velocity of the
+// cell, then forward again from the cells read by the first trace,
+// using their velocities. Each trace also reads the neighbors for the
+// interpolation. The velocities are bounded per brick.
+//////////////////////////////////////////////////////////////////////
+void BRICK_GRID::dilateAdvection(const float* velx, const float* vely, const float* velz, float dt, int steps)
+{
+	float* maxVel = new float[_totalBricks];
+	float* reach = new float[_totalBricks];
+
+	maxVelocity(velx, vely, velz, maxVel);
+
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static)
+#endif
+	for (int bz = 0; bz < _zBricks; bz++)
+		for (int by = 0; by < _yBricks; by++)
+			for (int bx = 0; bx < _xBricks; bx++)
+			{
+				const int index = bx + by * _xBricks + bz * _slabBricks;
+				const float trace = dt * maxVel[index] + 1.0f;
+				const int traceBricks = (int)ceilf(trace / BRICK_SIZE);
+				const float traceNear = dt * maxInRange(maxVel, bx, by, bz, traceBricks) + 1.0f;
+
+				reach[index] = trace + traceNear;
+			}
+
+	for (int i = 0; i < steps; i++)
+		dilate(reach);
+
+	delete[] maxVel;
+	delete[] reach;
+}
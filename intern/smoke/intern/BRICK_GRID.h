@@ -0,0 +1,83 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): Blender Foundation
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file smoke/intern/BRICK_GRID.h
+ *  \ingroup smoke
+ */
+//////////////////////////////////////////////////////////////////////
+// BRICK_GRID.h: activity of a smoke grid in bricks of 8^3 cells.
+//
+// A brick is active when any of the marked fields has a value above
+// the threshold in one of its cells, or when advection can carry such
+// a value into it. This is only an activity mask: the fields keep
+// their dense storage over the whole domain, loops use the bricks to
+// skip work on cells that are known to stay empty.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef BRICK_GRID_H
+#define BRICK_GRID_H
+
+#define BRICK_SHIFT 3
+#define BRICK_SIZE (1 << BRICK_SHIFT)
+
+// cells with absolute values at or below this are considered empty
+#define BRICK_EMPTY_THRESHOLD 1e-6f
+
+struct BRICK_GRID
+{
+	public:
+		// all bricks start active
+		BRICK_GRID(int xRes, int yRes, int zRes);
+		virtual ~BRICK_GRID();
+
+		void setAll(bool active);
+
+		// activate bricks with cells where |field| > threshold
+		void markField(const float* field, float threshold);
+
+		// activate bricks that MacCormack advection over the given number
+		// of steps can carry values of active bricks into, dt in cells
+		void dilateAdvection(const float* velx, const float* vely, const float* velz, float dt, int steps);
+
+		int totalActive() const;
+
+		inline bool activeCell(int x, int y, int z) const {
+			return _active[(x >> BRICK_SHIFT) + (y >> BRICK_SHIFT) * _xBricks + (z >> BRICK_SHIFT) * _slabBricks] != 0;
+		}
+
+		// dimensions in cells
+		int _xRes, _yRes, _zRes;
+
+		// dimensions in bricks
+		int _xBricks, _yBricks, _zBricks;
+		int _slabBricks;
+		int _totalBricks;
+
+		unsigned char* _active;
+
+	private:
+		void maxVelocity(const float* velx, const float* vely, const float* velz, float* maxVel) const;
+		float maxInRange(const float* values, int bx, int by, int bz, int radius) const;
+		void dilate(const float* reach);
+};
+
+#endif
@@ -32,6 +32,8 @@
 #include "IMAGE.h"
 #include <INTERPOLATE.h>
 #include "SPHERE.h"
+#include "MULTIGRID.h"
+#include "BRICK_GRID.h"
 #include <zlib.h>
 
 #include "float.h"
@@ -140,6 +142,9 @@ FLUID_3D::FLUID_3D(int *res, float dx, float dtdef, int init_heat, int init_fire
 		initColors(0.0f, 0.0f, 0.0f);
 	}
 
+	_bricks = new BRICK_GRID(_xRes, _yRes, _zRes);
+	_bricksHeat = new BRICK_GRID(_xRes, _yRes, _zRes);
+
 	// boundary conditions of the fluid domain
 	// set default values -> vertically non-colliding
 	_domainBcFront = true;
@@ -302,6 +307,9 @@ FLUID_3D::~FLUID_3D()
 	if (_color_bOld) delete[] _color_bOld;
 	if (_color_bTemp) delete[] _color_bTemp;
 
+	if (_bricks) delete _bricks;
+	if (_bricksHeat) delete _bricksHeat;
+
     // printf("deleted fluid\n");
 }
 
@@ -400,30 +408,24 @@ void FLUID_3D::step(float dt, float gravity[3])
 	SWAP_POINTERS(_zVelocity, _zVelocityTemp);
 #if PARALLEL==1
 	}	// end of single
+	}	// end of parallel
 
-	#pragma omp barrier
-
-	#pragma omp for
-	for (int i=0; i<2; i++)
-	{
-		if (i==0)
-		{
-#endif
-			project();
-#if PARALLEL==1
-		}
-		else if (i==1)
-		{
+	/*
+	* The pressure solve runs its own loops over z-slabs,
+	* so it is called outside of the parallel section.
+	*/
 #endif
-			if (_heat) {
-				diffuseHeat();
-			}
-#if PARALLEL==1
-		}
+	project();
+
+	if (_heat) {
+		diffuseHeat();
 	}
 
-	#pragma omp barrier
+	updateActiveBricks();
 
+#if PARALLEL==1
+	#pragma omp parallel
+	{
 	#pragma omp single
 	{
 #endif
@@ -997,7 +999,10 @@ void FLUID_3D::project()
 	fixObstacleCompression(_divergence);
 
 	// solve Poisson equation
-	solvePressurePre(_pressure, _divergence, _obstacles);
+	if (MULTIGRID::supported(_xRes, _yRes, _zRes))
+		solvePressureMG(_pressure, _divergence, _obstacles);
+	else
+		solvePressurePre(_pressure, _divergence, _obstacles);
 
 	setObstaclePressure(_pressure, 0, _zRes);
 
@@ -1651,18 +1656,18 @@ void FLUID_3D::advectMacCormackEnd1(int zBegin, int zEnd)
 
 	// advectFieldMacCormack1(dt, xVelocity, yVelocity, zVelocity, oldField, newField, res)
 
-	advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _densityOld, _densityTemp, res, zBegin, zEnd);
+	advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _densityOld, _densityTemp, res, zBegin, zEnd, _bricks);
 	if (_heat) {
-		advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _heatOld, _heatTemp, res, zBegin, zEnd);
+		advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _heatOld, _heatTemp, res, zBegin, zEnd, _bricksHeat);
 	}
 	if (_fuel) {
-		advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _fuelOld, _fuelTemp, res, zBegin, zEnd);
-		advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _reactOld, _reactTemp, res, zBegin, zEnd);
+		advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _fuelOld, _fuelTemp, res, zBegin, zEnd, _bricks);
+		advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _reactOld, _reactTemp, res, zBegin, zEnd, _bricks);
 	}
 	if (_color_r) {
-		advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _color_rOld, _color_rTemp, res, zBegin, zEnd);
-		advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _color_gOld, _color_gTemp, res, zBegin, zEnd);
-		advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _color_bOld, _color_bTemp, res, zBegin, zEnd);
+		advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _color_rOld, _color_rTemp, res, zBegin, zEnd, _bricks);
+		advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _color_gOld, _color_gTemp, res, zBegin, zEnd, _bricks);
+		advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _color_bOld, _color_bTemp, res, zBegin, zEnd, _bricks);
 	}
 	advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _xVelocityOld, _xVelocity, res, zBegin, zEnd);
 	advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _yVelocityOld, _yVelocity, res, zBegin, zEnd);
@@ -1685,18 +1690,18 @@ void FLUID_3D::advectMacCormackEnd2(int zBegin, int zEnd)
 	// advectFieldMacCormack2(dt, xVelocity, yVelocity, zVelocity, oldField, newField, tempfield, temp, res, obstacles)
 
 	/* finish advection */
-	advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _densityOld, _density, _densityTemp, t1, res, _obstacles, zBegin, zEnd);
+	advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _densityOld, _density, _densityTemp, t1, res, _obstacles, zBegin, zEnd, _bricks);
 	if (_heat) {
-		advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _heatOld, _heat, _heatTemp, t1, res, _obstacles, zBegin, zEnd);
+		advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _heatOld, _heat, _heatTemp, t1, res, _obstacles, zBegin, zEnd, _bricksHeat);
 	}
 	if (_fuel) {
-		advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _fuelOld, _fuel, _fuelTemp, t1, res, _obstacles, zBegin, zEnd);
-		advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _reactOld, _react, _reactTemp, t1, res, _obstacles, zBegin, zEnd);
+		advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _fuelOld, _fuel, _fuelTemp, t1, res, _obstacles, zBegin, zEnd, _bricks);
+		advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _reactOld, _react, _reactTemp, t1, res, _obstacles, zBegin, zEnd, _bricks);
 	}
 	if (_color_r) {
-		advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _color_rOld, _color_r, _color_rTemp, t1, res, _obstacles, zBegin, zEnd);
-		advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _color_gOld, _color_g, _color_gTemp, t1, res, _obstacles, zBegin, zEnd);
-		advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _color_bOld, _color_b, _color_bTemp, t1, res, _obstacles, zBegin, zEnd);
+		advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _color_rOld, _color_r, _color_rTemp, t1, res, _obstacles, zBegin, zEnd, _bricks);
+		advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _color_gOld, _color_g, _color_gTemp, t1, res, _obstacles, zBegin, zEnd, _bricks);
+		advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _color_bOld, _color_b, _color_bTemp, t1, res, _obstacles, zBegin, zEnd, _bricks);
 	}
 	advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _xVelocityOld, _xVelocityTemp, _xVelocity, t1, res, _obstacles, zBegin, zEnd);
 	advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _yVelocityOld, _yVelocityTemp, _yVelocity, t1, res, _obstacles, zBegin, zEnd);
@@ -1726,6 +1731,36 @@ void FLUID_3D::advectMacCormackEnd2(int zBegin, int zEnd)
 }
 
 
+//////////////////////////////////////////////////////////////////////
+// Find the bricks the scalar fields can reach during advection.
+// Heat diffuses into the whole domain quickly, so it gets bricks of
+// its own to keep the smoke bricks tight.
+//////////////////////////////////////////////////////////////////////
+void FLUID_3D::updateActiveBricks()
+{
+	const float dt0 = _dt / _dx;
+
+	_bricks->setAll(false);
+	_bricks->markField(_density, BRICK_EMPTY_THRESHOLD);
+	if (_fuel) {
+		_bricks->markField(_fuel, BRICK_EMPTY_THRESHOLD);
+		_bricks->markField(_react, BRICK_EMPTY_THRESHOLD);
+	}
+	if (_color_r) {
+		_bricks->markField(_color_r, BRICK_EMPTY_THRESHOLD);
+		_bricks->markField(_color_g, BRICK_EMPTY_THRESHOLD);
+		_bricks->markField(_color_b, BRICK_EMPTY_THRESHOLD);
+	}
+	_bricks->dilateAdvection(_xVelocity, _yVelocity, _zVelocity, dt0, 1);
+
+	if (_heat) {
+		_bricksHeat->setAll(false);
+		_bricksHeat->markField(_heat, BRICK_EMPTY_THRESHOLD);
+		_bricksHeat->dilateAdvection(_xVelocity, _yVelocity, _zVelocity, dt0, 1);
+	}
+}
+
+
 void FLUID_3D::processBurn(float *fuel, float *smoke, float *react, float *heat,
 						   float *r, float *g, float *b, int total_cells, float dt)
 {
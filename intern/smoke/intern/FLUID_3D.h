@@ -42,6 +42,7 @@
 using namespace std;
 using namespace BasicVector;
 struct WTURBULENCE;
+struct BRICK_GRID;
 
 struct FLUID_3D  
 {
@@ -140,6 +141,9 @@ struct FLUID_3D
 		float *_color_bOld;
 		float *_color_bTemp;
 
+		// bricks the smoke fields and the heat can reach in the current step
+		BRICK_GRID* _bricks;
+		BRICK_GRID* _bricksHeat;
 
 		// CG fields
 		int _iterations;
@@ -187,6 +191,7 @@ struct FLUID_3D
 		void diffuseColor();
 		void solvePressure(float* field, float* b, unsigned char* skip);
 		void solvePressurePre(float* field, float* b, unsigned char* skip);
+		void solvePressureMG(float* field, float* b, unsigned char* skip);
 		void solveHeat(float* field, float* b, unsigned char* skip);
 		void solveDiffusion(float* field, float* b, float* factor);
 
@@ -203,6 +208,7 @@ struct FLUID_3D
 		void advectMacCormackBegin(int zBegin, int zEnd);
 		void advectMacCormackEnd1(int zBegin, int zEnd);
 		void advectMacCormackEnd2(int zBegin, int zEnd);
+		void updateActiveBricks();
 
 		void floodFillComponent(int *components, size_t *queue, size_t limit, size_t start, int from, int to);
 		void mergeComponents(int *components, size_t *queue, size_t cur, size_t other);
@@ -238,11 +244,12 @@ struct FLUID_3D
 
 		// static advection functions, also used by WTURBULENCE
 		static void advectFieldSemiLagrange(const float dt, const float* velx, const float* vely,  const float* velz,
-				float* oldField, float* newField, Vec3Int res, int zBegin, int zEnd);
+				float* oldField, float* newField, Vec3Int res, int zBegin, int zEnd, const BRICK_GRID* bricks = NULL);
 		static void advectFieldMacCormack1(const float dt, const float* xVelocity, const float* yVelocity, const float* zVelocity, 
-				float* oldField, float* tempResult, Vec3Int res, int zBegin, int zEnd);
+				float* oldField, float* tempResult, Vec3Int res, int zBegin, int zEnd, const BRICK_GRID* bricks = NULL);
 		static void advectFieldMacCormack2(const float dt, const float* xVelocity, const float* yVelocity, const float* zVelocity, 
-				float* oldField, float* newField, float* tempResult, float* temp1,Vec3Int res, const unsigned char* obstacles, int zBegin, int zEnd);
+				float* oldField, float* newField, float* tempResult, float* temp1,Vec3Int res, const unsigned char* obstacles, int zBegin, int zEnd,
+				const BRICK_GRID* bricks = NULL);
 
 
 		// temp ones for testing
@@ -253,9 +260,10 @@ struct FLUID_3D
 
 		// maccormack helper functions
 		static void clampExtrema(const float dt, const float* xVelocity, const float* yVelocity,  const float* zVelocity,
-				float* oldField, float* newField, Vec3Int res, int zBegin, int zEnd);
+				float* oldField, float* newField, Vec3Int res, int zBegin, int zEnd, const BRICK_GRID* bricks = NULL);
 		static void clampOutsideRays(const float dt, const float* xVelocity, const float* yVelocity,  const float* zVelocity,
-				float* oldField, float* newField, Vec3Int res, const unsigned char* obstacles, const float *oldAdvection, int zBegin, int zEnd);
+				float* oldField, float* newField, Vec3Int res, const unsigned char* obstacles, const float *oldAdvection, int zBegin, int zEnd,
+				const BRICK_GRID* bricks = NULL);
 
 
 
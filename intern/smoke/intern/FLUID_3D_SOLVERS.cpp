@@ -28,6 +28,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "FLUID_3D.h"
+#include "MULTIGRID.h"
 #include <cstring>
 #define SOLVER_ACCURACY 1e-06
 
@@ -326,3 +327,17 @@ void FLUID_3D::solvePressurePre(float* field, float* b, unsigned char* skip)
 	if (_direction) delete[] _direction;
 	if (_q)       delete[] _q;
 }
+
+//////////////////////////////////////////////////////////////////////
+// solve the pressure equation with multigrid preconditioned CG
+//
+// Same system and stopping criterion as solvePressurePre(), but the
+// iteration count stays low at high resolutions.
+//////////////////////////////////////////////////////////////////////
+void FLUID_3D::solvePressureMG(float* field, float* b, unsigned char* skip)
+{
+	MULTIGRID multigrid(_xRes, _yRes, _zRes, skip);
+
+	multigrid.solvePCG(field, b, _iterations, 0.001f * SOLVER_ACCURACY);
+	// cout << i << " iterations" << endl;
+}
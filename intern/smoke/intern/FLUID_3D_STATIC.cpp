@@ -33,6 +33,7 @@
 #include "IMAGE.h"
 #include "WTURBULENCE.h"
 #include "INTERPOLATE.h"
+#include "BRICK_GRID.h"
 
 //////////////////////////////////////////////////////////////////////
 // add a test cube of density to the center
@@ -297,7 +298,7 @@ void FLUID_3D::copyBorderZ(float* field, Vec3Int res, int zBegin, int zEnd)
 // advect field with the semi lagrangian method
 //////////////////////////////////////////////////////////////////////
 void FLUID_3D::advectFieldSemiLagrange(const float dt, const float* velx, const float* vely,  const float* velz,
-		float* oldField, float* newField, Vec3Int res, int zBegin, int zEnd)
+		float* oldField, float* newField, Vec3Int res, int zBegin, int zEnd, const BRICK_GRID* bricks)
 {
 	const int xres = res[0];
 	const int yres = res[1];
@@ -310,7 +311,13 @@ void FLUID_3D::advectFieldSemiLagrange(const float dt, const float* velx, const
 			for (int x = 0; x < xres; x++)
 			{
 				const int index = x + y * xres + z * xres*yres;
-				
+
+				// nothing can be advected into inactive bricks
+				if (bricks && !bricks->activeCell(x, y, z)) {
+					newField[index] = 0.0f;
+					continue;
+				}
+
         // backtrace
 				float xTrace = x - dt * velx[index];
 				float yTrace = y - dt * vely[index];
@@ -369,7 +376,7 @@ void FLUID_3D::advectFieldSemiLagrange(const float dt, const float* velx, const
 // comments are the pseudocode from selle's paper
 //////////////////////////////////////////////////////////////////////
 void FLUID_3D::advectFieldMacCormack1(const float dt, const float* xVelocity, const float* yVelocity, const float* zVelocity, 
-				float* oldField, float* tempResult, Vec3Int res, int zBegin, int zEnd)
+				float* oldField, float* tempResult, Vec3Int res, int zBegin, int zEnd, const BRICK_GRID* bricks)
 {
 	/*const int sx= res[0];
 	const int sy= res[1];
@@ -384,13 +391,13 @@ void FLUID_3D::advectFieldMacCormack1(const float dt, const float* xVelocity, co
 
 
 	// phiHatN1 = A(phiN)
-	advectFieldSemiLagrange(  dt, xVelocity, yVelocity, zVelocity, phiN, phiN1, res, zBegin, zEnd);		// uses wide data from old field and velocities (both are whole)
+	advectFieldSemiLagrange(  dt, xVelocity, yVelocity, zVelocity, phiN, phiN1, res, zBegin, zEnd, bricks);		// uses wide data from old field and velocities (both are whole)
 }
 
 
 
 void FLUID_3D::advectFieldMacCormack2(const float dt, const float* xVelocity, const float* yVelocity, const float* zVelocity, 
-				float* oldField, float* newField, float* tempResult, float* temp1, Vec3Int res, const unsigned char* obstacles, int zBegin, int zEnd)
+				float* oldField, float* newField, float* tempResult, float* temp1, Vec3Int res, const unsigned char* obstacles, int zBegin, int zEnd, const BRICK_GRID* bricks)
 {
 	float* phiHatN  = tempResult;
 	float* t1  = temp1;
@@ -403,7 +410,7 @@ void FLUID_3D::advectFieldMacCormack2(const float dt, const float* xVelocity, co
 
 
 	// phiHatN = A^R(phiHatN1)
-	advectFieldSemiLagrange( -1.0f*dt, xVelocity, yVelocity, zVelocity, phiHatN, t1, res, zBegin, zEnd);		// uses wide data from old field and velocities (both are whole)
+	advectFieldSemiLagrange( -1.0f*dt, xVelocity, yVelocity, zVelocity, phiHatN, t1, res, zBegin, zEnd, bricks);		// uses wide data from old field and velocities (both are whole)
 
 	// phiN1 = phiHatN1 + (phiN - phiHatN) / 2
 	const int border = 0; 
@@ -411,6 +418,10 @@ void FLUID_3D::advectFieldMacCormack2(const float dt, const float* xVelocity, co
 		for (int y = border; y < sy-border; y++)
 			for (int x = border; x < sx-border; x++) {
 				int index = x + y * sx + z * sx*sy;
+				if (bricks && !bricks->activeCell(x, y, z)) {
+					phiN1[index] = 0.0f;
+					continue;
+				}
 				phiN1[index] = phiHatN[index] + (phiN[index] - t1[index]) * 0.50f;
 				//phiN1[index] = phiHatN1[index]; // debug, correction off
 			}
@@ -419,10 +430,10 @@ void FLUID_3D::advectFieldMacCormack2(const float dt, const float* xVelocity, co
 	copyBorderZ(phiN1, res, zBegin, zEnd);
 
 	// clamp any newly created extrema
-	clampExtrema(dt, xVelocity, yVelocity, zVelocity, oldField, newField, res, zBegin, zEnd);		// uses wide data from old field and velocities (both are whole)
+	clampExtrema(dt, xVelocity, yVelocity, zVelocity, oldField, newField, res, zBegin, zEnd, bricks);		// uses wide data from old field and velocities (both are whole)
 
 	// if the error estimate was bad, revert to first order
-	clampOutsideRays(dt, xVelocity, yVelocity, zVelocity, oldField, newField, res, obstacles, phiHatN, zBegin, zEnd);	// phiHatN is only used at cells within thread range, so its ok
+	clampOutsideRays(dt, xVelocity, yVelocity, zVelocity, oldField, newField, res, obstacles, phiHatN, zBegin, zEnd, bricks);	// phiHatN is only used at cells within thread range, so its ok
 
 } 
 
@@ -431,7 +442,7 @@ void FLUID_3D::advectFieldMacCormack2(const float dt, const float* xVelocity, co
 // Clamp the extrema generated by the BFECC error correction
 //////////////////////////////////////////////////////////////////////
 void FLUID_3D::clampExtrema(const float dt, const float* velx, const float* vely,  const float* velz,
-		float* oldField, float* newField, Vec3Int res, int zBegin, int zEnd)
+		float* oldField, float* newField, Vec3Int res, int zBegin, int zEnd, const BRICK_GRID* bricks)
 {
 	const int xres= res[0];
 	const int yres= res[1];
@@ -449,6 +460,9 @@ void FLUID_3D::clampExtrema(const float dt, const float* velx, const float* vely
 		for (int y = 1; y < yres-1; y++)
 			for (int x = 1; x < xres-1; x++)
 			{
+				if (bricks && !bricks->activeCell(x, y, z))
+					continue;
+
 				const int index = x + y * xres+ z * xres*yres;
 				// backtrace
 				float xTrace = x - dt * velx[index];
@@ -515,7 +529,7 @@ void FLUID_3D::clampExtrema(const float dt, const float* velx, const float* vely
 // incorrect
 //////////////////////////////////////////////////////////////////////
 void FLUID_3D::clampOutsideRays(const float dt, const float* velx, const float* vely,  const float* velz,
-				float* oldField, float* newField, Vec3Int res, const unsigned char* obstacles, const float *oldAdvection, int zBegin, int zEnd)
+				float* oldField, float* newField, Vec3Int res, const unsigned char* obstacles, const float *oldAdvection, int zBegin, int zEnd, const BRICK_GRID* bricks)
 {
 	const int sx= res[0];
 	const int sy= res[1];
@@ -532,6 +546,9 @@ void FLUID_3D::clampOutsideRays(const float dt, const float* velx, const float*
 		for (int y = 1; y < sy-1; y++)
 			for (int x = 1; x < sx-1; x++)
 			{
+				if (bricks && !bricks->activeCell(x, y, z))
+					continue;
+
 				const int index = x + y * sx+ z * slabSize;
 				// backtrace
 				float xBackward = x + dt * velx[index];
@@ -0,0 +1,671 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): Blender Foundation
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file smoke/intern/MULTIGRID.cpp
+ *  \ingroup smoke
+ */
+
+#include "MULTIGRID.h"
+
+#include <cmath>
+#include <cstring>
+
+#if PARALLEL==1
+#include <omp.h>
+#endif // PARALLEL
+
+// red-black Gauss-Seidel sweeps before and after the coarse correction
+#define MULTIGRID_SMOOTH_STEPS 2
+// symmetric red-black sweeps approximating the solve on the coarsest level
+#define MULTIGRID_COARSE_STEPS 16
+// piecewise constant prolongation underestimates the smooth error, scale up
+// the coarse correction to compensate
+#define MULTIGRID_CORRECTION 1.6f
+// coarsen until every axis has at most this many interior cells
+#define MULTIGRID_MIN_RES 4
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+MULTIGRID::MULTIGRID(int xRes, int yRes, int zRes, const unsigned char* skip)
+{
+	int threadval = 1;
+#if PARALLEL==1
+	threadval = omp_get_max_threads();
+#endif
+
+	// same partitioning as FLUID_3D::step()
+	_stepParts = threadval * 2;
+	_partialSums = new double[_stepParts];
+	_partialMax = new float[_stepParts];
+
+	initLevel(_levels[0], xRes, yRes, zRes, false);
+	_totalLevels = 1;
+	buildFine(skip);
+
+	while (_totalLevels < MULTIGRID_MAX_LEVELS)
+	{
+		const LEVEL& fine = _levels[_totalLevels - 1];
+		const int nx = fine.xRes - 2, ny = fine.yRes - 2, nz = fine.zRes - 2;
+
+		if (nx <= MULTIGRID_MIN_RES && ny <= MULTIGRID_MIN_RES && nz <= MULTIGRID_MIN_RES)
+			break;
+
+		initLevel(_levels[_totalLevels], (nx + 1) / 2 + 2, (ny + 1) / 2 + 2, (nz + 1) / 2 + 2, true);
+		buildCoarse(_totalLevels);
+		_totalLevels++;
+	}
+}
+
+MULTIGRID::~MULTIGRID()
+{
+	for (int l = 0; l < _totalLevels; l++)
+		freeLevel(_levels[l]);
+
+	delete[] _partialSums;
+	delete[] _partialMax;
+}
+
+bool MULTIGRID::supported(int xRes, int yRes, int zRes)
+{
+	return (xRes - 2 > MULTIGRID_MIN_RES || yRes - 2 > MULTIGRID_MIN_RES || zRes - 2 > MULTIGRID_MIN_RES);
+}
+
+void MULTIGRID::initLevel(LEVEL& level, int xRes, int yRes, int zRes, bool coarse)
+{
+	level.xRes = xRes;
+	level.yRes = yRes;
+	level.zRes = zRes;
+	level.slabSize = xRes * yRes;
+	level.totalCells = (size_t)level.slabSize * zRes;
+
+	// the fine level solves for the arrays of the CG iteration
+	float** fields[] = {&level.diag, &level.invDiag, &level.offX, &level.offY, &level.offZ,
+	                    &level.r, &level.b, &level.x};
+	const size_t totalFields = sizeof(fields) / sizeof(*fields) - (coarse ? 0 : 2);
+
+	level.b = level.x = NULL;
+
+	for (size_t i = 0; i < totalFields; i++)
+	{
+		*fields[i] = new float[level.totalCells];
+		memset(*fields[i], 0, sizeof(float) * level.totalCells);
+	}
+}
+
+void MULTIGRID::freeLevel(LEVEL& level)
+{
+	delete[] level.diag;
+	delete[] level.invDiag;
+	delete[] level.offX;
+	delete[] level.offY;
+	delete[] level.offZ;
+	delete[] level.r;
+	if (level.b) delete[] level.b;
+	if (level.x) delete[] level.x;
+}
+
+//////////////////////////////////////////////////////////////////////
+// z-slab partitioning of the interior cells
+//////////////////////////////////////////////////////////////////////
+
+int MULTIGRID::slabParts(const LEVEL& level) const
+{
+	const int nz = level.zRes - 2;
+	return (nz < _stepParts) ? nz : _stepParts;
+}
+
+void MULTIGRID::slabRange(const LEVEL& level, int part, int& zBegin, int& zEnd) const
+{
+	const float partSize = (float)(level.zRes - 2) / slabParts(level);
+
+	zBegin = 1 + (int)((float)part * partSize + 0.5f);
+	zEnd = 1 + (int)((float)(part + 1) * partSize + 0.5f);
+}
+
+//////////////////////////////////////////////////////////////////////
+// build the operators of all levels
+//////////////////////////////////////////////////////////////////////
+
+void MULTIGRID::buildFine(const unsigned char* skip)
+{
+	LEVEL& level = _levels[0];
+	const int xRes = level.xRes, yRes = level.yRes, slabSize = level.slabSize;
+	const int parts = slabParts(level);
+
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static,1)
+#endif
+	for (int part = 0; part < parts; part++)
+	{
+		int zBegin, zEnd;
+		slabRange(level, part, zBegin, zEnd);
+
+		for (int z = zBegin; z < zEnd; z++)
+			for (int y = 1; y < yRes - 1; y++)
+			{
+				size_t index = (size_t)z * slabSize + y * xRes + 1;
+
+				for (int x = 1; x < xRes - 1; x++, index++)
+				{
+					if (skip[index])
+						continue;
+
+					// same stencil as solvePressurePre(), neighbors on
+					// the domain border only add to the diagonal
+					float Acenter = 0.0f;
+					if (!skip[index + 1]) Acenter += 1.0f;
+					if (!skip[index - 1]) Acenter += 1.0f;
+					if (!skip[index + xRes]) Acenter += 1.0f;
+					if (!skip[index - xRes]) Acenter += 1.0f;
+					if (!skip[index + slabSize]) Acenter += 1.0f;
+					if (!skip[index - slabSize]) Acenter += 1.0f;
+
+					// cells enclosed by obstacles are left out
+					if (Acenter < 1.0f)
+						continue;
+
+					level.diag[index] = Acenter;
+					level.invDiag[index] = 1.0f / Acenter;
+
+					if (x < xRes - 2 && !skip[index + 1]) level.offX[index] = -1.0f;
+					if (y < yRes - 2 && !skip[index + xRes]) level.offY[index] = -1.0f;
+					if (z < level.zRes - 2 && !skip[index + slabSize]) level.offZ[index] = -1.0f;
+				}
+			}
+	}
+}
+
+void MULTIGRID::buildCoarse(int l)
+{
+	LEVEL& coarse = _levels[l];
+	const LEVEL& fine = _levels[l - 1];
+	const int parts = slabParts(coarse);
+
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static,1)
+#endif
+	for (int part = 0; part < parts; part++)
+	{
+		int zBegin, zEnd;
+		slabRange(coarse, part, zBegin, zEnd);
+
+		for (int z = zBegin; z < zEnd; z++)
+			for (int y = 1; y < coarse.yRes - 1; y++)
+			{
+				size_t index = (size_t)z * coarse.slabSize + y * coarse.xRes + 1;
+
+				for (int x = 1; x < coarse.xRes - 1; x++, index++)
+				{
+					float diag = 0.0f, offX = 0.0f, offY = 0.0f, offZ = 0.0f;
+
+					// Galerkin operator of the 2x2x2 aggregate: links between
+					// children add to the diagonal, links to the next aggregate
+					// become the coarse coupling
+					for (int dz = 0; dz < 2; dz++)
+					{
+						const int fz = 2 * z - 1 + dz;
+						if (fz > fine.zRes - 2)
+							break;
+
+						for (int dy = 0; dy < 2; dy++)
+						{
+							const int fy = 2 * y - 1 + dy;
+							if (fy > fine.yRes - 2)
+								break;
+
+							for (int dx = 0; dx < 2; dx++)
+							{
+								const int fx = 2 * x - 1 + dx;
+								if (fx > fine.xRes - 2)
+									break;
+
+								const size_t f = (size_t)fz * fine.slabSize + fy * fine.xRes + fx;
+
+								diag += fine.diag[f];
+
+								if (dx == 0) diag += 2.0f * fine.offX[f];
+								else offX += fine.offX[f];
+								if (dy == 0) diag += 2.0f * fine.offY[f];
+								else offY += fine.offY[f];
+								if (dz == 0) diag += 2.0f * fine.offZ[f];
+								else offZ += fine.offZ[f];
+							}
+						}
+					}
+
+					coarse.diag[index] = diag;
+					coarse.invDiag[index] = (diag > 0.0f) ? 1.0f / diag : 0.0f;
+					coarse.offX[index] = offX;
+					coarse.offY[index] = offY;
+					coarse.offZ[index] = offZ;
+				}
+			}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// V-cycle
+//////////////////////////////////////////////////////////////////////
+
+// Symmetric V-cycle, red-black sweeps before the coarse correction are
+// mirrored after it, so it can be used as a CG preconditioner.
+void MULTIGRID::vcycle(int l, const float* b, float* x)
+{
+	const LEVEL& level = _levels[l];
+
+	memset(x, 0, sizeof(float) * level.totalCells);
+
+	if (l == _totalLevels - 1)
+	{
+		smooth(level, b, x, 0);
+		for (int i = 0; i < MULTIGRID_COARSE_STEPS; i++)
+		{
+			smooth(level, b, x, 1);
+			smooth(level, b, x, 0);
+		}
+		return;
+	}
+
+	for (int i = 0; i < MULTIGRID_SMOOTH_STEPS; i++)
+	{
+		smooth(level, b, x, 0);
+		smooth(level, b, x, 1);
+	}
+
+	residual(level, b, x, level.r);
+	restrictResidual(l + 1, level.r);
+
+	vcycle(l + 1, _levels[l + 1].b, _levels[l + 1].x);
+
+	prolongCorrection(l + 1, x);
+
+	for (int i = 0; i < MULTIGRID_SMOOTH_STEPS; i++)
+	{
+		smooth(level, b, x, 1);
+		smooth(level, b, x, 0);
+	}
+}
+
+void MULTIGRID::smooth(const LEVEL& level, const float* b, float* x, int color)
+{
+	const int xRes = level.xRes, slabSize = level.slabSize;
+	const int parts = slabParts(level);
+
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static,1)
+#endif
+	for (int part = 0; part < parts; part++)
+	{
+		int zBegin, zEnd;
+		slabRange(level, part, zBegin, zEnd);
+
+		for (int z = zBegin; z < zEnd; z++)
+			for (int y = 1; y < level.yRes - 1; y++)
+			{
+				// first cell of this color in the row
+				const int xBegin = (((1 + y + z) & 1) == color) ? 1 : 2;
+				size_t index = (size_t)z * slabSize + y * xRes + xBegin;
+
+				for (int i = xBegin; i < xRes - 1; i += 2, index += 2)
+				{
+					if (level.invDiag[index] == 0.0f)
+						continue;
+
+					x[index] = (b[index] -
+					            level.offX[index] * x[index + 1] - level.offX[index - 1] * x[index - 1] -
+					            level.offY[index] * x[index + xRes] - level.offY[index - xRes] * x[index - xRes] -
+					            level.offZ[index] * x[index + slabSize] - level.offZ[index - slabSize] * x[index - slabSize]) *
+					           level.invDiag[index];
+				}
+			}
+	}
+}
+
+void MULTIGRID::residual(const LEVEL& level, const float* b, const float* x, float* r)
+{
+	const int xRes = level.xRes, slabSize = level.slabSize;
+	const int parts = slabParts(level);
+
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static,1)
+#endif
+	for (int part = 0; part < parts; part++)
+	{
+		int zBegin, zEnd;
+		slabRange(level, part, zBegin, zEnd);
+
+		for (int z = zBegin; z < zEnd; z++)
+			for (int y = 1; y < level.yRes - 1; y++)
+			{
+				size_t index = (size_t)z * slabSize + y * xRes + 1;
+
+				for (int i = 1; i < xRes - 1; i++, index++)
+				{
+					if (level.invDiag[index] == 0.0f)
+					{
+						r[index] = 0.0f;
+						continue;
+					}
+
+					r[index] = b[index] - (level.diag[index] * x[index] +
+					           level.offX[index] * x[index + 1] + level.offX[index - 1] * x[index - 1] +
+					           level.offY[index] * x[index + xRes] + level.offY[index - xRes] * x[index - xRes] +
+					           level.offZ[index] * x[index + slabSize] + level.offZ[index - slabSize] * x[index - slabSize]);
+				}
+			}
+	}
+}
+
+// sum the residual of the children into the coarse right hand side
+void MULTIGRID::restrictResidual(int l, const float* r)
+{
+	LEVEL& coarse = _levels[l];
+	const LEVEL& fine = _levels[l - 1];
+	const int parts = slabParts(coarse);
+
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static,1)
+#endif
+	for (int part = 0; part < parts; part++)
+	{
+		int zBegin, zEnd;
+		slabRange(coarse, part, zBegin, zEnd);
+
+		for (int z = zBegin; z < zEnd; z++)
+			for (int y = 1; y < coarse.yRes - 1; y++)
+			{
+				size_t index = (size_t)z * coarse.slabSize + y * coarse.xRes + 1;
+
+				for (int x = 1; x < coarse.xRes - 1; x++, index++)
+				{
+					float sum = 0.0f;
+
+					for (int fz = 2 * z - 1; fz <= 2 * z && fz < fine.zRes - 1; fz++)
+						for (int fy = 2 * y - 1; fy <= 2 * y && fy < fine.yRes - 1; fy++)
+							for (int fx = 2 * x - 1; fx <= 2 * x && fx < fine.xRes - 1; fx++)
+								sum += r[(size_t)fz * fine.slabSize + fy * fine.xRes + fx];
+
+					coarse.b[index] = (coarse.invDiag[index] == 0.0f) ? 0.0f : sum;
+				}
+			}
+	}
+}
+
+// add the coarse correction to all children
+void MULTIGRID::prolongCorrection(int l, float* x)
+{
+	const LEVEL& coarse = _levels[l];
+	const LEVEL& fine = _levels[l - 1];
+	const int parts = slabParts(fine);
+
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static,1)
+#endif
+	for (int part = 0; part < parts; part++)
+	{
+		int zBegin, zEnd;
+		slabRange(fine, part, zBegin, zEnd);
+
+		for (int z = zBegin; z < zEnd; z++)
+			for (int y = 1; y < fine.yRes - 1; y++)
+			{
+				const size_t coarseRow = (size_t)((z + 1) / 2) * coarse.slabSize + ((y + 1) / 2) * coarse.xRes;
+				size_t index = (size_t)z * fine.slabSize + y * fine.xRes + 1;
+
+				for (int i = 1; i < fine.xRes - 1; i++, index++)
+				{
+					if (fine.invDiag[index] != 0.0f)
+						x[index] += MULTIGRID_CORRECTION * coarse.x[coarseRow + (i + 1) / 2];
+				}
+			}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// preconditioned CG on the fine level
+//////////////////////////////////////////////////////////////////////
+
+int MULTIGRID::solvePCG(float* x, const float* b, int maxIterations, float tolerance)
+{
+	const size_t totalCells = _levels[0].totalCells;
+	float *r, *z, *d, *q;
+	int i = 0;
+
+	r = new float[totalCells];
+	z = new float[totalCells];
+	d = new float[totalCells];
+	q = new float[totalCells];
+
+	memset(r, 0, sizeof(float) * totalCells);
+	memset(z, 0, sizeof(float) * totalCells);
+	memset(d, 0, sizeof(float) * totalCells);
+	memset(q, 0, sizeof(float) * totalCells);
+
+	// r = b - Ax
+	float maxR = initResidual(x, b, r);
+
+	if (maxR > tolerance)
+	{
+		// d = M^-1 r
+		vcycle(0, r, z);
+		memcpy(d, z, sizeof(float) * totalCells);
+
+		double deltaNew = dot(r, z);
+
+		while (i < maxIterations)
+		{
+			// q = Ad
+			const double dq = multiply(d, q);
+			const float alpha = (fabs(dq) > 0.0) ? (float)(deltaNew / dq) : 0.0f;
+
+			// x = x + alpha * d, r = r - alpha * q
+			maxR = update(x, r, d, q, alpha);
+			i++;
+
+			if (maxR <= tolerance)
+				break;
+
+			// z = M^-1 r
+			vcycle(0, r, z);
+
+			const double deltaOld = deltaNew;
+			deltaNew = dot(r, z);
+
+			// d = z + beta * d
+			const float beta = (deltaOld != 0.0) ? (float)(deltaNew / deltaOld) : 0.0f;
+			updateDirection(d, z, beta);
+		}
+	}
+
+	delete[] r;
+	delete[] z;
+	delete[] d;
+	delete[] q;
+
+	return i;
+}
+
+float MULTIGRID::initResidual(const float* x, const float* b, float* r)
+{
+	const LEVEL& level = _levels[0];
+	const int parts = slabParts(level);
+
+	residual(level, b, x, r);
+
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static,1)
+#endif
+	for (int part = 0; part < parts; part++)
+	{
+		int zBegin, zEnd;
+		slabRange(level, part, zBegin, zEnd);
+
+		float maxR = 0.0f;
+
+		for (size_t index = (size_t)zBegin * level.slabSize; index < (size_t)zEnd * level.slabSize; index++)
+		{
+			const float tmp = r[index] * r[index] * level.invDiag[index];
+			maxR = (tmp > maxR) ? tmp : maxR;
+		}
+
+		_partialMax[part] = maxR;
+	}
+
+	float maxR = 0.0f;
+	for (int part = 0; part < parts; part++)
+		maxR = (_partialMax[part] > maxR) ? _partialMax[part] : maxR;
+
+	return maxR;
+}
+
+// result = Ax, returns x . Ax
+double MULTIGRID::multiply(const float* x, float* result)
+{
+	const LEVEL& level = _levels[0];
+	const int xRes = level.xRes, slabSize = level.slabSize;
+	const int parts = slabParts(level);
+
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static,1)
+#endif
+	for (int part = 0; part < parts; part++)
+	{
+		int zBegin, zEnd;
+		slabRange(level, part, zBegin, zEnd);
+
+		double sum = 0.0;
+
+		for (int z = zBegin; z < zEnd; z++)
+			for (int y = 1; y < level.yRes - 1; y++)
+			{
+				size_t index = (size_t)z * slabSize + y * xRes + 1;
+
+				for (int i = 1; i < xRes - 1; i++, index++)
+				{
+					if (level.invDiag[index] == 0.0f)
+					{
+						result[index] = 0.0f;
+						continue;
+					}
+
+					result[index] = level.diag[index] * x[index] +
+					                level.offX[index] * x[index + 1] + level.offX[index - 1] * x[index - 1] +
+					                level.offY[index] * x[index + xRes] + level.offY[index - xRes] * x[index - xRes] +
+					                level.offZ[index] * x[index + slabSize] + level.offZ[index - slabSize] * x[index - slabSize];
+
+					sum += (double)x[index] * result[index];
+				}
+			}
+
+		_partialSums[part] = sum;
+	}
+
+	double sum = 0.0;
+	for (int part = 0; part < parts; part++)
+		sum += _partialSums[part];
+
+	return sum;
+}
+
+float MULTIGRID::update(float* x, float* r, const float* d, const float* q, float alpha)
+{
+	const LEVEL& level = _levels[0];
+	const int parts = slabParts(level);
+
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static,1)
+#endif
+	for (int part = 0; part < parts; part++)
+	{
+		int zBegin, zEnd;
+		slabRange(level, part, zBegin, zEnd);
+
+		float maxR = 0.0f;
+
+		for (size_t index = (size_t)zBegin * level.slabSize; index < (size_t)zEnd * level.slabSize; index++)
+		{
+			x[index] += alpha * d[index];
+			r[index] -= alpha * q[index];
+
+			const float tmp = r[index] * r[index] * level.invDiag[index];
+			maxR = (tmp > maxR) ? tmp : maxR;
+		}
+
+		_partialMax[part] = maxR;
+	}
+
+	float maxR = 0.0f;
+	for (int part = 0; part < parts; part++)
+		maxR = (_partialMax[part] > maxR) ? _partialMax[part] : maxR;
+
+	return maxR;
+}
+
+void MULTIGRID::updateDirection(float* d, const float* z, float beta)
+{
+	const LEVEL& level = _levels[0];
+	const int parts = slabParts(level);
+
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static,1)
+#endif
+	for (int part = 0; part < parts; part++)
+	{
+		int zBegin, zEnd;
+		slabRange(level, part, zBegin, zEnd);
+
+		for (size_t index = (size_t)zBegin * level.slabSize; index < (size_t)zEnd * level.slabSize; index++)
+			d[index] = z[index] + beta * d[index];
+	}
+}
+
+// per slab partial sums, added up in order so the result does not depend
+// on the thread scheduling
+double MULTIGRID::dot(const float* a, const float* b)
+{
+	const LEVEL& level = _levels[0];
+	const int parts = slabParts(level);
+
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static,1)
+#endif
+	for (int part = 0; part < parts; part++)
+	{
+		int zBegin, zEnd;
+		slabRange(level, part, zBegin, zEnd);
+
+		double sum = 0.0;
+
+		for (size_t index = (size_t)zBegin * level.slabSize; index < (size_t)zEnd * level.slabSize; index++)
+			sum += (double)a[index] * b[index];
+
+		_partialSums[part] = sum;
+	}
+
+	double sum = 0.0;
+	for (int part = 0; part < parts; part++)
+		sum += _partialSums[part];
+
+	return sum;
+}
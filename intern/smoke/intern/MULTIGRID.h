@@ -0,0 +1,111 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): Blender Foundation
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file smoke/intern/MULTIGRID.h
+ *  \ingroup smoke
+ */
+//////////////////////////////////////////////////////////////////////
+// MULTIGRID.h: multigrid preconditioned CG for the pressure Poisson
+// equation of FLUID_3D.
+//
+// The fine level is the 7 point Poisson stencil used by
+// FLUID_3D::solvePressurePre(): obstacle cells (skip) are not part of
+// the system, non obstacle cells on the domain border are zero
+// pressure. Coarse levels merge 2x2x2 cells and use the Galerkin
+// operator of that aggregation, so obstacles of any size are
+// represented exactly on every level.
+//
+// All loops run over z-slabs, in parallel when built with OpenMP.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef MULTIGRID_H
+#define MULTIGRID_H
+
+#include <cstddef>
+
+#define MULTIGRID_MAX_LEVELS 10
+
+struct MULTIGRID
+{
+	public:
+		MULTIGRID(int xRes, int yRes, int zRes, const unsigned char* skip);
+		virtual ~MULTIGRID();
+
+		// resolution too small to benefit from coarse levels
+		static bool supported(int xRes, int yRes, int zRes);
+
+		// solve A x = b for the interior cells, x is used as initial guess;
+		// stops when the maximum preconditioned residual r * r / diag
+		// drops below tolerance. Returns the number of iterations.
+		int solvePCG(float* x, const float* b, int maxIterations, float tolerance);
+
+	private:
+		struct LEVEL {
+			int xRes, yRes, zRes;
+			int slabSize;
+			size_t totalCells;
+
+			// symmetric 7 point stencil, off* couples a cell to its +1 neighbor
+			float* diag;
+			float* invDiag;
+			float* offX;
+			float* offY;
+			float* offZ;
+
+			// coarse level right hand side and solution, fine level residual
+			float* b;
+			float* x;
+			float* r;
+		};
+
+		LEVEL _levels[MULTIGRID_MAX_LEVELS];
+		int _totalLevels;
+
+		// z-slab partitioning
+		int _stepParts;
+		double* _partialSums;
+		float* _partialMax;
+
+		void slabRange(const LEVEL& level, int part, int& zBegin, int& zEnd) const;
+		int slabParts(const LEVEL& level) const;
+
+		void initLevel(LEVEL& level, int xRes, int yRes, int zRes, bool coarse);
+		void freeLevel(LEVEL& level);
+		void buildFine(const unsigned char* skip);
+		void buildCoarse(int l);
+
+		// V-cycle preconditioner, z ~= A^-1 r
+		void vcycle(int l, const float* b, float* x);
+		void smooth(const LEVEL& level, const float* b, float* x, int color);
+		void residual(const LEVEL& level, const float* b, const float* x, float* r);
+		void restrictResidual(int l, const float* r);
+		void prolongCorrection(int l, float* x);
+
+		// fine level PCG kernels
+		float initResidual(const float* x, const float* b, float* r);
+		double multiply(const float* x, float* result);
+		float update(float* x, float* r, const float* d, const float* q, float alpha);
+		void updateDirection(float* d, const float* z, float beta);
+		double dot(const float* a, const float* b);
+};
+
+#endif
@@ -35,6 +35,7 @@
 #include "EIGENVALUE_HELPER.h"
 #include "LU_HELPER.h"
 #include "SPHERE.h"
+#include "BRICK_GRID.h"
 #include <zlib.h>
 #include <math.h>
 
@@ -814,7 +815,8 @@ Vec3 WTURBULENCE::WVelocityWithJacobian(const Vec3& orgPos, float* xUnwarped, fl
 // perform the full turbulence algorithm, including OpenMP 
 // if available
 //////////////////////////////////////////////////////////////////////
-void WTURBULENCE::stepTurbulenceFull(float dtOrg, float* xvel, float* yvel, float* zvel, unsigned char *obstacles)
+void WTURBULENCE::stepTurbulenceFull(float dtOrg, float* xvel, float* yvel, float* zvel, unsigned char *obstacles,
+                                     const BRICK_GRID *bricks)
 {
 	// enlarge timestep to match grid
 	const float dt = dtOrg * _amplify;
@@ -897,6 +899,9 @@ void WTURBULENCE::stepTurbulenceFull(float dtOrg, float* xvel, float* yvel, floa
   {
     const int indexSmall = xSmall + ySmall * _xResSm + zSmall * _slabSizeSm;
 
+    // no smoke can reach this cell during the step, skip the noise
+    const bool activeSmall = !bricks || bricks->activeCell(xSmall, ySmall, zSmall);
+
     // compute jacobian
     float jacobian[3][3] = {
       { minDx(xSmall, ySmall, zSmall, _tcU, _resSm), minDx(xSmall, ySmall, zSmall, _tcV, _resSm), minDx(xSmall, ySmall, zSmall, _tcW, _resSm) } ,
@@ -964,29 +969,36 @@ void WTURBULENCE::stepTurbulenceFull(float dtOrg, float* xvel, float* yvel, floa
       // from the coarse grid
       Vec3 vel = INTERPOLATE::lerp3dVec( xvel,yvel,zvel, 
           posSm[0], posSm[1], posSm[2], _xResSm,_yResSm,_zResSm);
-      Vec3 uvw = INTERPOLATE::lerp3dVec( _tcU,_tcV,_tcW, 
-          posSm[0], posSm[1], posSm[2], _xResSm,_yResSm,_zResSm);
-
-      // multiply the texture coordinate by _resSm so that turbulence
-      // synthesis begins at the first octave that the coarse grid 
-      // cannot capture
-      Vec3 texCoord = Vec3(uvw[0] * _resSm[0], 
-                           uvw[1] * _resSm[1],
-                           uvw[2] * _resSm[2]); 
-
-      // retrieve wavelet energy at highest frequency
-      float energy = INTERPOLATE::lerp3d(
-          highFreqEnergy, posSm[0],posSm[1],posSm[2], _xResSm, _yResSm, _zResSm);
-
-      // base amplitude for octave 0
-      float coefficient = sqrtf(2.0f * fabs(energy));
-      const float amplitude = *_strength * fabs(0.5f * coefficient) * persistence;
 
       // add noise to velocity, but only if the turbulence is
       // sufficiently undeformed, and the energy is large enough
       // to make a difference
-      const bool addNoise = eigMax[indexSmall] < 2.0f &&
+      const bool addNoise = activeSmall &&
+                            eigMax[indexSmall] < 2.0f &&
                             eigMin[indexSmall] > 0.5f;
+      Vec3 uvw, texCoord;
+      float amplitude = 0.0f;
+
+      if (addNoise) {
+        uvw = INTERPOLATE::lerp3dVec( _tcU,_tcV,_tcW, 
+            posSm[0], posSm[1], posSm[2], _xResSm,_yResSm,_zResSm);
+
+        // multiply the texture coordinate by _resSm so that turbulence
+        // synthesis begins at the first octave that the coarse grid 
+        // cannot capture
+        texCoord = Vec3(uvw[0] * _resSm[0], 
+                        uvw[1] * _resSm[1],
+                        uvw[2] * _resSm[2]); 
+
+        // retrieve wavelet energy at highest frequency
+        float energy = INTERPOLATE::lerp3d(
+            highFreqEnergy, posSm[0],posSm[1],posSm[2], _xResSm, _yResSm, _zResSm);
+
+        // base amplitude for octave 0
+        float coefficient = sqrtf(2.0f * fabs(energy));
+        amplitude = *_strength * fabs(0.5f * coefficient) * persistence;
+      }
+
       if (addNoise && amplitude > _cullingThreshold) {
         // base amplitude for octave 0
         float amplitudeScaled = amplitude;
@@ -1068,6 +1080,22 @@ void WTURBULENCE::stepTurbulenceFull(float dtOrg, float* xvel, float* yvel, floa
   FLUID_3D::setZeroY(bigUy, _resBig, 0 , _resBig[2]); 
   FLUID_3D::setZeroZ(bigUz, _resBig, 0 , _resBig[2]);
 
+  // bricks the big fields can reach in all substeps
+  BRICK_GRID bricksBig(_xResBig, _yResBig, _zResBig);
+
+  bricksBig.setAll(false);
+  bricksBig.markField(_densityBigOld, BRICK_EMPTY_THRESHOLD);
+  if (_fuelBig) {
+    bricksBig.markField(_fuelBigOld, BRICK_EMPTY_THRESHOLD);
+    bricksBig.markField(_reactBigOld, BRICK_EMPTY_THRESHOLD);
+  }
+  if (_color_rBig) {
+    bricksBig.markField(_color_rBigOld, BRICK_EMPTY_THRESHOLD);
+    bricksBig.markField(_color_gBigOld, BRICK_EMPTY_THRESHOLD);
+    bricksBig.markField(_color_bBigOld, BRICK_EMPTY_THRESHOLD);
+  }
+  bricksBig.dilateAdvection(bigUx, bigUy, bigUz, dtSubdiv, totalSubsteps);
+
 #if PARALLEL==1
   int stepParts = threadval*2;	// Dividing parallelized sections into numOfThreads * 2 sections
   float partSize = (float)_zResBig/stepParts;	// Size of one part;
@@ -1096,20 +1124,20 @@ void WTURBULENCE::stepTurbulenceFull(float dtOrg, float* xvel, float* yvel, floa
 		int zEnd = (int)((float)(i+1)*partSize + 0.5f);
 #endif
 		FLUID_3D::advectFieldMacCormack1(dtSubdiv, bigUx, bigUy, bigUz, 
-		    _densityBigOld, tempDensityBig, _resBig, zBegin, zEnd);
+		    _densityBigOld, tempDensityBig, _resBig, zBegin, zEnd, &bricksBig);
 		if (_fuelBig) {
 			FLUID_3D::advectFieldMacCormack1(dtSubdiv, bigUx, bigUy, bigUz, 
-				_fuelBigOld, tempFuelBig, _resBig, zBegin, zEnd);
+				_fuelBigOld, tempFuelBig, _resBig, zBegin, zEnd, &bricksBig);
 			FLUID_3D::advectFieldMacCormack1(dtSubdiv, bigUx, bigUy, bigUz, 
-				_reactBigOld, tempReactBig, _resBig, zBegin, zEnd);
+				_reactBigOld, tempReactBig, _resBig, zBegin, zEnd, &bricksBig);
 		}
 		if (_color_rBig) {
 			FLUID_3D::advectFieldMacCormack1(dtSubdiv, bigUx, bigUy, bigUz, 
-				_color_rBigOld, tempColor_rBig, _resBig, zBegin, zEnd);
+				_color_rBigOld, tempColor_rBig, _resBig, zBegin, zEnd, &bricksBig);
 			FLUID_3D::advectFieldMacCormack1(dtSubdiv, bigUx, bigUy, bigUz, 
-				_color_gBigOld, tempColor_gBig, _resBig, zBegin, zEnd);
+				_color_gBigOld, tempColor_gBig, _resBig, zBegin, zEnd, &bricksBig);
 			FLUID_3D::advectFieldMacCormack1(dtSubdiv, bigUx, bigUy, bigUz, 
-				_color_bBigOld, tempColor_bBig, _resBig, zBegin, zEnd);
+				_color_bBigOld, tempColor_bBig, _resBig, zBegin, zEnd, &bricksBig);
 		}
 #if PARALLEL==1
 	}
@@ -1123,20 +1151,20 @@ void WTURBULENCE::stepTurbulenceFull(float dtOrg, float* xvel, float* yvel, floa
 		int zEnd = (int)((float)(i+1)*partSize + 0.5f);
 #endif
 		FLUID_3D::advectFieldMacCormack2(dtSubdiv, bigUx, bigUy, bigUz, 
-		    _densityBigOld, _densityBig, tempDensityBig, tempBig, _resBig, NULL, zBegin, zEnd);
+		    _densityBigOld, _densityBig, tempDensityBig, tempBig, _resBig, NULL, zBegin, zEnd, &bricksBig);
 		if (_fuelBig) {
 			FLUID_3D::advectFieldMacCormack2(dtSubdiv, bigUx, bigUy, bigUz, 
-				_fuelBigOld, _fuelBig, tempFuelBig, tempBig, _resBig, NULL, zBegin, zEnd);
+				_fuelBigOld, _fuelBig, tempFuelBig, tempBig, _resBig, NULL, zBegin, zEnd, &bricksBig);
 			FLUID_3D::advectFieldMacCormack2(dtSubdiv, bigUx, bigUy, bigUz, 
-				_reactBigOld, _reactBig, tempReactBig, tempBig, _resBig, NULL, zBegin, zEnd);
+				_reactBigOld, _reactBig, tempReactBig, tempBig, _resBig, NULL, zBegin, zEnd, &bricksBig);
 		}
 		if (_color_rBig) {
 			FLUID_3D::advectFieldMacCormack2(dtSubdiv, bigUx, bigUy, bigUz, 
-				_color_rBigOld, _color_rBig, tempColor_rBig, tempBig, _resBig, NULL, zBegin, zEnd);
+				_color_rBigOld, _color_rBig, tempColor_rBig, tempBig, _resBig, NULL, zBegin, zEnd, &bricksBig);
 			FLUID_3D::advectFieldMacCormack2(dtSubdiv, bigUx, bigUy, bigUz, 
-				_color_gBigOld, _color_gBig, tempColor_gBig, tempBig, _resBig, NULL, zBegin, zEnd);
+				_color_gBigOld, _color_gBig, tempColor_gBig, tempBig, _resBig, NULL, zBegin, zEnd, &bricksBig);
 			FLUID_3D::advectFieldMacCormack2(dtSubdiv, bigUx, bigUy, bigUz, 
-				_color_bBigOld, _color_bBig, tempColor_bBig, tempBig, _resBig, NULL, zBegin, zEnd);
+				_color_bBigOld, _color_bBig, tempColor_bBig, tempBig, _resBig, NULL, zBegin, zEnd, &bricksBig);
 		}
 #if PARALLEL==1
 	}
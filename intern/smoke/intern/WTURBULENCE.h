@@ -28,6 +28,7 @@
 #include "VEC3.h"
 using namespace BasicVector;
 class SIMPLE_PARSER;
+struct BRICK_GRID;
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Main WTURBULENCE class, stores large density array etc.
@@ -51,8 +52,10 @@ struct WTURBULENCE
 		void stepTurbulenceReadable(float dt, float* xvel, float* yvel, float* zvel, unsigned char *obstacles);
 
 		// step more complete version -- include rotation correction
-		// and use OpenMP if available
-		void stepTurbulenceFull(float dt, float* xvel, float* yvel, float* zvel, unsigned char *obstacles);
+		// and use OpenMP if available. Noise is only synthesized in the
+		// active bricks of the coarse grid, when given
+		void stepTurbulenceFull(float dt, float* xvel, float* yvel, float* zvel, unsigned char *obstacles,
+		                        const BRICK_GRID *bricks = NULL);
 	
 		// texcoord functions
 		void advectTextureCoordinates(float dtOrg, float* xvel, float* yvel, float* zvel, float *tempBig1, float *tempBig2);
@@ -92,7 +92,8 @@ extern "C" void smoke_turbulence_step(WTURBULENCE *wt, FLUID_3D *fluid)
 		fluid->processBurn(wt->_fuelBig, wt->_densityBig, wt->_reactBig, 0,
 						   wt->_color_rBig, wt->_color_gBig, wt->_color_bBig, wt->_totalCellsBig, fluid->_dt);
 	}
-	wt->stepTurbulenceFull(fluid->_dt/fluid->_dx, fluid->_xVelocity, fluid->_yVelocity, fluid->_zVelocity, fluid->_obstacles);
+	wt->stepTurbulenceFull(fluid->_dt/fluid->_dx, fluid->_xVelocity, fluid->_yVelocity, fluid->_zVelocity, fluid->_obstacles,
+	                       fluid->_bricks);
 
 	if (wt->_fuelBig) {
 		fluid->updateFlame(wt->_reactBig, wt->_flameBig, wt->_totalCellsBig);
@@ -182,6 +182,7 @@ class DATA_PT_modifiers(ModifierButtonsPanel, Panel):
         col.label(text="Object:")
         col.prop(md, "object", text="")
 
+        layout.prop(md, "solver")
         layout.prop(md, "double_threshold")
 
         if bpy.app.debug:
@@ -74,6 +74,8 @@ class PHYSICS_PT_cloth(PhysicButtonsPanel, Panel):
         col.prop(cloth, "quality", text="Quality Steps")
         col = flow.column()
         col.prop(cloth, "time_scale", text="Speed Multiplier")
+        col = flow.column()
+        col.prop(cloth, "use_solver_preconditioner")
 
 
 class PHYSICS_PT_cloth_physical_properties(PhysicButtonsPanel, Panel):
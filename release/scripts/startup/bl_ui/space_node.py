@@ -519,6 +519,7 @@ class NODE_PT_quality(bpy.types.Panel):
         col.prop(tree, "use_groupnode_buffer")
         col.prop(tree, "use_two_pass")
         col.prop(tree, "use_viewer_border")
+        col.prop(tree, "use_full_frame")
 
 
 class NODE_UL_interface_sockets(bpy.types.UIList):
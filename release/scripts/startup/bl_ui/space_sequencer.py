@@ -1210,6 +1210,33 @@ class SEQUENCER_PT_proxy(SequencerButtonsPanel, Panel):
         col.operator("sequencer.rebuild_proxy")
 
 
+class SEQUENCER_PT_cache_settings(SequencerButtonsPanel, Panel):
+    bl_label = "Cache Settings"
+    bl_category = "Strip"
+    bl_options = {'DEFAULT_CLOSED'}
+
+    @classmethod
+    def poll(cls, context):
+        return cls.has_sequencer(context) and context.scene.sequence_editor
+
+    def draw(self, context):
+        layout = self.layout
+
+        ed = context.scene.sequence_editor
+        paths = context.preferences.filepaths
+
+        col = layout.column()
+        col.active = bool(paths.sequencer_disk_cache_directory)
+        col.label(text="Store on Disk:")
+        col.prop(ed, "use_cache_disk_raw")
+        col.prop(ed, "use_cache_disk_preprocessed")
+        col.prop(ed, "use_cache_disk_composite")
+        col.prop(ed, "use_cache_disk_final")
+
+        if not paths.sequencer_disk_cache_directory:
+            layout.label(text="Set the disk cache path in the preferences", icon='INFO')
+
+
 class SEQUENCER_PT_preview(SequencerButtonsPanel_Output, Panel):
     bl_label = "Scene Preview/Render"
     bl_space_type = 'SEQUENCE_EDITOR'
@@ -1416,6 +1443,7 @@ classes = (
     SEQUENCER_PT_mask,
     SEQUENCER_PT_filter,
     SEQUENCER_PT_proxy,
+    SEQUENCER_PT_cache_settings,
     SEQUENCER_PT_preview,
     SEQUENCER_PT_view,
     SEQUENCER_PT_view_safe_areas,
@@ -675,12 +675,25 @@ class USERPREF_PT_system_memory(PreferencePanel):
         flow = layout.grid_flow(row_major=False, columns=0, even_columns=True, even_rows=False, align=False)
 
         flow.prop(system, "memory_cache_limit", text="Sequencer Cache Limit")
+        flow.prop(system, "prefetch_frames", text="Sequencer Prefetch Frames")
+        flow.prop(system, "compositor_cache_limit", text="Compositor Cache Limit")
+        flow.prop(system, "modifier_cache_limit", text="Modifier Cache Limit")
         flow.prop(system, "scrollback", text="Console Scrollback Lines")
 
         layout.separator()
 
         flow = layout.grid_flow(row_major=False, columns=0, even_columns=True, even_rows=False, align=False)
 
+        flow.prop(system, "sequencer_cache_budget_raw", text="Sequencer Cache Raw")
+        flow.prop(system, "sequencer_cache_budget_preprocessed", text="Preprocessed")
+        flow.prop(system, "sequencer_cache_budget_composite", text="Composite")
+        flow.prop(system, "sequencer_cache_budget_final", text="Final")
+        flow.prop(system, "sequencer_disk_cache_size_limit", text="Sequencer Disk Cache Limit")
+
+        layout.separator()
+
+        flow = layout.grid_flow(row_major=False, columns=0, even_columns=True, even_rows=False, align=False)
+
         flow.prop(system, "texture_time_out", text="Texture Time Out")
         flow.prop(system, "texture_collection_rate", text="Garbage Collection Rate")
 
@@ -1183,6 +1196,7 @@ class USERPREF_PT_file_paths_render(FilePathsPanel):
         col = self.layout.column()
         col.prop(paths, "render_output_directory", text="Render Output")
         col.prop(paths, "render_cache_directory", text="Render Cache")
+        col.prop(paths, "sequencer_disk_cache_directory", text="Sequencer Disk Cache")
 
 
 class USERPREF_PT_file_paths_applications(FilePathsPanel):
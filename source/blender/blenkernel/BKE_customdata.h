@@ -204,6 +204,7 @@ int CustomData_number_of_layers_typemask(const struct CustomData *data, CustomDa
 /* duplicate data of a layer with flag NOFREE, and remove that flag.
  * returns the layer data */
 void *CustomData_duplicate_referenced_layer(struct CustomData *data, const int type, const int totelem);
+void CustomData_duplicate_referenced_layers(struct CustomData *data, const int totelem);
 void *CustomData_duplicate_referenced_layer_n(struct CustomData *data, const int type, const int n, const int totelem);
 void *CustomData_duplicate_referenced_layer_named(struct CustomData *data,
                                                   const int type, const char *name, const int totelem);
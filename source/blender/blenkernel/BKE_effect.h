@@ -140,6 +140,14 @@ void BKE_effectors_apply(
         struct EffectedPoint *point,
         float *force,
         float *impulse);
+void BKE_effectors_apply_array(
+        struct ListBase *effectors,
+        struct ListBase *colliders,
+        struct EffectorWeights *weights,
+        struct EffectedPoint *points,
+        int totpoint,
+        float (*forces)[3],
+        float (*impulses)[3]);
 void BKE_effectors_free(struct ListBase *lb);
 
 void pd_point_from_particle(struct ParticleSimulationData *sim, struct ParticleData *pa, struct ParticleKey *state, struct EffectedPoint *point);
@@ -219,6 +219,8 @@ void BKE_image_update_frame(const struct Main *bmain, int cfra);
 
 /* sets index offset for multilayer files */
 struct RenderPass *BKE_image_multilayer_index(struct RenderResult *rr, struct ImageUser *iuser);
+/* reads the pixels of all passes, which are otherwise only read when used */
+bool BKE_image_multilayer_load_all_passes(struct Image *ima);
 
 /* sets index offset for multiview files */
 void BKE_image_multiview_index(struct Image *ima, struct ImageUser *iuser);
@@ -430,6 +430,9 @@ struct Mesh *BKE_mesh_merge_verts(
         struct Mesh *mesh,
         const int *vtargetmap, const int tot_vtargetmap,
         const int merge_mode);
+struct Mesh *BKE_mesh_merge_verts_by_distance(
+        struct Mesh *mesh, const float dist,
+        const int merge_mode);
 
 
 /* flush flags */
@@ -434,6 +434,38 @@ struct DerivedMesh *modifier_applyModifier_DM_deprecated(
         struct ModifierData *md, const struct ModifierEvalContext *ctx,
         struct DerivedMesh *dm);
 
+/* Modifier stack result cache, see modifier_cache.c */
+struct ModifierResultCacheKey;
+
+typedef struct ModifierResultCacheStats {
+	/* results reused from the cache */
+	unsigned int hits;
+	/* results which had to be calculated */
+	unsigned int misses;
+	/* memory used by cached results (in bytes) */
+	size_t mem_in_use;
+} ModifierResultCacheStats;
+
+unsigned int modifier_resultCache_input_base(struct Object *ob, const float (*vert_cos)[3], const int vert_cos_len);
+struct ModifierResultCacheKey *modifier_resultCache_key_create(
+        struct Object *ob, struct ModifierData *md, const struct Mesh *me_input, const unsigned int input_id,
+        CustomDataMask mask, int app_flags);
+void modifier_resultCache_key_free(struct ModifierResultCacheKey *key);
+struct ModifierResultCacheKey *modifier_resultCache_key_create_ex(struct Object *ob, struct ModifierData *md);
+void modifier_resultCache_key_add(struct ModifierResultCacheKey *key, const void *data, const size_t data_len);
+bool modifier_resultCache_key_add_mesh(struct ModifierResultCacheKey *key, const struct Mesh *me);
+struct Mesh *modifier_resultCache_lookup(
+        struct Object *ob, struct ModifierData *md, const struct ModifierResultCacheKey *key,
+        unsigned int *r_id);
+struct Mesh *modifier_resultCache_store(
+        struct Object *ob, struct ModifierData *md, const struct ModifierResultCacheKey *key,
+        struct Mesh *mesh, unsigned int *r_id);
+void modifier_resultCache_release(struct Object *ob, const struct Mesh *me_eval);
+void modifier_resultCache_free(struct Object *ob);
+void modifier_resultCache_limit_update(void);
+void modifier_resultCache_stats_get(ModifierResultCacheStats *r_stats);
+void modifier_resultCache_stats_reset(void);
+
 struct Mesh *BKE_modifier_get_evaluated_mesh_from_evaluated_object(
         struct Object *ob_eval, bool *r_free_mesh);
 
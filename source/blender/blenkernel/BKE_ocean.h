@@ -86,6 +86,7 @@ void BKE_ocean_simulate(struct Ocean *o, float t, float scale, float chop_amount
 float BKE_ocean_jminus_to_foam(float jminus, float coverage);
 void  BKE_ocean_eval_uv(struct Ocean *oc, struct OceanResult *ocr, float u, float v);
 void  BKE_ocean_eval_uv_catrom(struct Ocean *oc, struct OceanResult *ocr, float u, float v);
+void  BKE_ocean_eval_uv_array(struct Ocean *oc, struct OceanResult *r_ocr, const float (*uv)[2], int totpoint);
 void  BKE_ocean_eval_xz(struct Ocean *oc, struct OceanResult *ocr, float x, float z);
 void  BKE_ocean_eval_xz_catrom(struct Ocean *oc, struct OceanResult *ocr, float x, float z);
 void  BKE_ocean_eval_ij(struct Ocean *oc, struct OceanResult *ocr, int i, int j);
@@ -170,11 +170,14 @@ typedef struct ParticleThreadContext {
 	struct CurveMapping *clumpcurve;
 	struct CurveMapping *roughcurve;
 	struct CurveMapping *twistcurve;
+
+	/* curve values at the path key times (segments + 1), shared by all children */
+	float *clumpcurve_keys, *roughcurve_keys, *twistcurve_keys;
 } ParticleThreadContext;
 
 typedef struct ParticleTask {
 	ParticleThreadContext *ctx;
-	struct RNG *rng, *rng_path;
+	struct RNG *rng;
 	int begin, end;
 } ParticleTask;
 
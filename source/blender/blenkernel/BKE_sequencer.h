@@ -112,6 +112,9 @@ typedef struct SeqRenderData {
 	struct GPUFX *gpu_fx;
 	int gpu_samples;
 	bool gpu_full_samples;
+
+	/* set when rendering frames ahead of the playhead, see seqprefetch.c */
+	struct SeqPrefetchJob *prefetch_job;
 } SeqRenderData;
 
 void BKE_sequencer_new_render_data(
@@ -194,7 +197,6 @@ struct ImBuf *BKE_sequencer_give_ibuf(const SeqRenderData *context, float cfra,
 struct ImBuf *BKE_sequencer_give_ibuf_threaded(const SeqRenderData *context, float cfra, int chanshown);
 struct ImBuf *BKE_sequencer_give_ibuf_direct(const SeqRenderData *context, float cfra, struct Sequence *seq);
 struct ImBuf *BKE_sequencer_give_ibuf_seqbase(const SeqRenderData *context, float cfra, int chan_shown, struct ListBase *seqbasep);
-void BKE_sequencer_give_ibuf_prefetch_request(const SeqRenderData *context, float cfra, int chan_shown);
 
 /* **********************************************************************
  * sequencer.c
@@ -257,14 +259,18 @@ void BKE_sequencer_proxy_set(struct Sequence *seq, bool value);
 /* **********************************************************************
  * seqcache.c
  *
- * Sequencer memory cache management functions
+ * Sequencer memory and disk cache management functions
  * ********************************************************************** */
 
 typedef enum {
 	SEQ_STRIPELEM_IBUF,
 	SEQ_STRIPELEM_IBUF_COMP,
 	SEQ_STRIPELEM_IBUF_STARTSTILL,
-	SEQ_STRIPELEM_IBUF_ENDSTILL
+	SEQ_STRIPELEM_IBUF_ENDSTILL,
+	/* image of the strip before preprocessing */
+	SEQ_STRIPELEM_IBUF_RAW,
+	/* output of the whole strip stack, stored for its top-most strip */
+	SEQ_STRIPELEM_IBUF_FINAL
 } eSeqStripElemIBuf;
 
 void BKE_sequencer_cache_destruct(void);
@@ -282,11 +288,37 @@ void BKE_sequencer_cache_put(const SeqRenderData *context, struct Sequence *seq,
 
 void BKE_sequencer_cache_cleanup_sequence(struct Sequence *seq);
 
-struct ImBuf *BKE_sequencer_preprocessed_cache_get(const SeqRenderData *context, struct Sequence *seq, float cfra, eSeqStripElemIBuf type);
-void BKE_sequencer_preprocessed_cache_put(const SeqRenderData *context, struct Sequence *seq, float cfra, eSeqStripElemIBuf type, struct ImBuf *ibuf);
+/* images of strips before preprocessing, see SEQ_STRIPELEM_IBUF_RAW */
 void BKE_sequencer_preprocessed_cache_cleanup(void);
 void BKE_sequencer_preprocessed_cache_cleanup_sequence(struct Sequence *seq);
 
+void BKE_sequencer_cache_disk_cleanup_sequence(struct Scene *scene, struct Sequence *seq);
+void BKE_sequencer_cache_disk_cleanup(struct Scene *scene);
+void BKE_sequencer_cache_disk_cleanup_all(struct Main *bmain);
+
+/* **********************************************************************
+ * seqprefetch.c
+ *
+ * Rendering of frames ahead of the playhead on a background thread
+ * ********************************************************************** */
+
+typedef struct SeqPrefetchStats {
+	/* frames requested by playback which were rendered ahead */
+	int hits;
+	/* frames requested by playback which had to be rendered on demand */
+	int misses;
+	/* frames rendered ahead of the last requested frame */
+	int lookahead;
+} SeqPrefetchStats;
+
+void BKE_sequencer_prefetch_start(const SeqRenderData *context, float cfra, int chanshown);
+void BKE_sequencer_prefetch_frame_request(const SeqRenderData *context, float cfra);
+void BKE_sequencer_prefetch_free(struct Scene *scene);
+void BKE_sequencer_prefetch_free_all(void);
+void BKE_sequencer_prefetch_stats_get(struct Scene *scene, SeqPrefetchStats *r_stats);
+void BKE_sequencer_prefetch_original_get(
+        const SeqRenderData *context, struct Sequence **r_seq, struct Scene **r_scene);
+
 /* **********************************************************************
  * seqeffects.c
  *
@@ -359,6 +391,7 @@ void BKE_sequence_base_unique_name_recursive(ListBase *seqbasep, struct Sequence
 void BKE_sequence_base_dupli_recursive(
         const struct Scene *scene_src, struct Scene *scene_dst, struct ListBase *nseqbase, const struct ListBase *seqbase,
         int dupe_flag, const int flag);
+void BKE_sequence_base_free_copy(struct ListBase *seqbase);
 bool BKE_sequence_is_valid_check(struct Sequence *seq);
 
 void BKE_sequencer_clear_scene_in_allseqs(struct Main *bmain, struct Scene *sce);
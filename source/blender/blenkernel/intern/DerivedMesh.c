@@ -1036,7 +1036,8 @@ static void add_orco_mesh(
 			BKE_mesh_orco_verts_transform(ob->data, orco, totvert, 0);
 		}
 
-		if (!(layerorco = CustomData_get_layer(&mesh->vdata, layer))) {
+		/* the layer may be referenced from a cached modifier result */
+		if (!(layerorco = CustomData_duplicate_referenced_layer(&mesh->vdata, layer, mesh->totvert))) {
 			CustomData_add_layer(&mesh->vdata, layer, CD_CALLOC, NULL, mesh->totvert);
 			BKE_mesh_update_customdata_pointers(mesh, false);
 
@@ -1287,6 +1288,11 @@ static void mesh_calc_modifiers(
 	Mesh *me_orco = NULL;
 	Mesh *me_orco_cloth = NULL;
 
+	/* Results of constructive modifiers are cached for the evaluated object,
+	 * 'cache_input_id' identifies the input of the next modifier (0 when it's unknown). */
+	const bool use_result_cache = useCache && !(ob->mode & OB_MODE_ALL_PAINT);
+	unsigned int cache_input_id = 0;
+
 	for (; md; md = md->next, curr = curr->next) {
 		const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
 
@@ -1395,6 +1401,8 @@ static void mesh_calc_modifiers(
 			if (me) {
 				if (deformedVerts) {
 					BKE_mesh_apply_vert_coords(me, deformedVerts);
+					/* deformed input isn't identified by the result cache */
+					cache_input_id = 0;
 				}
 			}
 			else {
@@ -1427,6 +1435,10 @@ static void mesh_calc_modifiers(
 					range_vn_i(CustomData_get_layer(&me->edata, CD_ORIGINDEX), me->totedge, 0);
 					range_vn_i(CustomData_get_layer(&me->pdata, CD_ORIGINDEX), me->totpoly, 0);
 				}
+
+				if (use_result_cache) {
+					cache_input_id = modifier_resultCache_input_base(ob, deformedVerts, numVerts);
+				}
 			}
 
 
@@ -1449,8 +1461,24 @@ static void mesh_calc_modifiers(
 				}
 			}
 
-			Mesh *me_next = modwrap_applyModifier(md, &mectx_apply, me);
-			ASSERT_IS_VALID_MESH(me_next);
+			/* reuse the previous result when the input and settings are unchanged */
+			Mesh *me_next = NULL;
+			struct ModifierResultCacheKey *cache_key = modifier_resultCache_key_create(
+			        ob, md, me, cache_input_id, mask | (need_mapping ? CD_MASK_ORIGINDEX : 0), app_flags);
+
+			cache_input_id = 0;
+			if (cache_key) {
+				me_next = modifier_resultCache_lookup(ob, md, cache_key, &cache_input_id);
+				if (me_next) {
+					modifier_resultCache_key_free(cache_key);
+					cache_key = NULL;
+				}
+			}
+
+			if (me_next == NULL) {
+				me_next = modwrap_applyModifier(md, &mectx_apply, me);
+				ASSERT_IS_VALID_MESH(me_next);
+			}
 
 			if (me_next) {
 				/* if the modifier returned a new mesh, release the old one */
@@ -1470,6 +1498,13 @@ static void mesh_calc_modifiers(
 				mesh_copy_autosmooth(me, ob->data);
 			}
 
+			if (cache_key) {
+				if (me_next) {
+					me = modifier_resultCache_store(ob, md, cache_key, me, &cache_input_id);
+				}
+				modifier_resultCache_key_free(cache_key);
+			}
+
 			/* create an orco mesh in parallel */
 			if (nextmask & CD_MASK_ORCO) {
 				if (!me_orco) {
@@ -1603,6 +1638,11 @@ static void mesh_calc_modifiers(
 		CustomData_free_layers(&(*r_final)->ldata, CD_NORMAL, (*r_final)->totloop);
 	}
 
+	if (use_result_cache) {
+		/* cached results which aren't referenced by the final mesh can be freed */
+		modifier_resultCache_release(ob, *r_final);
+	}
+
 	if (me_orco) {
 		BKE_id_free(NULL, me_orco);
 	}
@@ -32,6 +32,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "DNA_cloth_types.h"
 #include "DNA_collection_types.h"
 #include "DNA_effect_types.h"
@@ -82,6 +84,28 @@ typedef struct SelfColDetectData {
 	bool collided;
 } SelfColDetectData;
 
+/* Impulses of one collision pair, computed in parallel and then applied to the vertices. */
+typedef struct CollPairImpulse {
+	float i1[3], i2[3], i3[3];
+	bool active;
+	bool clamped;   /* impulses exceed the clamp distance */
+} CollPairImpulse;
+
+/* The collision pairs of all colliders as one range, for the parallel passes. */
+typedef struct ColResponseData {
+	ClothModifierData *clmd;
+	Object **collobjs;              /* NULL for self collisions */
+	CollisionModifierData **collmds;
+	CollPair **collisions;
+	uint *offsets;                  /* first pair of every collider, totcoll + 1 */
+	uint totcoll;
+	CollPairImpulse *impulses;
+	bool *clamped;                  /* per collider, one of its pairs exceeds the clamp distance */
+	bool result;
+	int applied;                    /* number of vertices the impulses were applied to */
+	float dt;
+} ColResponseData;
+
 /***********************************
 Collision modifier code start
 ***********************************/
@@ -473,8 +497,9 @@ DO_INLINE void collision_interpolateOnTriangle ( float to[3], float v1[3], float
 	VECADDMUL(to, v3, w3);
 }
 
-static int cloth_collision_response_static(ClothModifierData *clmd, CollisionModifierData *collmd, Object *collob,
-                                           CollPair *collpair, uint collision_count, const float dt)
+/* Impulses for one collision pair, applied to the cloth vertices by #collision_response_apply_cb. */
+static void cloth_collision_response_static(ClothModifierData *clmd, CollisionModifierData *collmd, Object *collob,
+                                            CollPair *collpair, const float dt, CollPairImpulse *r_impulse)
 {
 	int result = 0;
 	Cloth *cloth1;
@@ -482,317 +507,267 @@ static int cloth_collision_response_static(ClothModifierData *clmd, CollisionMod
 	float v1[3], v2[3], relativeVelocity[3];
 	float magrelVel;
 	float epsilon2 = BLI_bvhtree_get_epsilon(collmd->bvhtree);
+	float *i1 = r_impulse->i1, *i2 = r_impulse->i2, *i3 = r_impulse->i3;
 
 	cloth1 = clmd->clothObject;
 
-	for (int i = 0; i < collision_count; i++, collpair++) {
-		float i1[3], i2[3], i3[3];
+	zero_v3(i1);
+	zero_v3(i2);
+	zero_v3(i3);
+	r_impulse->active = false;
+	r_impulse->clamped = false;
 
-		zero_v3(i1);
-		zero_v3(i2);
-		zero_v3(i3);
-
-		/* Only handle static collisions here. */
-		if (collpair->flag & (COLLISION_IN_FUTURE | COLLISION_INACTIVE)) {
-			continue;
-		}
-
-		/* Compute barycentric coordinates for both collision points. */
-		collision_compute_barycentric(collpair->pa,
-		                              cloth1->verts[collpair->ap1].tx,
-		                              cloth1->verts[collpair->ap2].tx,
-		                              cloth1->verts[collpair->ap3].tx,
-		                              &w1, &w2, &w3);
-
-		collision_compute_barycentric(collpair->pb,
-		                              collmd->current_x[collpair->bp1].co,
-		                              collmd->current_x[collpair->bp2].co,
-		                              collmd->current_x[collpair->bp3].co,
-		                              &u1, &u2, &u3);
-
-		/* Calculate relative "velocity". */
-		collision_interpolateOnTriangle(v1, cloth1->verts[collpair->ap1].tv, cloth1->verts[collpair->ap2].tv, cloth1->verts[collpair->ap3].tv, w1, w2, w3);
-
-		collision_interpolateOnTriangle(v2, collmd->current_v[collpair->bp1].co, collmd->current_v[collpair->bp2].co, collmd->current_v[collpair->bp3].co, u1, u2, u3);
-
-		sub_v3_v3v3(relativeVelocity, v2, v1);
+	/* Only handle static collisions here. */
+	if (collpair->flag & (COLLISION_IN_FUTURE | COLLISION_INACTIVE)) {
+		return;
+	}
 
-		/* Calculate the normal component of the relative velocity (actually only the magnitude - the direction is stored in 'normal'). */
-		magrelVel = dot_v3v3(relativeVelocity, collpair->normal);
+	/* Compute barycentric coordinates for both collision points. */
+	collision_compute_barycentric(collpair->pa,
+	                              cloth1->verts[collpair->ap1].tx,
+	                              cloth1->verts[collpair->ap2].tx,
+	                              cloth1->verts[collpair->ap3].tx,
+	                              &w1, &w2, &w3);
 
-		/* If magrelVel < 0 the edges are approaching each other. */
-		if (magrelVel > 0.0f) {
-			/* Calculate Impulse magnitude to stop all motion in normal direction. */
-			float magtangent = 0, repulse = 0, d = 0;
-			double impulse = 0.0;
-			float vrel_t_pre[3];
-			float temp[3];
-			float time_multiplier;
+	collision_compute_barycentric(collpair->pb,
+	                              collmd->current_x[collpair->bp1].co,
+	                              collmd->current_x[collpair->bp2].co,
+	                              collmd->current_x[collpair->bp3].co,
+	                              &u1, &u2, &u3);
 
-			/* Calculate tangential velocity. */
-			copy_v3_v3(temp, collpair->normal);
-			mul_v3_fl(temp, magrelVel);
-			sub_v3_v3v3(vrel_t_pre, relativeVelocity, temp);
+	/* Calculate relative "velocity". */
+	collision_interpolateOnTriangle(v1, cloth1->verts[collpair->ap1].tv, cloth1->verts[collpair->ap2].tv, cloth1->verts[collpair->ap3].tv, w1, w2, w3);
 
-			/* Decrease in magnitude of relative tangential velocity due to coulomb friction
-			 * in original formula "magrelVel" should be the "change of relative velocity in normal direction". */
-			magtangent = min_ff(collob->pd->pdef_cfrict * 0.01f * magrelVel, len_v3(vrel_t_pre));
+	collision_interpolateOnTriangle(v2, collmd->current_v[collpair->bp1].co, collmd->current_v[collpair->bp2].co, collmd->current_v[collpair->bp3].co, u1, u2, u3);
 
-			/* Apply friction impulse. */
-			if ( magtangent > ALMOST_ZERO ) {
-				normalize_v3(vrel_t_pre);
+	sub_v3_v3v3(relativeVelocity, v2, v1);
 
-				impulse = magtangent / 1.5;
+	/* Calculate the normal component of the relative velocity (actually only the magnitude - the direction is stored in 'normal'). */
+	magrelVel = dot_v3v3(relativeVelocity, collpair->normal);
 
-				VECADDMUL(i1, vrel_t_pre, w1 * impulse);
-				VECADDMUL(i2, vrel_t_pre, w2 * impulse);
-				VECADDMUL(i3, vrel_t_pre, w3 * impulse);
-			}
+	/* If magrelVel < 0 the edges are approaching each other. */
+	if (magrelVel > 0.0f) {
+		/* Calculate Impulse magnitude to stop all motion in normal direction. */
+		float magtangent = 0, repulse = 0, d = 0;
+		double impulse = 0.0;
+		float vrel_t_pre[3];
+		float temp[3];
+		float time_multiplier;
 
-			/* Apply velocity stopping impulse. */
-			impulse =  magrelVel / 1.5f;
+		/* Calculate tangential velocity. */
+		copy_v3_v3(temp, collpair->normal);
+		mul_v3_fl(temp, magrelVel);
+		sub_v3_v3v3(vrel_t_pre, relativeVelocity, temp);
 
-			VECADDMUL(i1, collpair->normal, w1 * impulse);
-			cloth1->verts[collpair->ap1].impulse_count++;
+		/* Decrease in magnitude of relative tangential velocity due to coulomb friction
+		 * in original formula "magrelVel" should be the "change of relative velocity in normal direction". */
+		magtangent = min_ff(collob->pd->pdef_cfrict * 0.01f * magrelVel, len_v3(vrel_t_pre));
 
-			VECADDMUL(i2, collpair->normal, w2 * impulse);
-			cloth1->verts[collpair->ap2].impulse_count++;
+		/* Apply friction impulse. */
+		if ( magtangent > ALMOST_ZERO ) {
+			normalize_v3(vrel_t_pre);
 
-			VECADDMUL(i3, collpair->normal, w3 * impulse);
-			cloth1->verts[collpair->ap3].impulse_count++;
+			impulse = magtangent / 1.5;
 
-			time_multiplier = 1.0f / (clmd->sim_parms->dt * clmd->sim_parms->timescale);
+			VECADDMUL(i1, vrel_t_pre, w1 * impulse);
+			VECADDMUL(i2, vrel_t_pre, w2 * impulse);
+			VECADDMUL(i3, vrel_t_pre, w3 * impulse);
+		}
 
-			d = clmd->coll_parms->epsilon*8.0f/9.0f + epsilon2*8.0f/9.0f - collpair->distance;
+		/* Apply velocity stopping impulse. */
+		impulse =  magrelVel / 1.5f;
 
-			if ((magrelVel < 0.1f * d * time_multiplier) && (d > ALMOST_ZERO)) {
-				repulse = MIN2(d / time_multiplier, 0.1f * d * time_multiplier - magrelVel);
+		VECADDMUL(i1, collpair->normal, w1 * impulse);
+		VECADDMUL(i2, collpair->normal, w2 * impulse);
+		VECADDMUL(i3, collpair->normal, w3 * impulse);
 
-				/* Stay on the safe side and clamp repulse. */
-				if (impulse > ALMOST_ZERO) {
-					repulse = min_ff(repulse, 5.0f * impulse);
-				}
+		time_multiplier = 1.0f / (clmd->sim_parms->dt * clmd->sim_parms->timescale);
 
-				repulse = max_ff(impulse, repulse);
+		d = clmd->coll_parms->epsilon*8.0f/9.0f + epsilon2*8.0f/9.0f - collpair->distance;
 
-				impulse = repulse / 1.5f;
+		if ((magrelVel < 0.1f * d * time_multiplier) && (d > ALMOST_ZERO)) {
+			repulse = MIN2(d / time_multiplier, 0.1f * d * time_multiplier - magrelVel);
 
-				VECADDMUL(i1, collpair->normal, impulse);
-				VECADDMUL(i2, collpair->normal, impulse);
-				VECADDMUL(i3, collpair->normal, impulse);
+			/* Stay on the safe side and clamp repulse. */
+			if (impulse > ALMOST_ZERO) {
+				repulse = min_ff(repulse, 5.0f * impulse);
 			}
 
-			result = 1;
-		}
-		else {
-			float time_multiplier = 1.0f / (clmd->sim_parms->dt * clmd->sim_parms->timescale);
-			float d;
-
-			d = clmd->coll_parms->epsilon*8.0f/9.0f + epsilon2*8.0f/9.0f - collpair->distance;
-
-			if (d > ALMOST_ZERO) {
-				/* Stay on the safe side and clamp repulse. */
-				float repulse = d / time_multiplier;
-				float impulse = repulse / 4.5f;
+			repulse = max_ff(impulse, repulse);
 
-				VECADDMUL(i1, collpair->normal, w1 * impulse);
-				VECADDMUL(i2, collpair->normal, w2 * impulse);
-				VECADDMUL(i3, collpair->normal, w3 * impulse);
+			impulse = repulse / 1.5f;
 
-				cloth1->verts[collpair->ap1].impulse_count++;
-				cloth1->verts[collpair->ap2].impulse_count++;
-				cloth1->verts[collpair->ap3].impulse_count++;
-
-				result = 1;
-			}
+			VECADDMUL(i1, collpair->normal, impulse);
+			VECADDMUL(i2, collpair->normal, impulse);
+			VECADDMUL(i3, collpair->normal, impulse);
 		}
 
-		if (result) {
-			float clamp = clmd->coll_parms->clamp * dt;
+		result = 1;
+	}
+	else {
+		float time_multiplier = 1.0f / (clmd->sim_parms->dt * clmd->sim_parms->timescale);
+		float d;
 
-			if ((clamp > 0.0f) &&
-			    ((len_v3(i1) > clamp) ||
-			     (len_v3(i2) > clamp) ||
-			     (len_v3(i3) > clamp)))
-			{
-				return 0;
-			}
+		d = clmd->coll_parms->epsilon*8.0f/9.0f + epsilon2*8.0f/9.0f - collpair->distance;
 
-			for (int j = 0; j < 3; j++) {
-				if (cloth1->verts[collpair->ap1].impulse_count > 0 && ABS(cloth1->verts[collpair->ap1].impulse[j]) < ABS(i1[j]))
-					cloth1->verts[collpair->ap1].impulse[j] = i1[j];
+		if (d > ALMOST_ZERO) {
+			/* Stay on the safe side and clamp repulse. */
+			float repulse = d / time_multiplier;
+			float impulse = repulse / 4.5f;
 
-				if (cloth1->verts[collpair->ap2].impulse_count > 0 && ABS(cloth1->verts[collpair->ap2].impulse[j]) < ABS(i2[j]))
-					cloth1->verts[collpair->ap2].impulse[j] = i2[j];
+			VECADDMUL(i1, collpair->normal, w1 * impulse);
+			VECADDMUL(i2, collpair->normal, w2 * impulse);
+			VECADDMUL(i3, collpair->normal, w3 * impulse);
 
-				if (cloth1->verts[collpair->ap3].impulse_count > 0 && ABS(cloth1->verts[collpair->ap3].impulse[j]) < ABS(i3[j]))
-					cloth1->verts[collpair->ap3].impulse[j] = i3[j];
-			}
+			result = 1;
 		}
 	}
 
-	return result;
+	if (result) {
+		float clamp = clmd->coll_parms->clamp * dt;
+
+		r_impulse->active = true;
+		r_impulse->clamped = ((clamp > 0.0f) &&
+		                      ((len_v3(i1) > clamp) ||
+		                       (len_v3(i2) > clamp) ||
+		                       (len_v3(i3) > clamp)));
+	}
 }
 
-static int cloth_selfcollision_response_static(ClothModifierData *clmd, CollPair *collpair,
-                                               uint collision_count, const float dt)
+static void cloth_selfcollision_response_static(ClothModifierData *clmd, CollPair *collpair,
+                                                const float dt, CollPairImpulse *r_impulse)
 {
 	int result = 0;
 	Cloth *cloth1;
 	float w1, w2, w3, u1, u2, u3;
 	float v1[3], v2[3], relativeVelocity[3];
 	float magrelVel;
+	float *i1 = r_impulse->i1, *i2 = r_impulse->i2, *i3 = r_impulse->i3;
 
 	cloth1 = clmd->clothObject;
 
-	for (int i = 0; i < collision_count; i++, collpair++) {
-		float i1[3], i2[3], i3[3];
-
-		zero_v3(i1);
-		zero_v3(i2);
-		zero_v3(i3);
-
-		/* Only handle static collisions here. */
-		if (collpair->flag & (COLLISION_IN_FUTURE | COLLISION_INACTIVE)) {
-			continue;
-		}
-
-		/* Compute barycentric coordinates for both collision points. */
-		collision_compute_barycentric(collpair->pa,
-		                              cloth1->verts[collpair->ap1].tx,
-		                              cloth1->verts[collpair->ap2].tx,
-		                              cloth1->verts[collpair->ap3].tx,
-		                              &w1, &w2, &w3);
-
-		collision_compute_barycentric(collpair->pb,
-		                              cloth1->verts[collpair->bp1].tx,
-		                              cloth1->verts[collpair->bp2].tx,
-		                              cloth1->verts[collpair->bp3].tx,
-		                              &u1, &u2, &u3);
-
-		/* Calculate relative "velocity". */
-		collision_interpolateOnTriangle(v1, cloth1->verts[collpair->ap1].tv, cloth1->verts[collpair->ap2].tv, cloth1->verts[collpair->ap3].tv, w1, w2, w3);
-
-		collision_interpolateOnTriangle(v2, cloth1->verts[collpair->bp1].tv, cloth1->verts[collpair->bp2].tv, cloth1->verts[collpair->bp3].tv, u1, u2, u3);
+	zero_v3(i1);
+	zero_v3(i2);
+	zero_v3(i3);
+	r_impulse->active = false;
+	r_impulse->clamped = false;
 
-		sub_v3_v3v3(relativeVelocity, v2, v1);
+	/* Only handle static collisions here. */
+	if (collpair->flag & (COLLISION_IN_FUTURE | COLLISION_INACTIVE)) {
+		return;
+	}
 
-		/* Calculate the normal component of the relative velocity (actually only the magnitude - the direction is stored in 'normal'). */
-		magrelVel = dot_v3v3(relativeVelocity, collpair->normal);
+	/* Compute barycentric coordinates for both collision points. */
+	collision_compute_barycentric(collpair->pa,
+	                              cloth1->verts[collpair->ap1].tx,
+	                              cloth1->verts[collpair->ap2].tx,
+	                              cloth1->verts[collpair->ap3].tx,
+	                              &w1, &w2, &w3);
 
-		/* TODO: Impulses should be weighed by mass as this is self col,
-		 * this has to be done after mass distribution is implemented. */
+	collision_compute_barycentric(collpair->pb,
+	                              cloth1->verts[collpair->bp1].tx,
+	                              cloth1->verts[collpair->bp2].tx,
+	                              cloth1->verts[collpair->bp3].tx,
+	                              &u1, &u2, &u3);
 
-		/* If magrelVel < 0 the edges are approaching each other. */
-		if (magrelVel > 0.0f) {
-			/* Calculate Impulse magnitude to stop all motion in normal direction. */
-			float magtangent = 0, repulse = 0, d = 0;
-			double impulse = 0.0;
-			float vrel_t_pre[3];
-			float temp[3], time_multiplier;
+	/* Calculate relative "velocity". */
+	collision_interpolateOnTriangle(v1, cloth1->verts[collpair->ap1].tv, cloth1->verts[collpair->ap2].tv, cloth1->verts[collpair->ap3].tv, w1, w2, w3);
 
-			/* Calculate tangential velocity. */
-			copy_v3_v3(temp, collpair->normal);
-			mul_v3_fl(temp, magrelVel);
-			sub_v3_v3v3(vrel_t_pre, relativeVelocity, temp);
+	collision_interpolateOnTriangle(v2, cloth1->verts[collpair->bp1].tv, cloth1->verts[collpair->bp2].tv, cloth1->verts[collpair->bp3].tv, u1, u2, u3);
 
-			/* Decrease in magnitude of relative tangential velocity due to coulomb friction
-			 * in original formula "magrelVel" should be the "change of relative velocity in normal direction". */
-			magtangent = min_ff(clmd->coll_parms->self_friction * 0.01f * magrelVel, len_v3(vrel_t_pre));
+	sub_v3_v3v3(relativeVelocity, v2, v1);
 
-			/* Apply friction impulse. */
-			if (magtangent > ALMOST_ZERO) {
-				normalize_v3(vrel_t_pre);
+	/* Calculate the normal component of the relative velocity (actually only the magnitude - the direction is stored in 'normal'). */
+	magrelVel = dot_v3v3(relativeVelocity, collpair->normal);
 
-				impulse = magtangent / 1.5;
+	/* TODO: Impulses should be weighed by mass as this is self col,
+	 * this has to be done after mass distribution is implemented. */
 
-				VECADDMUL(i1, vrel_t_pre, w1 * impulse);
-				VECADDMUL(i2, vrel_t_pre, w2 * impulse);
-				VECADDMUL(i3, vrel_t_pre, w3 * impulse);
-			}
+	/* If magrelVel < 0 the edges are approaching each other. */
+	if (magrelVel > 0.0f) {
+		/* Calculate Impulse magnitude to stop all motion in normal direction. */
+		float magtangent = 0, repulse = 0, d = 0;
+		double impulse = 0.0;
+		float vrel_t_pre[3];
+		float temp[3], time_multiplier;
 
-			/* Apply velocity stopping impulse. */
-			impulse = magrelVel / 3.0f;
+		/* Calculate tangential velocity. */
+		copy_v3_v3(temp, collpair->normal);
+		mul_v3_fl(temp, magrelVel);
+		sub_v3_v3v3(vrel_t_pre, relativeVelocity, temp);
 
-			VECADDMUL(i1, collpair->normal, w1 * impulse);
-			cloth1->verts[collpair->ap1].impulse_count++;
+		/* Decrease in magnitude of relative tangential velocity due to coulomb friction
+		 * in original formula "magrelVel" should be the "change of relative velocity in normal direction". */
+		magtangent = min_ff(clmd->coll_parms->self_friction * 0.01f * magrelVel, len_v3(vrel_t_pre));
 
-			VECADDMUL(i2, collpair->normal, w2 * impulse);
-			cloth1->verts[collpair->ap2].impulse_count++;
+		/* Apply friction impulse. */
+		if (magtangent > ALMOST_ZERO) {
+			normalize_v3(vrel_t_pre);
 
-			VECADDMUL(i3, collpair->normal, w3 * impulse);
-			cloth1->verts[collpair->ap3].impulse_count++;
+			impulse = magtangent / 1.5;
 
-			time_multiplier = 1.0f / (clmd->sim_parms->dt * clmd->sim_parms->timescale);
+			VECADDMUL(i1, vrel_t_pre, w1 * impulse);
+			VECADDMUL(i2, vrel_t_pre, w2 * impulse);
+			VECADDMUL(i3, vrel_t_pre, w3 * impulse);
+		}
 
-			d = clmd->coll_parms->selfepsilon * 8.0f / 9.0f * 2.0f - collpair->distance;
+		/* Apply velocity stopping impulse. */
+		impulse = magrelVel / 3.0f;
 
-			if ((magrelVel < 0.1f * d * time_multiplier) && (d > ALMOST_ZERO)) {
-				repulse = MIN2 (d / time_multiplier, 0.1f * d * time_multiplier - magrelVel);
+		VECADDMUL(i1, collpair->normal, w1 * impulse);
+		VECADDMUL(i2, collpair->normal, w2 * impulse);
+		VECADDMUL(i3, collpair->normal, w3 * impulse);
 
-				if (impulse > ALMOST_ZERO) {
-					repulse = min_ff(repulse, 5.0*impulse);
-				}
+		time_multiplier = 1.0f / (clmd->sim_parms->dt * clmd->sim_parms->timescale);
 
-				repulse = max_ff(impulse, repulse);
+		d = clmd->coll_parms->selfepsilon * 8.0f / 9.0f * 2.0f - collpair->distance;
 
-				impulse = repulse / 1.5f;
+		if ((magrelVel < 0.1f * d * time_multiplier) && (d > ALMOST_ZERO)) {
+			repulse = MIN2 (d / time_multiplier, 0.1f * d * time_multiplier - magrelVel);
 
-				VECADDMUL(i1, collpair->normal, w1 * impulse);
-				VECADDMUL(i2, collpair->normal, w2 * impulse);
-				VECADDMUL(i3, collpair->normal, w3 * impulse);
+			if (impulse > ALMOST_ZERO) {
+				repulse = min_ff(repulse, 5.0*impulse);
 			}
 
-			result = 1;
-		}
-		else {
-			float time_multiplier = 1.0f / (clmd->sim_parms->dt * clmd->sim_parms->timescale);
-			float d;
-
-			d = clmd->coll_parms->selfepsilon * 8.0f / 9.0f * 2.0f - collpair->distance;
-
-			if ( d > ALMOST_ZERO) {
-				/* Stay on the safe side and clamp repulse. */
-				float repulse = d*1.0f/time_multiplier;
-				float impulse = repulse / 9.0f;
+			repulse = max_ff(impulse, repulse);
 
-				VECADDMUL(i1, collpair->normal, w1 * impulse);
-				VECADDMUL(i2, collpair->normal, w2 * impulse);
-				VECADDMUL(i3, collpair->normal, w3 * impulse);
+			impulse = repulse / 1.5f;
 
-				cloth1->verts[collpair->ap1].impulse_count++;
-				cloth1->verts[collpair->ap2].impulse_count++;
-				cloth1->verts[collpair->ap3].impulse_count++;
-
-				result = 1;
-			}
+			VECADDMUL(i1, collpair->normal, w1 * impulse);
+			VECADDMUL(i2, collpair->normal, w2 * impulse);
+			VECADDMUL(i3, collpair->normal, w3 * impulse);
 		}
 
-		if (result) {
-			float clamp = clmd->coll_parms->self_clamp * dt;
+		result = 1;
+	}
+	else {
+		float time_multiplier = 1.0f / (clmd->sim_parms->dt * clmd->sim_parms->timescale);
+		float d;
 
-			if ((clamp > 0.0f) &&
-			    ((len_v3(i1) > clamp) ||
-			     (len_v3(i2) > clamp) ||
-			     (len_v3(i3) > clamp)))
-			{
-				return 0;
-			}
+		d = clmd->coll_parms->selfepsilon * 8.0f / 9.0f * 2.0f - collpair->distance;
 
-			for (int j = 0; j < 3; j++) {
-				if (cloth1->verts[collpair->ap1].impulse_count > 0 && ABS(cloth1->verts[collpair->ap1].impulse[j]) < ABS(i1[j]))
-					cloth1->verts[collpair->ap1].impulse[j] = i1[j];
+		if ( d > ALMOST_ZERO) {
+			/* Stay on the safe side and clamp repulse. */
+			float repulse = d*1.0f/time_multiplier;
+			float impulse = repulse / 9.0f;
 
-				if (cloth1->verts[collpair->ap2].impulse_count > 0 && ABS(cloth1->verts[collpair->ap2].impulse[j]) < ABS(i2[j]))
-					cloth1->verts[collpair->ap2].impulse[j] = i2[j];
+			VECADDMUL(i1, collpair->normal, w1 * impulse);
+			VECADDMUL(i2, collpair->normal, w2 * impulse);
+			VECADDMUL(i3, collpair->normal, w3 * impulse);
 
-				if (cloth1->verts[collpair->ap3].impulse_count > 0 && ABS(cloth1->verts[collpair->ap3].impulse[j]) < ABS(i3[j]))
-					cloth1->verts[collpair->ap3].impulse[j] = i3[j];
-			}
+			result = 1;
 		}
 	}
 
-	return result;
+	if (result) {
+		float clamp = clmd->coll_parms->self_clamp * dt;
+
+		r_impulse->active = true;
+		r_impulse->clamped = ((clamp > 0.0f) &&
+		                      ((len_v3(i1) > clamp) ||
+		                       (len_v3(i2) > clamp) ||
+		                       (len_v3(i3) > clamp)));
+	}
 }
 
 #ifdef __GNUC__
@@ -1058,28 +1033,79 @@ void BKE_collider_cache_free(ListBase **colliders)
 	}
 }
 
-static bool cloth_bvh_objcollisions_nearcheck(ClothModifierData * clmd, CollisionModifierData *collmd,
-                                              CollPair **collisions, int numresult,
-                                              BVHTreeOverlap *overlap, bool culling, bool use_normal)
+/* collider of the pair at index in the flat range of all pairs */
+BLI_INLINE uint collision_range_find(const uint *offsets, uint totcoll, uint index)
 {
-	*collisions = (CollPair *)MEM_mallocN(sizeof(CollPair) * numresult, "collision array");
+	uint lo = 0, hi = totcoll;
 
-	ColDetectData data = {
-		.clmd = clmd,
-		.collmd = collmd,
-		.overlap = overlap,
-		.collisions = *collisions,
-		.culling = culling,
-		.use_normal = use_normal,
-		.collided = false,
+	/* last collider starting at or before index, empty colliders are skipped */
+	while (hi - lo > 1) {
+		const uint mid = (lo + hi) / 2;
+		if (offsets[mid] <= index) {
+			lo = mid;
+		}
+		else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+typedef struct ColDetectAllData {
+	ColDetectData *colliders;
+	uint *offsets;
+	uint totcoll;
+} ColDetectAllData;
+
+static void cloth_collision_all(
+        void *__restrict userdata,
+        const int index,
+        const ParallelRangeTLS *__restrict tls)
+{
+	ColDetectAllData *data = (ColDetectAllData *)userdata;
+	const uint c = collision_range_find(data->offsets, data->totcoll, index);
+
+	cloth_collision(&data->colliders[c], index - data->offsets[c], tls);
+}
+
+/* Narrow phase for all colliders at once, so small colliders don't each wait for their own threads. */
+static bool cloth_bvh_objcollisions_nearcheck(ClothModifierData *clmd, Object **collobjs, CollisionModifierData **collmds,
+                                              CollPair **collisions, uint *offsets, const uint numcollobj,
+                                              BVHTreeOverlap **overlap)
+{
+	ColDetectData *colliders = MEM_callocN(sizeof(*colliders) * numcollobj, "ColDetectData");
+	ColDetectAllData data = {
+		.colliders = colliders,
+		.offsets = offsets,
+		.totcoll = numcollobj,
 	};
+	bool collided = false;
+
+	for (uint i = 0; i < numcollobj; i++) {
+		Object *collob = collobjs[i];
+
+		colliders[i].clmd = clmd;
+		colliders[i].collmd = collmds[i];
+		colliders[i].overlap = overlap[i];
+		colliders[i].collisions = collisions[i];
+		colliders[i].culling = (collob->pd->flag & PFIELD_CLOTH_USE_CULLING);
+		colliders[i].use_normal = (collob->pd->flag & PFIELD_CLOTH_USE_NORMAL);
+		colliders[i].collided = false;
+	}
 
 	ParallelRangeSettings settings;
 	BLI_parallel_range_settings_defaults(&settings);
 	settings.use_threading = true;
-	BLI_task_parallel_range(0, numresult, &data, cloth_collision, &settings);
+	BLI_task_parallel_range(0, offsets[numcollobj], &data, cloth_collision_all, &settings);
 
-	return data.collided;
+	for (uint i = 0; i < numcollobj; i++) {
+		collided = collided || colliders[i].collided;
+	}
+
+	MEM_freeN(colliders);
+
+	return collided;
 }
 
 static bool cloth_bvh_selfcollisions_nearcheck(ClothModifierData * clmd, CollPair *collisions,
@@ -1100,91 +1126,196 @@ static bool cloth_bvh_selfcollisions_nearcheck(ClothModifierData * clmd, CollPai
 	return data.collided;
 }
 
-static int cloth_bvh_objcollisions_resolve(ClothModifierData * clmd, Object **collobjs, CollPair **collisions,
-                                           uint *collision_counts, const uint numcollobj, const float dt)
+static void collision_response_compute_cb(
+        void *__restrict userdata,
+        const int index,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
 {
-	Cloth *cloth = clmd->clothObject;
-	int i = 0, j = 0, mvert_num = 0;
-	ClothVertex *verts = NULL;
-	int ret = 0;
-	int result = 0;
-
-	mvert_num = clmd->clothObject->mvert_num;
-	verts = cloth->verts;
+	ColResponseData *data = (ColResponseData *)userdata;
+	const uint c = collision_range_find(data->offsets, data->totcoll, index);
+	CollPair *collpair = data->collisions[c] + (index - data->offsets[c]);
+	CollPairImpulse *impulse = &data->impulses[index];
 
-	result = 1;
+	if (data->collobjs) {
+		cloth_collision_response_static(data->clmd, data->collmds[c], data->collobjs[c], collpair, data->dt, impulse);
+	}
+	else {
+		cloth_selfcollision_response_static(data->clmd, collpair, data->dt, impulse);
+	}
 
-	for (j = 0; j < 2; j++) {
-		result = 0;
+	if (impulse->clamped) {
+		data->clamped[c] = true;
+	}
+}
 
-		for (i = 0; i < numcollobj; i++) {
-			Object *collob= collobjs[i];
-			CollisionModifierData *collmd = (CollisionModifierData *)modifiers_findByType(collob, eModifierType_Collision);
+/* keep the impulse with the largest magnitude, per axis */
+BLI_INLINE void collision_impulse_max_abs(float *impulse, const float value)
+{
+	union { float f; uint32_t u; } old, new;
 
-			if ( collmd->bvhtree ) {
-				result += cloth_collision_response_static(clmd, collmd, collob, collisions[i], collision_counts[i], dt);
-			}
-		}
+	old.f = *impulse;
+	new.f = value;
 
-		/* Apply impulses in parallel. */
-		if (result) {
-			for (i = 0; i < mvert_num; i++) {
-				// calculate "velocities" (just xnew = xold + v; no dt in v)
-				if (verts[i].impulse_count) {
-					add_v3_v3(verts[i].tv, verts[i].impulse);
-					add_v3_v3(verts[i].dcvel, verts[i].impulse);
-					zero_v3(verts[i].impulse);
-					verts[i].impulse_count = 0;
-
-					ret++;
-				}
-			}
-		}
-		else {
+	while (fabsf(old.f) < fabsf(value)) {
+		const uint32_t prev = atomic_cas_uint32((uint32_t *)impulse, old.u, new.u);
+		if (prev == old.u) {
 			break;
 		}
+		old.u = prev;
 	}
-	return ret;
 }
 
-static int cloth_bvh_selfcollisions_resolve(ClothModifierData * clmd, CollPair *collisions, int collision_count, const float dt)
+BLI_INLINE void collision_impulse_apply(ClothVertex *vert, const float impulse[3])
 {
-	Cloth *cloth = clmd->clothObject;
-	int i = 0, j = 0, mvert_num = 0;
-	ClothVertex *verts = NULL;
+	atomic_add_and_fetch_uint32(&vert->impulse_count, 1);
+
+	for (int j = 0; j < 3; j++) {
+		collision_impulse_max_abs(&vert->impulse[j], impulse[j]);
+	}
+}
+
+static void collision_response_apply_cb(
+        void *__restrict userdata,
+        const int index,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	ColResponseData *data = (ColResponseData *)userdata;
+	const uint c = collision_range_find(data->offsets, data->totcoll, index);
+	CollPair *collpair = data->collisions[c] + (index - data->offsets[c]);
+	CollPairImpulse *impulse = &data->impulses[index];
+	ClothVertex *verts = data->clmd->clothObject->verts;
+
+	/* a collider with an impulse over the clamp distance contributes none */
+	if (!impulse->active || data->clamped[c]) {
+		return;
+	}
+
+	collision_impulse_apply(&verts[collpair->ap1], impulse->i1);
+	collision_impulse_apply(&verts[collpair->ap2], impulse->i2);
+	collision_impulse_apply(&verts[collpair->ap3], impulse->i3);
+
+	data->result = true;
+}
+
+static void collision_vertex_apply_cb(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict tls)
+{
+	ColResponseData *data = (ColResponseData *)userdata;
+	ClothVertex *verts = data->clmd->clothObject->verts;
+	int *ret = tls->userdata_chunk;
+
+	// calculate "velocities" (just xnew = xold + v; no dt in v)
+	if (verts[i].impulse_count) {
+		add_v3_v3(verts[i].tv, verts[i].impulse);
+		add_v3_v3(verts[i].dcvel, verts[i].impulse);
+		zero_v3(verts[i].impulse);
+		verts[i].impulse_count = 0;
+
+		(*ret)++;
+	}
+}
+
+static void collision_vertex_apply_finalize(void *__restrict userdata, void *__restrict userdata_chunk)
+{
+	ColResponseData *data = (ColResponseData *)userdata;
+	int *ret = userdata_chunk;
+
+	data->applied += *ret;
+}
+
+/* Computes the impulses of all pairs in parallel, accumulates them per vertex with atomics
+ * and applies them, twice. Returns the number of vertices that got an impulse. */
+static int cloth_collisions_resolve(ColResponseData *data, const float dt)
+{
+	const uint totpairs = data->offsets[data->totcoll];
+	const uint mvert_num = data->clmd->clothObject->mvert_num;
 	int ret = 0;
-	int result = 0;
 
-	mvert_num = clmd->clothObject->mvert_num;
-	verts = cloth->verts;
+	if (totpairs == 0) {
+		return 0;
+	}
 
-	for (j = 0; j < 2; j++) {
-		result = 0;
+	data->impulses = MEM_mallocN(sizeof(*data->impulses) * totpairs, "CollPairImpulse");
+	data->clamped = MEM_mallocN(sizeof(*data->clamped) * data->totcoll, "collision clamped");
+	data->dt = dt;
 
-		result += cloth_selfcollision_response_static(clmd, collisions, collision_count, dt);
+	for (int j = 0; j < 2; j++) {
+		ParallelRangeSettings settings;
+		int ret_chunk = 0;
 
-		/* Apply impulses in parallel. */
-		if (result) {
-			for (i = 0; i < mvert_num; i++) {
-				if (verts[i].impulse_count) {
-					// VECADDMUL ( verts[i].tv, verts[i].impulse, 1.0f / verts[i].impulse_count );
-					add_v3_v3(verts[i].tv, verts[i].impulse);
-					add_v3_v3(verts[i].dcvel, verts[i].impulse);
-					zero_v3(verts[i].impulse);
-					verts[i].impulse_count = 0;
-
-					ret++;
-				}
-			}
-		}
+		memset(data->clamped, 0, sizeof(*data->clamped) * data->totcoll);
+		data->result = false;
 
-		if (!result) {
+		BLI_parallel_range_settings_defaults(&settings);
+		settings.use_threading = true;
+		BLI_task_parallel_range(0, totpairs, data, collision_response_compute_cb, &settings);
+		BLI_task_parallel_range(0, totpairs, data, collision_response_apply_cb, &settings);
+
+		if (!data->result) {
 			break;
 		}
+
+		/* Apply impulses in parallel. */
+		data->applied = 0;
+		settings.userdata_chunk = &ret_chunk;
+		settings.userdata_chunk_size = sizeof(ret_chunk);
+		settings.func_finalize = collision_vertex_apply_finalize;
+		settings.min_iter_per_thread = 1024;
+		BLI_task_parallel_range(0, mvert_num, data, collision_vertex_apply_cb, &settings);
+
+		ret += data->applied;
 	}
+
+	MEM_freeN(data->impulses);
+	MEM_freeN(data->clamped);
+
 	return ret;
 }
 
+typedef struct ColOverlapData {
+	Cloth *cloth;
+	Object **collobjs;
+	CollisionModifierData **collmds;
+	BVHTreeOverlap **overlap_obj;
+	uint *coll_counts_obj;
+	uint numcollobj;
+	BVHTreeOverlap *overlap_self;
+	uint coll_count_self;
+	bool use_self;
+	float step, dt;
+} ColOverlapData;
+
+/* broad phase of one collider, or of the self collisions for the last index */
+static void cloth_collision_overlap_cb(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	ColOverlapData *data = (ColOverlapData *)userdata;
+
+	if (i == data->numcollobj) {
+		if (data->use_self) {
+			data->overlap_self = BLI_bvhtree_overlap(data->cloth->bvhselftree, data->cloth->bvhselftree,
+			                                         &data->coll_count_self, NULL, NULL);
+		}
+		return;
+	}
+
+	CollisionModifierData *collmd = data->collmds[i];
+
+	if (!collmd->bvhtree) {
+		return;
+	}
+
+	/* Move object to position (step) in time. */
+	collision_move_object(collmd, data->step + data->dt, data->step);
+
+	data->overlap_obj[i] = BLI_bvhtree_overlap(data->cloth->bvhtree, collmd->bvhtree,
+	                                           &data->coll_counts_obj[i], NULL, NULL);
+}
+
 int cloth_bvh_collision(Depsgraph *depsgraph, Object *ob, ClothModifierData *clmd, float step, float dt)
 {
 	Cloth *cloth = clmd->clothObject;
@@ -1194,11 +1325,11 @@ int cloth_bvh_collision(Depsgraph *depsgraph, Object *ob, ClothModifierData *clm
 	ClothVertex *verts = NULL;
 	int ret = 0, ret2 = 0;
 	Object **collobjs = NULL;
+	CollisionModifierData **collmds = NULL;
 	unsigned int numcollobj = 0;
 	uint *coll_counts_obj = NULL;
 	BVHTreeOverlap **overlap_obj = NULL;
-	uint coll_count_self = 0;
-	BVHTreeOverlap *overlap_self = NULL;
+	ColOverlapData overlap_data = {NULL};
 
 	if ((clmd->sim_parms->flags & CLOTH_SIMSETTINGS_FLAG_COLLOBJ) || cloth_bvh==NULL)
 		return 0;
@@ -1214,27 +1345,34 @@ int cloth_bvh_collision(Depsgraph *depsgraph, Object *ob, ClothModifierData *clm
 		if (collobjs) {
 			coll_counts_obj = MEM_callocN(sizeof(uint) * numcollobj, "CollCounts");
 			overlap_obj = MEM_callocN(sizeof(*overlap_obj) * numcollobj, "BVHOverlap");
+			collmds = MEM_mallocN(sizeof(*collmds) * numcollobj, "CollisionModifierData");
 
 			for (i = 0; i < numcollobj; i++) {
-				Object *collob = collobjs[i];
-				CollisionModifierData *collmd = (CollisionModifierData *)modifiers_findByType(collob, eModifierType_Collision);
-
-				if (!collmd->bvhtree) {
-					continue;
-				}
-
-				/* Move object to position (step) in time. */
-				collision_move_object(collmd, step + dt, step);
-
-				overlap_obj[i] = BLI_bvhtree_overlap(cloth_bvh, collmd->bvhtree, &coll_counts_obj[i], NULL, NULL);
+				collmds[i] = (CollisionModifierData *)modifiers_findByType(collobjs[i], eModifierType_Collision);
 			}
 		}
 	}
 
 	if (clmd->coll_parms->flags & CLOTH_COLLSETTINGS_FLAG_SELF) {
 		bvhtree_update_from_cloth(clmd, false, true);
+	}
+
+	/* Overlap queries of all colliders and the self collisions at once. */
+	overlap_data.cloth = cloth;
+	overlap_data.collobjs = collobjs;
+	overlap_data.collmds = collmds;
+	overlap_data.overlap_obj = overlap_obj;
+	overlap_data.coll_counts_obj = coll_counts_obj;
+	overlap_data.numcollobj = (collobjs) ? numcollobj : 0;
+	overlap_data.use_self = (clmd->coll_parms->flags & CLOTH_COLLSETTINGS_FLAG_SELF) && cloth->bvhselftree;
+	overlap_data.step = step;
+	overlap_data.dt = dt;
 
-		overlap_self = BLI_bvhtree_overlap(cloth->bvhselftree, cloth->bvhselftree, &coll_count_self, NULL, NULL);
+	{
+		ParallelRangeSettings settings;
+		BLI_parallel_range_settings_defaults(&settings);
+		settings.use_threading = true;
+		BLI_task_parallel_range(0, overlap_data.numcollobj + 1, &overlap_data, cloth_collision_overlap_cb, &settings);
 	}
 
 	do {
@@ -1242,51 +1380,64 @@ int cloth_bvh_collision(Depsgraph *depsgraph, Object *ob, ClothModifierData *clm
 
 		/* Object collisions. */
 		if ((clmd->coll_parms->flags & CLOTH_COLLSETTINGS_FLAG_ENABLED) && collobjs) {
-			CollPair **collisions;
-			bool collided = false;
-
-			collisions = MEM_callocN(sizeof(CollPair *) * numcollobj, "CollPair");
+			CollPair **collisions = MEM_callocN(sizeof(CollPair *) * numcollobj, "CollPair");
+			uint *offsets = MEM_mallocN(sizeof(uint) * (numcollobj + 1), "collision offsets");
+			CollPair *collisions_all;
 
+			offsets[0] = 0;
 			for (i = 0; i < numcollobj; i++) {
-				Object *collob = collobjs[i];
-				CollisionModifierData *collmd = (CollisionModifierData *)modifiers_findByType(collob, eModifierType_Collision);
-
-				if (!collmd->bvhtree) {
-					continue;
-				}
-
-				if (coll_counts_obj[i] && overlap_obj[i]) {
-					collided = cloth_bvh_objcollisions_nearcheck(clmd, collmd, &collisions[i], coll_counts_obj[i], overlap_obj[i],
-					                                             (collob->pd->flag & PFIELD_CLOTH_USE_CULLING),
-					                                             (collob->pd->flag & PFIELD_CLOTH_USE_NORMAL)) || collided;
-				}
+				const bool use_coll = (collmds[i]->bvhtree && coll_counts_obj[i] && overlap_obj[i]);
+				offsets[i + 1] = offsets[i] + (use_coll ? coll_counts_obj[i] : 0);
 			}
 
-			if (collided) {
-				ret += cloth_bvh_objcollisions_resolve(clmd, collobjs, collisions, coll_counts_obj, numcollobj, dt);
-				ret2 += ret;
+			collisions_all = MEM_mallocN(sizeof(CollPair) * max_ii(offsets[numcollobj], 1), "collision array");
+			for (i = 0; i < numcollobj; i++) {
+				collisions[i] = collisions_all + offsets[i];
 			}
 
-			for (i = 0; i < numcollobj; i++) {
-				MEM_SAFE_FREE(collisions[i]);
+			if (offsets[numcollobj] &&
+			    cloth_bvh_objcollisions_nearcheck(clmd, collobjs, collmds, collisions, offsets, numcollobj, overlap_obj))
+			{
+				ColResponseData data = {
+					.clmd = clmd,
+					.collobjs = collobjs,
+					.collmds = collmds,
+					.collisions = collisions,
+					.offsets = offsets,
+					.totcoll = numcollobj,
+				};
+
+				ret += cloth_collisions_resolve(&data, dt);
+				ret2 += ret;
 			}
 
+			MEM_freeN(collisions_all);
 			MEM_freeN(collisions);
+			MEM_freeN(offsets);
 		}
 
 		/* Self collisions. */
 		if (clmd->coll_parms->flags & CLOTH_COLLSETTINGS_FLAG_SELF) {
 			CollPair *collisions = NULL;
+			uint coll_count_self = overlap_data.coll_count_self;
 
 			verts = cloth->verts;
 			mvert_num = cloth->mvert_num;
 
 			if (cloth->bvhselftree) {
-				if (coll_count_self && overlap_self) {
+				if (coll_count_self && overlap_data.overlap_self) {
 					collisions = (CollPair *)MEM_mallocN(sizeof(CollPair) * coll_count_self, "collision array");
 
-					if (cloth_bvh_selfcollisions_nearcheck(clmd, collisions, coll_count_self, overlap_self)) {
-						ret += cloth_bvh_selfcollisions_resolve(clmd, collisions,  coll_count_self, dt);
+					if (cloth_bvh_selfcollisions_nearcheck(clmd, collisions, coll_count_self, overlap_data.overlap_self)) {
+						uint offsets[2] = {0, coll_count_self};
+						ColResponseData data = {
+							.clmd = clmd,
+							.collisions = &collisions,
+							.offsets = offsets,
+							.totcoll = 1,
+						};
+
+						ret += cloth_collisions_resolve(&data, dt);
 						ret2 += ret;
 					}
 				}
@@ -1322,8 +1473,9 @@ int cloth_bvh_collision(Depsgraph *depsgraph, Object *ob, ClothModifierData *clm
 	}
 
 	MEM_SAFE_FREE(coll_counts_obj);
+	MEM_SAFE_FREE(collmds);
 
-	MEM_SAFE_FREE(overlap_self);
+	MEM_SAFE_FREE(overlap_data.overlap_self);
 
 	BKE_collision_objects_free(collobjs);
 
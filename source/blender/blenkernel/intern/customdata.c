@@ -2160,6 +2160,16 @@ void *CustomData_duplicate_referenced_layer_named(CustomData *data, const int ty
 	return customData_duplicate_referenced_layer_index(data, layer_index, totelem);
 }
 
+/**
+ * Duplicate all the layers with flag NOFREE, and remove the flag from duplicated layers.
+ */
+void CustomData_duplicate_referenced_layers(CustomData *data, const int totelem)
+{
+	for (int i = 0; i < data->totlayer; i++) {
+		customData_duplicate_referenced_layer_index(data, i, totelem);
+	}
+}
+
 bool CustomData_is_referenced_layer(struct CustomData *data, int type)
 {
 	CustomDataLayer *layer;
@@ -54,6 +54,7 @@
 #include "BLI_rand.h"
 #include "BLI_utildefines.h"
 #include "BLI_ghash.h"
+#include "BLI_task.h"
 
 #include "PIL_time.h"
 
@@ -992,6 +993,51 @@ static void do_physical_effector(EffectorCache *eff, EffectorData *efd, Effected
 	}
 }
 
+/* Evaluate a single effector for a point, accumulating into force and impulse. */
+static void effector_apply_point(
+        EffectorCache *eff, ListBase *colliders, EffectorWeights *weights,
+        EffectedPoint *point, float *force, float *impulse)
+{
+	EffectorData efd;
+	int p = 0, tot = 1, step = 1;
+
+	/* object effectors were fully checked to be OK to evaluate! */
+
+	get_effector_tot(eff, &efd, point, &tot, &p, &step);
+
+	for (; p < tot; p += step) {
+		if (get_effector_data(eff, &efd, point, 0)) {
+			efd.falloff = effector_falloff(eff, &efd, point, weights);
+
+			if (efd.falloff > 0.0f) {
+				efd.falloff *= eff_calc_visibility(colliders, eff, &efd, point);
+			}
+			if (efd.falloff <= 0.0f) {
+				/* don't do anything */
+			}
+			else if (eff->pd->forcefield == PFIELD_TEXTURE) {
+				do_texture_effector(eff, &efd, point, force);
+			}
+			else {
+				float temp1[3] = {0, 0, 0}, temp2[3];
+				copy_v3_v3(temp1, force);
+
+				do_physical_effector(eff, &efd, point, force);
+
+				/* for softbody backward compatibility */
+				if (point->flag & PE_WIND_AS_SPEED && impulse) {
+					sub_v3_v3v3(temp2, force, temp1);
+					sub_v3_v3v3(impulse, impulse, temp2);
+				}
+			}
+		}
+		else if (eff->flag & PE_VELOCITY_TO_IMPULSE && impulse) {
+			/* special case for harmonic effector */
+			add_v3_v3v3(impulse, impulse, efd.vel);
+		}
+	}
+}
+
 /*  -------- BKE_effectors_apply() --------
  * generic force/speed system, now used for particles and softbodies
  * scene       = scene where it runs in, for time and stuff
@@ -1021,53 +1067,190 @@ void BKE_effectors_apply(ListBase *effectors, ListBase *colliders, EffectorWeigh
 	 *     (is independent of other effectors)
 	 */
 	EffectorCache *eff;
-	EffectorData efd;
-	int p = 0, tot = 1, step = 1;
 
 	/* Cycle through collected objects, get total of (1/(gravity_strength * dist^gravity_power)) */
 	/* Check for min distance here? (yes would be cool to add that, ton) */
 
 	if (effectors) {
 		for (eff = effectors->first; eff; eff = eff->next) {
-			/* object effectors were fully checked to be OK to evaluate! */
+			effector_apply_point(eff, colliders, weights, point, force, impulse);
+		}
+	}
+}
 
-			get_effector_tot(eff, &efd, point, &tot, &p, &step);
+/*  -------- BKE_effectors_apply_array() -------- */
 
-			for (; p < tot; p += step) {
-				if (get_effector_data(eff, &efd, point, 0)) {
-					efd.falloff = effector_falloff(eff, &efd, point, weights);
+/* Number of points evaluated together, also the granularity of the culling. */
+#define EFFECTOR_BATCH_SIZE 256
 
-					if (efd.falloff > 0.0f) {
-						efd.falloff *= eff_calc_visibility(colliders, eff, &efd, point);
-					}
-					if (efd.falloff <= 0.0f) {
-						/* don't do anything */
-					}
-					else if (eff->pd->forcefield == PFIELD_TEXTURE) {
-						do_texture_effector(eff, &efd, point, force);
-					}
-					else {
-						float temp1[3] = {0, 0, 0}, temp2[3];
-						copy_v3_v3(temp1, force);
+typedef struct EffectorBatchInfo {
+	EffectorCache *eff;
+	/* sphere outside of which the effector has no influence, only when bounded */
+	float center[3];
+	float radius_sq;
+	bool bounded;
+} EffectorBatchInfo;
+
+typedef struct EffectorBatchData {
+	EffectorBatchInfo *info;
+	int totinfo;
+
+	ListBase *colliders;
+	EffectorWeights *weights;
+
+	EffectedPoint *points;
+	int totpoint;
+	float (*forces)[3];
+	float (*impulses)[3];
+} EffectorBatchData;
+
+/* Find a sphere that contains all points the effector can have an influence on,
+ * this is only possible for object effectors with a maximum falloff distance. */
+static bool effector_influence_sphere(EffectorCache *eff, float r_center[3], float *r_radius_sq)
+{
+	PartDeflect *pd = eff->pd;
 
-						do_physical_effector(eff, &efd, point, force);
+	if (eff->psys || (eff->flag & PE_USE_NORMAL_DATA) ||
+	    !ELEM(pd->shape, PFIELD_SHAPE_POINT, PFIELD_SHAPE_PLANE, PFIELD_SHAPE_LINE))
+	{
+		return false;
+	}
 
-						/* for softbody backward compatibility */
-						if (point->flag & PE_WIND_AS_SPEED && impulse) {
-							sub_v3_v3v3(temp2, force, temp1);
-							sub_v3_v3v3(impulse, impulse, temp2);
-						}
-					}
-				}
-				else if (eff->flag & PE_VELOCITY_TO_IMPULSE && impulse) {
-					/* special case for harmonic effector */
-					add_v3_v3v3(impulse, impulse, efd.vel);
-				}
+	copy_v3_v3(r_center, eff->ob->obmat[3]);
+
+	if (pd->falloff == PFIELD_FALL_SPHERE && pd->shape == PFIELD_SHAPE_POINT && (pd->flag & PFIELD_USEMAX)) {
+		/* distance is measured from the object center */
+		*r_radius_sq = SQUARE(pd->maxdist);
+		return true;
+	}
+	else if (pd->falloff == PFIELD_FALL_TUBE && (pd->flag & PFIELD_USEMAX) && (pd->flag & PFIELD_USEMAXR)) {
+		/* both the axial and the radial distance are limited */
+		*r_radius_sq = SQUARE(pd->maxdist) + SQUARE(pd->maxrad);
+		return true;
+	}
+
+	return false;
+}
+
+static float effector_batch_dist_squared_to_bounds(const float co[3], const float min[3], const float max[3])
+{
+	float d[3];
+
+	for (int i = 0; i < 3; i++) {
+		d[i] = (co[i] < min[i]) ? min[i] - co[i] : ((co[i] > max[i]) ? co[i] - max[i] : 0.0f);
+	}
+
+	return len_squared_v3(d);
+}
+
+static void effectors_apply_batch_cb(
+        void *__restrict userdata,
+        const int batch,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	EffectorBatchData *data = userdata;
+	const int start = batch * EFFECTOR_BATCH_SIZE;
+	const int end = min_ii(start + EFFECTOR_BATCH_SIZE, data->totpoint);
+	float min[3], max[3];
+
+	INIT_MINMAX(min, max);
+	for (int i = start; i < end; i++) {
+		minmax_v3v3_v3(min, max, data->points[i].loc);
+	}
+
+	/* Effectors are applied in list order for every point, same as BKE_effectors_apply(). */
+	for (int e = 0; e < data->totinfo; e++) {
+		EffectorBatchInfo *info = &data->info[e];
+
+		if (info->bounded && effector_batch_dist_squared_to_bounds(info->center, min, max) > info->radius_sq) {
+			/* no point of the batch is in range */
+			continue;
+		}
+
+		for (int i = start; i < end; i++) {
+			EffectedPoint *point = &data->points[i];
+
+			if (info->bounded && len_squared_v3v3(point->loc, info->center) > info->radius_sq) {
+				continue;
 			}
+
+			effector_apply_point(
+			        info->eff, data->colliders, data->weights, point,
+			        data->forces[i], data->impulses ? data->impulses[i] : NULL);
 		}
 	}
 }
 
+/* Same as BKE_effectors_apply() for an array of points, forces and impulses are
+ * accumulated per point. Points are evaluated in parallel batches, and effectors
+ * with a limited range are skipped for batches outside of it.
+ * impulses may be NULL. */
+void BKE_effectors_apply_array(
+        ListBase *effectors, ListBase *colliders, EffectorWeights *weights,
+        EffectedPoint *points, int totpoint, float (*forces)[3], float (*impulses)[3])
+{
+	EffectorBatchData data = {NULL};
+	ListBase *colliders_batch = NULL;
+	bool use_threading = true;
+
+	if (effectors == NULL || totpoint == 0) {
+		return;
+	}
+
+	data.info = MEM_mallocN(sizeof(*data.info) * BLI_listbase_count(effectors), __func__);
+
+	for (EffectorCache *eff = effectors->first; eff; eff = eff->next) {
+		EffectorBatchInfo *info = &data.info[data.totinfo];
+
+		if (weights && weights->weight[0] * weights->weight[eff->pd->forcefield] <= 0.0f) {
+			/* falloff is zero everywhere */
+			continue;
+		}
+
+		info->eff = eff;
+		info->bounded = effector_influence_sphere(eff, info->center, &info->radius_sq);
+		data.totinfo++;
+
+		/* the noise random generator is shared by all points */
+		if (eff->pd->f_noise > 0.0f) {
+			use_threading = false;
+		}
+		/* build the colliders once for the whole array instead of per point */
+		if (colliders == NULL && colliders_batch == NULL && (eff->pd->flag & PFIELD_VISIBILITY)) {
+			colliders_batch = BKE_collider_cache_create(eff->depsgraph, NULL, NULL);
+		}
+	}
+
+	if (data.totinfo == 0) {
+		MEM_freeN(data.info);
+		return;
+	}
+
+	data.colliders = colliders ? colliders : colliders_batch;
+	data.weights = weights;
+	data.points = points;
+	data.totpoint = totpoint;
+	data.forces = forces;
+	data.impulses = impulses;
+
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = use_threading && (totpoint > EFFECTOR_BATCH_SIZE);
+	settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+
+	BLI_task_parallel_range(
+	        0, (totpoint + EFFECTOR_BATCH_SIZE - 1) / EFFECTOR_BATCH_SIZE,
+	        &data, effectors_apply_batch_cb, &settings);
+
+	if (colliders_batch) {
+		BKE_collider_cache_free(&colliders_batch);
+	}
+
+	MEM_freeN(data.info);
+}
+
+#undef EFFECTOR_BATCH_SIZE
+
 /* ======== Simulation Debugging ======== */
 
 SimDebugData *_sim_debug_data = NULL;
@@ -3115,6 +3115,126 @@ static int imbuf_alpha_flags_for_image(Image *ima)
 	return flag;
 }
 
+#ifdef WITH_OPENEXR
+/* Multilayer files are opened with only their layout read, so the passes of ima->rr
+ * have no pixels until they are used. Read the pixels of a single pass here.
+ * Returns false when the pass can't be read, its pixels are left unset. */
+static bool image_multilayer_pass_ensure(Image *ima, RenderPass *rpass)
+{
+	RenderResult *rr = ima->rr;
+	RenderLayer *rl;
+	ImBufLoadOptions options = {0};
+	ImBuf *ibuf = NULL;
+	int flag;
+
+	if (rpass->rect) {
+		return true;
+	}
+
+	for (rl = rr->layers.first; rl; rl = rl->next) {
+		if (BLI_findindex(&rl->passes, rpass) != -1) {
+			break;
+		}
+	}
+
+	if (rl) {
+		options.layer = rl->name;
+		options.pass = rpass->name;
+		options.view = rpass->view;
+
+		flag = IB_rect | IB_multilayer;
+		flag |= imbuf_alpha_flags_for_image(ima);
+
+		if (BKE_image_has_packedfile(ima)) {
+			ImagePackedFile *imapf = ima->packedfiles.first;
+
+			if (imapf->packedfile) {
+				ibuf = IMB_ibImageFromMemory_ex(
+				       (unsigned char *)imapf->packedfile->data, imapf->packedfile->size, flag,
+				       ima->colorspace_settings.name, "<packed data>", &options);
+			}
+		}
+		else {
+			ImageUser iuser_t = {NULL};
+			char filepath[FILE_MAX];
+
+			/* the render result is created from the first view */
+			iuser_t.framenr = rr->framenr;
+			BKE_image_user_file_path(&iuser_t, ima, filepath);
+
+			ibuf = IMB_loadiffname_ex(filepath, flag, ima->colorspace_settings.name, &options);
+		}
+	}
+
+	if (ibuf && ibuf->userdata) {
+		const bool predivide = (ima->alpha_mode == IMA_ALPHA_PREMUL);
+		RenderResult *pass_rr = RE_MultilayerConvert(ibuf->userdata, ima->colorspace_settings.name, predivide,
+		                                             ibuf->x, ibuf->y);
+
+		if (pass_rr) {
+			RenderLayer *pass_rl = pass_rr->layers.first;
+			RenderPass *pass_rpass = (pass_rl) ? pass_rl->passes.first : NULL;
+
+			/* the file can have changed on disk since the layout was read */
+			if (pass_rpass && pass_rpass->rect && pass_rpass->channels == rpass->channels &&
+			    pass_rr->rectx == rr->rectx && pass_rr->recty == rr->recty)
+			{
+				rpass->rect = pass_rpass->rect;
+				pass_rpass->rect = NULL;
+			}
+
+			RE_FreeRenderResult(pass_rr);
+		}
+
+		IMB_exr_close(ibuf->userdata);
+		ibuf->userdata = NULL;
+	}
+
+	if (ibuf) {
+		IMB_freeImBuf(ibuf);
+	}
+
+	if (rpass->rect == NULL) {
+		CLOG_ERROR(&LOG, "cannot read pass \"%s\" of layer \"%s\" from image \"%s\"",
+		           rpass->name, rl ? rl->name : "", ima->id.name + 2);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * \return false when a pass can't be read (the file changed or is missing).
+ */
+bool BKE_image_multilayer_load_all_passes(Image *ima)
+{
+	RenderLayer *rl;
+	RenderPass *rpass;
+	bool ok = true;
+
+	BLI_spin_lock(&image_spin);
+
+	if (ima->type == IMA_TYPE_MULTILAYER && ima->rr) {
+		for (rl = ima->rr->layers.first; rl; rl = rl->next) {
+			for (rpass = rl->passes.first; rpass; rpass = rpass->next) {
+				if (!image_multilayer_pass_ensure(ima, rpass)) {
+					ok = false;
+				}
+			}
+		}
+	}
+
+	BLI_spin_unlock(&image_spin);
+
+	return ok;
+}
+#else  /* WITH_OPENEXR */
+bool BKE_image_multilayer_load_all_passes(Image *UNUSED(ima))
+{
+	return true;
+}
+#endif  /* WITH_OPENEXR */
+
 /* the number of files will vary according to the stereo format */
 static int image_num_files(Image *ima)
 {
@@ -3138,6 +3258,7 @@ static ImBuf *load_sequence_single(Image *ima, ImageUser *iuser, int frame, cons
 	char name[FILE_MAX];
 	int flag;
 	ImageUser iuser_t = {0};
+	ImBufLoadOptions options = {IMB_LOAD_LAYOUT_ONLY};
 
 	/* XXX temp stuff? */
 	if (ima->lastframe != frame)
@@ -3158,8 +3279,8 @@ static ImBuf *load_sequence_single(Image *ima, ImageUser *iuser, int frame, cons
 	flag = IB_rect | IB_multilayer;
 	flag |= imbuf_alpha_flags_for_image(ima);
 
-	/* read ibuf */
-	ibuf = IMB_loadiffname(name, flag, ima->colorspace_settings.name);
+	/* read ibuf, the pixels of multilayer passes are read when used */
+	ibuf = IMB_loadiffname_ex(name, flag, ima->colorspace_settings.name, &options);
 
 #if 0
 	if (ibuf) {
@@ -3272,6 +3393,14 @@ static ImBuf *image_load_sequence_multilayer(Image *ima, ImageUser *iuser, int f
 	if (ima->rr) {
 		RenderPass *rpass = BKE_image_multilayer_index(ima->rr, iuser);
 
+#ifdef WITH_OPENEXR
+		/* a pass which can't be read isn't cached as valid (black) pixels */
+		if (rpass && !image_multilayer_pass_ensure(ima, rpass)) {
+			rpass = NULL;
+			ima->ok = 0;
+		}
+#endif
+
 		if (rpass) {
 			// printf("load from pass %s\n", rpass->name);
 			/* since we free  render results, we copy the rect */
@@ -3423,6 +3552,7 @@ static ImBuf *load_image_single(
 {
 	char filepath[FILE_MAX];
 	struct ImBuf *ibuf = NULL;
+	ImBufLoadOptions options = {IMB_LOAD_LAYOUT_ONLY};
 	int flag;
 
 	/* is there a PackedFile with this image ? */
@@ -3434,9 +3564,9 @@ static ImBuf *load_image_single(
 
 		imapf = BLI_findlink(&ima->packedfiles, view_id);
 		if (imapf->packedfile) {
-			ibuf = IMB_ibImageFromMemory(
+			ibuf = IMB_ibImageFromMemory_ex(
 			       (unsigned char *)imapf->packedfile->data, imapf->packedfile->size, flag,
-			       ima->colorspace_settings.name, "<packed data>");
+			       ima->colorspace_settings.name, "<packed data>", &options);
 		}
 	}
 	else {
@@ -3457,8 +3587,8 @@ static ImBuf *load_image_single(
 
 		BKE_image_user_file_path(&iuser_t, ima, filepath);
 
-		/* read ibuf */
-		ibuf = IMB_loadiffname(filepath, flag, ima->colorspace_settings.name);
+		/* read ibuf, the pixels of multilayer passes are read when used */
+		ibuf = IMB_loadiffname_ex(filepath, flag, ima->colorspace_settings.name, &options);
 	}
 
 	if (ibuf) {
@@ -3583,6 +3713,13 @@ static ImBuf *image_get_ibuf_multilayer(Image *ima, ImageUser *iuser)
 	if (ima->rr) {
 		RenderPass *rpass = BKE_image_multilayer_index(ima->rr, iuser);
 
+#ifdef WITH_OPENEXR
+		/* a pass which can't be read isn't cached as valid (black) pixels */
+		if (rpass && !image_multilayer_pass_ensure(ima, rpass)) {
+			rpass = NULL;
+		}
+#endif
+
 		if (rpass) {
 			ibuf = IMB_allocImBuf(ima->rr->rectx, ima->rr->recty, 32, 0);
 
@@ -39,6 +39,8 @@
 #include "BLI_blenlib.h"
 #include "BLI_math_vector.h"
 #include "BLI_string_utils.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
 #include "BLT_translation.h"
@@ -80,6 +82,31 @@ typedef struct WeightsArrayCache {
 	float **defgroup_weights;
 } WeightsArrayCache;
 
+/**
+ * Offsets of a key-block from its relative key, only storing the vertices it moves
+ * (correctives typically move a small part of the mesh).
+ */
+typedef struct KeyBlockDelta {
+	/** Ascending vertex indices. */
+	int *index;
+	float (*delta)[3];
+	int len;
+
+	/* Used to detect when the deltas need to be recalculated. */
+	const void *data;
+	const void *data_ref;
+	int totelem;
+} KeyBlockDelta;
+
+/* Key.runtime */
+typedef struct KeyRuntime {
+	/* Aligned with Key.block. */
+	KeyBlockDelta *deltas;
+	int deltas_len;
+} KeyRuntime;
+
+static void key_runtime_free(Key *key);
+
 
 /** Free (or release) any data used by this shapekey (does not free the key itself). */
 void BKE_key_free(Key *key)
@@ -88,6 +115,8 @@ void BKE_key_free(Key *key)
 
 	BKE_animdata_free((ID *)key, false);
 
+	key_runtime_free(key);
+
 	while ((kb = BLI_pophead(&key->block))) {
 		if (kb->data)
 			MEM_freeN(kb->data);
@@ -99,6 +128,8 @@ void BKE_key_free_nolib(Key *key)
 {
 	KeyBlock *kb;
 
+	key_runtime_free(key);
+
 	while ((kb = BLI_pophead(&key->block))) {
 		if (kb->data)
 			MEM_freeN(kb->data);
@@ -170,6 +201,8 @@ void BKE_key_copy_data(Main *UNUSED(bmain), Key *key_dst, const Key *key_src, co
 {
 	BLI_duplicatelist(&key_dst->block, &key_src->block);
 
+	key_dst->runtime = NULL;
+
 	KeyBlock *kb_dst, *kb_src;
 	for (kb_src = key_src->block.first, kb_dst = key_dst->block.first;
 	     kb_dst;
@@ -200,6 +233,7 @@ Key *BKE_key_copy_nolib(Key *key)
 	keyn = MEM_dupallocN(key);
 
 	keyn->adt = NULL;
+	keyn->runtime = NULL;
 
 	BLI_duplicatelist(&keyn->block, &key->block);
 
@@ -1162,6 +1196,316 @@ static void keyblock_free_per_block_weights(Key *key, float **per_keyblock_weigh
 	MEM_freeN(per_keyblock_weights);
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Threaded Mesh Keys
+ *
+ * Threaded alternatives to #key_evaluate_relative and #do_key for meshes.
+ *
+ * For relative keys, offsets from the relative key are stored sparsely per key-block
+ * (cached in #Key.runtime), keys without influence are skipped,
+ * then the output is accumulated in parallel ranges of vertices.
+ * Each vertex accumulates key-blocks in the same order as #key_evaluate_relative,
+ * so the results match.
+ * \{ */
+
+/* vertices per parallel range, also the threshold to use threading at all */
+#define KEY_SPARSE_RANGE_SIZE 1024
+
+static ThreadMutex key_runtime_mutex = BLI_MUTEX_INITIALIZER;
+
+static void key_block_delta_free(KeyBlockDelta *kbd)
+{
+	MEM_SAFE_FREE(kbd->index);
+	MEM_SAFE_FREE(kbd->delta);
+	kbd->len = 0;
+	kbd->data = NULL;
+	kbd->data_ref = NULL;
+	kbd->totelem = 0;
+}
+
+static void key_runtime_clear(KeyRuntime *runtime)
+{
+	for (int i = 0; i < runtime->deltas_len; i++) {
+		key_block_delta_free(&runtime->deltas[i]);
+	}
+	MEM_SAFE_FREE(runtime->deltas);
+	runtime->deltas_len = 0;
+}
+
+static void key_runtime_free(Key *key)
+{
+	if (key->runtime) {
+		key_runtime_clear(key->runtime);
+		MEM_freeN(key->runtime);
+		key->runtime = NULL;
+	}
+}
+
+static void key_block_delta_calc(KeyBlockDelta *kbd, const KeyBlock *kb, const KeyBlock *refb)
+{
+	const float (*co)[3] = kb->data;
+	const float (*co_ref)[3] = refb->data;
+	const int totelem = kb->totelem;
+	int len = 0;
+
+	key_block_delta_free(kbd);
+
+	for (int i = 0; i < totelem; i++) {
+		if (!equals_v3v3(co[i], co_ref[i])) {
+			len++;
+		}
+	}
+
+	if (len != 0) {
+		kbd->index = MEM_mallocN(sizeof(*kbd->index) * (size_t)len, __func__);
+		kbd->delta = MEM_mallocN(sizeof(*kbd->delta) * (size_t)len, __func__);
+
+		for (int i = 0, j = 0; i < totelem; i++) {
+			if (!equals_v3v3(co[i], co_ref[i])) {
+				kbd->index[j] = i;
+				sub_v3_v3v3(kbd->delta[j], co[i], co_ref[i]);
+				j++;
+			}
+		}
+	}
+
+	kbd->len = len;
+	kbd->data = kb->data;
+	kbd->data_ref = refb->data;
+	kbd->totelem = totelem;
+}
+
+typedef struct KeySparseBlock {
+	const KeyBlockDelta *kbd;
+	const KeyBlock *kb;
+	const KeyBlock *refb;
+	const float *weights;
+	float influence;
+} KeySparseBlock;
+
+typedef struct KeySparseData {
+	KeySparseBlock *blocks;
+	int blocks_len;
+	float (*out)[3];
+	int tot;
+} KeySparseData;
+
+static void key_sparse_delta_calc_cb(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	KeySparseData *data = userdata;
+	KeySparseBlock *block = &data->blocks[i];
+	KeyBlockDelta *kbd = (KeyBlockDelta *)block->kbd;
+
+	if ((kbd->data != block->kb->data) ||
+	    (kbd->data_ref != block->refb->data) ||
+	    (kbd->totelem != block->kb->totelem))
+	{
+		key_block_delta_calc(kbd, block->kb, block->refb);
+	}
+}
+
+/* first delta with a vertex index >= \a index */
+static int key_block_delta_lower_bound(const KeyBlockDelta *kbd, const int index)
+{
+	int lo = 0, hi = kbd->len;
+	while (lo < hi) {
+		const int mid = (lo + hi) / 2;
+		if (kbd->index[mid] < index) {
+			lo = mid + 1;
+		}
+		else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+static void key_sparse_accumulate_cb(
+        void *__restrict userdata,
+        const int range,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	KeySparseData *data = userdata;
+	const int start = range * KEY_SPARSE_RANGE_SIZE;
+	const int end = min_ii(start + KEY_SPARSE_RANGE_SIZE, data->tot);
+	float (*out)[3] = data->out;
+
+	for (int b = 0; b < data->blocks_len; b++) {
+		const KeySparseBlock *block = &data->blocks[b];
+		const KeyBlockDelta *kbd = block->kbd;
+		const int *index = kbd->index;
+		const float (*delta)[3] = (const float (*)[3])kbd->delta;
+		int i = key_block_delta_lower_bound(kbd, start);
+
+		if (block->weights) {
+			for (; (i < kbd->len) && (index[i] < end); i++) {
+				const int v = index[i];
+				madd_v3_v3fl(out[v], delta[i], block->weights[v] * block->influence);
+			}
+		}
+		else {
+			for (; (i < kbd->len) && (index[i] < end); i++) {
+				madd_v3_v3fl(out[index[i]], delta[i], block->influence);
+			}
+		}
+	}
+}
+
+/**
+ * Check the threaded functions can be used, otherwise fall back to
+ * #key_evaluate_relative or #do_key.
+ */
+static bool key_mesh_threaded_poll(Key *key, const int tot)
+{
+	if ((key->from == NULL) || (GS(key->from->name) != ID_ME)) {
+		return false;
+	}
+	/* the active key-block may be read from edit-mode coordinates, see #key_block_get_data */
+	if (((Mesh *)key->from)->edit_btmesh != NULL) {
+		return false;
+	}
+	if ((key->elemsize != sizeof(float[3])) || (key->refkey == NULL) || (key->refkey->totelem != tot)) {
+		return false;
+	}
+	return true;
+}
+
+static void key_mesh_relative_sparse(Key *key, float **per_keyblock_weights, float (*out)[3], const int tot)
+{
+	/* Only evaluated keys keep their deltas, original key-block data may be edited in-place (sculpt).
+	 * Evaluated keys are re-copied when the original changes, so only animated values change between updates. */
+	const bool use_cache = (key->id.tag & LIB_TAG_COPIED_ON_WRITE) != 0;
+	KeyRuntime runtime_temp = {NULL};
+	KeyRuntime *runtime;
+	KeyBlock *kb;
+	int keyblock_index;
+
+	if (use_cache) {
+		/* objects sharing a mesh evaluate the same key from different threads */
+		BLI_mutex_lock(&key_runtime_mutex);
+		if (key->runtime == NULL) {
+			key->runtime = MEM_callocN(sizeof(*key->runtime), __func__);
+		}
+		runtime = key->runtime;
+	}
+	else {
+		runtime = &runtime_temp;
+	}
+
+	if (runtime->deltas_len != key->totkey) {
+		key_runtime_clear(runtime);
+		runtime->deltas = MEM_callocN(sizeof(*runtime->deltas) * (size_t)key->totkey, __func__);
+		runtime->deltas_len = key->totkey;
+	}
+
+	memcpy(out, key->refkey->data, sizeof(*out) * (size_t)tot);
+
+	KeySparseBlock *blocks = MEM_mallocN(sizeof(*blocks) * (size_t)key->totkey, __func__);
+	int blocks_len = 0;
+
+	/* skip key-blocks without influence (same rules as #key_evaluate_relative) */
+	for (kb = key->block.first, keyblock_index = 0; kb; kb = kb->next, keyblock_index++) {
+		if (kb == key->refkey) {
+			continue;
+		}
+		if ((kb->flag & KEYBLOCK_MUTE) || (kb->curval == 0.0f) || (kb->totelem != tot)) {
+			continue;
+		}
+		KeyBlock *refb = BLI_findlink(&key->block, kb->relative);
+		if ((refb == NULL) || (refb->totelem != tot)) {
+			continue;
+		}
+
+		KeySparseBlock *block = &blocks[blocks_len++];
+		block->kbd = &runtime->deltas[keyblock_index];
+		block->kb = kb;
+		block->refb = refb;
+		block->weights = per_keyblock_weights ? per_keyblock_weights[keyblock_index] : NULL;
+		block->influence = kb->curval;
+	}
+
+	if (blocks_len != 0) {
+		KeySparseData data = {
+			.blocks = blocks,
+			.blocks_len = blocks_len,
+			.out = out,
+			.tot = tot,
+		};
+		ParallelRangeSettings settings;
+
+		BLI_parallel_range_settings_defaults(&settings);
+		settings.use_threading = (tot > KEY_SPARSE_RANGE_SIZE);
+		settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+		BLI_task_parallel_range(0, blocks_len, &data, key_sparse_delta_calc_cb, &settings);
+	}
+
+	if (use_cache) {
+		BLI_mutex_unlock(&key_runtime_mutex);
+	}
+
+	if (blocks_len != 0) {
+		KeySparseData data = {
+			.blocks = blocks,
+			.blocks_len = blocks_len,
+			.out = out,
+			.tot = tot,
+		};
+		ParallelRangeSettings settings;
+
+		BLI_parallel_range_settings_defaults(&settings);
+		settings.use_threading = (tot > KEY_SPARSE_RANGE_SIZE);
+		BLI_task_parallel_range(
+		        0, (tot + KEY_SPARSE_RANGE_SIZE - 1) / KEY_SPARSE_RANGE_SIZE,
+		        &data, key_sparse_accumulate_cb, &settings);
+	}
+
+	MEM_freeN(blocks);
+	key_runtime_clear(&runtime_temp);
+}
+
+typedef struct KeyAbsoluteData {
+	Key *key;
+	KeyBlock *actkb;
+	KeyBlock **k;
+	float *t;
+	char *out;
+	int tot;
+} KeyAbsoluteData;
+
+static void key_absolute_range_cb(
+        void *__restrict userdata,
+        const int range,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	KeyAbsoluteData *data = userdata;
+	const int start = range * KEY_SPARSE_RANGE_SIZE;
+	const int end = min_ii(start + KEY_SPARSE_RANGE_SIZE, data->tot);
+
+	do_key(start, end, data->tot, data->out, data->key, data->actkb, data->k, data->t, KEY_MODE_DUMMY);
+}
+
+/**
+ * Absolute keys interpolate each vertex independently,
+ * ranges can be evaluated in parallel as long as no key-block needs resampling to \a tot.
+ */
+static bool key_mesh_absolute_parallel_poll(Key *key, KeyBlock **k, const int tot)
+{
+	if (!key_mesh_threaded_poll(key, tot) || (tot <= KEY_SPARSE_RANGE_SIZE)) {
+		return false;
+	}
+	for (int i = 0; i < 4; i++) {
+		if (k[i]->totelem != tot) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/** \} */
+
 static void do_mesh_key(Object *ob, Key *key, char *out, const int tot)
 {
 	KeyBlock *k[4], *actkb = BKE_keyblock_from_object(ob);
@@ -1172,7 +1516,12 @@ static void do_mesh_key(Object *ob, Key *key, char *out, const int tot)
 		WeightsArrayCache cache = {0, NULL};
 		float **per_keyblock_weights;
 		per_keyblock_weights = keyblock_get_per_block_weights(ob, key, &cache);
-		key_evaluate_relative(0, tot, tot, (char *)out, key, actkb, per_keyblock_weights, KEY_MODE_DUMMY);
+		if (key_mesh_threaded_poll(key, tot)) {
+			key_mesh_relative_sparse(key, per_keyblock_weights, (float (*)[3])out, tot);
+		}
+		else {
+			key_evaluate_relative(0, tot, tot, (char *)out, key, actkb, per_keyblock_weights, KEY_MODE_DUMMY);
+		}
 		keyblock_free_per_block_weights(key, per_keyblock_weights, &cache);
 	}
 	else {
@@ -1181,7 +1530,25 @@ static void do_mesh_key(Object *ob, Key *key, char *out, const int tot)
 		flag = setkeys(ctime_scaled, &key->block, k, t, 0);
 
 		if (flag == 0) {
-			do_key(0, tot, tot, (char *)out, key, actkb, k, t, KEY_MODE_DUMMY);
+			if (key_mesh_absolute_parallel_poll(key, k, tot)) {
+				KeyAbsoluteData data = {
+					.key = key,
+					.actkb = actkb,
+					.k = k,
+					.t = t,
+					.out = out,
+					.tot = tot,
+				};
+				ParallelRangeSettings settings;
+
+				BLI_parallel_range_settings_defaults(&settings);
+				BLI_task_parallel_range(
+				        0, (tot + KEY_SPARSE_RANGE_SIZE - 1) / KEY_SPARSE_RANGE_SIZE,
+				        &data, key_absolute_range_cb, &settings);
+			}
+			else {
+				do_key(0, tot, tot, (char *)out, key, actkb, k, t, KEY_MODE_DUMMY);
+			}
 		}
 		else {
 			cp_key(0, tot, tot, (char *)out, key, actkb, k[2], NULL, KEY_MODE_DUMMY);
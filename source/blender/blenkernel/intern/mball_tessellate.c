@@ -45,6 +45,7 @@
 #include "BLI_string_utils.h"
 #include "BLI_utildefines.h"
 #include "BLI_memarena.h"
+#include "BLI_task.h"
 
 #include "BKE_global.h"
 
@@ -73,10 +74,10 @@ typedef struct cube {           /* partitioning cell (cube) */
 	CORNER *corners[8];         /* eight corners */
 } CUBE;
 
-typedef struct cubes {          /* linked list of cubes acting as stack */
-	CUBE cube;                  /* a single cube */
-	struct cubes *next;         /* remaining elements */
-} CUBES;
+typedef struct seeds {          /* cubes to start polygonization from */
+	int cubes[26][3];           /* lattice locations, found for one metaelem */
+	unsigned int totcube;       /* number of found cubes */
+} SEEDS;
 
 typedef struct centerlist {     /* list of cube locations */
 	int i, j, k;                /* cube location */
@@ -120,10 +121,18 @@ typedef struct process {        /* parameters, storage */
 	MetaballBVHNode metaball_bvh; /* The simplest bvh */
 	Box allbb;                   /* Bounding box of all metaelems */
 
-	MetaballBVHNode **bvh_queue; /* Queue used during bvh traversal */
+	MetaballBVHNode **bvh_queue; /* Queues used during bvh traversal, one per thread */
 	unsigned int bvh_queue_size;
 
-	CUBES *cubes;               /* stack of cubes waiting for polygonization */
+	SEEDS *seeds;               /* cubes to start from, per metaelem */
+	CUBE *cubes;                /* cubes waiting for polygonization in the next pass */
+	unsigned int totcube;		/* size of memory allocated for cubes */
+	unsigned int curcube;		/* number of currently added cubes */
+
+	CORNER **pending_corners;   /* corners added in this pass, function value not computed yet */
+	unsigned int totpending_corner;
+	unsigned int curpending_corner;
+
 	CENTERLIST **centers;       /* cube center hash table */
 	CORNER **corners;           /* corner value hash table */
 	EDGELIST **edges;           /* edge and vertex id hash table */
@@ -133,8 +142,10 @@ typedef struct process {        /* parameters, storage */
 	unsigned int curindex;		/* number of currently added indices */
 
 	float (*co)[3], (*no)[3];   /* surface vertices - positions and normals */
+	const CORNER *(*vcorners)[2]; /* corners of the edge each vertex lies on */
 	unsigned int totvertex;		/* memory size */
 	unsigned int curvertex;		/* currently added vertices */
+	unsigned int pendingvertex;	/* first vertex added in this pass, position not computed yet */
 
 	/* memory allocation from common pool */
 	MemArena *pgn_elements;
@@ -144,7 +155,7 @@ typedef struct process {        /* parameters, storage */
 static int vertid(PROCESS *process, const CORNER *c1, const CORNER *c2);
 static void add_cube(PROCESS *process, int i, int j, int k);
 static void make_face(PROCESS *process, int i1, int i2, int i3, int i4);
-static void converge(PROCESS *process, const CORNER *c1, const CORNER *c2, float r_p[3]);
+static void converge(const PROCESS *process, const int thread_id, const CORNER *c1, const CORNER *c2, float r_p[3]);
 
 /* ******************* SIMPLE BVH ********************* */
 
@@ -363,26 +374,27 @@ static float densfunc(const MetaElem *ball, float x, float y, float z)
 
 /**
  * Computes density at given position form all metaballs which contain this point in their box.
- * Traverses BVH using a queue.
+ * Traverses BVH using a queue, \a thread_id selects the queue so threads can evaluate at the same time.
  */
-static float metaball(PROCESS *process, float x, float y, float z)
+static float metaball(const PROCESS *process, const int thread_id, float x, float y, float z)
 {
 	int i;
 	float dens = 0.0f;
 	unsigned int front = 0, back = 0;
-	MetaballBVHNode *node;
+	const MetaballBVHNode *node;
+	MetaballBVHNode **bvh_queue = &process->bvh_queue[(unsigned int)thread_id * process->bvh_queue_size];
 
-	process->bvh_queue[front++] = &process->metaball_bvh;
+	bvh_queue[front++] = (MetaballBVHNode *)&process->metaball_bvh;
 
 	while (front != back) {
-		node = process->bvh_queue[back++];
+		node = bvh_queue[back++];
 
 		for (i = 0; i < 2; i++) {
 			if ((node->bb[i].min[0] <= x) && (node->bb[i].max[0] >= x) &&
 			    (node->bb[i].min[1] <= y) && (node->bb[i].max[1] >= y) &&
 			    (node->bb[i].min[2] <= z) && (node->bb[i].max[2] >= z))
 			{
-				if (node->child[i])	process->bvh_queue[front++] = node->child[i];
+				if (node->child[i])	bvh_queue[front++] = node->child[i];
 				else dens += densfunc(node->bb[i].ml, x, y, z);
 			}
 		}
@@ -398,10 +410,6 @@ static void make_face(PROCESS *process, int i1, int i2, int i3, int i4)
 {
 	int *cur;
 
-#ifdef USE_ACCUM_NORMAL
-	float n[3];
-#endif
-
 	if (UNLIKELY(process->totindex == process->curindex)) {
 		process->totindex += 4096;
 		process->indices = MEM_reallocN(process->indices, sizeof(int[4]) * process->totindex);
@@ -415,23 +423,38 @@ static void make_face(PROCESS *process, int i1, int i2, int i3, int i4)
 	cur[1] = i2;
 	cur[2] = i3;
 	cur[3] = i4;
+}
 
 #ifdef USE_ACCUM_NORMAL
-	if (i4 == i3) {
-		normal_tri_v3(n, process->co[i1], process->co[i2], process->co[i3]);
-		accumulate_vertex_normals_v3(
-		        process->no[i1], process->no[i2], process->no[i3], NULL, n,
-		        process->co[i1], process->co[i2], process->co[i3], NULL);
-	}
-	else {
-		normal_quad_v3(n, process->co[i1], process->co[i2], process->co[i3], process->co[i4]);
-		accumulate_vertex_normals_v3(
-		        process->no[i1], process->no[i2], process->no[i3], process->no[i4], n,
-		        process->co[i1], process->co[i2], process->co[i3], process->co[i4]);
-	}
-#endif
+/**
+ * Accumulates face normals to vertices, vertex positions are only known once polygonization is done.
+ */
+static void accumulate_normals(PROCESS *process)
+{
+	unsigned int a;
+	float n[3];
 
+	for (a = 0; a < process->curindex; a++) {
+		const int i1 = process->indices[a][0];
+		const int i2 = process->indices[a][1];
+		const int i3 = process->indices[a][2];
+		const int i4 = process->indices[a][3];
+
+		if (i4 == i3) {
+			normal_tri_v3(n, process->co[i1], process->co[i2], process->co[i3]);
+			accumulate_vertex_normals_v3(
+			        process->no[i1], process->no[i2], process->no[i3], NULL, n,
+			        process->co[i1], process->co[i2], process->co[i3], NULL);
+		}
+		else {
+			normal_quad_v3(n, process->co[i1], process->co[i2], process->co[i3], process->co[i4]);
+			accumulate_vertex_normals_v3(
+			        process->no[i1], process->no[i2], process->no[i3], process->no[i4], n,
+			        process->co[i1], process->co[i2], process->co[i3], process->co[i4]);
+		}
+	}
 }
+#endif
 
 /* Frees allocated memory */
 static void freepolygonize(PROCESS *process)
@@ -441,6 +464,10 @@ static void freepolygonize(PROCESS *process)
 	if (process->centers) MEM_freeN(process->centers);
 	if (process->mainb) MEM_freeN(process->mainb);
 	if (process->bvh_queue) MEM_freeN(process->bvh_queue);
+	if (process->seeds) MEM_freeN(process->seeds);
+	if (process->cubes) MEM_freeN(process->cubes);
+	if (process->pending_corners) MEM_freeN(process->pending_corners);
+	if (process->vcorners) MEM_freeN(process->vcorners);
 	if (process->pgn_elements) BLI_memarena_free(process->pgn_elements);
 }
 
@@ -546,8 +573,8 @@ static void docube(PROCESS *process, CUBE *cube)
 }
 
 /**
- * return corner with the given lattice location
- * set (and cache) its function value
+ * return corner with the given lattice location,
+ * its function value is computed (and cached) at the start of the next pass, see #polygonize_corners()
  */
 static CORNER *setcorner(PROCESS *process, int i, int j, int k)
 {
@@ -574,7 +601,14 @@ static CORNER *setcorner(PROCESS *process, int i, int j, int k)
 	c->k = k;
 	c->co[2] = ((float)k - 0.5f) * process->size;
 
-	c->value = metaball(process, c->co[0], c->co[1], c->co[2]);
+	c->value = 0.0f;
+
+	if (UNLIKELY(process->totpending_corner == process->curpending_corner)) {
+		process->totpending_corner += 4096;
+		process->pending_corners = MEM_reallocN(
+		        process->pending_corners, sizeof(CORNER *) * process->totpending_corner);
+	}
+	process->pending_corners[process->curpending_corner++] = c;
 
 	c->next = process->corners[index];
 	process->corners[index] = c;
@@ -808,18 +842,20 @@ static int getedge(EDGELIST *table[],
 }
 
 /**
- * Adds a vertex, expands memory if needed.
+ * Adds a vertex lying on the edge between given corners, expands memory if needed.
+ * Its position and normal are computed at the end of the pass, see #polygonize_vertices().
  */
-static void addtovertices(PROCESS *process, const float v[3], const float no[3])
+static void addtovertices(PROCESS *process, const CORNER *c1, const CORNER *c2)
 {
 	if (process->curvertex == process->totvertex) {
 		process->totvertex += 4096;
 		process->co = MEM_reallocN(process->co, process->totvertex * sizeof(float[3]));
 		process->no = MEM_reallocN(process->no, process->totvertex * sizeof(float[3]));
+		process->vcorners = MEM_reallocN(process->vcorners, process->totvertex * sizeof(*process->vcorners));
 	}
 
-	copy_v3_v3(process->co[process->curvertex], v);
-	copy_v3_v3(process->no[process->curvertex], no);
+	process->vcorners[process->curvertex][0] = c1;
+	process->vcorners[process->curvertex][1] = c2;
 
 	process->curvertex++;
 }
@@ -830,38 +866,30 @@ static void addtovertices(PROCESS *process, const float v[3], const float no[3])
  *
  * \note Doesn't do normalization!
  */
-static void vnormal(PROCESS *process, const float point[3], float r_no[3])
+static void vnormal(const PROCESS *process, const int thread_id, const float point[3], float r_no[3])
 {
 	const float delta = process->delta;
-	const float f = metaball(process, point[0], point[1], point[2]);
+	const float f = metaball(process, thread_id, point[0], point[1], point[2]);
 
-	r_no[0] = metaball(process, point[0] + delta, point[1], point[2]) - f;
-	r_no[1] = metaball(process, point[0], point[1] + delta, point[2]) - f;
-	r_no[2] = metaball(process, point[0], point[1], point[2] + delta) - f;
+	r_no[0] = metaball(process, thread_id, point[0] + delta, point[1], point[2]) - f;
+	r_no[1] = metaball(process, thread_id, point[0], point[1] + delta, point[2]) - f;
+	r_no[2] = metaball(process, thread_id, point[0], point[1], point[2] + delta) - f;
 }
 #endif  /* USE_ACCUM_NORMAL */
 
 /**
  * \return the id of vertex between two corners.
  *
- * If it wasn't previously computed, does #converge() and adds vertex to process.
+ * If it wasn't previously added, adds vertex to process, its position is computed later.
+ * Vertex ids only depend on the order cubes are processed in, not on threading.
  */
 static int vertid(PROCESS *process, const CORNER *c1, const CORNER *c2)
 {
-	float v[3], no[3];
 	int vid = getedge(process->edges, c1->i, c1->j, c1->k, c2->i, c2->j, c2->k);
 
-	if (vid != -1) return vid;  /* previously computed */
-
-	converge(process, c1, c2, v);  /* position */
-
-#ifdef USE_ACCUM_NORMAL
-	zero_v3(no);
-#else
-	vnormal(process, v, no);
-#endif
+	if (vid != -1) return vid;  /* previously added */
 
-	addtovertices(process, v, no);            /* save vertex */
+	addtovertices(process, c1, c2);            /* save vertex */
 	vid = (int)process->curvertex - 1;
 	setedge(process, c1->i, c1->j, c1->k, c2->i, c2->j, c2->k, vid);
 
@@ -872,7 +900,7 @@ static int vertid(PROCESS *process, const CORNER *c1, const CORNER *c2)
  * Given two corners, computes approximation of surface intersection point between them.
  * In case of small threshold, do bisection.
  */
-static void converge(PROCESS *process, const CORNER *c1, const CORNER *c2, float r_p[3])
+static void converge(const PROCESS *process, const int thread_id, const CORNER *c1, const CORNER *c2, float r_p[3])
 {
 	float tmp, dens;
 	unsigned int i;
@@ -895,7 +923,7 @@ static void converge(PROCESS *process, const CORNER *c1, const CORNER *c2, float
 
 	for (i = 0; i < process->converge_res; i++) {
 		interp_v3_v3v3(r_p, c1_co, c2_co, 0.5f);
-		dens = metaball(process, r_p[0], r_p[1], r_p[2]);
+		dens = metaball(process, thread_id, r_p[0], r_p[1], r_p[2]);
 
 		if (dens > 0.0f) {
 			c1_value = dens;
@@ -912,27 +940,29 @@ static void converge(PROCESS *process, const CORNER *c1, const CORNER *c2, float
 }
 
 /**
- * Adds cube at given lattice position to cube stack of process.
+ * Adds cube at given lattice position to cubes of the next pass.
  */
 static void add_cube(PROCESS *process, int i, int j, int k)
 {
-	CUBES *ncube;
+	CUBE *ncube;
 	int n;
 
 	/* test if cube has been found before */
 	if (setcenter(process, process->centers, i, j, k) == 0) {
-		/* push cube on stack: */
-		ncube = BLI_memarena_alloc(process->pgn_elements, sizeof(CUBES));
-		ncube->next = process->cubes;
-		process->cubes = ncube;
+		if (UNLIKELY(process->totcube == process->curcube)) {
+			process->totcube += 4096;
+			process->cubes = MEM_reallocN(process->cubes, sizeof(CUBE) * process->totcube);
+		}
+
+		ncube = &process->cubes[process->curcube++];
 
-		ncube->cube.i = i;
-		ncube->cube.j = j;
-		ncube->cube.k = k;
+		ncube->i = i;
+		ncube->j = j;
+		ncube->k = k;
 
 		/* set corners of initial cube: */
 		for (n = 0; n < 8; n++)
-			ncube->cube.corners[n] = setcorner(process, i + MB_BIT(n, 2), j + MB_BIT(n, 1), k + MB_BIT(n, 0));
+			ncube->corners[n] = setcorner(process, i + MB_BIT(n, 2), j + MB_BIT(n, 1), k + MB_BIT(n, 0));
 	}
 }
 
@@ -954,16 +984,35 @@ static void closest_latice(int r[3], const float pos[3], const float size)
 	r[2] = (int)floorf(pos[2] / size + 1.0f);
 }
 
+/**
+ * Function value at given lattice location, without caching.
+ */
+static float lattice_value(const PROCESS *process, const int thread_id, const int it[3])
+{
+	return metaball(process, thread_id,
+	                ((float)it[0] - 0.5f) * process->size,
+	                ((float)it[1] - 0.5f) * process->size,
+	                ((float)it[2] - 0.5f) * process->size);
+}
+
 /**
  * Find at most 26 cubes to start polygonization from.
+ * Only reads the process, so it can run for all metaelems in parallel.
  */
-static void find_first_points(PROCESS *process, const unsigned int em)
+static void find_first_points(
+        void *__restrict userdata,
+        const int em,
+        const ParallelRangeTLS *__restrict tls)
 {
+	const PROCESS *process = userdata;
 	const MetaElem *ml;
+	SEEDS *seeds;
 	int center[3], lbn[3], rtf[3], it[3], dir[3], add[3];
 	float tmp[3], a, b;
 
 	ml = process->mainb[em];
+	seeds = &process->seeds[em];
+	seeds->totcube = 0;
 
 	mid_v3_v3v3(tmp, ml->bb->vec[0], ml->bb->vec[6]);
 	closest_latice(center, tmp, process->size);
@@ -979,20 +1028,20 @@ static void find_first_points(PROCESS *process, const unsigned int em)
 
 				copy_v3_v3_int(it, center);
 
-				b = setcorner(process, it[0], it[1], it[2])->value;
+				b = lattice_value(process, tls->thread_id, it);
 				do {
 					it[0] += dir[0];
 					it[1] += dir[1];
 					it[2] += dir[2];
 					a = b;
-					b = setcorner(process, it[0], it[1], it[2])->value;
+					b = lattice_value(process, tls->thread_id, it);
 
 					if (a * b < 0.0f) {
 						add[0] = it[0] - dir[0];
 						add[1] = it[1] - dir[1];
 						add[2] = it[2] - dir[2];
 						DO_MIN(it, add);
-						add_cube(process, add[0], add[1], add[2]);
+						copy_v3_v3_int(seeds->cubes[seeds->totcube++], add);
 						break;
 					}
 				} while ((it[0] > lbn[0]) && (it[1] > lbn[1]) && (it[2] > lbn[2]) &&
@@ -1002,34 +1051,124 @@ static void find_first_points(PROCESS *process, const unsigned int em)
 	}
 }
 
+static void polygonize_corner_cb(
+        void *__restrict userdata,
+        const int index,
+        const ParallelRangeTLS *__restrict tls)
+{
+	const PROCESS *process = userdata;
+	CORNER *c = process->pending_corners[index];
+
+	c->value = metaball(process, tls->thread_id, c->co[0], c->co[1], c->co[2]);
+}
+
+static void polygonize_vertex_cb(
+        void *__restrict userdata,
+        const int index,
+        const ParallelRangeTLS *__restrict tls)
+{
+	const PROCESS *process = userdata;
+	const unsigned int vid = process->pendingvertex + (unsigned int)index;
+
+	converge(process, tls->thread_id, process->vcorners[vid][0], process->vcorners[vid][1], process->co[vid]);
+
+#ifdef USE_ACCUM_NORMAL
+	zero_v3(process->no[vid]);
+#else
+	vnormal(process, tls->thread_id, process->co[vid], process->no[vid]);
+#endif
+}
+
+/**
+ * Computes function values of the corners added in the last pass.
+ */
+static void polygonize_corners(PROCESS *process)
+{
+	ParallelRangeSettings settings;
+
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.min_iter_per_thread = 256;
+
+	BLI_task_parallel_range(0, (int)process->curpending_corner, process, polygonize_corner_cb, &settings);
+	process->curpending_corner = 0;
+}
+
+/**
+ * Computes positions and normals of the vertices added in this pass.
+ */
+static void polygonize_vertices(PROCESS *process)
+{
+	ParallelRangeSettings settings;
+
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.min_iter_per_thread = 64;
+
+	BLI_task_parallel_range(
+	        0, (int)(process->curvertex - process->pendingvertex), process, polygonize_vertex_cb, &settings);
+	process->pendingvertex = process->curvertex;
+}
+
 /**
  * The main polygonization proc.
  * Allocates memory, makes cubetable,
  * finds starting surface points
- * and processes cubes on the stack until none left.
+ * and processes cubes until none left.
+ *
+ * Cubes are processed in passes, each pass does the cubes found by the previous one.
+ * Hash table lookups and output are done in order on one thread, so the result doesn't
+ * depend on threading, while the field evaluations of a pass (new corners, then the
+ * surface vertices and their normals) are done in parallel.
  */
 static void polygonize(PROCESS *process)
 {
-	CUBE c;
-	unsigned int i;
+	ParallelRangeSettings settings;
+	CUBE *cubes = NULL;
+	unsigned int totcube = 0, curcube;
+	unsigned int i, j;
+	const unsigned int num_threads = (unsigned int)BLI_task_scheduler_num_threads(BLI_task_scheduler_get());
 
 	process->centers = MEM_callocN(HASHSIZE * sizeof(CENTERLIST *), "mbproc->centers");
 	process->corners = MEM_callocN(HASHSIZE * sizeof(CORNER *), "mbproc->corners");
 	process->edges = MEM_callocN(2 * HASHSIZE * sizeof(EDGELIST *), "mbproc->edges");
-	process->bvh_queue = MEM_callocN(sizeof(MetaballBVHNode *) * process->bvh_queue_size, "Metaball BVH Queue");
+	process->bvh_queue = MEM_callocN(sizeof(MetaballBVHNode *) * process->bvh_queue_size * num_threads,
+	                                 "Metaball BVH Queue");
+	process->seeds = MEM_mallocN(sizeof(SEEDS) * process->totelem, "Metaball seeds");
 
 	makecubetable();
 
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.min_iter_per_thread = 4;
+
+	BLI_task_parallel_range(0, (int)process->totelem, process, find_first_points, &settings);
+
 	for (i = 0; i < process->totelem; i++) {
-		find_first_points(process, i);
+		for (j = 0; j < process->seeds[i].totcube; j++) {
+			const int *seed = process->seeds[i].cubes[j];
+			add_cube(process, seed[0], seed[1], seed[2]);
+		}
 	}
 
-	while (process->cubes != NULL) {
-		c = process->cubes->cube;
-		process->cubes = process->cubes->next;
+	while (process->curcube != 0) {
+		/* cubes of this pass, new ones are added to process->cubes for the next pass */
+		SWAP(CUBE *, cubes, process->cubes);
+		SWAP(unsigned int, totcube, process->totcube);
+		curcube = process->curcube;
+		process->curcube = 0;
+
+		polygonize_corners(process);
+
+		for (i = 0; i < curcube; i++) {
+			docube(process, &cubes[i]);
+		}
 
-		docube(process, &c);
+		polygonize_vertices(process);
 	}
+
+	if (cubes) MEM_freeN(cubes);
+
+#ifdef USE_ACCUM_NORMAL
+	accumulate_normals(process);
+#endif
 }
 
 /**
@@ -37,6 +37,7 @@
 #include "BLI_utildefines_stack.h"
 #include "BLI_edgehash.h"
 #include "BLI_ghash.h"
+#include "BLI_kdtree.h"
 
 #include "BKE_customdata.h"
 #include "BKE_library.h"
@@ -683,3 +684,52 @@ Mesh *BKE_mesh_merge_verts(Mesh *mesh, const int *vtargetmap, const int tot_vtar
 
 	return result;
 }
+
+/**
+ * Merge vertices within \a dist of each other, directly on the mesh (without converting to BMesh).
+ *
+ * Vertices are merged into the vertex with the lowest index in range,
+ * matching the "remove_doubles" BMesh operator.
+ *
+ * \param merge_mode: See #BKE_mesh_merge_verts.
+ * \return The input mesh when no vertices are merged,
+ * otherwise a new mesh (the input mesh is freed).
+ */
+Mesh *BKE_mesh_merge_verts_by_distance(Mesh *mesh, const float dist, const int merge_mode)
+{
+	const int totvert = mesh->totvert;
+	const MVert *mvert = mesh->mvert;
+	int *vtargetmap;
+	int tot_vtargetmap = 0;
+
+	if (totvert < 2) {
+		return mesh;
+	}
+
+	vtargetmap = MEM_mallocN(sizeof(*vtargetmap) * (size_t)totvert, __func__);
+
+	{
+		/* the tree is only used for storage, no need to balance it */
+		KDTree *tree = BLI_kdtree_new((unsigned int)totvert);
+		for (int i = 0; i < totvert; i++) {
+			BLI_kdtree_insert(tree, i, mvert[i].co);
+			vtargetmap[i] = -1;
+		}
+		tot_vtargetmap = BLI_kdtree_calc_duplicates_parallel(tree, dist, vtargetmap);
+		BLI_kdtree_free(tree);
+	}
+
+	if (tot_vtargetmap != 0) {
+		/* targets point to themselves, 'BKE_mesh_merge_verts' expects -1 */
+		for (int i = 0; i < totvert; i++) {
+			if (vtargetmap[i] == i) {
+				vtargetmap[i] = -1;
+			}
+		}
+		mesh = BKE_mesh_merge_verts(mesh, vtargetmap, tot_vtargetmap, merge_mode);
+	}
+
+	MEM_freeN(vtargetmap);
+
+	return mesh;
+}
@@ -60,6 +60,17 @@ void BKE_mesh_runtime_reset(Mesh *mesh)
 	memset(&mesh->runtime, 0, sizeof(mesh->runtime));
 }
 
+static int mesh_runtime_copy_id_next(void)
+{
+	static uint32_t copy_id_last = 0;
+	uint32_t copy_id;
+	/* 0 is used for meshes which weren't copied */
+	while ((copy_id = atomic_add_and_fetch_uint32(&copy_id_last, 1)) == 0) {
+		/* pass */
+	}
+	return (int)copy_id;
+}
+
 /* Clear all pointers which we don't want to be shared on copying the datablock.
  * However, keep all the flags which defines what the mesh is (for example, that
  * it's deformed only, or that its custom data layers are out of date.) */
@@ -72,6 +83,7 @@ void BKE_mesh_runtime_reset_on_copy(Mesh *mesh)
 	memset(&runtime->looptris, 0, sizeof(runtime->looptris));
 	runtime->bvh_cache = NULL;
 	runtime->shrinkwrap_data = NULL;
+	runtime->copy_id = mesh_runtime_copy_id_next();
 }
 
 void BKE_mesh_runtime_clear_cache(Mesh *mesh)
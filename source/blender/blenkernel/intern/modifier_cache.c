@@ -0,0 +1,792 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenkernel/intern/modifier_cache.c
+ *  \ingroup bke
+ *
+ * Modifier stack result cache.
+ *
+ * Stores the output of constructive modifiers along with the full key of their inputs,
+ * so re-evaluating the stack can skip modifiers whose inputs did not change
+ * (tweaking a modifier at the end of the stack doesn't re-run the ones before it).
+ *
+ * Meshes are never hashed: the input of a modifier is identified by the id of the cache entry it came from,
+ * the input of the first constructive modifier by the copy-on-write update of the object data
+ * (and the coordinates of the leading deform modifiers).
+ * A modifier whose input isn't identified that way (for example deformed after a constructive modifier)
+ * isn't cached, neither are the modifiers after it.
+ * Modifiers reading other data-blocks (boolean) build their own key, which holds their input meshes.
+ *
+ * The cache is stored in #Object_Runtime so it survives copy-on-write updates of the object,
+ * entries are identified by their position in the stack.
+ * Evaluated meshes reference the data of the cached meshes (no copy is made on lookup),
+ * the memory used by all objects is limited by #UserDef.modifier_cache_limit,
+ * least recently used entries which are not referenced by an evaluated mesh are freed first.
+ */
+
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+#include "DNA_userdef_types.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_listbase.h"
+#include "BLI_math_base.h"
+#include "BLI_threads.h"
+
+#include "BKE_customdata.h"
+#include "BKE_library.h"
+#include "BKE_mesh.h"
+#include "BKE_modifier.h"
+
+#include "RNA_access.h"
+
+#include "atomic_ops.h"
+
+#include "CLG_log.h"
+
+static CLG_LogRef LOG = {"bke.modifier_cache"};
+
+/**
+ * All inputs of a modifier, entries are only used when their key is equal
+ * (a hash alone isn't enough to tell results apart).
+ */
+typedef struct ModifierResultCacheKey {
+	unsigned char *data;
+	size_t data_len;
+	size_t data_len_alloc;
+} ModifierResultCacheKey;
+
+typedef struct ModifierResultCacheEntry {
+	/* Least recently used first, see #g_result_cache. */
+	struct ModifierResultCacheEntry *next, *prev;
+
+	struct ModifierResultCache *cache;
+	/** Position in the modifier stack. */
+	int index;
+	/** Referenced by an evaluated mesh, can't be freed. */
+	bool in_use;
+
+	ModifierResultCacheKey key;
+	/** Identifies #mesh as input of the next modifier. */
+	unsigned int id;
+	struct Mesh *mesh;
+	size_t mem_size;
+} ModifierResultCacheEntry;
+
+typedef struct ModifierResultCache {
+	/** Aligned with #Object.modifiers, NULL for modifiers without a cached result. */
+	ModifierResultCacheEntry **entries;
+	int entries_len;
+
+	/* Input of the first constructive modifier, see #modifier_resultCache_input_base. */
+	unsigned int base_id;
+	int base_copy_id;
+	const struct Mesh *base_mesh;
+	float (*base_cos)[3];
+	int base_cos_len;
+} ModifierResultCache;
+
+/* Protects #g_result_cache and the entries of all caches. */
+static ThreadMutex result_cache_lock = BLI_MUTEX_INITIALIZER;
+
+static struct {
+	/** Entries of all objects, least recently used first. */
+	ListBase lru;
+	size_t mem_in_use;
+	unsigned int hits;
+	unsigned int misses;
+	unsigned int id_last;
+} g_result_cache = {{NULL}};
+
+/* -------------------------------------------------------------------- */
+/** \name Key
+ * \{ */
+
+static void result_cache_key_add(ModifierResultCacheKey *key, const void *data, const size_t data_len)
+{
+	if (key->data_len + data_len > key->data_len_alloc) {
+		key->data_len_alloc = MAX2(key->data_len_alloc * 2, key->data_len + data_len);
+		key->data = MEM_reallocN(key->data, key->data_len_alloc);
+	}
+	memcpy(key->data + key->data_len, data, data_len);
+	key->data_len += data_len;
+}
+
+static void result_cache_key_add_int(ModifierResultCacheKey *key, const int value)
+{
+	result_cache_key_add(key, &value, sizeof(value));
+}
+
+static void result_cache_key_add_string(ModifierResultCacheKey *key, const char *str, const int str_len)
+{
+	result_cache_key_add_int(key, str_len);
+	result_cache_key_add(key, str, (size_t)str_len);
+}
+
+static bool result_cache_key_equals(const ModifierResultCacheKey *key_a, const ModifierResultCacheKey *key_b)
+{
+	return ((key_a->data_len == key_b->data_len) &&
+	        (memcmp(key_a->data, key_b->data, key_a->data_len) == 0));
+}
+
+/**
+ * Add settings through RNA, so runtime pointers stored in the modifier data are ignored.
+ *
+ * \return false when the modifier references data which can't be part of the key
+ * (objects, textures, curve mappings... anything exposed as a pointer or collection).
+ */
+static bool result_cache_key_add_settings(ModifierResultCacheKey *key, Object *ob, ModifierData *md)
+{
+	PointerRNA md_ptr;
+	bool ok = true;
+
+	RNA_pointer_create(&ob->id, &RNA_Modifier, md, &md_ptr);
+
+	RNA_STRUCT_BEGIN (&md_ptr, prop)
+	{
+		const PropertyType type = RNA_property_type(prop);
+		const int len = RNA_property_array_length(&md_ptr, prop);
+
+		switch (type) {
+			case PROP_BOOLEAN:
+			{
+				if (len == 0) {
+					result_cache_key_add_int(key, RNA_property_boolean_get(&md_ptr, prop));
+				}
+				else {
+					bool *values = MEM_mallocN(sizeof(*values) * (size_t)len, __func__);
+					RNA_property_boolean_get_array(&md_ptr, prop, values);
+					result_cache_key_add(key, values, sizeof(*values) * (size_t)len);
+					MEM_freeN(values);
+				}
+				break;
+			}
+			case PROP_INT:
+			{
+				if (len == 0) {
+					result_cache_key_add_int(key, RNA_property_int_get(&md_ptr, prop));
+				}
+				else {
+					int *values = MEM_mallocN(sizeof(*values) * (size_t)len, __func__);
+					RNA_property_int_get_array(&md_ptr, prop, values);
+					result_cache_key_add(key, values, sizeof(*values) * (size_t)len);
+					MEM_freeN(values);
+				}
+				break;
+			}
+			case PROP_FLOAT:
+			{
+				if (len == 0) {
+					const float value = RNA_property_float_get(&md_ptr, prop);
+					result_cache_key_add(key, &value, sizeof(value));
+				}
+				else {
+					float *values = MEM_mallocN(sizeof(*values) * (size_t)len, __func__);
+					RNA_property_float_get_array(&md_ptr, prop, values);
+					result_cache_key_add(key, values, sizeof(*values) * (size_t)len);
+					MEM_freeN(values);
+				}
+				break;
+			}
+			case PROP_ENUM:
+				result_cache_key_add_int(key, RNA_property_enum_get(&md_ptr, prop));
+				break;
+			case PROP_STRING:
+			{
+				char buf[256];
+				int buf_len;
+				char *str = RNA_property_string_get_alloc(&md_ptr, prop, buf, sizeof(buf), &buf_len);
+				result_cache_key_add_string(key, str, buf_len);
+				if (str != buf) {
+					MEM_freeN(str);
+				}
+				break;
+			}
+			case PROP_POINTER:
+			{
+				if (!STREQ(RNA_property_identifier(prop), "rna_type")) {
+					PointerRNA value = RNA_property_pointer_get(&md_ptr, prop);
+					if (value.data != NULL) {
+						ok = false;
+					}
+				}
+				break;
+			}
+			case PROP_COLLECTION:
+				if (RNA_property_collection_length(&md_ptr, prop) != 0) {
+					ok = false;
+				}
+				break;
+		}
+
+		if (ok == false) {
+			break;
+		}
+	}
+	RNA_STRUCT_END;
+
+	return ok;
+}
+
+/**
+ * Object level data read by modifiers.
+ */
+static void result_cache_key_add_object(ModifierResultCacheKey *key, Object *ob)
+{
+	bDeformGroup *dg;
+
+	result_cache_key_add(key, ob->obmat, sizeof(ob->obmat));
+	result_cache_key_add_int(key, ob->totcol);
+	result_cache_key_add_int(key, ob->actdef);
+
+	/* vertex groups are looked up by name */
+	result_cache_key_add_int(key, BLI_listbase_count(&ob->defbase));
+	for (dg = ob->defbase.first; dg; dg = dg->next) {
+		result_cache_key_add_string(key, dg->name, (int)strlen(dg->name));
+	}
+}
+
+/**
+ * The layers of the input mesh depend on the data masks of the whole stack,
+ * their contents are identified by the input id.
+ */
+static void result_cache_key_add_customdata(ModifierResultCacheKey *key, const CustomData *data, const int totelem)
+{
+	result_cache_key_add_int(key, totelem);
+	result_cache_key_add_int(key, data->totlayer);
+	for (int i = 0; i < data->totlayer; i++) {
+		const CustomDataLayer *layer = &data->layers[i];
+		result_cache_key_add_int(key, layer->type);
+		result_cache_key_add_string(key, layer->name, (int)strlen(layer->name));
+	}
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Entries
+ * \{ */
+
+static size_t result_cache_limit(void)
+{
+	return (size_t)max_ii(U.modifier_cache_limit, 0) * 1024 * 1024;
+}
+
+static unsigned int result_cache_id_next(void)
+{
+	unsigned int id;
+	/* 0 is used for unknown inputs */
+	while ((id = atomic_add_and_fetch_uint32(&g_result_cache.id_last, 1)) == 0) {
+		/* pass */
+	}
+	return id;
+}
+
+static size_t result_cache_customdata_size(const CustomData *data, const int totelem)
+{
+	size_t size = 0;
+	for (int i = 0; i < data->totlayer; i++) {
+		size += (size_t)CustomData_sizeof(data->layers[i].type) * (size_t)totelem;
+	}
+	return size;
+}
+
+static size_t result_cache_mesh_size(const Mesh *me)
+{
+	return (sizeof(*me) +
+	        result_cache_customdata_size(&me->vdata, me->totvert) +
+	        result_cache_customdata_size(&me->edata, me->totedge) +
+	        result_cache_customdata_size(&me->fdata, me->totface) +
+	        result_cache_customdata_size(&me->ldata, me->totloop) +
+	        result_cache_customdata_size(&me->pdata, me->totpoly));
+}
+
+static bool result_cache_customdata_is_referenced(const CustomData *data, const CustomData *data_user)
+{
+	for (int i = 0; i < data_user->totlayer; i++) {
+		const CustomDataLayer *layer_user = &data_user->layers[i];
+		if ((layer_user->flag & CD_FLAG_NOFREE) && layer_user->data) {
+			for (int j = 0; j < data->totlayer; j++) {
+				if (data->layers[j].data == layer_user->data) {
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+/**
+ * \return true when \a me_user references layers of \a me.
+ */
+static bool result_cache_mesh_is_referenced(const Mesh *me, const Mesh *me_user)
+{
+	return (result_cache_customdata_is_referenced(&me->vdata, &me_user->vdata) ||
+	        result_cache_customdata_is_referenced(&me->edata, &me_user->edata) ||
+	        result_cache_customdata_is_referenced(&me->fdata, &me_user->fdata) ||
+	        result_cache_customdata_is_referenced(&me->ldata, &me_user->ldata) ||
+	        result_cache_customdata_is_referenced(&me->pdata, &me_user->pdata));
+}
+
+/* Caller must hold #result_cache_lock. */
+static void result_cache_entry_free(ModifierResultCacheEntry *entry)
+{
+	BLI_remlink(&g_result_cache.lru, entry);
+	g_result_cache.mem_in_use -= entry->mem_size;
+	entry->cache->entries[entry->index] = NULL;
+
+	BKE_id_free(NULL, entry->mesh);
+	MEM_freeN(entry->key.data);
+	MEM_freeN(entry);
+}
+
+/* Caller must hold #result_cache_lock. */
+static void result_cache_evict(const size_t mem_limit)
+{
+	ModifierResultCacheEntry *entry = g_result_cache.lru.first;
+
+	while (entry && (g_result_cache.mem_in_use > mem_limit)) {
+		ModifierResultCacheEntry *entry_next = entry->next;
+		if (!entry->in_use) {
+			CLOG_INFO(&LOG, 2, "evict entry %u", entry->id);
+			result_cache_entry_free(entry);
+		}
+		entry = entry_next;
+	}
+}
+
+/* Caller must hold #result_cache_lock. */
+static ModifierResultCache *result_cache_ensure(Object *ob)
+{
+	ModifierResultCache *cache = ob->runtime.modifier_result_cache;
+	const int modifiers_len = BLI_listbase_count(&ob->modifiers);
+
+	if (cache == NULL) {
+		cache = ob->runtime.modifier_result_cache = MEM_callocN(sizeof(*cache), __func__);
+	}
+
+	if (cache->entries_len != modifiers_len) {
+		/* modifiers were added or removed, drop entries past the end */
+		for (int i = modifiers_len; i < cache->entries_len; i++) {
+			if (cache->entries[i]) {
+				result_cache_entry_free(cache->entries[i]);
+			}
+		}
+		cache->entries = MEM_recallocN(cache->entries, sizeof(*cache->entries) * (size_t)modifiers_len);
+		cache->entries_len = modifiers_len;
+	}
+
+	return cache;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Public API
+ * \{ */
+
+/**
+ * Only constructive modifiers which don't depend on time, caches or other data-blocks are cached,
+ * others can't be validated by their settings and input.
+ */
+static bool result_cache_is_supported(Object *ob, ModifierData *md)
+{
+	const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+
+	if (mti->type == eModifierTypeType_OnlyDeform) {
+		return false;
+	}
+	if (mti->flags & eModifierTypeFlag_UsesPointCache) {
+		return false;
+	}
+	if (modifier_dependsOnTime(md)) {
+		return false;
+	}
+	if (ELEM(md->type, eModifierType_Multires, eModifierType_ParticleSystem, eModifierType_DynamicPaint)) {
+		return false;
+	}
+	if (md->mode & eModifierMode_Virtual) {
+		return false;
+	}
+	if (BLI_findindex(&ob->modifiers, md) == -1) {
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Identify the input of the first constructive modifier,
+ * the object data (unchanged until its next copy-on-write update)
+ * deformed by the leading deform modifiers.
+ *
+ * \param vert_cos: Coordinates of the leading deform modifiers, NULL when there are none.
+ * \return The input id, 0 when the result cache isn't used.
+ */
+unsigned int modifier_resultCache_input_base(Object *ob, const float (*vert_cos)[3], const int vert_cos_len)
+{
+	const Mesh *me = ob->data;
+	ModifierResultCache *cache;
+	bool changed;
+
+	if (result_cache_limit() == 0) {
+		return 0;
+	}
+	/* animated mesh data is written to the evaluated copy directly, without a new copy */
+	if ((me->adt != NULL) || (me->runtime.copy_id == 0)) {
+		return 0;
+	}
+
+	BLI_mutex_lock(&result_cache_lock);
+	cache = result_cache_ensure(ob);
+	BLI_mutex_unlock(&result_cache_lock);
+
+	/* base data is only accessed while evaluating the object */
+	changed = ((cache->base_id == 0) ||
+	           (cache->base_mesh != me) ||
+	           (cache->base_copy_id != me->runtime.copy_id) ||
+	           ((vert_cos != NULL) != (cache->base_cos != NULL)));
+
+	if (!changed && vert_cos) {
+		changed = ((cache->base_cos_len != vert_cos_len) ||
+		           (memcmp(cache->base_cos, vert_cos, sizeof(*vert_cos) * (size_t)vert_cos_len) != 0));
+	}
+
+	if (changed) {
+		const size_t base_cos_size = sizeof(*cache->base_cos) * (size_t)cache->base_cos_len;
+		const size_t vert_cos_size = vert_cos ? sizeof(*vert_cos) * (size_t)vert_cos_len : 0;
+
+		MEM_SAFE_FREE(cache->base_cos);
+		cache->base_cos_len = 0;
+		if (vert_cos) {
+			cache->base_cos = MEM_mallocN(vert_cos_size, __func__);
+			memcpy(cache->base_cos, vert_cos, vert_cos_size);
+			cache->base_cos_len = vert_cos_len;
+		}
+		cache->base_mesh = me;
+		cache->base_copy_id = me->runtime.copy_id;
+		cache->base_id = result_cache_id_next();
+
+		BLI_mutex_lock(&result_cache_lock);
+		g_result_cache.mem_in_use -= base_cos_size;
+		g_result_cache.mem_in_use += vert_cos_size;
+		BLI_mutex_unlock(&result_cache_lock);
+	}
+
+	return cache->base_id;
+}
+
+/**
+ * Collect the inputs of a constructive modifier.
+ *
+ * \param input_id: Identifies \a me_input, see #modifier_resultCache_input_base.
+ * \return NULL when the modifier can't be cached, otherwise free with #modifier_resultCache_key_free.
+ */
+ModifierResultCacheKey *modifier_resultCache_key_create(
+        Object *ob, ModifierData *md, const Mesh *me_input, const unsigned int input_id,
+        CustomDataMask mask, int app_flags)
+{
+	ModifierResultCacheKey *key;
+
+	if ((input_id == 0) || !result_cache_is_supported(ob, md)) {
+		return NULL;
+	}
+
+	key = MEM_callocN(sizeof(*key), __func__);
+
+	result_cache_key_add_int(key, md->type);
+	result_cache_key_add_string(key, md->name, (int)strlen(md->name));
+	if (!result_cache_key_add_settings(key, ob, md)) {
+		modifier_resultCache_key_free(key);
+		return NULL;
+	}
+
+	result_cache_key_add(key, &mask, sizeof(mask));
+	result_cache_key_add_int(key, app_flags);
+	result_cache_key_add_object(key, ob);
+
+	result_cache_key_add(key, &input_id, sizeof(input_id));
+	result_cache_key_add_customdata(key, &me_input->vdata, me_input->totvert);
+	result_cache_key_add_customdata(key, &me_input->edata, me_input->totedge);
+	result_cache_key_add_customdata(key, &me_input->fdata, me_input->totface);
+	result_cache_key_add_customdata(key, &me_input->ldata, me_input->totloop);
+	result_cache_key_add_customdata(key, &me_input->pdata, me_input->totpoly);
+
+	return key;
+}
+
+void modifier_resultCache_key_free(ModifierResultCacheKey *key)
+{
+	MEM_SAFE_FREE(key->data);
+	MEM_freeN(key);
+}
+
+/**
+ * Start an empty key for a modifier which adds its inputs itself,
+ * for modifiers that read other data-blocks (and so are never cached by the stack).
+ *
+ * 
+eturn NULL when the modifier can't be cached, otherwise free with #modifier_resultCache_key_free.
+ */
+ModifierResultCacheKey *modifier_resultCache_key_create_ex(Object *ob, ModifierData *md)
+{
+	ModifierResultCacheKey *key;
+
+	if ((result_cache_limit() == 0) ||
+	    (md->mode & eModifierMode_Virtual) ||
+	    (BLI_findindex(&ob->modifiers, md) == -1))
+	{
+		return NULL;
+	}
+
+	key = MEM_callocN(sizeof(*key), __func__);
+
+	result_cache_key_add_int(key, md->type);
+	result_cache_key_add_string(key, md->name, (int)strlen(md->name));
+
+	return key;
+}
+
+void modifier_resultCache_key_add(ModifierResultCacheKey *key, const void *data, const size_t data_len)
+{
+	result_cache_key_add(key, data, data_len);
+}
+
+/**
+ * Add the geometry and all custom-data layers of \a me (tessellation data is ignored).
+ *
+ * \return false when a layer stores pointers which can't be part of the key.
+ */
+bool modifier_resultCache_key_add_mesh(ModifierResultCacheKey *key, const Mesh *me)
+{
+	const CustomData *cdata[4] = {&me->vdata, &me->edata, &me->ldata, &me->pdata};
+	const int totelem[4] = {me->totvert, me->totedge, me->totloop, me->totpoly};
+
+	for (int i = 0; i < 4; i++) {
+		const CustomData *data = cdata[i];
+
+		result_cache_key_add_customdata(key, data, totelem[i]);
+
+		for (int j = 0; j < data->totlayer; j++) {
+			const CustomDataLayer *layer = &data->layers[j];
+
+			if (layer->data == NULL) {
+				continue;
+			}
+
+			if (layer->type == CD_MDEFORMVERT) {
+				/* add the weights, not their pointers */
+				const MDeformVert *dvert = layer->data;
+				for (int k = 0; k < totelem[i]; k++, dvert++) {
+					result_cache_key_add_int(key, dvert->totweight);
+					if (dvert->totweight) {
+						result_cache_key_add(key, dvert->dw, sizeof(*dvert->dw) * (size_t)dvert->totweight);
+					}
+				}
+			}
+			else if (ELEM(layer->type, CD_MDISPS, CD_GRID_PAINT_MASK)) {
+				return false;
+			}
+			else {
+				result_cache_key_add(key, layer->data, (size_t)CustomData_sizeof(layer->type) * (size_t)totelem[i]);
+			}
+		}
+	}
+
+	return true;
+}
+
+/**
+ * \return A copy of the cached result referencing its data, or NULL when there is no entry for this key.
+ * \param r_id: Identifies the result as input of the next modifier.
+ */
+Mesh *modifier_resultCache_lookup(Object *ob, ModifierData *md, const ModifierResultCacheKey *key, unsigned int *r_id)
+{
+	ModifierResultCache *cache = ob->runtime.modifier_result_cache;
+	ModifierResultCacheEntry *entry = NULL;
+	const int index = BLI_findindex(&ob->modifiers, md);
+
+	BLI_mutex_lock(&result_cache_lock);
+	if (cache && (index != -1) && (index < cache->entries_len)) {
+		entry = cache->entries[index];
+		if (entry && result_cache_key_equals(&entry->key, key)) {
+			/* keep the data until the stack is done, see #modifier_resultCache_release */
+			entry->in_use = true;
+			BLI_remlink(&g_result_cache.lru, entry);
+			BLI_addtail(&g_result_cache.lru, entry);
+			g_result_cache.hits++;
+		}
+		else {
+			entry = NULL;
+		}
+	}
+	if (entry == NULL) {
+		g_result_cache.misses++;
+	}
+	BLI_mutex_unlock(&result_cache_lock);
+
+	if (entry == NULL) {
+		CLOG_INFO(&LOG, 2, "miss '%s' on '%s'", md->name, ob->id.name + 2);
+		return NULL;
+	}
+
+	CLOG_INFO(&LOG, 2, "hit '%s' on '%s'", md->name, ob->id.name + 2);
+	*r_id = entry->id;
+	return BKE_mesh_copy_for_eval(entry->mesh, true);
+}
+
+/**
+ * Store the result of a modifier, the cache takes ownership of \a mesh.
+ *
+ * \return The mesh to continue the stack with (a copy referencing the cached data),
+ * or \a mesh itself when it's not cached.
+ * \param r_id: Identifies the result as input of the next modifier, 0 when it's not cached.
+ */
+Mesh *modifier_resultCache_store(
+        Object *ob, ModifierData *md, const ModifierResultCacheKey *key, Mesh *mesh, unsigned int *r_id)
+{
+	ModifierResultCacheEntry *entry;
+	ModifierResultCache *cache;
+	const int index = BLI_findindex(&ob->modifiers, md);
+	const size_t mem_limit = result_cache_limit();
+	/* keys of modifiers adding their own inputs may hold whole meshes */
+	const size_t mem_size = result_cache_mesh_size(mesh) + key->data_len;
+
+	*r_id = 0;
+
+	if ((index == -1) || (mem_size > mem_limit)) {
+		return mesh;
+	}
+
+	/* the cached mesh must own its data, layers of the input (or the object data) may be referenced */
+	CustomData_duplicate_referenced_layers(&mesh->vdata, mesh->totvert);
+	CustomData_duplicate_referenced_layers(&mesh->edata, mesh->totedge);
+	CustomData_duplicate_referenced_layers(&mesh->fdata, mesh->totface);
+	CustomData_duplicate_referenced_layers(&mesh->ldata, mesh->totloop);
+	CustomData_duplicate_referenced_layers(&mesh->pdata, mesh->totpoly);
+	BKE_mesh_update_customdata_pointers(mesh, false);
+
+	entry = MEM_callocN(sizeof(*entry), __func__);
+	entry->key.data = MEM_mallocN(key->data_len, __func__);
+	entry->key.data_len = entry->key.data_len_alloc = key->data_len;
+	memcpy(entry->key.data, key->data, key->data_len);
+	entry->id = result_cache_id_next();
+	entry->mesh = mesh;
+	entry->mem_size = mem_size;
+	entry->in_use = true;
+
+	BLI_mutex_lock(&result_cache_lock);
+	cache = result_cache_ensure(ob);
+	if (cache->entries[index]) {
+		result_cache_entry_free(cache->entries[index]);
+	}
+	entry->cache = cache;
+	entry->index = index;
+	cache->entries[index] = entry;
+	BLI_addtail(&g_result_cache.lru, entry);
+	g_result_cache.mem_in_use += mem_size;
+	result_cache_evict(mem_limit);
+	BLI_mutex_unlock(&result_cache_lock);
+
+	*r_id = entry->id;
+	return BKE_mesh_copy_for_eval(mesh, true);
+}
+
+/**
+ * Entries are kept while an evaluated mesh references their data.
+ *
+ * \param me_eval: The result of the stack, or NULL when the evaluated meshes of the object are freed.
+ */
+void modifier_resultCache_release(Object *ob, const Mesh *me_eval)
+{
+	ModifierResultCache *cache = ob->runtime.modifier_result_cache;
+
+	if (cache == NULL) {
+		return;
+	}
+
+	BLI_mutex_lock(&result_cache_lock);
+	for (int i = 0; i < cache->entries_len; i++) {
+		ModifierResultCacheEntry *entry = cache->entries[i];
+		if (entry) {
+			entry->in_use = (me_eval != NULL) && result_cache_mesh_is_referenced(entry->mesh, me_eval);
+		}
+	}
+	result_cache_evict(result_cache_limit());
+	BLI_mutex_unlock(&result_cache_lock);
+}
+
+void modifier_resultCache_free(Object *ob)
+{
+	ModifierResultCache *cache = ob->runtime.modifier_result_cache;
+
+	if (cache) {
+		BLI_mutex_lock(&result_cache_lock);
+		for (int i = 0; i < cache->entries_len; i++) {
+			if (cache->entries[i]) {
+				result_cache_entry_free(cache->entries[i]);
+			}
+		}
+		g_result_cache.mem_in_use -= sizeof(*cache->base_cos) * (size_t)cache->base_cos_len;
+		BLI_mutex_unlock(&result_cache_lock);
+
+		MEM_SAFE_FREE(cache->entries);
+		MEM_SAFE_FREE(cache->base_cos);
+		MEM_freeN(cache);
+		ob->runtime.modifier_result_cache = NULL;
+	}
+}
+
+/**
+ * Free least recently used entries after #UserDef.modifier_cache_limit changed.
+ */
+void modifier_resultCache_limit_update(void)
+{
+	BLI_mutex_lock(&result_cache_lock);
+	result_cache_evict(result_cache_limit());
+	BLI_mutex_unlock(&result_cache_lock);
+}
+
+/**
+ * Totals for all objects since startup (or the last reset).
+ */
+void modifier_resultCache_stats_get(ModifierResultCacheStats *r_stats)
+{
+	BLI_mutex_lock(&result_cache_lock);
+	r_stats->hits = g_result_cache.hits;
+	r_stats->misses = g_result_cache.misses;
+	r_stats->mem_in_use = g_result_cache.mem_in_use;
+	BLI_mutex_unlock(&result_cache_lock);
+}
+
+void modifier_resultCache_stats_reset(void)
+{
+	BLI_mutex_lock(&result_cache_lock);
+	g_result_cache.hits = 0;
+	g_result_cache.misses = 0;
+	BLI_mutex_unlock(&result_cache_lock);
+}
+
+/** \} */
@@ -487,6 +487,8 @@ void BKE_object_free_derived_caches(Object *ob)
 		MEM_freeN(mesh_deform_eval);
 		ob->runtime.mesh_deform_eval = NULL;
 	}
+	/* the evaluated mesh may have referenced cached modifier results */
+	modifier_resultCache_release(ob, NULL);
 
 	BKE_object_free_curve_cache(ob);
 
@@ -597,6 +599,8 @@ void BKE_object_free(Object *ob)
 
 	BKE_sculptsession_free(ob);
 
+	modifier_resultCache_free(ob);
+
 	BLI_freelistN(&ob->pc_ids);
 
 	BLI_freelistN(&ob->lodlevels);
@@ -3550,6 +3554,7 @@ void BKE_object_runtime_reset_on_copy(Object *object)
 	runtime->curve_cache = NULL;
 	runtime->gpencil_cache = NULL;
 	runtime->cached_bbone_deformation = NULL;
+	runtime->modifier_result_cache = NULL;
 }
 
 /*
@@ -144,6 +144,7 @@ typedef struct Ocean {
 
 	/* two dimensional float array */
 	float *_k;                      /* init w	sim r */
+	float *_omega;                  /* init w	sim r */
 } Ocean;
 
 
@@ -294,7 +295,8 @@ float BKE_ocean_jminus_to_foam(float jminus, float coverage)
 	return foam * foam;
 }
 
-void BKE_ocean_eval_uv(struct Ocean *oc, struct OceanResult *ocr, float u, float v)
+/* BKE_ocean_eval_uv() without locking, the caller holds a read lock */
+static void ocean_eval_uv_nolock(struct Ocean *oc, struct OceanResult *ocr, float u, float v)
 {
 	int i0, i1, j0, j1;
 	float frac_x, frac_z;
@@ -307,8 +309,6 @@ void BKE_ocean_eval_uv(struct Ocean *oc, struct OceanResult *ocr, float u, float
 	if (u < 0) u += 1.0f;
 	if (v < 0) v += 1.0f;
 
-	BLI_rw_mutex_lock(&oc->oceanmutex, THREAD_LOCK_READ);
-
 	uu = u * oc->_M;
 	vv = v * oc->_N;
 
@@ -356,6 +356,28 @@ void BKE_ocean_eval_uv(struct Ocean *oc, struct OceanResult *ocr, float u, float
 		}
 	}
 #undef BILERP
+}
+
+void BKE_ocean_eval_uv(struct Ocean *oc, struct OceanResult *ocr, float u, float v)
+{
+	BLI_rw_mutex_lock(&oc->oceanmutex, THREAD_LOCK_READ);
+
+	ocean_eval_uv_nolock(oc, ocr, u, v);
+
+	BLI_rw_mutex_unlock(&oc->oceanmutex);
+}
+
+/* Same as BKE_ocean_eval_uv() for an array of (u, v) coordinates, the ocean is locked once for all of them.
+ * Meant for callers evaluating many points from several threads, where locking every sample contends. */
+void BKE_ocean_eval_uv_array(struct Ocean *oc, struct OceanResult *r_ocr, const float (*uv)[2], int totpoint)
+{
+	int i;
+
+	BLI_rw_mutex_lock(&oc->oceanmutex, THREAD_LOCK_READ);
+
+	for (i = 0; i < totpoint; i++) {
+		ocean_eval_uv_nolock(oc, &r_ocr[i], uv[i][0], uv[i][1]);
+	}
 
 	BLI_rw_mutex_unlock(&oc->oceanmutex);
 }
@@ -455,10 +477,8 @@ void BKE_ocean_eval_xz_catrom(struct Ocean *oc, struct OceanResult *ocr, float x
 /* note that this doesn't wrap properly for i, j < 0, but its not really meant for that being just a way to get
  * the raw data out to save in some image format.
  */
-void BKE_ocean_eval_ij(struct Ocean *oc, struct OceanResult *ocr, int i, int j)
+static void ocean_eval_ij_nolock(struct Ocean *oc, struct OceanResult *ocr, int i, int j)
 {
-	BLI_rw_mutex_lock(&oc->oceanmutex, THREAD_LOCK_READ);
-
 	i = abs(i) % oc->_M;
 	j = abs(j) % oc->_N;
 
@@ -484,6 +504,13 @@ void BKE_ocean_eval_ij(struct Ocean *oc, struct OceanResult *ocr, int i, int j)
 	if (oc->_do_jacobian) {
 		compute_eigenstuff(ocr, oc->_Jxx[i * oc->_N + j], oc->_Jzz[i * oc->_N + j], oc->_Jxz[i * oc->_N + j]);
 	}
+}
+
+void BKE_ocean_eval_ij(struct Ocean *oc, struct OceanResult *ocr, int i, int j)
+{
+	BLI_rw_mutex_lock(&oc->oceanmutex, THREAD_LOCK_READ);
+
+	ocean_eval_ij_nolock(oc, ocr, i, j);
 
 	BLI_rw_mutex_unlock(&oc->oceanmutex);
 }
@@ -495,7 +522,11 @@ typedef struct OceanSimulateData {
 	float chop_amount;
 } OceanSimulateData;
 
-static void ocean_compute_htilda(
+/* Compute htilda for one row, and from it the input of all enabled transforms.
+ * Every input is htilda times a real factor, possibly rotated by -i, so this is
+ * written out on the real and imaginary parts instead of going through the
+ * complex helpers, which keeps the loop free of temporaries. */
+static void ocean_compute_spectra(
         void *__restrict userdata,
         const int i,
         const ParallelRangeTLS *__restrict UNUSED(tls))
@@ -504,26 +535,76 @@ static void ocean_compute_htilda(
 	const Ocean *o = osd->o;
 	const float scale = osd->scale;
 	const float t = osd->t;
+	const float chop_amount = osd->chop_amount;
+	const float kx = o->_kx[i];
+	const int row = i * (1 + o->_N / 2);
 
 	int j;
 
 	/* note the <= _N/2 here, see the fftw doco about the mechanics of the complex->real fft storage */
 	for (j = 0; j <= o->_N / 2; ++j) {
-		fftw_complex exp_param1;
-		fftw_complex exp_param2;
-		fftw_complex conj_param;
+		const int index = row + j;
+		const double *h0 = o->_h0[i * o->_N + j];
+		const double *h0_minus = o->_h0_minus[i * o->_N + j];
+		const float k = o->_k[index];
+		const float kz = o->_kz[j];
+		const float phase = o->_omega[index] * t;
+		const double cos_phase = cosf(phase);
+		const double sin_phase = sinf(phase);
+
+		/* htilda = h0 * e^(i omega t) + conj(h0_minus) * e^(-i omega t) */
+		const double h_re = (h0[0] * cos_phase - h0[1] * sin_phase) + (h0_minus[0] * cos_phase - h0_minus[1] * sin_phase);
+		const double h_im = (h0[0] * sin_phase + h0[1] * cos_phase) - (h0_minus[0] * sin_phase + h0_minus[1] * cos_phase);
+
+		o->_htilda[index][0] = h_re;
+		o->_htilda[index][1] = h_im;
+
+		o->_fft_in[index][0] = h_re * scale;
+		o->_fft_in[index][1] = h_im * scale;
+
+		if (o->_do_chop) {
+			/* -i * -scale * chop_amount * k / |k| * htilda */
+			const float fx = (k == 0.0f) ? 0.0f : scale * chop_amount * kx / k;
+			const float fz = (k == 0.0f) ? 0.0f : scale * chop_amount * kz / k;
+
+			o->_fft_in_x[index][0] = (float)(-h_im * fx);
+			o->_fft_in_x[index][1] = (float)(h_re * fx);
+			o->_fft_in_z[index][0] = (float)(-h_im * fz);
+			o->_fft_in_z[index][1] = (float)(h_re * fz);
+		}
 
-		init_complex(exp_param1, 0.0, omega(o->_k[i * (1 + o->_N / 2) + j], o->_depth) * t);
-		init_complex(exp_param2, 0.0, -omega(o->_k[i * (1 + o->_N / 2) + j], o->_depth) * t);
-		exp_complex(exp_param1, exp_param1);
-		exp_complex(exp_param2, exp_param2);
-		conj_complex(conj_param, o->_h0_minus[i * o->_N + j]);
+		if (o->_do_jacobian) {
+			/* -chop_amount * k * k / |k| * htilda */
+			const float fxx = (k == 0.0f) ? 0.0f : -chop_amount * kx * kx / k;
+			const float fzz = (k == 0.0f) ? 0.0f : -chop_amount * kz * kz / k;
+			const float fxz = (k == 0.0f) ? 0.0f : -chop_amount * kx * kz / k;
+
+			o->_fft_in_jxx[index][0] = (float)(h_re * fxx);
+			o->_fft_in_jxx[index][1] = (float)(h_im * fxx);
+			o->_fft_in_jzz[index][0] = (float)(h_re * fzz);
+			o->_fft_in_jzz[index][1] = (float)(h_im * fzz);
+			o->_fft_in_jxz[index][0] = (float)(h_re * fxz);
+			o->_fft_in_jxz[index][1] = (float)(h_im * fxz);
+		}
 
-		mul_complex_c(exp_param1, o->_h0[i * o->_N + j], exp_param1);
-		mul_complex_c(exp_param2, conj_param, exp_param2);
+		if (o->_do_normals) {
+			/* -i * k * htilda, the z component uses the row wave number like it always did */
+			const float nkz = o->_kz[i];
 
-		add_comlex_c(o->_htilda[i * (1 + o->_N / 2) + j], exp_param1, exp_param2);
-		mul_complex_f(o->_fft_in[i * (1 + o->_N / 2) + j], o->_htilda[i * (1 + o->_N / 2) + j], scale);
+			o->_fft_in_nx[index][0] = (float)(h_im * kx);
+			o->_fft_in_nx[index][1] = (float)(-h_re * kx);
+			o->_fft_in_nz[index][0] = (float)(h_im * nkz);
+			o->_fft_in_nz[index][1] = (float)(-h_re * nkz);
+		}
+	}
+}
+
+static void ocean_add_identity(double *m, int size)
+{
+	int i;
+
+	for (i = 0; i < size; i++) {
+		m[i] += 1.0;
 	}
 }
 
@@ -539,27 +620,7 @@ static void ocean_compute_displacement_x(TaskPool * __restrict pool, void *UNUSE
 {
 	OceanSimulateData *osd = BLI_task_pool_userdata(pool);
 	const Ocean *o = osd->o;
-	const float scale = osd->scale;
-	const float chop_amount = osd->chop_amount;
-	int i, j;
 
-	for (i = 0; i < o->_M; ++i) {
-		for (j = 0; j <= o->_N / 2; ++j) {
-			fftw_complex mul_param;
-			fftw_complex minus_i;
-
-			init_complex(minus_i, 0.0, -1.0);
-			init_complex(mul_param, -scale, 0);
-			mul_complex_f(mul_param, mul_param, chop_amount);
-			mul_complex_c(mul_param, mul_param, minus_i);
-			mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
-			mul_complex_f(mul_param, mul_param,
-			              ((o->_k[i * (1 + o->_N / 2) + j] == 0.0f) ?
-			               0.0f :
-			               o->_kx[i] / o->_k[i * (1 + o->_N / 2) + j]));
-			init_complex(o->_fft_in_x[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
-		}
-	}
 	fftw_execute(o->_disp_x_plan);
 }
 
@@ -567,27 +628,7 @@ static void ocean_compute_displacement_z(TaskPool * __restrict pool, void *UNUSE
 {
 	OceanSimulateData *osd = BLI_task_pool_userdata(pool);
 	const Ocean *o = osd->o;
-	const float scale = osd->scale;
-	const float chop_amount = osd->chop_amount;
-	int i, j;
 
-	for (i = 0; i < o->_M; ++i) {
-		for (j = 0; j <= o->_N / 2; ++j) {
-			fftw_complex mul_param;
-			fftw_complex minus_i;
-
-			init_complex(minus_i, 0.0, -1.0);
-			init_complex(mul_param, -scale, 0);
-			mul_complex_f(mul_param, mul_param, chop_amount);
-			mul_complex_c(mul_param, mul_param, minus_i);
-			mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
-			mul_complex_f(mul_param, mul_param,
-			              ((o->_k[i * (1 + o->_N / 2) + j] == 0.0f) ?
-			               0.0f :
-			               o->_kz[j] / o->_k[i * (1 + o->_N / 2) + j]));
-			init_complex(o->_fft_in_z[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
-		}
-	}
 	fftw_execute(o->_disp_z_plan);
 }
 
@@ -595,89 +636,25 @@ static void ocean_compute_jacobian_jxx(TaskPool * __restrict pool, void *UNUSED(
 {
 	OceanSimulateData *osd = BLI_task_pool_userdata(pool);
 	const Ocean *o = osd->o;
-	const float chop_amount = osd->chop_amount;
-	int i, j;
 
-	for (i = 0; i < o->_M; ++i) {
-		for (j = 0; j <= o->_N / 2; ++j) {
-			fftw_complex mul_param;
-
-			/* init_complex(mul_param, -scale, 0); */
-			init_complex(mul_param, -1, 0);
-
-			mul_complex_f(mul_param, mul_param, chop_amount);
-			mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
-			mul_complex_f(mul_param, mul_param,
-			              ((o->_k[i * (1 + o->_N / 2) + j] == 0.0f) ?
-			               0.0f :
-			               o->_kx[i] * o->_kx[i] / o->_k[i * (1 + o->_N / 2) + j]));
-			init_complex(o->_fft_in_jxx[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
-		}
-	}
 	fftw_execute(o->_Jxx_plan);
-
-	for (i = 0; i < o->_M; ++i) {
-		for (j = 0; j < o->_N; ++j) {
-			o->_Jxx[i * o->_N + j] += 1.0;
-		}
-	}
+	ocean_add_identity(o->_Jxx, o->_M * o->_N);
 }
 
 static void ocean_compute_jacobian_jzz(TaskPool * __restrict pool, void *UNUSED(taskdata), int UNUSED(threadid))
 {
 	OceanSimulateData *osd = BLI_task_pool_userdata(pool);
 	const Ocean *o = osd->o;
-	const float chop_amount = osd->chop_amount;
-	int i, j;
 
-	for (i = 0; i < o->_M; ++i) {
-		for (j = 0; j <= o->_N / 2; ++j) {
-			fftw_complex mul_param;
-
-			/* init_complex(mul_param, -scale, 0); */
-			init_complex(mul_param, -1, 0);
-
-			mul_complex_f(mul_param, mul_param, chop_amount);
-			mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
-			mul_complex_f(mul_param, mul_param,
-			              ((o->_k[i * (1 + o->_N / 2) + j] == 0.0f) ?
-			               0.0f :
-			               o->_kz[j] * o->_kz[j] / o->_k[i * (1 + o->_N / 2) + j]));
-			init_complex(o->_fft_in_jzz[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
-		}
-	}
 	fftw_execute(o->_Jzz_plan);
-
-	for (i = 0; i < o->_M; ++i) {
-		for (j = 0; j < o->_N; ++j) {
-			o->_Jzz[i * o->_N + j] += 1.0;
-		}
-	}
+	ocean_add_identity(o->_Jzz, o->_M * o->_N);
 }
 
 static void ocean_compute_jacobian_jxz(TaskPool * __restrict pool, void *UNUSED(taskdata), int UNUSED(threadid))
 {
 	OceanSimulateData *osd = BLI_task_pool_userdata(pool);
 	const Ocean *o = osd->o;
-	const float chop_amount = osd->chop_amount;
-	int i, j;
 
-	for (i = 0; i < o->_M; ++i) {
-		for (j = 0; j <= o->_N / 2; ++j) {
-			fftw_complex mul_param;
-
-			/* init_complex(mul_param, -scale, 0); */
-			init_complex(mul_param, -1, 0);
-
-			mul_complex_f(mul_param, mul_param, chop_amount);
-			mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
-			mul_complex_f(mul_param, mul_param,
-			              ((o->_k[i * (1 + o->_N / 2) + j] == 0.0f) ?
-			               0.0f :
-			               o->_kx[i] * o->_kz[j] / o->_k[i * (1 + o->_N / 2) + j]));
-			init_complex(o->_fft_in_jxz[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
-		}
-	}
 	fftw_execute(o->_Jxz_plan);
 }
 
@@ -685,18 +662,7 @@ static void ocean_compute_normal_x(TaskPool * __restrict pool, void *UNUSED(task
 {
 	OceanSimulateData *osd = BLI_task_pool_userdata(pool);
 	const Ocean *o = osd->o;
-	int i, j;
 
-	for (i = 0; i < o->_M; ++i) {
-		for (j = 0; j <= o->_N / 2; ++j) {
-			fftw_complex mul_param;
-
-			init_complex(mul_param, 0.0, -1.0);
-			mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
-			mul_complex_f(mul_param, mul_param, o->_kx[i]);
-			init_complex(o->_fft_in_nx[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
-		}
-	}
 	fftw_execute(o->_N_x_plan);
 }
 
@@ -704,18 +670,7 @@ static void ocean_compute_normal_z(TaskPool * __restrict pool, void *UNUSED(task
 {
 	OceanSimulateData *osd = BLI_task_pool_userdata(pool);
 	const Ocean *o = osd->o;
-	int i, j;
 
-	for (i = 0; i < o->_M; ++i) {
-		for (j = 0; j <= o->_N / 2; ++j) {
-			fftw_complex mul_param;
-
-			init_complex(mul_param, 0.0, -1.0);
-			mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
-			mul_complex_f(mul_param, mul_param, o->_kz[i]);
-			init_complex(o->_fft_in_nz[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
-		}
-	}
 	fftw_execute(o->_N_z_plan);
 }
 
@@ -737,17 +692,16 @@ void BKE_ocean_simulate(struct Ocean *o, float t, float scale, float chop_amount
 
 	BLI_rw_mutex_lock(&o->oceanmutex, THREAD_LOCK_WRITE);
 
-	/* Note about multi-threading here: we have to run a first set of computations (htilda one) before we can run
-	 * all others, since they all depend on it.
-	 * So we make a first parallelized forloop run for htilda, and then pack all other computations into
-	 * a set of parallel tasks.
-	 * This is not optimal in all cases, but remains reasonably simple and should be OK most of the time. */
+	/* Note about multi-threading here: all transform inputs depend on htilda only, so they are computed
+	 * together with it in a parallelized forloop over the rows, reading htilda once while it is hot.
+	 * The transforms themselves are independent of each other, each one runs as a parallel task.
+	 * Plans are created once in BKE_ocean_init(), executing them from several threads is safe. */
 
-	/* compute a new htilda */
+	/* compute a new htilda and the spectra of all components */
 	ParallelRangeSettings settings;
 	BLI_parallel_range_settings_defaults(&settings);
 	settings.use_threading = (o->_M > 16);
-	BLI_task_parallel_range(0, o->_M, &osd, ocean_compute_htilda, &settings);
+	BLI_task_parallel_range(0, o->_M, &osd, ocean_compute_spectra, &settings);
 
 	if (o->_do_disp_y) {
 		BLI_task_pool_push(pool, ocean_compute_displacement_y, NULL, false, TASK_PRIORITY_HIGH);
@@ -879,6 +833,7 @@ void BKE_ocean_init(struct Ocean *o, int M, int N, float Lx, float Lz, float V,
 	o->_do_jacobian = do_jacobian;
 
 	o->_k = (float *) MEM_mallocN(M * (1 + N / 2) * sizeof(float), "ocean_k");
+	o->_omega = (float *) MEM_mallocN(M * (1 + N / 2) * sizeof(float), "ocean_omega");
 	o->_h0 = (fftw_complex *) MEM_mallocN(M * N * sizeof(fftw_complex), "ocean_h0");
 	o->_h0_minus = (fftw_complex *) MEM_mallocN(M * N * sizeof(fftw_complex), "ocean_h0_minus");
 	o->_kx = (float *) MEM_mallocN(o->_M * sizeof(float), "ocean_kx");
@@ -907,10 +862,13 @@ void BKE_ocean_init(struct Ocean *o, int M, int N, float Lx, float Lz, float V,
 	for (i = o->_N - 1, ii = 0; i > o->_N / 2; --i, ++ii)
 		o->_kz[i] = -2.0f * (float)M_PI * ii / o->_Lz;
 
-	/* pre-calculate the k matrix */
-	for (i = 0; i < o->_M; ++i)
-		for (j = 0; j <= o->_N / 2; ++j)
+	/* pre-calculate the k matrix, and the angular frequency of each wave which only depends on it */
+	for (i = 0; i < o->_M; ++i) {
+		for (j = 0; j <= o->_N / 2; ++j) {
 			o->_k[i * (1 + o->_N / 2) + j] = sqrt(o->_kx[i] * o->_kx[i] + o->_kz[j] * o->_kz[j]);
+			o->_omega[i * (1 + o->_N / 2) + j] = omega(o->_k[i * (1 + o->_N / 2) + j], o->_depth);
+		}
+	}
 
 	/*srand(seed);*/
 	rng = BLI_rng_new(seed);
@@ -1038,6 +996,7 @@ void BKE_ocean_free_data(struct Ocean *oc)
 	if (oc->_htilda) {
 		MEM_freeN(oc->_htilda);
 		MEM_freeN(oc->_k);
+		MEM_freeN(oc->_omega);
 		MEM_freeN(oc->_h0);
 		MEM_freeN(oc->_h0_minus);
 		MEM_freeN(oc->_kx);
@@ -1249,140 +1208,229 @@ void BKE_ocean_simulate_cache(struct OceanCache *och, int frame)
 }
 
 
-void BKE_ocean_bake(struct Ocean *o, struct OceanCache *och, void (*update_cb)(void *, float progress, int *cancel),
-                    void *update_cb_data)
+typedef struct OceanBakeData {
+	Ocean *o;
+	const OceanCache *och;
+	ImBuf *ibuf_disp;
+	ImBuf *ibuf_foam;
+	ImBuf *ibuf_normal;
+	float *prev_foam;
+	/* zero based frame index */
+	int i;
+} OceanBakeData;
+
+typedef struct OceanBakeWriteData {
+	const OceanCache *och;
+	ImBuf *ibuf;
+	int frame;
+	int type;
+} OceanBakeWriteData;
+
+static void ocean_bake_frame_row(
+        void *__restrict userdata,
+        const int y,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
 {
+	OceanBakeData *obd = userdata;
+	Ocean *o = obd->o;
+	const OceanCache *och = obd->och;
+	const int res_x = och->resolution_x;
+	const int i = obd->i;
+
 	/* note: some of these values remain uninitialized unless certain options
 	 * are enabled, take care that BKE_ocean_eval_ij() initializes a member
 	 * before use - campbell */
 	OceanResult ocr;
 
-	ImageFormatData imf = {0};
+	int x;
 
-	int f, i = 0, x, y, cancel = 0;
-	float progress;
+	for (x = 0; x < res_x; x++) {
 
-	ImBuf *ibuf_foam, *ibuf_disp, *ibuf_normal;
-	float *prev_foam;
-	int res_x = och->resolution_x;
-	int res_y = och->resolution_y;
-	char string[FILE_MAX];
-	//RNG *rng;
+		ocean_eval_ij_nolock(o, &ocr, x, y);
 
-	if (!o) return;
+		/* add to the image */
+		rgb_to_rgba_unit_alpha(&obd->ibuf_disp->rect_float[4 * (res_x * y + x)], ocr.disp);
 
-	if (o->_do_jacobian) prev_foam = MEM_callocN(res_x * res_y * sizeof(float), "previous frame foam bake data");
-	else prev_foam = NULL;
+		if (o->_do_jacobian) {
+			/* TODO, cleanup unused code - campbell */
 
-	//rng = BLI_rng_new(0);
+			float /*r, */ /* UNUSED */ pr = 0.0f, foam_result;
+			float neg_disp, neg_eplus;
+
+			ocr.foam = BKE_ocean_jminus_to_foam(ocr.Jminus, och->foam_coverage);
+
+			/* accumulate previous value for this cell */
+			if (i > 0) {
+				pr = obd->prev_foam[res_x * y + x];
+			}
+
+			/* r = BLI_rng_get_float(rng); */ /* UNUSED */ /* randomly reduce foam */
+
+			/* pr = pr * och->foam_fade; */		/* overall fade */
+
+			/* remember ocean coord sys is Y up!
+			 * break up the foam where height (Y) is low (wave valley), and X and Z displacement is greatest
+			 */
+
+			neg_disp = ocr.disp[1] < 0.0f ? 1.0f + ocr.disp[1] : 1.0f;
+			neg_disp = neg_disp < 0.0f ? 0.0f : neg_disp;
+
+			/* foam, 'ocr.Eplus' only initialized with do_jacobian */
+			neg_eplus = ocr.Eplus[2] < 0.0f ? 1.0f + ocr.Eplus[2] : 1.0f;
+			neg_eplus = neg_eplus < 0.0f ? 0.0f : neg_eplus;
+
+			if (pr < 1.0f)
+				pr *= pr;
+
+			pr *= och->foam_fade * (0.75f + neg_eplus * 0.25f);
+
+			/* A full clamping should not be needed! */
+			foam_result = min_ff(pr + ocr.foam, 1.0f);
+
+			obd->prev_foam[res_x * y + x] = foam_result;
+
+			/*foam_result = min_ff(foam_result, 1.0f); */
+
+			value_to_rgba_unit_alpha(&obd->ibuf_foam->rect_float[4 * (res_x * y + x)], foam_result);
+		}
+
+		if (o->_do_normals) {
+			rgb_to_rgba_unit_alpha(&obd->ibuf_normal->rect_float[4 * (res_x * y + x)], ocr.normal);
+		}
+	}
+}
+
+static void ocean_bake_write_image(TaskPool * __restrict UNUSED(pool), void *taskdata, int UNUSED(threadid))
+{
+	OceanBakeWriteData *obwd = taskdata;
+	const OceanCache *och = obwd->och;
+	ImageFormatData imf = {0};
+	char string[FILE_MAX];
 
 	/* setup image format */
 	imf.imtype = R_IMF_IMTYPE_OPENEXR;
 	imf.depth =  R_IMF_CHAN_DEPTH_16;
 	imf.exr_codec = R_IMF_EXR_CODEC_ZIP;
 
-	for (f = och->start, i = 0; f <= och->end; f++, i++) {
-
-		/* create a new imbuf to store image for this frame */
-		ibuf_foam = IMB_allocImBuf(res_x, res_y, 32, IB_rectfloat);
-		ibuf_disp = IMB_allocImBuf(res_x, res_y, 32, IB_rectfloat);
-		ibuf_normal = IMB_allocImBuf(res_x, res_y, 32, IB_rectfloat);
-
-		BKE_ocean_simulate(o, och->time[i], och->wave_scale, och->chop_amount);
+	cache_filename(string, och->bakepath, och->relbase, obwd->frame, obwd->type);
+	if (0 == BKE_imbuf_write(obwd->ibuf, string, &imf)) {
+		switch (obwd->type) {
+			case CACHE_TYPE_FOAM:
+				printf("Cannot save Foam File Output to %s\n", string);
+				break;
+			case CACHE_TYPE_NORMAL:
+				printf("Cannot save Normal File Output to %s\n", string);
+				break;
+			case CACHE_TYPE_DISPLACE:
+			default:
+				printf("Cannot save Displacement File Output to %s\n", string);
+				break;
+		}
+	}
 
-		/* add new foam */
-		for (y = 0; y < res_y; y++) {
-			for (x = 0; x < res_x; x++) {
+	IMB_freeImBuf(obwd->ibuf);
+}
 
-				BKE_ocean_eval_ij(o, &ocr, x, y);
+static void ocean_bake_write_push(TaskPool *pool, const OceanCache *och, ImBuf *ibuf, int frame, int type)
+{
+	OceanBakeWriteData *obwd = MEM_mallocN(sizeof(*obwd), "ocean bake write data");
 
-				/* add to the image */
-				rgb_to_rgba_unit_alpha(&ibuf_disp->rect_float[4 * (res_x * y + x)], ocr.disp);
+	obwd->och = och;
+	obwd->ibuf = ibuf;
+	obwd->frame = frame;
+	obwd->type = type;
 
-				if (o->_do_jacobian) {
-					/* TODO, cleanup unused code - campbell */
+	BLI_task_pool_push(pool, ocean_bake_write_image, obwd, true, TASK_PRIORITY_LOW);
+}
 
-					float /*r, */ /* UNUSED */ pr = 0.0f, foam_result;
-					float neg_disp, neg_eplus;
+/* Frames are simulated one after the other since the foam accumulates over time, but each
+ * frame's images are filled in parallel rows and compressed and written by background tasks
+ * while the next frame is simulated. At most one frame is being written at any time, which
+ * keeps the memory use at two frames worth of images. */
+void BKE_ocean_bake(struct Ocean *o, struct OceanCache *och, void (*update_cb)(void *, float progress, int *cancel),
+                    void *update_cb_data)
+{
+	TaskScheduler *scheduler = BLI_task_scheduler_get();
+	TaskPool *write_pool;
+	OceanBakeData obd;
 
-					ocr.foam = BKE_ocean_jminus_to_foam(ocr.Jminus, och->foam_coverage);
+	int f, i = 0, cancel = 0;
+	float progress;
 
-					/* accumulate previous value for this cell */
-					if (i > 0) {
-						pr = prev_foam[res_x * y + x];
-					}
+	int res_x = och->resolution_x;
+	int res_y = och->resolution_y;
+	char string[FILE_MAX];
+	//RNG *rng;
 
-					/* r = BLI_rng_get_float(rng); */ /* UNUSED */ /* randomly reduce foam */
+	if (!o) return;
 
-					/* pr = pr * och->foam_fade; */		/* overall fade */
+	obd.o = o;
+	obd.och = och;
 
-					/* remember ocean coord sys is Y up!
-					 * break up the foam where height (Y) is low (wave valley), and X and Z displacement is greatest
-					 */
+	if (o->_do_jacobian) obd.prev_foam = MEM_callocN(res_x * res_y * sizeof(float), "previous frame foam bake data");
+	else obd.prev_foam = NULL;
 
-					neg_disp = ocr.disp[1] < 0.0f ? 1.0f + ocr.disp[1] : 1.0f;
-					neg_disp = neg_disp < 0.0f ? 0.0f : neg_disp;
+	//rng = BLI_rng_new(0);
 
-					/* foam, 'ocr.Eplus' only initialized with do_jacobian */
-					neg_eplus = ocr.Eplus[2] < 0.0f ? 1.0f + ocr.Eplus[2] : 1.0f;
-					neg_eplus = neg_eplus < 0.0f ? 0.0f : neg_eplus;
+	/* the writing tasks all go to the same directory, create it once here */
+	cache_filename(string, och->bakepath, och->relbase, och->start, CACHE_TYPE_DISPLACE);
+	BLI_make_existing_file(string);
 
-					if (pr < 1.0f)
-						pr *= pr;
+	write_pool = BLI_task_pool_create(scheduler, NULL);
 
-					pr *= och->foam_fade * (0.75f + neg_eplus * 0.25f);
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (res_y > 16);
 
-					/* A full clamping should not be needed! */
-					foam_result = min_ff(pr + ocr.foam, 1.0f);
+	for (f = och->start, i = 0; f <= och->end; f++, i++) {
 
-					prev_foam[res_x * y + x] = foam_result;
+		/* create a new imbuf to store image for this frame */
+		obd.ibuf_foam = IMB_allocImBuf(res_x, res_y, 32, IB_rectfloat);
+		obd.ibuf_disp = IMB_allocImBuf(res_x, res_y, 32, IB_rectfloat);
+		obd.ibuf_normal = IMB_allocImBuf(res_x, res_y, 32, IB_rectfloat);
+		obd.i = i;
 
-					/*foam_result = min_ff(foam_result, 1.0f); */
+		BKE_ocean_simulate(o, och->time[i], och->wave_scale, och->chop_amount);
 
-					value_to_rgba_unit_alpha(&ibuf_foam->rect_float[4 * (res_x * y + x)], foam_result);
-				}
+		/* add new foam */
+		BLI_rw_mutex_lock(&o->oceanmutex, THREAD_LOCK_READ);
+		BLI_task_parallel_range(0, res_y, &obd, ocean_bake_frame_row, &settings);
+		BLI_rw_mutex_unlock(&o->oceanmutex);
 
-				if (o->_do_normals) {
-					rgb_to_rgba_unit_alpha(&ibuf_normal->rect_float[4 * (res_x * y + x)], ocr.normal);
-				}
-			}
-		}
+		/* wait for the previous frame to be written */
+		BLI_task_pool_work_and_wait(write_pool);
 
 		/* write the images */
-		cache_filename(string, och->bakepath, och->relbase, f, CACHE_TYPE_DISPLACE);
-		if (0 == BKE_imbuf_write(ibuf_disp, string, &imf))
-			printf("Cannot save Displacement File Output to %s\n", string);
-
-		if (o->_do_jacobian) {
-			cache_filename(string, och->bakepath, och->relbase, f, CACHE_TYPE_FOAM);
-			if (0 == BKE_imbuf_write(ibuf_foam, string, &imf))
-				printf("Cannot save Foam File Output to %s\n", string);
-		}
+		ocean_bake_write_push(write_pool, och, obd.ibuf_disp, f, CACHE_TYPE_DISPLACE);
 
-		if (o->_do_normals) {
-			cache_filename(string, och->bakepath, och->relbase, f, CACHE_TYPE_NORMAL);
-			if (0 == BKE_imbuf_write(ibuf_normal, string, &imf))
-				printf("Cannot save Normal File Output to %s\n", string);
-		}
+		if (o->_do_jacobian)
+			ocean_bake_write_push(write_pool, och, obd.ibuf_foam, f, CACHE_TYPE_FOAM);
+		else
+			IMB_freeImBuf(obd.ibuf_foam);
 
-		IMB_freeImBuf(ibuf_disp);
-		IMB_freeImBuf(ibuf_foam);
-		IMB_freeImBuf(ibuf_normal);
+		if (o->_do_normals)
+			ocean_bake_write_push(write_pool, och, obd.ibuf_normal, f, CACHE_TYPE_NORMAL);
+		else
+			IMB_freeImBuf(obd.ibuf_normal);
 
 		progress = (f - och->start) / (float)och->duration;
 
 		update_cb(update_cb_data, progress, &cancel);
 
 		if (cancel) {
-			if (prev_foam) MEM_freeN(prev_foam);
-			//BLI_rng_free(rng);
-			return;
+			break;
 		}
 	}
 
+	/* finish writing the last frame, also when canceled so no image is left half written */
+	BLI_task_pool_work_and_wait(write_pool);
+	BLI_task_pool_free(write_pool);
+
 	//BLI_rng_free(rng);
-	if (prev_foam) MEM_freeN(prev_foam);
-	och->baked = 1;
+	if (obd.prev_foam) MEM_freeN(obd.prev_foam);
+
+	if (!cancel)
+		och->baked = 1;
 }
 
 #else /* WITH_OCEANSIM */
@@ -1418,6 +1466,12 @@ void BKE_ocean_eval_xz_catrom(struct Ocean *UNUSED(oc), struct OceanResult *UNUS
 {
 }
 
+void BKE_ocean_eval_uv_array(struct Ocean *UNUSED(oc), struct OceanResult *UNUSED(r_ocr), const float (*uv)[2],
+                             int UNUSED(totpoint))
+{
+	UNUSED_VARS(uv);
+}
+
 void BKE_ocean_eval_ij(struct Ocean *UNUSED(oc), struct OceanResult *UNUSED(ocr), int UNUSED(i), int UNUSED(j))
 {
 }
@@ -2057,21 +2057,14 @@ static bool psys_thread_context_init_path(
 		ctx->twistcurve = NULL;
 	}
 
-	return true;
-}
+	psys_child_modifier_tables_init(ctx);
 
-static void psys_task_init_path(ParticleTask *task, ParticleSimulationData *sim)
-{
-	/* init random number generator */
-	int seed = 31415926 + sim->psys->seed;
-
-	task->rng_path = BLI_rng_new(seed);
+	return true;
 }
 
 /* note: this function must be thread safe, except for branching! */
-static void psys_thread_create_path(ParticleTask *task, struct ChildParticle *cpa, ParticleCacheKey *child_keys, int i)
+static void psys_thread_create_path(ParticleThreadContext *ctx, struct ChildParticle *cpa, ParticleCacheKey *child_keys, int i)
 {
-	ParticleThreadContext *ctx = task->ctx;
 	Object *ob = ctx->sim.ob;
 	ParticleSystem *psys = ctx->sim.psys;
 	ParticleSettings *part = psys->part;
@@ -2340,42 +2333,32 @@ static void psys_thread_create_path(ParticleTask *task, struct ChildParticle *cp
 		child_keys->segments = -1;
 }
 
-static void exec_child_path_cache(TaskPool * __restrict UNUSED(pool), void *taskdata, int UNUSED(threadid))
+static void psys_cache_child_path_cb(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
 {
-	ParticleTask *task = taskdata;
-	ParticleThreadContext *ctx = task->ctx;
+	ParticleThreadContext *ctx = userdata;
 	ParticleSystem *psys = ctx->sim.psys;
-	ParticleCacheKey **cache = psys->childcache;
-	ChildParticle *cpa;
-	int i;
 
-	cpa = psys->child + task->begin;
-	for (i = task->begin; i < task->end; ++i, ++cpa) {
-		BLI_assert(i < psys->totchildcache);
-		psys_thread_create_path(task, cpa, cache[i], i);
-	}
+	BLI_assert(i < psys->totchildcache);
+	psys_thread_create_path(ctx, psys->child + i, psys->childcache[i], i);
 }
 
 void psys_cache_child_paths(
         ParticleSimulationData *sim, float cfra,
         const bool editupdate, const bool use_render_params)
 {
-	TaskScheduler *task_scheduler;
-	TaskPool *task_pool;
 	ParticleThreadContext ctx;
-	ParticleTask *tasks_parent, *tasks_child;
-	int numtasks_parent, numtasks_child;
-	int i, totchild, totparent;
+	ParallelRangeSettings settings;
+	int totchild, totparent;
 
 	if (sim->psys->flag & PSYS_GLOBAL_HAIR)
 		return;
 
-	/* create a task pool for child path tasks */
 	if (!psys_thread_context_init_path(&ctx, sim, sim->scene, cfra, editupdate, use_render_params))
 		return;
 
-	task_scheduler = BLI_task_scheduler_get();
-	task_pool = BLI_task_pool_create(task_scheduler, &ctx);
 	totchild = ctx.totchild;
 	totparent = ctx.totparent;
 
@@ -2390,32 +2373,17 @@ void psys_cache_child_paths(
 		sim->psys->totchildcache = totchild;
 	}
 
-	/* cache parent paths */
-	ctx.parent_pass = 1;
-	psys_tasks_create(&ctx, 0, totparent, &tasks_parent, &numtasks_parent);
-	for (i = 0; i < numtasks_parent; ++i) {
-		ParticleTask *task = &tasks_parent[i];
+	BLI_parallel_range_settings_defaults(&settings);
+	/* path cost varies a lot per child (kink, roughness, cut paths) */
+	settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
 
-		psys_task_init_path(task, sim);
-		BLI_task_pool_push(task_pool, exec_child_path_cache, task, false, TASK_PRIORITY_LOW);
-	}
-	BLI_task_pool_work_and_wait(task_pool);
+	/* cache parent paths, children interpolated from virtual parents read them in the second pass */
+	ctx.parent_pass = 1;
+	BLI_task_parallel_range(0, totparent, &ctx, psys_cache_child_path_cb, &settings);
 
 	/* cache child paths */
 	ctx.parent_pass = 0;
-	psys_tasks_create(&ctx, totparent, totchild, &tasks_child, &numtasks_child);
-	for (i = 0; i < numtasks_child; ++i) {
-		ParticleTask *task = &tasks_child[i];
-
-		psys_task_init_path(task, sim);
-		BLI_task_pool_push(task_pool, exec_child_path_cache, task, false, TASK_PRIORITY_LOW);
-	}
-	BLI_task_pool_work_and_wait(task_pool);
-
-	BLI_task_pool_free(task_pool);
-
-	psys_tasks_free(tasks_parent, numtasks_parent);
-	psys_tasks_free(tasks_child, numtasks_child);
+	BLI_task_parallel_range(totparent, totchild, &ctx, psys_cache_child_path_cb, &settings);
 
 	psys_thread_context_free(&ctx);
 }
@@ -29,6 +29,8 @@
  *  \ingroup bke
  */
 
+#include "MEM_guardedalloc.h"
+
 #include "BLI_math.h"
 #include "BLI_noise.h"
 
@@ -80,6 +82,32 @@ typedef struct ParticlePathModifier {
 
 /* ------------------------------------------------------------------------- */
 
+static void clump_noise_offset(const float orco_offset[3], float clump_noise_size, float r_offset[3])
+{
+	float noisevec[3];
+	float da[4], pa[12];
+
+	mul_v3_v3fl(noisevec, orco_offset, 1.0f / clump_noise_size);
+	voronoi(noisevec[0], noisevec[1], noisevec[2], da, pa, 1.0f, 0);
+	mul_v3_v3fl(r_offset, &pa[0], clump_noise_size);
+}
+
+static void child_invariants_init(const ParticleChildModifierContext *modifier_ctx, ParticleChildInvariants *inv)
+{
+	ParticleSystem *psys = modifier_ctx->sim->psys;
+	ParticleSettings *part = psys->part;
+
+	inv->use_clump_noise = ((part->child_flag & PART_CHILD_USE_CLUMP_NOISE) && part->clump_noise_size != 0.0f);
+	if (inv->use_clump_noise) {
+		float orco_offset[3];
+
+		sub_v3_v3v3(orco_offset, modifier_ctx->orco, modifier_ctx->par_orco);
+		clump_noise_offset(orco_offset, part->clump_noise_size, inv->clump_noise_offset);
+	}
+
+	psys_frand_vec(psys, (int)(modifier_ctx->cpa - psys->child) + 27, inv->rough_vec);
+}
+
 static void do_kink_spiral_deform(ParticleKey *state, const float dir[3], const float kink[3],
                                   float time, float freq, float shape, float amplitude,
                                   const float spiral_start[3])
@@ -164,6 +192,7 @@ static void do_kink_spiral(ParticleThreadContext *ctx, ParticleTexture *ptex, co
 	float cut_time;
 	int start_index = 0, end_index = 0;
 	float kink_base[3];
+	ParticleChildInvariants invariants;
 
 	if (ptex) {
 		kink_amp *= ptex->kink_amp;
@@ -209,6 +238,10 @@ static void do_kink_spiral(ParticleThreadContext *ctx, ParticleTexture *ptex, co
 	modifier_ctx.cpa = cpa;
 	modifier_ctx.orco = orco;
 	modifier_ctx.parent_keys = parent_keys;
+	modifier_ctx.par_orco = parent_orco;
+
+	child_invariants_init(&modifier_ctx, &invariants);
+	modifier_ctx.invariants = &invariants;
 
 	for (k = 0, key = keys; k < end_index; k++, key++) {
 		float par_time;
@@ -253,7 +286,6 @@ static void do_kink_spiral(ParticleThreadContext *ctx, ParticleTexture *ptex, co
 		modifier_ctx.par_co = par_co;
 		modifier_ctx.par_vel = par_vel;
 		modifier_ctx.par_rot = par_rot;
-		modifier_ctx.par_orco = parent_orco;
 
 		/* Apply different deformations to the child path/ */
 		do_child_modifiers(&modifier_ctx, hairmat, (ParticleKey *)key, par_time);
@@ -311,12 +343,17 @@ void psys_apply_child_modifiers(ParticleThreadContext *ctx, struct ListBase *mod
 	else {
 		/* Fill in invariant part of modifier context. */
 		ParticleChildModifierContext modifier_ctx = {NULL};
+		ParticleChildInvariants invariants;
 		modifier_ctx.thread_ctx = ctx;
 		modifier_ctx.sim = &ctx->sim;
 		modifier_ctx.ptex = ptex;
 		modifier_ctx.cpa = cpa;
 		modifier_ctx.orco = orco;
 		modifier_ctx.parent_keys = parent_keys;
+		modifier_ctx.par_orco = parent_orco;
+
+		child_invariants_init(&modifier_ctx, &invariants);
+		modifier_ctx.invariants = &invariants;
 
 		totkeys = ctx->segments + 1;
 		max_length = ptex->length;
@@ -331,7 +368,6 @@ void psys_apply_child_modifiers(ParticleThreadContext *ctx, struct ListBase *mod
 			modifier_ctx.par_co = par->co;
 			modifier_ctx.par_vel = par->vel;
 			modifier_ctx.par_rot = iter.parent_rotation;
-			modifier_ctx.par_orco = parent_orco;
 
 			/* Apply different deformations to the child path. */
 			do_child_modifiers(&modifier_ctx, hairmat, (ParticleKey *)key, iter.time);
@@ -540,12 +576,12 @@ void do_kink(ParticleKey *state, const float par_co[3], const float par_vel[3],
 }
 
 static float do_clump_level(float result[3], const float co[3], const float par_co[3], float time,
-                            float clumpfac, float clumppow, float pa_clump, CurveMapping *clumpcurve)
+                            float clumpfac, float clumppow, float pa_clump, const float *clumpcurve_fac)
 {
 	float clump = 0.0f;
 
-	if (clumpcurve) {
-		clump = pa_clump * (1.0f - clamp_f(curvemapping_evaluateF(clumpcurve, 0, time), 0.0f, 1.0f));
+	if (clumpcurve_fac) {
+		clump = pa_clump * (1.0f - *clumpcurve_fac);
 
 		interp_v3_v3v3(result, co, par_co, clump);
 	}
@@ -568,26 +604,34 @@ static float do_clump_level(float result[3], const float co[3], const float par_
 	return clump;
 }
 
-float do_clump(ParticleKey *state, const float par_co[3], float time, const float orco_offset[3], float clumpfac, float clumppow, float pa_clump,
-               bool use_clump_noise, float clump_noise_size, CurveMapping *clumpcurve)
+/* noise_offset is NULL when clump noise is disabled, clumpcurve_fac is NULL without a clump curve */
+static float do_clump_ex(ParticleKey *state, const float par_co[3], float time, const float noise_offset[3],
+                         float clumpfac, float clumppow, float pa_clump, const float *clumpcurve_fac)
 {
-	float clump;
+	if (noise_offset) {
+		float center[3];
 
-	if (use_clump_noise && clump_noise_size != 0.0f) {
-		float center[3], noisevec[3];
-		float da[4], pa[12];
+		add_v3_v3v3(center, par_co, noise_offset);
 
-		mul_v3_v3fl(noisevec, orco_offset, 1.0f / clump_noise_size);
-		voronoi(noisevec[0], noisevec[1], noisevec[2], da, pa, 1.0f, 0);
-		mul_v3_fl(&pa[0], clump_noise_size);
-		add_v3_v3v3(center, par_co, &pa[0]);
-
-		do_clump_level(state->co, state->co, center, time, clumpfac, clumppow, pa_clump, clumpcurve);
+		do_clump_level(state->co, state->co, center, time, clumpfac, clumppow, pa_clump, clumpcurve_fac);
 	}
 
-	clump = do_clump_level(state->co, state->co, par_co, time, clumpfac, clumppow, pa_clump, clumpcurve);
+	return do_clump_level(state->co, state->co, par_co, time, clumpfac, clumppow, pa_clump, clumpcurve_fac);
+}
 
-	return clump;
+float do_clump(ParticleKey *state, const float par_co[3], float time, const float orco_offset[3], float clumpfac, float clumppow, float pa_clump,
+               bool use_clump_noise, float clump_noise_size, CurveMapping *clumpcurve)
+{
+	float noise_offset[3], clumpcurve_fac;
+	const bool use_noise = (use_clump_noise && clump_noise_size != 0.0f);
+
+	if (use_noise)
+		clump_noise_offset(orco_offset, clump_noise_size, noise_offset);
+	if (clumpcurve)
+		clumpcurve_fac = clamp_f(curvemapping_evaluateF(clumpcurve, 0, time), 0.0f, 1.0f);
+
+	return do_clump_ex(state, par_co, time, use_noise ? noise_offset : NULL, clumpfac, clumppow, pa_clump,
+	                   clumpcurve ? &clumpcurve_fac : NULL);
 }
 
 static void do_rough(const float loc[3], float mat[4][4], float t, float fac, float size, float thres, ParticleKey *state)
@@ -627,25 +671,27 @@ static void do_rough_end(const float loc[3], float mat[4][4], float t, float fac
 	madd_v3_v3fl(state->co, mat[1], rough[1]);
 }
 
-static void do_rough_curve(const float loc[3], float mat[4][4], float time, float fac, float size, CurveMapping *roughcurve, ParticleKey *state)
+/* Curve values only depend on the path time, children evaluated through a thread context
+ * look them up in tables built once per cache update when the time is on a path key. */
+static const float *path_key_table_lookup(const float *table, int segments, float time)
 {
-	float rough[3];
-	float rco[3];
+	if (table) {
+		const int k = (int)(time * (float)segments + 0.5f);
 
-	if (!roughcurve)
-		return;
+		if (k >= 0 && k <= segments && (float)k / (float)segments == time)
+			return &table[k];
+	}
+	return NULL;
+}
 
-	fac *= clamp_f(curvemapping_evaluateF(roughcurve, 0, time), 0.0f, 1.0f);
+static float path_curve_evaluate(CurveMapping *curve, const float *table, int segments, float time)
+{
+	const float *value = path_key_table_lookup(table, segments, time);
 
-	copy_v3_v3(rco, loc);
-	mul_v3_fl(rco, time);
-	rough[0] = -1.0f + 2.0f * BLI_gTurbulence(size, rco[0], rco[1], rco[2], 2, 0, 2);
-	rough[1] = -1.0f + 2.0f * BLI_gTurbulence(size, rco[1], rco[2], rco[0], 2, 0, 2);
-	rough[2] = -1.0f + 2.0f * BLI_gTurbulence(size, rco[2], rco[0], rco[1], 2, 0, 2);
+	if (value)
+		return *value;
 
-	madd_v3_v3fl(state->co, mat[0], fac * rough[0]);
-	madd_v3_v3fl(state->co, mat[1], fac * rough[1]);
-	madd_v3_v3fl(state->co, mat[2], fac * rough[2]);
+	return clamp_f(curvemapping_evaluateF(curve, 0, time), 0.0f, 1.0f);
 }
 
 static int twist_num_segments(const ParticleChildModifierContext *modifier_ctx)
@@ -725,9 +771,13 @@ static void do_twist(const ParticleChildModifierContext *modifier_ctx,
 	}
 	if (twist_curve != NULL) {
 		const int num_segments = twist_num_segments(modifier_ctx);
-		angle *= curvemapping_integrate_clamped(twist_curve,
-		                                        0.0f, time,
-		                                        1.0f / num_segments);
+		const float *integral = (thread_ctx != NULL)
+		        ? path_key_table_lookup(thread_ctx->twistcurve_keys, num_segments, time)
+		        : NULL;
+		angle *= (integral != NULL) ? *integral
+		                            : curvemapping_integrate_clamped(twist_curve,
+		                                                             0.0f, time,
+		                                                             1.0f / num_segments);
 	}
 	else {
 		angle *= time;
@@ -781,20 +831,41 @@ void do_child_modifiers(const ParticleChildModifierContext *modifier_ctx,
 		guided = do_guides(sim->depsgraph, sim->psys->part, sim->psys->effectors, (ParticleKey *)state, cpa->parent, t);
 
 	if (guided == 0) {
-		float orco_offset[3];
+		const ParticleChildInvariants *inv = modifier_ctx->invariants;
 		float clump;
 
-		sub_v3_v3v3(orco_offset, modifier_ctx->orco, modifier_ctx->par_orco);
-		clump = do_clump(state,
-		                 modifier_ctx->par_co,
-		                 t,
-		                 orco_offset,
-		                 part->clumpfac,
-		                 part->clumppow,
-		                 ptex ? ptex->clump : 1.0f,
-		                 part->child_flag & PART_CHILD_USE_CLUMP_NOISE,
-		                 part->clump_noise_size,
-		                 clumpcurve);
+		if (inv) {
+			float clumpcurve_fac;
+
+			if (clumpcurve) {
+				clumpcurve_fac = path_curve_evaluate(clumpcurve, ctx ? ctx->clumpcurve_keys : NULL,
+				                                     ctx ? ctx->segments : 0, t);
+			}
+
+			clump = do_clump_ex(state,
+			                    modifier_ctx->par_co,
+			                    t,
+			                    inv->use_clump_noise ? inv->clump_noise_offset : NULL,
+			                    part->clumpfac,
+			                    part->clumppow,
+			                    ptex ? ptex->clump : 1.0f,
+			                    clumpcurve ? &clumpcurve_fac : NULL);
+		}
+		else {
+			float orco_offset[3];
+
+			sub_v3_v3v3(orco_offset, modifier_ctx->orco, modifier_ctx->par_orco);
+			clump = do_clump(state,
+			                 modifier_ctx->par_co,
+			                 t,
+			                 orco_offset,
+			                 part->clumpfac,
+			                 part->clumppow,
+			                 ptex ? ptex->clump : 1.0f,
+			                 part->child_flag & PART_CHILD_USE_CLUMP_NOISE,
+			                 part->clump_noise_size,
+			                 clumpcurve);
+		}
 
 		if (kink_freq != 0.f) {
 			kink_amp *= (1.f - kink_amp_clump * clump);
@@ -816,22 +887,62 @@ void do_child_modifiers(const ParticleChildModifierContext *modifier_ctx,
 	}
 
 	if (roughcurve) {
-		do_rough_curve(modifier_ctx->orco, mat, t, rough1, part->rough1_size, roughcurve, state);
+		const float roughcurve_fac = path_curve_evaluate(roughcurve, ctx ? ctx->roughcurve_keys : NULL,
+		                                                 ctx ? ctx->segments : 0, t);
+
+		do_rough(modifier_ctx->orco, mat, t, rough1 * roughcurve_fac, part->rough1_size, 0.0, state);
 	}
 	else {
 		if (rough1 > 0.f)
 			do_rough(modifier_ctx->orco, mat, t, rough1, part->rough1_size, 0.0, state);
 
-		if (rough2 > 0.f) {
-			float vec[3];
-			psys_frand_vec(sim->psys, i + 27, vec);
-			do_rough(vec, mat, t, rough2, part->rough2_size, part->rough2_thres, state);
-		}
+		if (rough2 > 0.f || rough_end > 0.f) {
+			const float *vec;
+			float rand_vec[3];
 
-		if (rough_end > 0.f) {
-			float vec[3];
-			psys_frand_vec(sim->psys, i + 27, vec);
-			do_rough_end(vec, mat, t, rough_end, part->rough_end_shape, state);
+			if (modifier_ctx->invariants) {
+				vec = modifier_ctx->invariants->rough_vec;
+			}
+			else {
+				psys_frand_vec(sim->psys, i + 27, rand_vec);
+				vec = rand_vec;
+			}
+
+			if (rough2 > 0.f)
+				do_rough(vec, mat, t, rough2, part->rough2_size, part->rough2_thres, state);
+
+			if (rough_end > 0.f)
+				do_rough_end(vec, mat, t, rough_end, part->rough_end_shape, state);
 		}
 	}
 }
+
+static float *path_curve_table(CurveMapping *curve, int segments, bool integrate)
+{
+	float *table = MEM_mallocN(sizeof(float) * (segments + 1), "path curve keys");
+	int k;
+
+	for (k = 0; k <= segments; k++) {
+		const float time = (float)k / (float)segments;
+
+		if (integrate)
+			table[k] = curvemapping_integrate_clamped(curve, 0.0f, time, 1.0f / segments);
+		else
+			table[k] = clamp_f(curvemapping_evaluateF(curve, 0, time), 0.0f, 1.0f);
+	}
+
+	return table;
+}
+
+/* Evaluate the child modifier curves once for all path keys, after the curves have been copied to the context. */
+void psys_child_modifier_tables_init(ParticleThreadContext *ctx)
+{
+	ParticleSettings *part = ctx->sim.psys->part;
+
+	if (ctx->clumpcurve)
+		ctx->clumpcurve_keys = path_curve_table(ctx->clumpcurve, ctx->segments, false);
+	if (ctx->roughcurve)
+		ctx->roughcurve_keys = path_curve_table(ctx->roughcurve, ctx->segments, false);
+	if (ctx->twistcurve && part->childtype == PART_CHILD_PARTICLES && part->twist != 0.0f)
+		ctx->twistcurve_keys = path_curve_table(ctx->twistcurve, ctx->segments, true);
+}
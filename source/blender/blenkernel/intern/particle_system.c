@@ -477,8 +477,6 @@ void psys_tasks_free(ParticleTask *tasks, int numtasks)
 	for (i = 0; i < numtasks; ++i) {
 		if (tasks[i].rng)
 			BLI_rng_free(tasks[i].rng);
-		if (tasks[i].rng_path)
-			BLI_rng_free(tasks[i].rng_path);
 	}
 
 	MEM_freeN(tasks);
@@ -502,6 +500,13 @@ void psys_thread_context_free(ParticleThreadContext *ctx)
 	if (ctx->vg_twist)
 		MEM_freeN(ctx->vg_twist);
 
+	if (ctx->clumpcurve_keys)
+		MEM_freeN(ctx->clumpcurve_keys);
+	if (ctx->roughcurve_keys)
+		MEM_freeN(ctx->roughcurve_keys);
+	if (ctx->twistcurve_keys)
+		MEM_freeN(ctx->twistcurve_keys);
+
 	if (ctx->sim.psys->lattice_deform_data) {
 		end_latt_deform(ctx->sim.psys->lattice_deform_data);
 		ctx->sim.psys->lattice_deform_data = NULL;
@@ -2050,7 +2055,18 @@ typedef struct EfData {
 	ParticleTexture ptex;
 	ParticleSimulationData *sim;
 	ParticleData *pa;
+	/* effectors of the first integration step, evaluated ahead */
+	const float *eff_force, *eff_impulse, *eff_ave;
 } EfData;
+
+/* Effectors evaluated for the initial state of all dynamic particles at once,
+ * indexed through point_index, -1 for particles that are not dynamic. */
+typedef struct ParticleEffectorBatch {
+	int *point_index;
+	float (*force)[3];
+	float (*impulse)[3];
+	float (*ave)[3];
+} ParticleEffectorBatch;
 static void basic_force_cb(void *efdata_v, ParticleKey *state, float *force, float *impulse)
 {
 	EfData *efdata = (EfData *)efdata_v;
@@ -2059,11 +2075,23 @@ static void basic_force_cb(void *efdata_v, ParticleKey *state, float *force, flo
 	ParticleData *pa = efdata->pa;
 	EffectedPoint epoint;
 	RNG *rng = sim->rng;
+	const float *ave;
 
 	/* add effectors */
-	pd_point_from_particle(efdata->sim, efdata->pa, state, &epoint);
-	if (part->type != PART_HAIR || part->effector_weights->flag & EFF_WEIGHT_DO_HAIR)
-		BKE_effectors_apply(sim->psys->effectors, sim->colliders, part->effector_weights, &epoint, force, impulse);
+	if (efdata->eff_force) {
+		add_v3_v3(force, efdata->eff_force);
+		add_v3_v3(impulse, efdata->eff_impulse);
+		ave = efdata->eff_ave;
+
+		/* only valid for the initial state */
+		efdata->eff_force = efdata->eff_impulse = efdata->eff_ave = NULL;
+	}
+	else {
+		pd_point_from_particle(efdata->sim, efdata->pa, state, &epoint);
+		if (part->type != PART_HAIR || part->effector_weights->flag & EFF_WEIGHT_DO_HAIR)
+			BKE_effectors_apply(sim->psys->effectors, sim->colliders, part->effector_weights, &epoint, force, impulse);
+		ave = epoint.ave;
+	}
 
 	mul_v3_fl(force, efdata->ptex.field);
 	mul_v3_fl(impulse, efdata->ptex.field);
@@ -2079,11 +2107,79 @@ static void basic_force_cb(void *efdata_v, ParticleKey *state, float *force, flo
 		force[2] += (BLI_rng_get_float(rng)-0.5f) * part->brownfac;
 	}
 
-	if (part->flag & PART_ROT_DYN && epoint.ave)
-		copy_v3_v3(pa->state.ave, epoint.ave);
+	if (part->flag & PART_ROT_DYN && ave)
+		copy_v3_v3(pa->state.ave, ave);
+}
+
+/* Evaluate the effectors for the current state of all dynamic particles at once,
+ * used by basic_integrate() for the first integration step. Returns false when
+ * effectors have to be evaluated per particle. */
+static bool basic_integrate_effectors_batch(ParticleSimulationData *sim, ParticleEffectorBatch *batch)
+{
+	ParticleSystem *psys = sim->psys;
+	ParticleSettings *part = psys->part;
+	ParticleData *pa;
+	EffectedPoint *points;
+	int p, totpoint = 0;
+
+	if (psys->effectors == NULL) {
+		return false;
+	}
+	if (part->type == PART_HAIR && (part->effector_weights->flag & EFF_WEIGHT_DO_HAIR) == 0) {
+		return false;
+	}
+	for (EffectorCache *eff = psys->effectors->first; eff; eff = eff->next) {
+		/* self effecting particles see the state of particles integrated before them */
+		if (eff->psys == psys) {
+			return false;
+		}
+		/* noise draws from a random generator shared by all points, with more than one integration
+		 * step per particle the batch would draw the first steps of all particles before the others */
+		if (eff->pd && eff->pd->f_noise > 0.0f && ELEM(part->integrator, PART_INT_MIDPOINT, PART_INT_RK4)) {
+			return false;
+		}
+	}
+
+	batch->point_index = MEM_mallocN(sizeof(int) * psys->totpart, "particle effector index");
+	batch->force = MEM_callocN(sizeof(float[3]) * psys->totpart, "particle effector force");
+	batch->impulse = MEM_callocN(sizeof(float[3]) * psys->totpart, "particle effector impulse");
+	batch->ave = (part->flag & PART_ROT_DYN) ? MEM_mallocN(sizeof(float[3]) * psys->totpart, "particle effector ave") : NULL;
+	points = MEM_mallocN(sizeof(EffectedPoint) * psys->totpart, "particle effected points");
+
+	for (p = 0; p < psys->totpart; p++) {
+		batch->point_index[p] = -1;
+	}
+
+	LOOP_DYNAMIC_PARTICLES {
+		pd_point_from_particle(sim, pa, &pa->state, &points[totpoint]);
+
+		if (batch->ave) {
+			/* basic_integrate() starts from the previous angular velocity */
+			copy_v3_v3(batch->ave[totpoint], pa->prev_state.ave);
+			points[totpoint].ave = batch->ave[totpoint];
+		}
+
+		batch->point_index[p] = totpoint++;
+	}
+
+	BKE_effectors_apply_array(psys->effectors, sim->colliders, part->effector_weights, points, totpoint, batch->force, batch->impulse);
+
+	MEM_freeN(points);
+
+	return true;
+}
+
+static void basic_integrate_effectors_batch_free(ParticleEffectorBatch *batch)
+{
+	MEM_freeN(batch->point_index);
+	MEM_freeN(batch->force);
+	MEM_freeN(batch->impulse);
+	if (batch->ave) {
+		MEM_freeN(batch->ave);
+	}
 }
 /* gathers all forces that effect particles and calculates a new state for the particle */
-static void basic_integrate(ParticleSimulationData *sim, int p, float dfra, float cfra)
+static void basic_integrate(ParticleSimulationData *sim, int p, float dfra, float cfra, const ParticleEffectorBatch *batch)
 {
 	ParticleSettings *part = sim->psys->part;
 	ParticleData *pa = sim->psys->particles + p;
@@ -2096,6 +2192,14 @@ static void basic_integrate(ParticleSimulationData *sim, int p, float dfra, floa
 
 	efdata.pa = pa;
 	efdata.sim = sim;
+	efdata.eff_force = efdata.eff_impulse = efdata.eff_ave = NULL;
+
+	if (batch && batch->point_index[p] != -1) {
+		const int i = batch->point_index[p];
+		efdata.eff_force = batch->force[i];
+		efdata.eff_impulse = batch->impulse[i];
+		efdata.eff_ave = batch->ave ? batch->ave[i] : NULL;
+	}
 
 	/* add global acceleration (gravitation) */
 	if (psys_uses_gravity(sim) &&
@@ -3404,7 +3508,7 @@ static void dynamics_step_sph_ddr_task_cb_ex(
 	}
 
 	/* do global forces & effectors */
-	basic_integrate(sim, p, pa->state.time, data->cfra);
+	basic_integrate(sim, p, pa->state.time, data->cfra, NULL);
 
 	/* actual fluids calculations */
 	sph_integrate(sim, pa, pa->state.time, sphdata);
@@ -3436,7 +3540,7 @@ static void dynamics_step_sph_classical_basic_integrate_task_cb_ex(
 		return;
 	}
 
-	basic_integrate(sim, p, pa->state.time, data->cfra);
+	basic_integrate(sim, p, pa->state.time, data->cfra, NULL);
 }
 
 static void dynamics_step_sph_classical_calc_density_task_cb_ex(
@@ -3613,9 +3717,12 @@ static void dynamics_step(ParticleSimulationData *sim, float cfra)
 	switch (part->phystype) {
 		case PART_PHYS_NEWTON:
 		{
+			ParticleEffectorBatch batch;
+			const bool use_batch = basic_integrate_effectors_batch(sim, &batch);
+
 			LOOP_DYNAMIC_PARTICLES {
 				/* do global forces & effectors */
-				basic_integrate(sim, p, pa->state.time, cfra);
+				basic_integrate(sim, p, pa->state.time, cfra, use_batch ? &batch : NULL);
 
 				/* deflection */
 				if (sim->colliders)
@@ -3624,6 +3731,10 @@ static void dynamics_step(ParticleSimulationData *sim, float cfra)
 				/* rotations */
 				basic_rotate(part, pa, pa->state.time, timestep);
 			}
+
+			if (use_batch) {
+				basic_integrate_effectors_batch_free(&batch);
+			}
 			break;
 		}
 		case PART_PHYS_BOIDS:
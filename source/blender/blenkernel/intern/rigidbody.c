@@ -42,6 +42,8 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_math.h"
+#include "BLI_ghash.h"
+#include "BLI_task.h"
 
 #ifdef WITH_BULLET
 #  include "RBI_api.h"
@@ -393,12 +395,96 @@ static rbCollisionShape *rigidbody_get_shape_trimesh_from_mesh(Object *ob)
 	return shape;
 }
 
+/* Collision Shape Cache --------------------- */
+
+/* Mesh based collision shapes built while updating the simulation, so objects
+ * sharing mesh data (duplicated debris for example) instance the geometry of
+ * the first one instead of each computing their own convex hull or triangle mesh.
+ * Entries are the keys as well as the values of the hash.
+ */
+typedef struct RigidBodyShapeCacheEntry {
+	/* key */
+	const Mesh *mesh;
+	short shape;
+	short type;
+	int flag;
+
+	/* most recently built shape for the key, owned by the object using it */
+	rbCollisionShape *physics_shape;
+	bool can_embed;
+} RigidBodyShapeCacheEntry;
+
+static unsigned int rigidbody_shape_cache_hash(const void *key)
+{
+	const RigidBodyShapeCacheEntry *entry = key;
+	return BLI_ghashutil_ptrhash(entry->mesh);
+}
+
+static bool rigidbody_shape_cache_cmp(const void *a, const void *b)
+{
+	const RigidBodyShapeCacheEntry *entry_a = a;
+	const RigidBodyShapeCacheEntry *entry_b = b;
+
+	return ((entry_a->mesh != entry_b->mesh) ||
+	        (entry_a->shape != entry_b->shape) ||
+	        (entry_a->type != entry_b->type) ||
+	        (entry_a->flag != entry_b->flag));
+}
+
+static GHash *rigidbody_shape_cache_new(void)
+{
+	return BLI_ghash_new(rigidbody_shape_cache_hash, rigidbody_shape_cache_cmp, __func__);
+}
+
+static void rigidbody_shape_cache_free(GHash *shape_cache)
+{
+	BLI_ghash_free(shape_cache, MEM_freeN, NULL);
+}
+
+/* Fill in the cache key for the collision shape of the object,
+ * returns false when the shape can't be shared with other objects.
+ */
+static bool rigidbody_shape_cache_key(Object *ob, RigidBodyShapeCacheEntry *r_key)
+{
+	RigidBodyOb *rbo = ob->rigidbody_object;
+	Mesh *mesh;
+
+	if (ob->type != OB_MESH || ob->data == NULL || !ELEM(rbo->shape, RB_SHAPE_CONVEXH, RB_SHAPE_TRIMESH))
+		return false;
+
+	/* deforming triangle meshes get their vertices updated every step */
+	if (rbo->shape == RB_SHAPE_TRIMESH && (rbo->flag & RBO_FLAG_USE_DEFORM))
+		return false;
+
+	mesh = (ob->runtime.mesh_orig) ? ob->runtime.mesh_orig : ob->data;
+
+	/* evaluated geometry only matches the other users of the mesh without modifiers and shape keys */
+	if (rbo->mesh_source != RBO_MESH_BASE && (ob->modifiers.first || mesh->key))
+		return false;
+
+	r_key->mesh = mesh;
+	r_key->shape = rbo->shape;
+	/* passive and active triangle meshes use different shape types */
+	r_key->type = (rbo->shape == RB_SHAPE_TRIMESH) ? rbo->type : 0;
+	/* the collision margin is embedded in convex hulls */
+	r_key->flag = (rbo->shape == RB_SHAPE_CONVEXH) ? (rbo->flag & RBO_FLAG_USE_MARGIN) : 0;
+
+	return true;
+}
+
+/* --------------------- */
+
 /* Create new physics sim collision shape for object and store it,
  * or remove the existing one first and replace...
+ *
+ * \param shape_cache: Optional, used to share mesh shapes between objects
  */
-static void rigidbody_validate_sim_shape(Object *ob, bool rebuild)
+static void rigidbody_validate_sim_shape(Object *ob, bool rebuild, GHash *shape_cache)
 {
 	RigidBodyOb *rbo = ob->rigidbody_object;
+	RigidBodyShapeCacheEntry cache_key;
+	RigidBodyShapeCacheEntry *cache_entry = NULL;
+	bool use_cache = false;
 	rbCollisionShape *new_shape = NULL;
 	BoundBox *bb = NULL;
 	float size[3] = {1.0f, 1.0f, 1.0f};
@@ -442,6 +528,11 @@ static void rigidbody_validate_sim_shape(Object *ob, bool rebuild)
 		radius = MAX3(size[0], size[1], size[2]);
 	}
 
+	if (shape_cache && rigidbody_shape_cache_key(ob, &cache_key)) {
+		use_cache = true;
+		cache_entry = BLI_ghash_lookup(shape_cache, &cache_key);
+	}
+
 	/* create new shape */
 	switch (rbo->shape) {
 		case RB_SHAPE_BOX:
@@ -469,14 +560,33 @@ static void rigidbody_validate_sim_shape(Object *ob, bool rebuild)
 
 			if (!(rbo->flag & RBO_FLAG_USE_MARGIN) && has_volume)
 				hull_margin = 0.04f;
-			new_shape = rigidbody_get_shape_convexhull_from_mesh(ob, hull_margin, &can_embed);
+			if (cache_entry) {
+				new_shape = RB_shape_new_instance(cache_entry->physics_shape);
+				can_embed = cache_entry->can_embed;
+			}
+			if (new_shape == NULL)
+				new_shape = rigidbody_get_shape_convexhull_from_mesh(ob, hull_margin, &can_embed);
 			if (!(rbo->flag & RBO_FLAG_USE_MARGIN))
 				rbo->margin = (can_embed && has_volume) ? 0.04f : 0.0f;  /* RB_TODO ideally we shouldn't directly change the margin here */
 			break;
 		case RB_SHAPE_TRIMESH:
-			new_shape = rigidbody_get_shape_trimesh_from_mesh(ob);
+			if (cache_entry)
+				new_shape = RB_shape_new_instance(cache_entry->physics_shape);
+			if (new_shape == NULL)
+				new_shape = rigidbody_get_shape_trimesh_from_mesh(ob);
 			break;
 	}
+	/* remember the shape for other users of the mesh, this has to happen before the old
+	 * shape is freed below since that can be the one in the cache */
+	if (use_cache && new_shape) {
+		if (cache_entry == NULL) {
+			cache_entry = MEM_mallocN(sizeof(*cache_entry), __func__);
+			*cache_entry = cache_key;
+			BLI_ghash_insert(shape_cache, cache_entry, cache_entry);
+		}
+		cache_entry->physics_shape = new_shape;
+		cache_entry->can_embed = can_embed;
+	}
 	/* use box shape if we can't fall back to old shape */
 	if (new_shape == NULL && rbo->shared->physics_shape == NULL) {
 		new_shape = RB_shape_new_box(size[0], size[1], size[2]);
@@ -651,8 +761,9 @@ void BKE_rigidbody_calc_center_of_mass(Object *ob, float r_center[3])
  * Create physics sim representation of object given RigidBody settings
  *
  * \param rebuild: Even if an instance already exists, replace it
+ * \param shape_cache: Optional, used to share mesh shapes between objects
  */
-static void rigidbody_validate_sim_object(RigidBodyWorld *rbw, Object *ob, bool rebuild)
+static void rigidbody_validate_sim_object(RigidBodyWorld *rbw, Object *ob, bool rebuild, GHash *shape_cache)
 {
 	RigidBodyOb *rbo = (ob) ? ob->rigidbody_object : NULL;
 	float loc[3];
@@ -667,7 +778,7 @@ static void rigidbody_validate_sim_object(RigidBodyWorld *rbw, Object *ob, bool
 	/* make sure collision shape exists */
 	/* FIXME we shouldn't always have to rebuild collision shapes when rebuilding objects, but it's needed for constraints to update correctly */
 	if (rbo->shared->physics_shape == NULL || rebuild)
-		rigidbody_validate_sim_shape(ob, true);
+		rigidbody_validate_sim_shape(ob, true, shape_cache);
 
 	if (rbo->shared->physics_object) {
 		RB_dworld_remove_body(rbw->shared->physics_world, rbo->shared->physics_object);
@@ -1327,16 +1438,24 @@ static void rigidbody_update_sim_world(Scene *scene, RigidBodyWorld *rbw)
 	rigidbody_update_ob_array(rbw);
 }
 
-static void rigidbody_update_sim_ob(Depsgraph *depsgraph, Scene *scene, RigidBodyWorld *rbw, Object *ob, RigidBodyOb *rbo)
+/* Whether the object is transformed by the user during the simulation */
+static bool rigidbody_ob_is_transformed(Object *ob)
 {
-	float loc[3];
-	float rot[4];
-	float scale[3];
+	return (ob->flag & SELECT) && (G.moving & G_TRANSFORM_OBJ);
+}
 
-	/* only update if rigid body exists */
-	if (rbo->shared->physics_object == NULL)
-		return;
+/* Only dynamic bodies which aren't effectors themselves need effector update */
+static bool rigidbody_ob_use_effectors(Object *ob, RigidBodyOb *rbo)
+{
+	if (rbo->flag & RBO_FLAG_KINEMATIC || rigidbody_ob_is_transformed(ob))
+		return false;
 
+	return (rbo->type == RBO_TYPE_ACTIVE && ((ob->pd == NULL) || (ob->pd->forcefield == PFIELD_NULL)));
+}
+
+/* Update collision shapes of deforming meshes */
+static void rigidbody_update_sim_ob_shape(Object *ob, RigidBodyOb *rbo)
+{
 	if (rbo->shape == RB_SHAPE_TRIMESH && rbo->flag & RBO_FLAG_USE_DEFORM) {
 		Mesh *mesh = ob->runtime.mesh_deform_eval;
 		if (mesh) {
@@ -1347,6 +1466,92 @@ static void rigidbody_update_sim_ob(Depsgraph *depsgraph, Scene *scene, RigidBod
 			RB_shape_trimesh_update(rbo->shared->physics_shape, (float *)mvert, totvert, sizeof(MVert), bb->vec[0], bb->vec[6]);
 		}
 	}
+}
+
+/* Calculate the net force of the effectors for all bodies which use them.
+ * The effectors are evaluated once for the world, since no body using them is an
+ * effector itself. Returns NULL when there are no effectors, otherwise an array
+ * with a force per object of the world.
+ */
+static float (*rigidbody_update_sim_effectors(Depsgraph *depsgraph, Scene *scene, RigidBodyWorld *rbw))[3]
+{
+	EffectorWeights *effector_weights = rbw->effector_weights;
+	ListBase *effectors;
+	EffectedPoint *epoints;
+	float (*eff_loc)[3], (*eff_vel)[3], (*forces)[3], (*eff_force)[3] = NULL;
+	int *index;
+	int i, totpoint = 0;
+
+	/* get effectors present in the group specified by effector_weights */
+	effectors = BKE_effectors_create(depsgraph, NULL, NULL, effector_weights);
+	if (effectors == NULL) {
+		if (G.f & G_DEBUG)
+			printf("\tno forces to apply to rigid bodies\n");
+		return NULL;
+	}
+
+	epoints = MEM_mallocN(sizeof(*epoints) * rbw->numbodies, "rigidbody effected points");
+	eff_loc = MEM_mallocN(sizeof(*eff_loc) * rbw->numbodies, "rigidbody effector locations");
+	eff_vel = MEM_mallocN(sizeof(*eff_vel) * rbw->numbodies, "rigidbody effector velocities");
+	forces = MEM_callocN(sizeof(*forces) * rbw->numbodies, "rigidbody effector point forces");
+	index = MEM_mallocN(sizeof(*index) * rbw->numbodies, "rigidbody effector index");
+
+	for (i = 0; i < rbw->numbodies; i++) {
+		Object *ob = rbw->objects[i];
+		RigidBodyOb *rbo;
+
+		/* cleared when the object is removed from the world */
+		if (ob == NULL)
+			continue;
+
+		rbo = ob->rigidbody_object;
+		if (ob->type != OB_MESH || rbo == NULL || rbo->shared->physics_object == NULL || !rigidbody_ob_use_effectors(ob, rbo))
+			continue;
+
+		/* create dummy 'point' which represents last known position of object as result of sim */
+		// XXX: this can create some inaccuracies with sim position, but is probably better than using unsimulated vals?
+		RB_body_get_position(rbo->shared->physics_object, eff_loc[totpoint]);
+		RB_body_get_linear_velocity(rbo->shared->physics_object, eff_vel[totpoint]);
+
+		pd_point_from_loc(scene, eff_loc[totpoint], eff_vel[totpoint], 0, &epoints[totpoint]);
+		index[totpoint] = i;
+		totpoint++;
+	}
+
+	/* calculate net force of effectors for all points at once */
+	BKE_effectors_apply_array(effectors, NULL, effector_weights, epoints, totpoint, forces, NULL);
+
+	eff_force = MEM_callocN(sizeof(*eff_force) * rbw->numbodies, "rigidbody effector forces");
+	for (i = 0; i < totpoint; i++) {
+		copy_v3_v3(eff_force[index[i]], forces[i]);
+
+		if (G.f & G_DEBUG) {
+			printf("\tapplying force (%f,%f,%f) to '%s'\n",
+			       forces[i][0], forces[i][1], forces[i][2], rbw->objects[index[i]]->id.name + 2);
+		}
+	}
+
+	MEM_freeN(index);
+	MEM_freeN(forces);
+	MEM_freeN(eff_vel);
+	MEM_freeN(eff_loc);
+	MEM_freeN(epoints);
+
+	/* cleanup */
+	BKE_effectors_free(effectors);
+
+	return eff_force;
+}
+
+static void rigidbody_update_sim_ob(Object *ob, RigidBodyOb *rbo, const float eff_force[3])
+{
+	float loc[3];
+	float rot[4];
+	float scale[3];
+
+	/* only update if rigid body exists */
+	if (rbo->shared->physics_object == NULL)
+		return;
 
 	mat4_decompose(loc, rot, scale, ob->obmat);
 
@@ -1357,52 +1562,23 @@ static void rigidbody_update_sim_ob(Depsgraph *depsgraph, Scene *scene, RigidBod
 		RB_shape_set_margin(rbo->shared->physics_shape, RBO_GET_MARGIN(rbo) * MIN3(scale[0], scale[1], scale[2]));
 
 	/* make transformed objects temporarily kinmatic so that they can be moved by the user during simulation */
-	if (ob->flag & SELECT && G.moving & G_TRANSFORM_OBJ) {
+	if (rigidbody_ob_is_transformed(ob)) {
 		RB_body_set_kinematic_state(rbo->shared->physics_object, true);
 		RB_body_set_mass(rbo->shared->physics_object, 0.0f);
 	}
 
 	/* update rigid body location and rotation for kinematic bodies */
-	if (rbo->flag & RBO_FLAG_KINEMATIC || (ob->flag & SELECT && G.moving & G_TRANSFORM_OBJ)) {
+	if (rbo->flag & RBO_FLAG_KINEMATIC || rigidbody_ob_is_transformed(ob)) {
 		RB_body_activate(rbo->shared->physics_object);
 		RB_body_set_loc_rot(rbo->shared->physics_object, loc, rot);
 	}
 	/* update influence of effectors - but don't do it on an effector */
-	/* only dynamic bodies need effector update */
-	else if (rbo->type == RBO_TYPE_ACTIVE && ((ob->pd == NULL) || (ob->pd->forcefield == PFIELD_NULL))) {
-		EffectorWeights *effector_weights = rbw->effector_weights;
-		EffectedPoint epoint;
-		ListBase *effectors;
-
-		/* get effectors present in the group specified by effector_weights */
-		effectors = BKE_effectors_create(depsgraph, ob, NULL, effector_weights);
-		if (effectors) {
-			float eff_force[3] = {0.0f, 0.0f, 0.0f};
-			float eff_loc[3], eff_vel[3];
-
-			/* create dummy 'point' which represents last known position of object as result of sim */
-			// XXX: this can create some inaccuracies with sim position, but is probably better than using unsimulated vals?
-			RB_body_get_position(rbo->shared->physics_object, eff_loc);
-			RB_body_get_linear_velocity(rbo->shared->physics_object, eff_vel);
-
-			pd_point_from_loc(scene, eff_loc, eff_vel, 0, &epoint);
-
-			/* calculate net force of effectors, and apply to sim object
-			 * - we use 'central force' since apply force requires a "relative position" which we don't have...
-			 */
-			BKE_effectors_apply(effectors, NULL, effector_weights, &epoint, eff_force, NULL);
-			if (G.f & G_DEBUG)
-				printf("\tapplying force (%f,%f,%f) to '%s'\n", eff_force[0], eff_force[1], eff_force[2], ob->id.name + 2);
-			/* activate object in case it is deactivated */
-			if (!is_zero_v3(eff_force))
-				RB_body_activate(rbo->shared->physics_object);
-			RB_body_apply_central_force(rbo->shared->physics_object, eff_force);
-		}
-		else if (G.f & G_DEBUG)
-			printf("\tno forces to apply to '%s'\n", ob->id.name + 2);
-
-		/* cleanup */
-		BKE_effectors_free(effectors);
+	else if (eff_force && rigidbody_ob_use_effectors(ob, rbo)) {
+		/* activate object in case it is deactivated */
+		if (!is_zero_v3(eff_force))
+			RB_body_activate(rbo->shared->physics_object);
+		/* we use 'central force' since apply force requires a "relative position" which we don't have... */
+		RB_body_apply_central_force(rbo->shared->physics_object, eff_force);
 	}
 	/* NOTE: passive objects don't need to be updated since they don't move */
 
@@ -1411,6 +1587,50 @@ static void rigidbody_update_sim_ob(Depsgraph *depsgraph, Scene *scene, RigidBod
 	 */
 }
 
+typedef struct RigidBodyUpdateSimData {
+	RigidBodyWorld *rbw;
+	float (*eff_force)[3];
+} RigidBodyUpdateSimData;
+
+static void rigidbody_update_sim_ob_cb(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	RigidBodyUpdateSimData *data = userdata;
+	Object *ob = data->rbw->objects[i];
+	RigidBodyOb *rbo;
+
+	if (ob == NULL)
+		return;
+
+	rbo = ob->rigidbody_object;
+	if (ob->type == OB_MESH && rbo) {
+		rigidbody_update_sim_ob(ob, rbo, (data->eff_force) ? data->eff_force[i] : NULL);
+	}
+}
+
+/* Push transforms, scale and forces of all objects to the sim. The bodies are
+ * independent of each other here, so this runs in parallel. */
+static void rigidbody_update_sim_objects(Depsgraph *depsgraph, Scene *scene, RigidBodyWorld *rbw)
+{
+	RigidBodyUpdateSimData data;
+
+	if (rbw->numbodies == 0)
+		return;
+
+	data.rbw = rbw;
+	data.eff_force = rigidbody_update_sim_effectors(depsgraph, scene, rbw);
+
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.min_iter_per_thread = 64;
+	BLI_task_parallel_range(0, rbw->numbodies, &data, rigidbody_update_sim_ob_cb, &settings);
+
+	if (data.eff_force)
+		MEM_freeN(data.eff_force);
+}
+
 /**
  * Updates and validates world, bodies and shapes.
  *
@@ -1419,6 +1639,7 @@ static void rigidbody_update_sim_ob(Depsgraph *depsgraph, Scene *scene, RigidBod
 static void rigidbody_update_simulation(Depsgraph *depsgraph, Scene *scene, RigidBodyWorld *rbw, bool rebuild)
 {
 	float ctime = DEG_get_ctime(depsgraph);
+	GHash *shape_cache;
 
 	/* update world */
 	if (rebuild)
@@ -1444,7 +1665,9 @@ static void rigidbody_update_simulation(Depsgraph *depsgraph, Scene *scene, Rigi
 		FOREACH_COLLECTION_OBJECT_RECURSIVE_END;
 	}
 
-	/* update objects */
+	/* update objects, validation and shape building stays on this thread */
+	shape_cache = rigidbody_shape_cache_new();
+
 	FOREACH_COLLECTION_OBJECT_RECURSIVE_BEGIN(rbw->group, ob)
 	{
 		if (ob->type == OB_MESH) {
@@ -1462,7 +1685,7 @@ static void rigidbody_update_simulation(Depsgraph *depsgraph, Scene *scene, Rigi
 				 * - assume object to be active? That is the default for newly added settings...
 				 */
 				ob->rigidbody_object = BKE_rigidbody_create_object(scene, ob, RBO_TYPE_ACTIVE);
-				rigidbody_validate_sim_object(rbw, ob, true);
+				rigidbody_validate_sim_object(rbw, ob, true, shape_cache);
 
 				rbo = ob->rigidbody_object;
 			}
@@ -1474,15 +1697,15 @@ static void rigidbody_update_simulation(Depsgraph *depsgraph, Scene *scene, Rigi
 					/* TODO(Sybren): rigidbody_validate_sim_object() can call rigidbody_validate_sim_shape(),
 					 * but neither resets the RBO_FLAG_NEEDS_RESHAPE flag nor calls RB_body_set_collision_shape().
 					 * This results in the collision shape being created twice, which is unnecessary. */
-					rigidbody_validate_sim_object(rbw, ob, true);
+					rigidbody_validate_sim_object(rbw, ob, true, shape_cache);
 				}
 				else if (rbo->flag & RBO_FLAG_NEEDS_VALIDATE) {
-					rigidbody_validate_sim_object(rbw, ob, false);
+					rigidbody_validate_sim_object(rbw, ob, false, shape_cache);
 				}
 				/* refresh shape... */
 				if (rbo->flag & RBO_FLAG_NEEDS_RESHAPE) {
 					/* mesh/shape data changed, so force shape refresh */
-					rigidbody_validate_sim_shape(ob, true);
+					rigidbody_validate_sim_shape(ob, true, shape_cache);
 					/* now tell RB sim about it */
 					// XXX: we assume that this can only get applied for active/passive shapes that will be included as rigidbodies
 					RB_body_set_collision_shape(rbo->shared->physics_object, rbo->shared->physics_shape);
@@ -1490,12 +1713,18 @@ static void rigidbody_update_simulation(Depsgraph *depsgraph, Scene *scene, Rigi
 			}
 			rbo->flag &= ~(RBO_FLAG_NEEDS_VALIDATE | RBO_FLAG_NEEDS_RESHAPE);
 
-			/* update simulation object... */
-			rigidbody_update_sim_ob(depsgraph, scene, rbw, ob, rbo);
+			/* update deforming collision shapes... */
+			if (rbo->shared->physics_object)
+				rigidbody_update_sim_ob_shape(ob, rbo);
 		}
 	}
 	FOREACH_COLLECTION_OBJECT_RECURSIVE_END;
 
+	rigidbody_shape_cache_free(shape_cache);
+
+	/* update simulation objects... */
+	rigidbody_update_sim_objects(depsgraph, scene, rbw);
+
 	/* update constraints */
 	if (rbw->constraints == NULL) /* no constraints, move on */
 		return;
@@ -1538,12 +1767,16 @@ static void rigidbody_update_simulation_post_step(Depsgraph *depsgraph, RigidBod
 {
 	ViewLayer *view_layer = DEG_get_input_view_layer(depsgraph);
 
+	/* only objects transformed by the user need their state restored */
+	if ((G.moving & G_TRANSFORM_OBJ) == 0)
+		return;
+
 	FOREACH_COLLECTION_OBJECT_RECURSIVE_BEGIN(rbw->group, ob)
 	{
 		Base *base = BKE_view_layer_base_find(view_layer, ob);
 		RigidBodyOb *rbo = ob->rigidbody_object;
 		/* Reset kinematic state for transformed objects. */
-		if (rbo && base && (base->flag & BASE_SELECTED) && (G.moving & G_TRANSFORM_OBJ)) {
+		if (rbo && base && (base->flag & BASE_SELECTED)) {
 			RB_body_set_kinematic_state(rbo->shared->physics_object, rbo->flag & RBO_FLAG_KINEMATIC || rbo->flag & RBO_FLAG_DISABLED);
 			RB_body_set_mass(rbo->shared->physics_object, RBO_GET_MASS(rbo));
 			/* Deactivate passive objects so they don't interfere with deactivation of active objects. */
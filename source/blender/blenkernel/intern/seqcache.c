@@ -24,9 +24,28 @@
 
 /** \file blender/blenkernel/intern/seqcache.c
  *  \ingroup bke
+ *
+ * Images are cached on four levels, following the rendering of a frame:
+ *
+ * - raw: image of a strip before preprocessing (also still frames before and after strips),
+ * - preprocessed: image of a strip after preprocessing and modifiers,
+ * - composite: strips blended up to and including a strip,
+ * - final: output of the whole strip stack, stored for its top-most strip.
+ *
+ * Every level has its own share of the memory cache limit (UserDef.sequencer_cache_budget,
+ * relative to the sum of all shares) and frees its least recently used images when it's full, so tweaking a strip doesn't
+ * throw away final frames ready for playback and the other way around.
+ *
+ * Levels enabled in Editing.cache_flag are also written to disk, below the directory set
+ * in the user preferences, so frames are found again after they're freed from memory or in
+ * a later session on the same file. Files are removed when their strip is invalidated; the
+ * directory of a scene is stamped with Editing.disk_cache_version, which is incremented on
+ * every change, so frames stored for changes which were undone or not saved are not used.
  */
 
 #include <stddef.h>
+#include <stdio.h>
+#include <string.h>
 
 #include "BLI_sys_types.h"  /* for intptr_t */
 
@@ -34,16 +53,34 @@
 
 #include "DNA_sequence_types.h"
 #include "DNA_scene_types.h"
+#include "DNA_userdef_types.h"
 
-#include "IMB_moviecache.h"
+#include "IMB_colormanagement.h"
 #include "IMB_imbuf.h"
 #include "IMB_imbuf_types.h"
 
+#include "BLI_utildefines.h"
+#include "BLI_fileops.h"
+#include "BLI_fileops_types.h"
+#include "BLI_ghash.h"
 #include "BLI_listbase.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+#include "BLI_threads.h"
 
+#include "BKE_main.h"
 #include "BKE_sequencer.h"
 #include "BKE_scene.h"
 
+#ifdef WITH_LZO
+#  ifdef WITH_SYSTEM_LZO
+#    include <lzo/lzo1x.h>
+#  else
+#    include "minilzo.h"
+#  endif
+#  define LZO_OUT_LEN(size)     ((size) + (size) / 16 + 64 + 3)
+#endif
+
 typedef struct SeqCacheKey {
 	struct Sequence *seq;
 	SeqRenderData context;
@@ -51,25 +88,40 @@ typedef struct SeqCacheKey {
 	eSeqStripElemIBuf type;
 } SeqCacheKey;
 
-typedef struct SeqPreprocessCacheElem {
-	struct SeqPreprocessCacheElem *next, *prev;
+/* cache levels, also bits of Editing.cache_flag */
+enum {
+	SEQ_CACHE_LEVEL_RAW = 0,
+	SEQ_CACHE_LEVEL_PREPROCESSED,
+	SEQ_CACHE_LEVEL_COMPOSITE,
+	SEQ_CACHE_LEVEL_FINAL,
+};
+#define SEQ_CACHE_LEVEL_TOT 4
 
-	struct Sequence *seq;
-	SeqRenderData context;
-	eSeqStripElemIBuf type;
+#define SEQ_CACHE_LEVEL_ALL ((1 << SEQ_CACHE_LEVEL_TOT) - 1)
+#define SEQ_CACHE_LEVEL_NOT_RAW (SEQ_CACHE_LEVEL_ALL & ~(1 << SEQ_CACHE_LEVEL_RAW))
+
+typedef struct SeqCacheItem {
+	struct SeqCacheItem *next, *prev;
 
+	SeqCacheKey key;
 	ImBuf *ibuf;
-} SeqPreprocessCacheElem;
+	size_t size;
+} SeqCacheItem;
+
+typedef struct SeqCacheLevel {
+	/* least recently used first */
+	ListBase items;
+	size_t mem_in_use;
+} SeqCacheLevel;
 
-typedef struct SeqPreprocessCache {
-	int cfra;
-	ListBase elems;
-} SeqPreprocessCache;
+/* all items of all levels, by key */
+static GHash *cache_hash = NULL;
+static SeqCacheLevel cache_levels[SEQ_CACHE_LEVEL_TOT];
 
-static struct MovieCache *moviecache = NULL;
-static struct SeqPreprocessCache *preprocess_cache = NULL;
+/* frames are also rendered into the cache by prefetch thread */
+static ThreadMutex cache_lock = BLI_MUTEX_INITIALIZER;
 
-static void preprocessed_cache_destruct(void);
+static void seqcache_disk_index_free(void);
 
 static bool seq_cmp_render_data(const SeqRenderData *a, const SeqRenderData *b)
 {
@@ -98,12 +150,23 @@ static unsigned int seq_hash_render_data(const SeqRenderData *a)
 	return rval;
 }
 
+/* bit pattern of the frame, for hashing and file names */
+static unsigned int seqcache_cfra_bits(float cfra)
+{
+	unsigned int bits;
+
+	BLI_STATIC_ASSERT(sizeof(bits) == sizeof(cfra), "float must be 32 bits");
+	memcpy(&bits, &cfra, sizeof(bits));
+
+	return bits;
+}
+
 static unsigned int seqcache_hashhash(const void *key_)
 {
 	const SeqCacheKey *key = key_;
 	unsigned int rval = seq_hash_render_data(&key->context);
 
-	rval ^= *(const unsigned int *) &key->cfra;
+	rval ^= seqcache_cfra_bits(key->cfra);
 	rval += key->type;
 	rval ^= ((intptr_t) key->seq) << 6;
 
@@ -121,167 +184,895 @@ static bool seqcache_hashcmp(const void *a_, const void *b_)
 	        seq_cmp_render_data(&a->context, &b->context));
 }
 
-void BKE_sequencer_cache_destruct(void)
+static void seqcache_key_init(
+        SeqCacheKey *key, const SeqRenderData *context, Sequence *seq, float cfra, eSeqStripElemIBuf type)
 {
-	if (moviecache)
-		IMB_moviecache_free(moviecache);
+	key->seq = seq;
+	key->context = *context;
+	key->cfra = cfra - seq->start;
+	key->type = type;
+
+	if (context->prefetch_job) {
+		/* prefetch renders copies of strips, store frames for the originals */
+		BKE_sequencer_prefetch_original_get(context, &key->seq, &key->context.scene);
+		key->context.prefetch_job = NULL;
+	}
+}
 
-	preprocessed_cache_destruct();
+static int seqcache_level_get(eSeqStripElemIBuf type)
+{
+	switch (type) {
+		case SEQ_STRIPELEM_IBUF_RAW:
+		case SEQ_STRIPELEM_IBUF_STARTSTILL:
+		case SEQ_STRIPELEM_IBUF_ENDSTILL:
+			return SEQ_CACHE_LEVEL_RAW;
+		case SEQ_STRIPELEM_IBUF:
+			return SEQ_CACHE_LEVEL_PREPROCESSED;
+		case SEQ_STRIPELEM_IBUF_COMP:
+			return SEQ_CACHE_LEVEL_COMPOSITE;
+		case SEQ_STRIPELEM_IBUF_FINAL:
+			return SEQ_CACHE_LEVEL_FINAL;
+	}
+
+	BLI_assert(0);
+	return SEQ_CACHE_LEVEL_FINAL;
 }
 
-void BKE_sequencer_cache_cleanup(void)
+/* The level shares are normalized so they always add up to the whole memory cache limit. */
+static size_t seqcache_level_budget(int level)
 {
-	if (moviecache) {
-		IMB_moviecache_free(moviecache);
-		moviecache = IMB_moviecache_create("seqcache", sizeof(SeqCacheKey), seqcache_hashhash, seqcache_hashcmp);
+	uint64_t total = 0;
+	int i;
+
+	for (i = 0; i < SEQ_CACHE_LEVEL_TOT; i++) {
+		total += (uint64_t)U.sequencer_cache_budget[i];
+	}
+
+	if (total == 0) {
+		return 0;
 	}
 
-	BKE_sequencer_preprocessed_cache_cleanup();
+	return (size_t)((uint64_t)U.memcachelimit * 1024 * 1024 * U.sequencer_cache_budget[level] / total);
 }
 
-static bool seqcache_key_check_seq(ImBuf *UNUSED(ibuf), void *userkey, void *userdata)
+/* *************************** Memory cache *************************** */
+
+static void seqcache_item_remove(SeqCacheItem *item)
 {
-	SeqCacheKey *key = (SeqCacheKey *) userkey;
-	Sequence *seq = (Sequence *) userdata;
+	SeqCacheLevel *level = &cache_levels[seqcache_level_get(item->key.type)];
+
+	BLI_ghash_remove(cache_hash, &item->key, NULL, NULL);
+	BLI_remlink(&level->items, item);
+	level->mem_in_use -= item->size;
 
-	return key->seq == seq;
+	IMB_freeImBuf(item->ibuf);
+	MEM_freeN(item);
 }
 
-void BKE_sequencer_cache_cleanup_sequence(Sequence *seq)
+static void seqcache_cleanup_ex(Sequence *seq, int level_flag)
 {
-	if (moviecache)
-		IMB_moviecache_cleanup(moviecache, seqcache_key_check_seq, seq);
+	BLI_mutex_lock(&cache_lock);
+
+	for (int i = 0; i < SEQ_CACHE_LEVEL_TOT; i++) {
+		SeqCacheItem *item, *item_next;
+
+		if ((level_flag & (1 << i)) == 0) {
+			continue;
+		}
+
+		for (item = cache_levels[i].items.first; item; item = item_next) {
+			item_next = item->next;
+
+			if (seq == NULL || item->key.seq == seq) {
+				seqcache_item_remove(item);
+			}
+		}
+	}
+
+	BLI_mutex_unlock(&cache_lock);
 }
 
-struct ImBuf *BKE_sequencer_cache_get(const SeqRenderData *context, Sequence *seq, float cfra, eSeqStripElemIBuf type)
+static ImBuf *seqcache_memory_get(const SeqCacheKey *key)
 {
-	if (moviecache && seq) {
-		SeqCacheKey key;
+	ImBuf *ibuf = NULL;
+
+	BLI_mutex_lock(&cache_lock);
+
+	if (cache_hash) {
+		SeqCacheItem *item = BLI_ghash_lookup(cache_hash, key);
 
-		key.seq = seq;
-		key.context = *context;
-		key.cfra = cfra - seq->start;
-		key.type = type;
+		if (item) {
+			SeqCacheLevel *level = &cache_levels[seqcache_level_get(key->type)];
 
-		return IMB_moviecache_get(moviecache, &key);
+			BLI_remlink(&level->items, item);
+			BLI_addtail(&level->items, item);
+
+			ibuf = item->ibuf;
+			IMB_refImBuf(ibuf);
+		}
 	}
 
-	return NULL;
+	BLI_mutex_unlock(&cache_lock);
+
+	return ibuf;
 }
 
-void BKE_sequencer_cache_put(const SeqRenderData *context, Sequence *seq, float cfra, eSeqStripElemIBuf type, ImBuf *i)
+/* Returns false when the image was already cached for the key. */
+static bool seqcache_memory_put(const SeqCacheKey *key, ImBuf *ibuf)
 {
-	SeqCacheKey key;
+	const int level_index = seqcache_level_get(key->type);
+	SeqCacheLevel *level = &cache_levels[level_index];
+	const size_t budget = seqcache_level_budget(level_index);
+	SeqCacheItem *item;
 
-	if (i == NULL || context->skip_cache) {
+	BLI_mutex_lock(&cache_lock);
+
+	if (cache_hash == NULL) {
+		cache_hash = BLI_ghash_new(seqcache_hashhash, seqcache_hashcmp, "seqcache hash");
+	}
+
+	item = BLI_ghash_lookup(cache_hash, key);
+
+	if (item) {
+		if (item->ibuf == ibuf) {
+			BLI_remlink(&level->items, item);
+			BLI_addtail(&level->items, item);
+
+			BLI_mutex_unlock(&cache_lock);
+			return false;
+		}
+
+		seqcache_item_remove(item);
+	}
+
+	if (budget != 0) {
+		item = MEM_callocN(sizeof(SeqCacheItem), "sequencer cache item");
+		item->key = *key;
+		item->ibuf = ibuf;
+		item->size = IMB_get_size_in_memory(ibuf);
+
+		IMB_refImBuf(ibuf);
+
+		BLI_ghash_insert(cache_hash, &item->key, item);
+		BLI_addtail(&level->items, item);
+		level->mem_in_use += item->size;
+
+		/* the new item is kept even when it doesn't fit on its own */
+		while (level->mem_in_use > budget && level->items.first != item) {
+			seqcache_item_remove(level->items.first);
+		}
+	}
+
+	BLI_mutex_unlock(&cache_lock);
+
+	return true;
+}
+
+/* *************************** Disk cache *************************** */
+
+#define DISK_CACHE_EXT ".bseq"
+#define DISK_CACHE_STAMP "stamp"
+#define DISK_CACHE_VERSION 1
+
+/* DiskCacheHeader.flag */
+enum {
+	DISK_CACHE_RECT            = (1 << 0),
+	DISK_CACHE_RECT_FLOAT      = (1 << 1),
+	DISK_CACHE_RECT_LZO        = (1 << 2),
+	DISK_CACHE_RECT_FLOAT_LZO  = (1 << 3),
+};
+
+typedef struct DiskCacheHeader {
+	char id[4];
+	int version;
+	int x, y, planes, channels;
+	int flag, pad;
+	/* sizes of the pixel buffers following the header, as stored */
+	uint64_t rect_len, rect_float_len;
+	char rect_colorspace[64];
+	char float_colorspace[64];
+} DiskCacheHeader;
+
+typedef struct DiskCacheFile {
+	struct DiskCacheFile *next, *prev;
+
+	char path[FILE_MAX];
+	size_t size;
+	int64_t mtime;
+} DiskCacheFile;
+
+/* Version of the files in a scene directory, as last read or written. */
+typedef struct DiskCacheSceneDir {
+	struct DiskCacheSceneDir *next, *prev;
+
+	char dir[FILE_MAX];
+	int version;
+} DiskCacheSceneDir;
+
+/* Index of all files in the cache directory, to keep it below the size limit. */
+static struct {
+	char root[FILE_MAX];
+	/* least recently used first */
+	ListBase files;
+	GHash *files_hash;
+	size_t size;
+
+	ListBase scene_dirs;
+} disk_cache = {{0}};
+
+/* disk cache is used by main and prefetch thread */
+static ThreadMutex disk_lock = BLI_MUTEX_INITIALIZER;
+
+/* Directories of the cache and of the scene in it, false when the disk cache can't be used. */
+static bool seqcache_disk_scene_dir_get(Scene *scene, char *r_root, char *r_dir)
+{
+	const char *blendfile_path = BKE_main_blendfile_path_from_global();
+	char blendfile_name[FILE_MAXFILE], blendfile_dir[FILE_MAXFILE], scene_name[MAX_ID_NAME];
+
+	if (U.sequencer_disk_cache_dir[0] == '\0' || blendfile_path[0] == '\0') {
+		return false;
+	}
+
+	BLI_strncpy(r_root, U.sequencer_disk_cache_dir, FILE_MAX);
+	BLI_path_abs(r_root, blendfile_path);
+
+	/* file name isn't unique, add a hash of its path */
+	BLI_split_file_part(blendfile_path, blendfile_name, sizeof(blendfile_name));
+	BLI_path_extension_replace(blendfile_name, sizeof(blendfile_name), "");
+	BLI_snprintf(blendfile_dir, sizeof(blendfile_dir), "%s_%08x",
+	             blendfile_name, BLI_ghashutil_strhash_p(blendfile_path));
+
+	BLI_strncpy(scene_name, scene->id.name + 2, sizeof(scene_name));
+	BLI_filename_make_safe(scene_name);
+
+	BLI_path_join(r_dir, FILE_MAX, r_root, blendfile_dir, scene_name, NULL);
+
+	return true;
+}
+
+static void seqcache_disk_sequence_dir_get(const char *scene_dir, Sequence *seq, char *r_dir)
+{
+	char seq_name[SEQ_NAME_MAXSTR];
+
+	BLI_strncpy(seq_name, seq->name + 2, sizeof(seq_name));
+	BLI_filename_make_safe(seq_name);
+
+	BLI_path_join(r_dir, FILE_MAX, scene_dir, seq_name, NULL);
+}
+
+/* Unlike seq_hash_render_data() only uses values which are the same in another session. */
+static unsigned int seqcache_disk_context_hash(const SeqRenderData *context)
+{
+	unsigned int rval = BLI_ghashutil_strhash_p(context->scene->sequencer_colorspace_settings.name);
+
+	rval = rval * 31 + (unsigned int)context->rectx;
+	rval = rval * 31 + (unsigned int)context->recty;
+	rval = rval * 31 + (unsigned int)context->preview_render_size;
+	rval = rval * 31 + (unsigned int)(context->motion_blur_shutter * 100.0f);
+	rval = rval * 31 + (unsigned int)context->motion_blur_samples;
+	rval = rval * 31 + (unsigned int)context->scene->r.views_format;
+	rval = rval * 31 + (unsigned int)context->view_id;
+
+	return rval;
+}
+
+static bool seqcache_disk_use(const SeqCacheKey *key)
+{
+	Editing *ed = key->context.scene->ed;
+
+	return (ed && (ed->cache_flag & (1 << seqcache_level_get(key->type))) &&
+	        U.sequencer_disk_cache_dir[0] != '\0');
+}
+
+static bool seqcache_disk_path_get(const SeqCacheKey *key, char *r_root, char *r_scene_dir, char *r_path)
+{
+	char seq_dir[FILE_MAX], file_name[FILE_MAXFILE];
+
+	if (!seqcache_disk_scene_dir_get(key->context.scene, r_root, r_scene_dir)) {
+		return false;
+	}
+
+	seqcache_disk_sequence_dir_get(r_scene_dir, key->seq, seq_dir);
+
+	BLI_snprintf(file_name, sizeof(file_name), "%d-%08x-%08x" DISK_CACHE_EXT,
+	             (int)key->type, seqcache_disk_context_hash(&key->context),
+	             seqcache_cfra_bits(key->cfra));
+
+	BLI_path_join(r_path, FILE_MAX, seq_dir, file_name, NULL);
+
+	return true;
+}
+
+static void seqcache_disk_index_add(const char *path, size_t size, int64_t mtime)
+{
+	DiskCacheFile *file = BLI_ghash_lookup(disk_cache.files_hash, path);
+
+	if (file) {
+		BLI_remlink(&disk_cache.files, file);
+		disk_cache.size -= file->size;
+	}
+	else {
+		file = MEM_callocN(sizeof(DiskCacheFile), "sequencer disk cache file");
+		BLI_strncpy(file->path, path, sizeof(file->path));
+		BLI_ghash_insert(disk_cache.files_hash, file->path, file);
+	}
+
+	file->size = size;
+	file->mtime = mtime;
+
+	BLI_addtail(&disk_cache.files, file);
+	disk_cache.size += size;
+}
+
+static void seqcache_disk_index_remove(DiskCacheFile *file)
+{
+	BLI_ghash_remove(disk_cache.files_hash, file->path, NULL, NULL);
+	BLI_remlink(&disk_cache.files, file);
+	disk_cache.size -= file->size;
+
+	MEM_freeN(file);
+}
+
+static void seqcache_disk_index_scan(const char *dir, int depth)
+{
+	struct direntry *entries;
+	unsigned int entries_num = BLI_filelist_dir_contents(dir, &entries);
+
+	for (unsigned int i = 0; i < entries_num; i++) {
+		struct direntry *entry = &entries[i];
+
+		if (FILENAME_IS_CURRPAR(entry->relname)) {
+			continue;
+		}
+
+		/* root, file and scene directories, strip directories */
+		if (S_ISDIR(entry->type)) {
+			if (depth < 3) {
+				seqcache_disk_index_scan(entry->path, depth + 1);
+			}
+		}
+		else if (BLI_path_extension_check(entry->relname, DISK_CACHE_EXT)) {
+			seqcache_disk_index_add(entry->path, (size_t)entry->s.st_size, (int64_t)entry->s.st_mtime);
+		}
+	}
+
+	BLI_filelist_free(entries, entries_num);
+}
+
+static int seqcache_disk_index_cmp(const void *a_, const void *b_)
+{
+	const DiskCacheFile *a = a_;
+	const DiskCacheFile *b = b_;
+
+	return (a->mtime > b->mtime);
+}
+
+/* Files of previous sessions are found by scanning the directory once. */
+static void seqcache_disk_index_ensure(const char *root)
+{
+	if (disk_cache.files_hash && STREQ(disk_cache.root, root)) {
 		return;
 	}
 
-	if (!moviecache) {
-		moviecache = IMB_moviecache_create("seqcache", sizeof(SeqCacheKey), seqcache_hashhash, seqcache_hashcmp);
+	seqcache_disk_index_free();
+
+	BLI_strncpy(disk_cache.root, root, sizeof(disk_cache.root));
+	disk_cache.files_hash = BLI_ghash_str_new("sequencer disk cache files");
+
+	if (BLI_is_dir(root)) {
+		seqcache_disk_index_scan(root, 1);
+		BLI_listbase_sort(&disk_cache.files, seqcache_disk_index_cmp);
+	}
+}
+
+static void seqcache_disk_index_free(void)
+{
+	if (disk_cache.files_hash) {
+		BLI_ghash_free(disk_cache.files_hash, NULL, NULL);
+		disk_cache.files_hash = NULL;
 	}
 
-	key.seq = seq;
-	key.context = *context;
-	key.cfra = cfra - seq->start;
-	key.type = type;
+	BLI_freelistN(&disk_cache.files);
+	BLI_freelistN(&disk_cache.scene_dirs);
+	disk_cache.root[0] = '\0';
+	disk_cache.size = 0;
+}
+
+static void seqcache_disk_limit_enforce(void)
+{
+	const size_t limit = (size_t)U.sequencer_disk_cache_size_limit * 1024 * 1024 * 1024;
+
+	while (limit != 0 && disk_cache.size > limit && disk_cache.files.first) {
+		DiskCacheFile *file = disk_cache.files.first;
 
-	IMB_moviecache_put(moviecache, &key, i);
+		BLI_delete(file->path, false, false);
+		seqcache_disk_index_remove(file);
+	}
 }
 
-void BKE_sequencer_preprocessed_cache_cleanup(void)
+static void seqcache_disk_remove_dir(const char *dir)
 {
-	SeqPreprocessCacheElem *elem;
+	const size_t dir_len = strlen(dir);
+	DiskCacheFile *file, *file_next;
 
-	if (!preprocess_cache)
+	if (!BLI_is_dir(dir)) {
 		return;
+	}
+
+	BLI_delete(dir, true, true);
+
+	for (file = disk_cache.files.first; file; file = file_next) {
+		file_next = file->next;
+
+		if (STREQLEN(file->path, dir, dir_len) && file->path[dir_len] == SEP) {
+			seqcache_disk_index_remove(file);
+		}
+	}
+}
+
+static int seqcache_disk_stamp_read(const char *scene_dir)
+{
+	char path[FILE_MAX];
+	FILE *file;
+	int version = -1;
+
+	BLI_path_join(path, sizeof(path), scene_dir, DISK_CACHE_STAMP, NULL);
 
-	for (elem = preprocess_cache->elems.first; elem; elem = elem->next) {
-		IMB_freeImBuf(elem->ibuf);
+	file = BLI_fopen(path, "r");
+	if (file) {
+		if (fscanf(file, "%d", &version) != 1) {
+			version = -1;
+		}
+		fclose(file);
 	}
-	BLI_freelistN(&preprocess_cache->elems);
 
-	BLI_listbase_clear(&preprocess_cache->elems);
+	return version;
 }
 
-static void preprocessed_cache_destruct(void)
+static void seqcache_disk_stamp_write(const char *scene_dir, int version, bool create)
 {
-	if (!preprocess_cache)
+	char path[FILE_MAX];
+	FILE *file;
+
+	BLI_path_join(path, sizeof(path), scene_dir, DISK_CACHE_STAMP, NULL);
+
+	if (!create && !BLI_exists(path)) {
 		return;
+	}
 
-	BKE_sequencer_preprocessed_cache_cleanup();
+	if (BLI_make_existing_file(path)) {
+		file = BLI_fopen(path, "w");
+		if (file) {
+			fprintf(file, "%d\n", version);
+			fclose(file);
+		}
+	}
+}
 
-	MEM_freeN(preprocess_cache);
-	preprocess_cache = NULL;
+static DiskCacheSceneDir *seqcache_disk_scene_dir_find(const char *scene_dir)
+{
+	return BLI_findstring(&disk_cache.scene_dirs, scene_dir, offsetof(DiskCacheSceneDir, dir));
 }
 
-ImBuf *BKE_sequencer_preprocessed_cache_get(const SeqRenderData *context, Sequence *seq, float cfra, eSeqStripElemIBuf type)
+/* Remove files of the scene when they were written for another state of its strips. */
+static void seqcache_disk_scene_dir_verify(Editing *ed, const char *scene_dir)
 {
-	SeqPreprocessCacheElem *elem;
+	DiskCacheSceneDir *dir = seqcache_disk_scene_dir_find(scene_dir);
+
+	if (dir == NULL) {
+		dir = MEM_callocN(sizeof(DiskCacheSceneDir), "sequencer disk cache scene directory");
+		BLI_strncpy(dir->dir, scene_dir, sizeof(dir->dir));
+		dir->version = seqcache_disk_stamp_read(scene_dir);
+		BLI_addtail(&disk_cache.scene_dirs, dir);
+	}
 
-	if (!preprocess_cache)
+	if (dir->version != ed->disk_cache_version) {
+		seqcache_disk_remove_dir(scene_dir);
+		dir->version = ed->disk_cache_version;
+	}
+}
+
+static void seqcache_disk_version_bump(Editing *ed, const char *scene_dir)
+{
+	DiskCacheSceneDir *dir = seqcache_disk_scene_dir_find(scene_dir);
+
+	ed->disk_cache_version++;
+
+	if (dir) {
+		dir->version = ed->disk_cache_version;
+	}
+
+	seqcache_disk_stamp_write(scene_dir, ed->disk_cache_version, false);
+}
+
+/* Returns a new buffer, NULL when compression is not available or doesn't make the data smaller. */
+static void *seqcache_disk_compress(const void *data, size_t len, size_t *r_len)
+{
+#ifdef WITH_LZO
+	lzo_uint out_len = LZO_OUT_LEN(len);
+	unsigned char *out = MEM_mallocN(out_len, "sequencer disk cache compressed");
+	void *wrkmem = MEM_mallocN(LZO1X_MEM_COMPRESS, "sequencer disk cache lzo");
+	int r = lzo1x_1_compress(data, (lzo_uint)len, out, &out_len, wrkmem);
+
+	MEM_freeN(wrkmem);
+
+	if (r == LZO_E_OK && out_len < len) {
+		*r_len = out_len;
+		return out;
+	}
+
+	MEM_freeN(out);
+#else
+	UNUSED_VARS(data, len, r_len);
+#endif
+
+	return NULL;
+}
+
+static bool seqcache_disk_decompress(const unsigned char *in, size_t in_len, void *data, size_t len, bool is_compressed)
+{
+	if (!is_compressed) {
+		if (in_len != len) {
+			return false;
+		}
+
+		memcpy(data, in, len);
+		return true;
+	}
+
+#ifdef WITH_LZO
+	{
+		lzo_uint out_len = len;
+		int r = lzo1x_decompress_safe(in, (lzo_uint)in_len, data, &out_len, NULL);
+
+		return (r == LZO_E_OK && out_len == len);
+	}
+#else
+	return false;
+#endif
+}
+
+static void seqcache_disk_write(const SeqCacheKey *key, ImBuf *ibuf)
+{
+	char root[FILE_MAX], scene_dir[FILE_MAX], path[FILE_MAX], path_temp[FILE_MAX];
+	const size_t pixels = (size_t)ibuf->x * ibuf->y;
+	const size_t rect_len = ibuf->rect ? pixels * 4 : 0;
+	const size_t rect_float_len = ibuf->rect_float ? pixels * 4 * sizeof(float) : 0;
+	DiskCacheHeader header = {{0}};
+	void *rect_compressed = NULL, *rect_float_compressed = NULL;
+	size_t rect_stored_len = rect_len, rect_float_stored_len = rect_float_len;
+	bool is_stored;
+	FILE *file;
+
+	/* sequencer only renders RGBA images */
+	if ((rect_len == 0 && rect_float_len == 0) || (ibuf->rect_float && ibuf->channels != 4)) {
+		return;
+	}
+
+	if (!seqcache_disk_path_get(key, root, scene_dir, path)) {
+		return;
+	}
+
+	BLI_mutex_lock(&disk_lock);
+	seqcache_disk_index_ensure(root);
+	seqcache_disk_scene_dir_verify(key->context.scene->ed, scene_dir);
+	is_stored = BLI_ghash_haskey(disk_cache.files_hash, path);
+	BLI_mutex_unlock(&disk_lock);
+
+	if (is_stored) {
+		return;
+	}
+
+	memcpy(header.id, "BSEQ", sizeof(header.id));
+	header.version = DISK_CACHE_VERSION;
+	header.x = ibuf->x;
+	header.y = ibuf->y;
+	header.planes = ibuf->planes;
+	header.channels = ibuf->channels;
+
+	if (ibuf->rect) {
+		header.flag |= DISK_CACHE_RECT;
+		BLI_strncpy(header.rect_colorspace, IMB_colormanagement_get_rect_colorspace(ibuf),
+		            sizeof(header.rect_colorspace));
+
+		rect_compressed = seqcache_disk_compress(ibuf->rect, rect_len, &rect_stored_len);
+		if (rect_compressed) {
+			header.flag |= DISK_CACHE_RECT_LZO;
+		}
+	}
+
+	if (ibuf->rect_float) {
+		header.flag |= DISK_CACHE_RECT_FLOAT;
+		BLI_strncpy(header.float_colorspace, IMB_colormanagement_get_float_colorspace(ibuf),
+		            sizeof(header.float_colorspace));
+
+		rect_float_compressed = seqcache_disk_compress(ibuf->rect_float, rect_float_len, &rect_float_stored_len);
+		if (rect_float_compressed) {
+			header.flag |= DISK_CACHE_RECT_FLOAT_LZO;
+		}
+	}
+
+	header.rect_len = rect_stored_len;
+	header.rect_float_len = rect_float_stored_len;
+
+	/* written under a temporary name, so an interrupted write never leaves a broken file */
+	BLI_snprintf(path_temp, sizeof(path_temp), "%s.tmp", path);
+
+	BLI_mutex_lock(&disk_lock);
+
+	seqcache_disk_stamp_write(scene_dir, key->context.scene->ed->disk_cache_version, true);
+
+	if (BLI_make_existing_file(path_temp) && (file = BLI_fopen(path_temp, "wb"))) {
+		bool ok = (fwrite(&header, sizeof(header), 1, file) == 1);
+
+		if (ok && rect_stored_len) {
+			const void *data = rect_compressed ? rect_compressed : (void *)ibuf->rect;
+			ok = (fwrite(data, rect_stored_len, 1, file) == 1);
+		}
+		if (ok && rect_float_stored_len) {
+			const void *data = rect_float_compressed ? rect_float_compressed : (void *)ibuf->rect_float;
+			ok = (fwrite(data, rect_float_stored_len, 1, file) == 1);
+		}
+
+		fclose(file);
+
+		if (ok && BLI_rename(path_temp, path) == 0) {
+			seqcache_disk_index_add(path, sizeof(header) + rect_stored_len + rect_float_stored_len, 0);
+			seqcache_disk_limit_enforce();
+		}
+		else {
+			BLI_delete(path_temp, false, false);
+		}
+	}
+
+	BLI_mutex_unlock(&disk_lock);
+
+	MEM_SAFE_FREE(rect_compressed);
+	MEM_SAFE_FREE(rect_float_compressed);
+}
+
+static ImBuf *seqcache_disk_read(const SeqCacheKey *key)
+{
+	char root[FILE_MAX], scene_dir[FILE_MAX], path[FILE_MAX];
+	DiskCacheFile *file;
+	DiskCacheHeader header;
+	unsigned char *data = NULL;
+	size_t data_len = 0, rect_len, rect_float_len;
+	ImBuf *ibuf = NULL;
+	bool ok;
+
+	if (!seqcache_disk_path_get(key, root, scene_dir, path)) {
 		return NULL;
+	}
+
+	BLI_mutex_lock(&disk_lock);
+
+	seqcache_disk_index_ensure(root);
+	seqcache_disk_scene_dir_verify(key->context.scene->ed, scene_dir);
+
+	file = BLI_ghash_lookup(disk_cache.files_hash, path);
+
+	if (file) {
+		FILE *fp = BLI_fopen(path, "rb");
+
+		if (fp) {
+			data_len = file->size;
+			data = MEM_mallocN(data_len, "sequencer disk cache file");
+
+			if (fread(data, data_len, 1, fp) != 1) {
+				MEM_SAFE_FREE(data);
+			}
+
+			fclose(fp);
+		}
+
+		if (data) {
+			BLI_remlink(&disk_cache.files, file);
+			BLI_addtail(&disk_cache.files, file);
+		}
+		else {
+			BLI_delete(path, false, false);
+			seqcache_disk_index_remove(file);
+		}
+	}
 
-	if (preprocess_cache->cfra != cfra)
+	BLI_mutex_unlock(&disk_lock);
+
+	if (data == NULL) {
 		return NULL;
+	}
 
-	for (elem = preprocess_cache->elems.first; elem; elem = elem->next) {
-		if (elem->seq != seq)
-			continue;
+	ok = (data_len >= sizeof(header));
 
-		if (elem->type != type)
-			continue;
+	if (ok) {
+		memcpy(&header, data, sizeof(header));
 
-		if (seq_cmp_render_data(&elem->context, context) != 0)
-			continue;
+		ok = (memcmp(header.id, "BSEQ", sizeof(header.id)) == 0 &&
+		      header.version == DISK_CACHE_VERSION &&
+		      header.x > 0 && header.y > 0 && header.channels == 4 &&
+		      data_len == sizeof(header) + header.rect_len + header.rect_float_len);
+	}
+
+	if (ok) {
+		const size_t pixels = (size_t)header.x * header.y;
+		const unsigned char *rect_data = data + sizeof(header);
+		const unsigned char *rect_float_data = rect_data + header.rect_len;
+		int flags = 0;
+
+		if (header.flag & DISK_CACHE_RECT) {
+			flags |= IB_rect;
+		}
+		if (header.flag & DISK_CACHE_RECT_FLOAT) {
+			flags |= IB_rectfloat;
+		}
+
+		ibuf = IMB_allocImBuf(header.x, header.y, header.planes, flags);
+
+		rect_len = ibuf->rect ? pixels * 4 : 0;
+		rect_float_len = ibuf->rect_float ? pixels * 4 * sizeof(float) : 0;
+
+		if (ibuf->rect) {
+			ok = seqcache_disk_decompress(rect_data, header.rect_len, ibuf->rect, rect_len,
+			                              (header.flag & DISK_CACHE_RECT_LZO) != 0);
+			IMB_colormanagement_assign_rect_colorspace(ibuf, header.rect_colorspace);
+		}
+		if (ok && ibuf->rect_float) {
+			ok = seqcache_disk_decompress(rect_float_data, header.rect_float_len, ibuf->rect_float,
+			                              rect_float_len, (header.flag & DISK_CACHE_RECT_FLOAT_LZO) != 0);
+			IMB_colormanagement_assign_float_colorspace(ibuf, header.float_colorspace);
+		}
 
-		IMB_refImBuf(elem->ibuf);
-		return elem->ibuf;
+		if (!ok) {
+			IMB_freeImBuf(ibuf);
+			ibuf = NULL;
+		}
 	}
 
-	return NULL;
+	MEM_freeN(data);
+
+	return ibuf;
 }
 
-void BKE_sequencer_preprocessed_cache_put(const SeqRenderData *context, Sequence *seq, float cfra, eSeqStripElemIBuf type, ImBuf *ibuf)
+/* Files of a strip are removed when it changes. The version of the scene is incremented even
+ * when the disk cache isn't used, as files may be written later on from the same file. */
+void BKE_sequencer_cache_disk_cleanup_sequence(Scene *scene, Sequence *seq)
 {
-	SeqPreprocessCacheElem *elem;
+	char root[FILE_MAX], scene_dir[FILE_MAX], seq_dir[FILE_MAX];
+	Editing *ed = scene->ed;
+
+	if (ed == NULL) {
+		return;
+	}
+
+	BLI_mutex_lock(&disk_lock);
+
+	if (seqcache_disk_scene_dir_get(scene, root, scene_dir)) {
+		seqcache_disk_index_ensure(root);
+		seqcache_disk_scene_dir_verify(ed, scene_dir);
 
-	if (!preprocess_cache) {
-		preprocess_cache = MEM_callocN(sizeof(SeqPreprocessCache), "sequencer preprocessed cache");
+		seqcache_disk_sequence_dir_get(scene_dir, seq, seq_dir);
+		seqcache_disk_remove_dir(seq_dir);
+
+		seqcache_disk_version_bump(ed, scene_dir);
 	}
 	else {
-		if (preprocess_cache->cfra != cfra)
-			BKE_sequencer_preprocessed_cache_cleanup();
+		ed->disk_cache_version++;
+	}
+
+	BLI_mutex_unlock(&disk_lock);
+}
+
+void BKE_sequencer_cache_disk_cleanup(Scene *scene)
+{
+	char root[FILE_MAX], scene_dir[FILE_MAX];
+	Editing *ed = scene->ed;
+
+	if (ed == NULL) {
+		return;
 	}
 
-	elem = MEM_callocN(sizeof(SeqPreprocessCacheElem), "sequencer preprocessed cache element");
+	BLI_mutex_lock(&disk_lock);
+
+	if (seqcache_disk_scene_dir_get(scene, root, scene_dir)) {
+		seqcache_disk_index_ensure(root);
+		seqcache_disk_remove_dir(scene_dir);
 
-	elem->seq = seq;
-	elem->type = type;
-	elem->context = *context;
-	elem->ibuf = ibuf;
+		seqcache_disk_version_bump(ed, scene_dir);
+	}
+	else {
+		ed->disk_cache_version++;
+	}
 
-	preprocess_cache->cfra = cfra;
+	BLI_mutex_unlock(&disk_lock);
+}
 
-	IMB_refImBuf(ibuf);
+/* For changes which can affect any strip (animation, camera...) */
+void BKE_sequencer_cache_disk_cleanup_all(Main *bmain)
+{
+	Scene *scene;
 
-	BLI_addtail(&preprocess_cache->elems, elem);
+	for (scene = bmain->scene.first; scene; scene = scene->id.next) {
+		BKE_sequencer_cache_disk_cleanup(scene);
+	}
 }
 
-void BKE_sequencer_preprocessed_cache_cleanup_sequence(Sequence *seq)
+/* *************************** Public API *************************** */
+
+void BKE_sequencer_cache_destruct(void)
 {
-	SeqPreprocessCacheElem *elem, *elem_next;
+	BKE_sequencer_prefetch_free_all();
 
-	if (!preprocess_cache)
-		return;
+	seqcache_cleanup_ex(NULL, SEQ_CACHE_LEVEL_ALL);
+
+	BLI_mutex_lock(&cache_lock);
+	if (cache_hash) {
+		BLI_ghash_free(cache_hash, NULL, NULL);
+		cache_hash = NULL;
+	}
+	BLI_mutex_unlock(&cache_lock);
+
+	BLI_mutex_lock(&disk_lock);
+	seqcache_disk_index_free();
+	BLI_mutex_unlock(&disk_lock);
+}
+
+void BKE_sequencer_cache_cleanup(void)
+{
+	BKE_sequencer_prefetch_free_all();
+
+	seqcache_cleanup_ex(NULL, SEQ_CACHE_LEVEL_ALL);
+}
+
+void BKE_sequencer_cache_cleanup_sequence(Sequence *seq)
+{
+	seqcache_cleanup_ex(seq, SEQ_CACHE_LEVEL_NOT_RAW);
+}
 
-	for (elem = preprocess_cache->elems.first; elem; elem = elem_next) {
-		elem_next = elem->next;
+struct ImBuf *BKE_sequencer_cache_get(const SeqRenderData *context, Sequence *seq, float cfra, eSeqStripElemIBuf type)
+{
+	ImBuf *ibuf;
+	SeqCacheKey key;
+
+	if (seq == NULL) {
+		return NULL;
+	}
+
+	seqcache_key_init(&key, context, seq, cfra, type);
 
-		if (elem->seq == seq) {
-			IMB_freeImBuf(elem->ibuf);
+	ibuf = seqcache_memory_get(&key);
 
-			BLI_freelinkN(&preprocess_cache->elems, elem);
+	if (ibuf == NULL && seqcache_disk_use(&key)) {
+		ibuf = seqcache_disk_read(&key);
+
+		if (ibuf) {
+			seqcache_memory_put(&key, ibuf);
 		}
 	}
+
+	return ibuf;
+}
+
+void BKE_sequencer_cache_put(const SeqRenderData *context, Sequence *seq, float cfra, eSeqStripElemIBuf type, ImBuf *i)
+{
+	SeqCacheKey key;
+
+	if (i == NULL || context->skip_cache) {
+		return;
+	}
+
+	seqcache_key_init(&key, context, seq, cfra, type);
+
+	if (seqcache_memory_put(&key, i) && seqcache_disk_use(&key)) {
+		seqcache_disk_write(&key, i);
+	}
+}
+
+void BKE_sequencer_preprocessed_cache_cleanup(void)
+{
+	seqcache_cleanup_ex(NULL, 1 << SEQ_CACHE_LEVEL_RAW);
+}
+
+void BKE_sequencer_preprocessed_cache_cleanup_sequence(Sequence *seq)
+{
+	seqcache_cleanup_ex(seq, 1 << SEQ_CACHE_LEVEL_RAW);
 }
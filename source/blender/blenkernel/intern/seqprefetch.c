@@ -0,0 +1,490 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2018 Blender Foundation.
+ * All rights reserved.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenkernel/intern/seqprefetch.c
+ *  \ingroup bke
+ *
+ * Rendering of sequencer frames ahead of the playhead.
+ *
+ * During playback every displayed frame starts a background thread which renders the
+ * following frames (up to UserDef.prefetchframes) into the sequencer cache, so they are
+ * ready when playback reaches them.
+ *
+ * The thread never touches strips of the scene: it renders a copy of them, made on the
+ * main thread when prefetching starts, so it has its own animation handles and effect
+ * data. Frames are stored in the cache for the original strips. Any change to strips
+ * invalidates the cache, which also stops the thread and frees the copy.
+ *
+ * Scene, movie clip and text strips rely on data which can't be used outside of the main
+ * thread (render pipeline, clip cache, font cache), so edits using them are not prefetched.
+ * Only F-Curves of the scene action are evaluated for the copy, drivers and NLA are not.
+ */
+
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_anim_types.h"
+#include "DNA_scene_types.h"
+#include "DNA_sequence_types.h"
+#include "DNA_userdef_types.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_ghash.h"
+#include "BLI_listbase.h"
+#include "BLI_math_base.h"
+#include "BLI_threads.h"
+
+#include "BKE_animsys.h"
+#include "BKE_fcurve.h"
+#include "BKE_library.h"
+#include "BKE_sequencer.h"
+#include "BKE_sound.h"
+
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+
+#include "RNA_access.h"
+
+typedef struct SeqPrefetchJob {
+	struct SeqPrefetchJob *next, *prev;
+
+	/* Scene the frames are rendered for and its copy used by prefetch thread:
+	 * scene itself is only copied shallow, strips are duplicated. */
+	Scene *scene;
+	Scene *scene_copy;
+	/* copied strip -> original strip */
+	GHash *sequences;
+
+	/* displayed list of strips (could be inside of meta strip), original and copied one */
+	ListBase *seqbasep_orig;
+	ListBase *seqbasep;
+	int chanshown;
+	bool is_supported;
+
+	SeqRenderData context;
+
+	ListBase threads;
+	bool running;
+	bool stop;
+
+	ThreadMutex mutex;
+	ThreadCondition frame_done_cond;
+
+	/* continuous range of frames which are rendered */
+	float cfra_start, cfra_done;
+	/* frame being rendered by prefetch thread */
+	float cfra_rendering;
+	bool is_rendering;
+	/* last frame requested by playback */
+	float cfra_playhead;
+
+	SeqPrefetchStats stats;
+} SeqPrefetchJob;
+
+/* only accessed from main thread */
+static ListBase prefetch_jobs = {NULL, NULL};
+
+static SeqPrefetchJob *seq_prefetch_job_get(Scene *scene)
+{
+	SeqPrefetchJob *job;
+
+	for (job = prefetch_jobs.first; job; job = job->next) {
+		if (job->scene == scene) {
+			return job;
+		}
+	}
+
+	return NULL;
+}
+
+/* Masks are read from the original Mask data-block, which can be edited (and reloaded
+ * by RNA setters) while the prefetch thread renders, so strips using them aren't prefetched. */
+static bool seq_prefetch_uses_mask(Sequence *seq)
+{
+	SequenceModifierData *smd;
+
+	if (seq->type == SEQ_TYPE_MASK) {
+		return true;
+	}
+
+	for (smd = seq->modifiers.first; smd; smd = smd->next) {
+		if ((smd->mask_input_type == SEQUENCE_MASK_INPUT_ID) && smd->mask_id) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool seq_prefetch_is_supported(ListBase *seqbase)
+{
+	Sequence *seq;
+
+	for (seq = seqbase->first; seq; seq = seq->next) {
+		if (ELEM(seq->type, SEQ_TYPE_SCENE, SEQ_TYPE_MOVIECLIP, SEQ_TYPE_TEXT)) {
+			return false;
+		}
+		if (seq_prefetch_uses_mask(seq)) {
+			return false;
+		}
+		if (seq->type == SEQ_TYPE_META && !seq_prefetch_is_supported(&seq->seqbase)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void seq_prefetch_map_sequences(SeqPrefetchJob *job, ListBase *seqbase_orig, ListBase *seqbase)
+{
+	Sequence *seq_orig, *seq;
+
+	/* duplicated strips are in the same order as originals */
+	for (seq_orig = seqbase_orig->first, seq = seqbase->first;
+	     seq_orig && seq;
+	     seq_orig = seq_orig->next, seq = seq->next)
+	{
+		BLI_ghash_insert(job->sequences, seq, seq_orig);
+
+		/* duplicate is added to the sound scene of the original, copy is never played */
+		if (seq->scene_sound) {
+			BKE_sound_remove_scene_sound(job->scene_copy, seq->scene_sound);
+			seq->scene_sound = NULL;
+		}
+
+		if (seq->type == SEQ_TYPE_META) {
+			if (&seq_orig->seqbase == job->seqbasep_orig) {
+				job->seqbasep = &seq->seqbase;
+			}
+			seq_prefetch_map_sequences(job, &seq_orig->seqbase, &seq->seqbase);
+		}
+	}
+}
+
+static SeqPrefetchJob *seq_prefetch_job_create(const SeqRenderData *context, int chanshown)
+{
+	Scene *scene = context->scene;
+	Editing *ed = scene->ed;
+	Editing *ed_copy;
+	SeqPrefetchJob *job;
+
+	job = MEM_callocN(sizeof(SeqPrefetchJob), "sequencer prefetch job");
+
+	job->scene = scene;
+	job->scene_copy = MEM_dupallocN(scene);
+
+	ed_copy = job->scene_copy->ed = MEM_dupallocN(ed);
+	BLI_listbase_clear(&ed_copy->seqbase);
+	BLI_listbase_clear(&ed_copy->metastack);
+	ed_copy->seqbasep = &ed_copy->seqbase;
+	ed_copy->act_seq = NULL;
+
+	BKE_sequence_base_dupli_recursive(scene, job->scene_copy, &ed_copy->seqbase, &ed->seqbase,
+	                                  SEQ_DUPE_ALL, LIB_ID_CREATE_NO_USER_REFCOUNT);
+
+	job->sequences = BLI_ghash_ptr_new("sequencer prefetch sequences");
+	job->seqbasep_orig = ed->seqbasep;
+	if (ed->seqbasep == &ed->seqbase) {
+		job->seqbasep = &ed_copy->seqbase;
+	}
+	seq_prefetch_map_sequences(job, &ed->seqbase, &ed_copy->seqbase);
+
+	job->chanshown = chanshown;
+	job->is_supported = (job->seqbasep != NULL) && (chanshown >= 0) &&
+	                    seq_prefetch_is_supported(&ed_copy->seqbase);
+
+	job->context = *context;
+	job->context.scene = job->scene_copy;
+	job->context.skip_cache = false;
+	job->context.prefetch_job = job;
+
+	BLI_mutex_init(&job->mutex);
+	BLI_condition_init(&job->frame_done_cond);
+
+	BLI_addtail(&prefetch_jobs, job);
+
+	return job;
+}
+
+static bool seq_prefetch_job_matches(SeqPrefetchJob *job, const SeqRenderData *context, int chanshown)
+{
+	const SeqRenderData *job_context = &job->context;
+
+	return (job_context->bmain == context->bmain &&
+	        job_context->rectx == context->rectx &&
+	        job_context->recty == context->recty &&
+	        job_context->preview_render_size == context->preview_render_size &&
+	        job_context->motion_blur_samples == context->motion_blur_samples &&
+	        job_context->motion_blur_shutter == context->motion_blur_shutter &&
+	        job_context->view_id == context->view_id &&
+	        job->chanshown == chanshown &&
+	        job->seqbasep_orig == job->scene->ed->seqbasep);
+}
+
+static void seq_prefetch_thread_stop(SeqPrefetchJob *job)
+{
+	if (BLI_listbase_is_empty(&job->threads)) {
+		return;
+	}
+
+	BLI_mutex_lock(&job->mutex);
+	job->stop = true;
+	BLI_mutex_unlock(&job->mutex);
+
+	/* waits for the frame being rendered */
+	BLI_threadpool_end(&job->threads);
+
+	job->stop = false;
+	job->running = false;
+	job->is_rendering = false;
+}
+
+static void seq_prefetch_job_free(SeqPrefetchJob *job)
+{
+	seq_prefetch_thread_stop(job);
+
+	BKE_sequence_base_free_copy(&job->scene_copy->ed->seqbase);
+	MEM_freeN(job->scene_copy->ed);
+	MEM_freeN(job->scene_copy);
+
+	BLI_ghash_free(job->sequences, NULL, NULL);
+
+	BLI_mutex_end(&job->mutex);
+	BLI_condition_end(&job->frame_done_cond);
+
+	BLI_freelinkN(&prefetch_jobs, job);
+}
+
+/* Write animated values of strips to the copy, writing through RNA to the copied scene
+ * resolves paths to copied strips. */
+static void seq_prefetch_animation_evaluate(SeqPrefetchJob *job, float cfra)
+{
+	Scene *scene = job->scene_copy;
+	PointerRNA ptr;
+	FCurve *fcu;
+
+	if (scene->adt == NULL || scene->adt->action == NULL) {
+		return;
+	}
+
+	RNA_id_pointer_create(&scene->id, &ptr);
+
+	for (fcu = scene->adt->action->curves.first; fcu; fcu = fcu->next) {
+		if (fcu->rna_path == NULL || fcu->driver || (fcu->flag & (FCURVE_MUTED | FCURVE_DISABLED))) {
+			continue;
+		}
+		if (STRPREFIX(fcu->rna_path, "sequence_editor.")) {
+			BKE_animsys_execute_fcurve(&ptr, fcu, evaluate_fcurve(fcu, cfra));
+		}
+	}
+}
+
+static void *seq_prefetch_thread(void *job_v)
+{
+	SeqPrefetchJob *job = job_v;
+	Scene *scene = job->scene_copy;
+
+	while (true) {
+		ImBuf *ibuf;
+		float cfra;
+
+		BLI_mutex_lock(&job->mutex);
+
+		cfra = job->cfra_done + 1.0f;
+
+		if (job->stop || cfra > job->cfra_playhead + U.prefetchframes || cfra > PEFRA) {
+			job->running = false;
+			BLI_mutex_unlock(&job->mutex);
+			break;
+		}
+
+		job->cfra_rendering = cfra;
+		job->is_rendering = true;
+
+		BLI_mutex_unlock(&job->mutex);
+
+		seq_prefetch_animation_evaluate(job, cfra);
+
+		/* result is stored in the cache */
+		ibuf = BKE_sequencer_give_ibuf_seqbase(&job->context, cfra, job->chanshown, job->seqbasep);
+		if (ibuf) {
+			IMB_freeImBuf(ibuf);
+		}
+
+		BLI_mutex_lock(&job->mutex);
+
+		job->cfra_done = cfra;
+		job->is_rendering = false;
+		job->stats.lookahead = max_ii((int)(job->cfra_done - job->cfra_playhead), 0);
+
+		BLI_condition_notify_all(&job->frame_done_cond);
+		BLI_mutex_unlock(&job->mutex);
+	}
+
+	return NULL;
+}
+
+/* Render frames following cfra on a background thread, to be called after the frame was
+ * given to playback. */
+void BKE_sequencer_prefetch_start(const SeqRenderData *context, float cfra, int chanshown)
+{
+	Scene *scene = context->scene;
+	SeqPrefetchJob *job;
+	bool running;
+
+	if (U.prefetchframes <= 0 || scene->ed == NULL || context->prefetch_job || !BLI_thread_is_main()) {
+		return;
+	}
+
+	job = seq_prefetch_job_get(scene);
+
+	if (job && !seq_prefetch_job_matches(job, context, chanshown)) {
+		seq_prefetch_job_free(job);
+		job = NULL;
+	}
+
+	if (job == NULL) {
+		job = seq_prefetch_job_create(context, chanshown);
+		job->cfra_start = job->cfra_done = cfra;
+	}
+
+	if (!job->is_supported) {
+		return;
+	}
+
+	/* playhead moved out of the rendered range, start over from it */
+	if (cfra < job->cfra_start || cfra > job->cfra_done + 1.0f) {
+		seq_prefetch_thread_stop(job);
+		job->cfra_start = job->cfra_done = cfra;
+	}
+
+	BLI_mutex_lock(&job->mutex);
+
+	job->cfra_playhead = cfra;
+	job->cfra_done = max_ff(job->cfra_done, cfra);
+	job->stats.lookahead = (int)(job->cfra_done - cfra);
+	running = job->running;
+
+	BLI_mutex_unlock(&job->mutex);
+
+	if (!running && job->cfra_done < cfra + U.prefetchframes) {
+		/* thread of previous frame reached its lookahead and finished */
+		if (!BLI_listbase_is_empty(&job->threads)) {
+			BLI_threadpool_end(&job->threads);
+		}
+
+		job->running = true;
+
+		BLI_threadpool_init(&job->threads, seq_prefetch_thread, 1);
+		BLI_threadpool_insert(&job->threads, job);
+	}
+}
+
+/* Called by playback before rendering cfra: waits for prefetch thread when it's rendering
+ * the same frame, so it's not rendered twice. */
+void BKE_sequencer_prefetch_frame_request(const SeqRenderData *context, float cfra)
+{
+	SeqPrefetchJob *job;
+
+	if (!BLI_thread_is_main()) {
+		return;
+	}
+
+	job = seq_prefetch_job_get(context->scene);
+
+	if (job == NULL || !job->is_supported || !seq_prefetch_job_matches(job, context, job->chanshown)) {
+		return;
+	}
+
+	BLI_mutex_lock(&job->mutex);
+
+	while (job->is_rendering && job->cfra_rendering == cfra) {
+		BLI_condition_wait(&job->frame_done_cond, &job->mutex);
+	}
+
+	if (cfra > job->cfra_start && cfra <= job->cfra_done) {
+		job->stats.hits++;
+	}
+	else {
+		job->stats.misses++;
+	}
+
+	BLI_mutex_unlock(&job->mutex);
+}
+
+/* Stop prefetching for the scene and free copy of its strips, to be called when strips change. */
+void BKE_sequencer_prefetch_free(Scene *scene)
+{
+	SeqPrefetchJob *job;
+
+	/* strips of the copy are also invalidated when animation is written to them */
+	if (!BLI_thread_is_main()) {
+		return;
+	}
+
+	job = seq_prefetch_job_get(scene);
+
+	if (job) {
+		seq_prefetch_job_free(job);
+	}
+}
+
+void BKE_sequencer_prefetch_free_all(void)
+{
+	if (!BLI_thread_is_main()) {
+		return;
+	}
+
+	while (prefetch_jobs.first) {
+		seq_prefetch_job_free(prefetch_jobs.first);
+	}
+}
+
+void BKE_sequencer_prefetch_stats_get(Scene *scene, SeqPrefetchStats *r_stats)
+{
+	SeqPrefetchJob *job = seq_prefetch_job_get(scene);
+
+	if (job) {
+		BLI_mutex_lock(&job->mutex);
+		*r_stats = job->stats;
+		BLI_mutex_unlock(&job->mutex);
+	}
+	else {
+		memset(r_stats, 0, sizeof(*r_stats));
+	}
+}
+
+/* Original strip and scene of a strip rendered by prefetch thread, used for cache keys. */
+void BKE_sequencer_prefetch_original_get(const SeqRenderData *context, Sequence **r_seq, Scene **r_scene)
+{
+	SeqPrefetchJob *job = context->prefetch_job;
+	Sequence *seq_orig = BLI_ghash_lookup(job->sequences, *r_seq);
+
+	BLI_assert(seq_orig != NULL);
+
+	if (seq_orig) {
+		*r_seq = seq_orig;
+	}
+	*r_scene = job->scene;
+}
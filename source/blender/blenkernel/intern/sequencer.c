@@ -905,7 +905,7 @@ void BKE_sequence_reload_new_file(Scene *scene, Sequence *seq, const bool lock_r
 						char str[FILE_MAX];
 
 						seq_multiview_name(scene, i, prefix, ext, str, FILE_MAX);
-						anim = openanim(str, IB_rect | ((seq->flag & SEQ_FILTERY) ? IB_animdeinterlace : 0),
+						anim = openanim(str, IB_rect | IB_animdecodeahead | ((seq->flag & SEQ_FILTERY) ? IB_animdeinterlace : 0),
 						                seq->streamindex, seq->strip->colorspace_settings.name);
 
 						if (anim) {
@@ -921,7 +921,7 @@ void BKE_sequence_reload_new_file(Scene *scene, Sequence *seq, const bool lock_r
 
 			if (is_multiview_loaded == false) {
 				struct anim *anim;
-				anim = openanim(path, IB_rect | ((seq->flag & SEQ_FILTERY) ? IB_animdeinterlace : 0),
+				anim = openanim(path, IB_rect | IB_animdecodeahead | ((seq->flag & SEQ_FILTERY) ? IB_animdeinterlace : 0),
 				                seq->streamindex, seq->strip->colorspace_settings.name);
 				if (anim) {
 					sanim = MEM_mallocN(sizeof(StripAnim), "Strip Anim");
@@ -1575,12 +1575,12 @@ static void seq_open_anim_file(Scene *scene, Sequence *seq, bool openfile)
 
 				if (openfile) {
 					sanim->anim = openanim(
-					        str, IB_rect | ((seq->flag & SEQ_FILTERY) ? IB_animdeinterlace : 0),
+					        str, IB_rect | IB_animdecodeahead | ((seq->flag & SEQ_FILTERY) ? IB_animdeinterlace : 0),
 					        seq->streamindex, seq->strip->colorspace_settings.name);
 				}
 				else {
 					sanim->anim = openanim_noload(
-					        str, IB_rect | ((seq->flag & SEQ_FILTERY) ? IB_animdeinterlace : 0),
+					        str, IB_rect | IB_animdecodeahead | ((seq->flag & SEQ_FILTERY) ? IB_animdeinterlace : 0),
 					        seq->streamindex, seq->strip->colorspace_settings.name);
 				}
 
@@ -1591,12 +1591,12 @@ static void seq_open_anim_file(Scene *scene, Sequence *seq, bool openfile)
 				else {
 					if (openfile) {
 						sanim->anim = openanim(
-						        name, IB_rect | ((seq->flag & SEQ_FILTERY) ? IB_animdeinterlace : 0),
+						        name, IB_rect | IB_animdecodeahead | ((seq->flag & SEQ_FILTERY) ? IB_animdeinterlace : 0),
 						        seq->streamindex, seq->strip->colorspace_settings.name);
 					}
 					else {
 						sanim->anim = openanim_noload(
-						        name, IB_rect | ((seq->flag & SEQ_FILTERY) ? IB_animdeinterlace : 0),
+						        name, IB_rect | IB_animdecodeahead | ((seq->flag & SEQ_FILTERY) ? IB_animdeinterlace : 0),
 						        seq->streamindex, seq->strip->colorspace_settings.name);
 					}
 
@@ -1620,12 +1620,12 @@ static void seq_open_anim_file(Scene *scene, Sequence *seq, bool openfile)
 
 		if (openfile) {
 			sanim->anim = openanim(
-			        name, IB_rect | ((seq->flag & SEQ_FILTERY) ? IB_animdeinterlace : 0),
+			        name, IB_rect | IB_animdecodeahead | ((seq->flag & SEQ_FILTERY) ? IB_animdeinterlace : 0),
 			        seq->streamindex, seq->strip->colorspace_settings.name);
 		}
 		else {
 			sanim->anim = openanim_noload(
-			        name, IB_rect | ((seq->flag & SEQ_FILTERY) ? IB_animdeinterlace : 0),
+			        name, IB_rect | IB_animdecodeahead | ((seq->flag & SEQ_FILTERY) ? IB_animdeinterlace : 0),
 			        seq->streamindex, seq->strip->colorspace_settings.name);
 		}
 
@@ -3608,7 +3608,7 @@ static ImBuf *seq_render_strip(
 		ibuf = copy_from_ibuf_still(context, seq, nr);
 
 		if (ibuf == NULL) {
-			ibuf = BKE_sequencer_preprocessed_cache_get(context, seq, cfra, SEQ_STRIPELEM_IBUF);
+			ibuf = BKE_sequencer_cache_get(context, seq, cfra, SEQ_STRIPELEM_IBUF_RAW);
 
 			if (ibuf == NULL) {
 				/* MOVIECLIPs have their own proxy management */
@@ -3624,7 +3624,7 @@ static ImBuf *seq_render_strip(
 					if (ELEM(seq->type, SEQ_TYPE_MOVIE, SEQ_TYPE_MOVIECLIP)) {
 						is_proxy_image = (context->preview_render_size != 100);
 					}
-					BKE_sequencer_preprocessed_cache_put(context, seq, cfra, SEQ_STRIPELEM_IBUF, ibuf);
+					BKE_sequencer_cache_put(context, seq, cfra, SEQ_STRIPELEM_IBUF_RAW, ibuf);
 				}
 			}
 		}
@@ -3872,6 +3872,9 @@ ImBuf *BKE_sequencer_give_ibuf(const SeqRenderData *context, float cfra, int cha
 {
 	Editing *ed = BKE_sequencer_editing_get(context->scene, false);
 	ListBase *seqbasep;
+	Sequence *seq_arr[MAXSEQ + 1];
+	ImBuf *out;
+	int seq_count;
 
 	if (ed == NULL) return NULL;
 
@@ -3884,10 +3887,24 @@ ImBuf *BKE_sequencer_give_ibuf(const SeqRenderData *context, float cfra, int cha
 		seqbasep = ed->seqbasep;
 	}
 
-	SeqRenderState state;
-	sequencer_state_init(&state);
+	seq_count = get_shown_sequences(seqbasep, cfra, chanshown, seq_arr);
 
-	return seq_render_strip_stack(context, &state, seqbasep, cfra, chanshown);
+	if (seq_count == 0) {
+		return NULL;
+	}
+
+	out = BKE_sequencer_cache_get(context, seq_arr[seq_count - 1], cfra, SEQ_STRIPELEM_IBUF_FINAL);
+
+	if (out == NULL) {
+		SeqRenderState state;
+		sequencer_state_init(&state);
+
+		out = seq_render_strip_stack(context, &state, seqbasep, cfra, chanshown);
+
+		BKE_sequencer_cache_put(context, seq_arr[seq_count - 1], cfra, SEQ_STRIPELEM_IBUF_FINAL, out);
+	}
+
+	return out;
 }
 
 ImBuf *BKE_sequencer_give_ibuf_seqbase(const SeqRenderData *context, float cfra, int chanshown, ListBase *seqbasep)
@@ -3907,156 +3924,19 @@ ImBuf *BKE_sequencer_give_ibuf_direct(const SeqRenderData *context, float cfra,
 	return seq_render_strip(context, &state, seq, cfra);
 }
 
-/* *********************** threading api ******************* */
-
-static ListBase running_threads;
-static ListBase prefetch_wait;
-static ListBase prefetch_done;
-
-static pthread_mutex_t queue_lock          = PTHREAD_MUTEX_INITIALIZER;
-static pthread_mutex_t wakeup_lock         = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t wakeup_cond          = PTHREAD_COND_INITIALIZER;
-
-//static pthread_mutex_t prefetch_ready_lock = PTHREAD_MUTEX_INITIALIZER;
-//static pthread_cond_t  prefetch_ready_cond = PTHREAD_COND_INITIALIZER;
-
-static pthread_mutex_t frame_done_lock     = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t frame_done_cond      = PTHREAD_COND_INITIALIZER;
-
-static volatile bool seq_thread_shutdown = true;
-static volatile int seq_last_given_monoton_cfra = 0;
-static int monoton_cfra = 0;
-
-typedef struct PrefetchThread {
-	struct PrefetchThread *next, *prev;
-
-	Scene *scene;
-	struct PrefetchQueueElem *current;
-	pthread_t pthread;
-	int running;
-
-} PrefetchThread;
-
-typedef struct PrefetchQueueElem {
-	struct PrefetchQueueElem *next, *prev;
-
-	int rectx;
-	int recty;
-	float cfra;
-	int chanshown;
-	int preview_render_size;
-
-	int monoton_cfra;
-
-	ImBuf *ibuf;
-} PrefetchQueueElem;
-
-void BKE_sequencer_give_ibuf_prefetch_request(const SeqRenderData *context, float cfra, int chanshown)
-{
-	PrefetchQueueElem *e;
-	if (seq_thread_shutdown) {
-		return;
-	}
-
-	e = MEM_callocN(sizeof(PrefetchQueueElem), "prefetch_queue_elem");
-	e->rectx = context->rectx;
-	e->recty = context->recty;
-	e->cfra = cfra;
-	e->chanshown = chanshown;
-	e->preview_render_size = context->preview_render_size;
-	e->monoton_cfra = monoton_cfra++;
-
-	pthread_mutex_lock(&queue_lock);
-	BLI_addtail(&prefetch_wait, e);
-	pthread_mutex_unlock(&queue_lock);
-
-	pthread_mutex_lock(&wakeup_lock);
-	pthread_cond_signal(&wakeup_cond);
-	pthread_mutex_unlock(&wakeup_lock);
-}
-
+/* Same as BKE_sequencer_give_ibuf, used by playback: frames following the requested one
+ * are rendered ahead on a background thread, see seqprefetch.c */
 ImBuf *BKE_sequencer_give_ibuf_threaded(const SeqRenderData *context, float cfra, int chanshown)
 {
-	PrefetchQueueElem *e = NULL;
-	bool found_something = false;
-
-	if (seq_thread_shutdown) {
-		return BKE_sequencer_give_ibuf(context, cfra, chanshown);
-	}
-
-	while (!e) {
-		bool success = false;
-		pthread_mutex_lock(&queue_lock);
-
-		for (e = prefetch_done.first; e; e = e->next) {
-			if (cfra == e->cfra &&
-			    chanshown == e->chanshown &&
-			    context->rectx == e->rectx &&
-			    context->recty == e->recty &&
-			    context->preview_render_size == e->preview_render_size)
-			{
-				success = true;
-				found_something = true;
-				break;
-			}
-		}
-
-		if (!e) {
-			for (e = prefetch_wait.first; e; e = e->next) {
-				if (cfra == e->cfra &&
-				    chanshown == e->chanshown &&
-				    context->rectx == e->rectx &&
-				    context->recty == e->recty &&
-				    context->preview_render_size == e->preview_render_size)
-				{
-					found_something = true;
-					break;
-				}
-			}
-		}
-
-		if (!e) {
-			PrefetchThread *tslot;
-
-			for (tslot = running_threads.first;
-			     tslot;
-			     tslot = tslot->next)
-			{
-				if (tslot->current &&
-				    cfra == tslot->current->cfra &&
-				    chanshown == tslot->current->chanshown &&
-				    context->rectx == tslot->current->rectx &&
-				    context->recty == tslot->current->recty &&
-				    context->preview_render_size == tslot->current->preview_render_size)
-				{
-					found_something = true;
-					break;
-				}
-			}
-		}
-
-		/* e->ibuf is unrefed by render thread on next round. */
-
-		if (e) {
-			seq_last_given_monoton_cfra = e->monoton_cfra;
-		}
+	ImBuf *ibuf;
 
-		pthread_mutex_unlock(&queue_lock);
+	BKE_sequencer_prefetch_frame_request(context, cfra);
 
-		if (!success) {
-			e = NULL;
+	ibuf = BKE_sequencer_give_ibuf(context, cfra, chanshown);
 
-			if (!found_something) {
-				fprintf(stderr, "SEQ-THREAD: Requested frame not in queue ???\n");
-				break;
-			}
-			pthread_mutex_lock(&frame_done_lock);
-			pthread_cond_wait(&frame_done_cond, &frame_done_lock);
-			pthread_mutex_unlock(&frame_done_lock);
-		}
-	}
+	BKE_sequencer_prefetch_start(context, cfra, chanshown);
 
-	return e ? e->ibuf : NULL;
+	return ibuf;
 }
 
 /* check whether sequence cur depends on seq */
@@ -4086,7 +3966,7 @@ bool BKE_sequence_check_depend(Sequence *seq, Sequence *cur)
 	return true;
 }
 
-static void sequence_do_invalidate_dependent(Sequence *seq, ListBase *seqbase)
+static void sequence_do_invalidate_dependent(Scene *scene, Sequence *seq, ListBase *seqbase)
 {
 	Sequence *cur;
 
@@ -4097,10 +3977,11 @@ static void sequence_do_invalidate_dependent(Sequence *seq, ListBase *seqbase)
 		if (BKE_sequence_check_depend(seq, cur)) {
 			BKE_sequencer_cache_cleanup_sequence(cur);
 			BKE_sequencer_preprocessed_cache_cleanup_sequence(cur);
+			BKE_sequencer_cache_disk_cleanup_sequence(scene, cur);
 		}
 
 		if (cur->seqbase.first)
-			sequence_do_invalidate_dependent(seq, &cur->seqbase);
+			sequence_do_invalidate_dependent(scene, seq, &cur->seqbase);
 	}
 }
 
@@ -4108,6 +3989,9 @@ static void sequence_invalidate_cache(Scene *scene, Sequence *seq, bool invalida
 {
 	Editing *ed = scene->ed;
 
+	/* frames rendered ahead are using copy of strips from before the change */
+	BKE_sequencer_prefetch_free(scene);
+
 	/* invalidate cache for current sequence */
 	if (invalidate_self) {
 		/* Animation structure holds some buffers inside,
@@ -4118,6 +4002,9 @@ static void sequence_invalidate_cache(Scene *scene, Sequence *seq, bool invalida
 		BKE_sequencer_cache_cleanup_sequence(seq);
 	}
 
+	/* images of the strip stored on disk were rendered before the change */
+	BKE_sequencer_cache_disk_cleanup_sequence(scene, seq);
+
 	/* if invalidation is invoked from sequence free routine, effectdata would be NULL here */
 	if (seq->effectdata && seq->type == SEQ_TYPE_SPEED)
 		BKE_sequence_effect_speed_rebuild_map(scene, seq, true);
@@ -4130,7 +4017,7 @@ static void sequence_invalidate_cache(Scene *scene, Sequence *seq, bool invalida
 	/* NOTE: can not use SEQ_BEGIN/SEQ_END here because that macro will change sequence's depth,
 	 *       which makes transformation routines work incorrect
 	 */
-	sequence_do_invalidate_dependent(seq, &ed->seqbase);
+	sequence_do_invalidate_dependent(scene, seq, &ed->seqbase);
 }
 
 void BKE_sequence_invalidate_cache(Scene *scene, Sequence *seq)
@@ -5620,6 +5507,19 @@ void BKE_sequence_base_dupli_recursive(
 	}
 }
 
+/* Free strips duplicated out of any scene (with LIB_ID_CREATE_NO_USER_REFCOUNT
+ * and with sound handles removed), such as copies used by background jobs. */
+void BKE_sequence_base_free_copy(ListBase *seqbase)
+{
+	Sequence *seq, *seq_next;
+
+	for (seq = seqbase->first; seq; seq = seq_next) {
+		seq_next = seq->next;
+		seq_free_sequence_recurse(NULL, seq, false);
+	}
+	BLI_listbase_clear(seqbase);
+}
+
 /* called on draw, needs to be fast,
  * we could cache and use a flag if we want to make checks for file paths resolving for eg. */
 bool BKE_sequence_is_valid_check(Sequence *seq)
@@ -69,7 +69,9 @@
 #include "BLI_utildefines.h"
 #include "BLI_listbase.h"
 #include "BLI_ghash.h"
-#include "BLI_threads.h"
+#include "BLI_buffer.h"
+#include "BLI_kdopbvh.h"
+#include "BLI_task.h"
 
 #include "BKE_collection.h"
 #include "BKE_collision.h"
@@ -110,6 +112,7 @@ typedef struct BodySpring {
 typedef struct BodyFace {
 	int v1, v2, v3;
 	float ext_force[3]; /* faces colliding */
+	float damp;         /* damping of the collision, with BFF_INTERSECT or BFF_CLOSEVERT */
 	short flag;
 } BodyFace;
 
@@ -140,14 +143,11 @@ typedef struct  SB_thread_context {
 		Object *ob;
 		float forcetime;
 		float timenow;
-		int ifirst;
-		int ilast;
-		ListBase *effectors;
+		float (*eff_force)[3];
+		float (*eff_speed)[3];
 		int do_deflector;
 		float fieldfactor;
 		float windfactor;
-		int nr;
-		int tot;
 } SB_thread_context;
 
 #define MID_PRESERVE 1
@@ -285,8 +285,103 @@ typedef struct ccd_Mesh {
 	/* Axis Aligned Bounding Box AABB */
 	float bbmin[3];
 	float bbmax[3];
+	/* trees over the mima boxes of the triangles and over the vertices (current and previous position) */
+	BVHTree *bvhtree;
+	BVHTree *bvhtree_verts;
 } ccd_Mesh;
 
+/* insert or update the leafs of the ccd_Mesh trees */
+static void ccd_mesh_bvh_update(ccd_Mesh *pccd_M, bool update)
+{
+	const ccdf_minmax *mima;
+	int i;
+
+	for (i = 0, mima = pccd_M->mima; i < pccd_M->tri_num; i++, mima++) {
+		const float co[2][3] = {
+		    {mima->minx, mima->miny, mima->minz},
+		    {mima->maxx, mima->maxy, mima->maxz},
+		};
+
+		if (update) BLI_bvhtree_update_node(pccd_M->bvhtree, i, co[0], NULL, 2);
+		else        BLI_bvhtree_insert(pccd_M->bvhtree, i, co[0], 2);
+	}
+
+	for (i = 0; i < pccd_M->mvert_num; i++) {
+		const float *co_prev = pccd_M->mprevvert ? pccd_M->mprevvert[i].co : NULL;
+
+		if (update) BLI_bvhtree_update_node(pccd_M->bvhtree_verts, i, pccd_M->mvert[i].co, co_prev, 1);
+		else        BLI_bvhtree_insert(pccd_M->bvhtree_verts, i, pccd_M->mvert[i].co, 1);
+	}
+
+	if (update) {
+		BLI_bvhtree_update_tree(pccd_M->bvhtree);
+		BLI_bvhtree_update_tree(pccd_M->bvhtree_verts);
+	}
+	else {
+		BLI_bvhtree_balance(pccd_M->bvhtree);
+		BLI_bvhtree_balance(pccd_M->bvhtree_verts);
+	}
+}
+
+typedef struct ccd_BVHQuery {
+	float min[3], max[3];
+	BLI_Buffer *indices;
+} ccd_BVHQuery;
+
+static bool ccd_bvh_overlap(const BVHTreeAxisRange *bounds, const ccd_BVHQuery *query)
+{
+	return !((query->max[0] < bounds[0].min) || (query->min[0] > bounds[0].max) ||
+	         (query->max[1] < bounds[1].min) || (query->min[1] > bounds[1].max) ||
+	         (query->max[2] < bounds[2].min) || (query->min[2] > bounds[2].max));
+}
+
+static bool ccd_bvh_walk_parent_cb(const BVHTreeAxisRange *bounds, void *userdata)
+{
+	return ccd_bvh_overlap(bounds, userdata);
+}
+
+static bool ccd_bvh_walk_leaf_cb(const BVHTreeAxisRange *bounds, int index, void *userdata)
+{
+	ccd_BVHQuery *query = userdata;
+
+	if (ccd_bvh_overlap(bounds, query)) {
+		BLI_buffer_append(query->indices, int, index);
+	}
+	return true;
+}
+
+static bool ccd_bvh_walk_order_cb(const BVHTreeAxisRange *UNUSED(bounds), char UNUSED(axis), void *UNUSED(userdata))
+{
+	return true;
+}
+
+static int ccd_index_cmp(const void *a, const void *b)
+{
+	const int i1 = *(const int *)a, i2 = *(const int *)b;
+	return (i1 > i2) - (i1 < i2);
+}
+
+/**
+ * Fills \a r_indices with the leafs of \a tree whose bounds overlap the box \a min, \a max.
+ * They are sorted ascending, so callers visit them in the same order as a linear scan did,
+ * damping and velocity of the last hit win there.
+ */
+static void ccd_mesh_query(BVHTree *tree, const float min[3], const float max[3], BLI_Buffer *r_indices)
+{
+	ccd_BVHQuery query;
+
+	copy_v3_v3(query.min, min);
+	copy_v3_v3(query.max, max);
+	query.indices = r_indices;
+
+	BLI_buffer_clear(r_indices);
+	BLI_bvhtree_walk_dfs(tree, ccd_bvh_walk_parent_cb, ccd_bvh_walk_leaf_cb, ccd_bvh_walk_order_cb, &query);
+
+	if (r_indices->count > 1) {
+		qsort(r_indices->data, r_indices->count, sizeof(int), ccd_index_cmp);
+	}
+}
+
 
 static ccd_Mesh *ccd_mesh_make(Object *ob)
 {
@@ -371,6 +466,10 @@ static ccd_Mesh *ccd_mesh_make(Object *ob)
 		mima->maxz = max_ff(mima->maxz, v[2] + hull);
 	}
 
+	pccd_M->bvhtree = BLI_bvhtree_new(pccd_M->tri_num, 0.0f, 4, 6);
+	pccd_M->bvhtree_verts = BLI_bvhtree_new(pccd_M->mvert_num, 0.0f, 4, 6);
+	ccd_mesh_bvh_update(pccd_M, false);
+
 	return pccd_M;
 }
 static void ccd_mesh_update(Object *ob, ccd_Mesh *pccd_M)
@@ -490,6 +589,8 @@ static void ccd_mesh_update(Object *ob, ccd_Mesh *pccd_M)
 		mima->maxy = max_ff(mima->maxy, v[1] + hull);
 		mima->maxz = max_ff(mima->maxz, v[2] + hull);
 	}
+
+	ccd_mesh_bvh_update(pccd_M, true);
 	return;
 }
 
@@ -500,6 +601,8 @@ static void ccd_mesh_free(ccd_Mesh *ccdm)
 		MEM_freeN((void *)ccdm->tri);
 		if (ccdm->mprevvert) MEM_freeN((void *)ccdm->mprevvert);
 		MEM_freeN(ccdm->mima);
+		BLI_bvhtree_free(ccdm->bvhtree);
+		BLI_bvhtree_free(ccdm->bvhtree_verts);
 		MEM_freeN(ccdm);
 		ccdm = NULL;
 	}
@@ -1035,9 +1138,10 @@ static int sb_detect_face_pointCached(float face_v1[3], float face_v2[3], float
 	Object *ob;
 	GHash *hash;
 	GHashIterator *ihash;
-	float nv1[3], edge1[3], edge2[3], d_nvect[3], aabbmin[3], aabbmax[3];
+	float nv1[3], edge1[3], edge2[3], d_nvect[3], d_nvect_len, aabbmin[3], aabbmax[3];
 	float facedist, outerfacethickness, tune = 10.f;
 	int a, deflected=0;
+	BLI_buffer_declare_static(int, indices, BLI_BUFFER_NOP, 64);
 
 	aabbmin[0] = min_fff(face_v1[0], face_v2[0], face_v3[0]);
 	aabbmin[1] = min_fff(face_v1[1], face_v2[1], face_v3[1]);
@@ -1050,7 +1154,7 @@ static int sb_detect_face_pointCached(float face_v1[3], float face_v2[3], float
 	sub_v3_v3v3(edge1, face_v1, face_v2);
 	sub_v3_v3v3(edge2, face_v3, face_v2);
 	cross_v3_v3v3(d_nvect, edge2, edge1);
-	normalize_v3(d_nvect);
+	d_nvect_len = normalize_v3(d_nvect);
 
 
 	hash  = vertexowner->soft->scratch->colliderhash;
@@ -1092,7 +1196,33 @@ static int sb_detect_face_pointCached(float face_v1[3], float face_v2[3], float
 
 				/* use mesh*/
 				if (mvert) {
-					while (a) {
+					/* Only vertices close to the face can deflect it. The prism test below is done
+					 * with the vertex relative to face_v2, so the face is offset by the in-plane part
+					 * of face_v2 and padded by outerfacethickness along the normal (plus some slack
+					 * for rounding). */
+					float qmin[3], qmax[3], offset[3];
+					int i;
+
+					if (d_nvect_len != 0.0f) {
+						const float margin = outerfacethickness + 1e-5f * (1.0f + len_v3(face_v2) + len_v3v3(aabbmin, aabbmax));
+
+						project_plane_normalized_v3_v3v3(offset, face_v2, d_nvect);
+						add_v3_v3v3(qmin, aabbmin, offset);
+						add_v3_v3v3(qmax, aabbmax, offset);
+						add_v3_fl(qmin, -margin);
+						add_v3_fl(qmax, margin);
+					}
+					else {
+						/* degenerate face, no bounds */
+						copy_v3_fl(qmin, -FLT_MAX);
+						copy_v3_fl(qmax, FLT_MAX);
+					}
+					ccd_mesh_query(ccdm->bvhtree_verts, qmin, qmax, &indices);
+
+					/* visit in descending order like the former scan over all vertices */
+					for (i = (int)indices.count; i--; ) {
+						a = BLI_buffer_at(&indices, int, i) + 1;
+
 						copy_v3_v3(nv1, mvert[a-1].co);
 						if (mprevvert) {
 							mul_v3_fl(nv1, time);
@@ -1118,14 +1248,14 @@ static int sb_detect_face_pointCached(float face_v1[3], float face_v2[3], float
 								deflected = 3;
 							}
 						}
-						a--;
-					}/* while (a)*/
+					}/* for (i)*/
 				} /* if (mvert) */
 			} /* if (ob->pd && ob->pd->deflect) */
 			BLI_ghashIterator_step(ihash);
 		}
 	} /* while () */
 	BLI_ghashIterator_free(ihash);
+	BLI_buffer_free(&indices);
 	return deflected;
 }
 
@@ -1138,7 +1268,8 @@ static int sb_detect_face_collisionCached(float face_v1[3], float face_v2[3], fl
 	GHashIterator *ihash;
 	float nv1[3], nv2[3], nv3[3], edge1[3], edge2[3], d_nvect[3], aabbmin[3], aabbmax[3];
 	float t, tune = 10.0f;
-	int a, deflected=0;
+	int i, deflected=0;
+	BLI_buffer_declare_static(int, indices, BLI_BUFFER_NOP, 64);
 
 	aabbmin[0] = min_fff(face_v1[0], face_v2[0], face_v3[0]);
 	aabbmin[1] = min_fff(face_v1[1], face_v2[1], face_v3[1]);
@@ -1159,14 +1290,10 @@ static int sb_detect_face_collisionCached(float face_v1[3], float face_v2[3], fl
 				const MVert *mvert = NULL;
 				const MVert *mprevvert = NULL;
 				const MVertTri *vt = NULL;
-				const ccdf_minmax *mima = NULL;
 
 				if (ccdm) {
 					mvert = ccdm->mvert;
-					vt = ccdm->tri;
 					mprevvert = ccdm->mprevvert;
-					mima = ccdm->mima;
-					a = ccdm->tri_num;
 
 					if ((aabbmax[0] < ccdm->bbmin[0]) ||
 					    (aabbmax[1] < ccdm->bbmin[1]) ||
@@ -1189,19 +1316,10 @@ static int sb_detect_face_collisionCached(float face_v1[3], float face_v2[3], fl
 				}
 
 
-				/* use mesh*/
-				while (a--) {
-					if ((aabbmax[0] < mima->minx) ||
-					    (aabbmin[0] > mima->maxx) ||
-					    (aabbmax[1] < mima->miny) ||
-					    (aabbmin[1] > mima->maxy) ||
-					    (aabbmax[2] < mima->minz) ||
-					    (aabbmin[2] > mima->maxz))
-					{
-						mima++;
-						vt++;
-						continue;
-					}
+				/* use mesh, the query tests the mima boxes of the triangles */
+				ccd_mesh_query(ccdm->bvhtree, aabbmin, aabbmax, &indices);
+				for (i = 0; i < (int)indices.count; i++) {
+					vt = &ccdm->tri[BLI_buffer_at(&indices, int, i)];
 
 
 					if (mvert) {
@@ -1235,68 +1353,89 @@ static int sb_detect_face_collisionCached(float face_v1[3], float face_v2[3], fl
 						*damp=tune*ob->pd->pdef_sbdamp;
 						deflected = 2;
 					}
-					mima++;
-					vt++;
-				}/* while a */
+				}/* for (i) */
 			} /* if (ob->pd && ob->pd->deflect) */
 			BLI_ghashIterator_step(ihash);
 		}
 	} /* while () */
 	BLI_ghashIterator_free(ihash);
+	BLI_buffer_free(&indices);
 	return deflected;
 }
 
 
 
+static void scan_for_ext_face_forces_cb(
+        void *__restrict userdata,
+        const int a,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	SB_thread_context *pctx = userdata;
+	Object *ob = pctx->ob;
+	SoftBody *sb = ob->soft;
+	BodyFace *bf = &sb->scratch->bodyface[a];
+
+	/* only detect here, the forces are added to the body points in face order afterwards */
+	bf->ext_force[0]=bf->ext_force[1]=bf->ext_force[2]=0.0f;
+/*+++edges intruding*/
+	bf->flag &= ~BFF_INTERSECT;
+	if (sb_detect_face_collisionCached(
+	        sb->bpoint[bf->v1].pos, sb->bpoint[bf->v2].pos, sb->bpoint[bf->v3].pos,
+	        &bf->damp, bf->ext_force, ob, pctx->timenow))
+	{
+		bf->flag |= BFF_INTERSECT;
+	}
+/*---edges intruding*/
+
+/*+++ close vertices*/
+	if (( bf->flag & BFF_INTERSECT)==0) {
+		bf->flag &= ~BFF_CLOSEVERT;
+		if (sb_detect_face_pointCached(
+		        sb->bpoint[bf->v1].pos, sb->bpoint[bf->v2].pos, sb->bpoint[bf->v3].pos,
+		        &bf->damp, bf->ext_force, ob, pctx->timenow))
+		{
+			bf->flag |= BFF_CLOSEVERT;
+		}
+	}
+/*--- close vertices*/
+}
+
 static void scan_for_ext_face_forces(Object *ob, float timenow)
 {
 	SoftBody *sb = ob->soft;
 	BodyFace *bf;
 	int a;
-	float damp=0.0f, choke=1.0f;
+	float choke=1.0f;
 	float tune = -10.0f;
-	float feedback[3];
 
 	if (sb && sb->scratch->totface) {
+		SB_thread_context ctx = {NULL};
+		ParallelRangeSettings settings;
 
+		ctx.ob = ob;
+		ctx.timenow = timenow;
+
+		BLI_parallel_range_settings_defaults(&settings);
+		settings.min_iter_per_thread = 100;
+		BLI_task_parallel_range(0, sb->scratch->totface, &ctx, scan_for_ext_face_forces_cb, &settings);
 
 		bf = sb->scratch->bodyface;
 		for (a=0; a<sb->scratch->totface; a++, bf++) {
-			bf->ext_force[0]=bf->ext_force[1]=bf->ext_force[2]=0.0f;
-/*+++edges intruding*/
-			bf->flag &= ~BFF_INTERSECT;
-			zero_v3(feedback);
-			if (sb_detect_face_collisionCached(
-			        sb->bpoint[bf->v1].pos, sb->bpoint[bf->v2].pos, sb->bpoint[bf->v3].pos,
-			        &damp, feedback, ob, timenow))
-			{
-				madd_v3_v3fl(sb->bpoint[bf->v1].force, feedback, tune);
-				madd_v3_v3fl(sb->bpoint[bf->v2].force, feedback, tune);
-				madd_v3_v3fl(sb->bpoint[bf->v3].force, feedback, tune);
-//				madd_v3_v3fl(bf->ext_force, feedback, tune);
-				bf->flag |= BFF_INTERSECT;
-				choke = min_ff(max_ff(damp, choke), 1.0f);
+			if (bf->flag & BFF_INTERSECT) {
+				madd_v3_v3fl(sb->bpoint[bf->v1].force, bf->ext_force, tune);
+				madd_v3_v3fl(sb->bpoint[bf->v2].force, bf->ext_force, tune);
+				madd_v3_v3fl(sb->bpoint[bf->v3].force, bf->ext_force, tune);
+				choke = min_ff(max_ff(bf->damp, choke), 1.0f);
 			}
-/*---edges intruding*/
-
-/*+++ close vertices*/
-			if (( bf->flag & BFF_INTERSECT)==0) {
-				bf->flag &= ~BFF_CLOSEVERT;
+			else {
 				tune = -1.0f;
-				zero_v3(feedback);
-				if (sb_detect_face_pointCached(
-				        sb->bpoint[bf->v1].pos, sb->bpoint[bf->v2].pos, sb->bpoint[bf->v3].pos,
-				        &damp,	feedback, ob, timenow))
-				{
-					madd_v3_v3fl(sb->bpoint[bf->v1].force, feedback, tune);
-					madd_v3_v3fl(sb->bpoint[bf->v2].force, feedback, tune);
-					madd_v3_v3fl(sb->bpoint[bf->v3].force, feedback, tune);
-//					madd_v3_v3fl(bf->ext_force, feedback, tune);
-					bf->flag |= BFF_CLOSEVERT;
-					choke = min_ff(max_ff(damp, choke), 1.0f);
+				if (bf->flag & BFF_CLOSEVERT) {
+					madd_v3_v3fl(sb->bpoint[bf->v1].force, bf->ext_force, tune);
+					madd_v3_v3fl(sb->bpoint[bf->v2].force, bf->ext_force, tune);
+					madd_v3_v3fl(sb->bpoint[bf->v3].force, bf->ext_force, tune);
+					choke = min_ff(max_ff(bf->damp, choke), 1.0f);
 				}
 			}
-/*--- close vertices*/
 		}
 		bf = sb->scratch->bodyface;
 		for (a=0; a<sb->scratch->totface; a++, bf++) {
@@ -1322,8 +1461,10 @@ static int sb_detect_edge_collisionCached(float edge_v1[3], float edge_v2[3], fl
 	GHashIterator *ihash;
 	float nv1[3], nv2[3], nv3[3], edge1[3], edge2[3], d_nvect[3], aabbmin[3], aabbmax[3];
 	float t, el;
-	int a, deflected=0;
+	int i, deflected=0;
+	BLI_buffer_declare_static(int, indices, BLI_BUFFER_NOP, 64);
 
+	INIT_MINMAX(aabbmin, aabbmax);
 	minmax_v3v3_v3(aabbmin, aabbmax, edge_v1);
 	minmax_v3v3_v3(aabbmin, aabbmax, edge_v2);
 
@@ -1341,14 +1482,10 @@ static int sb_detect_edge_collisionCached(float edge_v1[3], float edge_v2[3], fl
 				const MVert *mvert = NULL;
 				const MVert *mprevvert = NULL;
 				const MVertTri *vt = NULL;
-				const ccdf_minmax *mima = NULL;
 
 				if (ccdm) {
 					mvert = ccdm->mvert;
 					mprevvert = ccdm->mprevvert;
-					vt = ccdm->tri;
-					mima = ccdm->mima;
-					a = ccdm->tri_num;
 
 					if ((aabbmax[0] < ccdm->bbmin[0]) ||
 					    (aabbmax[1] < ccdm->bbmin[1]) ||
@@ -1371,19 +1508,10 @@ static int sb_detect_edge_collisionCached(float edge_v1[3], float edge_v2[3], fl
 				}
 
 
-				/* use mesh*/
-				while (a--) {
-					if ((aabbmax[0] < mima->minx) ||
-					    (aabbmin[0] > mima->maxx) ||
-					    (aabbmax[1] < mima->miny) ||
-					    (aabbmin[1] > mima->maxy) ||
-					    (aabbmax[2] < mima->minz) ||
-					    (aabbmin[2] > mima->maxz))
-					{
-						mima++;
-						vt++;
-						continue;
-					}
+				/* use mesh, the query tests the mima boxes of the triangles */
+				ccd_mesh_query(ccdm->bvhtree, aabbmin, aabbmax, &indices);
+				for (i = 0; i < (int)indices.count; i++) {
+					vt = &ccdm->tri[BLI_buffer_at(&indices, int, i)];
 
 
 					if (mvert) {
@@ -1422,19 +1550,60 @@ static int sb_detect_edge_collisionCached(float edge_v1[3], float edge_v2[3], fl
 						*damp=ob->pd->pdef_sbdamp;
 						deflected = 2;
 					}
-
-					mima++;
-					vt++;
-				}/* while a */
+				}/* for (i) */
 			} /* if (ob->pd && ob->pd->deflect) */
 			BLI_ghashIterator_step(ihash);
 		}
 	} /* while () */
 	BLI_ghashIterator_free(ihash);
+	BLI_buffer_free(&indices);
 	return deflected;
 }
 
-static void _scan_for_ext_spring_forces(Scene *scene, Object *ob, float timenow, int ifirst, int ilast, struct ListBase *effectors)
+/* Evaluate the effectors for the midpoints of all edge springs at once, ahead of the
+ * spring threads. Returns the wind speed per spring. */
+static float (*sb_calc_spring_effectors(Scene *scene, Object *ob, ListBase *effectors))[3]
+{
+	SoftBody *sb = ob->soft;
+	float (*eff_speed)[3] = MEM_callocN(sizeof(float[3]) * sb->totspring, "SB_spring_effector_speed");
+	float (*force)[3] = MEM_callocN(sizeof(float[3]) * sb->totspring, "SB_spring_effector_force");
+	float (*speed)[3] = MEM_callocN(sizeof(float[3]) * sb->totspring, "SB_spring_effector_points_speed");
+	float (*pos)[3] = MEM_mallocN(sizeof(float[3]) * sb->totspring, "SB_spring_effector_points_pos");
+	float (*vel)[3] = MEM_mallocN(sizeof(float[3]) * sb->totspring, "SB_spring_effector_points_vel");
+	EffectedPoint *epoints = MEM_callocN(sizeof(EffectedPoint) * sb->totspring, "SB_spring_effected_points");
+	int *spring_index = MEM_mallocN(sizeof(int) * sb->totspring, "SB_spring_effector_index");
+	int a, totpoint = 0;
+
+	/* only edge springs see wind */
+	for (a = 0; a < sb->totspring; a++) {
+		BodySpring *bs = &sb->bspring[a];
+
+		if (bs->springtype == SB_EDGE) {
+			mid_v3_v3v3(pos[totpoint], sb->bpoint[bs->v1].pos, sb->bpoint[bs->v2].pos);
+			mid_v3_v3v3(vel[totpoint], sb->bpoint[bs->v1].vec, sb->bpoint[bs->v2].vec);
+			pd_point_from_soft(scene, pos[totpoint], vel[totpoint], -1, &epoints[totpoint]);
+			spring_index[totpoint] = a;
+			totpoint++;
+		}
+	}
+
+	BKE_effectors_apply_array(effectors, NULL, sb->effector_weights, epoints, totpoint, force, speed);
+
+	for (a = 0; a < totpoint; a++) {
+		copy_v3_v3(eff_speed[spring_index[a]], speed[a]);
+	}
+
+	MEM_freeN(spring_index);
+	MEM_freeN(epoints);
+	MEM_freeN(vel);
+	MEM_freeN(pos);
+	MEM_freeN(speed);
+	MEM_freeN(force);
+
+	return eff_speed;
+}
+
+static void _scan_for_ext_spring_forces(Object *ob, float timenow, int ifirst, int ilast, float (*eff_speed)[3])
 {
 	SoftBody *sb = ob->soft;
 	int a;
@@ -1465,19 +1634,14 @@ static void _scan_for_ext_spring_forces(Scene *scene, Object *ob, float timenow,
 				/* +++ springs seeing wind ... n stuff depending on their orientation*/
 				/* note we don't use sb->mediafrict but use sb->aeroedge for magnitude of effect*/
 				if (sb->aeroedge) {
-					float vel[3], sp[3], pr[3], force[3];
+					float vel[3], sp[3], pr[3];
 					float f, windfactor  = 0.25f;
 					/*see if we have wind*/
-					if (effectors) {
-						EffectedPoint epoint;
-						float speed[3] = {0.0f, 0.0f, 0.0f};
-						float pos[3];
-						mid_v3_v3v3(pos, sb->bpoint[bs->v1].pos, sb->bpoint[bs->v2].pos);
+					if (eff_speed) {
+						float speed[3];
 						mid_v3_v3v3(vel, sb->bpoint[bs->v1].vec, sb->bpoint[bs->v2].vec);
-						pd_point_from_soft(scene, pos, vel, -1, &epoint);
-						BKE_effectors_apply(effectors, NULL, sb->effector_weights, &epoint, force, speed);
 
-						mul_v3_fl(speed, windfactor);
+						mul_v3_v3fl(speed, eff_speed[a], windfactor);
 						add_v3_v3(vel, speed);
 					}
 					/* media in rest */
@@ -1507,66 +1671,44 @@ static void _scan_for_ext_spring_forces(Scene *scene, Object *ob, float timenow,
 	}
 }
 
-static void *exec_scan_for_ext_spring_forces(void *data)
+static void scan_for_ext_spring_forces_cb(
+        void *__restrict userdata,
+        const int a,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
 {
-	SB_thread_context *pctx = (SB_thread_context*)data;
-	_scan_for_ext_spring_forces(pctx->scene, pctx->ob, pctx->timenow, pctx->ifirst, pctx->ilast, pctx->effectors);
-	return NULL;
+	SB_thread_context *pctx = userdata;
+	_scan_for_ext_spring_forces(pctx->ob, pctx->timenow, a, a + 1, pctx->eff_speed);
 }
 
 static void sb_sfesf_threads_run(struct Depsgraph *depsgraph, Scene *scene, struct Object *ob, float timenow, int totsprings, int *UNUSED(ptr_to_break_func(void)))
 {
-	ListBase threads;
-	SB_thread_context *sb_threads;
-	int i, totthread, left, dec;
+	SB_thread_context ctx = {NULL};
+	ParallelRangeSettings settings;
 	int lowsprings =100; /* wild guess .. may increase with better thread management 'above' or even be UI option sb->spawn_cf_threads_nopts */
 
-	ListBase *effectors = BKE_effectors_create(depsgraph, ob, NULL, ob->soft->effector_weights);
-
-	/* figure the number of threads while preventing pretty pointless threading overhead */
-	totthread= BKE_scene_num_threads(scene);
-	/* what if we got zillions of CPUs running but less to spread*/
-	while ((totsprings/totthread < lowsprings) && (totthread > 1)) {
-		totthread--;
-	}
-
-	sb_threads= MEM_callocN(sizeof(SB_thread_context)*totthread, "SBSpringsThread");
-	memset(sb_threads, 0, sizeof(SB_thread_context)*totthread);
-	left = totsprings;
-	dec = totsprings/totthread +1;
-	for (i=0; i<totthread; i++) {
-		sb_threads[i].scene = scene;
-		sb_threads[i].ob = ob;
-		sb_threads[i].forcetime = 0.0; // not used here
-		sb_threads[i].timenow = timenow;
-		sb_threads[i].ilast   = left;
-		left = left - dec;
-		if (left >0) {
-			sb_threads[i].ifirst  = left;
+	float (*eff_speed)[3] = NULL;
+
+	if (ob->soft->aeroedge) {
+		ListBase *effectors = BKE_effectors_create(depsgraph, ob, NULL, ob->soft->effector_weights);
+		if (effectors) {
+			eff_speed = sb_calc_spring_effectors(scene, ob, effectors);
+			BKE_effectors_free(effectors);
 		}
-		else
-			sb_threads[i].ifirst  = 0;
-		sb_threads[i].effectors = effectors;
-		sb_threads[i].do_deflector = false;// not used here
-		sb_threads[i].fieldfactor = 0.0f;// not used here
-		sb_threads[i].windfactor  = 0.0f;// not used here
-		sb_threads[i].nr= i;
-		sb_threads[i].tot= totthread;
 	}
-	if (totthread > 1) {
-		BLI_threadpool_init(&threads, exec_scan_for_ext_spring_forces, totthread);
 
-		for (i=0; i<totthread; i++)
-			BLI_threadpool_insert(&threads, &sb_threads[i]);
+	ctx.scene = scene;
+	ctx.ob = ob;
+	ctx.timenow = timenow;
+	ctx.eff_speed = eff_speed;
 
-		BLI_threadpool_end(&threads);
-	}
-	else
-		exec_scan_for_ext_spring_forces(&sb_threads[0]);
-	/* clean up */
-	MEM_freeN(sb_threads);
+	/* prevent pretty pointless threading overhead */
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.min_iter_per_thread = lowsprings;
+	BLI_task_parallel_range(0, totsprings, &ctx, scan_for_ext_spring_forces_cb, &settings);
 
-	BKE_effectors_free(effectors);
+	if (eff_speed) {
+		MEM_freeN(eff_speed);
+	}
 }
 
 
@@ -1608,12 +1750,14 @@ static int sb_detect_vertex_collisionCached(
 	GHash *hash;
 	GHashIterator *ihash;
 	float nv1[3], nv2[3], nv3[3], edge1[3], edge2[3], d_nvect[3], dv1[3], ve[3], avel[3] = {0.0, 0.0, 0.0},
-	      vv1[3], vv2[3], vv3[3], coledge[3] = {0.0f, 0.0f, 0.0f}, mindistedge = 1000.0f,
+	      vv1[3] = {0.0f, 0.0f, 0.0f}, vv2[3] = {0.0f, 0.0f, 0.0f}, vv3[3] = {0.0f, 0.0f, 0.0f},
+	      coledge[3] = {0.0f, 0.0f, 0.0f}, mindistedge = 1000.0f,
 	      outerforceaccu[3], innerforceaccu[3],
 	      facedist, /* n_mag, */ /* UNUSED */ force_mag_norm, minx, miny, minz, maxx, maxy, maxz,
 	      innerfacethickness = -0.5f, outerfacethickness = 0.2f,
 	      ee = 5.0f, ff = 0.1f, fa=1;
-	int a, deflected=0, cavel=0, ci=0;
+	int i, deflected=0, cavel=0, ci=0;
+	BLI_buffer_declare_static(int, indices, BLI_BUFFER_NOP, 64);
 /* init */
 	*intrusion = 0.0f;
 	hash  = vertexowner->soft->scratch->colliderhash;
@@ -1631,14 +1775,10 @@ static int sb_detect_vertex_collisionCached(
 				const MVert *mvert = NULL;
 				const MVert *mprevvert = NULL;
 				const MVertTri *vt = NULL;
-				const ccdf_minmax *mima = NULL;
 
 				if (ccdm) {
 					mvert = ccdm->mvert;
 					mprevvert = ccdm->mprevvert;
-					vt = ccdm->tri;
-					mima = ccdm->mima;
-					a = ccdm->tri_num;
 
 					minx = ccdm->bbmin[0];
 					miny = ccdm->bbmin[1];
@@ -1675,19 +1815,10 @@ static int sb_detect_vertex_collisionCached(
 				fa *= fa;
 				fa = 1.0f/fa;
 				avel[0]=avel[1]=avel[2]=0.0f;
-				/* use mesh*/
-				while (a--) {
-					if ((opco[0] < mima->minx) ||
-					    (opco[0] > mima->maxx) ||
-					    (opco[1] < mima->miny) ||
-					    (opco[1] > mima->maxy) ||
-					    (opco[2] < mima->minz) ||
-					    (opco[2] > mima->maxz))
-					{
-						mima++;
-						vt++;
-						continue;
-					}
+				/* use mesh, the query tests the mima boxes of the triangles */
+				ccd_mesh_query(ccdm->bvhtree, opco, opco, &indices);
+				for (i = 0; i < (int)indices.count; i++) {
+					vt = &ccdm->tri[BLI_buffer_at(&indices, int, i)];
 
 					if (mvert) {
 
@@ -1753,10 +1884,7 @@ static int sb_detect_vertex_collisionCached(
 							ci++;
 						}
 					}
-
-					mima++;
-					vt++;
-				}/* while a */
+				}/* for (i) */
 			} /* if (ob->pd && ob->pd->deflect) */
 			BLI_ghashIterator_step(ihash);
 		}
@@ -1781,6 +1909,7 @@ static int sb_detect_vertex_collisionCached(
 	}
 
 	BLI_ghashIterator_free(ihash);
+	BLI_buffer_free(&indices);
 	if (cavel) mul_v3_fl(avel, 1.0f/(float)cavel);
 	copy_v3_v3(vel, avel);
 	if (ci) *intrusion /= ci;
@@ -1921,7 +2050,7 @@ static void sb_spring_force(Object *ob, int bpi, BodySpring *bs, float iks, floa
 /* since this is definitely the most CPU consuming task here .. try to spread it */
 /* core function _softbody_calc_forces_slice_in_a_thread */
 /* result is int to be able to flag user break */
-static int _softbody_calc_forces_slice_in_a_thread(Scene *scene, Object *ob, float forcetime, float timenow, int ifirst, int ilast, int *UNUSED(ptr_to_break_func(void)), ListBase *effectors, int do_deflector, float fieldfactor, float windfactor)
+static int _softbody_calc_forces_slice_in_a_thread(Scene *scene, Object *ob, float forcetime, float timenow, int ifirst, int ilast, int *UNUSED(ptr_to_break_func(void)), float (*eff_force)[3], float (*eff_speed)[3], int do_deflector, float fieldfactor, float windfactor)
 {
 	float iks;
 	int bb, do_selfcollision, do_springcollision, do_aero;
@@ -2040,14 +2169,12 @@ static int _softbody_calc_forces_slice_in_a_thread(Scene *scene, Object *ob, flo
 			}
 
 			/* particle field & vortex */
-			if (effectors) {
-				EffectedPoint epoint;
+			if (eff_force) {
 				float kd;
-				float force[3] = {0.0f, 0.0f, 0.0f};
-				float speed[3] = {0.0f, 0.0f, 0.0f};
+				float force[3], speed[3];
 				float eval_sb_fric_force_scale = sb_fric_force_scale(ob); /* just for calling function once */
-				pd_point_from_soft(scene, bp->pos, bp->vec, sb->bpoint-bp, &epoint);
-				BKE_effectors_apply(effectors, NULL, sb->effector_weights, &epoint, force, speed);
+				copy_v3_v3(force, eff_force[bp - sb->bpoint]);
+				copy_v3_v3(speed, eff_speed[bp - sb->bpoint]);
 
 				/* apply forcefield*/
 				mul_v3_fl(force, fieldfactor* eval_sb_fric_force_scale);
@@ -2119,66 +2246,57 @@ static int _softbody_calc_forces_slice_in_a_thread(Scene *scene, Object *ob, flo
 	return 0; /*done fine*/
 }
 
-static void *exec_softbody_calc_forces(void *data)
-{
-	SB_thread_context *pctx = (SB_thread_context*)data;
-	_softbody_calc_forces_slice_in_a_thread(pctx->scene, pctx->ob, pctx->forcetime, pctx->timenow, pctx->ifirst, pctx->ilast, NULL, pctx->effectors, pctx->do_deflector, pctx->fieldfactor, pctx->windfactor);
-	return NULL;
-}
-
-static void sb_cf_threads_run(Scene *scene, Object *ob, float forcetime, float timenow, int totpoint, int *UNUSED(ptr_to_break_func(void)), struct ListBase *effectors, int do_deflector, float fieldfactor, float windfactor)
+/* Evaluate the effectors for all body points at once, ahead of the force threads. */
+static void sb_calc_point_effectors(Scene *scene, Object *ob, ListBase *effectors, float (**r_force)[3], float (**r_speed)[3])
 {
-	ListBase threads;
-	SB_thread_context *sb_threads;
-	int i, totthread, left, dec;
-	int lowpoints =100; /* wild guess .. may increase with better thread management 'above' or even be UI option sb->spawn_cf_threads_nopts */
+	SoftBody *sb = ob->soft;
+	float (*eff_force)[3] = MEM_callocN(sizeof(float[3]) * sb->totpoint, "SB_point_effector_force");
+	float (*eff_speed)[3] = MEM_callocN(sizeof(float[3]) * sb->totpoint, "SB_point_effector_speed");
+	EffectedPoint *epoints = MEM_callocN(sizeof(EffectedPoint) * sb->totpoint, "SB_point_effected_points");
+	BodyPoint *bp;
+	int a;
 
-	/* figure the number of threads while preventing pretty pointless threading overhead */
-	totthread= BKE_scene_num_threads(scene);
-	/* what if we got zillions of CPUs running but less to spread*/
-	while ((totpoint/totthread < lowpoints) && (totthread > 1)) {
-		totthread--;
-	}
-
-	/* printf("sb_cf_threads_run spawning %d threads\n", totthread); */
-
-	sb_threads= MEM_callocN(sizeof(SB_thread_context)*totthread, "SBThread");
-	memset(sb_threads, 0, sizeof(SB_thread_context)*totthread);
-	left = totpoint;
-	dec = totpoint/totthread +1;
-	for (i=0; i<totthread; i++) {
-		sb_threads[i].scene = scene;
-		sb_threads[i].ob = ob;
-		sb_threads[i].forcetime = forcetime;
-		sb_threads[i].timenow = timenow;
-		sb_threads[i].ilast   = left;
-		left = left - dec;
-		if (left >0) {
-			sb_threads[i].ifirst  = left;
-		}
-		else
-			sb_threads[i].ifirst  = 0;
-		sb_threads[i].effectors = effectors;
-		sb_threads[i].do_deflector = do_deflector;
-		sb_threads[i].fieldfactor = fieldfactor;
-		sb_threads[i].windfactor  = windfactor;
-		sb_threads[i].nr= i;
-		sb_threads[i].tot= totthread;
+	for (a = 0, bp = sb->bpoint; a < sb->totpoint; a++, bp++) {
+		pd_point_from_soft(scene, bp->pos, bp->vec, sb->bpoint - bp, &epoints[a]);
 	}
 
+	BKE_effectors_apply_array(effectors, NULL, sb->effector_weights, epoints, sb->totpoint, eff_force, eff_speed);
 
-	if (totthread > 1) {
-		BLI_threadpool_init(&threads, exec_softbody_calc_forces, totthread);
+	MEM_freeN(epoints);
 
-		for (i=0; i<totthread; i++)
-			BLI_threadpool_insert(&threads, &sb_threads[i]);
+	*r_force = eff_force;
+	*r_speed = eff_speed;
+}
 
-		BLI_threadpool_end(&threads);
-	}
-	else
-		exec_softbody_calc_forces(&sb_threads[0]);
-	/* clean up */
-	MEM_freeN(sb_threads);
+static void softbody_calc_forces_cb(
+        void *__restrict userdata,
+        const int a,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	SB_thread_context *pctx = userdata;
+	_softbody_calc_forces_slice_in_a_thread(pctx->scene, pctx->ob, pctx->forcetime, pctx->timenow, a, a + 1, NULL, pctx->eff_force, pctx->eff_speed, pctx->do_deflector, pctx->fieldfactor, pctx->windfactor);
+}
+
+static void sb_cf_threads_run(Scene *scene, Object *ob, float forcetime, float timenow, int totpoint, int *UNUSED(ptr_to_break_func(void)), float (*eff_force)[3], float (*eff_speed)[3], int do_deflector, float fieldfactor, float windfactor)
+{
+	SB_thread_context ctx;
+	ParallelRangeSettings settings;
+	int lowpoints =100; /* wild guess .. may increase with better thread management 'above' or even be UI option sb->spawn_cf_threads_nopts */
+
+	ctx.scene = scene;
+	ctx.ob = ob;
+	ctx.forcetime = forcetime;
+	ctx.timenow = timenow;
+	ctx.eff_force = eff_force;
+	ctx.eff_speed = eff_speed;
+	ctx.do_deflector = do_deflector;
+	ctx.fieldfactor = fieldfactor;
+	ctx.windfactor = windfactor;
+
+	/* prevent pretty pointless threading overhead */
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.min_iter_per_thread = lowpoints;
+	BLI_task_parallel_range(0, totpoint, &ctx, softbody_calc_forces_cb, &settings);
 }
 
 static void softbody_calc_forces(struct Depsgraph *depsgraph, Scene *scene, Object *ob, float forcetime, float timenow)
@@ -2209,18 +2327,27 @@ static void softbody_calc_forces(struct Depsgraph *depsgraph, Scene *scene, Obje
 
 	/* after spring scan because it uses Effoctors too */
 	ListBase *effectors = BKE_effectors_create(depsgraph, ob, NULL, sb->effector_weights);
+	float (*eff_force)[3] = NULL, (*eff_speed)[3] = NULL;
+
+	if (effectors) {
+		sb_calc_point_effectors(scene, ob, effectors, &eff_force, &eff_speed);
+	}
 
 	if (do_deflector) {
 		float defforce[3];
 		do_deflector = sb_detect_aabb_collisionCached(defforce, ob, timenow);
 	}
 
-	sb_cf_threads_run(scene, ob, forcetime, timenow, sb->totpoint, NULL, effectors, do_deflector, fieldfactor, windfactor);
+	sb_cf_threads_run(scene, ob, forcetime, timenow, sb->totpoint, NULL, eff_force, eff_speed, do_deflector, fieldfactor, windfactor);
 
 	/* finally add forces caused by face collision */
 	if (ob->softflag & OB_SB_FACECOLL) scan_for_ext_face_forces(ob, timenow);
 
 	/* finish matrix and solve */
+	if (eff_force) {
+		MEM_freeN(eff_force);
+		MEM_freeN(eff_speed);
+	}
 	BKE_effectors_free(effectors);
 }
 
@@ -2662,6 +2789,7 @@ static void mesh_faces_to_scratch(Object *ob)
 		bodyface->v3 = me->mloop[lt->tri[2]].v;
 		zero_v3(bodyface->ext_force);
 		bodyface->ext_force[0] = bodyface->ext_force[1] = bodyface->ext_force[2] = 0.0f;
+		bodyface->damp = 0.0f;
 		bodyface->flag = 0;
 	}
 
@@ -31,6 +31,14 @@
 #ifndef __PARTICLE_PRIVATE_H__
 #define __PARTICLE_PRIVATE_H__
 
+/* Modifier inputs which are constant along a single child path,
+ * evaluated once per child instead of once per path key. */
+typedef struct ParticleChildInvariants {
+	bool use_clump_noise;
+	float clump_noise_offset[3];
+	float rough_vec[3];
+} ParticleChildInvariants;
+
 typedef struct ParticleChildModifierContext {
 	ParticleThreadContext *thread_ctx;
 	ParticleSimulationData *sim;
@@ -42,6 +50,8 @@ typedef struct ParticleChildModifierContext {
 	const float *par_orco;  /* float3 */
 	const float *orco;      /* float3 */
 	ParticleCacheKey *parent_keys;
+	/* Optional, computed per key when NULL. */
+	const ParticleChildInvariants *invariants;
 } ParticleChildModifierContext;
 
 void do_kink(ParticleKey *state, const float par_co[3], const float par_vel[3], const float par_rot[4], float time, float freq, float shape, float amplitude, float flat,
@@ -50,5 +60,6 @@ float do_clump(ParticleKey *state, const float par_co[3], float time, const floa
                bool use_clump_noise, float clump_noise_size, CurveMapping *clumpcurve);
 void do_child_modifiers(const ParticleChildModifierContext *modifier_ctx,
                         float mat[4][4], ParticleKey *state, float t);
+void psys_child_modifier_tables_init(ParticleThreadContext *ctx);
 
 #endif /* __PARTICLE_PRIVATE_H__ */
@@ -69,6 +69,9 @@ void BLI_kdtree_range_search_cb(
 int BLI_kdtree_calc_duplicates_fast(
         const KDTree *tree, const float range, bool use_index_order,
         int *doubles);
+int BLI_kdtree_calc_duplicates_parallel(
+        const KDTree *tree, const float range,
+        int *duplicates);
 
 /* Normal use is deprecated */
 /* remove __normal functions when last users drop */
@@ -29,6 +29,7 @@
 
 #include "BLI_math.h"
 #include "BLI_kdtree.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 #include "BLI_strict_flags.h"
 
@@ -804,3 +805,402 @@ int BLI_kdtree_calc_duplicates_fast(
 }
 
 /** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name BLI_kdtree_calc_duplicates_parallel
+ *
+ * Points are bucketed in a uniform grid (cells at least \a range wide) ordered by Morton code,
+ * neighbors in the 27 surrounding cells are found in parallel,
+ * then targets are assigned in a single ordered pass.
+ * \{ */
+
+/* bits per axis for cell coordinates (63 bit keys) */
+#define DEDUP_CELL_BITS 21
+#define DEDUP_CELL_MAX ((1u << DEDUP_CELL_BITS) - 1)
+/* average number of point pairs compared per point, above this the serial search is used */
+#define DEDUP_PAIRS_PER_POINT_MAX 64
+
+typedef struct DeDuplicatePoint {
+	uint64_t key;
+	uint node;
+} DeDuplicatePoint;
+
+struct DeDuplicateParallelParams {
+	const KDTreeNode *nodes;
+	const int *duplicates;
+	float range_sq;
+	float min[3];
+	float cell_size_inv;
+
+	/* sorted by cell key */
+	const DeDuplicatePoint *points;
+	/* first point of each (non-empty) cell */
+	const uint64_t *cell_keys;
+	const uint *cell_start;
+	uint cells_len;
+
+	/* aligned with KDTreeNode.index */
+	uint *neighbors_len;
+	/* when NULL only count neighbors */
+	const size_t *neighbors_offset;
+	uint *neighbors;
+
+	/* aligned with cells, see #dedup_cell_pairs_cb */
+	uint64_t *cell_pairs;
+};
+
+static uint64_t dedup_morton_spread(uint x)
+{
+	uint64_t v = x & DEDUP_CELL_MAX;
+	v = (v | (v << 32)) & 0x1f00000000ffffULL;
+	v = (v | (v << 16)) & 0x1f0000ff0000ffULL;
+	v = (v | (v << 8))  & 0x100f00f00f00f00fULL;
+	v = (v | (v << 4))  & 0x10c30c30c30c30c3ULL;
+	v = (v | (v << 2))  & 0x1249249249249249ULL;
+	return v;
+}
+
+static uint64_t dedup_cell_key(const uint cell[3])
+{
+	return dedup_morton_spread(cell[0]) | (dedup_morton_spread(cell[1]) << 1) | (dedup_morton_spread(cell[2]) << 2);
+}
+
+static void dedup_cell_coord(const struct DeDuplicateParallelParams *p, const float co[3], uint r_cell[3])
+{
+	for (int j = 0; j < 3; j++) {
+		const float f = (co[j] - p->min[j]) * p->cell_size_inv;
+		r_cell[j] = (f <= 0.0f) ? 0u : ((f >= (float)DEDUP_CELL_MAX) ? DEDUP_CELL_MAX : (uint)f);
+	}
+}
+
+/* \return the cell index, or -1 for an empty cell */
+static int dedup_cell_find(const struct DeDuplicateParallelParams *p, const uint64_t key)
+{
+	uint lo = 0, hi = p->cells_len;
+	while (lo < hi) {
+		const uint mid = (lo + hi) / 2;
+		if (p->cell_keys[mid] < key) {
+			lo = mid + 1;
+		}
+		else {
+			hi = mid;
+		}
+	}
+	return ((lo < p->cells_len) && (p->cell_keys[lo] == key)) ? (int)lo : -1;
+}
+
+/**
+ * Collect the neighbors of all points in a cell.
+ *
+ * Only points which can be merged (initialized to -1) are stored as neighbors,
+ * and only those with a greater index than the searching point,
+ * unless it's a point which must be kept (lower indices have already searched for it otherwise,
+ * see #BLI_kdtree_calc_duplicates_parallel).
+ */
+/* \return the number of non-empty cells around (and including) the cell of \a cell_index */
+static uint dedup_cell_neighbor_cells(
+        const struct DeDuplicateParallelParams *p, const int cell_index,
+        uint r_neighbor_start[27], uint r_neighbor_end[27])
+{
+	uint neighbor_cells_len = 0;
+	uint cell[3];
+
+	dedup_cell_coord(p, p->nodes[p->points[p->cell_start[cell_index]].node].co, cell);
+
+	for (int x = -1; x <= 1; x++) {
+		for (int y = -1; y <= 1; y++) {
+			for (int z = -1; z <= 1; z++) {
+				const int cell_other_signed[3] = {(int)cell[0] + x, (int)cell[1] + y, (int)cell[2] + z};
+				if ((cell_other_signed[0] < 0) || (cell_other_signed[1] < 0) || (cell_other_signed[2] < 0) ||
+				    (cell_other_signed[0] > (int)DEDUP_CELL_MAX) ||
+				    (cell_other_signed[1] > (int)DEDUP_CELL_MAX) ||
+				    (cell_other_signed[2] > (int)DEDUP_CELL_MAX))
+				{
+					continue;
+				}
+				const uint cell_other[3] = {(uint)cell_other_signed[0], (uint)cell_other_signed[1], (uint)cell_other_signed[2]};
+				const int i = dedup_cell_find(p, dedup_cell_key(cell_other));
+				if (i != -1) {
+					r_neighbor_start[neighbor_cells_len] = p->cell_start[i];
+					r_neighbor_end[neighbor_cells_len] = p->cell_start[i + 1];
+					neighbor_cells_len++;
+				}
+			}
+		}
+	}
+	return neighbor_cells_len;
+}
+
+/**
+ * Upper bound of the number of point pairs compared for a cell,
+ * used to avoid the parallel search for dense clusters of points.
+ */
+static void dedup_cell_pairs_cb(
+        void *__restrict userdata,
+        const int cell_index,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	const struct DeDuplicateParallelParams *p = userdata;
+	uint neighbor_start[27], neighbor_end[27];
+	const uint neighbor_cells_len = dedup_cell_neighbor_cells(p, cell_index, neighbor_start, neighbor_end);
+	uint64_t neighbor_points_len = 0;
+
+	for (uint c = 0; c < neighbor_cells_len; c++) {
+		neighbor_points_len += neighbor_end[c] - neighbor_start[c];
+	}
+	p->cell_pairs[cell_index] = (uint64_t)(p->cell_start[cell_index + 1] - p->cell_start[cell_index]) * neighbor_points_len;
+}
+
+static void dedup_cell_neighbors_cb(
+        void *__restrict userdata,
+        const int cell_index,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	const struct DeDuplicateParallelParams *p = userdata;
+	const uint start = p->cell_start[cell_index];
+	const uint end = p->cell_start[cell_index + 1];
+	uint neighbor_start[27], neighbor_end[27];
+	const uint neighbor_cells_len = dedup_cell_neighbor_cells(p, cell_index, neighbor_start, neighbor_end);
+
+	for (uint a = start; a < end; a++) {
+		const KDTreeNode *node = &p->nodes[p->points[a].node];
+		const int index = node->index;
+		const bool is_keep = (p->duplicates[index] == index);
+		uint *neighbors = p->neighbors_offset ? &p->neighbors[p->neighbors_offset[index]] : NULL;
+		uint neighbors_len = 0;
+
+		if (!ELEM(p->duplicates[index], -1, index)) {
+			continue;
+		}
+
+		for (uint c = 0; c < neighbor_cells_len; c++) {
+			for (uint b = neighbor_start[c]; b < neighbor_end[c]; b++) {
+				const KDTreeNode *node_other = &p->nodes[p->points[b].node];
+				const int index_other = node_other->index;
+				if ((index_other == index) ||
+				    (p->duplicates[index_other] != -1) ||
+				    ((index_other < index) && !is_keep))
+				{
+					continue;
+				}
+				if (compare_len_squared_v3v3(node->co, node_other->co, p->range_sq)) {
+					if (neighbors) {
+						neighbors[neighbors_len] = (uint)index_other;
+					}
+					neighbors_len++;
+				}
+			}
+		}
+
+		if (neighbors == NULL) {
+			p->neighbors_len[index] = neighbors_len;
+		}
+	}
+}
+
+static void dedup_points_sort(DeDuplicatePoint *points, const uint points_len)
+{
+	DeDuplicatePoint *points_tmp = MEM_mallocN(sizeof(*points) * points_len, __func__);
+	DeDuplicatePoint *src = points, *dst = points_tmp;
+
+	/* LSD radix sort, one byte at a time */
+	for (uint shift = 0; shift < 64; shift += 8) {
+		uint count[256] = {0};
+		for (uint i = 0; i < points_len; i++) {
+			count[(src[i].key >> shift) & 0xff]++;
+		}
+		if (count[(src[0].key >> shift) & 0xff] == points_len) {
+			/* all keys share this byte */
+			continue;
+		}
+		for (uint i = 0, total = 0; i < 256; i++) {
+			const uint c = count[i];
+			count[i] = total;
+			total += c;
+		}
+		for (uint i = 0; i < points_len; i++) {
+			dst[count[(src[i].key >> shift) & 0xff]++] = src[i];
+		}
+		SWAP(DeDuplicatePoint *, src, dst);
+	}
+
+	if (src != points) {
+		memcpy(points, src, sizeof(*points) * points_len);
+	}
+	MEM_freeN(points_tmp);
+}
+
+/**
+ * Threaded alternative to #BLI_kdtree_calc_duplicates_fast (with \a use_index_order enabled),
+ * for large numbers of points.
+ *
+ * Finding neighbors runs in parallel, targets are then assigned looping over points ordered by index,
+ * giving the same results as #BLI_kdtree_calc_duplicates_fast independent of the number of threads.
+ *
+ * Indices must be aligned with nodes (each index in [0, totnode) used once),
+ * the tree may be unbalanced since only its nodes are read.
+ *
+ * \param range: Coordinates in this range are candidates to be merged.
+ * \param duplicates: An array of int's the length of #KDTree.totnode
+ * Values initialized to -1 are candidates to me merged.
+ * Setting the index to it's own position in the array prevents it from being touched,
+ * although it can still be used as a target.
+ * \returns The number of merges found.
+ *
+ * \note Merging is always a single step (target indices wont be marked for merging).
+ * \note When many points are close to each other (dense clusters or a large \a range),
+ * this falls back to #BLI_kdtree_calc_duplicates_fast on a balanced copy of the tree,
+ * keeping time and memory bounded.
+ */
+int BLI_kdtree_calc_duplicates_parallel(
+        const KDTree *tree, const float range,
+        int *duplicates)
+{
+	const KDTreeNode *nodes = tree->nodes;
+	const uint totnode = tree->totnode;
+	int found = 0;
+
+	if (totnode < 2) {
+		return 0;
+	}
+
+	struct DeDuplicateParallelParams p = {
+		.nodes = nodes,
+		.duplicates = duplicates,
+		.range_sq = range * range,
+	};
+
+	/* cells must be at least 'range' wide so neighbors are in adjacent cells */
+	{
+		float max[3], extent = 0.0f;
+		INIT_MINMAX(p.min, max);
+		for (uint i = 0; i < totnode; i++) {
+			minmax_v3v3_v3(p.min, max, nodes[i].co);
+		}
+		for (int j = 0; j < 3; j++) {
+			extent = max_ff(extent, max[j] - p.min[j]);
+		}
+		float cell_size = max_ff(range, extent / (float)(DEDUP_CELL_MAX - 1));
+		if (!(cell_size > 0.0f)) {
+			cell_size = 1.0f;
+		}
+		p.cell_size_inv = 1.0f / cell_size;
+	}
+
+	DeDuplicatePoint *points = MEM_mallocN(sizeof(*points) * totnode, __func__);
+	for (uint i = 0; i < totnode; i++) {
+		uint cell[3];
+		dedup_cell_coord(&p, nodes[i].co, cell);
+		points[i].key = dedup_cell_key(cell);
+		points[i].node = i;
+	}
+	dedup_points_sort(points, totnode);
+
+	uint cells_len = 0;
+	for (uint i = 0; i < totnode; i++) {
+		if ((i == 0) || (points[i].key != points[i - 1].key)) {
+			cells_len++;
+		}
+	}
+
+	uint64_t *cell_keys = MEM_mallocN(sizeof(*cell_keys) * cells_len, __func__);
+	uint *cell_start = MEM_mallocN(sizeof(*cell_start) * (cells_len + 1), __func__);
+	for (uint i = 0, c = 0; i < totnode; i++) {
+		if ((i == 0) || (points[i].key != points[i - 1].key)) {
+			cell_keys[c] = points[i].key;
+			cell_start[c] = i;
+			c++;
+		}
+	}
+	cell_start[cells_len] = totnode;
+
+	p.points = points;
+	p.cell_keys = cell_keys;
+	p.cell_start = cell_start;
+	p.cells_len = cells_len;
+
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+	settings.min_iter_per_thread = 1024;
+
+	/* Dense clusters would compare (and store) every pair of points,
+	 * the serial search skips points as soon as they're merged instead. */
+	{
+		uint64_t pairs_len = 0;
+		p.cell_pairs = MEM_mallocN(sizeof(*p.cell_pairs) * cells_len, __func__);
+		BLI_task_parallel_range(0, (int)cells_len, &p, dedup_cell_pairs_cb, &settings);
+		for (uint i = 0; i < cells_len; i++) {
+			pairs_len += p.cell_pairs[i];
+		}
+		MEM_freeN(p.cell_pairs);
+
+		if (pairs_len > (uint64_t)totnode * DEDUP_PAIRS_PER_POINT_MAX) {
+			MEM_freeN(cell_keys);
+			MEM_freeN(cell_start);
+			MEM_freeN(points);
+
+			/* The search needs a balanced tree, callers may pass one that isn't. */
+			KDTree *tree_balanced = BLI_kdtree_new(totnode);
+			for (uint i = 0; i < totnode; i++) {
+				BLI_kdtree_insert(tree_balanced, nodes[i].index, nodes[i].co);
+			}
+			BLI_kdtree_balance(tree_balanced);
+			found = BLI_kdtree_calc_duplicates_fast(tree_balanced, range, true, duplicates);
+			BLI_kdtree_free(tree_balanced);
+			return found;
+		}
+	}
+
+	p.neighbors_len = MEM_callocN(sizeof(*p.neighbors_len) * totnode, __func__);
+
+	/* count, then store neighbors */
+	BLI_task_parallel_range(0, (int)cells_len, &p, dedup_cell_neighbors_cb, &settings);
+
+	size_t *neighbors_offset = MEM_mallocN(sizeof(*neighbors_offset) * (totnode + 1), __func__);
+	neighbors_offset[0] = 0;
+	for (uint i = 0; i < totnode; i++) {
+		neighbors_offset[i + 1] = neighbors_offset[i] + p.neighbors_len[i];
+	}
+
+	if (neighbors_offset[totnode] != 0) {
+		p.neighbors = MEM_mallocN(sizeof(*p.neighbors) * neighbors_offset[totnode], __func__);
+		p.neighbors_offset = neighbors_offset;
+		BLI_task_parallel_range(0, (int)cells_len, &p, dedup_cell_neighbors_cb, &settings);
+
+		/* Assign targets in index order, as #BLI_kdtree_calc_duplicates_fast does.
+		 *
+		 * Neighbors with a lower index can be skipped (besides for points to keep):
+		 * when they were searched this point was still a candidate for merging,
+		 * so either it was merged into them (and isn't searched), or they were merged already. */
+		for (uint i = 0; i < totnode; i++) {
+			const int index = (int)i;
+			if (ELEM(duplicates[index], -1, index)) {
+				const int found_prev = found;
+				for (size_t k = neighbors_offset[i]; k < neighbors_offset[i + 1]; k++) {
+					const uint index_other = p.neighbors[k];
+					if (duplicates[index_other] == -1) {
+						duplicates[index_other] = index;
+						found += 1;
+					}
+				}
+				if (found != found_prev) {
+					/* Prevent chains of doubles. */
+					duplicates[index] = index;
+				}
+			}
+		}
+
+		MEM_freeN(p.neighbors);
+	}
+
+	MEM_freeN(neighbors_offset);
+	MEM_freeN(p.neighbors_len);
+	MEM_freeN(cell_keys);
+	MEM_freeN(cell_start);
+	MEM_freeN(points);
+
+	return found;
+}
+
+/** \} */
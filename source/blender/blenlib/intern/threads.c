@@ -614,6 +614,8 @@ void BLI_ticket_mutex_unlock(TicketMutex *ticket)
 
 /* Condition */
 
+static void wait_timeout(struct timespec *timeout, int ms);
+
 void BLI_condition_init(ThreadCondition *cond)
 {
 	pthread_cond_init(cond, NULL);
@@ -624,6 +626,16 @@ void BLI_condition_wait(ThreadCondition *cond, ThreadMutex *mutex)
 	pthread_cond_wait(cond, mutex);
 }
 
+/* Returns false when woken up by the timeout rather than a notify. */
+bool BLI_condition_wait_timeout(ThreadCondition *cond, ThreadMutex *mutex, int ms)
+{
+	struct timespec timeout;
+
+	wait_timeout(&timeout, ms);
+
+	return pthread_cond_timedwait(cond, mutex, &timeout) != ETIMEDOUT;
+}
+
 void BLI_condition_wait_global_mutex(ThreadCondition *cond, const int type)
 {
 	pthread_cond_wait(cond, global_mutex_from_type(type));
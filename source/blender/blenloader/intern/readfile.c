@@ -3764,6 +3764,7 @@ static void direct_link_key(FileData *fd, Key *key)
 	direct_link_animdata(fd, key->adt);
 
 	key->refkey = newdataadr(fd, key->refkey);
+	key->runtime = NULL;
 
 	for (kb = key->block.first; kb; kb = kb->next) {
 		kb->data = newdataadr(fd, kb->data);
@@ -2788,13 +2788,15 @@ void blo_do_versions_280(FileData *fd, Library *UNUSED(lib), Main *bmain)
 		BKE_main_id_repair_duplicate_names_listbase(lb);
 	}
 
-	{
-		/* Versioning code until next subversion bump goes here. */
-
+	if (!MAIN_VERSION_ATLEAST(bmain, 280, 44)) {
 		if (!DNA_struct_elem_find(fd->filesdna, "Material", "float", "a")) {
 			for (Material *mat = bmain->mat.first; mat; mat = mat->id.next) {
 				mat->a = 1.0f;
 			}
 		}
 	}
+
+	{
+		/* Versioning code until next subversion bump goes here. */
+	}
 }
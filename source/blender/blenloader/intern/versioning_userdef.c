@@ -478,6 +478,23 @@ void BLO_version_defaults_userpref_blend(Main *bmain, UserDef *userdef)
 		}
 	}
 
+	if (!USER_VERSION_ATLEAST(280, 44)) {
+		/* 0 disables the compositor cache, only set the default for preferences without it */
+		if (userdef->compositor_cache_limit == 0) {
+			userdef->compositor_cache_limit = 1024;
+		}
+		if (userdef->sequencer_disk_cache_size_limit == 0) {
+			const char budget[4] = {25, 25, 20, 30};
+
+			memcpy(userdef->sequencer_cache_budget, budget, sizeof(budget));
+			userdef->sequencer_disk_cache_size_limit = 100;
+		}
+	}
+
+	if (!USER_VERSION_ATLEAST(280, 45)) {
+		userdef->modifier_cache_limit = 256;
+	}
+
 	/**
 	 * Include next version bump.
 	 */
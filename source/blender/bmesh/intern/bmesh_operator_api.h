@@ -319,6 +319,34 @@ int BMO_mesh_enabled_flag_count(BMesh *bm, const char htype, const short oflag);
  * type can be a bitmask of BM_FACE, BM_EDGE, or BM_FACE. */
 int BMO_mesh_disabled_flag_count(BMesh *bm, const char htype, const short oflag);
 
+/*---------selection-local regions-----------*/
+
+/**
+ * Compact arrays of the elements an operator works on,
+ * so operators acting on a small selection don't need passes over the whole mesh.
+ *
+ * Arrays are sorted by element index, giving the same order as iterating over the mesh.
+ */
+typedef struct BMOpRegion {
+	BMVert **verts;
+	BMEdge **edges;
+	BMFace **faces;
+	int verts_len, edges_len, faces_len;
+} BMOpRegion;
+
+/* callback for #BMO_region_parallel, \a index is the position in the region array */
+typedef void (*BMORegionFunc)(void *userdata, BMElem *ele, const int index);
+
+void BMO_region_from_verts(
+        BMesh *bm, BMOpRegion *region,
+        BMVert **verts, const int verts_len, const char htype_expand);
+void BMO_region_from_edges(
+        BMesh *bm, BMOpRegion *region,
+        BMEdge **edges, const int edges_len, const char htype_expand);
+void BMO_region_faces_append(BMesh *bm, BMOpRegion *region, BMFace **faces, const int faces_len);
+void BMO_region_free(BMOpRegion *region);
+void BMO_region_parallel(BMOpRegion *region, const char htype, BMORegionFunc func, void *userdata);
+
 /*---------formatted operator initialization/execution-----------*/
 void BMO_push(BMesh *bm, BMOperator *op);
 void BMO_pop(BMesh *bm);
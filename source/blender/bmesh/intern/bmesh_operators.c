@@ -29,11 +29,13 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_utildefines.h"
+#include "BLI_array.h"
 #include "BLI_string.h"
 #include "BLI_math.h"
 #include "BLI_memarena.h"
 #include "BLI_mempool.h"
 #include "BLI_listbase.h"
+#include "BLI_task.h"
 
 #include "BLT_translation.h"
 
@@ -596,6 +598,211 @@ int BMO_mesh_disabled_flag_count(BMesh *bm, const char htype, const short oflag)
 	return bmo_mesh_flag_count(bm, htype, oflag, false);
 }
 
+
+/* -------------------------------------------------------------------- */
+/** \name Selection-Local Regions
+ *
+ * Operators which only touch elements around their input can build a #BMOpRegion
+ * instead of looping over all mesh elements and testing tool-flags.
+ * Per-element phases that don't change topology can then run in parallel with #BMO_region_parallel.
+ * \{ */
+
+static int bmo_region_elem_index_cmp(const void *a_v, const void *b_v)
+{
+	const int a = BM_elem_index_get(*(BMElem * const *)a_v);
+	const int b = BM_elem_index_get(*(BMElem * const *)b_v);
+	if      (a < b) return -1;
+	else if (a > b) return  1;
+	else            return  0;
+}
+
+static void bmo_region_sort(void **elems, const int elems_len)
+{
+	if (elems_len > 1) {
+		qsort(elems, (size_t)elems_len, sizeof(*elems), bmo_region_elem_index_cmp);
+	}
+}
+
+static void **bmo_region_copy(void **elems, const int elems_len, const char *alloc_str)
+{
+	void **elems_copy = MEM_mallocN(sizeof(*elems) * (size_t)MAX2(elems_len, 1), alloc_str);
+	memcpy(elems_copy, elems, sizeof(*elems) * (size_t)elems_len);
+	bmo_region_sort(elems_copy, elems_len);
+	return elems_copy;
+}
+
+/**
+ * Collect unique elements connected to \a elems, sorted by index.
+ */
+static void **bmo_region_expand(BMElem **elems, const int elems_len, const char itype, int *r_len)
+{
+	BMElem **elems_expand = NULL;
+	BLI_array_declare(elems_expand);
+
+	for (int i = 0; i < elems_len; i++) {
+		BMIter iter;
+		BMElem *ele;
+		BM_ITER_ELEM (ele, &iter, elems[i], itype) {
+			if (!BM_ELEM_API_FLAG_TEST(ele, _FLAG_WALK)) {
+				BM_ELEM_API_FLAG_ENABLE(ele, _FLAG_WALK);
+				BLI_array_append(elems_expand, ele);
+			}
+		}
+	}
+
+	for (int i = 0; i < BLI_array_len(elems_expand); i++) {
+		BM_ELEM_API_FLAG_DISABLE(elems_expand[i], _FLAG_WALK);
+	}
+
+	*r_len = BLI_array_len(elems_expand);
+	bmo_region_sort((void **)elems_expand, *r_len);
+	return (void **)elems_expand;
+}
+
+/**
+ * Initialize a region from vertices (typically an input slot),
+ * \a htype_expand adds the edges and/or faces using them.
+ */
+void BMO_region_from_verts(
+        BMesh *bm, BMOpRegion *region,
+        BMVert **verts, const int verts_len, const char htype_expand)
+{
+	memset(region, 0, sizeof(*region));
+
+	/* indices are set when pushing the tool-flag layer, this is only needed when called after modifying the mesh */
+	BM_mesh_elem_index_ensure(bm, BM_VERT | (htype_expand & (BM_EDGE | BM_FACE)));
+
+	region->verts = (BMVert **)bmo_region_copy((void **)verts, verts_len, __func__);
+	region->verts_len = verts_len;
+
+	if (htype_expand & BM_EDGE) {
+		region->edges = (BMEdge **)bmo_region_expand(
+		        (BMElem **)region->verts, region->verts_len, BM_EDGES_OF_VERT, &region->edges_len);
+	}
+	if (htype_expand & BM_FACE) {
+		region->faces = (BMFace **)bmo_region_expand(
+		        (BMElem **)region->verts, region->verts_len, BM_FACES_OF_VERT, &region->faces_len);
+	}
+}
+
+/**
+ * Initialize a region from edges, \a htype_expand adds their vertices and/or the faces using them.
+ */
+void BMO_region_from_edges(
+        BMesh *bm, BMOpRegion *region,
+        BMEdge **edges, const int edges_len, const char htype_expand)
+{
+	memset(region, 0, sizeof(*region));
+
+	BM_mesh_elem_index_ensure(bm, BM_EDGE | (htype_expand & (BM_VERT | BM_FACE)));
+
+	region->edges = (BMEdge **)bmo_region_copy((void **)edges, edges_len, __func__);
+	region->edges_len = edges_len;
+
+	if (htype_expand & BM_VERT) {
+		region->verts = (BMVert **)bmo_region_expand(
+		        (BMElem **)region->edges, region->edges_len, BM_VERTS_OF_EDGE, &region->verts_len);
+	}
+	if (htype_expand & BM_FACE) {
+		region->faces = (BMFace **)bmo_region_expand(
+		        (BMElem **)region->edges, region->edges_len, BM_FACES_OF_EDGE, &region->faces_len);
+	}
+}
+
+/**
+ * Add faces which aren't already in the region (faces from a slot map for example).
+ */
+void BMO_region_faces_append(BMesh *bm, BMOpRegion *region, BMFace **faces, const int faces_len)
+{
+	int faces_len_new = region->faces_len;
+
+	if (faces_len == 0) {
+		return;
+	}
+
+	BM_mesh_elem_index_ensure(bm, BM_FACE);
+
+	region->faces = MEM_reallocN(region->faces, sizeof(*region->faces) * (size_t)(region->faces_len + faces_len));
+
+	for (int i = 0; i < region->faces_len; i++) {
+		BM_ELEM_API_FLAG_ENABLE(region->faces[i], _FLAG_WALK);
+	}
+	for (int i = 0; i < faces_len; i++) {
+		if (!BM_ELEM_API_FLAG_TEST(faces[i], _FLAG_WALK)) {
+			BM_ELEM_API_FLAG_ENABLE(faces[i], _FLAG_WALK);
+			region->faces[faces_len_new++] = faces[i];
+		}
+	}
+	for (int i = 0; i < faces_len_new; i++) {
+		BM_ELEM_API_FLAG_DISABLE(region->faces[i], _FLAG_WALK);
+	}
+
+	region->faces_len = faces_len_new;
+	bmo_region_sort((void **)region->faces, region->faces_len);
+}
+
+void BMO_region_free(BMOpRegion *region)
+{
+	MEM_SAFE_FREE(region->verts);
+	MEM_SAFE_FREE(region->edges);
+	MEM_SAFE_FREE(region->faces);
+	region->verts_len = region->edges_len = region->faces_len = 0;
+}
+
+typedef struct BMORegionParallelData {
+	BMElem **elems;
+	BMORegionFunc func;
+	void *userdata;
+} BMORegionParallelData;
+
+static void bmo_region_parallel_cb(
+        void *__restrict userdata,
+        const int index,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	BMORegionParallelData *data = userdata;
+	data->func(data->userdata, data->elems[index], index);
+}
+
+/**
+ * Run \a func on each element of one region array, threaded for large regions.
+ *
+ * \note The callback must not change topology or write to other elements,
+ * tool-flags of the element itself may be set.
+ */
+void BMO_region_parallel(BMOpRegion *region, const char htype, BMORegionFunc func, void *userdata)
+{
+	BMORegionParallelData data = {NULL, func, userdata};
+	int elems_len;
+
+	switch (htype) {
+		case BM_VERT:
+			data.elems = (BMElem **)region->verts;
+			elems_len = region->verts_len;
+			break;
+		case BM_EDGE:
+			data.elems = (BMElem **)region->edges;
+			elems_len = region->edges_len;
+			break;
+		case BM_FACE:
+			data.elems = (BMElem **)region->faces;
+			elems_len = region->faces_len;
+			break;
+		default:
+			BLI_assert(0);
+			return;
+	}
+
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (elems_len >= BM_OMP_LIMIT);
+	settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+	settings.min_iter_per_thread = 256;
+	BLI_task_parallel_range(0, elems_len, &data, bmo_region_parallel_cb, &settings);
+}
+
+/** \} */
+
 void BMO_mesh_flag_disable_all(BMesh *bm, BMOperator *UNUSED(op), const char htype, const short oflag)
 {
 	if (htype & BM_VERT) {
@@ -186,19 +186,50 @@ finally:
 }
 
 
+typedef struct WeldFaceData {
+	BMesh *bm;
+	/* -1 when the face has no merged vertices, otherwise the number of collapsed edges */
+	int *edge_collapse;
+} WeldFaceData;
+
+static void remdoubles_face_collapse_cb(void *userdata, BMElem *ele, const int index)
+{
+	WeldFaceData *data = userdata;
+	BMesh *bm = data->bm;
+	BMFace *f = (BMFace *)ele;
+	BMLoop *l_iter, *l_first;
+	bool vert_delete = false;
+	int  edge_collapse = 0;
+
+	l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+	do {
+		if (BMO_vert_flag_test(bm, l_iter->v, ELE_DEL)) {
+			vert_delete = true;
+		}
+		if (BMO_edge_flag_test(bm, l_iter->e, EDGE_COL)) {
+			edge_collapse++;
+		}
+	} while ((l_iter = l_iter->next) != l_first);
+
+	data->edge_collapse[index] = vert_delete ? edge_collapse : -1;
+}
+
 /**
  * \note with 'targetmap', multiple 'keys' are currently supported, though no callers should be using.
  * (because slot maps currently use GHash without the GHASH_FLAG_ALLOW_DUPES flag set)
  *
+ * Only the merged vertices and the edges & faces using them are visited (see #BMOpRegion),
+ * so merging a few vertices of a large mesh doesn't loop over all its geometry.
  */
 void bmo_weld_verts_exec(BMesh *bm, BMOperator *op)
 {
-	BMIter iter, liter;
+	BMOIter siter;
+	BMOpRegion region;
 	BMVert *v;
 	BMEdge *e;
-	BMLoop *l;
 	BMFace *f;
 	BMOpSlot *slot_targetmap = BMO_slot_get(op->slots_in, "targetmap");
+	int i;
 
 	/* Maintain selection history. */
 	const bool has_selected = !BLI_listbase_is_empty(&bm->selected);
@@ -209,8 +240,19 @@ void bmo_weld_verts_exec(BMesh *bm, BMOperator *op)
 		targetmap_all = BLI_ghash_ptr_new(__func__);
 	}
 
+	{
+		BMVert **verts = MEM_mallocN(sizeof(*verts) * (size_t)MAX2(BMO_slot_map_count(op->slots_in, "targetmap"), 1), __func__);
+		int verts_len = 0;
+		BMO_ITER (v, &siter, op->slots_in, "targetmap", 0) {
+			verts[verts_len++] = v;
+		}
+		BMO_region_from_verts(bm, &region, verts, verts_len, BM_FACE);
+		MEM_freeN(verts);
+	}
+
 	/* mark merge verts for deletion */
-	BM_ITER_MESH (v, &iter, bm, BM_VERTS_OF_MESH) {
+	for (i = 0; i < region.verts_len; i++) {
+		v = region.verts[i];
 		BMVert *v_dst = BMO_slot_map_elem_get(slot_targetmap, v);
 		if (v_dst != NULL) {
 			BMO_vert_flag_enable(bm, v, ELE_DEL);
@@ -227,12 +269,23 @@ void bmo_weld_verts_exec(BMesh *bm, BMOperator *op)
 
 	/* check if any faces are getting their own corners merged
 	 * together, split face if so */
-	BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
-		remdoubles_splitface(f, bm, op, slot_targetmap);
+	for (i = 0; i < region.faces_len; i++) {
+		remdoubles_splitface(region.faces[i], bm, op, slot_targetmap);
 	}
 
-	BM_ITER_MESH (e, &iter, bm, BM_EDGES_OF_MESH) {
+	/* expand the region to edges, this includes faces created by splitting */
+	{
+		BMVert **verts = region.verts;
+		const int verts_len = region.verts_len;
+		region.verts = NULL;
+		BMO_region_free(&region);
+		BMO_region_from_verts(bm, &region, verts, verts_len, BM_EDGE | BM_FACE);
+		MEM_freeN(verts);
+	}
+
+	for (i = 0; i < region.edges_len; i++) {
 		BMVert *v1, *v2;
+		e = region.edges[i];
 		const bool is_del_v1 = BMO_vert_flag_test_bool(bm, (v1 = e->v1), ELE_DEL);
 		const bool is_del_v2 = BMO_vert_flag_test_bool(bm, (v2 = e->v2), ELE_DEL);
 
@@ -262,22 +315,19 @@ void bmo_weld_verts_exec(BMesh *bm, BMOperator *op)
 		}
 	}
 
+	WeldFaceData face_data = {
+		.bm = bm,
+		.edge_collapse = MEM_mallocN(sizeof(int) * (size_t)MAX2(region.faces_len, 1), __func__),
+	};
+	BMO_region_parallel(&region, BM_FACE, remdoubles_face_collapse_cb, &face_data);
+
 	/* faces get "modified" by creating new faces here, then at the
 	 * end the old faces are deleted */
-	BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
-		bool vert_delete = false;
-		int  edge_collapse = 0;
+	for (i = 0; i < region.faces_len; i++) {
+		const int edge_collapse = face_data.edge_collapse[i];
+		f = region.faces[i];
 
-		BM_ITER_ELEM (l, &liter, f, BM_LOOPS_OF_FACE) {
-			if (BMO_vert_flag_test(bm, l->v, ELE_DEL)) {
-				vert_delete = true;
-			}
-			if (BMO_edge_flag_test(bm, l->e, EDGE_COL)) {
-				edge_collapse++;
-			}
-		}
-
-		if (vert_delete) {
+		if (edge_collapse != -1) {
 			bool use_in_place = false;
 			BMFace *f_new = NULL;
 			BMO_face_flag_enable(bm, f, ELE_DEL);
@@ -316,6 +366,9 @@ void bmo_weld_verts_exec(BMesh *bm, BMOperator *op)
 		}
 	}
 
+	MEM_freeN(face_data.edge_collapse);
+	BMO_region_free(&region);
+
 	if (has_selected) {
 		BM_select_history_merge_from_targetmap(bm, targetmap_all, targetmap_all, targetmap_all, true);
 	}
@@ -652,8 +705,8 @@ static void bmesh_find_doubles_common(
 			}
 		}
 
-		BLI_kdtree_balance(tree);
-		found_duplicates = BLI_kdtree_calc_duplicates_fast(tree, dist, false, duplicates) != 0;
+		/* the tree is only used for storage, no need to balance it */
+		found_duplicates = BLI_kdtree_calc_duplicates_parallel(tree, dist, duplicates) != 0;
 		BLI_kdtree_free(tree);
 	}
 
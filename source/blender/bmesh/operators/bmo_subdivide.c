@@ -31,8 +31,10 @@
 #include "BLI_math.h"
 #include "BLI_rand.h"
 #include "BLI_array.h"
+#include "BLI_alloca.h"
 #include "BLI_noise.h"
 #include "BLI_stack.h"
+#include "BLI_task.h"
 
 #include "BKE_customdata.h"
 
@@ -886,17 +888,162 @@ typedef struct SubDFaceData {
 	BMFace *face;
 } SubDFaceData;
 
+typedef struct SubDFaceMatchData {
+	BMesh *bm;
+	const SubDParams *params;
+	bool use_only_quads;
+	/* aligned with the faces of the region, SubDFaceData.face is NULL when the face isn't split */
+	SubDFaceData *facedata;
+} SubDFaceMatchData;
+
+/**
+ * Figure out which pattern to use for a face (only reads edge flags, may run in parallel).
+ */
+static void bmo_subd_face_match_cb(void *userdata, BMElem *ele, const int index)
+{
+	SubDFaceMatchData *data = userdata;
+	BMesh *bm = data->bm;
+	BMFace *face = (BMFace *)ele;
+	SubDFaceData *fd = &data->facedata[index];
+	const SubDPattern *pat;
+	BMEdge *e1 = NULL, *e2 = NULL;
+	BMEdge **edges;
+	BMVert **verts;
+	BMIter liter;
+	BMLoop *l_new;
+	float vec1[3], vec2[3];
+	bool matched = false;
+	int totesel, i, j, a, b;
+
+	fd->face = NULL;
+
+	/* skip non-quads if requested */
+	if (data->use_only_quads && face->len != 4)
+		return;
+
+	edges = BLI_array_alloca(edges, face->len);
+	verts = BLI_array_alloca(verts, face->len);
+
+	totesel = 0;
+	BM_ITER_ELEM_INDEX (l_new, &liter, face, BM_LOOPS_OF_FACE, i) {
+		edges[i] = l_new->e;
+		verts[i] = l_new->v;
+
+		if (BMO_edge_flag_test(bm, edges[i], SUBD_SPLIT)) {
+			if (!e1) e1 = edges[i];
+			else     e2 = edges[i];
+
+			totesel++;
+		}
+	}
+
+	/* make sure the two edges have a valid angle to each other */
+	if (totesel == 2 && BM_edge_share_vert_check(e1, e2)) {
+		sub_v3_v3v3(vec1, e1->v2->co, e1->v1->co);
+		sub_v3_v3v3(vec2, e2->v2->co, e2->v1->co);
+		normalize_v3(vec1);
+		normalize_v3(vec2);
+
+		if (fabsf(dot_v3v3(vec1, vec2)) > 1.0f - FLT_FACE_SPLIT_EPSILON) {
+			totesel = 0;
+		}
+	}
+
+	if (BMO_face_flag_test(bm, face, FACE_CUSTOMFILL)) {
+		pat = *BMO_slot_map_data_get(data->params->slot_custom_patterns, face);
+		for (i = 0; i < pat->len; i++) {
+			matched = 1;
+			for (j = 0; j < pat->len; j++) {
+				a = (j + i) % pat->len;
+				if ((!!BMO_edge_flag_test(bm, edges[a], SUBD_SPLIT)) != (!!pat->seledges[j])) {
+					matched = 0;
+					break;
+				}
+			}
+			if (matched) {
+				fd->pat = pat;
+				fd->start = verts[i];
+				fd->face = face;
+				fd->totedgesel = totesel;
+				BMO_face_flag_enable(bm, face, SUBD_SPLIT);
+				break;
+			}
+		}
+
+		/* obvously don't test for other patterns matching */
+		return;
+	}
+
+	for (i = 0; i < PATTERNS_TOT; i++) {
+		pat = patterns[i];
+		if (!pat) {
+			continue;
+		}
+
+		if (pat->len == face->len) {
+			for (a = 0; a < pat->len; a++) {
+				matched = 1;
+				for (b = 0; b < pat->len; b++) {
+					j = (b + a) % pat->len;
+					if ((!!BMO_edge_flag_test(bm, edges[j], SUBD_SPLIT)) != (!!pat->seledges[b])) {
+						matched = 0;
+						break;
+					}
+				}
+				if (matched) {
+					break;
+				}
+			}
+			if (matched) {
+				BMO_face_flag_enable(bm, face, SUBD_SPLIT);
+
+				fd->pat = pat;
+				fd->start = verts[a];
+				fd->face = face;
+				fd->totedgesel = totesel;
+				break;
+			}
+		}
+
+	}
+
+	if (!matched && totesel) {
+		BMO_face_flag_enable(bm, face, SUBD_SPLIT);
+
+		/* must initialize all members here */
+		fd->start = NULL;
+		fd->pat = NULL;
+		fd->totedgesel = totesel;
+		fd->face = face;
+	}
+}
+
+static void bmo_subd_vert_shape_store_cb(void *userdata, MempoolIterData *iter)
+{
+	const SubDParams *params = userdata;
+	BMVert *v = (BMVert *)iter;
+	float *co = BM_ELEM_CD_GET_VOID_P(v, params->shape_info.cd_vert_shape_offset_tmp);
+	copy_v3_v3(co, v->co);
+}
+
+static void bmo_subd_vert_shape_restore_cb(void *userdata, MempoolIterData *iter)
+{
+	const SubDParams *params = userdata;
+	BMVert *v = (BMVert *)iter;
+	const float *co = BM_ELEM_CD_GET_VOID_P(v, params->shape_info.cd_vert_shape_offset_tmp);
+	copy_v3_v3(v->co, co);
+}
+
 void bmo_subdivide_edges_exec(BMesh *bm, BMOperator *op)
 {
 	BMOpSlot *einput;
+	BMOpRegion region;
 	const SubDPattern *pat;
 	SubDParams params;
 	BLI_Stack *facedata;
-	BMIter viter, fiter, liter;
-	BMVert *v, **verts = NULL;
+	BMIter liter;
+	BMVert **verts = NULL;
 	BMEdge *edge;
-	BMEdge **edges = NULL;
-	BLI_array_declare(edges);
 	BMLoop *(*loops_split)[2] = NULL;
 	BLI_array_declare(loops_split);
 	BMLoop **loops = NULL;
@@ -906,7 +1053,7 @@ void bmo_subdivide_edges_exec(BMesh *bm, BMOperator *op)
 	BLI_array_declare(verts);
 	float smooth, fractal, along_normal;
 	bool use_sphere, use_single_edge, use_grid_fill, use_only_quads;
-	int cornertype, seed, i, j, a, b, numcuts, totesel, smooth_falloff;
+	int cornertype, seed, i, j, a, b = 0, numcuts, smooth_falloff;
 
 	BMO_slot_buffer_flag_enable(bm, op->slots_in, "edges", BM_EDGE, SUBD_SPLIT);
 
@@ -960,10 +1107,7 @@ void bmo_subdivide_edges_exec(BMesh *bm, BMOperator *op)
 
 	bmo_subd_init_shape_info(bm, &params);
 
-	BM_ITER_MESH (v, &viter, bm, BM_VERTS_OF_MESH) {
-		float *co = BM_ELEM_CD_GET_VOID_P(v, params.shape_info.cd_vert_shape_offset_tmp);
-		copy_v3_v3(co, v->co);
-	}
+	BM_iter_parallel(bm, BM_VERTS_OF_MESH, bmo_subd_vert_shape_store_cb, &params, bm->totvert >= BM_OMP_LIMIT);
 
 	/* first go through and tag edges */
 	BMO_slot_buffer_from_enabled_flag(bm, op, op->slots_in, "edges", BM_EDGE, SUBD_SPLIT);
@@ -1001,126 +1145,43 @@ void bmo_subdivide_edges_exec(BMesh *bm, BMOperator *op)
 
 	facedata = BLI_stack_new(sizeof(SubDFaceData), __func__);
 
-	BM_ITER_MESH (face, &fiter, bm, BM_FACES_OF_MESH) {
-		BMEdge *e1 = NULL, *e2 = NULL;
-		float vec1[3], vec2[3];
-		bool matched = false;
-
-		/* skip non-quads if requested */
-		if (use_only_quads && face->len != 4)
-			continue;
-
-		/* figure out which pattern to use */
-
-		BLI_array_clear(edges);
-		BLI_array_clear(verts);
-
-		BLI_array_grow_items(edges, face->len);
-		BLI_array_grow_items(verts, face->len);
-
-		totesel = 0;
-		BM_ITER_ELEM_INDEX (l_new, &liter, face, BM_LOOPS_OF_FACE, i) {
-			edges[i] = l_new->e;
-			verts[i] = l_new->v;
-
-			if (BMO_edge_flag_test(bm, edges[i], SUBD_SPLIT)) {
-				if (!e1) e1 = edges[i];
-				else     e2 = edges[i];
-
-				totesel++;
-			}
-		}
-
-		/* make sure the two edges have a valid angle to each other */
-		if (totesel == 2 && BM_edge_share_vert_check(e1, e2)) {
-			sub_v3_v3v3(vec1, e1->v2->co, e1->v1->co);
-			sub_v3_v3v3(vec2, e2->v2->co, e2->v1->co);
-			normalize_v3(vec1);
-			normalize_v3(vec2);
-
-			if (fabsf(dot_v3v3(vec1, vec2)) > 1.0f - FLT_FACE_SPLIT_EPSILON) {
-				totesel = 0;
-			}
-		}
-
-		if (BMO_face_flag_test(bm, face, FACE_CUSTOMFILL)) {
-			pat = *BMO_slot_map_data_get(params.slot_custom_patterns, face);
-			for (i = 0; i < pat->len; i++) {
-				matched = 1;
-				for (j = 0; j < pat->len; j++) {
-					a = (j + i) % pat->len;
-					if ((!!BMO_edge_flag_test(bm, edges[a], SUBD_SPLIT)) != (!!pat->seledges[j])) {
-						matched = 0;
-						break;
-					}
-				}
-				if (matched) {
-					SubDFaceData *fd;
-
-					fd = BLI_stack_push_r(facedata);
-					fd->pat = pat;
-					fd->start = verts[i];
-					fd->face = face;
-					fd->totedgesel = totesel;
-					BMO_face_flag_enable(bm, face, SUBD_SPLIT);
-					break;
-				}
-			}
-
-			/* obvously don't test for other patterns matching */
-			continue;
+	/* only faces using split edges (or with custom patterns) can match a pattern */
+	{
+		BMOpSlot *slot_edges = BMO_slot_get(op->slots_in, "edges");
+		BMO_region_from_edges(bm, &region, (BMEdge **)slot_edges->data.buf, slot_edges->len, BM_FACE);
+	}
+	if (BMO_slot_map_count(op->slots_in, "custom_patterns") != 0) {
+		BMFace **faces = MEM_mallocN(sizeof(*faces) * (size_t)BMO_slot_map_count(op->slots_in, "custom_patterns"), __func__);
+		int faces_len = 0;
+		BMOIter siter;
+		BMO_ITER (face, &siter, op->slots_in, "custom_patterns", 0) {
+			faces[faces_len++] = face;
 		}
+		BMO_region_faces_append(bm, &region, faces, faces_len);
+		MEM_freeN(faces);
+	}
 
-		for (i = 0; i < PATTERNS_TOT; i++) {
-			pat = patterns[i];
-			if (!pat) {
-				continue;
-			}
-
-			if (pat->len == face->len) {
-				for (a = 0; a < pat->len; a++) {
-					matched = 1;
-					for (b = 0; b < pat->len; b++) {
-						j = (b + a) % pat->len;
-						if ((!!BMO_edge_flag_test(bm, edges[j], SUBD_SPLIT)) != (!!pat->seledges[b])) {
-							matched = 0;
-							break;
-						}
-					}
-					if (matched) {
-						break;
-					}
-				}
-				if (matched) {
-					SubDFaceData *fd;
-
-					BMO_face_flag_enable(bm, face, SUBD_SPLIT);
-
-					fd = BLI_stack_push_r(facedata);
-					fd->pat = pat;
-					fd->start = verts[a];
-					fd->face = face;
-					fd->totedgesel = totesel;
-					break;
-				}
+	{
+		SubDFaceMatchData match_data = {
+			.bm = bm,
+			.params = &params,
+			.use_only_quads = use_only_quads,
+			.facedata = MEM_mallocN(sizeof(SubDFaceData) * (size_t)MAX2(region.faces_len, 1), __func__),
+		};
+
+		BMO_region_parallel(&region, BM_FACE, bmo_subd_face_match_cb, &match_data);
+
+		for (i = 0; i < region.faces_len; i++) {
+			if (match_data.facedata[i].face) {
+				*((SubDFaceData *)BLI_stack_push_r(facedata)) = match_data.facedata[i];
 			}
-
 		}
 
-		if (!matched && totesel) {
-			SubDFaceData *fd;
-
-			BMO_face_flag_enable(bm, face, SUBD_SPLIT);
-
-			/* must initialize all members here */
-			fd = BLI_stack_push_r(facedata);
-			fd->start = NULL;
-			fd->pat = NULL;
-			fd->totedgesel = totesel;
-			fd->face = face;
-		}
+		MEM_freeN(match_data.facedata);
 	}
 
+	BMO_region_free(&region);
+
 	einput = BMO_slot_get(op->slots_in, "edges");
 
 	/* go through and split edges */
@@ -1130,10 +1191,7 @@ void bmo_subdivide_edges_exec(BMesh *bm, BMOperator *op)
 	}
 
 	/* copy original-geometry displacements to current coordinates */
-	BM_ITER_MESH (v, &viter, bm, BM_VERTS_OF_MESH) {
-		const float *co = BM_ELEM_CD_GET_VOID_P(v, params.shape_info.cd_vert_shape_offset_tmp);
-		copy_v3_v3(v->co, co);
-	}
+	BM_iter_parallel(bm, BM_VERTS_OF_MESH, bmo_subd_vert_shape_restore_cb, &params, bm->totvert >= BM_OMP_LIMIT);
 
 	for (; !BLI_stack_is_empty(facedata); BLI_stack_discard(facedata)) {
 		SubDFaceData *fd = BLI_stack_peek(facedata);
@@ -1276,15 +1334,11 @@ void bmo_subdivide_edges_exec(BMesh *bm, BMOperator *op)
 	}
 
 	/* copy original-geometry displacements to current coordinates */
-	BM_ITER_MESH (v, &viter, bm, BM_VERTS_OF_MESH) {
-		const float *co = BM_ELEM_CD_GET_VOID_P(v, params.shape_info.cd_vert_shape_offset_tmp);
-		copy_v3_v3(v->co, co);
-	}
+	BM_iter_parallel(bm, BM_VERTS_OF_MESH, bmo_subd_vert_shape_restore_cb, &params, bm->totvert >= BM_OMP_LIMIT);
 
 	BM_data_layer_free_n(bm, &bm->vdata, CD_SHAPEKEY, params.shape_info.tmpkey);
 
 	BLI_stack_free(facedata);
-	if (edges) BLI_array_free(edges);
 	if (verts) BLI_array_free(verts);
 	BLI_array_free(loops_split);
 	BLI_array_free(loops);
@@ -50,6 +50,7 @@
 
 #include "BLI_kdopbvh.h"
 #include "BLI_buffer.h"
+#include "BLI_task.h"
 
 #include "bmesh.h"
 #include "intern/bmesh_private.h"
@@ -964,6 +965,234 @@ static int isect_bvhtree_point_v3(
 	return num_isect;
 }
 
+/* -------------------------------------------------------------------- */
+/* Threaded Overlap & Winding Number
+ *
+ * Used with #BMESH_ISECT_FLAG_THREADED, the overlap callback rejects triangle pairs
+ * that can't touch (in parallel, while the BVH trees are traversed),
+ * so the serial cutting pass only visits pairs which may intersect.
+ *
+ * With #BMESH_ISECT_FLAG_WINDING, inside/outside is calculated using the winding number
+ * (signed crossings) instead of the crossing parity, this handles operands made of
+ * overlapping shells, and is evaluated for all face-groups in parallel. */
+
+struct OverlapFilterData {
+	BMLoop *(*looptris)[3];
+	float eps_margin;
+};
+
+/**
+ * Returns false when all points of \a tri_a are on one side of the plane of \a tri_b.
+ */
+static bool isect_tri_plane_side_test(
+        const float *tri_a[3], const float *tri_b[3], const float eps)
+{
+	float plane[4];
+	float nor[3];
+
+	if (normal_tri_v3(nor, UNPACK3(tri_b)) == 0.0f) {
+		/* degenerate, we can't reject */
+		return true;
+	}
+	plane_from_point_normal_v3(plane, tri_b[0], nor);
+
+	const float d0 = plane_point_side_v3(plane, tri_a[0]);
+	const float d1 = plane_point_side_v3(plane, tri_a[1]);
+	const float d2 = plane_point_side_v3(plane, tri_a[2]);
+
+	if ((d0 > eps && d1 > eps && d2 > eps) ||
+	    (d0 < -eps && d1 < -eps && d2 < -eps))
+	{
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Conservative test (may return true for pairs which don't intersect),
+ * must never reject pairs #bm_isect_tri_tri would cut.
+ *
+ * \note Runs from multiple threads, only reads vertex coordinates.
+ */
+static bool bm_isect_overlap_filter_cb(void *userdata, int index_a, int index_b, int UNUSED(thread))
+{
+	struct OverlapFilterData *data = userdata;
+	BMLoop **a = data->looptris[index_a];
+	BMLoop **b = data->looptris[index_b];
+	const float *f_a_cos[3] = {UNPACK3_EX(, a, ->v->co)};
+	const float *f_b_cos[3] = {UNPACK3_EX(, b, ->v->co)};
+
+	return (isect_tri_plane_side_test(f_a_cos, f_b_cos, data->eps_margin) &&
+	        isect_tri_plane_side_test(f_b_cos, f_a_cos, data->eps_margin));
+}
+
+struct WindingHit {
+	float depth;
+	int sign;
+};
+
+struct WindingRaycastData {
+	const float **looptris;
+	BLI_Buffer *z_buffer;
+	const float *direction;
+};
+
+static void raycast_winding_callback(
+        void *userdata,
+        int index,
+        const BVHTreeRay *ray,
+        BVHTreeRayHit *UNUSED(hit))
+{
+	struct WindingRaycastData *raycast_data = userdata;
+	const float **looptris = raycast_data->looptris;
+	const float *v0 = looptris[index * 3 + 0];
+	const float *v1 = looptris[index * 3 + 1];
+	const float *v2 = looptris[index * 3 + 2];
+	float dist;
+
+	if (isect_ray_tri_epsilon_v3(ray->origin, ray->direction, v0, v1, v2, &dist, NULL, FLT_EPSILON)) {
+		if (dist >= 0.0f) {
+			float nor[3];
+			normal_tri_v3(nor, v0, v1, v2);
+			const float d = dot_v3v3(nor, raycast_data->direction);
+			if (d != 0.0f) {
+				struct WindingHit w_hit = {dist, (d > 0.0f) ? 1 : -1};
+				BLI_buffer_append(raycast_data->z_buffer, struct WindingHit, w_hit);
+			}
+		}
+	}
+}
+
+static int bm_winding_hit_cmp(const void *a_v, const void *b_v)
+{
+	const struct WindingHit *a = a_v, *b = b_v;
+	if      (a->depth > b->depth) return  1;
+	else if (a->depth < b->depth) return -1;
+	else                          return  0;
+}
+
+/**
+ * Signed number of times the surface winds around \a co, when cast along \a dir.
+ * Hits at the same depth with the same sign are counted once (ray passing through an edge).
+ */
+static int isect_bvhtree_point_winding_dir_v3(
+        BVHTree *tree,
+        const float **looptris,
+        const float co[3], const float dir[3])
+{
+	BLI_buffer_declare_static(struct WindingHit, z_buffer, BLI_BUFFER_NOP, 64);
+
+	struct WindingRaycastData raycast_data = {
+		looptris,
+		&z_buffer,
+		dir,
+	};
+	BVHTreeRayHit hit = {0};
+
+	hit.index = -1;
+	hit.dist = BVH_RAYCAST_DIST_MAX;
+
+	BLI_bvhtree_ray_cast(tree,
+	                     co, dir,
+	                     0.0f,
+	                     &hit,
+	                     raycast_winding_callback,
+	                     &raycast_data);
+
+	int winding = 0;
+
+	if (z_buffer.count != 0) {
+		const float eps = FLT_EPSILON * 10;
+		struct WindingHit *hit_arr = z_buffer.data;
+
+		qsort(hit_arr, z_buffer.count, sizeof(*hit_arr), bm_winding_hit_cmp);
+
+		winding = hit_arr[0].sign;
+		for (uint i = 1, i_last = 0; i < z_buffer.count; i++) {
+			if ((hit_arr[i].depth - hit_arr[i_last].depth > eps) ||
+			    (hit_arr[i].sign != hit_arr[i_last].sign))
+			{
+				winding += hit_arr[i].sign;
+				i_last = i;
+			}
+		}
+	}
+
+	BLI_buffer_free(&z_buffer);
+
+	return winding;
+}
+
+/**
+ * Use the majority of three axis aligned rays,
+ * so a single ray grazing an edge or a crack in the surface doesn't flip the result.
+ */
+static bool isect_bvhtree_point_winding_inside_v3(
+        BVHTree *tree,
+        const float **looptris,
+        const float co[3])
+{
+	static const float dirs[3][3] = {
+		{1.0f, 0.0f, 0.0f},
+		{0.0f, 1.0f, 0.0f},
+		{0.0f, 0.0f, 1.0f},
+	};
+	int inside_tot = 0;
+
+	for (int i = 0; i < 3; i++) {
+		if (isect_bvhtree_point_winding_dir_v3(tree, looptris, co, dirs[i]) > 0) {
+			inside_tot += 1;
+		}
+		/* early exit once the majority is known */
+		if ((inside_tot == 2) || (inside_tot + (2 - i) < 2)) {
+			break;
+		}
+	}
+	return (inside_tot >= 2);
+}
+
+struct GroupInsideData {
+	BMFace **ftable;
+	const int *groups_array;
+	const int (*group_index)[2];
+	int (*test_fn)(BMFace *f, void *user_data);
+	void *user_data;
+	BVHTree **tree_pair;
+	const float **looptri_coords;
+	bool use_winding;
+	/* -1: skip, 0: outside, 1: inside */
+	signed char *r_group_inside;
+};
+
+static void bm_isect_group_inside_cb(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	struct GroupInsideData *data = userdata;
+	BMFace *f = data->ftable[data->groups_array[data->group_index[i][0]]];
+	float co[3];
+	int side = data->test_fn(f, data->user_data);
+
+	if (side == -1) {
+		data->r_group_inside[i] = -1;
+		return;
+	}
+	BLI_assert(ELEM(side, 0, 1));
+	side = !side;
+
+	BM_face_calc_point_in_face(f, co);
+
+	bool is_inside;
+	if (data->use_winding) {
+		is_inside = isect_bvhtree_point_winding_inside_v3(data->tree_pair[side], data->looptri_coords, co);
+	}
+	else {
+		is_inside = (isect_bvhtree_point_v3(data->tree_pair[side], data->looptri_coords, co) & 1) == 1;
+	}
+	data->r_group_inside[i] = (signed char)is_inside;
+}
+
 #endif  /* USE_BVH */
 
 /**
@@ -972,15 +1201,16 @@ static int isect_bvhtree_point_v3(
  *
  * \param test_fn: Return value: -1: skip, 0: tree_a, 1: tree_b (use_self == false)
  * \param boolean_mode -1: no-boolean, 0: intersection... see #BMESH_ISECT_BOOLEAN_ISECT.
+ * \param flag: Options for the intersection engine, see #BMESH_ISECT_FLAG_THREADED.
  * \return true if the mesh is changed (intersections cut or faces removed from boolean).
  */
-bool BM_mesh_intersect(
+bool BM_mesh_intersect_ex(
         BMesh *bm,
         struct BMLoop *(*looptris)[3], const int looptris_tot,
         int (*test_fn)(BMFace *f, void *user_data), void *user_data,
         const bool use_self, const bool use_separate, const bool use_dissolve, const bool use_island_connect,
         const bool use_partial_connect, const bool use_edge_tag, const int boolean_mode,
-        const float eps)
+        const float eps, const int flag)
 {
 	struct ISectState s;
 	const int totface_orig = bm->totface;
@@ -1103,7 +1333,18 @@ bool BM_mesh_intersect(
 		tree_b = tree_a;
 	}
 
-	overlap = BLI_bvhtree_overlap(tree_b, tree_a, &tree_overlap_tot, NULL, NULL);
+	if (flag & BMESH_ISECT_FLAG_THREADED) {
+		struct OverlapFilterData overlap_filter_data = {
+			.looptris = looptris,
+			.eps_margin = s.epsilon.eps_margin,
+		};
+		overlap = BLI_bvhtree_overlap(
+		        tree_b, tree_a, &tree_overlap_tot,
+		        bm_isect_overlap_filter_cb, &overlap_filter_data);
+	}
+	else {
+		overlap = BLI_bvhtree_overlap(tree_b, tree_a, &tree_overlap_tot, NULL, NULL);
+	}
 
 	if (overlap) {
 		uint i;
@@ -1558,6 +1799,33 @@ bool BM_mesh_intersect(
 		printf("%s: Total face-groups: %d\n", __func__, group_tot);
 #endif
 
+		/* Calculate inside/outside for all islands up-front,
+		 * this only reads from the mesh so it can run in parallel. */
+		signed char *group_inside = MEM_mallocN(sizeof(*group_inside) * (size_t)max_ii(group_tot, 1), __func__);
+		{
+			struct GroupInsideData group_inside_data = {
+				.ftable = ftable,
+				.groups_array = groups_array,
+				.group_index = (const int (*)[2])group_index,
+				.test_fn = test_fn,
+				.user_data = user_data,
+				.tree_pair = tree_pair,
+				.looptri_coords = looptri_coords,
+				.use_winding = (flag & BMESH_ISECT_FLAG_WINDING) != 0,
+				.r_group_inside = group_inside,
+			};
+
+			ParallelRangeSettings settings;
+			BLI_parallel_range_settings_defaults(&settings);
+			settings.use_threading = (flag & BMESH_ISECT_FLAG_THREADED) != 0;
+			settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+			BLI_task_parallel_range(
+			        0, group_tot,
+			        &group_inside_data,
+			        bm_isect_group_inside_cb,
+			        &settings);
+		}
+
 		/* Check if island is inside/outside */
 		for (i = 0; i < group_tot; i++) {
 			int fg     = group_index[i][0];
@@ -1567,32 +1835,26 @@ bool BM_mesh_intersect(
 			{
 				/* for now assyme this is an OK face to test with (not degenerate!) */
 				BMFace *f = ftable[groups_array[fg]];
-				float co[3];
-				int hits;
-				int side = test_fn(f, user_data);
+				bool is_inside;
+				int side;
 
-				if (side == -1) {
+				if (group_inside[i] == -1) {
 					continue;
 				}
-				BLI_assert(ELEM(side, 0, 1));
-				side = !side;
-
-				// BM_face_calc_center_median(f, co);
-				BM_face_calc_point_in_face(f, co);
-
-				hits = isect_bvhtree_point_v3(tree_pair[side], looptri_coords, co);
+				is_inside = (group_inside[i] == 1);
+				side = !test_fn(f, user_data);
 
 				switch (boolean_mode) {
 					case BMESH_ISECT_BOOLEAN_ISECT:
-						do_remove = ((hits & 1) != 1);
+						do_remove = !is_inside;
 						do_flip = false;
 						break;
 					case BMESH_ISECT_BOOLEAN_UNION:
-						do_remove = ((hits & 1) == 1);
+						do_remove = is_inside;
 						do_flip = false;
 						break;
 					case BMESH_ISECT_BOOLEAN_DIFFERENCE:
-						do_remove = ((hits & 1) == 1) == side;
+						do_remove = is_inside == side;
 						do_flip = (side == 0);
 						break;
 				}
@@ -1614,6 +1876,7 @@ bool BM_mesh_intersect(
 			has_edit_boolean |= (do_flip || do_remove);
 		}
 
+		MEM_freeN(group_inside);
 		MEM_freeN(groups_array);
 		MEM_freeN(group_index);
 
@@ -1681,3 +1944,20 @@ bool BM_mesh_intersect(
 
 	return (has_edit_isect || has_edit_boolean);
 }
+
+bool BM_mesh_intersect(
+        BMesh *bm,
+        struct BMLoop *(*looptris)[3], const int looptris_tot,
+        int (*test_fn)(BMFace *f, void *user_data), void *user_data,
+        const bool use_self, const bool use_separate, const bool use_dissolve, const bool use_island_connect,
+        const bool use_partial_connect, const bool use_edge_tag, const int boolean_mode,
+        const float eps)
+{
+	return BM_mesh_intersect_ex(
+	        bm,
+	        looptris, looptris_tot,
+	        test_fn, user_data,
+	        use_self, use_separate, use_dissolve, use_island_connect,
+	        use_partial_connect, use_edge_tag, boolean_mode,
+	        eps, 0);
+}
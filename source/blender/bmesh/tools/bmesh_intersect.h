@@ -32,6 +32,23 @@ bool BM_mesh_intersect(
         const bool use_self, const bool use_separate, const bool use_dissolve, const bool use_island_connect,
         const bool use_partial_connect, const bool use_edge_tag, const int boolean_mode,
         const float eps);
+bool BM_mesh_intersect_ex(
+        BMesh *bm,
+        struct BMLoop *(*looptris)[3], const int looptris_tot,
+        int (*test_fn)(BMFace *f, void *user_data), void *user_data,
+        const bool use_self, const bool use_separate, const bool use_dissolve, const bool use_island_connect,
+        const bool use_partial_connect, const bool use_edge_tag, const int boolean_mode,
+        const float eps, const int flag);
+
+/* BM_mesh_intersect_ex flag */
+enum {
+	/* Reject non-touching triangle pairs while traversing the BVH (threaded),
+	 * and calculate inside/outside for face-groups in parallel. */
+	BMESH_ISECT_FLAG_THREADED = (1 << 0),
+	/* Use the winding number for inside/outside tests (instead of even/odd crossings),
+	 * needed for operands with overlapping or nested shells. */
+	BMESH_ISECT_FLAG_WINDING  = (1 << 1),
+};
 
 enum {
 	BMESH_ISECT_BOOLEAN_NONE = -1,
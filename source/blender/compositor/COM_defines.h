@@ -72,7 +72,8 @@ typedef enum CompositorPriority {
 
 // workscheduler threading models
 /**
- * COM_TM_QUEUE is a multithreaded model, which uses the BLI_thread_queue pattern. This is the default option.
+ * COM_TM_QUEUE is a multithreaded model. CPU chunks are put in a queue per thread, idle threads steal chunks
+ * from the queues of other threads. OpenCL chunks use the BLI_thread_queue pattern. This is the default option.
  */
 #define COM_TM_QUEUE 1
 
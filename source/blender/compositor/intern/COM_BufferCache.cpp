@@ -0,0 +1,460 @@
+/*
+ * Copyright 2018, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <string.h>
+#include <typeinfo>
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_listbase.h"
+#include "BLI_math_base.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_node_types.h"
+#include "DNA_scene_types.h"
+#include "DNA_userdef_types.h"
+
+#include "RNA_access.h"
+}
+
+#include "COM_BufferCache.h"
+#include "COM_ExecutionGroup.h"
+#include "COM_MemoryProxy.h"
+#include "COM_NodeOperation.h"
+#include "COM_ReadBufferOperation.h"
+#include "COM_WriteBufferOperation.h"
+
+/* nested pointers (curve mappings, image users...) are written to the key up to this depth */
+#define KEY_RNA_MAX_DEPTH 4
+
+typedef std::list<const std::string *> BufferCacheLRU;
+
+typedef struct BufferCacheEntry {
+	MemoryBuffer *buffer;
+	DataType datatype;
+	size_t size;
+	/* position in the least recently used list, the front is freed first */
+	BufferCacheLRU::iterator lru_link;
+} BufferCacheEntry;
+
+typedef std::map<std::string, BufferCacheEntry> BufferCacheEntries;
+typedef std::map<NodeOperation *, int> OperationIndices;
+
+static ThreadMutex s_cacheMutex = BLI_MUTEX_INITIALIZER;
+static BufferCacheEntries s_entries;
+static BufferCacheLRU s_lru;
+static size_t s_totalSize = 0;
+/* version of nodes which read data outside of their settings, increased every time they are tagged for execution */
+static std::map<const bNode *, unsigned int> s_sourceNodeVersions;
+/* write buffers restored by the last #BufferCache::restoreBuffers call */
+static std::set<WriteBufferOperation *> s_restored;
+
+static void key_add(std::string &key, const void *data, size_t size)
+{
+	key.append((const char *)data, size);
+}
+
+static void key_add_int(std::string &key, int value)
+{
+	key_add(key, &value, sizeof(value));
+}
+
+static void key_add_string(std::string &key, const char *str)
+{
+	const size_t len = strlen(str);
+	key_add_int(key, (int)len);
+	key_add(key, str, len);
+}
+
+static void key_add_rna_struct(std::string &key, PointerRNA *ptr, StructRNA *skip_srna, int depth)
+{
+	RNA_STRUCT_BEGIN (ptr, prop)
+	{
+		const char *identifier = RNA_property_identifier(prop);
+		const PropertyType type = RNA_property_type(prop);
+		const int len = RNA_property_array_length(ptr, prop);
+
+		/* generic properties (name, location, select...) don't change the result */
+		if (STREQ(identifier, "rna_type") ||
+		    (skip_srna && RNA_struct_type_find_property(skip_srna, identifier)))
+		{
+			continue;
+		}
+
+		switch (type) {
+			case PROP_BOOLEAN:
+			{
+				if (len == 0) {
+					key_add_int(key, RNA_property_boolean_get(ptr, prop));
+				}
+				else {
+					bool *values = (bool *)MEM_mallocN(sizeof(*values) * (size_t)len, __func__);
+					RNA_property_boolean_get_array(ptr, prop, values);
+					key_add(key, values, sizeof(*values) * (size_t)len);
+					MEM_freeN(values);
+				}
+				break;
+			}
+			case PROP_INT:
+			{
+				if (len == 0) {
+					key_add_int(key, RNA_property_int_get(ptr, prop));
+				}
+				else {
+					int *values = (int *)MEM_mallocN(sizeof(*values) * (size_t)len, __func__);
+					RNA_property_int_get_array(ptr, prop, values);
+					key_add(key, values, sizeof(*values) * (size_t)len);
+					MEM_freeN(values);
+				}
+				break;
+			}
+			case PROP_FLOAT:
+			{
+				if (len == 0) {
+					const float value = RNA_property_float_get(ptr, prop);
+					key_add(key, &value, sizeof(value));
+				}
+				else {
+					float *values = (float *)MEM_mallocN(sizeof(*values) * (size_t)len, __func__);
+					RNA_property_float_get_array(ptr, prop, values);
+					key_add(key, values, sizeof(*values) * (size_t)len);
+					MEM_freeN(values);
+				}
+				break;
+			}
+			case PROP_ENUM:
+				key_add_int(key, RNA_property_enum_get(ptr, prop));
+				break;
+			case PROP_STRING:
+			{
+				char buf[256];
+				int buf_len;
+				char *str = RNA_property_string_get_alloc(ptr, prop, buf, sizeof(buf), &buf_len);
+				key_add_int(key, buf_len);
+				key_add(key, str, (size_t)buf_len);
+				if (str != buf) {
+					MEM_freeN(str);
+				}
+				break;
+			}
+			case PROP_POINTER:
+			{
+				PointerRNA value = RNA_property_pointer_get(ptr, prop);
+				if (value.data == NULL) {
+					key_add_int(key, 0);
+				}
+				else if (RNA_struct_is_ID(value.type)) {
+					/* data-block contents are handled by the source node versions */
+					key_add(key, &value.data, sizeof(value.data));
+				}
+				else if (depth < KEY_RNA_MAX_DEPTH) {
+					key_add_rna_struct(key, &value, NULL, depth + 1);
+				}
+				break;
+			}
+			case PROP_COLLECTION:
+			{
+				key_add_int(key, RNA_property_collection_length(ptr, prop));
+				if (depth < KEY_RNA_MAX_DEPTH) {
+					RNA_PROP_BEGIN (ptr, itemptr, prop)
+					{
+						key_add_rna_struct(key, &itemptr, NULL, depth + 1);
+					}
+					RNA_PROP_END;
+				}
+				break;
+			}
+		}
+	}
+	RNA_STRUCT_END;
+}
+
+std::string BufferCache::nodeKey(bNodeTree *ntree, bNode *node)
+{
+	std::string key;
+	PointerRNA ptr;
+
+	if (node == NULL) {
+		return key;
+	}
+
+	key_add_int(key, node->type);
+	key_add_int(key, (node->flag & NODE_MUTED) != 0);
+
+	RNA_pointer_create((ID *)ntree, &RNA_Node, node, &ptr);
+	key_add_rna_struct(key, &ptr, &RNA_Node, 0);
+
+	/* nodes reading images, render results, masks... can't tell when their data changed,
+	 * use a version which is increased every time they are tagged for execution */
+	if (node->id != NULL || BLI_listbase_is_empty(&node->inputs)) {
+		const bNode *source = node->original ? node->original : node;
+
+		BLI_mutex_lock(&s_cacheMutex);
+		unsigned int &version = s_sourceNodeVersions[source];
+		if (node->need_exec) {
+			version++;
+		}
+		key_add(key, &source, sizeof(source));
+		key_add_int(key, (int)version);
+		BLI_mutex_unlock(&s_cacheMutex);
+	}
+
+	return key;
+}
+
+/**
+ * Write the operations a buffer is calculated from, inputs first.
+ * Operations are referenced by the position of their record, so shared inputs are written once.
+ * \return position of the record of \a operation
+ */
+static int key_add_operation(std::string &key, NodeOperation *operation, OperationIndices &indices)
+{
+	OperationIndices::iterator found = indices.find(operation);
+	if (found != indices.end()) {
+		return found->second;
+	}
+
+	const unsigned int num_inputs = operation->getNumberOfInputSockets();
+	std::vector<int> input_indices(num_inputs, -1);
+	int write_index = -1;
+
+	if (operation->isReadBufferOperation()) {
+		/* continue with the operations writing the buffer */
+		MemoryProxy *proxy = ((ReadBufferOperation *)operation)->getMemoryProxy();
+		WriteBufferOperation *writeOperation = proxy ? proxy->getWriteBufferOperation() : NULL;
+		if (writeOperation) {
+			write_index = key_add_operation(key, writeOperation, indices);
+		}
+	}
+	for (unsigned int index = 0; index < num_inputs; index++) {
+		NodeOperationInput *input = operation->getInputSocket(index);
+		if (input->isConnected()) {
+			input_indices[index] = key_add_operation(key, &input->getLink()->getOperation(), indices);
+		}
+	}
+
+	key_add_string(key, typeid(*operation).name());
+	key_add_int(key, (int)operation->getNodeKey().size());
+	key.append(operation->getNodeKey());
+	key_add_int(key, (int)operation->getWidth());
+	key_add_int(key, (int)operation->getHeight());
+
+	if (operation->isSetOperation()) {
+		float value[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+		operation->readSampled(value, 0, 0, COM_PS_NEAREST);
+		key_add(key, value, sizeof(value));
+	}
+	key_add_int(key, write_index);
+
+	key_add_int(key, (int)num_inputs);
+	for (unsigned int index = 0; index < num_inputs; index++) {
+		NodeOperationInput *input = operation->getInputSocket(index);
+
+		key_add_int(key, (int)input->getDataType());
+		key_add_int(key, (int)input->getResizeMode());
+		key_add_int(key, input_indices[index]);
+	}
+
+	const int index = (int)indices.size();
+	indices[operation] = index;
+	return index;
+}
+
+/**
+ * Settings of the execution every buffer depends on.
+ */
+static void key_add_context(std::string &key, const CompositorContext &context)
+{
+	const RenderData *rd = context.getRenderData();
+	const char *view_name = context.getViewName();
+
+	key_add_int(key, (int)context.getQuality());
+	key_add_int(key, context.getFramenumber());
+	key_add_string(key, view_name ? view_name : "");
+	if (rd) {
+		key_add_int(key, rd->xsch);
+		key_add_int(key, rd->ysch);
+		key_add_int(key, rd->size);
+	}
+}
+
+static std::string buffer_key(WriteBufferOperation *writeOperation, const CompositorContext &context)
+{
+	std::string key;
+	OperationIndices indices;
+
+	key_add_context(key, context);
+	key_add_operation(key, writeOperation, indices);
+
+	return key;
+}
+
+static size_t cache_limit()
+{
+	return (size_t)max_ii(U.compositor_cache_limit, 0) * 1024 * 1024;
+}
+
+static bool cache_is_enabled(const CompositorContext &context)
+{
+	/* final renders are executed once, only cache while editing */
+	return !context.isRendering() && cache_limit() != 0;
+}
+
+static void cache_entry_free(BufferCacheEntries::iterator it)
+{
+	s_totalSize -= it->second.size;
+	s_lru.erase(it->second.lru_link);
+	delete it->second.buffer;
+	s_entries.erase(it);
+}
+
+/* free least recently used entries until \a size fits in the limit */
+static void cache_free_for_size(size_t size, size_t limit)
+{
+	while (!s_lru.empty() && s_totalSize + size > limit) {
+		cache_entry_free(s_entries.find(*s_lru.front()));
+	}
+}
+
+static size_t buffer_size(MemoryBuffer *buffer)
+{
+	return sizeof(float) * buffer->get_num_channels() * (size_t)buffer->getWidth() * (size_t)buffer->getHeight();
+}
+
+void BufferCache::restoreBuffers(const std::vector<NodeOperation *> &operations, const CompositorContext &context)
+{
+	s_restored.clear();
+
+	if (cache_limit() == 0) {
+		clear();
+		return;
+	}
+	if (!cache_is_enabled(context)) {
+		return;
+	}
+
+	BLI_mutex_lock(&s_cacheMutex);
+
+	for (std::vector<NodeOperation *>::const_iterator iter = operations.begin(); iter != operations.end(); ++iter) {
+		if (!(*iter)->isWriteBufferOperation()) {
+			continue;
+		}
+		WriteBufferOperation *writeOperation = (WriteBufferOperation *)*iter;
+		MemoryProxy *proxy = writeOperation->getMemoryProxy();
+		MemoryBuffer *buffer = proxy->getBuffer();
+		ExecutionGroup *group = proxy->getExecutor();
+
+		if (writeOperation->isSingleValue() || buffer == NULL || group == NULL) {
+			continue;
+		}
+
+		BufferCacheEntries::iterator found = s_entries.find(buffer_key(writeOperation, context));
+		if (found == s_entries.end()) {
+			continue;
+		}
+
+		BufferCacheEntry &entry = found->second;
+		if (entry.datatype != proxy->getDataType() || entry.size != buffer_size(buffer) ||
+		    entry.buffer->getWidth() != buffer->getWidth() || entry.buffer->getHeight() != buffer->getHeight())
+		{
+			cache_entry_free(found);
+			continue;
+		}
+
+		memcpy(buffer->getBuffer(), entry.buffer->getBuffer(), entry.size);
+		buffer->setCreatedState();
+		group->markExecuted();
+		s_lru.splice(s_lru.end(), s_lru, entry.lru_link);
+		s_restored.insert(writeOperation);
+	}
+
+	BLI_mutex_unlock(&s_cacheMutex);
+}
+
+void BufferCache::storeBuffers(const std::vector<NodeOperation *> &operations, const CompositorContext &context)
+{
+	if (!cache_is_enabled(context)) {
+		return;
+	}
+
+	const size_t limit = cache_limit();
+
+	BLI_mutex_lock(&s_cacheMutex);
+
+	for (std::vector<NodeOperation *>::const_iterator iter = operations.begin(); iter != operations.end(); ++iter) {
+		if (!(*iter)->isWriteBufferOperation()) {
+			continue;
+		}
+		WriteBufferOperation *writeOperation = (WriteBufferOperation *)*iter;
+		MemoryProxy *proxy = writeOperation->getMemoryProxy();
+		MemoryBuffer *buffer = proxy->getBuffer();
+		ExecutionGroup *group = proxy->getExecutor();
+
+		if (writeOperation->isSingleValue() || buffer == NULL || group == NULL) {
+			continue;
+		}
+		if (s_restored.find(writeOperation) != s_restored.end()) {
+			continue;
+		}
+		/* partially calculated (viewer border, cancelled) buffers can't be used again */
+		if (!group->isFullyExecuted()) {
+			continue;
+		}
+
+		const size_t size = buffer_size(buffer);
+		if (size > limit) {
+			continue;
+		}
+
+		const std::string key = buffer_key(writeOperation, context);
+		BufferCacheEntries::iterator found = s_entries.find(key);
+		if (found != s_entries.end()) {
+			cache_entry_free(found);
+		}
+		cache_free_for_size(size, limit);
+
+		BufferCacheEntry &entry = s_entries[key];
+		entry.buffer = new MemoryBuffer(proxy->getDataType(), buffer->getRect());
+		entry.datatype = proxy->getDataType();
+		entry.size = size;
+		memcpy(entry.buffer->getBuffer(), buffer->getBuffer(), size);
+
+		/* map keys don't move, the list can point to them */
+		entry.lru_link = s_lru.insert(s_lru.end(), &s_entries.find(key)->first);
+		s_totalSize += size;
+	}
+
+	s_restored.clear();
+	BLI_mutex_unlock(&s_cacheMutex);
+}
+
+void BufferCache::clear()
+{
+	BLI_mutex_lock(&s_cacheMutex);
+	while (!s_entries.empty()) {
+		cache_entry_free(s_entries.begin());
+	}
+	s_sourceNodeVersions.clear();
+	BLI_mutex_unlock(&s_cacheMutex);
+}
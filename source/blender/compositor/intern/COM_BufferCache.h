@@ -0,0 +1,72 @@
+/*
+ * Copyright 2018, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __COM_BUFFERCACHE_H__
+#define __COM_BUFFERCACHE_H__
+
+#include <string>
+#include <vector>
+
+#include "COM_CompositorContext.h"
+
+class NodeOperation;
+struct bNode;
+struct bNodeTree;
+
+/**
+ * \brief cache of the buffers written by WriteBufferOperation's, kept between executions
+ *
+ * Every buffer is identified by a key holding the operations it was calculated from: their node settings,
+ * resolution, constant inputs and (recursively) their input operations.
+ * Keys are compared as a whole, so buffers are never mixed up by a hash collision.
+ * When the tree is executed again the groups writing a cached buffer are skipped,
+ * so only the part of the tree after a changed node is calculated again.
+ *
+ * Input nodes reading data-blocks (images, render results, movie clips...) can't be hashed by their settings,
+ * their key is changed every time the node is tagged for execution (see bNode.need_exec).
+ *
+ * The memory used is limited by UserDef.compositor_cache_limit, least recently used buffers are freed first.
+ * \ingroup Memory
+ */
+class BufferCache {
+public:
+	/**
+	 * \brief key of the settings of a node, given to all operations created for the node
+	 * \see NodeOperation.setNodeKey
+	 */
+	static std::string nodeKey(bNodeTree *ntree, bNode *node);
+
+	/**
+	 * \brief fill the write buffers found in the cache and mark their execution groups as executed
+	 * \note to be called after the execution groups are initialized
+	 */
+	static void restoreBuffers(const std::vector<NodeOperation *> &operations, const CompositorContext &context);
+
+	/**
+	 * \brief add the fully calculated write buffers to the cache
+	 * \note to be called before the operations are deinitialized
+	 */
+	static void storeBuffers(const std::vector<NodeOperation *> &operations, const CompositorContext &context);
+
+	/**
+	 * \brief free all cached buffers
+	 */
+	static void clear();
+};
+
+#endif
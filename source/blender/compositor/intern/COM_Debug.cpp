@@ -32,6 +32,7 @@ extern "C" {
 #include "BLI_fileops.h"
 #include "BLI_path_util.h"
 #include "BLI_string.h"
+#include "BLI_threads.h"
 
 #include "DNA_node_types.h"
 #include "BKE_appdir.h"
@@ -44,6 +45,7 @@ extern "C" {
 
 #include "COM_ReadBufferOperation.h"
 #include "COM_ViewerOperation.h"
+#include "COM_WorkScheduler.h"
 #include "COM_WriteBufferOperation.h"
 
 
@@ -53,6 +55,8 @@ DebugInfo::OpNameMap DebugInfo::m_op_names;
 std::string DebugInfo::m_current_node_name;
 std::string DebugInfo::m_current_op_name;
 DebugInfo::GroupStateMap DebugInfo::m_group_states;
+DebugInfo::GroupStatsMap DebugInfo::m_group_stats;
+static ThreadMutex g_group_stats_mutex = BLI_MUTEX_INITIALIZER;
 
 std::string DebugInfo::node_name(const Node *node)
 {
@@ -83,6 +87,30 @@ void DebugInfo::execute_started(const ExecutionSystem *system)
 	m_group_states.clear();
 	for (ExecutionSystem::Groups::const_iterator it = system->m_groups.begin(); it != system->m_groups.end(); ++it)
 		m_group_states[*it] = EG_WAIT;
+	m_group_stats.clear();
+}
+
+void DebugInfo::execute_finished(const ExecutionSystem *system)
+{
+	const int num_threads = max_ii(WorkScheduler::get_num_cpu_threads(), 1);
+	int group_index = 0;
+
+	printf("Compositor chunk utilization (%d threads):\n", num_threads);
+	for (ExecutionSystem::Groups::const_iterator it = system->m_groups.begin(); it != system->m_groups.end(); ++it, ++group_index) {
+		GroupStatsMap::const_iterator found = m_group_stats.find(*it);
+		if (found == m_group_stats.end()) {
+			continue;
+		}
+		const GroupStats &stats = found->second;
+		const double span = stats.end_time - stats.start_time;
+		/* average number of threads busy with the group while it was running */
+		const double parallelism = (span > 0.0) ? stats.busy_time / span : 0.0;
+
+		printf("  group %d (%s): %u chunks, %d threads, busy %.3fs, span %.3fs, utilization %.1f%%\n",
+		       group_index, operation_name((*it)->getOutputOperation()).c_str(),
+		       stats.chunks, (int)stats.threads.size(), stats.busy_time, span,
+		       100.0 * parallelism / num_threads);
+	}
 }
 
 void DebugInfo::node_added(const Node *node)
@@ -115,6 +143,27 @@ void DebugInfo::execution_group_finished(const ExecutionGroup *group)
 	m_group_states[group] = EG_FINISHED;
 }
 
+void DebugInfo::chunk_executed(const ExecutionGroup *group, int thread_id, double start_time, double end_time)
+{
+	BLI_mutex_lock(&g_group_stats_mutex);
+	GroupStatsMap::iterator found = m_group_stats.find(group);
+	if (found == m_group_stats.end()) {
+		GroupStats stats;
+		stats.chunks = 0;
+		stats.busy_time = 0.0;
+		stats.start_time = start_time;
+		stats.end_time = end_time;
+		found = m_group_stats.insert(std::make_pair(group, stats)).first;
+	}
+	GroupStats &stats = found->second;
+	stats.chunks++;
+	stats.busy_time += end_time - start_time;
+	stats.start_time = min(stats.start_time, start_time);
+	stats.end_time = max(stats.end_time, end_time);
+	stats.threads.insert(thread_id);
+	BLI_mutex_unlock(&g_group_stats_mutex);
+}
+
 int DebugInfo::graphviz_operation(const ExecutionSystem *system, const NodeOperation *operation, const ExecutionGroup *group, char *str, int maxlen)
 {
 	int len = 0;
@@ -417,12 +466,14 @@ std::string DebugInfo::node_name(const Node * /*node*/) { return ""; }
 std::string DebugInfo::operation_name(const NodeOperation * /*op*/) { return ""; }
 void DebugInfo::convert_started() {}
 void DebugInfo::execute_started(const ExecutionSystem * /*system*/) {}
+void DebugInfo::execute_finished(const ExecutionSystem * /*system*/) {}
 void DebugInfo::node_added(const Node * /*node*/) {}
 void DebugInfo::node_to_operations(const Node * /*node*/) {}
 void DebugInfo::operation_added(const NodeOperation * /*operation*/) {}
 void DebugInfo::operation_read_write_buffer(const NodeOperation * /*operation*/) {}
 void DebugInfo::execution_group_started(const ExecutionGroup * /*group*/) {}
 void DebugInfo::execution_group_finished(const ExecutionGroup * /*group*/) {}
+void DebugInfo::chunk_executed(const ExecutionGroup * /*group*/, int /*thread_id*/, double /*start_time*/, double /*end_time*/) {}
 void DebugInfo::graphviz(const ExecutionSystem * /*system*/) {}
 
 #endif
@@ -23,6 +23,7 @@
 #define __COM_DEBUG_H__
 
 #include <map>
+#include <set>
 #include <string>
 
 #include "COM_defines.h"
@@ -44,11 +45,24 @@ public:
 	typedef std::map<const NodeOperation *, std::string> OpNameMap;
 	typedef std::map<const ExecutionGroup *, GroupState> GroupStateMap;
 
+	/** Chunk timings of an execution group, to see how well the threads are kept busy. */
+	typedef struct GroupStats {
+		unsigned int chunks;
+		/** Sum of the time spent calculating chunks (seconds). */
+		double busy_time;
+		/** Time between the start of the first and the end of the last chunk. */
+		double start_time, end_time;
+		/** Threads that calculated chunks of the group, (-1 for OpenCL devices). */
+		std::set<int> threads;
+	} GroupStats;
+	typedef std::map<const ExecutionGroup *, GroupStats> GroupStatsMap;
+
 	static std::string node_name(const Node *node);
 	static std::string operation_name(const NodeOperation *op);
 
 	static void convert_started();
 	static void execute_started(const ExecutionSystem *system);
+	static void execute_finished(const ExecutionSystem *system);
 
 	static void node_added(const Node *node);
 	static void node_to_operations(const Node *node);
@@ -57,6 +71,8 @@ public:
 
 	static void execution_group_started(const ExecutionGroup *group);
 	static void execution_group_finished(const ExecutionGroup *group);
+	/** Called from the scheduler threads for every calculated chunk. */
+	static void chunk_executed(const ExecutionGroup *group, int thread_id, double start_time, double end_time);
 
 	static void graphviz(const ExecutionSystem *system);
 
@@ -76,6 +92,7 @@ private:
 	static std::string m_current_node_name;		/**< base name for all operations added by a node */
 	static std::string m_current_op_name;		/**< base name for automatic sub-operations */
 	static GroupStateMap m_group_states;		/**< for visualizing group states */
+	static GroupStatsMap m_group_stats;		/**< per group utilization, printed when the execution finished */
 #endif
 };
 
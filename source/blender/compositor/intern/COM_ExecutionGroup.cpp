@@ -152,6 +152,28 @@ void ExecutionGroup::deinitExecution()
 	this->m_cachedReadOperations.clear();
 	this->m_bTree = NULL;
 }
+bool ExecutionGroup::isFullyExecuted() const
+{
+	if (this->m_viewerBorder.xmin != 0 || this->m_viewerBorder.ymin != 0 ||
+	    this->m_viewerBorder.xmax != (int)this->m_width || this->m_viewerBorder.ymax != (int)this->m_height)
+	{
+		return false;
+	}
+	for (unsigned int index = 0; index < this->m_numberOfChunks; index++) {
+		if (this->m_chunkExecutionStates[index] != COM_ES_EXECUTED) {
+			return false;
+		}
+	}
+	return this->m_numberOfChunks != 0;
+}
+
+void ExecutionGroup::markExecuted()
+{
+	for (unsigned int index = 0; index < this->m_numberOfChunks; index++) {
+		this->m_chunkExecutionStates[index] = COM_ES_EXECUTED;
+	}
+}
+
 void ExecutionGroup::determineResolution(unsigned int resolution[2])
 {
 	NodeOperation *operation = this->getOutputOperation();
@@ -338,12 +360,18 @@ void ExecutionGroup::execute(ExecutionSystem *graph)
 			}
 		}
 
-		WorkScheduler::finish();
+		/* don't wait for all scheduled chunks, chunks of which the input areas become available
+		 * are scheduled while the rest is still being calculated */
+		if (!finished) {
+			WorkScheduler::waitForProgress();
+		}
 
 		if (bTree->test_break && bTree->test_break(bTree->tbh)) {
 			breaked = true;
 		}
 	}
+	WorkScheduler::finish();
+
 	DebugInfo::execution_group_finished(this);
 	DebugInfo::graphviz(graph);
 
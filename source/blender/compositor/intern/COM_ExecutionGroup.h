@@ -359,6 +359,18 @@ public:
 	 */
 	void deinitExecution();
 
+	/**
+	 * \brief are all chunks calculated, covering the whole resolution (no border)
+	 * \see BufferCache
+	 */
+	bool isFullyExecuted() const;
+
+	/**
+	 * \brief mark all chunks as calculated, when the output buffer was filled otherwise
+	 * \see BufferCache
+	 */
+	void markExecuted();
+
 
 	/**
 	 * \brief schedule an ExecutionGroup
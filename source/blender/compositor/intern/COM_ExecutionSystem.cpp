@@ -30,12 +30,14 @@ extern "C" {
 
 #include "BLT_translation.h"
 
+#include "COM_BufferCache.h"
 #include "COM_Converter.h"
 #include "COM_NodeOperationBuilder.h"
 #include "COM_NodeOperation.h"
 #include "COM_ExecutionGroup.h"
 #include "COM_WorkScheduler.h"
 #include "COM_ReadBufferOperation.h"
+#include "COM_WriteBufferOperation.h"
 #include "COM_Debug.h"
 
 #ifdef WITH_CXX_GUARDEDALLOC
@@ -148,6 +150,8 @@ void ExecutionSystem::execute()
 	for (index = 0; index < this->m_operations.size(); index++) {
 		NodeOperation *operation = this->m_operations[index];
 		if (operation->isWriteBufferOperation()) {
+			WriteBufferOperation *writeOperation = (WriteBufferOperation *)operation;
+			writeOperation->setFullFrame(this->m_context.isFullFrameEnabled());
 			operation->setbNodeTree(this->m_context.getbNodeTree());
 			operation->initExecution();
 		}
@@ -174,6 +178,9 @@ void ExecutionSystem::execute()
 		executionGroup->initExecution();
 	}
 
+	/* skip the groups of which the result didn't change since the previous execution */
+	BufferCache::restoreBuffers(this->m_operations, this->m_context);
+
 	WorkScheduler::start(this->m_context);
 
 	executeGroups(COM_PRIORITY_HIGH);
@@ -185,6 +192,12 @@ void ExecutionSystem::execute()
 	WorkScheduler::finish();
 	WorkScheduler::stop();
 
+	DebugInfo::execute_finished(this);
+
+	if (!editingtree->test_break(editingtree->tbh)) {
+		BufferCache::storeBuffers(this->m_operations, this->m_context);
+	}
+
 	editingtree->stats_draw(editingtree->sdh, IFACE_("Compositing | De-initializing execution"));
 	for (index = 0; index < this->m_operations.size(); index++) {
 		NodeOperation *operation = this->m_operations[index];
@@ -135,6 +135,17 @@ public:
 	 */
 	float *getBuffer() { return this->m_buffer; }
 
+	/**
+	 * \brief get the data of the element at (x, y)
+	 * \note coordinates are in image space, the buffer must contain (x, y)
+	 */
+	inline float *getElem(int x, int y)
+	{
+		BLI_assert(x >= this->m_rect.xmin && x < this->m_rect.xmax &&
+		           y >= this->m_rect.ymin && y < this->m_rect.ymax);
+		return &this->m_buffer[((y - this->m_rect.ymin) * this->m_width + (x - this->m_rect.xmin)) * this->m_num_channels];
+	}
+
 	/**
 	 * \brief after execution the state will be set to available by calling this method
 	 */
@@ -25,6 +25,7 @@
 
 #include "COM_defines.h"
 #include "COM_ExecutionSystem.h"
+#include "COM_ReadBufferOperation.h"
 
 #include "COM_NodeOperation.h" /* own include */
 
@@ -192,6 +193,115 @@ bool NodeOperation::determineDependingAreaOfInterest(rcti *input, ReadBufferOper
 	}
 }
 
+void NodeOperation::getAreaOfInterest(int /*inputIndex*/, const rcti *outputArea, rcti *r_inputArea)
+{
+	*r_inputArea = *outputArea;
+}
+
+/**
+ * Fill an area of \a output by reading \a operation pixel by pixel,
+ * the same way WriteBufferOperation does for operations without buffer support.
+ */
+static void render_area_per_pixel(NodeOperation *operation, MemoryBuffer *output, const rcti *area)
+{
+	const size_t elem_size = sizeof(float) * output->get_num_channels();
+	float color[4];
+
+	if (operation->isSetOperation()) {
+		/* constant, only read once */
+		operation->readSampled(color, 0, 0, COM_PS_NEAREST);
+		for (int y = area->ymin; y < area->ymax; y++) {
+			for (int x = area->xmin; x < area->xmax; x++) {
+				memcpy(output->getElem(x, y), color, elem_size);
+			}
+		}
+	}
+	else if (operation->isComplex()) {
+		rcti rect = *area;
+		void *data = operation->initializeTileData(&rect);
+		for (int y = area->ymin; y < area->ymax; y++) {
+			for (int x = area->xmin; x < area->xmax; x++) {
+				operation->read(color, x, y, data);
+				memcpy(output->getElem(x, y), color, elem_size);
+			}
+		}
+		if (data) {
+			operation->deinitializeTileData(&rect, data);
+		}
+	}
+	else {
+		for (int y = area->ymin; y < area->ymax; y++) {
+			for (int x = area->xmin; x < area->xmax; x++) {
+				operation->readSampled(color, x, y, COM_PS_NEAREST);
+				memcpy(output->getElem(x, y), color, elem_size);
+			}
+		}
+	}
+}
+
+void NodeOperation::renderMemoryBufferArea(MemoryBuffer *output, const rcti *area)
+{
+	if (BLI_rcti_is_empty(area)) {
+		return;
+	}
+	if (!canUpdateMemoryBufferArea()) {
+		render_area_per_pixel(this, output, area);
+		return;
+	}
+
+	/* same as the pixel path: complex operations prepare their data (tables, sizes...) first */
+	rcti rect = *area;
+	void *data = isComplex() ? initializeTileData(&rect) : NULL;
+
+	const unsigned int inputs_len = getNumberOfInputSockets();
+	vector<MemoryBuffer *> inputs(inputs_len, (MemoryBuffer *)NULL);
+	vector<MemoryBuffer *> temporary;
+
+	for (unsigned int index = 0; index < inputs_len; index++) {
+		NodeOperationInput *socket = getInputSocket(index);
+		NodeOperation *inputOperation = getInputOperation(index);
+		rcti inputArea;
+
+		if (inputOperation == NULL) {
+			continue;
+		}
+		getAreaOfInterest(index, area, &inputArea);
+		if (BLI_rcti_is_empty(&inputArea)) {
+			continue;
+		}
+
+		const bool same_datatype = (socket->getLink()->getDataType() == socket->getDataType());
+
+		if (same_datatype && inputOperation->isReadBufferOperation()) {
+			/* use the written buffer directly when it covers the area */
+			ReadBufferOperation *readOperation = (ReadBufferOperation *)inputOperation;
+			MemoryBuffer *buffer = readOperation->getMemoryBuffer();
+			if (buffer && !readOperation->isSingleValue() && BLI_rcti_inside_rcti(buffer->getRect(), &inputArea)) {
+				inputs[index] = buffer;
+				continue;
+			}
+		}
+
+		MemoryBuffer *buffer = new MemoryBuffer(socket->getDataType(), &inputArea);
+		if (same_datatype) {
+			inputOperation->renderMemoryBufferArea(buffer, &inputArea);
+		}
+		else {
+			render_area_per_pixel(inputOperation, buffer, &inputArea);
+		}
+		inputs[index] = buffer;
+		temporary.push_back(buffer);
+	}
+
+	updateMemoryBufferArea(output, area, inputs_len ? &inputs[0] : NULL);
+
+	for (vector<MemoryBuffer *>::iterator it = temporary.begin(); it != temporary.end(); ++it) {
+		delete *it;
+	}
+	if (data) {
+		deinitializeTileData(&rect, data);
+	}
+}
 
 /*****************
  **** OpInput ****
@@ -126,6 +126,12 @@ private:
 	 */
 	bool m_isResolutionSet;
 
+	/**
+	 * \brief key of the settings of the node this operation was created for
+	 * \see BufferCache
+	 */
+	std::string m_nodeKey;
+
 public:
 	virtual ~NodeOperation();
 
@@ -216,6 +222,47 @@ public:
 	                           list<cl_kernel> * /*clKernelsToCleanUp*/) {}
 	virtual void deinitExecution();
 
+	/**
+	 * \brief can this operation calculate whole areas at once
+	 * \ingroup execution
+	 * Operations returning true implement updateMemoryBufferArea and getAreaOfInterest,
+	 * all other operations are evaluated pixel by pixel.
+	 * \see renderMemoryBufferArea
+	 */
+	virtual bool canUpdateMemoryBufferArea() const { return false; }
+
+	/**
+	 * \brief determine the area of an input needed to calculate an area of this operation
+	 * \ingroup execution
+	 * \note an empty area means the input is not needed as a buffer (for example
+	 * inputs only read once at initialization), NULL will be passed for it.
+	 * \param inputIndex: the index of the input socket
+	 * \param outputArea: the area of this operation that will be calculated
+	 * \param r_inputArea: the needed area of the input
+	 */
+	virtual void getAreaOfInterest(int inputIndex, const rcti *outputArea, rcti *r_inputArea);
+
+	/**
+	 * \brief calculate a whole area of this operation at once
+	 * \ingroup execution
+	 * \param output: the buffer to write to, covering at least \a area
+	 * \param area: the area to calculate
+	 * \param inputs: buffer for every input socket, covering at least the area from getAreaOfInterest
+	 */
+	virtual void updateMemoryBufferArea(MemoryBuffer * /*output*/,
+	                                    const rcti * /*area*/,
+	                                    MemoryBuffer ** /*inputs*/) {}
+
+	/**
+	 * \brief write an area of this operation to \a output
+	 * \ingroup execution
+	 * Operations supporting it (and their inputs recursively) are calculated a buffer at a time,
+	 * the others fall back to pixel by pixel reads.
+	 * \param output: the buffer to write to, covering at least \a area
+	 * \param area: the area to calculate
+	 */
+	void renderMemoryBufferArea(MemoryBuffer *output, const rcti *area);
+
 	bool isResolutionSet() {
 		return this->m_isResolutionSet;
 	}
@@ -235,6 +282,9 @@ public:
 
 	void getConnectedInputSockets(Inputs *sockets);
 
+	void setNodeKey(const std::string &key) { this->m_nodeKey = key; }
+	const std::string &getNodeKey() const { return this->m_nodeKey; }
+
 	/**
 	 * \brief is this operation complex
 	 *
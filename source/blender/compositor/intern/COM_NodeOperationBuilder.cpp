@@ -24,6 +24,7 @@ extern "C" {
 }
 
 #include "COM_NodeConverter.h"
+#include "COM_BufferCache.h"
 #include "COM_Converter.h"
 #include "COM_Debug.h"
 #include "COM_ExecutionSystem.h"
@@ -63,12 +64,14 @@ void NodeOperationBuilder::convertToOperations(ExecutionSystem *system)
 		Node *node = (Node *)m_graph.nodes()[index];
 
 		m_current_node = node;
+		m_current_node_key = BufferCache::nodeKey(node->getbNodeTree(), node->getbNode());
 
 		DebugInfo::node_to_operations(node);
 		node->convertToOperations(converter, *m_context);
 	}
 
 	m_current_node = NULL;
+	m_current_node_key.clear();
 
 	/* The input map constructed by nodes maps operation inputs to node inputs.
 	 * Inverting yields a map of node inputs to all connected operation inputs,
@@ -130,6 +133,9 @@ void NodeOperationBuilder::convertToOperations(ExecutionSystem *system)
 
 void NodeOperationBuilder::addOperation(NodeOperation *operation)
 {
+	if (m_current_node) {
+		operation->setNodeKey(m_current_node_key);
+	}
 	m_operations.push_back(operation);
 }
 
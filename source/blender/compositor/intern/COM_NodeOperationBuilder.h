@@ -24,6 +24,7 @@
 
 #include <map>
 #include <set>
+#include <string>
 #include <vector>
 
 #include "COM_NodeGraph.h"
@@ -87,6 +88,8 @@ private:
 	OutputSocketMap m_output_map;
 
 	Node *m_current_node;
+	/** Settings key of the current node, given to its operations */
+	std::string m_current_node_key;
 
 	/** Operation that will be writing to the viewer image
 	 *  Only one operation can occupy this place at a time,
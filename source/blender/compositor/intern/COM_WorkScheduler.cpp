@@ -20,6 +20,7 @@
  *      Monique Dewanchand
  */
 
+#include <deque>
 #include <list>
 #include <stdio.h>
 
@@ -30,12 +31,15 @@
 #include "COM_OpenCLKernels.cl.h"
 #include "clew.h"
 #include "COM_WriteBufferOperation.h"
+#include "COM_Debug.h"
 
 #include "MEM_guardedalloc.h"
 
 #include "PIL_time.h"
 #include "BLI_threads.h"
 
+#include "atomic_ops.h"
+
 #include "BKE_global.h"
 
 #if COM_CURRENT_THREADING_MODEL == COM_TM_NOTHREAD
@@ -57,8 +61,34 @@ static ThreadLocal(CPUDevice *) g_thread_device;
 /// \brief list of all thread for every CPUDevice in cpudevices a thread exists
 static ListBase g_cputhreads;
 static bool g_cpuInitialized = false;
-/// \brief all scheduled work for the cpu
-static ThreadQueue *g_cpuqueue;
+
+/**
+ * \brief scheduled cpu work of a single thread.
+ * The owning thread takes packages from the front, so chunks are calculated in the order they were scheduled,
+ * other threads steal from the back.
+ */
+typedef struct CPUWorkQueue {
+	SpinLock lock;
+	std::deque<WorkPackage *> packages;
+} CPUWorkQueue;
+
+/// \brief all scheduled work for the cpu, a queue for every CPUDevice
+static vector<CPUWorkQueue *> g_cpuqueues;
+/// \brief number of packages in g_cpuqueues
+static unsigned int g_cpuqueued = 0;
+static bool g_cpuStopping = false;
+/// \brief protects the conditions below
+static ThreadMutex g_workMutex;
+/// \brief cpu threads wait for new packages
+static ThreadCondition g_workCondition;
+/// \brief finish() and waitForProgress() wait for executed packages
+static ThreadCondition g_finishCondition;
+/// \brief packages scheduled, but not executed yet
+static unsigned int g_pending = 0;
+/// \brief total number of executed packages, and the number seen by the last waitForProgress() call
+static unsigned int g_executed = 0;
+static unsigned int g_executed_seen = 0;
+
 static ThreadQueue *g_gpuqueue;
 #ifdef COM_OPENCL_ENABLED
 static cl_context g_context;
@@ -76,14 +106,76 @@ static bool g_openclInitialized = false;
 #endif
 
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+void WorkScheduler::execute_package(Device *device, WorkPackage *package, int thread_id)
+{
+	ExecutionGroup *group = package->getExecutionGroup();
+	const double start = PIL_check_seconds_timer();
+
+	device->execute(package);
+	delete package;
+
+	DebugInfo::chunk_executed(group, thread_id, start, PIL_check_seconds_timer());
+
+	BLI_mutex_lock(&g_workMutex);
+	g_pending--;
+	g_executed++;
+	BLI_condition_notify_all(&g_finishCondition);
+	BLI_mutex_unlock(&g_workMutex);
+}
+
+WorkPackage *WorkScheduler::pop_cpu(int thread_id)
+{
+	const int queues_len = g_cpuqueues.size();
+	WorkPackage *package = NULL;
+
+	/* own queue first, then steal from the others starting at the next thread */
+	for (int offset = 0; offset < queues_len && package == NULL; offset++) {
+		CPUWorkQueue *queue = g_cpuqueues[(thread_id + offset) % queues_len];
+
+		BLI_spin_lock(&queue->lock);
+		if (!queue->packages.empty()) {
+			if (offset == 0) {
+				package = queue->packages.front();
+				queue->packages.pop_front();
+			}
+			else {
+				package = queue->packages.back();
+				queue->packages.pop_back();
+			}
+		}
+		BLI_spin_unlock(&queue->lock);
+	}
+
+	if (package) {
+		atomic_sub_and_fetch_u(&g_cpuqueued, 1);
+	}
+	return package;
+}
+
 void *WorkScheduler::thread_execute_cpu(void *data)
 {
 	CPUDevice *device = (CPUDevice *)data;
-	WorkPackage *work;
+	const int thread_id = device->thread_id();
+
 	BLI_thread_local_set(g_thread_device, device);
-	while ((work = (WorkPackage *)BLI_thread_queue_pop(g_cpuqueue))) {
-		device->execute(work);
-		delete work;
+
+	while (true) {
+		WorkPackage *work = pop_cpu(thread_id);
+		if (work) {
+			execute_package(device, work, thread_id);
+			continue;
+		}
+
+		BLI_mutex_lock(&g_workMutex);
+		while (atomic_fetch_and_add_u(&g_cpuqueued, 0) == 0 && !g_cpuStopping) {
+			BLI_condition_wait(&g_workCondition, &g_workMutex);
+		}
+		const bool stop = g_cpuStopping && atomic_fetch_and_add_u(&g_cpuqueued, 0) == 0;
+		BLI_mutex_unlock(&g_workMutex);
+
+		if (stop) {
+			break;
+		}
 	}
 
 	return NULL;
@@ -95,8 +187,7 @@ void *WorkScheduler::thread_execute_gpu(void *data)
 	WorkPackage *work;
 
 	while ((work = (WorkPackage *)BLI_thread_queue_pop(g_gpuqueue))) {
-		device->execute(work);
-		delete work;
+		execute_package(device, work, -1);
 	}
 
 	return NULL;
@@ -113,16 +204,27 @@ void WorkScheduler::schedule(ExecutionGroup *group, int chunkNumber)
 	device.execute(package);
 	delete package;
 #elif COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+	BLI_mutex_lock(&g_workMutex);
+	g_pending++;
+	BLI_mutex_unlock(&g_workMutex);
+
 #ifdef COM_OPENCL_ENABLED
 	if (group->isOpenCL() && g_openclActive) {
 		BLI_thread_queue_push(g_gpuqueue, package);
+		return;
 	}
-	else {
-		BLI_thread_queue_push(g_cpuqueue, package);
-	}
-#else
-	BLI_thread_queue_push(g_cpuqueue, package);
 #endif
+
+	/* the same chunk of the next groups is likely to read this chunk, keep it on the same thread */
+	CPUWorkQueue *queue = g_cpuqueues[chunkNumber % g_cpuqueues.size()];
+	BLI_spin_lock(&queue->lock);
+	queue->packages.push_back(package);
+	BLI_spin_unlock(&queue->lock);
+	atomic_add_and_fetch_u(&g_cpuqueued, 1);
+
+	BLI_mutex_lock(&g_workMutex);
+	BLI_condition_notify_one(&g_workCondition);
+	BLI_mutex_unlock(&g_workMutex);
 #endif
 }
 
@@ -130,7 +232,22 @@ void WorkScheduler::start(CompositorContext &context)
 {
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
 	unsigned int index;
-	g_cpuqueue = BLI_thread_queue_init();
+
+	BLI_mutex_init(&g_workMutex);
+	BLI_condition_init(&g_workCondition);
+	BLI_condition_init(&g_finishCondition);
+	g_cpuStopping = false;
+	g_cpuqueued = 0;
+	g_pending = 0;
+	g_executed = 0;
+	g_executed_seen = 0;
+
+	for (index = 0; index < g_cpudevices.size(); index++) {
+		CPUWorkQueue *queue = new CPUWorkQueue();
+		BLI_spin_init(&queue->lock);
+		g_cpuqueues.push_back(queue);
+	}
+
 	BLI_threadpool_init(&g_cputhreads, thread_execute_cpu, g_cpudevices.size());
 	for (index = 0; index < g_cpudevices.size(); index++) {
 		Device *device = g_cpudevices[index];
@@ -155,26 +272,40 @@ void WorkScheduler::start(CompositorContext &context)
 void WorkScheduler::finish()
 {
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
-#ifdef COM_OPENCL_ENABLED
-	if (g_openclActive) {
-		BLI_thread_queue_wait_finish(g_gpuqueue);
-		BLI_thread_queue_wait_finish(g_cpuqueue);
+	BLI_mutex_lock(&g_workMutex);
+	while (g_pending != 0) {
+		BLI_condition_wait(&g_finishCondition, &g_workMutex);
 	}
-	else {
-		BLI_thread_queue_wait_finish(g_cpuqueue);
-	}
-#else
-	BLI_thread_queue_wait_finish(cpuqueue);
+	g_executed_seen = g_executed;
+	BLI_mutex_unlock(&g_workMutex);
 #endif
+}
+void WorkScheduler::waitForProgress()
+{
+#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+	BLI_mutex_lock(&g_workMutex);
+	while (g_pending != 0 && g_executed == g_executed_seen) {
+		BLI_condition_wait(&g_finishCondition, &g_workMutex);
+	}
+	g_executed_seen = g_executed;
+	BLI_mutex_unlock(&g_workMutex);
 #endif
 }
 void WorkScheduler::stop()
 {
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
-	BLI_thread_queue_nowait(g_cpuqueue);
+	BLI_mutex_lock(&g_workMutex);
+	g_cpuStopping = true;
+	BLI_condition_notify_all(&g_workCondition);
+	BLI_mutex_unlock(&g_workMutex);
 	BLI_threadpool_end(&g_cputhreads);
-	BLI_thread_queue_free(g_cpuqueue);
-	g_cpuqueue = NULL;
+
+	while (!g_cpuqueues.empty()) {
+		CPUWorkQueue *queue = g_cpuqueues.back();
+		g_cpuqueues.pop_back();
+		BLI_spin_end(&queue->lock);
+		delete queue;
+	}
 #ifdef COM_OPENCL_ENABLED
 	if (g_openclActive) {
 		BLI_thread_queue_nowait(g_gpuqueue);
@@ -183,6 +314,10 @@ void WorkScheduler::stop()
 		g_gpuqueue = NULL;
 	}
 #endif
+
+	BLI_condition_end(&g_workCondition);
+	BLI_condition_end(&g_finishCondition);
+	BLI_mutex_end(&g_workMutex);
 #endif
 }
 
@@ -350,6 +485,11 @@ void WorkScheduler::deinitialize()
 #endif
 }
 
+int WorkScheduler::get_num_cpu_threads()
+{
+	return g_cpudevices.size();
+}
+
 int WorkScheduler::current_thread_id()
 {
 	CPUDevice *device = (CPUDevice *)BLI_thread_local_get(g_thread_device);
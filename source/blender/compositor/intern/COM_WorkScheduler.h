@@ -53,6 +53,17 @@ class WorkScheduler {
 	 * inside this loop new work is queried and being executed
 	 */
 	static void *thread_execute_gpu(void *data);
+
+	/**
+	 * \brief get the next package for a cpu thread,
+	 * from its own queue or stolen from the queue of another thread
+	 */
+	static WorkPackage *pop_cpu(int thread_id);
+
+	/**
+	 * \brief execute a package and notify the threads waiting for progress
+	 */
+	static void execute_package(Device *device, WorkPackage *package, int thread_id);
 #endif
 public:
 	/**
@@ -105,6 +116,15 @@ public:
 	 */
 	static void finish();
 
+	/**
+	 * \brief wait until a scheduled chunk has been executed since the last call.
+	 * Returns immediately when there is no scheduled work.
+	 *
+	 * Used by ExecutionGroup.execute to schedule chunks of which the input areas became available
+	 * while other chunks are still being calculated.
+	 */
+	static void waitForProgress();
+
 	/**
 	 * \brief Are there OpenCL capable GPU devices initialized?
 	 * the result of this method is stored in the CompositorContext
@@ -115,6 +135,11 @@ public:
 
 	static int current_thread_id();
 
+	/**
+	 * \brief number of threads calculating cpu chunks
+	 */
+	static int get_num_cpu_threads();
+
 #ifdef WITH_CXX_GUARDEDALLOC
 	MEM_CXX_CLASS_ALLOC_FUNCS("COM:WorkScheduler")
 #endif
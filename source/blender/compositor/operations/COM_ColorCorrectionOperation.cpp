@@ -51,6 +51,25 @@ void ColorCorrectionOperation::executePixelSampled(float output[4], float x, flo
 	this->m_inputImage->readSampled(inputImageColor, x, y, sampler);
 	this->m_inputMask->readSampled(inputMask, x, y, sampler);
 
+	correctPixel(output, inputImageColor, inputMask[0]);
+}
+
+void ColorCorrectionOperation::updateMemoryBufferArea(MemoryBuffer *output, const rcti *area, MemoryBuffer **inputs)
+{
+	BLI_assert(inputs[0]->get_num_channels() == 4 && inputs[1]->get_num_channels() == 1);
+
+	for (int y = area->ymin; y < area->ymax; y++) {
+		const float *inputImageColor = inputs[0]->getElem(area->xmin, y);
+		const float *inputMask = inputs[1]->getElem(area->xmin, y);
+		float *out = output->getElem(area->xmin, y);
+		for (int x = area->xmin; x < area->xmax; x++, out += 4, inputImageColor += 4, inputMask++) {
+			correctPixel(out, inputImageColor, inputMask[0]);
+		}
+	}
+}
+
+void ColorCorrectionOperation::correctPixel(float output[4], const float inputImageColor[4], float value)
+{
 	float level = (inputImageColor[0] + inputImageColor[1] + inputImageColor[2]) / 3.0f;
 	float contrast = this->m_data->master.contrast;
 	float saturation = this->m_data->master.saturation;
@@ -59,7 +78,6 @@ void ColorCorrectionOperation::executePixelSampled(float output[4], float x, flo
 	float lift = this->m_data->master.lift;
 	float r, g, b;
 
-	float value = inputMask[0];
 	value = min(1.0f, value);
 	const float mvalue = 1.0f - value;
 
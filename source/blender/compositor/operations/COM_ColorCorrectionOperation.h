@@ -38,6 +38,11 @@ private:
 	bool m_greenChannelEnabled;
 	bool m_blueChannelEnabled;
 
+	/**
+	 * correct a single color, shared by the pixel and buffer paths
+	 */
+	void correctPixel(float output[4], const float inputImageColor[4], float value);
+
 public:
 	ColorCorrectionOperation();
 
@@ -46,6 +51,9 @@ public:
 	 */
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
 
+	bool canUpdateMemoryBufferArea() const { return true; }
+	void updateMemoryBufferArea(MemoryBuffer *output, const rcti *area, MemoryBuffer **inputs);
+
 	/**
 	 * Initialize the execution
 	 */
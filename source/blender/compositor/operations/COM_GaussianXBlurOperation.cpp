@@ -123,6 +123,61 @@ void GaussianXBlurOperation::executePixel(float output[4], int x, int y, void *d
 	mul_v4_v4fl(output, color_accum, 1.0f / multiplier_accum);
 }
 
+void GaussianXBlurOperation::getAreaOfInterest(int inputIndex, const rcti *outputArea, rcti *r_inputArea)
+{
+	if (inputIndex == 0) {
+		/* taps are clamped to the image, same as executePixel */
+		NodeOperation *inputOperation = getInputOperation(0);
+		BLI_rcti_init(r_inputArea,
+		              max_ii(outputArea->xmin - this->m_filtersize - 1, 0),
+		              min_ii(outputArea->xmax + this->m_filtersize + 1, inputOperation->getWidth()),
+		              outputArea->ymin, outputArea->ymax);
+	}
+	else {
+		/* size is read once in initializeTileData */
+		BLI_rcti_init(r_inputArea, 0, 0, 0, 0);
+	}
+}
+
+void GaussianXBlurOperation::updateMemoryBufferArea(MemoryBuffer *output, const rcti *area, MemoryBuffer **inputs)
+{
+	MemoryBuffer *inputBuffer = inputs[0];
+	rcti &rect = *inputBuffer->getRect();
+	int step = getStep();
+	int offsetadd = getOffsetAdd();
+
+	for (int y = area->ymin; y < area->ymax; y++) {
+		float *out = output->getElem(area->xmin, y);
+		for (int x = area->xmin; x < area->xmax; x++, out += 4) {
+			float ATTR_ALIGN(16) color_accum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+			float multiplier_accum = 0.0f;
+			int xmin = max_ii(x - m_filtersize,     rect.xmin);
+			int xmax = min_ii(x + m_filtersize + 1, rect.xmax);
+			const float *in = inputBuffer->getElem(xmin, y);
+
+#ifdef __SSE2__
+			__m128 accum_r = _mm_load_ps(color_accum);
+			for (int nx = xmin, index = (xmin - x) + this->m_filtersize; nx < xmax; nx += step, index += step) {
+				__m128 reg_a = _mm_load_ps(in);
+				reg_a = _mm_mul_ps(reg_a, this->m_gausstab_sse[index]);
+				accum_r = _mm_add_ps(accum_r, reg_a);
+				multiplier_accum += this->m_gausstab[index];
+				in += offsetadd;
+			}
+			_mm_store_ps(color_accum, accum_r);
+#else
+			for (int nx = xmin, index = (xmin - x) + this->m_filtersize; nx < xmax; nx += step, index += step) {
+				const float multiplier = this->m_gausstab[index];
+				madd_v4_v4fl(color_accum, in, multiplier);
+				multiplier_accum += multiplier;
+				in += offsetadd;
+			}
+#endif
+			mul_v4_v4fl(out, color_accum, 1.0f / multiplier_accum);
+		}
+	}
+}
+
 void GaussianXBlurOperation::executeOpenCL(OpenCLDevice *device,
                                            MemoryBuffer *outputMemoryBuffer, cl_mem clOutputBuffer,
                                            MemoryBuffer **inputMemoryBuffers, list<cl_mem> *clMemToCleanUp,
@@ -59,6 +59,10 @@ public:
 	void *initializeTileData(rcti *rect);
 	bool determineDependingAreaOfInterest(rcti *input, ReadBufferOperation *readOperation, rcti *output);
 
+	bool canUpdateMemoryBufferArea() const { return true; }
+	void getAreaOfInterest(int inputIndex, const rcti *outputArea, rcti *r_inputArea);
+	void updateMemoryBufferArea(MemoryBuffer *output, const rcti *area, MemoryBuffer **inputs);
+
 	void checkOpenCL() {
 		this->setOpenCL(m_data.sizex >= 128);
 	}
@@ -125,6 +125,57 @@ void GaussianYBlurOperation::executePixel(float output[4], int x, int y, void *d
 	mul_v4_v4fl(output, color_accum, 1.0f / multiplier_accum);
 }
 
+void GaussianYBlurOperation::getAreaOfInterest(int inputIndex, const rcti *outputArea, rcti *r_inputArea)
+{
+	if (inputIndex == 0) {
+		/* taps are clamped to the image, same as executePixel */
+		NodeOperation *inputOperation = getInputOperation(0);
+		BLI_rcti_init(r_inputArea,
+		              outputArea->xmin, outputArea->xmax,
+		              max_ii(outputArea->ymin - this->m_filtersize - 1, 0),
+		              min_ii(outputArea->ymax + this->m_filtersize + 1, inputOperation->getHeight()));
+	}
+	else {
+		/* size is read once in initializeTileData */
+		BLI_rcti_init(r_inputArea, 0, 0, 0, 0);
+	}
+}
+
+/**
+ * Unlike executePixel this works on whole rows, the weighted input rows are accumulated
+ * in the output row so the input is read in memory order.
+ */
+void GaussianYBlurOperation::updateMemoryBufferArea(MemoryBuffer *output, const rcti *area, MemoryBuffer **inputs)
+{
+	MemoryBuffer *inputBuffer = inputs[0];
+	rcti &rect = *inputBuffer->getRect();
+	const int step = getStep();
+	const int row_len = BLI_rcti_size_x(area) * 4;
+
+	for (int y = area->ymin; y < area->ymax; y++) {
+		float *out = output->getElem(area->xmin, y);
+		float multiplier_accum = 0.0f;
+		int ymin = max_ii(y - m_filtersize,     rect.ymin);
+		int ymax = min_ii(y + m_filtersize + 1, rect.ymax);
+
+		memset(out, 0, sizeof(float) * row_len);
+
+		for (int ny = ymin; ny < ymax; ny += step) {
+			const float multiplier = this->m_gausstab[(ny - y) + this->m_filtersize];
+			const float *in = inputBuffer->getElem(area->xmin, ny);
+			for (int i = 0; i < row_len; i++) {
+				out[i] += in[i] * multiplier;
+			}
+			multiplier_accum += multiplier;
+		}
+
+		const float multiplier_inv = 1.0f / multiplier_accum;
+		for (int i = 0; i < row_len; i++) {
+			out[i] *= multiplier_inv;
+		}
+	}
+}
+
 void GaussianYBlurOperation::executeOpenCL(OpenCLDevice *device,
                                            MemoryBuffer *outputMemoryBuffer, cl_mem clOutputBuffer,
                                            MemoryBuffer **inputMemoryBuffers, list<cl_mem> *clMemToCleanUp,
@@ -72,6 +72,25 @@ void MathBaseOperation::clampIfNeeded(float *color)
 	}
 }
 
+void MathBaseOperation::updateMemoryBufferArea(MemoryBuffer *output, const rcti *area, MemoryBuffer **inputs)
+{
+	const int width = BLI_rcti_size_x(area);
+
+	BLI_assert(inputs[0]->get_num_channels() == 1 && inputs[1]->get_num_channels() == 1);
+
+	for (int y = area->ymin; y < area->ymax; y++) {
+		float *out = output->getElem(area->xmin, y);
+
+		mathRow(out, inputs[0]->getElem(area->xmin, y), inputs[1]->getElem(area->xmin, y), width);
+
+		if (this->m_useClamp) {
+			for (int i = 0; i < width; i++) {
+				CLAMP(out[i], 0.0f, 1.0f);
+			}
+		}
+	}
+}
+
 void MathAddOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -85,6 +104,13 @@ void MathAddOperation::executePixelSampled(float output[4], float x, float y, Pi
 	clampIfNeeded(output);
 }
 
+void MathAddOperation::mathRow(float *output, const float *value1, const float *value2, int len)
+{
+	for (int i = 0; i < len; i++) {
+		output[i] = value1[i] + value2[i];
+	}
+}
+
 void MathSubtractOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -98,6 +124,13 @@ void MathSubtractOperation::executePixelSampled(float output[4], float x, float
 	clampIfNeeded(output);
 }
 
+void MathSubtractOperation::mathRow(float *output, const float *value1, const float *value2, int len)
+{
+	for (int i = 0; i < len; i++) {
+		output[i] = value1[i] - value2[i];
+	}
+}
+
 void MathMultiplyOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -111,6 +144,13 @@ void MathMultiplyOperation::executePixelSampled(float output[4], float x, float
 	clampIfNeeded(output);
 }
 
+void MathMultiplyOperation::mathRow(float *output, const float *value1, const float *value2, int len)
+{
+	for (int i = 0; i < len; i++) {
+		output[i] = value1[i] * value2[i];
+	}
+}
+
 void MathDivideOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -127,6 +167,14 @@ void MathDivideOperation::executePixelSampled(float output[4], float x, float y,
 	clampIfNeeded(output);
 }
 
+void MathDivideOperation::mathRow(float *output, const float *value1, const float *value2, int len)
+{
+	for (int i = 0; i < len; i++) {
+		/* We don't want to divide by zero. */
+		output[i] = (value2[i] == 0.0f) ? 0.0f : value1[i] / value2[i];
+	}
+}
+
 void MathSineOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -265,6 +313,13 @@ void MathMinimumOperation::executePixelSampled(float output[4], float x, float y
 	clampIfNeeded(output);
 }
 
+void MathMinimumOperation::mathRow(float *output, const float *value1, const float *value2, int len)
+{
+	for (int i = 0; i < len; i++) {
+		output[i] = min(value1[i], value2[i]);
+	}
+}
+
 void MathMaximumOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -278,6 +333,13 @@ void MathMaximumOperation::executePixelSampled(float output[4], float x, float y
 	clampIfNeeded(output);
 }
 
+void MathMaximumOperation::mathRow(float *output, const float *value1, const float *value2, int len)
+{
+	for (int i = 0; i < len; i++) {
+		output[i] = max(value1[i], value2[i]);
+	}
+}
+
 void MathRoundOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
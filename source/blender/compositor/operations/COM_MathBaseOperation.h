@@ -67,6 +67,16 @@ public:
 	 */
 	void determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2]);
 
+	/**
+	 * the buffer at a time variant of the inner loop, operations supporting it implement mathRow
+	 */
+	void updateMemoryBufferArea(MemoryBuffer *output, const rcti *area, MemoryBuffer **inputs);
+
+	/**
+	 * calculate a row of \a len values
+	 */
+	virtual void mathRow(float * /*output*/, const float * /*value1*/, const float * /*value2*/, int /*len*/) {}
+
 	void setUseClamp(bool value) { this->m_useClamp = value; }
 };
 
@@ -74,21 +84,29 @@ class MathAddOperation : public MathBaseOperation {
 public:
 	MathAddOperation() : MathBaseOperation() {}
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool canUpdateMemoryBufferArea() const { return true; }
+	void mathRow(float *output, const float *value1, const float *value2, int len);
 };
 class MathSubtractOperation : public MathBaseOperation {
 public:
 	MathSubtractOperation() : MathBaseOperation() {}
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool canUpdateMemoryBufferArea() const { return true; }
+	void mathRow(float *output, const float *value1, const float *value2, int len);
 };
 class MathMultiplyOperation : public MathBaseOperation {
 public:
 	MathMultiplyOperation() : MathBaseOperation() {}
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool canUpdateMemoryBufferArea() const { return true; }
+	void mathRow(float *output, const float *value1, const float *value2, int len);
 };
 class MathDivideOperation : public MathBaseOperation {
 public:
 	MathDivideOperation() : MathBaseOperation() {}
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool canUpdateMemoryBufferArea() const { return true; }
+	void mathRow(float *output, const float *value1, const float *value2, int len);
 };
 class MathSineOperation : public MathBaseOperation {
 public:
@@ -135,11 +153,15 @@ class MathMinimumOperation : public MathBaseOperation {
 public:
 	MathMinimumOperation() : MathBaseOperation() {}
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool canUpdateMemoryBufferArea() const { return true; }
+	void mathRow(float *output, const float *value1, const float *value2, int len);
 };
 class MathMaximumOperation : public MathBaseOperation {
 public:
 	MathMaximumOperation() : MathBaseOperation() {}
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool canUpdateMemoryBufferArea() const { return true; }
+	void mathRow(float *output, const float *value1, const float *value2, int len);
 };
 class MathRoundOperation : public MathBaseOperation {
 public:
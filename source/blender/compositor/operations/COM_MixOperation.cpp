@@ -22,6 +22,8 @@
 
 #include "COM_MixOperation.h"
 
+#include "MEM_guardedalloc.h"
+
 extern "C" {
 #  include "BLI_math.h"
 }
@@ -100,6 +102,52 @@ void MixBaseOperation::deinitExecution()
 	this->m_inputColor2Operation = NULL;
 }
 
+void MixBaseOperation::updateMemoryBufferArea(MemoryBuffer *output, const rcti *area, MemoryBuffer **inputs)
+{
+	MemoryBuffer *inputValue = inputs[0];
+	MemoryBuffer *inputColor1 = inputs[1];
+	MemoryBuffer *inputColor2 = inputs[2];
+	const int width = BLI_rcti_size_x(area);
+	float *value = (float *)MEM_mallocN(sizeof(float) * width, __func__);
+
+	BLI_assert(inputValue->get_num_channels() == 1);
+	BLI_assert(inputColor1->get_num_channels() == 4 && inputColor2->get_num_channels() == 4);
+
+	for (int y = area->ymin; y < area->ymax; y++) {
+		const float *color1 = inputColor1->getElem(area->xmin, y);
+		const float *color2 = inputColor2->getElem(area->xmin, y);
+		float *out = output->getElem(area->xmin, y);
+
+		memcpy(value, inputValue->getElem(area->xmin, y), sizeof(float) * width);
+		if (this->useValueAlphaMultiply()) {
+			for (int i = 0; i < width; i++) {
+				value[i] *= color2[i * 4 + 3];
+			}
+		}
+
+		mixRow(out, value, color1, color2, width);
+
+		if (this->m_useClamp) {
+			for (int i = 0; i < width * 4; i++) {
+				CLAMP(out[i], 0.0f, 1.0f);
+			}
+		}
+	}
+
+	MEM_freeN(value);
+}
+
+void MixBaseOperation::mixRow(float *output, const float *value, const float *color1, const float *color2, int len)
+{
+	for (int i = 0; i < len; i++, output += 4, color1 += 4, color2 += 4) {
+		const float valuem = 1.0f - value[i];
+		output[0] = valuem * color1[0] + value[i] * color2[0];
+		output[1] = valuem * color1[1] + value[i] * color2[1];
+		output[2] = valuem * color1[2] + value[i] * color2[2];
+		output[3] = color1[3];
+	}
+}
+
 /* ******** Mix Add Operation ******** */
 
 MixAddOperation::MixAddOperation() : MixBaseOperation()
@@ -129,6 +177,16 @@ void MixAddOperation::executePixelSampled(float output[4], float x, float y, Pix
 	clampIfNeeded(output);
 }
 
+void MixAddOperation::mixRow(float *output, const float *value, const float *color1, const float *color2, int len)
+{
+	for (int i = 0; i < len; i++, output += 4, color1 += 4, color2 += 4) {
+		output[0] = color1[0] + value[i] * color2[0];
+		output[1] = color1[1] + value[i] * color2[1];
+		output[2] = color1[2] + value[i] * color2[2];
+		output[3] = color1[3];
+	}
+}
+
 /* ******** Mix Blend Operation ******** */
 
 MixBlendOperation::MixBlendOperation() : MixBaseOperation()
@@ -300,6 +358,17 @@ void MixDarkenOperation::executePixelSampled(float output[4], float x, float y,
 	clampIfNeeded(output);
 }
 
+void MixDarkenOperation::mixRow(float *output, const float *value, const float *color1, const float *color2, int len)
+{
+	for (int i = 0; i < len; i++, output += 4, color1 += 4, color2 += 4) {
+		const float valuem = 1.0f - value[i];
+		output[0] = min_ff(color1[0], color2[0]) * value[i] + color1[0] * valuem;
+		output[1] = min_ff(color1[1], color2[1]) * value[i] + color1[1] * valuem;
+		output[2] = min_ff(color1[2], color2[2]) * value[i] + color1[2] * valuem;
+		output[3] = color1[3];
+	}
+}
+
 /* ******** Mix Difference Operation ******** */
 
 MixDifferenceOperation::MixDifferenceOperation() : MixBaseOperation()
@@ -330,6 +399,17 @@ void MixDifferenceOperation::executePixelSampled(float output[4], float x, float
 	clampIfNeeded(output);
 }
 
+void MixDifferenceOperation::mixRow(float *output, const float *value, const float *color1, const float *color2, int len)
+{
+	for (int i = 0; i < len; i++, output += 4, color1 += 4, color2 += 4) {
+		const float valuem = 1.0f - value[i];
+		output[0] = valuem * color1[0] + value[i] * fabsf(color1[0] - color2[0]);
+		output[1] = valuem * color1[1] + value[i] * fabsf(color1[1] - color2[1]);
+		output[2] = valuem * color1[2] + value[i] * fabsf(color1[2] - color2[2]);
+		output[3] = color1[3];
+	}
+}
+
 /* ******** Mix Difference Operation ******** */
 
 MixDivideOperation::MixDivideOperation() : MixBaseOperation()
@@ -371,6 +451,17 @@ void MixDivideOperation::executePixelSampled(float output[4], float x, float y,
 	clampIfNeeded(output);
 }
 
+void MixDivideOperation::mixRow(float *output, const float *value, const float *color1, const float *color2, int len)
+{
+	for (int i = 0; i < len; i++, output += 4, color1 += 4, color2 += 4) {
+		const float valuem = 1.0f - value[i];
+		for (int c = 0; c < 3; c++) {
+			output[c] = (color2[c] != 0.0f) ? valuem * color1[c] + value[i] * color1[c] / color2[c] : 0.0f;
+		}
+		output[3] = color1[3];
+	}
+}
+
 /* ******** Mix Dodge Operation ******** */
 
 MixDodgeOperation::MixDodgeOperation() : MixBaseOperation()
@@ -554,6 +645,17 @@ void MixLightenOperation::executePixelSampled(float output[4], float x, float y,
 	clampIfNeeded(output);
 }
 
+void MixLightenOperation::mixRow(float *output, const float *value, const float *color1, const float *color2, int len)
+{
+	for (int i = 0; i < len; i++, output += 4, color1 += 4, color2 += 4) {
+		for (int c = 0; c < 3; c++) {
+			const float tmp = value[i] * color2[c];
+			output[c] = (tmp > color1[c]) ? tmp : color1[c];
+		}
+		output[3] = color1[3];
+	}
+}
+
 /* ******** Mix Linear Light Operation ******** */
 
 MixLinearLightOperation::MixLinearLightOperation() : MixBaseOperation()
@@ -623,6 +725,17 @@ void MixMultiplyOperation::executePixelSampled(float output[4], float x, float y
 	clampIfNeeded(output);
 }
 
+void MixMultiplyOperation::mixRow(float *output, const float *value, const float *color1, const float *color2, int len)
+{
+	for (int i = 0; i < len; i++, output += 4, color1 += 4, color2 += 4) {
+		const float valuem = 1.0f - value[i];
+		output[0] = color1[0] * (valuem + value[i] * color2[0]);
+		output[1] = color1[1] * (valuem + value[i] * color2[1]);
+		output[2] = color1[2] * (valuem + value[i] * color2[2]);
+		output[3] = color1[3];
+	}
+}
+
 /* ******** Mix Ovelray Operation ******** */
 
 MixOverlayOperation::MixOverlayOperation() : MixBaseOperation()
@@ -740,6 +853,17 @@ void MixScreenOperation::executePixelSampled(float output[4], float x, float y,
 	clampIfNeeded(output);
 }
 
+void MixScreenOperation::mixRow(float *output, const float *value, const float *color1, const float *color2, int len)
+{
+	for (int i = 0; i < len; i++, output += 4, color1 += 4, color2 += 4) {
+		const float valuem = 1.0f - value[i];
+		output[0] = 1.0f - (valuem + value[i] * (1.0f - color2[0])) * (1.0f - color1[0]);
+		output[1] = 1.0f - (valuem + value[i] * (1.0f - color2[1])) * (1.0f - color1[1]);
+		output[2] = 1.0f - (valuem + value[i] * (1.0f - color2[2])) * (1.0f - color1[2]);
+		output[3] = color1[3];
+	}
+}
+
 /* ******** Mix Soft Light Operation ******** */
 
 MixSoftLightOperation::MixSoftLightOperation() : MixBaseOperation()
@@ -806,6 +930,16 @@ void MixSubtractOperation::executePixelSampled(float output[4], float x, float y
 	clampIfNeeded(output);
 }
 
+void MixSubtractOperation::mixRow(float *output, const float *value, const float *color1, const float *color2, int len)
+{
+	for (int i = 0; i < len; i++, output += 4, color1 += 4, color2 += 4) {
+		output[0] = color1[0] - value[i] * color2[0];
+		output[1] = color1[1] - value[i] * color2[1];
+		output[2] = color1[2] - value[i] * color2[2];
+		output[3] = color1[3];
+	}
+}
+
 /* ******** Mix Value Operation ******** */
 
 MixValueOperation::MixValueOperation() : MixBaseOperation()
@@ -74,6 +74,16 @@ public:
 
 	void determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2]);
 
+	/**
+	 * the buffer at a time variant of the inner loop, operations supporting it implement mixRow
+	 */
+	void updateMemoryBufferArea(MemoryBuffer *output, const rcti *area, MemoryBuffer **inputs);
+
+	/**
+	 * mix a row of \a len pixels, \a value already has the alpha of color2 applied when needed
+	 */
+	virtual void mixRow(float *output, const float *value, const float *color1, const float *color2, int len);
+
 
 	void setUseValueAlphaMultiply(const bool value) { this->m_valueAlphaMultiply = value; }
 	inline bool useValueAlphaMultiply() { return this->m_valueAlphaMultiply; }
@@ -84,12 +94,15 @@ class MixAddOperation : public MixBaseOperation {
 public:
 	MixAddOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool canUpdateMemoryBufferArea() const { return true; }
+	void mixRow(float *output, const float *value, const float *color1, const float *color2, int len);
 };
 
 class MixBlendOperation : public MixBaseOperation {
 public:
 	MixBlendOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool canUpdateMemoryBufferArea() const { return true; }
 };
 
 class MixBurnOperation : public MixBaseOperation {
@@ -108,18 +121,24 @@ class MixDarkenOperation : public MixBaseOperation {
 public:
 	MixDarkenOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool canUpdateMemoryBufferArea() const { return true; }
+	void mixRow(float *output, const float *value, const float *color1, const float *color2, int len);
 };
 
 class MixDifferenceOperation : public MixBaseOperation {
 public:
 	MixDifferenceOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool canUpdateMemoryBufferArea() const { return true; }
+	void mixRow(float *output, const float *value, const float *color1, const float *color2, int len);
 };
 
 class MixDivideOperation : public MixBaseOperation {
 public:
 	MixDivideOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool canUpdateMemoryBufferArea() const { return true; }
+	void mixRow(float *output, const float *value, const float *color1, const float *color2, int len);
 };
 
 class MixDodgeOperation : public MixBaseOperation {
@@ -144,6 +163,8 @@ class MixLightenOperation : public MixBaseOperation {
 public:
 	MixLightenOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool canUpdateMemoryBufferArea() const { return true; }
+	void mixRow(float *output, const float *value, const float *color1, const float *color2, int len);
 };
 
 class MixLinearLightOperation : public MixBaseOperation {
@@ -156,6 +177,8 @@ class MixMultiplyOperation : public MixBaseOperation {
 public:
 	MixMultiplyOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool canUpdateMemoryBufferArea() const { return true; }
+	void mixRow(float *output, const float *value, const float *color1, const float *color2, int len);
 };
 
 class MixOverlayOperation : public MixBaseOperation {
@@ -174,6 +197,8 @@ class MixScreenOperation : public MixBaseOperation {
 public:
 	MixScreenOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool canUpdateMemoryBufferArea() const { return true; }
+	void mixRow(float *output, const float *value, const float *color1, const float *color2, int len);
 };
 
 class MixSoftLightOperation : public MixBaseOperation {
@@ -186,6 +211,8 @@ class MixSubtractOperation : public MixBaseOperation {
 public:
 	MixSubtractOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool canUpdateMemoryBufferArea() const { return true; }
+	void mixRow(float *output, const float *value, const float *color1, const float *color2, int len);
 };
 
 class MixValueOperation : public MixBaseOperation {
@@ -49,6 +49,8 @@ public:
 	unsigned int getOffset() const { return this->m_offset; }
 	bool determineDependingAreaOfInterest(rcti *input, ReadBufferOperation *readOperation, rcti *output);
 	MemoryBuffer *getInputMemoryBuffer(MemoryBuffer **memoryBuffers) { return memoryBuffers[this->m_offset]; }
+	MemoryBuffer *getMemoryBuffer() { return this->m_buffer; }
+	bool isSingleValue() const { return this->m_single_value; }
 	void readResolutionFromWriteBuffer();
 	void updateMemoryBuffer();
 };
@@ -62,6 +62,69 @@ void TranslateOperation::executePixelSampled(float output[4], float x, float y,
 	this->m_inputOperation->readSampled(output, originalXPos, originalYPos, COM_PS_BILINEAR);
 }
 
+void TranslateOperation::getAreaOfInterest(int inputIndex, const rcti *outputArea, rcti *r_inputArea)
+{
+	if (inputIndex == 0) {
+		ensureDelta();
+
+		/* one extra pixel on each side for bilinear sampling */
+		const int deltaX = (int)floorf(this->getDeltaX());
+		const int deltaY = (int)floorf(this->getDeltaY());
+		BLI_rcti_init(r_inputArea,
+		              outputArea->xmin - deltaX - 1, outputArea->xmax - deltaX + 1,
+		              outputArea->ymin - deltaY - 1, outputArea->ymax - deltaY + 1);
+	}
+	else {
+		/* delta is read once in ensureDelta */
+		BLI_rcti_init(r_inputArea, 0, 0, 0, 0);
+	}
+}
+
+void TranslateOperation::updateMemoryBufferArea(MemoryBuffer *output, const rcti *area, MemoryBuffer **inputs)
+{
+	MemoryBuffer *inputBuffer = inputs[0];
+	const rcti *rect = inputBuffer->getRect();
+
+	ensureDelta();
+
+	const float deltaX = this->getDeltaX();
+	const float deltaY = this->getDeltaY();
+
+	if (deltaX == floorf(deltaX) && deltaY == floorf(deltaY)) {
+		/* whole pixel offset, bilinear sampling gives the input pixels: copy rows */
+		const int offsetX = (int)deltaX;
+		const int offsetY = (int)deltaY;
+		const int width = BLI_rcti_size_x(area);
+
+		for (int y = area->ymin; y < area->ymax; y++) {
+			const int inputY = y - offsetY;
+			const int inputXMin = max_ii(area->xmin - offsetX, rect->xmin);
+			const int inputXMax = min_ii(area->xmax - offsetX, rect->xmax);
+			float *out = output->getElem(area->xmin, y);
+
+			if (inputY < rect->ymin || inputY >= rect->ymax || inputXMin >= inputXMax) {
+				memset(out, 0, sizeof(float) * 4 * width);
+				continue;
+			}
+
+			/* outside of the input is zero, same as MemoryBuffer.readBilinear */
+			const int clipMin = inputXMin - (area->xmin - offsetX);
+			const int clipMax = (area->xmax - offsetX) - inputXMax;
+			memset(out, 0, sizeof(float) * 4 * clipMin);
+			memcpy(out + clipMin * 4, inputBuffer->getElem(inputXMin, inputY), sizeof(float) * 4 * (inputXMax - inputXMin));
+			memset(out + (width - clipMax) * 4, 0, sizeof(float) * 4 * clipMax);
+		}
+	}
+	else {
+		for (int y = area->ymin; y < area->ymax; y++) {
+			float *out = output->getElem(area->xmin, y);
+			for (int x = area->xmin; x < area->xmax; x++, out += 4) {
+				inputBuffer->readBilinear(out, x - deltaX, y - deltaY);
+			}
+		}
+	}
+}
+
 bool TranslateOperation::determineDependingAreaOfInterest(rcti *input, ReadBufferOperation *readOperation, rcti *output)
 {
 	rcti newInput;
@@ -43,6 +43,10 @@ public:
 	void initExecution();
 	void deinitExecution();
 
+	bool canUpdateMemoryBufferArea() const { return true; }
+	void getAreaOfInterest(int inputIndex, const rcti *outputArea, rcti *r_inputArea);
+	void updateMemoryBufferArea(MemoryBuffer *output, const rcti *area, MemoryBuffer **inputs);
+
 	float getDeltaX() { return this->m_deltaX * this->m_factorX; }
 	float getDeltaY() { return this->m_deltaY * this->m_factorY; }
 
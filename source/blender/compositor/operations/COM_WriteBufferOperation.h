@@ -33,6 +33,7 @@
 class WriteBufferOperation : public NodeOperation {
 	MemoryProxy *m_memoryProxy;
 	bool m_single_value; /* single value stored in buffer */
+	bool m_fullFrame; /* calculate the input a buffer at a time where supported */
 	NodeOperation *m_input;
 public:
 	WriteBufferOperation(DataType datatype);
@@ -41,6 +42,7 @@ public:
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
 	bool isWriteBufferOperation() const { return true; }
 	bool isSingleValue() const { return m_single_value; }
+	void setFullFrame(bool fullFrame) { this->m_fullFrame = fullFrame; }
 
 	void executeRegion(rcti *rect, unsigned int tileNumber);
 	void initExecution();
@@ -1857,6 +1857,11 @@ static bool save_image_doit(bContext *C, SpaceImage *sima, wmOperator *op, SaveI
 
 		/* we need renderresult for exr and rendered multiview */
 		scene = CTX_data_scene(C);
+		/* passes of multilayer images are only read when used, all are written */
+		if (!BKE_image_multilayer_load_all_passes(ima)) {
+			BKE_report(op->reports, RPT_ERROR, "Did not write, could not read all passes of the multilayer image");
+			goto cleanup;
+		}
 		rr = BKE_image_acquire_renderresult(scene, ima);
 		bool is_mono = rr ? BLI_listbase_count_at_most(&rr->views, 2) < 2 : BLI_listbase_count_at_most(&ima->views, 2) < 2;
 		bool is_exr_rr = rr && ELEM(imf->imtype, R_IMF_IMTYPE_OPENEXR, R_IMF_IMTYPE_MULTILAYER) && RE_HasFloatPixels(rr);
@@ -1927,6 +1927,7 @@ static int sequencer_refresh_all_exec(bContext *C, wmOperator *UNUSED(op))
 	Editing *ed = BKE_sequencer_editing_get(scene, false);
 
 	BKE_sequencer_free_imbuf(scene, &ed->seqbase, false);
+	BKE_sequencer_cache_disk_cleanup(scene);
 
 	WM_event_add_notifier(C, NC_SCENE | ND_SEQUENCER, scene);
 
@@ -1938,7 +1939,7 @@ void SEQUENCER_OT_refresh_all(struct wmOperatorType *ot)
 	/* identifiers */
 	ot->name = "Refresh Sequencer";
 	ot->idname = "SEQUENCER_OT_refresh_all";
-	ot->description = "Refresh the sequencer editor";
+	ot->description = "Refresh the sequencer editor, also removing frames of the scene cached on disk";
 
 	/* api callbacks */
 	ot->exec = sequencer_refresh_all_exec;
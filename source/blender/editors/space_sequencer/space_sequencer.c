@@ -686,6 +686,7 @@ static void sequencer_preview_region_listener(
 				case ND_KEYFRAME:
 					/* Otherwise, often prevents seeing immediately effects of keyframe editing... */
 					BKE_sequencer_cache_cleanup();
+					BKE_sequencer_cache_disk_cleanup_all(G_MAIN);
 					ED_region_tag_redraw(ar);
 					break;
 			}
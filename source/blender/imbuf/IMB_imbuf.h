@@ -77,6 +77,7 @@
  * \attention defined in ???
  */
 struct ImBuf;
+struct ImBufLoadOptions;
 
 /**
  *
@@ -106,6 +107,9 @@ void IMB_exit(void);
  * \attention Defined in readimage.c
  */
 struct ImBuf *IMB_ibImageFromMemory(unsigned char *mem, size_t size, int flags, char colorspace[IM_MAX_SPACE], const char *descr);
+struct ImBuf *IMB_ibImageFromMemory_ex(
+        unsigned char *mem, size_t size, int flags, char colorspace[IM_MAX_SPACE], const char *descr,
+        struct ImBufLoadOptions *options);
 
 /**
  *
@@ -118,6 +122,8 @@ struct ImBuf *IMB_testiffname(const char *filepath, int flags);
  * \attention Defined in readimage.c
  */
 struct ImBuf *IMB_loadiffname(const char *filepath, int flags, char colorspace[IM_MAX_SPACE]);
+struct ImBuf *IMB_loadiffname_ex(
+        const char *filepath, int flags, char colorspace[IM_MAX_SPACE], struct ImBufLoadOptions *options);
 
 /**
  *
@@ -168,6 +174,13 @@ struct ImBuf *IMB_makeSingleUser(struct ImBuf *ibuf);
  */
 struct ImBuf *IMB_dupImBuf(const struct ImBuf *ibuf1);
 
+/**
+ * Memory used by the pixels of imbuf and its mipmaps, as counted by caches
+ *
+ * \attention Defined in moviecache.c
+ */
+size_t IMB_get_size_in_memory(struct ImBuf *ibuf);
+
 /**
  *
  * \attention Defined in allocimbuf.c
@@ -382,6 +395,24 @@ struct ImBuf *IMB_onehalf(struct ImBuf *ibuf1);
  */
 bool IMB_scaleImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy);
 
+/**
+ * Filters for #IMB_scaleImBuf_filter.
+ */
+typedef enum eIMBScaleFilter {
+	/** Average of the covered pixels, nearest pixel when enlarging. */
+	IMB_SCALE_FILTER_BOX = 0,
+	/** Linear interpolation, triangle filter when shrinking. */
+	IMB_SCALE_FILTER_BILINEAR = 1,
+	/** Lanczos windowed sinc (3 lobes), sharper but may ring at hard edges. */
+	IMB_SCALE_FILTER_LANCZOS = 2,
+} eIMBScaleFilter;
+
+/**
+ *
+ * \attention Defined in scaling.c
+ */
+bool IMB_scaleImBuf_filter(struct ImBuf *ibuf, unsigned int newx, unsigned int newy, eIMBScaleFilter filter);
+
 /**
  *
  * \attention Defined in scaling.c
@@ -300,10 +300,49 @@ enum {
 	IB_ignore_alpha     = 1 << 14,
 	IB_thumbnail        = 1 << 15,
 	IB_multiview        = 1 << 16,
+	/** decode movie frames ahead of the requested one on a worker thread while playing */
+	IB_animdecodeahead  = 1 << 17,
 };
 
 /** \} */
 
+/**
+ * \name Imbuf load options
+ * \brief Read only part of an image, see #IMB_loadiffname_ex.
+ *
+ * OpenEXR reads the region from tiles or bands of scanlines, levels from
+ * mipmaps where present, and multilayer passes selectively. Other formats
+ * are decoded in full and then cropped and scaled, giving the same result.
+ * Region and level apply to single layer images, the names to multilayer.
+ *
+ * \{ */
+
+/** ImBufLoadOptions.flag */
+enum {
+	/** only read the region of interest */
+	IMB_LOAD_ROI         = 1 << 0,
+	/** multilayer: create the layers and passes, but don't read their pixels */
+	IMB_LOAD_LAYOUT_ONLY = 1 << 1,
+};
+
+typedef struct ImBufLoadOptions {
+	int flag;
+	/** region of interest in full resolution pixels, max is exclusive,
+	 * rounded outwards to whole pixels of the level */
+	int roi_xmin, roi_ymin, roi_xmax, roi_ymax;
+	/** resolution level, each level halves the image size */
+	int level;
+	/** when set, use the lowest resolution level where the largest side is still this size */
+	int fit_size;
+	/** multilayer: only read passes matching these names, NULL matches all */
+	const char *layer, *pass, *view;
+
+	/** set on load, size of the full resolution image */
+	int full_x, full_y;
+} ImBufLoadOptions;
+
+/** \} */
+
 /**
  * \name Imbuf preset profile tags
  * \brief Some predefined color space profiles that 8 bit imbufs can represent
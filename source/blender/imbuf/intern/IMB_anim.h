@@ -93,6 +93,7 @@
 struct IDProperty;
 struct _AviMovie;
 struct anim_index;
+struct AnimDecodeAhead;
 
 struct anim {
 	int ib_flags;
@@ -140,12 +141,20 @@ struct anim {
 	AVFrame *pFrameRGB;
 	AVFrame *pFrameDeinterlaced;
 	struct SwsContext *img_convert_ctx;
+	/* color conversion split in bands of rows converted in parallel,
+	 * NULL when the pixel format or frame size doesn't allow it */
+	struct SwsContext **img_convert_ctx_bands;
+	int img_convert_num_bands;
+	int img_convert_band_height;
 	int videoStream;
 
 	struct ImBuf *last_frame;
 	int64_t last_pts;
 	int64_t next_pts;
 	AVPacket next_packet;
+
+	/* frames decoded ahead by a worker thread, see IB_animdecodeahead */
+	struct AnimDecodeAhead *decode_ahead;
 #endif
 
 	char index_dir[768];
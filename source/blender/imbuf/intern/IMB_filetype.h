@@ -31,6 +31,7 @@
 /* Generic File Type */
 
 struct ImBuf;
+struct ImBufLoadOptions;
 
 #define IM_FTYPE_FLOAT	1
 
@@ -49,6 +50,10 @@ typedef struct ImFileType {
 	int flag;
 	int filetype;
 	int default_save_role;
+
+	/* optional, load with #ImBufLoadOptions, otherwise the loaded image is cropped and scaled */
+	struct ImBuf *(*load_ex)(const unsigned char *mem, size_t size, int flags, char colorspace[IM_MAX_SPACE],
+	                         struct ImBufLoadOptions *options);
 } ImFileType;
 
 extern const ImFileType IMB_FILE_TYPES[];
@@ -63,6 +68,10 @@ void imb_tile_cache_exit(void);
 void imb_loadtile(struct ImBuf *ibuf, int tx, int ty, unsigned int *rect);
 void imb_tile_cache_tile_free(struct ImBuf *ibuf, int tx, int ty);
 
+int imb_load_options_level(const struct ImBufLoadOptions *options, int width, int height);
+void imb_load_options_region(
+        const struct ImBufLoadOptions *options, int width, int height, int level, int r_region[4]);
+
 /* Type Specific Functions */
 
 /* png */
@@ -83,10 +83,23 @@
 #include "IMB_metadata.h"
 
 #ifdef WITH_FFMPEG
+#  include "DNA_listBase.h"
+
+#  include "BLI_math_base.h"
+#  include "BLI_task.h"
+#  include "BLI_threads.h"
+
 #  include "BKE_global.h"  /* ENDIAN_ORDER */
 
+#  include "MEM_CacheLimiterC-Api.h"
+
+#  include "PIL_time.h"
+
+#  include "atomic_ops.h"
+
 #  include <libavformat/avformat.h>
 #  include <libavcodec/avcodec.h>
+#  include <libavutil/pixdesc.h>
 #  include <libavutil/rational.h>
 #  include <libswscale/swscale.h>
 
@@ -473,6 +486,298 @@ BLI_INLINE bool need_aligned_ffmpeg_buffer(struct anim *anim)
 	return (anim->x & 31) != 0;
 }
 
+/* Frames decoded ahead of the last fetched one while a movie opened with
+ * IB_animdecodeahead is played forward, so decoding and color conversion of
+ * the next frames overlap with whatever the caller does with the current one.
+ *
+ * Frames of the ring directly follow anim->last_frame in stream order, and the
+ * frame pending in the decoder (anim->pFrame at anim->next_pts) directly follows
+ * the last frame of the ring. Decoder state is only accessed with the mutex held.
+ *
+ * The worker only runs during forward playback: a fetch out of order stops it,
+ * and it stops by itself once the movie is not fetched for a while (playback
+ * stopped or moved past the strip), freeing the ring either way. Frames decoded
+ * ahead are not owned by the memory cache limiter, so all movies share a single
+ * budget kept to a part of the cache limit. */
+
+#define DECODE_AHEAD_MAX_FRAMES 8
+#define DECODE_AHEAD_MAX_MEMORY (256 * 1024 * 1024)
+/* the worker stops after this long without a fetch */
+#define DECODE_AHEAD_IDLE_TIMEOUT 1.0
+/* interval of the worker to check for the idle timeout and free budget */
+#define DECODE_AHEAD_POLL_MS 100
+
+/* memory used by frames decoded ahead of all movies */
+static size_t decode_ahead_mem_in_use = 0;
+
+typedef struct AnimDecodeAheadFrame {
+	ImBuf *ibuf;
+	int64_t pts;
+} AnimDecodeAheadFrame;
+
+typedef struct AnimDecodeAhead {
+	ThreadMutex mutex;
+	ThreadCondition cond;
+	ListBase threads;
+	bool thread_running;
+	/* set by the worker once it is done, it still needs to be joined */
+	bool thread_exited;
+	bool stop;
+
+	/* set while frames are fetched one after the other */
+	bool active;
+	/* fetches waiting for the mutex, the worker gives way to them */
+	uint32_t num_waiting;
+	/* time of the last fetch, for the idle timeout */
+	double last_fetch_time;
+
+	AnimDecodeAheadFrame frames[DECODE_AHEAD_MAX_FRAMES];
+	int num_frames;
+	/* memory reserved from the shared budget by each frame */
+	size_t frame_mem_size;
+} AnimDecodeAhead;
+
+static void ffmpeg_decode_ahead_init(struct anim *anim)
+{
+	AnimDecodeAhead *da = MEM_callocN(sizeof(AnimDecodeAhead), "anim decode ahead");
+
+	BLI_mutex_init(&da->mutex);
+	BLI_condition_init(&da->cond);
+	da->frame_mem_size = (size_t)anim->x * (size_t)anim->y * 4;
+
+	anim->decode_ahead = da;
+}
+
+/* Reserve memory for one more frame decoded ahead, false when over budget. */
+static bool ffmpeg_decode_ahead_mem_reserve(AnimDecodeAhead *da)
+{
+	const size_t mem_limit = min_zz(DECODE_AHEAD_MAX_MEMORY, MEM_CacheLimiter_get_maximum() / 4);
+
+	if (atomic_add_and_fetch_z(&decode_ahead_mem_in_use, da->frame_mem_size) > mem_limit) {
+		atomic_sub_and_fetch_z(&decode_ahead_mem_in_use, da->frame_mem_size);
+		return false;
+	}
+
+	return true;
+}
+
+static void ffmpeg_decode_ahead_mem_release(AnimDecodeAhead *da, int num_frames)
+{
+	if (num_frames) {
+		atomic_sub_and_fetch_z(&decode_ahead_mem_in_use, da->frame_mem_size * (size_t)num_frames);
+	}
+}
+
+static void ffmpeg_decode_ahead_clear(AnimDecodeAhead *da)
+{
+	int i;
+
+	for (i = 0; i < da->num_frames; i++) {
+		IMB_freeImBuf(da->frames[i].ibuf);
+	}
+	ffmpeg_decode_ahead_mem_release(da, da->num_frames);
+	da->num_frames = 0;
+}
+
+/* Stop and join the worker, must be called with the mutex held. */
+static void ffmpeg_decode_ahead_thread_end(AnimDecodeAhead *da)
+{
+	if (!da->thread_running) {
+		return;
+	}
+
+	da->stop = true;
+	BLI_condition_notify_all(&da->cond);
+
+	while (!da->thread_exited) {
+		BLI_condition_wait(&da->cond, &da->mutex);
+	}
+
+	/* The worker does not lock the mutex anymore once it has exited. */
+	BLI_threadpool_end(&da->threads);
+
+	da->thread_running = false;
+	da->thread_exited = false;
+	da->stop = false;
+}
+
+static void ffmpeg_decode_ahead_free(struct anim *anim)
+{
+	AnimDecodeAhead *da = anim->decode_ahead;
+
+	if (da == NULL) {
+		return;
+	}
+
+	BLI_mutex_lock(&da->mutex);
+	ffmpeg_decode_ahead_thread_end(da);
+	ffmpeg_decode_ahead_clear(da);
+	BLI_mutex_unlock(&da->mutex);
+
+	BLI_mutex_end(&da->mutex);
+	BLI_condition_end(&da->cond);
+
+	MEM_freeN(da);
+	anim->decode_ahead = NULL;
+}
+
+/* Color conversion of big frames is split in bands of rows, each with its own
+ * swscale context since a context can only convert slices in order. Band heights
+ * are a multiple of 16 rows so chroma planes are split on whole rows as well. */
+
+#define FFMPEG_CONVERT_MIN_BAND_HEIGHT 64
+
+typedef struct FFmpegConvertBandData {
+	struct anim *anim;
+	AVFrame *input;
+	uint8_t *dst;
+	int dst_stride;
+	int plane_shift[4];
+} FFmpegConvertBandData;
+
+static bool ffmpeg_setup_colorspace_details(struct anim *anim, struct SwsContext *ctx)
+{
+#ifdef FFMPEG_SWSCALE_COLOR_SPACE_SUPPORT
+	/* The following for color space determination */
+	int srcRange, dstRange, brightness, contrast, saturation;
+	int *table;
+	const int *inv_table;
+
+	/* Try do detect if input has 0-255 YCbCR range (JFIF Jpeg MotionJpeg) */
+	if (sws_getColorspaceDetails(ctx, (int **)&inv_table, &srcRange,
+	                             &table, &dstRange, &brightness, &contrast, &saturation))
+	{
+		return false;
+	}
+
+	srcRange = srcRange || anim->pCodecCtx->color_range == AVCOL_RANGE_JPEG;
+	inv_table = sws_getCoefficients(anim->pCodecCtx->colorspace);
+
+	if (sws_setColorspaceDetails(ctx, (int *)inv_table, srcRange,
+	                             table, dstRange, brightness, contrast, saturation))
+	{
+		return false;
+	}
+#else
+	UNUSED_VARS(anim, ctx);
+#endif
+	return true;
+}
+
+static void ffmpeg_convert_bands_free(struct anim *anim)
+{
+	int i;
+
+	if (anim->img_convert_ctx_bands == NULL) {
+		return;
+	}
+
+	for (i = 0; i < anim->img_convert_num_bands; i++) {
+		if (anim->img_convert_ctx_bands[i]) {
+			sws_freeContext(anim->img_convert_ctx_bands[i]);
+		}
+	}
+	MEM_freeN(anim->img_convert_ctx_bands);
+	anim->img_convert_ctx_bands = NULL;
+	anim->img_convert_num_bands = 0;
+}
+
+static void ffmpeg_convert_bands_init(struct anim *anim)
+{
+	const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(anim->pCodecCtx->pix_fmt);
+	const int num_threads = BLI_system_thread_count();
+	int band_height, num_bands, i;
+
+	/* Big endian conversion is followed by a byte swap which isn't split. */
+	if (ENDIAN_ORDER == B_ENDIAN || num_threads < 2 || desc == NULL ||
+	    (desc->flags & (AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_BITSTREAM | AV_PIX_FMT_FLAG_HWACCEL)))
+	{
+		return;
+	}
+
+	band_height = (anim->y + num_threads - 1) / num_threads;
+	band_height = max_ii((band_height + 15) & ~15, FFMPEG_CONVERT_MIN_BAND_HEIGHT);
+	num_bands = (anim->y + band_height - 1) / band_height;
+
+	if (num_bands < 2) {
+		return;
+	}
+
+	anim->img_convert_ctx_bands = MEM_callocN(sizeof(struct SwsContext *) * num_bands, "ffmpeg convert bands");
+	anim->img_convert_num_bands = num_bands;
+	anim->img_convert_band_height = band_height;
+
+	for (i = 0; i < num_bands; i++) {
+		const int height = min_ii(band_height, anim->y - i * band_height);
+		struct SwsContext *ctx = sws_getContext(
+		        anim->x,
+		        height,
+		        anim->pCodecCtx->pix_fmt,
+		        anim->x,
+		        height,
+		        AV_PIX_FMT_RGBA,
+		        SWS_FAST_BILINEAR | SWS_FULL_CHR_H_INT,
+		        NULL, NULL, NULL);
+
+		if (ctx == NULL) {
+			ffmpeg_convert_bands_free(anim);
+			return;
+		}
+
+		ffmpeg_setup_colorspace_details(anim, ctx);
+		anim->img_convert_ctx_bands[i] = ctx;
+	}
+}
+
+static void ffmpeg_convert_band(void *__restrict userdata, const int band, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	FFmpegConvertBandData *data = userdata;
+	struct anim *anim = data->anim;
+	AVFrame *input = data->input;
+	const int y = band * anim->img_convert_band_height;
+	const int height = min_ii(anim->img_convert_band_height, anim->y - y);
+	const uint8_t *src[4] = {NULL};
+	int src_stride[4] = {0};
+	uint8_t *dst[4] = {data->dst + (ptrdiff_t)y * data->dst_stride, NULL, NULL, NULL};
+	int dst_stride[4] = {data->dst_stride, 0, 0, 0};
+
+	for (int i = 0; i < 4 && input->data[i]; i++) {
+		src[i] = input->data[i] + (ptrdiff_t)(y >> data->plane_shift[i]) * input->linesize[i];
+		src_stride[i] = input->linesize[i];
+	}
+
+	sws_scale(anim->img_convert_ctx_bands[band], src, src_stride, 0, height, dst, dst_stride);
+}
+
+/* Convert input into the RGBA rows starting at dst, row y being at dst + y * dst_stride. */
+static void ffmpeg_convert_bands(struct anim *anim, AVFrame *input, uint8_t *dst, int dst_stride)
+{
+	const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(anim->pCodecCtx->pix_fmt);
+	FFmpegConvertBandData data;
+	ParallelRangeSettings settings;
+	int plane, c;
+
+	data.anim = anim;
+	data.input = input;
+	data.dst = dst;
+	data.dst_stride = dst_stride;
+
+	/* Planes holding chroma components are vertically subsampled, the first plane never is. */
+	for (plane = 0; plane < 4; plane++) {
+		data.plane_shift[plane] = 0;
+		for (c = 1; c < 3 && c < desc->nb_components && plane > 0; c++) {
+			if (desc->comp[c].plane == plane) {
+				data.plane_shift[plane] = desc->log2_chroma_h;
+			}
+		}
+	}
+
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.min_iter_per_thread = 1;
+
+	BLI_task_parallel_range(0, anim->img_convert_num_bands, &data, ffmpeg_convert_band, &settings);
+}
+
 static int startffmpeg(struct anim *anim)
 {
 	int i, videoStream;
@@ -485,13 +790,6 @@ static int startffmpeg(struct anim *anim)
 	double frs_den;
 	int streamcount;
 
-#ifdef FFMPEG_SWSCALE_COLOR_SPACE_SUPPORT
-	/* The following for color space determination */
-	int srcRange, dstRange, brightness, contrast, saturation;
-	int *table;
-	const int *inv_table;
-#endif
-
 	if (anim == NULL) return(-1);
 
 	streamcount = anim->streamindex;
@@ -537,6 +835,10 @@ static int startffmpeg(struct anim *anim)
 
 	pCodecCtx->workaround_bugs = 1;
 
+	/* Let the decoder use frame or slice threads, whichever the codec supports. */
+	pCodecCtx->thread_count = BLI_system_thread_count();
+	pCodecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
 	if (avcodec_open2(pCodecCtx, pCodec, NULL) < 0) {
 		avformat_close_input(&pFormatCtx);
 		return -1;
@@ -667,24 +969,15 @@ static int startffmpeg(struct anim *anim)
 		return -1;
 	}
 
-#ifdef FFMPEG_SWSCALE_COLOR_SPACE_SUPPORT
-	/* Try do detect if input has 0-255 YCbCR range (JFIF Jpeg MotionJpeg) */
-	if (!sws_getColorspaceDetails(anim->img_convert_ctx, (int **)&inv_table, &srcRange,
-	                              &table, &dstRange, &brightness, &contrast, &saturation))
-	{
-		srcRange = srcRange || anim->pCodecCtx->color_range == AVCOL_RANGE_JPEG;
-		inv_table = sws_getCoefficients(anim->pCodecCtx->colorspace);
-
-		if (sws_setColorspaceDetails(anim->img_convert_ctx, (int *)inv_table, srcRange,
-		                             table, dstRange, brightness, contrast, saturation))
-		{
-			fprintf(stderr, "Warning: Could not set libswscale colorspace details.\n");
-		}
-	}
-	else {
+	if (!ffmpeg_setup_colorspace_details(anim, anim->img_convert_ctx)) {
 		fprintf(stderr, "Warning: Could not set libswscale colorspace details.\n");
 	}
-#endif
+
+	ffmpeg_convert_bands_init(anim);
+
+	if (anim->ib_flags & IB_animdecodeahead) {
+		ffmpeg_decode_ahead_init(anim);
+	}
 
 	return (0);
 }
@@ -692,13 +985,12 @@ static int startffmpeg(struct anim *anim)
 /* postprocess the image in anim->pFrame and do color conversion
  * and deinterlacing stuff.
  *
- * Output is anim->last_frame
+ * Output is ibuf (anim->last_frame or a frame decoded ahead)
  */
 
-static void ffmpeg_postprocess(struct anim *anim)
+static void ffmpeg_postprocess(struct anim *anim, ImBuf *ibuf)
 {
 	AVFrame *input = anim->pFrame;
-	ImBuf *ibuf = anim->last_frame;
 	int filter_y = 0;
 
 	if (!anim->pFrameComplete) {
@@ -798,13 +1090,18 @@ static void ffmpeg_postprocess(struct anim *anim)
 		uint8_t *dst2[4]  = { dst[0] + (anim->y - 1) * dstStride[0],
 			                  0, 0, 0 };
 
-		sws_scale(anim->img_convert_ctx,
-		          (const uint8_t *const *)input->data,
-		          input->linesize,
-		          0,
-		          anim->y,
-		          dst2,
-		          dstStride2);
+		if (anim->img_convert_num_bands) {
+			ffmpeg_convert_bands(anim, input, dst2[0], dstStride2[0]);
+		}
+		else {
+			sws_scale(anim->img_convert_ctx,
+			          (const uint8_t *const *)input->data,
+			          input->linesize,
+			          0,
+			          anim->y,
+			          dst2,
+			          dstStride2);
+		}
 	}
 
 	if (need_aligned_ffmpeg_buffer(anim)) {
@@ -1003,8 +1300,84 @@ static int ffmpeg_seek_by_byte(AVFormatContext *pFormatCtx)
 	return false;
 }
 
-static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
-                               IMB_Timecode_Type tc)
+static void *ffmpeg_decode_ahead_thread(void *data)
+{
+	struct anim *anim = data;
+	AnimDecodeAhead *da = anim->decode_ahead;
+
+	BLI_mutex_lock(&da->mutex);
+
+	while (!da->stop) {
+		AnimDecodeAheadFrame *frame;
+
+		if (PIL_check_seconds_timer() - da->last_fetch_time > DECODE_AHEAD_IDLE_TIMEOUT) {
+			/* Not played anymore, don't hold on to the frames. */
+			ffmpeg_decode_ahead_clear(da);
+			break;
+		}
+
+		if (!da->active || da->num_frames == DECODE_AHEAD_MAX_FRAMES || !anim->pFrameComplete ||
+		    atomic_add_and_fetch_uint32(&da->num_waiting, 0) != 0 ||
+		    !ffmpeg_decode_ahead_mem_reserve(da))
+		{
+			BLI_condition_wait_timeout(&da->cond, &da->mutex, DECODE_AHEAD_POLL_MS);
+			continue;
+		}
+
+		/* Same as the tail of ffmpeg_fetchibuf_ex(): convert the pending frame,
+		 * then decode the next one so its PTS ends the converted frame. */
+		frame = &da->frames[da->num_frames++];
+		frame->ibuf = IMB_allocImBuf(anim->x, anim->y, 32, IB_rect);
+		frame->ibuf->rect_colorspace = colormanage_colorspace_get_named(anim->colorspace);
+		frame->pts = anim->next_pts;
+
+		ffmpeg_postprocess(anim, frame->ibuf);
+		ffmpeg_decode_video_frame(anim);
+	}
+
+	da->thread_exited = true;
+	BLI_condition_notify_all(&da->cond);
+	BLI_mutex_unlock(&da->mutex);
+
+	return NULL;
+}
+
+/* Make the frame decoded ahead showing pts_to_search the last frame,
+ * dropping the ones before it. */
+static bool ffmpeg_decode_ahead_take(struct anim *anim, int64_t pts_to_search)
+{
+	AnimDecodeAhead *da = anim->decode_ahead;
+	int i, j;
+
+	for (i = 0; i < da->num_frames; i++) {
+		const int64_t end_pts = (i + 1 < da->num_frames) ? da->frames[i + 1].pts : anim->next_pts;
+
+		if (da->frames[i].pts <= pts_to_search && end_pts > pts_to_search) {
+			break;
+		}
+	}
+
+	if (i == da->num_frames) {
+		return false;
+	}
+
+	for (j = 0; j < i; j++) {
+		IMB_freeImBuf(da->frames[j].ibuf);
+	}
+	ffmpeg_decode_ahead_mem_release(da, i + 1);
+
+	IMB_freeImBuf(anim->last_frame);
+	anim->last_frame = da->frames[i].ibuf;
+	anim->last_pts = da->frames[i].pts;
+
+	da->num_frames -= i + 1;
+	memmove(da->frames, da->frames + i + 1, sizeof(AnimDecodeAheadFrame) * da->num_frames);
+
+	return true;
+}
+
+static ImBuf *ffmpeg_fetchibuf_ex(struct anim *anim, int position,
+                                  IMB_Timecode_Type tc)
 {
 	int64_t pts_to_search = 0;
 	double frame_rate;
@@ -1014,8 +1387,9 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
 	AVStream *v_st;
 	int new_frame_index = 0; /* To quiet gcc barking... */
 	int old_frame_index = 0; /* To quiet gcc barking... */
-
-	if (anim == NULL) return (0);
+	AnimDecodeAhead *da = anim->decode_ahead;
+	int64_t last_frame_end_pts;
+	bool decoder_ahead = false;
 
 	av_log(anim->pFormatCtx, AV_LOG_DEBUG, "FETCH: pos=%d\n", position);
 
@@ -1053,8 +1427,11 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
 	       "(pts_timebase=%g, frame_rate=%g, st_time=%lld)\n",
 	       (long long int)pts_to_search, pts_time_base, frame_rate, st_time);
 
+	/* Frames decoded ahead follow the last frame, the decoder is past them. */
+	last_frame_end_pts = (da && da->num_frames) ? da->frames[0].pts : anim->next_pts;
+
 	if (anim->last_frame &&
-	    anim->last_pts <= pts_to_search && anim->next_pts > pts_to_search)
+	    anim->last_pts <= pts_to_search && last_frame_end_pts > pts_to_search)
 	{
 		av_log(anim->pFormatCtx, AV_LOG_DEBUG,
 		       "FETCH: frame repeat: last: %lld next: %lld\n",
@@ -1065,8 +1442,37 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
 		return anim->last_frame;
 	}
 
-	if (position > anim->curposition + 1 &&
-	    anim->preseek &&
+	if (da) {
+		/* Keep decoding ahead only while playing forward. */
+		const bool sequential = anim->curposition >= 0 && position == anim->curposition + 1;
+
+		if (da->num_frames) {
+			if (ffmpeg_decode_ahead_take(anim, pts_to_search)) {
+				av_log(anim->pFormatCtx, AV_LOG_DEBUG,
+				       "FETCH: frame decoded ahead: %lld\n",
+				       (long long int)anim->last_pts);
+				da->active = true;
+				IMB_refImBuf(anim->last_frame);
+				anim->curposition = position;
+				return anim->last_frame;
+			}
+
+			decoder_ahead = true;
+			ffmpeg_decode_ahead_clear(da);
+		}
+
+		da->active = sequential;
+	}
+
+	if (decoder_ahead && pts_to_search >= anim->next_pts) {
+		av_log(anim->pFormatCtx, AV_LOG_DEBUG,
+		       "FETCH: past the frames decoded ahead\n");
+
+		ffmpeg_decode_video_frame_scan(anim, pts_to_search);
+	}
+	else if (!decoder_ahead &&
+	         position > anim->curposition + 1 &&
+	         anim->preseek &&
 	    !tc_index &&
 	    position - (anim->curposition + 1) < anim->preseek)
 	{
@@ -1075,7 +1481,8 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
 
 		ffmpeg_decode_video_frame_scan(anim, pts_to_search);
 	}
-	else if (tc_index &&
+	else if (!decoder_ahead &&
+	         tc_index &&
 	         IMB_indexer_can_scan(tc_index, old_frame_index,
 	                              new_frame_index))
 	{
@@ -1085,7 +1492,7 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
 
 		ffmpeg_decode_video_frame_scan(anim, pts_to_search);
 	}
-	else if (position != anim->curposition + 1) {
+	else if (decoder_ahead || position != anim->curposition + 1) {
 		long long pos;
 		int ret;
 
@@ -1178,7 +1585,7 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
 	anim->last_frame = IMB_allocImBuf(anim->x, anim->y, 32, IB_rect);
 	anim->last_frame->rect_colorspace = colormanage_colorspace_get_named(anim->colorspace);
 
-	ffmpeg_postprocess(anim);
+	ffmpeg_postprocess(anim, anim->last_frame);
 
 	anim->last_pts = anim->next_pts;
 
@@ -1191,11 +1598,52 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
 	return anim->last_frame;
 }
 
+static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
+                               IMB_Timecode_Type tc)
+{
+	AnimDecodeAhead *da;
+	ImBuf *ibuf;
+
+	if (anim == NULL) return (0);
+
+	da = anim->decode_ahead;
+
+	if (da == NULL) {
+		return ffmpeg_fetchibuf_ex(anim, position, tc);
+	}
+
+	atomic_add_and_fetch_uint32(&da->num_waiting, 1);
+	BLI_mutex_lock(&da->mutex);
+	atomic_sub_and_fetch_uint32(&da->num_waiting, 1);
+
+	ibuf = ffmpeg_fetchibuf_ex(anim, position, tc);
+	da->last_fetch_time = PIL_check_seconds_timer();
+
+	if (da->thread_exited || !da->active) {
+		/* Timed out or no longer played forward. */
+		ffmpeg_decode_ahead_thread_end(da);
+		ffmpeg_decode_ahead_clear(da);
+	}
+
+	if (da->active && !da->thread_running) {
+		BLI_threadpool_init(&da->threads, ffmpeg_decode_ahead_thread, 1);
+		BLI_threadpool_insert(&da->threads, anim);
+		da->thread_running = true;
+	}
+
+	BLI_condition_notify_all(&da->cond);
+	BLI_mutex_unlock(&da->mutex);
+
+	return ibuf;
+}
+
 static void free_anim_ffmpeg(struct anim *anim)
 {
 	if (anim == NULL) return;
 
 	if (anim->pCodecCtx) {
+		ffmpeg_decode_ahead_free(anim);
+
 		avcodec_close(anim->pCodecCtx);
 		avformat_close_input(&anim->pFormatCtx);
 
@@ -1221,6 +1669,7 @@ static void free_anim_ffmpeg(struct anim *anim)
 		av_frame_free(&anim->pFrameDeinterlaced);
 
 		sws_freeContext(anim->img_convert_ctx);
+		ffmpeg_convert_bands_free(anim);
 		IMB_freeImBuf(anim->last_frame);
 		if (anim->next_packet.stream_index != -1) {
 			av_free_packet(&anim->next_packet);
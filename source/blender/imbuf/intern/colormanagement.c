@@ -59,6 +59,7 @@
 #include "BLI_string.h"
 #include "BLI_threads.h"
 #include "BLI_rect.h"
+#include "BLI_task.h"
 
 #include "BKE_appdir.h"
 #include "BKE_colortools.h"
@@ -111,6 +112,15 @@ typedef struct ColormanageProcessor {
 	OCIO_ConstProcessorRcPtr *processor;
 	CurveMapping *curve_mapping;
 	bool is_data_result;
+
+	/* Display transform baked into 3D LUT, used instead of OCIO processor for
+	 * buffers when set (see colormanage_processor_lut_bake). */
+	float *lut;
+	float lut_lin_max, lut_log_min, lut_log_scale;
+
+	/* Processor cache item this processor is shared from, NULL when processor is
+	 * owned by the caller. */
+	struct ColormanageProcessorCacheItem *cache_item;
 } ColormanageProcessor;
 
 static struct global_glsl_state {
@@ -141,6 +151,8 @@ static struct global_color_picking_state {
 	bool failed;
 } global_color_picking_state = {NULL};
 
+static void colormanage_processor_cache_free(void);
+
 /*********************** Color managed cache *************************/
 
 /* Cache Implementation Notes
@@ -721,6 +733,8 @@ void colormanagement_exit(void)
 	memset(&global_glsl_state, 0, sizeof(global_glsl_state));
 	memset(&global_color_picking_state, 0, sizeof(global_color_picking_state));
 
+	colormanage_processor_cache_free();
+
 	colormanage_free_config();
 }
 
@@ -952,6 +966,331 @@ static OCIO_ConstProcessorRcPtr *display_to_scene_linear_processor(ColorManagedD
 	return (OCIO_ConstProcessorRcPtr *) display->to_scene_linear;
 }
 
+/*********************** Processor cache *************************/
+
+/* Creating processor is expensive: OCIO builds the whole transform chain for the
+ * look, view and display, and the curve mapping is copied and premultiplied. Display
+ * buffers are updated for every redraw of image and sequencer editors, so processors
+ * of recently used settings are kept here and shared between all users.
+ *
+ * Shared processors are only read from, cached item is only re-used for another
+ * settings once all users released the processor.
+ */
+#define PROCESSOR_CACHE_SIZE 16
+
+/* Display transform can be baked into 3D LUT with a per-channel shaper:
+ * values below 2^LUT_STOPS_MIN are interpolated linearly towards zero in the first
+ * cell, the rest of cells are spaced logarithmically up to 2^LUT_STOPS_MAX and values
+ * above are clamped. The range is shifted by exposure, so the same range of display
+ * values is covered. Precision is good enough for byte display buffers only.
+ */
+#define LUT_SIZE 65
+#define LUT_STOPS_MIN -12.0f
+#define LUT_STOPS_MAX 8.0f
+/* Baking costs about as much as transforming a buffer of the LUT size, so it's only
+ * worth it for buffers which are much bigger. */
+#define LUT_MIN_PIXELS (4 * LUT_SIZE * LUT_SIZE * LUT_SIZE)
+
+typedef struct ColormanageProcessorKey {
+	char from_colorspace[MAX_COLORSPACE_NAME];
+	char to_colorspace[MAX_COLORSPACE_NAME];  /* display device for display processors */
+	char look[MAX_COLORSPACE_NAME];
+	char view[MAX_COLORSPACE_NAME];
+	float exposure, gamma;
+	/* Compared by pointer and timestamp, same as GLSL state and display buffers cache. */
+	CurveMapping *curve_mapping;
+	int curve_mapping_timestamp;
+	bool is_display;
+	bool use_lut;
+} ColormanageProcessorKey;
+
+typedef struct ColormanageProcessorCacheItem {
+	ColormanageProcessorKey key;
+	ColormanageProcessor *cm_processor;
+	int users;
+	unsigned int last_used;
+} ColormanageProcessorCacheItem;
+
+static struct global_processor_cache {
+	ColormanageProcessorCacheItem items[PROCESSOR_CACHE_SIZE];
+	unsigned int clock;
+} global_processor_cache = {{{{{0}}}}};
+
+static void colormanage_processor_free_data(ColormanageProcessor *cm_processor)
+{
+	if (cm_processor->curve_mapping)
+		curvemapping_free(cm_processor->curve_mapping);
+	if (cm_processor->processor)
+		OCIO_processorRelease(cm_processor->processor);
+	if (cm_processor->lut)
+		MEM_freeN(cm_processor->lut);
+
+	MEM_freeN(cm_processor);
+}
+
+static float lut_shaper_inverse(const ColormanageProcessor *cm_processor, int index)
+{
+	if (index == 0) {
+		return 0.0f;
+	}
+	return exp2f(cm_processor->lut_log_min + (float)(index - 1) / cm_processor->lut_log_scale);
+}
+
+/* Position of the value in LUT cells, in [0, LUT_SIZE - 1]. */
+BLI_INLINE float lut_shaper(const ColormanageProcessor *cm_processor, float value)
+{
+	/* also catches NaN */
+	if (!(value > 0.0f)) {
+		return 0.0f;
+	}
+	if (value < cm_processor->lut_lin_max) {
+		return value / cm_processor->lut_lin_max;
+	}
+	return min_ff(1.0f + (log2f(value) - cm_processor->lut_log_min) * cm_processor->lut_log_scale,
+	              (float)(LUT_SIZE - 1));
+}
+
+static void lut_bake_slice_func(void *__restrict userdata,
+                                const int b,
+                                const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	ColormanageProcessor *cm_processor = userdata;
+	float *slice = cm_processor->lut + ((size_t)b) * LUT_SIZE * LUT_SIZE * 3;
+	const float blue = lut_shaper_inverse(cm_processor, b);
+	OCIO_PackedImageDesc *img;
+	float *fp = slice;
+
+	for (int g = 0; g < LUT_SIZE; g++) {
+		const float green = lut_shaper_inverse(cm_processor, g);
+		for (int r = 0; r < LUT_SIZE; r++, fp += 3) {
+			fp[0] = lut_shaper_inverse(cm_processor, r);
+			fp[1] = green;
+			fp[2] = blue;
+		}
+	}
+
+	img = OCIO_createOCIO_PackedImageDesc(
+	        slice, LUT_SIZE, LUT_SIZE, 3, sizeof(float),
+	        3 * sizeof(float), 3 * sizeof(float) * LUT_SIZE);
+	OCIO_processorApply(cm_processor->processor, img);
+	OCIO_PackedImageDescRelease(img);
+}
+
+static void colormanage_processor_lut_bake(ColormanageProcessor *cm_processor, float exposure)
+{
+	ParallelRangeSettings settings;
+	const float stops_min = LUT_STOPS_MIN - exposure;
+	const float stops_max = LUT_STOPS_MAX - exposure;
+
+	cm_processor->lut_lin_max = exp2f(stops_min);
+	cm_processor->lut_log_min = stops_min;
+	cm_processor->lut_log_scale = (float)(LUT_SIZE - 2) / (stops_max - stops_min);
+	cm_processor->lut = MEM_mallocN(sizeof(float) * 3 * LUT_SIZE * LUT_SIZE * LUT_SIZE,
+	                                "colormanagement display LUT");
+
+	BLI_parallel_range_settings_defaults(&settings);
+	BLI_task_parallel_range(0, LUT_SIZE, cm_processor, lut_bake_slice_func, &settings);
+}
+
+/* Trilinear interpolation of the baked LUT, same as OCIO_processorApply(_predivide)
+ * for RGB part of pixels. */
+static void colormanage_processor_lut_apply(const ColormanageProcessor *cm_processor, float *buffer,
+                                            size_t num_pixels, int channels, bool predivide)
+{
+	const float *lut = cm_processor->lut;
+	const size_t stride_g = LUT_SIZE * 3;
+	const size_t stride_b = LUT_SIZE * LUT_SIZE * 3;
+	float *pixel = buffer;
+
+	for (size_t i = 0; i < num_pixels; i++, pixel += channels) {
+		const float alpha = (predivide && channels == 4) ? pixel[3] : 1.0f;
+		const bool use_alpha = (alpha != 1.0f && alpha != 0.0f);
+		const float *corner;
+		float fac[3];
+		size_t offset = 0;
+
+		for (int c = 0; c < 3; c++) {
+			const float position = lut_shaper(cm_processor, use_alpha ? pixel[c] / alpha : pixel[c]);
+			const int index = min_ii((int)position, LUT_SIZE - 2);
+			fac[c] = position - (float)index;
+			offset += (size_t)index * ((c == 0) ? 3 : ((c == 1) ? stride_g : stride_b));
+		}
+
+		corner = lut + offset;
+
+		for (int c = 0; c < 3; c++) {
+			const float *p0 = corner + c;
+			const float *p1 = corner + c + stride_b;
+			const float c00 = interpf(p0[3], p0[0], fac[0]);
+			const float c10 = interpf(p0[stride_g + 3], p0[stride_g], fac[0]);
+			const float c01 = interpf(p1[3], p1[0], fac[0]);
+			const float c11 = interpf(p1[stride_g + 3], p1[stride_g], fac[0]);
+			const float value = interpf(interpf(c11, c01, fac[1]), interpf(c10, c00, fac[1]), fac[2]);
+
+			pixel[c] = use_alpha ? value * alpha : value;
+		}
+	}
+}
+
+static ColormanageProcessor *display_processor_create(const ColorManagedViewSettings *view_settings,
+                                                      const ColorManagedDisplaySettings *display_settings,
+                                                      bool use_lut)
+{
+	ColormanageProcessor *cm_processor;
+	ColorSpace *display_space;
+
+	cm_processor = MEM_callocN(sizeof(ColormanageProcessor), "colormanagement processor");
+
+	display_space =  display_transform_get_colorspace(view_settings, display_settings);
+	if (display_space)
+		cm_processor->is_data_result = display_space->is_data;
+
+	cm_processor->processor = create_display_buffer_processor(view_settings->look,
+	                                                          view_settings->view_transform,
+	                                                          display_settings->display_device,
+	                                                          view_settings->exposure,
+	                                                          view_settings->gamma,
+	                                                          global_role_scene_linear);
+
+	if (view_settings->flag & COLORMANAGE_VIEW_USE_CURVES) {
+		cm_processor->curve_mapping = curvemapping_copy(view_settings->curve_mapping);
+		curvemapping_premultiply(cm_processor->curve_mapping, false);
+	}
+
+	if (use_lut && cm_processor->processor) {
+		colormanage_processor_lut_bake(cm_processor, view_settings->exposure);
+	}
+
+	return cm_processor;
+}
+
+static ColormanageProcessor *colorspace_processor_create(const char *from_colorspace, const char *to_colorspace)
+{
+	ColormanageProcessor *cm_processor;
+	ColorSpace *color_space;
+
+	cm_processor = MEM_callocN(sizeof(ColormanageProcessor), "colormanagement processor");
+
+	color_space = colormanage_colorspace_get_named(to_colorspace);
+	cm_processor->is_data_result = color_space->is_data;
+
+	cm_processor->processor = create_colorspace_transform_processor(from_colorspace, to_colorspace);
+
+	return cm_processor;
+}
+
+static ColormanageProcessor *processor_cache_acquire(const ColormanageProcessorKey *key,
+                                                     const ColorManagedViewSettings *view_settings,
+                                                     const ColorManagedDisplaySettings *display_settings)
+{
+	ColormanageProcessorCacheItem *item = NULL;
+	ColormanageProcessor *cm_processor;
+	int i;
+
+	BLI_mutex_lock(&processor_lock);
+
+	global_processor_cache.clock++;
+
+	for (i = 0; i < PROCESSOR_CACHE_SIZE; i++) {
+		ColormanageProcessorCacheItem *cache_item = &global_processor_cache.items[i];
+
+		if (cache_item->cm_processor && memcmp(&cache_item->key, key, sizeof(*key)) == 0) {
+			cache_item->users++;
+			cache_item->last_used = global_processor_cache.clock;
+
+			BLI_mutex_unlock(&processor_lock);
+
+			return cache_item->cm_processor;
+		}
+	}
+
+	/* find empty or least recently used item which is not used by anyone */
+	for (i = 0; i < PROCESSOR_CACHE_SIZE; i++) {
+		ColormanageProcessorCacheItem *cache_item = &global_processor_cache.items[i];
+
+		if (cache_item->cm_processor == NULL) {
+			item = cache_item;
+			break;
+		}
+		else if (cache_item->users == 0 && (item == NULL || cache_item->last_used < item->last_used)) {
+			item = cache_item;
+		}
+	}
+
+	/* processor is created with lock held, so it isn't created several times */
+	if (key->is_display)
+		cm_processor = display_processor_create(view_settings, display_settings, key->use_lut);
+	else
+		cm_processor = colorspace_processor_create(key->from_colorspace, key->to_colorspace);
+
+	if (item) {
+		if (item->cm_processor)
+			colormanage_processor_free_data(item->cm_processor);
+
+		memcpy(&item->key, key, sizeof(*key));
+		item->cm_processor = cm_processor;
+		item->users = 1;
+		item->last_used = global_processor_cache.clock;
+
+		cm_processor->cache_item = item;
+	}
+
+	BLI_mutex_unlock(&processor_lock);
+
+	return cm_processor;
+}
+
+static ColormanageProcessor *display_processor_acquire(const ColorManagedViewSettings *view_settings,
+                                                       const ColorManagedDisplaySettings *display_settings,
+                                                       bool use_lut)
+{
+	ColormanageProcessorKey key;
+
+	/* zero padding of names, so key can be compared as memory */
+	memset(&key, 0, sizeof(key));
+
+	BLI_strncpy(key.from_colorspace, global_role_scene_linear, sizeof(key.from_colorspace));
+	BLI_strncpy(key.to_colorspace, display_settings->display_device, sizeof(key.to_colorspace));
+	BLI_strncpy(key.look, view_settings->look, sizeof(key.look));
+	BLI_strncpy(key.view, view_settings->view_transform, sizeof(key.view));
+	key.exposure = view_settings->exposure;
+	key.gamma = view_settings->gamma;
+	if ((view_settings->flag & COLORMANAGE_VIEW_USE_CURVES) && view_settings->curve_mapping) {
+		key.curve_mapping = view_settings->curve_mapping;
+		key.curve_mapping_timestamp = view_settings->curve_mapping->changed_timestamp;
+	}
+	key.is_display = true;
+	key.use_lut = use_lut;
+
+	return processor_cache_acquire(&key, view_settings, display_settings);
+}
+
+static ColormanageProcessor *colorspace_processor_acquire(const char *from_colorspace, const char *to_colorspace)
+{
+	ColormanageProcessorKey key;
+
+	memset(&key, 0, sizeof(key));
+
+	BLI_strncpy(key.from_colorspace, from_colorspace, sizeof(key.from_colorspace));
+	BLI_strncpy(key.to_colorspace, to_colorspace, sizeof(key.to_colorspace));
+
+	return processor_cache_acquire(&key, NULL, NULL);
+}
+
+static void colormanage_processor_cache_free(void)
+{
+	for (int i = 0; i < PROCESSOR_CACHE_SIZE; i++) {
+		ColormanageProcessorCacheItem *cache_item = &global_processor_cache.items[i];
+
+		if (cache_item->cm_processor) {
+			BLI_assert(cache_item->users == 0);
+			colormanage_processor_free_data(cache_item->cm_processor);
+		}
+	}
+
+	memset(&global_processor_cache, 0, sizeof(global_processor_cache));
+}
+
 void IMB_colormanagement_init_default_view_settings(
         ColorManagedViewSettings *view_settings,
         const ColorManagedDisplaySettings *display_settings)
@@ -1582,8 +1921,14 @@ static void colormanage_display_buffer_process_ex(ImBuf *ibuf, float *display_bu
 		skip_transform = is_ibuf_rect_in_display_space(ibuf, view_settings, display_settings);
 	}
 
-	if (skip_transform == false)
-		cm_processor = IMB_colormanagement_display_processor_new(view_settings, display_settings);
+	if (skip_transform == false) {
+		/* baked transform is only precise enough for byte display buffers */
+		const bool use_lut = (view_settings->flag & COLORMANAGE_VIEW_USE_BAKED_LUT) &&
+		                     display_buffer == NULL &&
+		                     ((size_t)ibuf->x) * ibuf->y >= LUT_MIN_PIXELS;
+
+		cm_processor = display_processor_acquire(view_settings, display_settings, use_lut);
+	}
 
 	display_buffer_apply_threaded(ibuf, ibuf->rect_float, (unsigned char *) ibuf->rect,
 	                              display_buffer, display_buffer_byte, cm_processor);
@@ -3252,12 +3597,8 @@ void IMB_partial_display_buffer_update_delayed(ImBuf *ibuf, int xmin, int ymin,
 ColormanageProcessor *IMB_colormanagement_display_processor_new(const ColorManagedViewSettings *view_settings,
                                                                 const ColorManagedDisplaySettings *display_settings)
 {
-	ColormanageProcessor *cm_processor;
 	ColorManagedViewSettings default_view_settings;
 	const ColorManagedViewSettings *applied_view_settings;
-	ColorSpace *display_space;
-
-	cm_processor = MEM_callocN(sizeof(ColormanageProcessor), "colormanagement processor");
 
 	if (view_settings) {
 		applied_view_settings = view_settings;
@@ -3268,38 +3609,12 @@ ColormanageProcessor *IMB_colormanagement_display_processor_new(const ColorManag
 		applied_view_settings = &default_view_settings;
 	}
 
-	display_space =  display_transform_get_colorspace(applied_view_settings, display_settings);
-	if (display_space)
-		cm_processor->is_data_result = display_space->is_data;
-
-	cm_processor->processor = create_display_buffer_processor(applied_view_settings->look,
-	                                                          applied_view_settings->view_transform,
-	                                                          display_settings->display_device,
-	                                                          applied_view_settings->exposure,
-	                                                          applied_view_settings->gamma,
-	                                                          global_role_scene_linear);
-
-	if (applied_view_settings->flag & COLORMANAGE_VIEW_USE_CURVES) {
-		cm_processor->curve_mapping = curvemapping_copy(applied_view_settings->curve_mapping);
-		curvemapping_premultiply(cm_processor->curve_mapping, false);
-	}
-
-	return cm_processor;
+	return display_processor_acquire(applied_view_settings, display_settings, false);
 }
 
 ColormanageProcessor *IMB_colormanagement_colorspace_processor_new(const char *from_colorspace, const char *to_colorspace)
 {
-	ColormanageProcessor *cm_processor;
-	ColorSpace *color_space;
-
-	cm_processor = MEM_callocN(sizeof(ColormanageProcessor), "colormanagement processor");
-
-	color_space = colormanage_colorspace_get_named(to_colorspace);
-	cm_processor->is_data_result = color_space->is_data;
-
-	cm_processor->processor = create_colorspace_transform_processor(from_colorspace, to_colorspace);
-
-	return cm_processor;
+	return colorspace_processor_acquire(from_colorspace, to_colorspace);
 }
 
 void IMB_colormanagement_processor_apply_v4(ColormanageProcessor *cm_processor, float pixel[4])
@@ -3363,7 +3678,11 @@ void IMB_colormanagement_processor_apply(ColormanageProcessor *cm_processor, flo
 		}
 	}
 
-	if (cm_processor->processor && channels >= 3) {
+	if (cm_processor->lut && channels >= 3) {
+		/* apply baked display transform */
+		colormanage_processor_lut_apply(cm_processor, buffer, ((size_t)width) * height, channels, predivide);
+	}
+	else if (cm_processor->processor && channels >= 3) {
 		OCIO_PackedImageDesc *img;
 
 		/* apply OCIO processor */
@@ -3402,12 +3721,16 @@ void IMB_colormanagement_processor_apply_byte(ColormanageProcessor *cm_processor
 
 void IMB_colormanagement_processor_free(ColormanageProcessor *cm_processor)
 {
-	if (cm_processor->curve_mapping)
-		curvemapping_free(cm_processor->curve_mapping);
-	if (cm_processor->processor)
-		OCIO_processorRelease(cm_processor->processor);
+	if (cm_processor->cache_item) {
+		/* shared processor, stays in the cache */
+		BLI_mutex_lock(&processor_lock);
+		BLI_assert(cm_processor->cache_item->users > 0);
+		cm_processor->cache_item->users--;
+		BLI_mutex_unlock(&processor_lock);
+		return;
+	}
 
-	MEM_freeN(cm_processor);
+	colormanage_processor_free_data(cm_processor);
 }
 
 /* **** OpenGL drawing routines using GLSL for color space transform ***** */
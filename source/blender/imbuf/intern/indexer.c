@@ -1311,8 +1311,9 @@ struct anim *IMB_anim_open_proxy(
 
 	get_proxy_filename(anim, preview_size, fname, false);
 
-	/* proxies are generated in the same color space as animation itself */
-	anim->proxy_anim[i] = IMB_open_anim(fname, 0, 0, anim->colorspace);
+	/* proxies are generated in the same color space as animation itself,
+	 * and are played back the same way */
+	anim->proxy_anim[i] = IMB_open_anim(fname, anim->ib_flags & IB_animdecodeahead, 0, anim->colorspace);
 
 	anim->proxies_tried |= preview_size;
 
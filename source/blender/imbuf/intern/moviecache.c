@@ -194,7 +194,7 @@ static void IMB_moviecache_destructor(void *p)
 }
 
 /* approximate size of ImBuf in memory */
-static size_t IMB_get_size_in_memory(ImBuf *ibuf)
+size_t IMB_get_size_in_memory(ImBuf *ibuf)
 {
 	int a;
 	size_t size = 0, channel_size = 0;
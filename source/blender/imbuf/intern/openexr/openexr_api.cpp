@@ -62,6 +62,7 @@
 #include <ImfOutputPart.h>
 #include <ImfMultiPartOutputFile.h>
 #include <ImfTiledOutputPart.h>
+#include <ImfTiledInputPart.h>
 #include <ImfPartType.h>
 #include <ImfPartHelper.h>
 
@@ -87,6 +88,7 @@ _CRTIMP void __cdecl _invalid_parameter_noinfo(void)
 
 #include "BLI_blenlib.h"
 #include "BLI_math_color.h"
+#include "BLI_math_vector.h"
 #include "BLI_threads.h"
 
 #include "BKE_idprop.h"
@@ -95,6 +97,7 @@ _CRTIMP void __cdecl _invalid_parameter_noinfo(void)
 #include "IMB_imbuf_types.h"
 #include "IMB_imbuf.h"
 #include "IMB_allocimbuf.h"
+#include "IMB_filetype.h"
 #include "IMB_metadata.h"
 
 #include "openexr_multi.h"
@@ -818,9 +821,10 @@ int IMB_exr_begin_write(void *handle, const char *filename, int width, int heigh
 	return (data->ofile != NULL);
 }
 
-/* only used for writing temp. render results (not image files)
- * (FSA and Save Buffers) */
-void IMB_exrtile_begin_write(void *handle, const char *filename, int mipmap, int width, int height, int tilex, int tiley)
+/* used for writing temp. render results (FSA and Save Buffers), and for
+ * multilayer output files written tile by tile while rendering */
+int IMB_exrtile_begin_write(void *handle, const char *filename, int mipmap, int width, int height, int tilex, int tiley,
+                            int compress, const StampData *stamp)
 {
 	ExrHandle *data = (ExrHandle *)handle;
 	Header header(width, height);
@@ -834,7 +838,8 @@ void IMB_exrtile_begin_write(void *handle, const char *filename, int mipmap, int
 	data->mipmap = mipmap;
 
 	header.setTileDescription(TileDescription(tilex, tiley, (mipmap) ? MIPMAP_LEVELS : ONE_LEVEL));
-	header.compression() = RLE_COMPRESSION;
+	openexr_header_compression(&header, compress);
+	BKE_stamp_info_callback(&header, const_cast<StampData *>(stamp), openexr_header_metadata_callback, false);
 	header.setType(TILEDIMAGE);
 
 	header.insert("BlenderMultiChannel", StringAttribute("Blender V2.43"));
@@ -855,13 +860,11 @@ void IMB_exrtile_begin_write(void *handle, const char *filename, int mipmap, int
 
 	/* assign channels  */
 	for (echan = (ExrChannel *)data->channels.first; echan; echan = echan->next) {
-		/* Tiles are expected to be saved with full float currently. */
-		BLI_assert(echan->use_half_float == 0);
-
 		echan->m->internal_name = echan->m->name;
 		echan->m->part_number = echan->view_id;
 
-		headers[echan->view_id].channels().insert(echan->m->internal_name, Channel(Imf::FLOAT));
+		headers[echan->view_id].channels().insert(echan->m->internal_name,
+		                                          Channel(echan->use_half_float ? Imf::HALF : Imf::FLOAT));
 		exr_printf("%d %-6s %-22s \"%s\"\n", echan->m->part_number, echan->m->view.c_str(), echan->m->name.c_str(), echan->m->internal_name.c_str());
 	}
 
@@ -878,6 +881,8 @@ void IMB_exrtile_begin_write(void *handle, const char *filename, int mipmap, int
 		data->mpofile = NULL;
 		data->ofile_stream = NULL;
 	}
+
+	return (data->mpofile != NULL);
 }
 
 /* read from file */
@@ -1057,15 +1062,23 @@ void IMB_exr_write_channels(void *handle)
 	}
 }
 
-/* temporary function, used for FSA and Save Buffers */
-/* called once per tile * view */
-void IMB_exrtile_write_channels(void *handle, int partx, int party, int level, const char *viewname, bool empty)
+/* used for FSA, Save Buffers and multilayer output written while rendering */
+/* called once per render tile * view, the render tile covers one or more
+ * tiles of the file, which are compressed in parallel by OpenEXR */
+void IMB_exrtile_write_channels(void *handle, int partx, int party, int partw, int parth,
+                                int level, const char *viewname, bool empty)
 {
 	/* Can write empty channels for incomplete renders. */
 	ExrHandle *data = (ExrHandle *)handle;
 	FrameBuffer frameBuffer;
 	std::string view(viewname);
 	const int view_id = imb_exr_get_multiView_id(*data->multiView, view);
+	const size_t num_pixels = ((size_t)partw) * parth;
+	half *rect_half = NULL, *current_rect_half = NULL;
+
+	if (data->mpofile == NULL) {
+		return;
+	}
 
 	exr_printf("\nIMB_exrtile_write_channels(view: %s)\n", viewname);
 	exr_printf("%s %-6s %-22s \"%s\"\n", "p", "view", "name", "internal_name");
@@ -1074,6 +1087,11 @@ void IMB_exrtile_write_channels(void *handle, int partx, int party, int level, c
 	if (!empty) {
 		ExrChannel *echan;
 
+		if (data->num_half_channels != 0) {
+			rect_half = (half *)MEM_mallocN(sizeof(half) * data->num_half_channels * num_pixels, __func__);
+			current_rect_half = rect_half;
+		}
+
 		for (echan = (ExrChannel *)data->channels.first; echan; echan = echan->next) {
 
 			/* eventually we can make the parts' channels to include
@@ -1088,14 +1106,35 @@ void IMB_exrtile_write_channels(void *handle, int partx, int party, int level, c
 			           echan->m->internal_name.c_str()
 			           );
 
-			float *rect = echan->rect - echan->xstride * partx - echan->ystride * party;
-			frameBuffer.insert(echan->m->internal_name,
-			                   Slice(Imf::FLOAT,
-			                         (char *)rect,
-			                         echan->xstride * sizeof(float),
-			                         echan->ystride * sizeof(float)
-			                        )
-			);
+			if (echan->use_half_float) {
+				half *cur = current_rect_half;
+				for (int y = 0; y < parth; y++) {
+					const float *rect = echan->rect + (size_t)echan->ystride * y;
+					for (int x = 0; x < partw; x++, cur++) {
+						*cur = rect[(size_t)echan->xstride * x];
+					}
+				}
+
+				half *rect = current_rect_half - partx - (ptrdiff_t)partw * party;
+				frameBuffer.insert(echan->m->internal_name,
+				                   Slice(Imf::HALF,
+				                         (char *)rect,
+				                         sizeof(half),
+				                         partw * sizeof(half)
+				                        )
+				);
+				current_rect_half += num_pixels;
+			}
+			else {
+				float *rect = echan->rect - echan->xstride * partx - echan->ystride * party;
+				frameBuffer.insert(echan->m->internal_name,
+				                   Slice(Imf::FLOAT,
+				                         (char *)rect,
+				                         echan->xstride * sizeof(float),
+				                         echan->ystride * sizeof(float)
+				                        )
+				);
+			}
 		}
 	}
 
@@ -1103,12 +1142,19 @@ void IMB_exrtile_write_channels(void *handle, int partx, int party, int level, c
 	out.setFrameBuffer(frameBuffer);
 
 	try {
-		// printf("write tile %d %d\n", partx/data->tilex, party/data->tiley);
-		out.writeTile(partx / data->tilex, party / data->tiley, level);
+		const int dx1 = partx / data->tilex, dx2 = (partx + partw - 1) / data->tilex;
+		const int dy1 = party / data->tiley, dy2 = (party + parth - 1) / data->tiley;
+
+		// printf("write tiles %d %d - %d %d\n", dx1, dy1, dx2, dy2);
+		out.writeTiles(dx1, dx2, dy1, dy2, level);
 	}
 	catch (const std::exception& exc) {
 		std::cerr << "OpenEXR-writeTile: ERROR: " << exc.what() << std::endl;
 	}
+
+	if (rect_half != NULL) {
+		MEM_freeN(rect_half);
+	}
 }
 
 void IMB_exr_read_channels(void *handle)
@@ -1162,6 +1208,11 @@ void IMB_exr_read_channels(void *handle)
 				printf("warning, channel with no rect set %s\n", echan->m->internal_name.c_str());
 		}
 
+		/* Parts can be skipped when only some passes are read. */
+		if (frameBuffer.begin() == frameBuffer.end()) {
+			continue;
+		}
+
 		/* Read pixels. */
 		try {
 			in.setFrameBuffer(frameBuffer);
@@ -1397,13 +1448,51 @@ static ExrPass *imb_exr_get_pass(ListBase *lb, char *passname)
 	return pass;
 }
 
-/* creates channels, makes a hierarchy and assigns memory to channels */
-static ExrHandle *imb_exr_begin_read_mem(IStream &file_stream, MultiPartInputFile &file, int width, int height)
+static bool imb_exr_pass_match(const ExrLayer *lay, const ExrPass *pass, const ImBufLoadOptions *options)
+{
+	return ((options->layer == NULL || STREQ(lay->name, options->layer)) &&
+	        (options->pass == NULL || STREQ(pass->internal_name, options->pass)) &&
+	        (options->view == NULL || STREQ(pass->view, options->view)));
+}
+
+/* removes the layers, passes and their channels that were not asked for */
+static void imb_exr_filter_passes(ExrHandle *data, const ImBufLoadOptions *options)
+{
+	ExrLayer *lay, *lay_next;
+	ExrPass *pass, *pass_next;
+
+	for (lay = (ExrLayer *)data->layers.first; lay; lay = lay_next) {
+		lay_next = lay->next;
+
+		for (pass = (ExrPass *)lay->passes.first; pass; pass = pass_next) {
+			pass_next = pass->next;
+
+			if (!imb_exr_pass_match(lay, pass, options)) {
+				for (int a = 0; a < pass->totchan; a++) {
+					ExrChannel *echan = pass->chan[a];
+					delete echan->m;
+					BLI_freelinkN(&data->channels, echan);
+				}
+				BLI_freelinkN(&lay->passes, pass);
+			}
+		}
+
+		if (BLI_listbase_is_empty(&lay->passes)) {
+			BLI_freelinkN(&data->layers, lay);
+		}
+	}
+}
+
+/* creates channels, makes a hierarchy and assigns memory to channels,
+ * optionally only for some passes or without memory, see ImBufLoadOptions */
+static ExrHandle *imb_exr_begin_read_mem(IStream &file_stream, MultiPartInputFile &file, int width, int height,
+                                         const ImBufLoadOptions *options)
 {
 	ExrLayer *lay;
 	ExrPass *pass;
 	ExrChannel *echan;
 	ExrHandle *data = (ExrHandle *)IMB_exr_get_handle();
+	const bool layout_only = (options && (options->flag & IMB_LOAD_LAYOUT_ONLY));
 	int a;
 	char layname[EXR_TOT_MAXNAME], passname[EXR_TOT_MAXNAME];
 
@@ -1463,11 +1552,17 @@ static ExrHandle *imb_exr_begin_read_mem(IStream &file_stream, MultiPartInputFil
 		return NULL;
 	}
 
+	if (options && (options->layer || options->pass || options->view)) {
+		imb_exr_filter_passes(data, options);
+	}
+
 	/* with some heuristics, try to merge the channels in buffers */
 	for (lay = (ExrLayer *)data->layers.first; lay; lay = lay->next) {
 		for (pass = (ExrPass *)lay->passes.first; pass; pass = pass->next) {
 			if (pass->totchan) {
-				pass->rect = (float *)MEM_mapallocN(width * height * pass->totchan * sizeof(float), "pass rect");
+				if (!layout_only) {
+					pass->rect = (float *)MEM_mapallocN(width * height * pass->totchan * sizeof(float), "pass rect");
+				}
 				if (pass->totchan == 1) {
 					echan = pass->chan[0];
 					echan->rect = pass->rect;
@@ -1501,7 +1596,7 @@ static ExrHandle *imb_exr_begin_read_mem(IStream &file_stream, MultiPartInputFil
 						}
 						for (a = 0; a < pass->totchan; a++) {
 							echan = pass->chan[a];
-							echan->rect = pass->rect + lookup[(unsigned int)echan->chan_id];
+							echan->rect = (pass->rect) ? pass->rect + lookup[(unsigned int)echan->chan_id] : NULL;
 							echan->xstride = pass->totchan;
 							echan->ystride = width * pass->totchan;
 							pass->chan_id[(unsigned int)lookup[(unsigned int)echan->chan_id]] = echan->chan_id;
@@ -1510,7 +1605,7 @@ static ExrHandle *imb_exr_begin_read_mem(IStream &file_stream, MultiPartInputFil
 					else { /* unknown */
 						for (a = 0; a < pass->totchan; a++) {
 							echan = pass->chan[a];
-							echan->rect = pass->rect + a;
+							echan->rect = (pass->rect) ? pass->rect + a : NULL;
 							echan->xstride = pass->totchan;
 							echan->ystride = width * pass->totchan;
 							pass->chan_id[a] = echan->chan_id;
@@ -1739,7 +1834,161 @@ bool IMB_exr_has_multilayer(void *handle)
 	return imb_exr_is_multi(*data->ifile);
 }
 
-struct ImBuf *imb_load_openexr(const unsigned char *mem, size_t size, int flags, char colorspace[IM_MAX_SPACE])
+/* Insert RGBA slices for the first pixel at first, luma files are read as Y, BY, RY */
+static void exr_rgba_framebuffer(MultiPartInputFile& file, FrameBuffer& frameBuffer, float *first,
+                                 size_t xstride, size_t ystride, bool has_rgb, bool has_luma)
+{
+	if (has_rgb) {
+		frameBuffer.insert(exr_rgba_channelname(file, "R"),
+		                   Slice(Imf::FLOAT,  (char *) first, xstride, ystride));
+		frameBuffer.insert(exr_rgba_channelname(file, "G"),
+		                   Slice(Imf::FLOAT,  (char *) (first + 1), xstride, ystride));
+		frameBuffer.insert(exr_rgba_channelname(file, "B"),
+		                   Slice(Imf::FLOAT,  (char *) (first + 2), xstride, ystride));
+	}
+	else if (has_luma) {
+		frameBuffer.insert(exr_rgba_channelname(file, "Y"),
+		                   Slice(Imf::FLOAT,  (char *) first, xstride, ystride));
+		frameBuffer.insert(exr_rgba_channelname(file, "BY"),
+		                   Slice(Imf::FLOAT,  (char *) (first + 1), xstride, ystride, 1, 1, 0.5f));
+		frameBuffer.insert(exr_rgba_channelname(file, "RY"),
+		                   Slice(Imf::FLOAT,  (char *) (first + 2), xstride, ystride, 1, 1, 0.5f));
+	}
+
+	/* 1.0 is fill value, this still needs to be assigned even when (is_alpha == 0) */
+	frameBuffer.insert(exr_rgba_channelname(file, "A"),
+	                   Slice(Imf::FLOAT,  (char *) (first + 3), xstride, ystride, 1, 1, 1.0f));
+}
+
+/* Read the RGBA region of a mipmap level into ibuf, only the tiles covering it are
+ * read. Returns false when the file has no such level. */
+static bool exr_read_rgba_mipmap_region(MultiPartInputFile& file, ImBuf *ibuf, int level, const int region[4],
+                                        bool has_rgb, bool has_luma)
+{
+	const Header& header = file.header(0);
+
+	if (!header.hasTileDescription() || header.tileDescription().mode == ONE_LEVEL) {
+		return false;
+	}
+
+	TiledInputPart in(file, 0);
+	const Box2i dw = header.dataWindow();
+	const int width = dw.max.x - dw.min.x + 1, height = dw.max.y - dw.min.y + 1;
+	const bool is_ripmap = (header.tileDescription().mode == RIPMAP_LEVELS);
+
+	if (level >= in.numXLevels() || level >= in.numYLevels() ||
+	    in.levelWidth(level) != std::max(width >> level, 1) ||
+	    in.levelHeight(level) != std::max(height >> level, 1))
+	{
+		return false;
+	}
+
+	/* region in top-down pixels of the level, and the tiles covering it */
+	const int level_height = in.levelHeight(level);
+	const int x1 = region[0], x2 = region[2] - 1;
+	const int y1 = level_height - region[3], y2 = level_height - region[1] - 1;
+	const int tile_x = in.tileXSize(), tile_y = in.tileYSize();
+	const int bx1 = (x1 / tile_x) * tile_x, by1 = (y1 / tile_y) * tile_y;
+	const int bx2 = std::min((x2 / tile_x + 1) * tile_x, in.levelWidth(level)) - 1;
+	const int by2 = std::min((y2 / tile_y + 1) * tile_y, level_height) - 1;
+	const size_t buffer_width = bx2 - bx1 + 1;
+	float *buffer = (float *)MEM_mapallocN(sizeof(float) * 4 * buffer_width * (by2 - by1 + 1), __func__);
+	bool ok = true;
+
+	try {
+		FrameBuffer frameBuffer;
+		/* tiles of a level are in data window coordinates too */
+		float *first = buffer - 4 * ((ptrdiff_t)(dw.min.x + bx1) + (ptrdiff_t)(dw.min.y + by1) * buffer_width);
+
+		exr_rgba_framebuffer(file, frameBuffer, first, sizeof(float) * 4, sizeof(float) * 4 * buffer_width,
+		                     has_rgb, has_luma);
+		in.setFrameBuffer(frameBuffer);
+
+		if (is_ripmap) {
+			in.readTiles(bx1 / tile_x, bx2 / tile_x, by1 / tile_y, by2 / tile_y, level, level);
+		}
+		else {
+			in.readTiles(bx1 / tile_x, bx2 / tile_x, by1 / tile_y, by2 / tile_y, level);
+		}
+
+		/* flip to Blender convention while copying the region */
+		for (int y = 0; y < ibuf->y; y++) {
+			const float *src = buffer + 4 * ((size_t)(y2 - y - by1) * buffer_width + (x1 - bx1));
+			memcpy(ibuf->rect_float + 4 * (size_t)y * ibuf->x, src, sizeof(float) * 4 * ibuf->x);
+		}
+	}
+	catch (const std::exception& exc) {
+		std::cerr << "OpenEXR-readTiles: ERROR: " << exc.what() << std::endl;
+		ok = false;
+	}
+
+	MEM_freeN(buffer);
+
+	return ok;
+}
+
+/* Read the RGBA region of a level into ibuf, from bands of full resolution scanlines
+ * which are averaged down, so only one band and the result are in memory. */
+static void exr_read_rgba_scanline_region(MultiPartInputFile& file, ImBuf *ibuf, int level, const int region[4],
+                                          bool has_rgb, bool has_luma)
+{
+	InputPart in(file, 0);
+	const Box2i dw = file.header(0).dataWindow();
+	const int width = dw.max.x - dw.min.x + 1, height = dw.max.y - dw.min.y + 1;
+	const int step = 1 << level;
+	const int level_height = std::max(height >> level, 1);
+	/* first level row to read, top-down */
+	const int ly1 = level_height - region[3];
+	const int y1 = ly1 * step, y2 = std::min((ly1 + ibuf->y) * step, height);
+	/* a band is a whole number of level rows, and enough scanlines to not read too often */
+	const int band_height = std::max(step, (64 / step) * step);
+	float *band = (float *)MEM_mapallocN(sizeof(float) * 4 * (size_t)width * band_height, __func__);
+
+	for (int y = y1; y < y2; y += band_height) {
+		const int rows = std::min(band_height, y2 - y);
+
+		try {
+			FrameBuffer frameBuffer;
+			float *first = band - 4 * ((ptrdiff_t)dw.min.x + (ptrdiff_t)(dw.min.y + y) * width);
+
+			exr_rgba_framebuffer(file, frameBuffer, first, sizeof(float) * 4, sizeof(float) * 4 * width,
+			                     has_rgb, has_luma);
+			in.setFrameBuffer(frameBuffer);
+			in.readPixels(dw.min.y + y, dw.min.y + y + rows - 1);
+		}
+		catch (const std::exception& exc) {
+			std::cerr << "OpenEXR-readPixels: ERROR: " << exc.what() << std::endl;
+			break;
+		}
+
+		/* average blocks of step x step pixels, fewer at the right and bottom edge */
+		for (int by = 0; by < rows; by += step) {
+			const int level_row = (y + by) / step - ly1;
+			const int ny = std::min(step, rows - by);
+			float *out = ibuf->rect_float + 4 * (size_t)(ibuf->y - 1 - level_row) * ibuf->x;
+
+			for (int x = 0; x < ibuf->x; x++, out += 4) {
+				const int sx = (region[0] + x) * step;
+				const int nx = std::min(step, width - sx);
+				float sum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+				for (int j = 0; j < ny; j++) {
+					const float *src = band + 4 * ((size_t)(by + j) * width + sx);
+					for (int i = 0; i < nx; i++, src += 4) {
+						add_v4_v4(sum, src);
+					}
+				}
+
+				mul_v4_v4fl(out, sum, 1.0f / (nx * ny));
+			}
+		}
+	}
+
+	MEM_freeN(band);
+}
+
+struct ImBuf *imb_load_openexr_ex(const unsigned char *mem, size_t size, int flags, char colorspace[IM_MAX_SPACE],
+                                  ImBufLoadOptions *options)
 {
 	struct ImBuf *ibuf = NULL;
 	Mem_IStream *membuf = NULL;
@@ -1774,11 +2023,23 @@ struct ImBuf *imb_load_openexr(const unsigned char *mem, size_t size, int flags,
 		}
 		else {
 			const int is_alpha = exr_has_alpha(*file);
+			const bool read_rgba = !is_multi || (flags & IB_thumbnail);
+			int level = 0, region[4] = {0, 0, width, height};
 
-			ibuf = IMB_allocImBuf(width, height, is_alpha ? 32 : 24, 0);
+			if (options) {
+				options->full_x = width;
+				options->full_y = height;
+
+				if (read_rgba && !(flags & IB_test)) {
+					level = imb_load_options_level(options, width, height);
+					imb_load_options_region(options, width, height, level, region);
+				}
+			}
+
+			ibuf = IMB_allocImBuf(region[2] - region[0], region[3] - region[1], is_alpha ? 32 : 24, 0);
 
 			if (hasXDensity(file->header(0))) {
-				ibuf->ppm[0] = xDensity(file->header(0)) * 39.3700787f;
+				ibuf->ppm[0] = xDensity(file->header(0)) * 39.3700787f / (1 << level);
 				ibuf->ppm[1] = ibuf->ppm[0] * (double)file->header(0).pixelAspectRatio();
 			}
 
@@ -1802,63 +2063,55 @@ struct ImBuf *imb_load_openexr(const unsigned char *mem, size_t size, int flags,
 					}
 				}
 
-				if (is_multi && ((flags & IB_thumbnail) == 0)) { /* only enters with IB_multilayer flag set */
+				if (!read_rgba) { /* only enters with IB_multilayer flag set */
 					/* constructs channels for reading, allocates memory in channels */
-					ExrHandle *handle = imb_exr_begin_read_mem(*membuf, *file, width, height);
+					ExrHandle *handle = imb_exr_begin_read_mem(*membuf, *file, width, height, options);
 					if (handle) {
-						IMB_exr_read_channels(handle);
+						if (!(options && (options->flag & IMB_LOAD_LAYOUT_ONLY))) {
+							IMB_exr_read_channels(handle);
+						}
 						ibuf->userdata = handle;         /* potential danger, the caller has to check for this! */
 					}
 				}
 				else {
 					const bool has_rgb = exr_has_rgb(*file);
 					const bool has_luma = exr_has_luma(*file);
-					FrameBuffer frameBuffer;
-					float *first;
-					int xstride = sizeof(float) * 4;
-					int ystride = -xstride * width;
 
 					imb_addrectfloatImBuf(ibuf);
 
-					/* inverse correct first pixel for datawindow coordinates (- dw.min.y because of y flip) */
-					first = ibuf->rect_float - 4 * (dw.min.x - dw.min.y * width);
-					/* but, since we read y-flipped (negative y stride) we move to last scanline */
-					first += 4 * (height - 1) * width;
-
-					if (has_rgb) {
-						frameBuffer.insert(exr_rgba_channelname(*file, "R"),
-						                   Slice(Imf::FLOAT,  (char *) first, xstride, ystride));
-						frameBuffer.insert(exr_rgba_channelname(*file, "G"),
-						                   Slice(Imf::FLOAT,  (char *) (first + 1), xstride, ystride));
-						frameBuffer.insert(exr_rgba_channelname(*file, "B"),
-						                   Slice(Imf::FLOAT,  (char *) (first + 2), xstride, ystride));
-					}
-					else if (has_luma) {
-						frameBuffer.insert(exr_rgba_channelname(*file, "Y"),
-						                   Slice(Imf::FLOAT,  (char *) first, xstride, ystride));
-						frameBuffer.insert(exr_rgba_channelname(*file, "BY"),
-						                   Slice(Imf::FLOAT,  (char *) (first + 1), xstride, ystride, 1, 1, 0.5f));
-						frameBuffer.insert(exr_rgba_channelname(*file, "RY"),
-						                   Slice(Imf::FLOAT,  (char *) (first + 2), xstride, ystride, 1, 1, 0.5f));
+					if (ibuf->x != width || ibuf->y != height) {
+						/* part of the image or a lower resolution, without depth */
+						if (level == 0 || !exr_read_rgba_mipmap_region(*file, ibuf, level, region, has_rgb, has_luma)) {
+							exr_read_rgba_scanline_region(*file, ibuf, level, region, has_rgb, has_luma);
+						}
 					}
+					else {
+						FrameBuffer frameBuffer;
+						float *first;
+						int xstride = sizeof(float) * 4;
+						int ystride = -xstride * width;
+
+						/* inverse correct first pixel for datawindow coordinates (- dw.min.y because of y flip) */
+						first = ibuf->rect_float - 4 * (dw.min.x - dw.min.y * width);
+						/* but, since we read y-flipped (negative y stride) we move to last scanline */
+						first += 4 * (height - 1) * width;
+
+						exr_rgba_framebuffer(*file, frameBuffer, first, xstride, ystride, has_rgb, has_luma);
+
+						if (exr_has_zbuffer(*file)) {
+							float *firstz;
+
+							addzbuffloatImBuf(ibuf);
+							firstz = ibuf->zbuf_float - (dw.min.x - dw.min.y * width);
+							firstz += (height - 1) * width;
+							frameBuffer.insert("Z", Slice(Imf::FLOAT,  (char *)firstz, sizeof(float), -width * sizeof(float)));
+						}
 
-					/* 1.0 is fill value, this still needs to be assigned even when (is_alpha == 0) */
-					frameBuffer.insert(exr_rgba_channelname(*file, "A"),
-					                   Slice(Imf::FLOAT,  (char *) (first + 3), xstride, ystride, 1, 1, 1.0f));
-
-					if (exr_has_zbuffer(*file)) {
-						float *firstz;
-
-						addzbuffloatImBuf(ibuf);
-						firstz = ibuf->zbuf_float - (dw.min.x - dw.min.y * width);
-						firstz += (height - 1) * width;
-						frameBuffer.insert("Z", Slice(Imf::FLOAT,  (char *)firstz, sizeof(float), -width * sizeof(float)));
+						InputPart in (*file, 0);
+						in.setFrameBuffer(frameBuffer);
+						in.readPixels(dw.min.y, dw.max.y);
 					}
 
-					InputPart in (*file, 0);
-					in.setFrameBuffer(frameBuffer);
-					in.readPixels(dw.min.y, dw.max.y);
-
 					// XXX, ImBuf has no nice way to deal with this.
 					// ideally IM_rect would be used when the caller wants a rect BUT
 					// at the moment all functions use IM_rect.
@@ -1914,6 +2167,11 @@ struct ImBuf *imb_load_openexr(const unsigned char *mem, size_t size, int flags,
 
 }
 
+struct ImBuf *imb_load_openexr(const unsigned char *mem, size_t size, int flags, char colorspace[IM_MAX_SPACE])
+{
+	return imb_load_openexr_ex(mem, size, flags, colorspace, NULL);
+}
+
 void imb_initopenexr(void)
 {
 	int num_threads = BLI_system_thread_count();
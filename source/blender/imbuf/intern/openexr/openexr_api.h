@@ -47,6 +47,8 @@ int		imb_is_a_openexr			(const unsigned char *mem);
 int		imb_save_openexr			(struct ImBuf *ibuf, const char *name, int flags);
 
 struct ImBuf *imb_load_openexr		(const unsigned char *mem, size_t size, int flags, char *colorspace);
+struct ImBuf *imb_load_openexr_ex	(const unsigned char *mem, size_t size, int flags, char *colorspace,
+                                	 struct ImBufLoadOptions *options);
 
 #ifdef __cplusplus
 }
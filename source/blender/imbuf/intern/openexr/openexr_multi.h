@@ -60,14 +60,14 @@ void  IMB_exr_add_channel(void *handle,
 
 int     IMB_exr_begin_read(void *handle, const char *filename, int *width, int *height);
 int     IMB_exr_begin_write(void *handle, const char *filename, int width, int height, int compress, const struct StampData *stamp);
-void    IMB_exrtile_begin_write(void *handle, const char *filename, int mipmap, int width, int height, int tilex, int tiley);
+int     IMB_exrtile_begin_write(void *handle, const char *filename, int mipmap, int width, int height, int tilex, int tiley, int compress, const struct StampData *stamp);
 
 void    IMB_exr_set_channel(void *handle, const char *layname, const char *passname, int xstride, int ystride, float *rect);
 float  *IMB_exr_channel_rect(void *handle, const char *layname, const char *passname, const char *view);
 
 void    IMB_exr_read_channels(void *handle);
 void    IMB_exr_write_channels(void *handle);
-void    IMB_exrtile_write_channels(void *handle, int partx, int party, int level, const char *viewname, bool empty);
+void    IMB_exrtile_write_channels(void *handle, int partx, int party, int partw, int parth, int level, const char *viewname, bool empty);
 void    IMB_exr_clear_channels(void *handle);
 
 void    IMB_exr_multilayer_convert(
@@ -40,7 +40,12 @@
 #endif
 
 #include <stdlib.h>
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
 #include "BLI_utildefines.h"
+#include "BLI_math_base.h"
 #include "BLI_string.h"
 #include "BLI_path_util.h"
 #include "BLI_fileops.h"
@@ -101,7 +106,134 @@ static void imb_handle_alpha(ImBuf *ibuf, int flags, char colorspace[IM_MAX_SPAC
 	colormanage_imbuf_make_linear(ibuf, effective_colorspace);
 }
 
-ImBuf *IMB_ibImageFromMemory(unsigned char *mem, size_t size, int flags, char colorspace[IM_MAX_SPACE], const char *descr)
+int imb_load_options_level(const ImBufLoadOptions *options, int width, int height)
+{
+	int level = clamp_i(options->level, 0, 30);
+
+	if (options->fit_size > 0) {
+		const int size = max_ii(width, height);
+
+		while (level < 30 && (size >> (level + 1)) >= options->fit_size) {
+			level++;
+		}
+	}
+
+	return level;
+}
+
+/* Region to load in pixels of the level, xmin, ymin, xmax, ymax with max exclusive. */
+void imb_load_options_region(const ImBufLoadOptions *options, int width, int height, int level, int r_region[4])
+{
+	const int level_x = max_ii(width >> level, 1);
+	const int level_y = max_ii(height >> level, 1);
+
+	if (options->flag & IMB_LOAD_ROI) {
+		const int round = (1 << level) - 1;
+
+		r_region[0] = clamp_i(options->roi_xmin >> level, 0, level_x - 1);
+		r_region[1] = clamp_i(options->roi_ymin >> level, 0, level_y - 1);
+		r_region[2] = clamp_i((options->roi_xmax + round) >> level, r_region[0] + 1, level_x);
+		r_region[3] = clamp_i((options->roi_ymax + round) >> level, r_region[1] + 1, level_y);
+	}
+	else {
+		r_region[0] = 0;
+		r_region[1] = 0;
+		r_region[2] = level_x;
+		r_region[3] = level_y;
+	}
+}
+
+/* Crop the full image for formats which can only decode everything. */
+static void imb_load_options_crop(ImBuf *ibuf, int x, int y, int w, int h)
+{
+	int i;
+
+	if (ibuf->rect) {
+		unsigned int *rect = MEM_mapallocN(sizeof(unsigned int) * (size_t)w * h, __func__);
+
+		for (i = 0; i < h; i++) {
+			memcpy(rect + (size_t)i * w, ibuf->rect + (size_t)(y + i) * ibuf->x + x, sizeof(unsigned int) * w);
+		}
+
+		imb_freerectImBuf(ibuf);
+		ibuf->rect = rect;
+		ibuf->mall |= IB_rect;
+	}
+
+	if (ibuf->rect_float) {
+		const int channels = ibuf->channels;
+		float *rect_float = MEM_mapallocN(sizeof(float) * channels * (size_t)w * h, __func__);
+
+		for (i = 0; i < h; i++) {
+			memcpy(rect_float + (size_t)i * w * channels,
+			       ibuf->rect_float + ((size_t)(y + i) * ibuf->x + x) * channels,
+			       sizeof(float) * channels * w);
+		}
+
+		imb_freerectfloatImBuf(ibuf);
+		ibuf->rect_float = rect_float;
+		ibuf->channels = channels;
+		ibuf->mall |= IB_rectfloat;
+	}
+
+	IMB_freezbufImBuf(ibuf);
+	IMB_freezbuffloatImBuf(ibuf);
+
+	ibuf->x = w;
+	ibuf->y = h;
+}
+
+static void imb_load_options_apply(ImBuf *ibuf, ImBufLoadOptions *options)
+{
+	int level, region[4];
+
+	options->full_x = ibuf->x;
+	options->full_y = ibuf->y;
+
+	/* multilayer images are returned as layers in userdata */
+	if (ibuf->userdata || (ibuf->rect == NULL && ibuf->rect_float == NULL)) {
+		return;
+	}
+
+	level = imb_load_options_level(options, ibuf->x, ibuf->y);
+	imb_load_options_region(options, ibuf->x, ibuf->y, level, region);
+
+	if (options->flag & IMB_LOAD_ROI) {
+		const int xmin = region[0] << level, ymin = region[1] << level;
+		const int xmax = min_ii(region[2] << level, ibuf->x), ymax = min_ii(region[3] << level, ibuf->y);
+
+		if (xmin != 0 || ymin != 0 || xmax != ibuf->x || ymax != ibuf->y) {
+			imb_load_options_crop(ibuf, xmin, ymin, xmax - xmin, ymax - ymin);
+		}
+	}
+
+	if (level != 0) {
+		IMB_scaleImBuf(ibuf, region[2] - region[0], region[3] - region[1]);
+	}
+}
+
+static ImBuf *imb_load_from_memory(
+        const ImFileType *type, const unsigned char *mem, size_t size, int flags, char colorspace[IM_MAX_SPACE],
+        ImBufLoadOptions *options)
+{
+	ImBuf *ibuf;
+
+	if (options && type->load_ex) {
+		return type->load_ex(mem, size, flags, colorspace, options);
+	}
+
+	ibuf = type->load(mem, size, flags, colorspace);
+
+	if (ibuf && options && (flags & IB_test) == 0) {
+		imb_load_options_apply(ibuf, options);
+	}
+
+	return ibuf;
+}
+
+ImBuf *IMB_ibImageFromMemory_ex(
+        unsigned char *mem, size_t size, int flags, char colorspace[IM_MAX_SPACE], const char *descr,
+        ImBufLoadOptions *options)
 {
 	ImBuf *ibuf;
 	const ImFileType *type;
@@ -117,7 +249,7 @@ ImBuf *IMB_ibImageFromMemory(unsigned char *mem, size_t size, int flags, char co
 
 	for (type = IMB_FILE_TYPES; type < IMB_FILE_TYPES_LAST; type++) {
 		if (type->load) {
-			ibuf = type->load(mem, size, flags, effective_colorspace);
+			ibuf = imb_load_from_memory(type, mem, size, flags, effective_colorspace, options);
 			if (ibuf) {
 				imb_handle_alpha(ibuf, flags, colorspace, effective_colorspace);
 				return ibuf;
@@ -131,7 +263,13 @@ ImBuf *IMB_ibImageFromMemory(unsigned char *mem, size_t size, int flags, char co
 	return NULL;
 }
 
-static ImBuf *IMB_ibImageFromFile(const char *filepath, int flags, char colorspace[IM_MAX_SPACE], const char *descr)
+ImBuf *IMB_ibImageFromMemory(unsigned char *mem, size_t size, int flags, char colorspace[IM_MAX_SPACE], const char *descr)
+{
+	return IMB_ibImageFromMemory_ex(mem, size, flags, colorspace, descr, NULL);
+}
+
+static ImBuf *IMB_ibImageFromFile(
+        const char *filepath, int flags, char colorspace[IM_MAX_SPACE], const char *descr, ImBufLoadOptions *options)
 {
 	ImBuf *ibuf;
 	const ImFileType *type;
@@ -144,6 +282,9 @@ static ImBuf *IMB_ibImageFromFile(const char *filepath, int flags, char colorspa
 		if (type->load_filepath) {
 			ibuf = type->load_filepath(filepath, flags, effective_colorspace);
 			if (ibuf) {
+				if (options && (flags & IB_test) == 0) {
+					imb_load_options_apply(ibuf, options);
+				}
 				imb_handle_alpha(ibuf, flags, colorspace, effective_colorspace);
 				return ibuf;
 			}
@@ -162,7 +303,9 @@ static bool imb_is_filepath_format(const char *filepath)
 	return BLI_path_extension_check_array(filepath, imb_ext_image_filepath_only);
 }
 
-ImBuf *IMB_loadifffile(int file, const char *filepath, int flags, char colorspace[IM_MAX_SPACE], const char *descr)
+static ImBuf *imb_loadifffile_ex(
+        int file, const char *filepath, int flags, char colorspace[IM_MAX_SPACE], const char *descr,
+        ImBufLoadOptions *options)
 {
 	ImBuf *ibuf;
 	unsigned char *mem;
@@ -171,7 +314,7 @@ ImBuf *IMB_loadifffile(int file, const char *filepath, int flags, char colorspac
 	if (file == -1) return NULL;
 
 	if (imb_is_filepath_format(filepath))
-		return IMB_ibImageFromFile(filepath, flags, colorspace, descr);
+		return IMB_ibImageFromFile(filepath, flags, colorspace, descr, options);
 
 	size = BLI_file_descriptor_size(file);
 
@@ -184,7 +327,7 @@ ImBuf *IMB_loadifffile(int file, const char *filepath, int flags, char colorspac
 		return NULL;
 	}
 
-	ibuf = IMB_ibImageFromMemory(mem, size, flags, colorspace, descr);
+	ibuf = IMB_ibImageFromMemory_ex(mem, size, flags, colorspace, descr, options);
 
 	imb_mmap_lock();
 	if (munmap(mem, size))
@@ -194,6 +337,11 @@ ImBuf *IMB_loadifffile(int file, const char *filepath, int flags, char colorspac
 	return ibuf;
 }
 
+ImBuf *IMB_loadifffile(int file, const char *filepath, int flags, char colorspace[IM_MAX_SPACE], const char *descr)
+{
+	return imb_loadifffile_ex(file, filepath, flags, colorspace, descr, NULL);
+}
+
 static void imb_cache_filename(char *filename, const char *name, int flags)
 {
 	/* read .tx instead if it exists and is not older */
@@ -209,7 +357,8 @@ static void imb_cache_filename(char *filename, const char *name, int flags)
 	BLI_strncpy(filename, name, IMB_FILENAME_SIZE);
 }
 
-ImBuf *IMB_loadiffname(const char *filepath, int flags, char colorspace[IM_MAX_SPACE])
+/* Load with options to only read part of the image, see #ImBufLoadOptions. */
+ImBuf *IMB_loadiffname_ex(const char *filepath, int flags, char colorspace[IM_MAX_SPACE], ImBufLoadOptions *options)
 {
 	ImBuf *ibuf;
 	int file, a;
@@ -223,7 +372,7 @@ ImBuf *IMB_loadiffname(const char *filepath, int flags, char colorspace[IM_MAX_S
 	if (file == -1)
 		return NULL;
 
-	ibuf = IMB_loadifffile(file, filepath, flags, colorspace, filepath_tx);
+	ibuf = imb_loadifffile_ex(file, filepath, flags, colorspace, filepath_tx, options);
 
 	if (ibuf) {
 		BLI_strncpy(ibuf->name, filepath, sizeof(ibuf->name));
@@ -237,6 +386,11 @@ ImBuf *IMB_loadiffname(const char *filepath, int flags, char colorspace[IM_MAX_S
 	return ibuf;
 }
 
+ImBuf *IMB_loadiffname(const char *filepath, int flags, char colorspace[IM_MAX_SPACE])
+{
+	return IMB_loadiffname_ex(filepath, flags, colorspace, NULL);
+}
+
 ImBuf *IMB_testiffname(const char *filepath, int flags)
 {
 	ImBuf *ibuf;
@@ -33,8 +33,11 @@
 
 
 #include "BLI_utildefines.h"
+#include "BLI_math_base.h"
 #include "BLI_math_color.h"
+#include "BLI_math_vector.h"
 #include "BLI_math_interp.h"
+#include "BLI_task.h"
 #include "MEM_guardedalloc.h"
 
 #include "imbuf.h"
@@ -334,14 +337,77 @@ MINLINE void premul_ushort_to_straight_uchar(unsigned char *result, const unsign
 	}
 }
 
+typedef struct OneHalfData {
+	struct ImBuf *ibuf1, *ibuf2;
+	bool do_rect, do_float;
+} OneHalfData;
+
+/* average 2x2 blocks of pixels for a row of ibuf2 */
+static void imb_onehalf_row(void *__restrict userdata, const int y, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	const OneHalfData *data = userdata;
+	struct ImBuf *ibuf1 = data->ibuf1, *ibuf2 = data->ibuf2;
+	int x;
+
+	if (data->do_rect) {
+		unsigned char *cp1, *cp2, *dest;
+
+		cp1 = (unsigned char *)ibuf1->rect + ((size_t)(2 * y) * ibuf1->x << 2);
+		cp2 = cp1 + (ibuf1->x << 2);
+		dest = (unsigned char *)ibuf2->rect + ((size_t)y * ibuf2->x << 2);
+
+		for (x = ibuf2->x; x > 0; x--) {
+			unsigned short p1i[8], p2i[8], desti[4];
+
+			straight_uchar_to_premul_ushort(p1i, cp1);
+			straight_uchar_to_premul_ushort(p2i, cp2);
+			straight_uchar_to_premul_ushort(p1i + 4, cp1 + 4);
+			straight_uchar_to_premul_ushort(p2i + 4, cp2 + 4);
+
+			desti[0] = ((unsigned int) p1i[0] + p2i[0] + p1i[4] + p2i[4]) >> 2;
+			desti[1] = ((unsigned int) p1i[1] + p2i[1] + p1i[5] + p2i[5]) >> 2;
+			desti[2] = ((unsigned int) p1i[2] + p2i[2] + p1i[6] + p2i[6]) >> 2;
+			desti[3] = ((unsigned int) p1i[3] + p2i[3] + p1i[7] + p2i[7]) >> 2;
+
+			premul_ushort_to_straight_uchar(dest, desti);
+
+			cp1 += 8;
+			cp2 += 8;
+			dest += 4;
+		}
+	}
+
+	if (data->do_float) {
+		float *p1f, *p2f, *destf;
+
+		p1f = ibuf1->rect_float + ((size_t)(2 * y) * ibuf1->x << 2);
+		p2f = p1f + (ibuf1->x << 2);
+		destf = ibuf2->rect_float + ((size_t)y * ibuf2->x << 2);
+
+		for (x = ibuf2->x; x > 0; x--) {
+			destf[0] = 0.25f * (p1f[0] + p2f[0] + p1f[4] + p2f[4]);
+			destf[1] = 0.25f * (p1f[1] + p2f[1] + p1f[5] + p2f[5]);
+			destf[2] = 0.25f * (p1f[2] + p2f[2] + p1f[6] + p2f[6]);
+			destf[3] = 0.25f * (p1f[3] + p2f[3] + p1f[7] + p2f[7]);
+			p1f += 8;
+			p2f += 8;
+			destf += 4;
+		}
+	}
+}
+
 /* result in ibuf2, scaling should be done correctly */
 void imb_onehalf_no_alloc(struct ImBuf *ibuf2, struct ImBuf *ibuf1)
 {
-	int x, y;
-	const short do_rect = (ibuf1->rect != NULL);
-	const short do_float = (ibuf1->rect_float != NULL) && (ibuf2->rect_float != NULL);
+	OneHalfData data;
+	ParallelRangeSettings settings;
+
+	data.ibuf1 = ibuf1;
+	data.ibuf2 = ibuf2;
+	data.do_rect = (ibuf1->rect != NULL);
+	data.do_float = (ibuf1->rect_float != NULL) && (ibuf2->rect_float != NULL);
 
-	if (do_rect && (ibuf2->rect == NULL)) {
+	if (data.do_rect && (ibuf2->rect == NULL)) {
 		imb_addrectImBuf(ibuf2);
 	}
 
@@ -354,58 +420,12 @@ void imb_onehalf_no_alloc(struct ImBuf *ibuf2, struct ImBuf *ibuf1)
 		return;
 	}
 
-	if (do_rect) {
-		unsigned char *cp1, *cp2, *dest;
-
-		cp1 = (unsigned char *) ibuf1->rect;
-		dest = (unsigned char *) ibuf2->rect;
-
-		for (y = ibuf2->y; y > 0; y--) {
-			cp2 = cp1 + (ibuf1->x << 2);
-			for (x = ibuf2->x; x > 0; x--) {
-				unsigned short p1i[8], p2i[8], desti[4];
-
-				straight_uchar_to_premul_ushort(p1i, cp1);
-				straight_uchar_to_premul_ushort(p2i, cp2);
-				straight_uchar_to_premul_ushort(p1i + 4, cp1 + 4);
-				straight_uchar_to_premul_ushort(p2i + 4, cp2 + 4);
-
-				desti[0] = ((unsigned int) p1i[0] + p2i[0] + p1i[4] + p2i[4]) >> 2;
-				desti[1] = ((unsigned int) p1i[1] + p2i[1] + p1i[5] + p2i[5]) >> 2;
-				desti[2] = ((unsigned int) p1i[2] + p2i[2] + p1i[6] + p2i[6]) >> 2;
-				desti[3] = ((unsigned int) p1i[3] + p2i[3] + p1i[7] + p2i[7]) >> 2;
-
-				premul_ushort_to_straight_uchar(dest, desti);
-
-				cp1 += 8;
-				cp2 += 8;
-				dest += 4;
-			}
-			cp1 = cp2;
-			if (ibuf1->x & 1) cp1 += 4;
-		}
-	}
+	/* mipmaps of big textures are made on every upload, small levels aren't worth the threading overhead */
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = ((size_t)ibuf2->x * ibuf2->y >= 128 * 128);
+	settings.min_iter_per_thread = 16;
 
-	if (do_float) {
-		float *p1f, *p2f, *destf;
-
-		p1f = ibuf1->rect_float;
-		destf = ibuf2->rect_float;
-		for (y = ibuf2->y; y > 0; y--) {
-			p2f = p1f + (ibuf1->x << 2);
-			for (x = ibuf2->x; x > 0; x--) {
-				destf[0] = 0.25f * (p1f[0] + p2f[0] + p1f[4] + p2f[4]);
-				destf[1] = 0.25f * (p1f[1] + p2f[1] + p1f[5] + p2f[5]);
-				destf[2] = 0.25f * (p1f[2] + p2f[2] + p1f[6] + p2f[6]);
-				destf[3] = 0.25f * (p1f[3] + p2f[3] + p1f[7] + p2f[7]);
-				p1f += 8;
-				p2f += 8;
-				destf += 4;
-			}
-			p1f = p2f;
-			if (ibuf1->x & 1) p1f += 4;
-		}
-	}
+	BLI_task_parallel_range(0, ibuf2->y, &data, imb_onehalf_row, &settings);
 }
 
 ImBuf *IMB_onehalf(struct ImBuf *ibuf1)
@@ -876,608 +896,348 @@ static bool q_scale_linear_interpolation(
 	return true;
 }
 
-static ImBuf *scaledownx(struct ImBuf *ibuf, int newx)
-{
-	const int do_rect = (ibuf->rect != NULL);
-	const int do_float = (ibuf->rect_float != NULL);
-	const size_t rect_size = ibuf->x * ibuf->y * 4;
-
-	uchar *rect, *_newrect, *newrect;
-	float *rectf, *_newrectf, *newrectf;
-	float sample, add, val[4], nval[4], valf[4], nvalf[4];
-	int x, y;
-
-	rectf = _newrectf = newrectf = NULL;
-	rect = _newrect = newrect = NULL;
-	nval[0] =  nval[1] = nval[2] = nval[3] = 0.0f;
-	nvalf[0] = nvalf[1] = nvalf[2] = nvalf[3] = 0.0f;
-
-	if (!do_rect && !do_float) return (ibuf);
+/* ******** separable filter scaling ******** */
 
-	if (do_rect) {
-		_newrect = MEM_mallocN(newx * ibuf->y * sizeof(uchar) * 4, "scaledownx");
-		if (_newrect == NULL) return(ibuf);
-	}
-	if (do_float) {
-		_newrectf = MEM_mallocN(newx * ibuf->y * sizeof(float) * 4, "scaledownxf");
-		if (_newrectf == NULL) {
-			if (_newrect) MEM_freeN(_newrect);
-			return(ibuf);
-		}
+/* Scaling is done in two passes: the rows are scaled horizontally into a float buffer,
+ * which is then scaled vertically into the new buffer. Every destination pixel of a pass
+ * is a weighted sum of a range of source pixels, the weights only depend on the position
+ * in the row or column so they are calculated once per pass (polyphase filter).
+ *
+ * Byte buffers are filtered with premultiplied alpha, so transparent pixels don't bleed
+ * their color into the result. */
+
+/* number of pixels of a row handled at once by the vertical pass, keeps the accumulated
+ * values in the cache while all source rows are added */
+#define SCALE_BLOCK_SIZE 256
+/* number of rows handled by a single task of the horizontal pass */
+#define SCALE_ROWS_PER_TASK 8
+
+typedef struct ScaleFilterTable {
+	/* first source pixel and number of source pixels for every destination pixel */
+	int *first;
+	int *len;
+	/* max_len weights for every destination pixel, normalized to add up to one */
+	float *weights;
+	int max_len;
+} ScaleFilterTable;
+
+static float scale_filter_sinc(float x)
+{
+	if (fabsf(x) < 1e-6f) {
+		return 1.0f;
 	}
+	x *= (float)M_PI;
+	return sinf(x) / x;
+}
 
-	add = (ibuf->x - 0.01) / newx;
-
-	if (do_rect) {
-		rect = (uchar *) ibuf->rect;
-		newrect = _newrect;
-	}
-	if (do_float) {
-		rectf = ibuf->rect_float;
-		newrectf = _newrectf;
+/* kernel value for a distance in destination pixels (source pixels when enlarging) */
+static float scale_filter_weight(eIMBScaleFilter filter, float x)
+{
+	x = fabsf(x);
+	switch (filter) {
+		case IMB_SCALE_FILTER_BILINEAR:
+			return (x < 1.0f) ? 1.0f - x : 0.0f;
+		case IMB_SCALE_FILTER_LANCZOS:
+			return (x < 3.0f) ? scale_filter_sinc(x) * scale_filter_sinc(x / 3.0f) : 0.0f;
+		case IMB_SCALE_FILTER_BOX:
+		default:
+			return (x <= 0.5f) ? 1.0f : 0.0f;
 	}
+}
 
-	for (y = ibuf->y; y > 0; y--) {
-		sample = 0.0f;
-		val[0] =  val[1] = val[2] = val[3] = 0.0f;
-		valf[0] = valf[1] = valf[2] = valf[3] = 0.0f;
+static float scale_filter_radius(eIMBScaleFilter filter)
+{
+	switch (filter) {
+		case IMB_SCALE_FILTER_BILINEAR:
+			return 1.0f;
+		case IMB_SCALE_FILTER_LANCZOS:
+			return 3.0f;
+		case IMB_SCALE_FILTER_BOX:
+		default:
+			return 0.5f;
+	}
+}
 
-		for (x = newx; x > 0; x--) {
-			if (do_rect) {
-				nval[0] = -val[0] * sample;
-				nval[1] = -val[1] * sample;
-				nval[2] = -val[2] * sample;
-				nval[3] = -val[3] * sample;
-			}
-			if (do_float) {
-				nvalf[0] = -valf[0] * sample;
-				nvalf[1] = -valf[1] * sample;
-				nvalf[2] = -valf[2] * sample;
-				nvalf[3] = -valf[3] * sample;
-			}
+static void scale_filter_table_init(ScaleFilterTable *table, eIMBScaleFilter filter, int src_len, int dst_len)
+{
+	const float scale = (float)src_len / (float)dst_len;
+	/* when shrinking the filter is widened to cover all source pixels */
+	const float filter_scale = max_ff(scale, 1.0f);
+	const float support = scale_filter_radius(filter) * filter_scale;
+	int i;
 
-			sample += add;
+	table->max_len = min_ii((int)ceilf(support * 2.0f) + 2, src_len);
+	table->first = MEM_mallocN(sizeof(int) * dst_len, __func__);
+	table->len = MEM_mallocN(sizeof(int) * dst_len, __func__);
+	table->weights = MEM_callocN(sizeof(float) * dst_len * table->max_len, __func__);
+
+	for (i = 0; i < dst_len; i++) {
+		const float center = ((float)i + 0.5f) * scale;
+		int first = max_ii((int)floorf(center - support), 0);
+		int last = min_ii((int)ceilf(center + support), src_len - 1);
+		float *weights = &table->weights[i * table->max_len];
+		float total = 0.0f;
+		int j;
+
+		if (last - first + 1 > table->max_len) {
+			last = first + table->max_len - 1;
+		}
 
-			while (sample >= 1.0f) {
-				sample -= 1.0f;
+		for (j = first; j <= last; j++) {
+			float weight;
 
-				if (do_rect) {
-					nval[0] += rect[0];
-					nval[1] += rect[1];
-					nval[2] += rect[2];
-					nval[3] += rect[3];
-					rect += 4;
-				}
-				if (do_float) {
-					nvalf[0] += rectf[0];
-					nvalf[1] += rectf[1];
-					nvalf[2] += rectf[2];
-					nvalf[3] += rectf[3];
-					rectf += 4;
-				}
+			if (filter == IMB_SCALE_FILTER_BOX && scale > 1.0f) {
+				/* exact area of the source pixel covered by the destination pixel */
+				const float lo = max_ff((float)j, center - 0.5f * scale);
+				const float hi = min_ff((float)(j + 1), center + 0.5f * scale);
+				weight = max_ff(hi - lo, 0.0f);
 			}
-
-			if (do_rect) {
-				val[0] = rect[0]; val[1] = rect[1]; val[2] = rect[2]; val[3] = rect[3];
-				rect += 4;
-
-				newrect[0] = ((nval[0] + sample * val[0]) / add + 0.5f);
-				newrect[1] = ((nval[1] + sample * val[1]) / add + 0.5f);
-				newrect[2] = ((nval[2] + sample * val[2]) / add + 0.5f);
-				newrect[3] = ((nval[3] + sample * val[3]) / add + 0.5f);
-
-				newrect += 4;
+			else {
+				weight = scale_filter_weight(filter, ((float)j + 0.5f - center) / filter_scale);
 			}
-			if (do_float) {
-
-				valf[0] = rectf[0]; valf[1] = rectf[1]; valf[2] = rectf[2]; valf[3] = rectf[3];
-				rectf += 4;
 
-				newrectf[0] = ((nvalf[0] + sample * valf[0]) / add);
-				newrectf[1] = ((nvalf[1] + sample * valf[1]) / add);
-				newrectf[2] = ((nvalf[2] + sample * valf[2]) / add);
-				newrectf[3] = ((nvalf[3] + sample * valf[3]) / add);
+			weights[j - first] = weight;
+			total += weight;
+		}
 
-				newrectf += 4;
+		if (total != 0.0f) {
+			const float total_inv = 1.0f / total;
+			for (j = 0; j <= last - first; j++) {
+				weights[j] *= total_inv;
 			}
+		}
+		else {
+			/* can only happen for box filters exactly between pixels, use the nearest pixel */
+			first = min_ii((int)center, src_len - 1);
+			last = first;
+			weights[0] = 1.0f;
+		}
 
-			sample -= 1.0f;
+		/* skip zero weights at the ends, the kernels are zero at the edge of their support */
+		while (last > first && weights[last - first] == 0.0f) {
+			last--;
+		}
+		while (first < last && weights[0] == 0.0f) {
+			memmove(weights, weights + 1, sizeof(float) * (last - first));
+			weights[last - first] = 0.0f;
+			first++;
 		}
-	}
 
-	if (do_rect) {
-		// printf("%ld %ld\n", (uchar *)rect - ((uchar *)ibuf->rect), rect_size);
-		BLI_assert((uchar *)rect - ((uchar *)ibuf->rect) == rect_size); /* see bug [#26502] */
-		imb_freerectImBuf(ibuf);
-		ibuf->mall |= IB_rect;
-		ibuf->rect = (unsigned int *) _newrect;
-	}
-	if (do_float) {
-		// printf("%ld %ld\n", rectf - ibuf->rect_float, rect_size);
-		BLI_assert((rectf - ibuf->rect_float) == rect_size); /* see bug [#26502] */
-		imb_freerectfloatImBuf(ibuf);
-		ibuf->mall |= IB_rectfloat;
-		ibuf->rect_float = _newrectf;
+		table->first[i] = first;
+		table->len[i] = last - first + 1;
 	}
-	(void)rect_size; /* UNUSED in release builds */
-
-	ibuf->x = newx;
-	return(ibuf);
 }
 
-
-static ImBuf *scaledowny(struct ImBuf *ibuf, int newy)
+static void scale_filter_table_free(ScaleFilterTable *table)
 {
-	const int do_rect = (ibuf->rect != NULL);
-	const int do_float = (ibuf->rect_float != NULL);
-	const size_t rect_size = ibuf->x * ibuf->y * 4;
-
-	uchar *rect, *_newrect, *newrect;
-	float *rectf, *_newrectf, *newrectf;
-	float sample, add, val[4], nval[4], valf[4], nvalf[4];
-	int x, y, skipx;
-
-	rectf = _newrectf = newrectf = NULL;
-	rect = _newrect = newrect = NULL;
-	nval[0] =  nval[1] = nval[2] = nval[3] = 0.0f;
-	nvalf[0] = nvalf[1] = nvalf[2] = nvalf[3] = 0.0f;
-
-	if (!do_rect && !do_float) return (ibuf);
-
-	if (do_rect) {
-		_newrect = MEM_mallocN(newy * ibuf->x * sizeof(uchar) * 4, "scaledowny");
-		if (_newrect == NULL) return(ibuf);
-	}
-	if (do_float) {
-		_newrectf = MEM_mallocN(newy * ibuf->x * sizeof(float) * 4, "scaledownyf");
-		if (_newrectf == NULL) {
-			if (_newrect) MEM_freeN(_newrect);
-			return(ibuf);
-		}
-	}
+	MEM_freeN(table->first);
+	MEM_freeN(table->len);
+	MEM_freeN(table->weights);
+}
 
-	add = (ibuf->y - 0.01) / newy;
-	skipx = 4 * ibuf->x;
+typedef struct ScaleFilterData {
+	const ImBuf *ibuf;
+	int newx, newy;
+	/* channels of the buffer being scaled, 4 for byte buffers */
+	int channels;
 
-	for (x = skipx - 4; x >= 0; x -= 4) {
-		if (do_rect) {
-			rect = ((uchar *) ibuf->rect) + x;
-			newrect = _newrect + x;
-		}
-		if (do_float) {
-			rectf = ibuf->rect_float + x;
-			newrectf = _newrectf + x;
-		}
+	const unsigned char *src_byte;
+	const float *src_float;
+	/* horizontally scaled rows, newx * ibuf->y pixels */
+	float *tmp;
+	unsigned char *dst_byte;
+	float *dst_float;
 
-		sample = 0.0f;
-		val[0] =  val[1] = val[2] = val[3] = 0.0f;
-		valf[0] = valf[1] = valf[2] = valf[3] = 0.0f;
+	ScaleFilterTable table_x, table_y;
+} ScaleFilterData;
 
-		for (y = newy; y > 0; y--) {
-			if (do_rect) {
-				nval[0] = -val[0] * sample;
-				nval[1] = -val[1] * sample;
-				nval[2] = -val[2] * sample;
-				nval[3] = -val[3] * sample;
+static void scale_filter_row_x(const ScaleFilterData *data, const float *src, float *dst)
+{
+	const ScaleFilterTable *table = &data->table_x;
+	const int channels = data->channels;
+	int x, k, c;
+
+	for (x = 0; x < data->newx; x++, dst += channels) {
+		const float *weights = &table->weights[x * table->max_len];
+		const float *s = &src[table->first[x] * channels];
+		const int len = table->len[x];
+
+		if (channels == 4) {
+			float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+			for (k = 0; k < len; k++, s += 4) {
+				const float w = weights[k];
+				acc[0] += w * s[0];
+				acc[1] += w * s[1];
+				acc[2] += w * s[2];
+				acc[3] += w * s[3];
 			}
-			if (do_float) {
-				nvalf[0] = -valf[0] * sample;
-				nvalf[1] = -valf[1] * sample;
-				nvalf[2] = -valf[2] * sample;
-				nvalf[3] = -valf[3] * sample;
+			copy_v4_v4(dst, acc);
+		}
+		else {
+			for (c = 0; c < channels; c++) {
+				dst[c] = 0.0f;
 			}
-
-			sample += add;
-
-			while (sample >= 1.0f) {
-				sample -= 1.0f;
-
-				if (do_rect) {
-					nval[0] += rect[0];
-					nval[1] += rect[1];
-					nval[2] += rect[2];
-					nval[3] += rect[3];
-					rect += skipx;
-				}
-				if (do_float) {
-					nvalf[0] += rectf[0];
-					nvalf[1] += rectf[1];
-					nvalf[2] += rectf[2];
-					nvalf[3] += rectf[3];
-					rectf += skipx;
+			for (k = 0; k < len; k++, s += channels) {
+				for (c = 0; c < channels; c++) {
+					dst[c] += weights[k] * s[c];
 				}
 			}
-
-			if (do_rect) {
-				val[0] = rect[0]; val[1] = rect[1]; val[2] = rect[2]; val[3] = rect[3];
-				rect += skipx;
-
-				newrect[0] = ((nval[0] + sample * val[0]) / add + 0.5f);
-				newrect[1] = ((nval[1] + sample * val[1]) / add + 0.5f);
-				newrect[2] = ((nval[2] + sample * val[2]) / add + 0.5f);
-				newrect[3] = ((nval[3] + sample * val[3]) / add + 0.5f);
-
-				newrect += skipx;
-			}
-			if (do_float) {
-
-				valf[0] = rectf[0]; valf[1] = rectf[1]; valf[2] = rectf[2]; valf[3] = rectf[3];
-				rectf += skipx;
-
-				newrectf[0] = ((nvalf[0] + sample * valf[0]) / add);
-				newrectf[1] = ((nvalf[1] + sample * valf[1]) / add);
-				newrectf[2] = ((nvalf[2] + sample * valf[2]) / add);
-				newrectf[3] = ((nvalf[3] + sample * valf[3]) / add);
-
-				newrectf += skipx;
-			}
-
-			sample -= 1.0f;
 		}
 	}
-
-	if (do_rect) {
-		// printf("%ld %ld\n", (uchar *)rect - ((uchar *)ibuf->rect), rect_size);
-		BLI_assert((uchar *)rect - ((uchar *)ibuf->rect) == rect_size); /* see bug [#26502] */
-		imb_freerectImBuf(ibuf);
-		ibuf->mall |= IB_rect;
-		ibuf->rect = (unsigned int *) _newrect;
-	}
-	if (do_float) {
-		// printf("%ld %ld\n", rectf - ibuf->rect_float, rect_size);
-		BLI_assert((rectf - ibuf->rect_float) == rect_size); /* see bug [#26502] */
-		imb_freerectfloatImBuf(ibuf);
-		ibuf->mall |= IB_rectfloat;
-		ibuf->rect_float = (float *) _newrectf;
-	}
-	(void)rect_size; /* UNUSED in release builds */
-
-	ibuf->y = newy;
-	return(ibuf);
 }
 
-
-static ImBuf *scaleupx(struct ImBuf *ibuf, int newx)
+static void scale_filter_x_task(void *__restrict userdata, const int task, const ParallelRangeTLS *__restrict UNUSED(tls))
 {
-	uchar *rect, *_newrect = NULL, *newrect;
-	float *rectf, *_newrectf = NULL, *newrectf;
-	float sample, add;
-	float val_a, nval_a, diff_a;
-	float val_b, nval_b, diff_b;
-	float val_g, nval_g, diff_g;
-	float val_r, nval_r, diff_r;
-	float val_af, nval_af, diff_af;
-	float val_bf, nval_bf, diff_bf;
-	float val_gf, nval_gf, diff_gf;
-	float val_rf, nval_rf, diff_rf;
-	int x, y;
-	bool do_rect = false, do_float = false;
-
-	val_a = nval_a = diff_a = val_b = nval_b = diff_b = 0;
-	val_g = nval_g = diff_g = val_r = nval_r = diff_r = 0;
-	val_af = nval_af = diff_af = val_bf = nval_bf = diff_bf = 0;
-	val_gf = nval_gf = diff_gf = val_rf = nval_rf = diff_rf = 0;
-	if (ibuf == NULL) return(NULL);
-	if (ibuf->rect == NULL && ibuf->rect_float == NULL) return (ibuf);
-
-	if (ibuf->rect) {
-		do_rect = true;
-		_newrect = MEM_mallocN(newx * ibuf->y * sizeof(int), "scaleupx");
-		if (_newrect == NULL) return(ibuf);
-	}
-	if (ibuf->rect_float) {
-		do_float = true;
-		_newrectf = MEM_mallocN(newx * ibuf->y * sizeof(float) * 4, "scaleupxf");
-		if (_newrectf == NULL) {
-			if (_newrect) MEM_freeN(_newrect);
-			return(ibuf);
-		}
+	const ScaleFilterData *data = userdata;
+	const int width = data->ibuf->x;
+	const int channels = data->channels;
+	const int y_start = task * SCALE_ROWS_PER_TASK;
+	const int y_end = min_ii(y_start + SCALE_ROWS_PER_TASK, data->ibuf->y);
+	float *row = NULL;
+	int y;
+
+	if (data->src_byte) {
+		row = MEM_mallocN(sizeof(float) * 4 * width, __func__);
 	}
 
-	add = (ibuf->x - 1.001) / (newx - 1.0);
-
-	rect = (uchar *) ibuf->rect;
-	rectf = (float *) ibuf->rect_float;
-	newrect = _newrect;
-	newrectf = _newrectf;
-
-	for (y = ibuf->y; y > 0; y--) {
+	for (y = y_start; y < y_end; y++) {
+		float *dst = &data->tmp[(size_t)y * data->newx * channels];
 
-		sample = 0;
-
-		if (do_rect) {
-			val_a = rect[0];
-			nval_a = rect[4];
-			diff_a = nval_a - val_a;
-			val_a += 0.5f;
-
-			val_b = rect[1];
-			nval_b = rect[5];
-			diff_b = nval_b - val_b;
-			val_b += 0.5f;
-
-			val_g = rect[2];
-			nval_g = rect[6];
-			diff_g = nval_g - val_g;
-			val_g += 0.5f;
-
-			val_r = rect[3];
-			nval_r = rect[7];
-			diff_r = nval_r - val_r;
-			val_r += 0.5f;
-
-			rect += 8;
-		}
-		if (do_float) {
-			val_af = rectf[0];
-			nval_af = rectf[4];
-			diff_af = nval_af - val_af;
-
-			val_bf = rectf[1];
-			nval_bf = rectf[5];
-			diff_bf = nval_bf - val_bf;
-
-			val_gf = rectf[2];
-			nval_gf = rectf[6];
-			diff_gf = nval_gf - val_gf;
-
-			val_rf = rectf[3];
-			nval_rf = rectf[7];
-			diff_rf = nval_rf - val_rf;
-
-			rectf += 8;
-		}
-		for (x = newx; x > 0; x--) {
-			if (sample >= 1.0f) {
-				sample -= 1.0f;
-
-				if (do_rect) {
-					val_a = nval_a;
-					nval_a = rect[0];
-					diff_a = nval_a - val_a;
-					val_a += 0.5f;
-
-					val_b = nval_b;
-					nval_b = rect[1];
-					diff_b = nval_b - val_b;
-					val_b += 0.5f;
-
-					val_g = nval_g;
-					nval_g = rect[2];
-					diff_g = nval_g - val_g;
-					val_g += 0.5f;
-
-					val_r = nval_r;
-					nval_r = rect[3];
-					diff_r = nval_r - val_r;
-					val_r += 0.5f;
-					rect += 4;
-				}
-				if (do_float) {
-					val_af = nval_af;
-					nval_af = rectf[0];
-					diff_af = nval_af - val_af;
-
-					val_bf = nval_bf;
-					nval_bf = rectf[1];
-					diff_bf = nval_bf - val_bf;
-
-					val_gf = nval_gf;
-					nval_gf = rectf[2];
-					diff_gf = nval_gf - val_gf;
-
-					val_rf = nval_rf;
-					nval_rf = rectf[3];
-					diff_rf = nval_rf - val_rf;
-					rectf += 4;
-				}
-			}
-			if (do_rect) {
-				newrect[0] = val_a + sample * diff_a;
-				newrect[1] = val_b + sample * diff_b;
-				newrect[2] = val_g + sample * diff_g;
-				newrect[3] = val_r + sample * diff_r;
-				newrect += 4;
+		if (data->src_byte) {
+			const unsigned char *src = &data->src_byte[(size_t)y * width * 4];
+			int x;
+			for (x = 0; x < width; x++) {
+				straight_uchar_to_premul_float(&row[x * 4], &src[x * 4]);
 			}
-			if (do_float) {
-				newrectf[0] = val_af + sample * diff_af;
-				newrectf[1] = val_bf + sample * diff_bf;
-				newrectf[2] = val_gf + sample * diff_gf;
-				newrectf[3] = val_rf + sample * diff_rf;
-				newrectf += 4;
-			}
-			sample += add;
+			scale_filter_row_x(data, row, dst);
+		}
+		else {
+			scale_filter_row_x(data, &data->src_float[(size_t)y * width * channels], dst);
 		}
 	}
 
-	if (do_rect) {
-		imb_freerectImBuf(ibuf);
-		ibuf->mall |= IB_rect;
-		ibuf->rect = (unsigned int *) _newrect;
-	}
-	if (do_float) {
-		imb_freerectfloatImBuf(ibuf);
-		ibuf->mall |= IB_rectfloat;
-		ibuf->rect_float = (float *) _newrectf;
+	if (row) {
+		MEM_freeN(row);
 	}
-
-	ibuf->x = newx;
-	return(ibuf);
 }
 
-static ImBuf *scaleupy(struct ImBuf *ibuf, int newy)
+static void scale_filter_y_task(void *__restrict userdata, const int y, const ParallelRangeTLS *__restrict UNUSED(tls))
 {
-	uchar *rect, *_newrect = NULL, *newrect;
-	float *rectf, *_newrectf = NULL, *newrectf;
-	float sample, add;
-	float val_a, nval_a, diff_a;
-	float val_b, nval_b, diff_b;
-	float val_g, nval_g, diff_g;
-	float val_r, nval_r, diff_r;
-	float val_af, nval_af, diff_af;
-	float val_bf, nval_bf, diff_bf;
-	float val_gf, nval_gf, diff_gf;
-	float val_rf, nval_rf, diff_rf;
-	int x, y, skipx;
-	bool do_rect = false, do_float = false;
-
-	val_a = nval_a = diff_a = val_b = nval_b = diff_b = 0;
-	val_g = nval_g = diff_g = val_r = nval_r = diff_r = 0;
-	val_af = nval_af = diff_af = val_bf = nval_bf = diff_bf = 0;
-	val_gf = nval_gf = diff_gf = val_rf = nval_rf = diff_rf = 0;
-	if (ibuf == NULL) return(NULL);
-	if (ibuf->rect == NULL && ibuf->rect_float == NULL) return (ibuf);
+	const ScaleFilterData *data = userdata;
+	const ScaleFilterTable *table = &data->table_y;
+	const int channels = data->channels;
+	const size_t row_stride = (size_t)data->newx * channels;
+	const float *weights = &table->weights[y * table->max_len];
+	const float *src = &data->tmp[table->first[y] * row_stride];
+	const int len = table->len[y];
+	float acc[SCALE_BLOCK_SIZE * 4];
+	int block, k, i;
+
+	for (block = 0; block < data->newx; block += SCALE_BLOCK_SIZE) {
+		const int block_len = min_ii(SCALE_BLOCK_SIZE, data->newx - block) * channels;
+		const size_t offset = (size_t)block * channels;
+
+		memset(acc, 0, sizeof(float) * block_len);
+		for (k = 0; k < len; k++) {
+			const float w = weights[k];
+			const float *s = &src[k * row_stride + offset];
+			for (i = 0; i < block_len; i++) {
+				acc[i] += w * s[i];
+			}
+		}
 
-	if (ibuf->rect) {
-		do_rect = true;
-		_newrect = MEM_mallocN(ibuf->x * newy * sizeof(int), "scaleupy");
-		if (_newrect == NULL) return(ibuf);
-	}
-	if (ibuf->rect_float) {
-		do_float = true;
-		_newrectf = MEM_mallocN(ibuf->x * newy * sizeof(float) * 4, "scaleupyf");
-		if (_newrectf == NULL) {
-			if (_newrect) MEM_freeN(_newrect);
-			return(ibuf);
+		if (data->dst_byte) {
+			unsigned char *dst = &data->dst_byte[(size_t)y * data->newx * 4 + offset];
+			for (i = 0; i < block_len; i += 4) {
+				float color[4];
+				/* lanczos can overshoot */
+				CLAMP_MIN(acc[i + 3], 0.0f);
+				color[3] = min_ff(acc[i + 3], 1.0f);
+				color[0] = clamp_f(acc[i], 0.0f, color[3]);
+				color[1] = clamp_f(acc[i + 1], 0.0f, color[3]);
+				color[2] = clamp_f(acc[i + 2], 0.0f, color[3]);
+				premul_float_to_straight_uchar(&dst[i], color);
+			}
+		}
+		else {
+			memcpy(&data->dst_float[(size_t)y * row_stride + offset], acc, sizeof(float) * block_len);
 		}
 	}
+}
 
-	add = (ibuf->y - 1.001) / (newy - 1.0);
-	skipx = 4 * ibuf->x;
+static void scale_filter_buffer(
+        ScaleFilterData *data, const unsigned char *src_byte, const float *src_float,
+        unsigned char *dst_byte, float *dst_float)
+{
+	const ImBuf *ibuf = data->ibuf;
+	ParallelRangeSettings settings;
 
-	rect = (uchar *) ibuf->rect;
-	rectf = (float *) ibuf->rect_float;
-	newrect = _newrect;
-	newrectf = _newrectf;
+	data->src_byte = src_byte;
+	data->src_float = src_float;
+	data->dst_byte = dst_byte;
+	data->dst_float = dst_float;
+	data->channels = src_byte ? 4 : ibuf->channels;
+	data->tmp = MEM_mallocN(sizeof(float) * data->channels * data->newx * ibuf->y, __func__);
 
-	for (x = ibuf->x; x > 0; x--) {
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = ((size_t)ibuf->x * ibuf->y > 64 * 64) || ((size_t)data->newx * data->newy > 64 * 64);
+	settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
 
-		sample = 0;
-		if (do_rect) {
-			rect = ((uchar *)ibuf->rect) + 4 * (x - 1);
-			newrect = _newrect + 4 * (x - 1);
-
-			val_a = rect[0];
-			nval_a = rect[skipx];
-			diff_a = nval_a - val_a;
-			val_a += 0.5f;
-
-			val_b = rect[1];
-			nval_b = rect[skipx + 1];
-			diff_b = nval_b - val_b;
-			val_b += 0.5f;
-
-			val_g = rect[2];
-			nval_g = rect[skipx + 2];
-			diff_g = nval_g - val_g;
-			val_g += 0.5f;
-
-			val_r = rect[3];
-			nval_r = rect[skipx + 3];
-			diff_r = nval_r - val_r;
-			val_r += 0.5f;
-
-			rect += 2 * skipx;
-		}
-		if (do_float) {
-			rectf = ibuf->rect_float + 4 * (x - 1);
-			newrectf = _newrectf + 4 * (x - 1);
+	BLI_task_parallel_range(0, (ibuf->y + SCALE_ROWS_PER_TASK - 1) / SCALE_ROWS_PER_TASK, data, scale_filter_x_task, &settings);
+	BLI_task_parallel_range(0, data->newy, data, scale_filter_y_task, &settings);
 
-			val_af = rectf[0];
-			nval_af = rectf[skipx];
-			diff_af = nval_af - val_af;
-
-			val_bf = rectf[1];
-			nval_bf = rectf[skipx + 1];
-			diff_bf = nval_bf - val_bf;
-
-			val_gf = rectf[2];
-			nval_gf = rectf[skipx + 2];
-			diff_gf = nval_gf - val_gf;
+	MEM_freeN(data->tmp);
+	data->tmp = NULL;
+}
 
-			val_rf = rectf[3];
-			nval_rf = rectf[skipx + 3];
-			diff_rf = nval_rf - val_rf;
+/**
+ * Scale byte and float buffers, with separate filters for the horizontal and vertical pass.
+ */
+static bool imb_scale_filter(ImBuf *ibuf, int newx, int newy, eIMBScaleFilter filter_x, eIMBScaleFilter filter_y)
+{
+	ScaleFilterData data = {NULL};
+	unsigned char *newrect = NULL;
+	float *newrectf = NULL;
 
-			rectf += 2 * skipx;
+	if (ibuf->rect) {
+		newrect = MEM_mallocN(sizeof(unsigned char) * 4 * newx * newy, "scale filter byte");
+		if (newrect == NULL) {
+			return false;
 		}
-
-		for (y = newy; y > 0; y--) {
-			if (sample >= 1.0f) {
-				sample -= 1.0f;
-
-				if (do_rect) {
-					val_a = nval_a;
-					nval_a = rect[0];
-					diff_a = nval_a - val_a;
-					val_a += 0.5f;
-
-					val_b = nval_b;
-					nval_b = rect[1];
-					diff_b = nval_b - val_b;
-					val_b += 0.5f;
-
-					val_g = nval_g;
-					nval_g = rect[2];
-					diff_g = nval_g - val_g;
-					val_g += 0.5f;
-
-					val_r = nval_r;
-					nval_r = rect[3];
-					diff_r = nval_r - val_r;
-					val_r += 0.5f;
-					rect += skipx;
-				}
-				if (do_float) {
-					val_af = nval_af;
-					nval_af = rectf[0];
-					diff_af = nval_af - val_af;
-
-					val_bf = nval_bf;
-					nval_bf = rectf[1];
-					diff_bf = nval_bf - val_bf;
-
-					val_gf = nval_gf;
-					nval_gf = rectf[2];
-					diff_gf = nval_gf - val_gf;
-
-					val_rf = nval_rf;
-					nval_rf = rectf[3];
-					diff_rf = nval_rf - val_rf;
-					rectf += skipx;
-				}
-			}
-			if (do_rect) {
-				newrect[0] = val_a + sample * diff_a;
-				newrect[1] = val_b + sample * diff_b;
-				newrect[2] = val_g + sample * diff_g;
-				newrect[3] = val_r + sample * diff_r;
-				newrect += skipx;
-			}
-			if (do_float) {
-				newrectf[0] = val_af + sample * diff_af;
-				newrectf[1] = val_bf + sample * diff_bf;
-				newrectf[2] = val_gf + sample * diff_gf;
-				newrectf[3] = val_rf + sample * diff_rf;
-				newrectf += skipx;
-			}
-			sample += add;
+	}
+	if (ibuf->rect_float) {
+		newrectf = MEM_mallocN(sizeof(float) * ibuf->channels * newx * newy, "scale filter float");
+		if (newrectf == NULL) {
+			if (newrect) MEM_freeN(newrect);
+			return false;
 		}
 	}
 
-	if (do_rect) {
+	data.ibuf = ibuf;
+	data.newx = newx;
+	data.newy = newy;
+	scale_filter_table_init(&data.table_x, filter_x, ibuf->x, newx);
+	scale_filter_table_init(&data.table_y, filter_y, ibuf->y, newy);
+
+	if (newrect) {
+		scale_filter_buffer(&data, (unsigned char *)ibuf->rect, NULL, newrect, NULL);
 		imb_freerectImBuf(ibuf);
 		ibuf->mall |= IB_rect;
-		ibuf->rect = (unsigned int *) _newrect;
+		ibuf->rect = (unsigned int *)newrect;
 	}
-	if (do_float) {
+	if (newrectf) {
+		scale_filter_buffer(&data, NULL, ibuf->rect_float, NULL, newrectf);
 		imb_freerectfloatImBuf(ibuf);
 		ibuf->mall |= IB_rectfloat;
-		ibuf->rect_float = (float *) _newrectf;
+		ibuf->rect_float = newrectf;
 	}
 
+	scale_filter_table_free(&data.table_x);
+	scale_filter_table_free(&data.table_y);
+
+	ibuf->x = newx;
 	ibuf->y = newy;
-	return(ibuf);
+	return true;
 }
 
 static void scalefast_Z_ImBuf(ImBuf *ibuf, int newx, int newy)
@@ -1553,11 +1313,15 @@ bool IMB_scaleImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy)
 	if (ibuf == NULL) return false;
 	if (ibuf->rect == NULL && ibuf->rect_float == NULL) return false;
 
+	/* zero keeps the size of that direction */
+	if (newx == 0) newx = ibuf->x;
+	if (newy == 0) newy = ibuf->y;
+
 	if (newx == ibuf->x && newy == ibuf->y) {
 		return false;
 	}
 
-	/* scaleup / scaledown functions below change ibuf->x and ibuf->y
+	/* the scaling below changes ibuf->x and ibuf->y
 	 * so we first scale the Z-buffer (if any) */
 	scalefast_Z_ImBuf(ibuf, newx, newy);
 
@@ -1567,14 +1331,34 @@ bool IMB_scaleImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy)
 		return true;
 	}
 
-	if (newx && (newx < ibuf->x)) scaledownx(ibuf, newx);
-	if (newy && (newy < ibuf->y)) scaledowny(ibuf, newy);
-	if (newx && (newx > ibuf->x)) scaleupx(ibuf, newx);
-	if (newy && (newy > ibuf->y)) scaleupy(ibuf, newy);
+	/* average the covered pixels when shrinking, interpolate when enlarging */
+	imb_scale_filter(ibuf, newx, newy,
+	                 (newx < ibuf->x) ? IMB_SCALE_FILTER_BOX : IMB_SCALE_FILTER_BILINEAR,
+	                 (newy < ibuf->y) ? IMB_SCALE_FILTER_BOX : IMB_SCALE_FILTER_BILINEAR);
 
 	return true;
 }
 
+/**
+ * Scale using \a filter for both directions, the filter is widened when shrinking so all pixels are used.
+ *
+ * Return true if \a ibuf is modified.
+ */
+bool IMB_scaleImBuf_filter(struct ImBuf *ibuf, unsigned int newx, unsigned int newy, eIMBScaleFilter filter)
+{
+	if (ibuf == NULL) return false;
+	if (ibuf->rect == NULL && ibuf->rect_float == NULL) return false;
+	if (newx == 0 || newy == 0) return false;
+
+	if (newx == ibuf->x && newy == ibuf->y) {
+		return false;
+	}
+
+	scalefast_Z_ImBuf(ibuf, newx, newy);
+
+	return imb_scale_filter(ibuf, newx, newy, filter, filter);
+}
+
 struct imbufRGBA {
 	float r, g, b, a;
 };
@@ -1662,111 +1446,7 @@ bool IMB_scalefastImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy
 
 /* ******** threaded scaling ******** */
 
-typedef struct ScaleTreadInitData {
-	ImBuf *ibuf;
-
-	unsigned int newx;
-	unsigned int newy;
-
-	unsigned char *byte_buffer;
-	float *float_buffer;
-} ScaleTreadInitData;
-
-typedef struct ScaleThreadData {
-	ImBuf *ibuf;
-
-	unsigned int newx;
-	unsigned int newy;
-
-	int start_line;
-	int tot_line;
-
-	unsigned char *byte_buffer;
-	float *float_buffer;
-} ScaleThreadData;
-
-static void scale_thread_init(void *data_v, int start_line, int tot_line, void *init_data_v)
-{
-	ScaleThreadData *data = (ScaleThreadData *) data_v;
-	ScaleTreadInitData *init_data = (ScaleTreadInitData *) init_data_v;
-
-	data->ibuf = init_data->ibuf;
-
-	data->newx = init_data->newx;
-	data->newy = init_data->newy;
-
-	data->start_line = start_line;
-	data->tot_line = tot_line;
-
-	data->byte_buffer = init_data->byte_buffer;
-	data->float_buffer = init_data->float_buffer;
-}
-
-static void *do_scale_thread(void *data_v)
-{
-	ScaleThreadData *data = (ScaleThreadData *) data_v;
-	ImBuf *ibuf = data->ibuf;
-	int i;
-	float factor_x = (float) ibuf->x / data->newx;
-	float factor_y = (float) ibuf->y / data->newy;
-
-	for (i = 0; i < data->tot_line; i++) {
-		int y = data->start_line + i;
-		int x;
-
-		for (x = 0; x < data->newx; x++) {
-			float u = (float) x * factor_x;
-			float v = (float) y * factor_y;
-			int offset = y * data->newx + x;
-
-			if (data->byte_buffer) {
-				unsigned char *pixel = data->byte_buffer + 4 * offset;
-				BLI_bilinear_interpolation_char((unsigned char *) ibuf->rect, pixel, ibuf->x, ibuf->y, 4, u, v);
-			}
-
-			if (data->float_buffer) {
-				float *pixel = data->float_buffer + ibuf->channels * offset;
-				BLI_bilinear_interpolation_fl(ibuf->rect_float, pixel, ibuf->x, ibuf->y, ibuf->channels, u, v);
-			}
-		}
-	}
-
-	return NULL;
-}
-
 void IMB_scaleImBuf_threaded(ImBuf *ibuf, unsigned int newx, unsigned int newy)
 {
-	ScaleTreadInitData init_data = {NULL};
-
-	/* prepare initialization data */
-	init_data.ibuf = ibuf;
-
-	init_data.newx = newx;
-	init_data.newy = newy;
-
-	if (ibuf->rect)
-		init_data.byte_buffer = MEM_mallocN(4 * newx * newy * sizeof(char), "threaded scale byte buffer");
-
-	if (ibuf->rect_float)
-		init_data.float_buffer = MEM_mallocN(ibuf->channels * newx * newy * sizeof(float), "threaded scale float buffer");
-
-	/* actual scaling threads */
-	IMB_processor_apply_threaded(newy, sizeof(ScaleThreadData), &init_data,
-	                             scale_thread_init, do_scale_thread);
-
-	/* alter image buffer */
-	ibuf->x = newx;
-	ibuf->y = newy;
-
-	if (ibuf->rect) {
-		imb_freerectImBuf(ibuf);
-		ibuf->mall |= IB_rect;
-		ibuf->rect = (unsigned int *) init_data.byte_buffer;
-	}
-
-	if (ibuf->rect_float) {
-		imb_freerectfloatImBuf(ibuf);
-		ibuf->mall |= IB_rectfloat;
-		ibuf->rect_float = init_data.float_buffer;
-	}
+	IMB_scaleImBuf_filter(ibuf, newx, newy, IMB_SCALE_FILTER_BILINEAR);
 }
@@ -326,6 +326,7 @@ static ImBuf *thumb_create_ex(
 	char cheight[40] = "0";
 	short tsize = 128;
 	short ex, ey;
+	int full_x = 0, full_y = 0; /* size of the image file, when it was loaded at a lower level */
 	float scaledx, scaledy;
 	BLI_stat_t info;
 
@@ -369,8 +370,15 @@ static ImBuf *thumb_create_ex(
 				if (img == NULL) {
 					switch (source) {
 						case THB_SOURCE_IMAGE:
-							img = IMB_loadiffname(file_path, IB_rect | IB_metadata, NULL);
+						{
+							/* files with mipmaps only have the level closest to the thumbnail read */
+							ImBufLoadOptions options = {0};
+							options.fit_size = tsize;
+							img = IMB_loadiffname_ex(file_path, IB_rect | IB_metadata, NULL, &options);
+							full_x = options.full_x;
+							full_y = options.full_y;
 							break;
+						}
 						case THB_SOURCE_BLEND:
 							img = IMB_thumb_load_blend(file_path, blen_group, blen_id);
 							break;
@@ -386,8 +394,8 @@ static ImBuf *thumb_create_ex(
 					if (BLI_stat(file_path, &info) != -1) {
 						BLI_snprintf(mtime, sizeof(mtime), "%ld", (long int)info.st_mtime);
 					}
-					BLI_snprintf(cwidth, sizeof(cwidth), "%d", img->x);
-					BLI_snprintf(cheight, sizeof(cheight), "%d", img->y);
+					BLI_snprintf(cwidth, sizeof(cwidth), "%d", full_x ? full_x : img->x);
+					BLI_snprintf(cheight, sizeof(cheight), "%d", full_y ? full_y : img->y);
 				}
 			}
 			else if (THB_SOURCE_MOVIE == source) {
@@ -125,6 +125,9 @@ typedef struct Key {
 	 * current free uid for keyblocks
 	 */
 	int uidgen;
+
+	/** Runtime only, sparse shape deltas used for blending (see key.c). */
+	struct KeyRuntime *runtime;
 } Key;
 
 /* **************** KEY ********************* */
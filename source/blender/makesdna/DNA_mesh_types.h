@@ -89,7 +89,8 @@ typedef struct Mesh_Runtime {
 	struct SubdivCCG *subdiv_ccg;
 	void  *pad1;
 	int subdiv_ccg_tot_level;
-	int pad2;
+	/** Changes every time the mesh is copied (copy-on-write updates), see #BKE_mesh_runtime_reset_on_copy. */
+	int copy_id;
 
 	int64_t cd_dirty_vert;
 	int64_t cd_dirty_edge;
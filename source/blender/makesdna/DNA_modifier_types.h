@@ -798,7 +798,8 @@ typedef struct BooleanModifierData {
 
 	struct Object *object;
 	char operation;
-	char pad[2];
+	char solver;
+	char pad;
 	char bm_flag;
 	float double_threshold;
 } BooleanModifierData;
@@ -809,6 +810,13 @@ typedef enum {
 	eBooleanModifierOp_Difference = 2,
 } BooleanModifierOp;
 
+/* BooleanModifierData.solver */
+typedef enum {
+	eBooleanModifierSolver_BMesh    = 0,
+	/* multi-threaded intersection with winding number inside/outside test */
+	eBooleanModifierSolver_Threaded = 1,
+} BooleanModifierSolver;
+
 /* bm_flag (only used when G_DEBUG) */
 enum {
 	eBooleanModifierBMeshFlag_BMesh_Separate            = (1 << 0),
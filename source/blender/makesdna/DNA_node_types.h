@@ -511,6 +511,7 @@ typedef struct bNodeTree {
 
 /* tree is localized copy, free when deleting node groups */
 /* #define NTREE_IS_LOCALIZED			(1 << 5) */
+#define NTREE_COM_FULL_FRAME		(1 << 6)	/* calculate nodes a buffer at a time where supported */
 
 /* XXX not nice, but needed as a temporary flags
  * for group updates after library linking.
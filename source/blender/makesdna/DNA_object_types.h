@@ -162,6 +162,10 @@ typedef struct Object_Runtime {
 
 	struct ObjectBBoneDeform *cached_bbone_deformation;
 
+	/** Outputs of constructive modifiers, reused while their inputs don't change. */
+	struct ModifierResultCache *modifier_result_cache;
+	void *pad_ptr;
+
 	/**
 	 * The custom data layer mask that was last used
 	 * to calculate mesh_eval and mesh_deform_eval.
@@ -1884,6 +1884,7 @@ enum {
 #define R_SCEMODE_DEPRECATED_19 (1 << 19)  /* cleared */
 #define R_EXR_CACHE_FILE        (1 << 20)
 #define R_MULTIVIEW             (1 << 21)
+#define R_EXR_STREAM_FILE       (1 << 22)
 
 /* RenderData.stamp */
 #define R_STAMP_TIME 	(1 << 0)
@@ -269,6 +269,11 @@ typedef struct Editing {
 	int over_ofs, over_cfra;
 	int over_flag, proxy_storage;
 	rctf over_border;
+
+	/** Levels of the sequencer cache also stored on disk, see #eSeqCacheFlag. */
+	int cache_flag;
+	/** Incremented on changes which make the disk cache invalid. */
+	int disk_cache_version;
 } Editing;
 
 /* ************* Effect Variable Structs ********* */
@@ -454,6 +459,14 @@ typedef struct SequencerScopes {
 /* store proxies in project directory */
 #define SEQ_EDIT_PROXY_DIR_STORAGE 1
 
+/* Editor->cache_flag, one bit for every level of the cache, see seqcache.c */
+typedef enum eSeqCacheFlag {
+	SEQ_CACHE_DISK_RAW          = (1 << 0),
+	SEQ_CACHE_DISK_PREPROCESSED = (1 << 1),
+	SEQ_CACHE_DISK_COMPOSITE    = (1 << 2),
+	SEQ_CACHE_DISK_FINAL        = (1 << 3),
+} eSeqCacheFlag;
+
 /* SpeedControlVars->flags */
 #define SEQ_SPEED_INTEGRATE      (1 << 0)
 #define SEQ_SPEED_DEPRECATED_1   (1 << 1)  /* cleared */
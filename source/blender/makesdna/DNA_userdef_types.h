@@ -655,7 +655,9 @@ typedef struct UserDef {
 	/* Was using non-aligned struct! */
 	/* struct SolidLight light[3] DNA_DEPRECATED; */
 	struct SolidLight light_param[4];
-	float light_ambient[3], pad7;
+	float light_ambient[3];
+	/** Compositor intermediate buffer cache limit (in megabytes). */
+	int compositor_cache_limit;
 	short gizmo_flag, gizmo_size;
 	short edit_studio_light;
 	short pad6[2];
@@ -774,7 +776,15 @@ typedef struct UserDef {
 	/** #eMultiSample_Type, amount of samples for Grease Pencil. */
 	short gpencil_multisamples;
 
-	char pad5[4];
+	/** Share of the sequencer cache limit (memcachelimit) for every level of the cache, in percent. */
+	char sequencer_cache_budget[4];
+	/** 768 = FILE_MAXDIR. */
+	char sequencer_disk_cache_dir[768];
+	/** Sequencer disk cache size limit (in gigabytes). */
+	int sequencer_disk_cache_size_limit;
+
+	/** Modifier stack result cache limit (in megabytes). */
+	int modifier_cache_limit;
 } UserDef;
 
 /* from blenkernel blender.c */
@@ -716,6 +716,14 @@ static void rna_def_cloth_sim_settings(BlenderRNA *brna)
 	RNA_def_property_update(prop, 0, "rna_cloth_update");
 	RNA_def_property_clear_flag(prop, PROP_ANIMATABLE);
 
+	prop = RNA_def_property(srna, "use_solver_preconditioner", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "flags", CLOTH_SIMSETTINGS_FLAG_SOLVER_PRECONDITION);
+	RNA_def_property_ui_text(prop, "Preconditioner",
+	                         "Precondition the solver with the inverse of the per vertex blocks, "
+	                         "fewer iterations for cloth with varying mass or stiffness");
+	RNA_def_property_update(prop, 0, "rna_cloth_update");
+	RNA_def_property_clear_flag(prop, PROP_ANIMATABLE);
+
 	prop = RNA_def_property(srna, "bending_model", PROP_ENUM, PROP_NONE);
 	RNA_def_property_enum_sdna(prop, NULL, "bending_model");
 	RNA_def_property_enum_items(prop, prop_bending_model_items);
@@ -576,6 +576,7 @@ static void rna_ColorManagedColorspaceSettings_reload_update(Main *bmain, Scene
 		/* all sequencers for now, we don't know which scenes are using this clip as a strip */
 		BKE_sequencer_cache_cleanup();
 		BKE_sequencer_preprocessed_cache_cleanup();
+		BKE_sequencer_cache_disk_cleanup_all(bmain);
 
 		WM_main_add_notifier(NC_MOVIECLIP | ND_DISPLAY, &clip->id);
 		WM_main_add_notifier(NC_MOVIECLIP | NA_EDITED, &clip->id);
@@ -619,6 +620,7 @@ static void rna_ColorManagedColorspaceSettings_reload_update(Main *bmain, Scene
 
 				BKE_sequencer_cache_cleanup();
 				BKE_sequencer_preprocessed_cache_cleanup();
+				BKE_sequencer_cache_disk_cleanup(scene);
 			}
 
 			WM_main_add_notifier(NC_SCENE | ND_SEQUENCER, NULL);
@@ -1145,6 +1147,13 @@ static void rna_def_colormanage(BlenderRNA *brna)
 	RNA_def_property_ui_text(prop, "Use Curves", "Use RGB curved for pre-display transformation");
 	RNA_def_property_update(prop, NC_WINDOW, "rna_ColorManagement_update");
 
+	prop = RNA_def_property(srna, "use_baked_lut", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "flag", COLORMANAGE_VIEW_USE_BAKED_LUT);
+	RNA_def_property_ui_text(prop, "Baked Display LUT",
+	                         "Bake view transform into a look-up table for faster display of large images, "
+	                         "at the cost of small precision loss");
+	RNA_def_property_update(prop, NC_WINDOW, "rna_ColorManagement_update");
+
 	/* ** Colorspace **  */
 	srna = RNA_def_struct(brna, "ColorManagedInputColorspaceSettings", NULL);
 	RNA_def_struct_path_func(srna, "rna_ColorManagedInputColorspaceSettings_path");
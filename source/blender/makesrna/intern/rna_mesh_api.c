@@ -46,6 +46,7 @@
 
 #include "DNA_mesh_types.h"
 
+#include "BKE_library.h"
 #include "BKE_mesh.h"
 #include "BKE_mesh_tangent.h"
 #include "BKE_mesh_mapping.h"
@@ -216,6 +217,35 @@ static void rna_Mesh_split_faces(Mesh *mesh, bool free_loop_normals)
 	BKE_mesh_split_faces(mesh, free_loop_normals != 0);
 }
 
+static int rna_Mesh_merge_vertices(Mesh *mesh, ReportList *reports, float distance)
+{
+	const int totvert = mesh->totvert;
+	Mesh *mesh_merged;
+
+	if (mesh->edit_btmesh) {
+		BKE_report(reports, RPT_ERROR, "Mesh is in edit mode");
+		return 0;
+	}
+	if (mesh->key) {
+		BKE_report(reports, RPT_ERROR, "Mesh has shape keys");
+		return 0;
+	}
+
+	/* merging frees the mesh it's given */
+	mesh_merged = BKE_mesh_merge_verts_by_distance(
+	        BKE_mesh_copy_for_eval(mesh, false), distance, MESH_MERGE_VERTS_DUMP_IF_EQUAL);
+
+	if (mesh_merged->totvert == totvert) {
+		BKE_id_free(NULL, mesh_merged);
+		return 0;
+	}
+
+	BKE_mesh_nomain_to_mesh(mesh_merged, mesh, NULL, CD_MASK_MESH, true);
+	DEG_id_tag_update(&mesh->id, 0);
+
+	return totvert - mesh->totvert;
+}
+
 static void rna_Mesh_update_gpu_tag(Mesh *mesh)
 {
 	BKE_mesh_batch_cache_dirty_tag(mesh, BKE_MESH_BATCH_DIRTY_ALL);
@@ -331,6 +361,15 @@ void RNA_api_mesh(StructRNA *srna)
 	parm = RNA_def_boolean(func, "result", 0, "Result", "");
 	RNA_def_function_return(func, parm);
 
+	func = RNA_def_function(srna, "merge_vertices", "rna_Mesh_merge_vertices");
+	RNA_def_function_ui_description(func, "Merge vertices closer than the given distance to each other, "
+	                                "without converting the mesh to BMesh, collapsed faces are removed");
+	RNA_def_function_flag(func, FUNC_USE_REPORTS);
+	RNA_def_float_distance(func, "distance", 0.0001f, 0.0f, FLT_MAX, "Distance", "Maximum distance between merged vertices",
+	                       0.00001f, 10.0f);
+	parm = RNA_def_int(func, "result", 0, 0, INT_MAX, "Result", "Number of removed vertices", 0, INT_MAX);
+	RNA_def_function_return(func, parm);
+
 	func = RNA_def_function(srna, "validate_material_indices", "BKE_mesh_validate_material_indices");
 	RNA_def_function_ui_description(func, "Validate material indices of polygons, return True when the mesh has had "
 	                                "invalid indices corrected (to default 0)");
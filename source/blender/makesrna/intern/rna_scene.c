@@ -1788,10 +1788,11 @@ static void rna_SceneCamera_update(Main *UNUSED(bmain), Scene *UNUSED(scene), Po
 	}
 }
 
-static void rna_SceneSequencer_update(Main *UNUSED(bmain), Scene *UNUSED(scene), PointerRNA *UNUSED(ptr))
+static void rna_SceneSequencer_update(Main *bmain, Scene *UNUSED(scene), PointerRNA *UNUSED(ptr))
 {
 	BKE_sequencer_cache_cleanup();
 	BKE_sequencer_preprocessed_cache_cleanup();
+	BKE_sequencer_cache_disk_cleanup_all(bmain);
 }
 
 static char *rna_ToolSettings_path(PointerRNA *UNUSED(ptr))
@@ -1936,11 +1937,12 @@ static void rna_GPUDOFSettings_blades_set(PointerRNA *ptr, const int value)
 	}
 }
 
-static void rna_GPUDOFSettings_update(Main *UNUSED(bmain), Scene *scene, PointerRNA *UNUSED(ptr))
+static void rna_GPUDOFSettings_update(Main *bmain, Scene *scene, PointerRNA *UNUSED(ptr))
 {
 	/* TODO(sergey): Can be more selective here. */
 	BKE_sequencer_cache_cleanup();
 	BKE_sequencer_preprocessed_cache_cleanup();
+	BKE_sequencer_cache_disk_cleanup_all(bmain);
 	WM_main_add_notifier(NC_SCENE | ND_SEQUENCER, scene);
 }
 
@@ -5169,6 +5171,14 @@ static void rna_def_scene_render_data(BlenderRNA *brna)
 	                         "(saves memory, required for Full Sample)");
 	RNA_def_property_update(prop, NC_SCENE | ND_RENDER_OPTIONS, NULL);
 
+	prop = RNA_def_property(srna, "use_stream_output", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "scemode", R_EXR_STREAM_FILE);
+	RNA_def_property_clear_flag(prop, PROP_ANIMATABLE);
+	RNA_def_property_ui_text(prop, "Stream Output",
+	                         "Write tiles directly into the MultiLayer OpenEXR output file while rendering, "
+	                         "instead of temp files (requires Save Buffers, not used with compositing)");
+	RNA_def_property_update(prop, NC_SCENE | ND_RENDER_OPTIONS, NULL);
+
 	prop = RNA_def_property(srna, "use_full_sample", PROP_BOOLEAN, PROP_NONE);
 	RNA_def_property_boolean_sdna(prop, NULL, "scemode", R_FULL_SAMPLE);
 	RNA_def_property_ui_text(prop, "Full Sample",
@@ -498,6 +498,9 @@ static void rna_Sequence_name_set(PointerRNA *ptr, const char *value)
 	/* make a copy of the old name first */
 	BLI_strncpy(oldname, seq->name + 2, sizeof(seq->name) - 2);
 
+	/* files of the disk cache are found by name of the strip */
+	BKE_sequencer_cache_disk_cleanup_sequence(scene, seq);
+
 	/* copy the new name into the name slot */
 	BLI_strncpy_utf8(seq->name + 2, value, sizeof(seq->name) - 2);
 
@@ -939,6 +942,27 @@ static int rna_SequenceEditor_overlay_frame_get(PointerRNA *ptr)
 
 }
 
+static int rna_SequenceEditor_prefetch_hits_get(PointerRNA *ptr)
+{
+	SeqPrefetchStats stats;
+	BKE_sequencer_prefetch_stats_get((Scene *)ptr->id.data, &stats);
+	return stats.hits;
+}
+
+static int rna_SequenceEditor_prefetch_misses_get(PointerRNA *ptr)
+{
+	SeqPrefetchStats stats;
+	BKE_sequencer_prefetch_stats_get((Scene *)ptr->id.data, &stats);
+	return stats.misses;
+}
+
+static int rna_SequenceEditor_prefetch_lookahead_get(PointerRNA *ptr)
+{
+	SeqPrefetchStats stats;
+	BKE_sequencer_prefetch_stats_get((Scene *)ptr->id.data, &stats);
+	return stats.lookahead;
+}
+
 static void rna_SequenceEditor_overlay_frame_set(PointerRNA *ptr, int value)
 {
 	Scene *scene = (Scene *)ptr->id.data;
@@ -1730,10 +1754,45 @@ static void rna_def_editor(BlenderRNA *brna)
 	RNA_def_property_ui_text(prop, "Proxy Storage", "How to store proxies for this project");
 	RNA_def_property_update(prop, NC_SPACE | ND_SPACE_SEQUENCER, "rna_SequenceEditor_update_cache");
 
+	/* prefetch statistics, see UserDef.prefetchframes */
+	prop = RNA_def_property(srna, "prefetch_hits", PROP_INT, PROP_UNSIGNED);
+	RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+	RNA_def_property_int_funcs(prop, "rna_SequenceEditor_prefetch_hits_get", NULL, NULL);
+	RNA_def_property_ui_text(prop, "Prefetch Hits", "Number of frames played back which were rendered ahead");
+
+	prop = RNA_def_property(srna, "prefetch_misses", PROP_INT, PROP_UNSIGNED);
+	RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+	RNA_def_property_int_funcs(prop, "rna_SequenceEditor_prefetch_misses_get", NULL, NULL);
+	RNA_def_property_ui_text(prop, "Prefetch Misses",
+	                         "Number of frames played back which were not rendered ahead in time");
+
+	prop = RNA_def_property(srna, "prefetch_lookahead", PROP_INT, PROP_UNSIGNED);
+	RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+	RNA_def_property_int_funcs(prop, "rna_SequenceEditor_prefetch_lookahead_get", NULL, NULL);
+	RNA_def_property_ui_text(prop, "Prefetch Lookahead", "Number of frames rendered ahead of the current frame");
+
 	prop = RNA_def_property(srna, "proxy_dir", PROP_STRING, PROP_DIRPATH);
 	RNA_def_property_string_sdna(prop, NULL, "proxy_dir");
 	RNA_def_property_ui_text(prop, "Proxy Directory", "");
 	RNA_def_property_update(prop, NC_SPACE | ND_SPACE_SEQUENCER, "rna_SequenceEditor_update_cache");
+
+	/* levels of the cache written to the disk cache directory of the user preferences */
+	prop = RNA_def_property(srna, "use_cache_disk_raw", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "cache_flag", SEQ_CACHE_DISK_RAW);
+	RNA_def_property_ui_text(prop, "Raw Images", "Store images of strips before preprocessing on disk");
+
+	prop = RNA_def_property(srna, "use_cache_disk_preprocessed", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "cache_flag", SEQ_CACHE_DISK_PREPROCESSED);
+	RNA_def_property_ui_text(prop, "Preprocessed Images",
+	                         "Store images of strips after preprocessing and modifiers on disk");
+
+	prop = RNA_def_property(srna, "use_cache_disk_composite", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "cache_flag", SEQ_CACHE_DISK_COMPOSITE);
+	RNA_def_property_ui_text(prop, "Composite Images", "Store images of strips blended with the strips below on disk");
+
+	prop = RNA_def_property(srna, "use_cache_disk_final", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "cache_flag", SEQ_CACHE_DISK_FINAL);
+	RNA_def_property_ui_text(prop, "Final Images", "Store final frames on disk");
 }
 
 static void rna_def_filter_video(StructRNA *srna)
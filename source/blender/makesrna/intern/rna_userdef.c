@@ -106,6 +106,7 @@ static const EnumPropertyItem rna_enum_studio_light_type_items[] = {
 #include "BKE_idprop.h"
 #include "BKE_main.h"
 #include "BKE_mesh_runtime.h"
+#include "BKE_modifier.h"
 #include "BKE_pbvh.h"
 #include "BKE_paint.h"
 
@@ -317,6 +318,32 @@ static void rna_Userdef_memcache_update(Main *UNUSED(bmain), Scene *UNUSED(scene
 	MEM_CacheLimiter_set_maximum(((size_t) U.memcachelimit) * 1024 * 1024);
 }
 
+static void rna_Userdef_modifier_cache_update(Main *UNUSED(bmain), Scene *UNUSED(scene), PointerRNA *UNUSED(ptr))
+{
+	modifier_resultCache_limit_update();
+}
+
+static int rna_UserDef_modifier_cache_hits_get(PointerRNA *UNUSED(ptr))
+{
+	ModifierResultCacheStats stats;
+	modifier_resultCache_stats_get(&stats);
+	return (int)stats.hits;
+}
+
+static int rna_UserDef_modifier_cache_misses_get(PointerRNA *UNUSED(ptr))
+{
+	ModifierResultCacheStats stats;
+	modifier_resultCache_stats_get(&stats);
+	return (int)stats.misses;
+}
+
+static float rna_UserDef_modifier_cache_memory_get(PointerRNA *UNUSED(ptr))
+{
+	ModifierResultCacheStats stats;
+	modifier_resultCache_stats_get(&stats);
+	return (float)((double)stats.mem_in_use / (1024.0 * 1024.0));
+}
+
 static void rna_UserDef_weight_color_update(Main *bmain, Scene *scene, PointerRNA *ptr)
 {
 	Object *ob;
@@ -4398,6 +4425,76 @@ static void rna_def_userdef_system(BlenderRNA *brna)
 	RNA_def_property_ui_text(prop, "Memory Cache Limit", "Memory cache limit (in megabytes)");
 	RNA_def_property_update(prop, 0, "rna_Userdef_memcache_update");
 
+	prop = RNA_def_property(srna, "compositor_cache_limit", PROP_INT, PROP_NONE);
+	RNA_def_property_int_sdna(prop, NULL, "compositor_cache_limit");
+	RNA_def_property_range(prop, 0, max_memory_in_megabytes_int());
+	RNA_def_property_ui_text(prop, "Compositor Cache Limit",
+	                         "Memory used to keep intermediate compositor results between executions, "
+	                         "so only nodes after a change are calculated again (in megabytes, 0 to disable)");
+
+	prop = RNA_def_property(srna, "modifier_cache_limit", PROP_INT, PROP_NONE);
+	RNA_def_property_int_sdna(prop, NULL, "modifier_cache_limit");
+	RNA_def_property_range(prop, 0, max_memory_in_megabytes_int());
+	RNA_def_property_ui_text(prop, "Modifier Cache Limit",
+	                         "Memory used to keep results of modifiers between evaluations, "
+	                         "so only modifiers after a change are calculated again (in megabytes, 0 to disable)");
+	RNA_def_property_update(prop, 0, "rna_Userdef_modifier_cache_update");
+
+	/* modifier cache statistics, see modifier_cache.c */
+	prop = RNA_def_property(srna, "modifier_cache_hits", PROP_INT, PROP_UNSIGNED);
+	RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+	RNA_def_property_int_funcs(prop, "rna_UserDef_modifier_cache_hits_get", NULL, NULL);
+	RNA_def_property_ui_text(prop, "Modifier Cache Hits", "Number of modifier results reused from the cache");
+
+	prop = RNA_def_property(srna, "modifier_cache_misses", PROP_INT, PROP_UNSIGNED);
+	RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+	RNA_def_property_int_funcs(prop, "rna_UserDef_modifier_cache_misses_get", NULL, NULL);
+	RNA_def_property_ui_text(prop, "Modifier Cache Misses",
+	                         "Number of cached modifiers which had to be calculated again");
+
+	prop = RNA_def_property(srna, "modifier_cache_memory", PROP_FLOAT, PROP_UNSIGNED);
+	RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+	RNA_def_property_float_funcs(prop, "rna_UserDef_modifier_cache_memory_get", NULL, NULL);
+	RNA_def_property_ui_text(prop, "Modifier Cache Memory", "Memory used by cached modifier results (in megabytes)");
+
+	/* sequencer cache levels, see seqcache.c
+	 * the shares are normalized against their sum, so they don't need to add up to 100 */
+	prop = RNA_def_property(srna, "sequencer_cache_budget_raw", PROP_INT, PROP_PERCENTAGE);
+	RNA_def_property_int_sdna(prop, NULL, "sequencer_cache_budget[0]");
+	RNA_def_property_range(prop, 0, 100);
+	RNA_def_property_ui_text(prop, "Raw Images",
+	                         "Share of the memory cache limit used for images of strips before preprocessing, "
+	                         "relative to the other sequencer cache levels");
+
+	prop = RNA_def_property(srna, "sequencer_cache_budget_preprocessed", PROP_INT, PROP_PERCENTAGE);
+	RNA_def_property_int_sdna(prop, NULL, "sequencer_cache_budget[1]");
+	RNA_def_property_range(prop, 0, 100);
+	RNA_def_property_ui_text(prop, "Preprocessed Images",
+	                         "Share of the memory cache limit used for images of strips after preprocessing and modifiers, "
+	                         "relative to the other sequencer cache levels");
+
+	prop = RNA_def_property(srna, "sequencer_cache_budget_composite", PROP_INT, PROP_PERCENTAGE);
+	RNA_def_property_int_sdna(prop, NULL, "sequencer_cache_budget[2]");
+	RNA_def_property_range(prop, 0, 100);
+	RNA_def_property_ui_text(prop, "Composite Images",
+	                         "Share of the memory cache limit used for images of strips blended with the strips below, "
+	                         "relative to the other sequencer cache levels");
+
+	prop = RNA_def_property(srna, "sequencer_cache_budget_final", PROP_INT, PROP_PERCENTAGE);
+	RNA_def_property_int_sdna(prop, NULL, "sequencer_cache_budget[3]");
+	RNA_def_property_range(prop, 0, 100);
+	RNA_def_property_ui_text(prop, "Final Images",
+	                         "Share of the memory cache limit used for final frames, "
+	                         "relative to the other sequencer cache levels");
+
+	prop = RNA_def_property(srna, "sequencer_disk_cache_size_limit", PROP_INT, PROP_NONE);
+	RNA_def_property_int_sdna(prop, NULL, "sequencer_disk_cache_size_limit");
+	RNA_def_property_range(prop, 1, INT_MAX);
+	RNA_def_property_ui_range(prop, 1, 1000, 1, -1);
+	RNA_def_property_ui_text(prop, "Sequencer Disk Cache Limit",
+	                         "Disk space used by the sequencer disk cache, least recently used images are removed first "
+	                         "(in gigabytes)");
+
 	prop = RNA_def_property(srna, "scrollback", PROP_INT, PROP_UNSIGNED);
 	RNA_def_property_int_sdna(prop, NULL, "scrollback");
 	RNA_def_property_range(prop, 32, 32768);
@@ -4962,6 +5059,11 @@ static void rna_def_userdef_filepaths(BlenderRNA *brna)
 	RNA_def_property_string_sdna(prop, NULL, "render_cachedir");
 	RNA_def_property_ui_text(prop, "Render Cache Path", "Where to cache raw render results");
 
+	prop = RNA_def_property(srna, "sequencer_disk_cache_directory", PROP_STRING, PROP_DIRPATH);
+	RNA_def_property_string_sdna(prop, NULL, "sequencer_disk_cache_dir");
+	RNA_def_property_ui_text(prop, "Sequencer Disk Cache Path",
+	                         "Where to store sequencer images of editors which have the disk cache enabled");
+
 	prop = RNA_def_property(srna, "image_editor", PROP_STRING, PROP_FILEPATH);
 	RNA_def_property_string_sdna(prop, NULL, "image_editor");
 	RNA_def_property_ui_text(prop, "Image Editor", "Path to an image editor");
@@ -48,11 +48,13 @@
 
 #include "BLI_alloca.h"
 #include "BLI_math_geom.h"
+#include "BLI_math_vector.h"
 
 #include "BKE_global.h"  /* only to check G.debug */
 #include "BKE_library.h"
 #include "BKE_material.h"
 #include "BKE_mesh.h"
+#include "BKE_object.h"
 
 #include "DNA_mesh_types.h"
 #include "DNA_meshdata_types.h"
@@ -75,6 +77,7 @@ static void initData(ModifierData *md)
 	BooleanModifierData *bmd = (BooleanModifierData *)md;
 
 	bmd->double_threshold = 1e-6f;
+	bmd->solver = eBooleanModifierSolver_Threaded;
 }
 
 static bool isDisabled(const struct Scene *UNUSED(scene), ModifierData *md, bool UNUSED(useRenderParams))
@@ -157,6 +160,109 @@ static Mesh *get_quick_mesh(
 }
 
 
+/**
+ * Key everything the result depends on (including both meshes),
+ * so moving either operand (or editing it) invalidates the cached result.
+ * The result is stored in the modifier result cache of the object, which survives copy-on-write updates.
+ *
+ * \return NULL when the result can't be cached.
+ */
+static struct ModifierResultCacheKey *boolean_cache_key_create(
+        BooleanModifierData *bmd,
+        Object *ob_self, Mesh *mesh_self,
+        Object *ob_other, Mesh *mesh_other)
+{
+	struct ModifierResultCacheKey *key;
+	float imat[4][4];
+	float omat[4][4];
+	const int settings[3] = {bmd->operation, bmd->bm_flag, (G.debug & G_DEBUG) ? 1 : 0};
+
+	key = modifier_resultCache_key_create_ex(ob_self, &bmd->modifier);
+	if (key == NULL) {
+		return NULL;
+	}
+
+	/* the flip of the other operand follows from it too */
+	invert_m4_m4(imat, ob_self->obmat);
+	mul_m4_m4m4(omat, imat, ob_other->obmat);
+
+	modifier_resultCache_key_add(key, omat, sizeof(omat));
+	modifier_resultCache_key_add(key, settings, sizeof(settings));
+	modifier_resultCache_key_add(key, &bmd->double_threshold, sizeof(bmd->double_threshold));
+	{
+		const short ob_src_totcol = ob_other->totcol;
+		short *material_remap = BLI_array_alloca(material_remap, ob_src_totcol ? ob_src_totcol : 1);
+
+		BKE_material_remap_object_calc(ob_self, ob_other, material_remap);
+		modifier_resultCache_key_add(key, &ob_src_totcol, sizeof(ob_src_totcol));
+		modifier_resultCache_key_add(key, material_remap, sizeof(*material_remap) * (size_t)ob_src_totcol);
+	}
+
+	if (!modifier_resultCache_key_add_mesh(key, mesh_self) ||
+	    !modifier_resultCache_key_add_mesh(key, mesh_other))
+	{
+		modifier_resultCache_key_free(key);
+		return NULL;
+	}
+
+	return key;
+}
+
+/**
+ * When the bounds don't overlap there is nothing to cut,
+ * intersect and difference results are known without building a BMesh.
+ */
+static Mesh *get_disjoint_mesh(
+        Object *ob_self,  Mesh *mesh_self,
+        Object *ob_other, Mesh *mesh_other,
+        int operation)
+{
+	float min_self[3], max_self[3];
+	float min_other[3], max_other[3];
+
+	if (!ELEM(operation, eBooleanModifierOp_Intersect, eBooleanModifierOp_Difference)) {
+		return NULL;
+	}
+
+	INIT_MINMAX(min_self, max_self);
+	INIT_MINMAX(min_other, max_other);
+
+	if (!BKE_mesh_minmax(mesh_self, min_self, max_self) ||
+	    !BKE_mesh_minmax(mesh_other, min_other, max_other))
+	{
+		return NULL;
+	}
+
+	{
+		float imat[4][4];
+		float omat[4][4];
+		float bb_min[3], bb_max[3];
+		BoundBox bb;
+
+		invert_m4_m4(imat, ob_self->obmat);
+		mul_m4_m4m4(omat, imat, ob_other->obmat);
+
+		BKE_boundbox_init_from_minmax(&bb, min_other, max_other);
+		INIT_MINMAX(bb_min, bb_max);
+		for (int i = 0; i < 8; i++) {
+			float co[3];
+			mul_v3_m4v3(co, omat, bb.vec[i]);
+			minmax_v3v3_v3(bb_min, bb_max, co);
+		}
+
+		if (isect_aabb_aabb_v3(min_self, max_self, bb_min, bb_max)) {
+			return NULL;
+		}
+	}
+
+	if (operation == eBooleanModifierOp_Intersect) {
+		return BKE_mesh_new_nomain(0, 0, 0, 0, 0);
+	}
+	else {
+		return mesh_self;
+	}
+}
+
 /* has no meaning for faces, do this so we can tell which face is which */
 #define BM_FACE_TAG BM_ELEM_DRAW
 
@@ -190,6 +296,21 @@ static Mesh *applyModifier(ModifierData *md, const ModifierEvalContext *ctx, Mes
 		 * Returning mesh is depended on modifiers operation (sergey) */
 		result = get_quick_mesh(object, mesh, other, mesh_other, bmd->operation);
 
+		const bool use_threaded = (bmd->solver == eBooleanModifierSolver_Threaded);
+		struct ModifierResultCacheKey *cache_key = NULL;
+		unsigned int cache_id;
+
+		if ((result == NULL) && use_threaded) {
+			result = get_disjoint_mesh(object, mesh, other, mesh_other, bmd->operation);
+
+			if (result == NULL) {
+				cache_key = boolean_cache_key_create(bmd, object, mesh, other, mesh_other);
+				if (cache_key != NULL) {
+					result = modifier_resultCache_lookup(object, md, cache_key, &cache_id);
+				}
+			}
+		}
+
 		if (result == NULL) {
 			const bool is_flip = (is_negative_m4(object->obmat) != is_negative_m4(other->obmat));
 
@@ -302,7 +423,7 @@ static Mesh *applyModifier(ModifierData *md, const ModifierEvalContext *ctx, Mes
 					use_island_connect = (bmd->bm_flag & eBooleanModifierBMeshFlag_BMesh_NoConnectRegions) == 0;
 				}
 
-				BM_mesh_intersect(
+				BM_mesh_intersect_ex(
 				        bm,
 				        looptris, tottri,
 				        bm_face_isect_pair, NULL,
@@ -313,7 +434,8 @@ static Mesh *applyModifier(ModifierData *md, const ModifierEvalContext *ctx, Mes
 				        false,
 				        false,
 				        bmd->operation,
-				        bmd->double_threshold);
+				        bmd->double_threshold,
+				        use_threaded ? (BMESH_ISECT_FLAG_THREADED | BMESH_ISECT_FLAG_WINDING) : 0);
 
 				MEM_freeN(looptris);
 			}
@@ -322,6 +444,11 @@ static Mesh *applyModifier(ModifierData *md, const ModifierEvalContext *ctx, Mes
 
 			BM_mesh_free(bm);
 
+			if (cache_key != NULL) {
+				/* the cache takes ownership, returns a copy referencing its data */
+				result = modifier_resultCache_store(object, md, cache_key, result, &cache_id);
+			}
+
 			result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
 
 #ifdef DEBUG_TIME
@@ -333,6 +460,10 @@ static Mesh *applyModifier(ModifierData *md, const ModifierEvalContext *ctx, Mes
 		 * an error, so delete the modifier object */
 		if (result == NULL)
 			modifier_setError(md, "Cannot execute boolean operation");
+
+		if (cache_key != NULL) {
+			modifier_resultCache_key_free(cache_key);
+		}
 	}
 
 	if (mesh_other != NULL && mesh_other_free) {
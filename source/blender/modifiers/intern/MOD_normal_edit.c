@@ -415,9 +415,11 @@ static Mesh *normalEditModifier_do(
 	}
 
 	Mesh *result;
-	if (mesh->medge == ((Mesh *)ob->data)->medge) {
+	if (CustomData_is_referenced_layer(&mesh->edata, CD_MEDGE) ||
+	    CustomData_is_referenced_layer(&mesh->ldata, CD_CUSTOMLOOPNORMAL))
+	{
 		/* We need to duplicate data here, otherwise setting custom normals (which may also affect sharp edges) could
-		 * modify org mesh, see T43671. */
+		 * modify org mesh (or a cached modifier result), see T43671. */
 		BKE_id_copy_ex(
 		        NULL, &mesh->id, (ID **)&result,
 		        LIB_ID_CREATE_NO_MAIN |
@@ -342,6 +342,106 @@ static Mesh *generate_ocean_geometry(OceanModifierData *omd)
 	return result;
 }
 
+/* points evaluated per task, the ocean lock is taken once per block */
+#define OCEAN_EVAL_BLOCK_SIZE 256
+
+typedef struct OceanDisplaceData {
+	OceanModifierData *omd;
+	MVert *mverts;
+	MLoop *mloops;
+	MLoopCol *mloopcols;
+	int totitem;
+	int cfra_for_cache;
+	/* use cached & inverted value for speed
+	 * expanded this would read...
+	 *
+	 * (axis / (omd->size * omd->spatial_size)) + 0.5f) */
+	float size_co_inv;
+} OceanDisplaceData;
+
+static void ocean_displace_eval_block(
+        const OceanDisplaceData *odd, const int block, const bool use_loops,
+        OceanResult *r_ocr, int *r_start, int *r_totpoint)
+{
+	OceanModifierData *omd = odd->omd;
+	float uv[OCEAN_EVAL_BLOCK_SIZE][2];
+	const int start = block * OCEAN_EVAL_BLOCK_SIZE;
+	const int totpoint = min_ii(odd->totitem - start, OCEAN_EVAL_BLOCK_SIZE);
+	int i;
+
+	for (i = 0; i < totpoint; i++) {
+		const int vi = use_loops ? odd->mloops[start + i].v : start + i;
+		const float *vco = odd->mverts[vi].co;
+		uv[i][0] = (vco[0] * odd->size_co_inv) + 0.5f;
+		uv[i][1] = (vco[1] * odd->size_co_inv) + 0.5f;
+	}
+
+	if (omd->oceancache && omd->cached == true) {
+		for (i = 0; i < totpoint; i++) {
+			BKE_ocean_cache_eval_uv(omd->oceancache, &r_ocr[i], odd->cfra_for_cache, uv[i][0], uv[i][1]);
+		}
+	}
+	else {
+		BKE_ocean_eval_uv_array(omd->ocean, r_ocr, (const float (*)[2])uv, totpoint);
+	}
+
+	*r_start = start;
+	*r_totpoint = totpoint;
+}
+
+static void ocean_displace_foam_block(
+        void *__restrict userdata,
+        const int block,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	const OceanDisplaceData *odd = userdata;
+	OceanModifierData *omd = odd->omd;
+	OceanResult ocr[OCEAN_EVAL_BLOCK_SIZE];
+	int start, totpoint, i;
+
+	ocean_displace_eval_block(odd, block, true, ocr, &start, &totpoint);
+
+	for (i = 0; i < totpoint; i++) {
+		MLoopCol *mlcol = &odd->mloopcols[start + i];
+		float foam;
+
+		if (omd->oceancache && omd->cached == true) {
+			foam = ocr[i].foam;
+			CLAMP(foam, 0.0f, 1.0f);
+		}
+		else {
+			foam = BKE_ocean_jminus_to_foam(ocr[i].Jminus, omd->foam_coverage);
+		}
+
+		mlcol->r = mlcol->g = mlcol->b = (char)(foam * 255);
+		/* This needs to be set (render engine uses) */
+		mlcol->a = 255;
+	}
+}
+
+static void ocean_displace_verts_block(
+        void *__restrict userdata,
+        const int block,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	const OceanDisplaceData *odd = userdata;
+	OceanResult ocr[OCEAN_EVAL_BLOCK_SIZE];
+	int start, totpoint, i;
+
+	ocean_displace_eval_block(odd, block, false, ocr, &start, &totpoint);
+
+	for (i = 0; i < totpoint; i++) {
+		float *vco = odd->mverts[start + i].co;
+
+		vco[2] += ocr[i].disp[1];
+
+		if (odd->omd->chop_amount > 0.0f) {
+			vco[0] += ocr[i].disp[0];
+			vco[1] += ocr[i].disp[2];
+		}
+	}
+}
+
 static Mesh *doOcean(ModifierData *md, const ModifierEvalContext *ctx, Mesh *mesh)
 {
 	OceanModifierData *omd = (OceanModifierData *) md;
@@ -350,21 +450,14 @@ static Mesh *doOcean(ModifierData *md, const ModifierEvalContext *ctx, Mesh *mes
 	bool allocated_ocean = false;
 
 	Mesh *result = NULL;
-	OceanResult ocr;
-
-	MVert *mverts;
+	OceanDisplaceData odd;
 
 	int cfra_for_cache;
-	int i, j;
-
-	/* use cached & inverted value for speed
-	 * expanded this would read...
-	 *
-	 * (axis / (omd->size * omd->spatial_size)) + 0.5f) */
-#define OCEAN_CO(_size_co_inv, _v) ((_v * _size_co_inv) + 0.5f)
 
 	const float size_co_inv = 1.0f / (omd->size * omd->spatial_size);
 
+	ParallelRangeSettings settings;
+
 	/* can happen in when size is small, avoid bad array lookups later and quit now */
 	if (!isfinite(size_co_inv)) {
 		return mesh;
@@ -404,86 +497,49 @@ static Mesh *doOcean(ModifierData *md, const ModifierEvalContext *ctx, Mesh *mes
 	CLAMP(cfra_for_cache, omd->bakestart, omd->bakeend);
 	cfra_for_cache -= omd->bakestart; /* shift to 0 based */
 
-	mverts = result->mvert;
+	odd.omd = omd;
+	odd.mverts = result->mvert;
+	odd.mloops = result->mloop;
+	odd.mloopcols = NULL;
+	odd.cfra_for_cache = cfra_for_cache;
+	odd.size_co_inv = size_co_inv;
+
+	/* Points are evaluated in blocks, so the ocean lock is taken once per block
+	 * rather than once per point, which made the threaded version slower than
+	 * the single threaded one. */
+	BLI_parallel_range_settings_defaults(&settings);
 
 	/* add vcols before displacement - allows lookup based on position */
 
 	if (omd->flag & MOD_OCEAN_GENERATE_FOAM) {
 		if (CustomData_number_of_layers(&result->ldata, CD_MLOOPCOL) < MAX_MCOL) {
-			const int num_polys = result->totpoly;
 			const int num_loops = result->totloop;
-			MLoop *mloops = result->mloop;
-			MLoopCol *mloopcols = CustomData_add_layer_named(
-			                          &result->ldata, CD_MLOOPCOL, CD_CALLOC, NULL, num_loops, omd->foamlayername);
-
-			if (mloopcols) { /* unlikely to fail */
-				MPoly *mpolys = result->mpoly;
-				MPoly *mp;
-
-				for (i = 0, mp = mpolys; i < num_polys; i++, mp++) {
-					MLoop *ml = &mloops[mp->loopstart];
-					MLoopCol *mlcol = &mloopcols[mp->loopstart];
-
-					for (j = mp->totloop; j--; ml++, mlcol++) {
-						const float *vco = mverts[ml->v].co;
-						const float u = OCEAN_CO(size_co_inv, vco[0]);
-						const float v = OCEAN_CO(size_co_inv, vco[1]);
-						float foam;
-
-						if (omd->oceancache && omd->cached == true) {
-							BKE_ocean_cache_eval_uv(omd->oceancache, &ocr, cfra_for_cache, u, v);
-							foam = ocr.foam;
-							CLAMP(foam, 0.0f, 1.0f);
-						}
-						else {
-							BKE_ocean_eval_uv(omd->ocean, &ocr, u, v);
-							foam = BKE_ocean_jminus_to_foam(ocr.Jminus, omd->foam_coverage);
-						}
-
-						mlcol->r = mlcol->g = mlcol->b = (char)(foam * 255);
-						/* This needs to be set (render engine uses) */
-						mlcol->a = 255;
-					}
-				}
-			}
-		}
-	}
-
-
-	/* displace the geometry */
 
-	/* Note: tried to parallelized that one and previous foam loop, but gives 20% slower results... odd. */
-	{
-		const int num_verts = result->totvert;
+			odd.mloopcols = CustomData_add_layer_named(
+			                    &result->ldata, CD_MLOOPCOL, CD_CALLOC, NULL, num_loops, omd->foamlayername);
 
-		for (i = 0; i < num_verts; i++) {
-			float *vco = mverts[i].co;
-			const float u = OCEAN_CO(size_co_inv, vco[0]);
-			const float v = OCEAN_CO(size_co_inv, vco[1]);
-
-			if (omd->oceancache && omd->cached == true) {
-				BKE_ocean_cache_eval_uv(omd->oceancache, &ocr, cfra_for_cache, u, v);
-			}
-			else {
-				BKE_ocean_eval_uv(omd->ocean, &ocr, u, v);
-			}
-
-			vco[2] += ocr.disp[1];
-
-			if (omd->chop_amount > 0.0f) {
-				vco[0] += ocr.disp[0];
-				vco[1] += ocr.disp[2];
+			if (odd.mloopcols) { /* unlikely to fail */
+				odd.totitem = num_loops;
+				settings.use_threading = (num_loops > OCEAN_EVAL_BLOCK_SIZE);
+				BLI_task_parallel_range(
+				        0, (num_loops + OCEAN_EVAL_BLOCK_SIZE - 1) / OCEAN_EVAL_BLOCK_SIZE,
+				        &odd, ocean_displace_foam_block, &settings);
 			}
 		}
 	}
 
+	/* displace the geometry */
+	odd.totitem = result->totvert;
+	settings.use_threading = (result->totvert > OCEAN_EVAL_BLOCK_SIZE);
+	BLI_task_parallel_range(
+	        0, (result->totvert + OCEAN_EVAL_BLOCK_SIZE - 1) / OCEAN_EVAL_BLOCK_SIZE,
+	        &odd, ocean_displace_verts_block, &settings);
+
 	if (allocated_ocean) {
 		BKE_ocean_free(omd->ocean);
 		omd->ocean = NULL;
 	}
 
-#undef OCEAN_CO
-
 	return result;
 }
 #else  /* WITH_OCEANSIM */
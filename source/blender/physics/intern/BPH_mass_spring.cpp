@@ -522,15 +522,21 @@ static void cloth_calc_force(Scene *scene, ClothModifierData *clmd, float UNUSED
 	if (effectors) {
 		/* cache per-vertex forces to avoid redundant calculation */
 		float(*winvec)[3] = (float(*)[3])MEM_callocN(sizeof(float[3]) * mvert_num, "effector forces");
-		for (i = 0; i < cloth->mvert_num; i++) {
-			float x[3], v[3];
-			EffectedPoint epoint;
+		float(*eff_x)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * mvert_num, "effector locations");
+		float(*eff_v)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * mvert_num, "effector velocities");
+		EffectedPoint *epoints = (EffectedPoint *)MEM_callocN(sizeof(EffectedPoint) * mvert_num, "effected points");
 
-			BPH_mass_spring_get_motion_state(data, i, x, v);
-			pd_point_from_loc(scene, x, v, i, &epoint);
-			BKE_effectors_apply(effectors, NULL, clmd->sim_parms->effector_weights, &epoint, winvec[i], NULL);
+		for (i = 0; i < cloth->mvert_num; i++) {
+			BPH_mass_spring_get_motion_state(data, i, eff_x[i], eff_v[i]);
+			pd_point_from_loc(scene, eff_x[i], eff_v[i], i, &epoints[i]);
 		}
 
+		BKE_effectors_apply_array(effectors, NULL, clmd->sim_parms->effector_weights, epoints, mvert_num, winvec, NULL);
+
+		MEM_freeN(epoints);
+		MEM_freeN(eff_x);
+		MEM_freeN(eff_v);
+
 		for (i = 0; i < cloth->tri_num; i++) {
 			const MVertTri *vt = &tri[i];
 			BPH_mass_spring_force_face_wind(data, vt->tri[0], vt->tri[1], vt->tri[2], winvec);
@@ -1000,6 +1006,10 @@ int BPH_cloth_solve(Depsgraph *depsgraph, Object *ob, float frame, ClothModifier
 		}
 	}
 
+	BPH_mass_spring_solver_set_preconditioner(
+	        id, (clmd->sim_parms->flags & CLOTH_SIMSETTINGS_FLAG_SOLVER_PRECONDITION) ?
+	        BPH_PRECONDITIONER_BLOCK_JACOBI : BPH_PRECONDITIONER_NONE);
+
 	while (step < tf) {
 		ImplicitSolverResult result;
 
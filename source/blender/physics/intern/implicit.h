@@ -68,6 +68,11 @@ typedef struct ImplicitSolverResult {
 	float error;
 } ImplicitSolverResult;
 
+typedef enum eImplicitPreconditioner {
+	BPH_PRECONDITIONER_NONE         = 0,
+	BPH_PRECONDITIONER_BLOCK_JACOBI = 1, /* inverse of the 3x3 diagonal blocks */
+} eImplicitPreconditioner;
+
 BLI_INLINE void implicit_print_matrix_elem(float v)
 {
 	printf("%-8.3f", v);
@@ -93,6 +98,8 @@ void BPH_mass_spring_add_constraint_ndof0(struct Implicit_Data *data, int index,
 void BPH_mass_spring_add_constraint_ndof1(struct Implicit_Data *data, int index, const float c1[3], const float c2[3], const float dV[3]);
 void BPH_mass_spring_add_constraint_ndof2(struct Implicit_Data *data, int index, const float c1[3], const float dV[3]);
 
+/* eImplicitPreconditioner, used by the conjugate gradient solver of the following steps */
+void BPH_mass_spring_solver_set_preconditioner(struct Implicit_Data *data, int preconditioner);
 bool BPH_mass_spring_solve_velocities(struct Implicit_Data *data, float dt, struct ImplicitSolverResult *result);
 bool BPH_mass_spring_solve_positions(struct Implicit_Data *data, float dt);
 void BPH_mass_spring_apply_result(struct Implicit_Data *data);
@@ -42,6 +42,7 @@
 #include "DNA_texture_types.h"
 
 #include "BLI_math.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_cloth.h"
@@ -641,6 +642,200 @@ DO_INLINE void subadd_bfmatrixS_bfmatrixS(fmatrix3x3 *to, fmatrix3x3 *from, floa
 
 }
 
+///////////////////////////
+// BLOCKED SPARSE ROW big matrix with 3x3 matrix entries
+///////////////////////////
+
+/* Number of vertices handled by one task of the parallel solver kernels. Each chunk writes
+ * its own partial dot product and those are summed in order, so the result of the solver
+ * does not depend on the number of threads. */
+#define CLOTH_SOLVER_CHUNK_SIZE 1024
+
+/* entry holds the transposed block of the big matrix */
+#define BSR_TRANSPOSED (1u << 31)
+
+/* Row-wise copy of a SPARSE SYMMETRIC big matrix, for the conjugate gradient loop.
+ * Every row has the diagonal block and both halves of its off-diagonal blocks, so rows
+ * can be multiplied in parallel without writing to the same vector elements. */
+typedef struct BSRMatrix {
+	unsigned int vcount, scount;    /* vertex and spring count of the big matrix */
+	unsigned int *row_start;        /* first entry of every row, vcount + 1 */
+	unsigned int *col;              /* column of every entry */
+	unsigned int *src;              /* big matrix block of every entry, with BSR_TRANSPOSED */
+	unsigned int (*src_rc)[2];      /* row and column of the off-diagonal blocks of the layout */
+	float (*m)[3][3];               /* entry values, contiguous per row */
+} BSRMatrix;
+
+DO_INLINE BSRMatrix *create_bsrmatrix(void)
+{
+	return (BSRMatrix *)MEM_callocN(sizeof(BSRMatrix), "cloth_implicit_alloc_bsr");
+}
+
+static void bsrmatrix_free_layout(BSRMatrix *bsr)
+{
+	MEM_SAFE_FREE(bsr->row_start);
+	MEM_SAFE_FREE(bsr->col);
+	MEM_SAFE_FREE(bsr->src);
+	MEM_SAFE_FREE(bsr->src_rc);
+	MEM_SAFE_FREE(bsr->m);
+}
+
+DO_INLINE void del_bsrmatrix(BSRMatrix *bsr)
+{
+	if (bsr != NULL) {
+		bsrmatrix_free_layout(bsr);
+		MEM_freeN(bsr);
+	}
+}
+
+/* springs are added in the same order every step, so the layout can usually be reused */
+static bool bsrmatrix_layout_matches(const BSRMatrix *bsr, const fmatrix3x3 *from, unsigned int scount)
+{
+	unsigned int i, vcount = from[0].vcount;
+
+	if (bsr->row_start == NULL || bsr->vcount != vcount || bsr->scount != scount) {
+		return false;
+	}
+
+	for (i = 0; i < scount; i++) {
+		if (bsr->src_rc[i][0] != from[vcount + i].r || bsr->src_rc[i][1] != from[vcount + i].c) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void bsrmatrix_build_layout(BSRMatrix *bsr, const fmatrix3x3 *from, unsigned int scount)
+{
+	unsigned int vcount = from[0].vcount;
+	unsigned int totentry = vcount + 2 * scount;
+	unsigned int *fill;
+	unsigned int i;
+
+	bsrmatrix_free_layout(bsr);
+
+	bsr->vcount = vcount;
+	bsr->scount = scount;
+	bsr->row_start = MEM_callocN(sizeof(*bsr->row_start) * (vcount + 1), "bsr row_start");
+	bsr->col = MEM_mallocN(sizeof(*bsr->col) * totentry, "bsr col");
+	bsr->src = MEM_mallocN(sizeof(*bsr->src) * totentry, "bsr src");
+	bsr->src_rc = MEM_mallocN(sizeof(*bsr->src_rc) * max_ii(scount, 1), "bsr src_rc");
+	bsr->m = MEM_mallocN(sizeof(*bsr->m) * totentry, "bsr m");
+
+	/* count entries per row: the diagonal and both halves of the off-diagonal blocks */
+	for (i = 0; i < vcount; i++) {
+		bsr->row_start[i + 1] = 1;
+	}
+	for (i = vcount; i < vcount + scount; i++) {
+		bsr->row_start[from[i].r + 1]++;
+		bsr->row_start[from[i].c + 1]++;
+		bsr->src_rc[i - vcount][0] = from[i].r;
+		bsr->src_rc[i - vcount][1] = from[i].c;
+	}
+	for (i = 0; i < vcount; i++) {
+		bsr->row_start[i + 1] += bsr->row_start[i];
+	}
+
+	/* diagonal block first, then the springs in order, so rows always sum the same way */
+	fill = MEM_mallocN(sizeof(*fill) * max_ii(vcount, 1), "bsr fill");
+	for (i = 0; i < vcount; i++) {
+		fill[i] = bsr->row_start[i];
+		bsr->col[fill[i]] = i;
+		bsr->src[fill[i]] = i;
+		fill[i]++;
+	}
+	for (i = vcount; i < vcount + scount; i++) {
+		/* the stored block is the lower triangle, multiplied transposed for column c */
+		bsr->col[fill[from[i].r]] = from[i].c;
+		bsr->src[fill[from[i].r]++] = i;
+		bsr->col[fill[from[i].c]] = from[i].r;
+		bsr->src[fill[from[i].c]++] = i | BSR_TRANSPOSED;
+	}
+	MEM_freeN(fill);
+}
+
+typedef struct BSRUpdateData {
+	BSRMatrix *bsr;
+	const fmatrix3x3 *from;
+} BSRUpdateData;
+
+static void bsrmatrix_update_cb(void *__restrict userdata, const int chunk, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	BSRUpdateData *data = userdata;
+	BSRMatrix *bsr = data->bsr;
+	const unsigned int row_end = min_ii((chunk + 1) * CLOTH_SOLVER_CHUNK_SIZE, bsr->vcount);
+	unsigned int e;
+
+	for (e = bsr->row_start[chunk * CLOTH_SOLVER_CHUNK_SIZE]; e < bsr->row_start[row_end]; e++) {
+		const unsigned int src = bsr->src[e];
+
+		if (src & BSR_TRANSPOSED) {
+			transpose_m3_m3(bsr->m[e], data->from[src & ~BSR_TRANSPOSED].m);
+		}
+		else {
+			copy_m3_m3(bsr->m[e], data->from[src].m);
+		}
+	}
+}
+
+BLI_INLINE int cloth_solver_num_chunks(unsigned int vcount)
+{
+	return (vcount + CLOTH_SOLVER_CHUNK_SIZE - 1) / CLOTH_SOLVER_CHUNK_SIZE;
+}
+
+BLI_INLINE void cloth_solver_parallel_range(unsigned int vcount, void *userdata, TaskParallelRangeFunc func)
+{
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (vcount > CLOTH_SOLVER_CHUNK_SIZE);
+	BLI_task_parallel_range(0, cloth_solver_num_chunks(vcount), userdata, func, &settings);
+}
+
+/* copy the block values of a big matrix, the layout is only rebuilt when the springs changed */
+static void bsrmatrix_update(BSRMatrix *bsr, const fmatrix3x3 *from, unsigned int scount)
+{
+	BSRUpdateData data = {bsr, from};
+
+	if (!bsrmatrix_layout_matches(bsr, from, scount)) {
+		bsrmatrix_build_layout(bsr, from, scount);
+	}
+
+	cloth_solver_parallel_range(bsr->vcount, &data, bsrmatrix_update_cb);
+}
+
+/* one row of the matrix multiplied with a long vector */
+BLI_INLINE void bsrmatrix_mul_row(float to[3], const BSRMatrix *bsr, unsigned int row, lfVector *fLongVector)
+{
+	float sum[3] = {0.0f, 0.0f, 0.0f};
+	unsigned int e;
+
+	for (e = bsr->row_start[row]; e < bsr->row_start[row + 1]; e++) {
+		const float(*m)[3] = bsr->m[e];
+		const float *v = fLongVector[bsr->col[e]];
+
+		sum[0] += m[0][0] * v[0] + m[0][1] * v[1] + m[0][2] * v[2];
+		sum[1] += m[1][0] * v[0] + m[1][1] * v[1] + m[1][2] * v[2];
+		sum[2] += m[2][0] * v[0] + m[2][1] * v[1] + m[2][2] * v[2];
+	}
+
+	copy_v3_v3(to, sum);
+}
+
+/* sum of the per chunk partial results, in chunk order */
+static float cloth_solver_sum_partials(const float *partial, unsigned int vcount)
+{
+	const int num_chunks = cloth_solver_num_chunks(vcount);
+	double sum = 0.0;
+	int i;
+
+	for (i = 0; i < num_chunks; i++) {
+		sum += partial[i];
+	}
+
+	return (float)sum;
+}
+
 ///////////////////////////////////////////////////////////////////
 // simulator start
 ///////////////////////////////////////////////////////////////////
@@ -666,6 +861,8 @@ typedef struct Implicit_Data {
 	lfVector *z;                /* target velocity in constrained directions */
 	fmatrix3x3 *S;              /* filtering matrix for constraints */
 	fmatrix3x3 *P, *Pinv;       /* pre-conditioning matrix */
+	BSRMatrix *bsrA;            /* row-wise copy of A for the conjugate gradient loop */
+	int preconditioner;         /* eImplicitPreconditioner */
 } Implicit_Data;
 
 Implicit_Data *BPH_mass_spring_solver_create(int numverts, int numsprings)
@@ -690,6 +887,7 @@ Implicit_Data *BPH_mass_spring_solver_create(int numverts, int numsprings)
 	id->B = create_lfvector(numverts);
 	id->dV = create_lfvector(numverts);
 	id->z = create_lfvector(numverts);
+	id->bsrA = create_bsrmatrix();
 
 	initdiag_bfmatrix(id->bigI, I);
 
@@ -716,10 +914,16 @@ void BPH_mass_spring_solver_free(Implicit_Data *id)
 	del_lfvector(id->B);
 	del_lfvector(id->dV);
 	del_lfvector(id->z);
+	del_bsrmatrix(id->bsrA);
 
 	MEM_freeN(id);
 }
 
+void BPH_mass_spring_solver_set_preconditioner(Implicit_Data *id, int preconditioner)
+{
+	id->preconditioner = preconditioner;
+}
+
 /* ==== Transformation from/to root reference frames ==== */
 
 BLI_INLINE void world_to_root_v3(Implicit_Data *data, int index, float r[3], const float v[3])
@@ -824,44 +1028,156 @@ static int  cg_filtered(lfVector *ldV, fmatrix3x3 *lA, lfVector *lB, lfVector *z
 }
 #endif
 
-static int cg_filtered(lfVector *ldV, fmatrix3x3 *lA, lfVector *lB, lfVector *z, fmatrix3x3 *S, ImplicitSolverResult *result)
+typedef struct CGSolverData {
+	const BSRMatrix *A;
+	fmatrix3x3 *S;
+	fmatrix3x3 *Pinv;           /* block-Jacobi preconditioner, NULL for none */
+	lfVector *B, *dV, *r, *c, *q, *s;
+	float alpha, beta;
+	float *partial, *partial_bnorm;
+} CGSolverData;
+
+BLI_INLINE void cg_precondition(float to[3], const CGSolverData *data, int i, const float r[3])
+{
+	if (data->Pinv) {
+		float (*m)[3] = data->Pinv[i].m;
+		to[0] = dot_v3v3(m[0], r);
+		to[1] = dot_v3v3(m[1], r);
+		to[2] = dot_v3v3(m[2], r);
+	}
+	else {
+		copy_v3_v3(to, r);
+	}
+}
+
+/* fB = filter(B), r = filter(B - A * dV), c = filter(P^-1 * r), returns fB^T * P^-1 * fB */
+static void cg_init_cb(void *__restrict userdata, const int chunk, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	CGSolverData *data = userdata;
+	const int start = chunk * CLOTH_SOLVER_CHUNK_SIZE;
+	const int end = min_ii(start + CLOTH_SOLVER_CHUNK_SIZE, data->A->vcount);
+	float bnorm2 = 0.0f, delta = 0.0f;
+	int i;
+
+	for (i = start; i < end; i++) {
+		float fB[3], PfB[3], AdV[3];
+
+		copy_v3_v3(fB, data->B[i]);
+		mul_m3_v3(data->S[i].m, fB);
+		/* same norm as delta, so the stopping test doesn't depend on the preconditioner's scale */
+		cg_precondition(PfB, data, i, fB);
+		bnorm2 += dot_v3v3(fB, PfB);
+
+		bsrmatrix_mul_row(AdV, data->A, i, data->dV);
+		sub_v3_v3v3(data->r[i], data->B[i], AdV);
+		mul_m3_v3(data->S[i].m, data->r[i]);
+
+		cg_precondition(data->c[i], data, i, data->r[i]);
+		mul_m3_v3(data->S[i].m, data->c[i]);
+		delta += dot_v3v3(data->r[i], data->c[i]);
+	}
+
+	data->partial_bnorm[chunk] = bnorm2;
+	data->partial[chunk] = delta;
+}
+
+/* q = filter(A * c), returns c^T * q */
+static void cg_mul_cb(void *__restrict userdata, const int chunk, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	CGSolverData *data = userdata;
+	const int start = chunk * CLOTH_SOLVER_CHUNK_SIZE;
+	const int end = min_ii(start + CLOTH_SOLVER_CHUNK_SIZE, data->A->vcount);
+	float dot = 0.0f;
+	int i;
+
+	for (i = start; i < end; i++) {
+		bsrmatrix_mul_row(data->q[i], data->A, i, data->c);
+		mul_m3_v3(data->S[i].m, data->q[i]);
+		dot += dot_v3v3(data->c[i], data->q[i]);
+	}
+
+	data->partial[chunk] = dot;
+}
+
+/* dV += alpha * c, r -= alpha * q, s = P^-1 * r, returns r^T * s */
+static void cg_update_cb(void *__restrict userdata, const int chunk, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	CGSolverData *data = userdata;
+	const int start = chunk * CLOTH_SOLVER_CHUNK_SIZE;
+	const int end = min_ii(start + CLOTH_SOLVER_CHUNK_SIZE, data->A->vcount);
+	float dot = 0.0f;
+	int i;
+
+	for (i = start; i < end; i++) {
+		madd_v3_v3fl(data->dV[i], data->c[i], data->alpha);
+		madd_v3_v3fl(data->r[i], data->q[i], -data->alpha);
+		cg_precondition(data->s[i], data, i, data->r[i]);
+		dot += dot_v3v3(data->r[i], data->s[i]);
+	}
+
+	data->partial[chunk] = dot;
+}
+
+/* c = filter(s + beta * c) */
+static void cg_direction_cb(void *__restrict userdata, const int chunk, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	CGSolverData *data = userdata;
+	const int start = chunk * CLOTH_SOLVER_CHUNK_SIZE;
+	const int end = min_ii(start + CLOTH_SOLVER_CHUNK_SIZE, data->A->vcount);
+	int i;
+
+	for (i = start; i < end; i++) {
+		VECADDS(data->c[i], data->s[i], data->c[i], data->beta);
+		mul_m3_v3(data->S[i].m, data->c[i]);
+	}
+}
+
+/* block-Jacobi preconditioner: inverse of the diagonal blocks of A */
+static void cg_build_block_jacobi(fmatrix3x3 *Pinv, const fmatrix3x3 *lA)
+{
+	unsigned int i;
+
+	for (i = 0; i < lA[0].vcount; i++) {
+		if (!invert_m3_m3(Pinv[i].m, lA[i].m)) {
+			unit_m3(Pinv[i].m);
+		}
+	}
+}
+
+static int cg_filtered(lfVector *ldV, BSRMatrix *lA, lfVector *lB, lfVector *z, fmatrix3x3 *S, fmatrix3x3 *Pinv, ImplicitSolverResult *result)
 {
 	// Solves for unknown X in equation AX=B
 	unsigned int conjgrad_loopcount = 0, conjgrad_looplimit = 100;
 	float conjgrad_epsilon = 0.01f;
 
-	unsigned int numverts = lA[0].vcount;
-	lfVector *fB = create_lfvector(numverts);
-	lfVector *AdV = create_lfvector(numverts);
-	lfVector *r = create_lfvector(numverts);
-	lfVector *c = create_lfvector(numverts);
-	lfVector *q = create_lfvector(numverts);
-	lfVector *s = create_lfvector(numverts);
-	float bnorm2, delta_new, delta_old, delta_target, alpha;
+	unsigned int numverts = lA->vcount;
+	const int num_chunks = cloth_solver_num_chunks(numverts);
+	CGSolverData data = {NULL};
+	float bnorm2, delta_new, delta_old, delta_target;
+
+	data.A = lA;
+	data.S = S;
+	data.Pinv = Pinv;
+	data.B = lB;
+	data.dV = ldV;
+	data.r = create_lfvector(numverts);
+	data.c = create_lfvector(numverts);
+	data.q = create_lfvector(numverts);
+	data.s = create_lfvector(numverts);
+	data.partial = MEM_mallocN(sizeof(float) * max_ii(num_chunks, 1), "cloth_implicit_partial");
+	data.partial_bnorm = MEM_mallocN(sizeof(float) * max_ii(num_chunks, 1), "cloth_implicit_partial_bnorm");
 
 	cp_lfvector(ldV, z, numverts);
 
-	/* d0 = filter(B)^T * P * filter(B) */
-	cp_lfvector(fB, lB, numverts);
-	filter(fB, S);
-	bnorm2 = dot_lfvector(fB, fB, numverts);
+	/* d0 = filter(B)^T * P^-1 * filter(B), r = filter(B - A * dV), c = filter(P^-1 * r) */
+	cloth_solver_parallel_range(numverts, &data, cg_init_cb);
+	bnorm2 = cloth_solver_sum_partials(data.partial_bnorm, numverts);
 	delta_target = conjgrad_epsilon * conjgrad_epsilon * bnorm2;
 
-	/* r = filter(B - A * dV) */
-	mul_bfmatrix_lfvector(AdV, lA, ldV);
-	sub_lfvector_lfvector(r, lB, AdV, numverts);
-	filter(r, S);
-
-	/* c = filter(P^-1 * r) */
-	cp_lfvector(c, r, numverts);
-	filter(c, S);
-
 	/* delta = r^T * c */
-	delta_new = dot_lfvector(r, c, numverts);
+	delta_new = cloth_solver_sum_partials(data.partial, numverts);
 
 #ifdef IMPLICIT_PRINT_SOLVER_INPUT_OUTPUT
-	printf("==== A ====\n");
-	print_bfmatrix(lA);
 	printf("==== z ====\n");
 	print_lvector(z, numverts);
 	printf("==== B ====\n");
@@ -871,22 +1187,20 @@ static int cg_filtered(lfVector *ldV, fmatrix3x3 *lA, lfVector *lB, lfVector *z,
 #endif
 
 	while (delta_new > delta_target && conjgrad_loopcount < conjgrad_looplimit) {
-		mul_bfmatrix_lfvector(q, lA, c);
-		filter(q, S);
-
-		alpha = delta_new / dot_lfvector(c, q, numverts);
+		/* q = filter(A * c) */
+		cloth_solver_parallel_range(numverts, &data, cg_mul_cb);
 
-		add_lfvector_lfvectorS(ldV, ldV, c, alpha, numverts);
+		data.alpha = delta_new / cloth_solver_sum_partials(data.partial, numverts);
 
-		add_lfvector_lfvectorS(r, r, q, -alpha, numverts);
+		/* dV += alpha * c, r -= alpha * q, s = P^-1 * r */
+		cloth_solver_parallel_range(numverts, &data, cg_update_cb);
 
-		/* s = P^-1 * r */
-		cp_lfvector(s, r, numverts);
 		delta_old = delta_new;
-		delta_new = dot_lfvector(r, s, numverts);
+		delta_new = cloth_solver_sum_partials(data.partial, numverts);
 
-		add_lfvector_lfvectorS(c, s, c, delta_new / delta_old, numverts);
-		filter(c, S);
+		/* c = filter(s + c * delta_new / delta_old) */
+		data.beta = delta_new / delta_old;
+		cloth_solver_parallel_range(numverts, &data, cg_direction_cb);
 
 		conjgrad_loopcount++;
 	}
@@ -897,16 +1211,17 @@ static int cg_filtered(lfVector *ldV, fmatrix3x3 *lA, lfVector *lB, lfVector *z,
 	printf("========\n");
 #endif
 
-	del_lfvector(fB);
-	del_lfvector(AdV);
-	del_lfvector(r);
-	del_lfvector(c);
-	del_lfvector(q);
-	del_lfvector(s);
+	del_lfvector(data.r);
+	del_lfvector(data.c);
+	del_lfvector(data.q);
+	del_lfvector(data.s);
+	MEM_freeN(data.partial);
+	MEM_freeN(data.partial_bnorm);
 	// printf("W/O conjgrad_loopcount: %d\n", conjgrad_loopcount);
 
 	result->status = conjgrad_loopcount < conjgrad_looplimit ? BPH_SOLVER_SUCCESS : BPH_SOLVER_NO_CONVERGENCE;
 	result->iterations = conjgrad_loopcount;
+	/* relative residual in the norm of the stopping test */
 	result->error = bnorm2 > 0.0f ? sqrtf(delta_new / bnorm2) : 0.0f;
 
 	return conjgrad_loopcount < conjgrad_looplimit;  // true means we reached desired accuracy in given time - ie stable
@@ -1129,7 +1444,16 @@ bool BPH_mass_spring_solve_velocities(Implicit_Data *data, float dt, ImplicitSol
 	double start = PIL_check_seconds_timer();
 #endif
 
-	cg_filtered(data->dV, data->A, data->B, data->z, data->S, result); /* conjugate gradient algorithm to solve Ax=b */
+	/* the solver loop multiplies rows of A in parallel */
+	bsrmatrix_update(data->bsrA, data->A, data->num_blocks);
+
+	if (data->preconditioner == BPH_PRECONDITIONER_BLOCK_JACOBI) {
+		cg_build_block_jacobi(data->Pinv, data->A);
+	}
+
+	/* conjugate gradient algorithm to solve Ax=b */
+	cg_filtered(data->dV, data->bsrA, data->B, data->z, data->S,
+	            (data->preconditioner == BPH_PRECONDITIONER_BLOCK_JACOBI) ? data->Pinv : NULL, result);
 	// cg_filtered_pre(id->dV, id->A, id->B, id->z, id->S, id->P, id->Pinv, id->bigI);
 
 #ifdef DEBUG_TIME
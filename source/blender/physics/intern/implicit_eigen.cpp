@@ -466,6 +466,11 @@ int BPH_mass_spring_solver_numvert(Implicit_Data *id)
 		return 0;
 }
 
+void BPH_mass_spring_solver_set_preconditioner(Implicit_Data *UNUSED(id), int UNUSED(preconditioner))
+{
+	/* the Eigen solver uses its own diagonal preconditioner */
+}
+
 /* ==== Transformation from/to root reference frames ==== */
 
 BLI_INLINE void world_to_root_v3(Implicit_Data *data, int index, float r[3], const float v[3])
@@ -159,6 +159,9 @@ typedef struct RenderResult {
 	/* optional saved endresult on disk */
 	int do_exr_tile;
 
+	/* multilayer output file written tile by tile, in place of the temp files */
+	void *stream_exrhandle;
+
 	/* for render results in Image, verify validity for sequences */
 	int framenr;
 
@@ -155,6 +155,10 @@ struct Render {
 	void **movie_ctx_arr;
 	char viewname[MAX_NAME];
 
+	/* output file to stream tiles into while rendering, see R_EXR_STREAM_FILE */
+	char stream_filepath[1024]; /* FILE_MAX */
+	bool stream_written;
+
 	/* TODO replace by a whole draw manager. */
 	void *gl_context;
 	void *gpu_context;
@@ -1972,6 +1972,34 @@ void RE_SetReports(Render *re, ReportList *reports)
 }
 
 /* general Blender frame render call */
+/* Whether tiles can be written into the output file while rendering, that is
+ * when the file written afterwards would only hold the render layers as they are. */
+static bool render_stream_output_possible(Scene *scene)
+{
+	RenderData *rd = &scene->r;
+
+	if ((rd->scemode & (R_EXR_STREAM_FILE | R_EXR_TILE_FILE)) != (R_EXR_STREAM_FILE | R_EXR_TILE_FILE))
+		return false;
+	if (rd->im_format.imtype != R_IMF_IMTYPE_MULTILAYER || (rd->im_format.flag & R_IMF_FLAG_PREVIEW_JPG))
+		return false;
+	if ((rd->scemode & R_MULTIVIEW) && rd->im_format.views_format != R_IMF_VIEWS_MULTIVIEW)
+		return false;
+	if ((rd->scemode & R_DOCOMP) && scene->use_nodes && scene->nodetree)
+		return false;
+	if (RE_seq_render_active(scene, rd))
+		return false;
+	if ((rd->stamp & R_STAMP_ALL) && (rd->stamp & R_STAMP_DRAW))
+		return false;
+	if ((rd->mode & R_BORDER) && !(rd->mode & R_CROP))
+		return false;
+#ifdef WITH_FREESTYLE
+	if (rd->mode & R_EDGE_FRS)
+		return false;
+#endif
+
+	return true;
+}
+
 void RE_BlenderFrame(Render *re, Main *bmain, Scene *scene, ViewLayer *single_layer, Object *camera_override,
                      int frame, const bool write_still)
 {
@@ -1989,6 +2017,12 @@ void RE_BlenderFrame(Render *re, Main *bmain, Scene *scene, ViewLayer *single_la
 
 		BLI_callback_exec(re->main, (ID *)scene, BLI_CB_EVT_RENDER_PRE);
 
+		if (write_still && render_stream_output_possible(scene)) {
+			BKE_image_path_from_imformat(
+			        re->stream_filepath, scene->r.pic, BKE_main_blendfile_path(bmain), scene->r.cfra,
+			        &scene->r.im_format, (scene->r.scemode & R_EXTENSION) != 0, false, NULL);
+		}
+
 		do_render_all_options(re);
 
 		if (write_still && !G.is_break) {
@@ -2007,6 +2041,9 @@ void RE_BlenderFrame(Render *re, Main *bmain, Scene *scene, ViewLayer *single_la
 			}
 		}
 
+		re->stream_filepath[0] = '\0';
+		re->stream_written = false;
+
 		BLI_callback_exec(re->main, (ID *)scene, BLI_CB_EVT_RENDER_POST); /* keep after file save */
 		if (write_still) {
 			BLI_callback_exec(re->main, (ID *)scene, BLI_CB_EVT_RENDER_WRITE);
@@ -2242,8 +2279,14 @@ static int do_write_image_or_movie(Render *re, Main *bmain, Scene *scene, bMovie
 			        name, scene->r.pic, BKE_main_blendfile_path(bmain), scene->r.cfra,
 			        &scene->r.im_format, (scene->r.scemode & R_EXTENSION) != 0, true, NULL);
 
-		/* write images as individual images or stereo */
-		ok = RE_WriteRenderViewsImage(re->reports, &rres, scene, true, name);
+		if (re->stream_written && STREQ(name, re->stream_filepath)) {
+			/* tiles were already written into the file while rendering */
+			render_print_save_message(re->reports, name, true, 0);
+		}
+		else {
+			/* write images as individual images or stereo */
+			ok = RE_WriteRenderViewsImage(re->reports, &rres, scene, true, name);
+		}
 	}
 
 	RE_ReleaseResultImageViews(re, &rres);
@@ -2486,6 +2529,11 @@ void RE_BlenderAnim(Render *re, Main *bmain, Scene *scene, ViewLayer *single_lay
 			/* run callbacs before rendering, before the scene is updated */
 			BLI_callback_exec(re->main, (ID *)scene, BLI_CB_EVT_RENDER_PRE);
 
+			if (is_movie == false && render_stream_output_possible(scene)) {
+				BKE_image_path_from_imformat(
+				        re->stream_filepath, scene->r.pic, BKE_main_blendfile_path(bmain), scene->r.cfra,
+				        &scene->r.im_format, (scene->r.scemode & R_EXTENSION) != 0, true, NULL);
+			}
 
 			do_render_all_options(re);
 			totrendered++;
@@ -2498,6 +2546,9 @@ void RE_BlenderAnim(Render *re, Main *bmain, Scene *scene, ViewLayer *single_lay
 			else
 				G.is_break = true;
 
+			re->stream_filepath[0] = '\0';
+			re->stream_written = false;
+
 			if (G.is_break == true) {
 				/* remove touched file */
 				if (is_movie == false) {
@@ -37,6 +37,7 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_utildefines.h"
+#include "BLI_fileops.h"
 #include "BLI_listbase.h"
 #include "BLI_hash_md5.h"
 #include "BLI_path_util.h"
@@ -672,7 +673,8 @@ RenderResult *render_result_new_from_exr(void *exrhandle, const char *colorspace
 			rpass->rectx = rectx;
 			rpass->recty = recty;
 
-			if (rpass->channels >= 3) {
+			/* passes of a layout-only read have no pixels yet, see #image_multilayer_pass_ensure */
+			if (rpass->rect && rpass->channels >= 3) {
 				IMB_colormanagement_transform(rpass->rect, rpass->rectx, rpass->recty, rpass->channels,
 				                              colorspace, to_colorspace, predivide);
 			}
@@ -993,7 +995,7 @@ static void save_render_result_tile(RenderResult *rr, RenderResult *rrpart, cons
 {
 	RenderLayer *rlp, *rl;
 	RenderPass *rpassp;
-	int offs, partx, party;
+	int offs, partx, party, partw, parth;
 
 	BLI_thread_lock(LOCK_IMAGE);
 
@@ -1022,7 +1024,7 @@ static void save_render_result_tile(RenderResult *rr, RenderResult *rrpart, cons
 			for (a = 0; a < xstride; a++) {
 				set_pass_full_name(fullname, rpassp->name, a, viewname, rpassp->chan_id);
 
-				IMB_exr_set_channel(rl->exrhandle, rlp->name, fullname,
+				IMB_exr_set_channel((rr->stream_exrhandle) ? rr->stream_exrhandle : rl->exrhandle, rlp->name, fullname,
 				                    xstride, xstride * rrpart->rectx, rpassp->rect + a + xstride * offs);
 			}
 		}
@@ -1031,17 +1033,25 @@ static void save_render_result_tile(RenderResult *rr, RenderResult *rrpart, cons
 
 	party = rrpart->tilerect.ymin + rrpart->crop;
 	partx = rrpart->tilerect.xmin + rrpart->crop;
+	parth = rrpart->recty - 2 * rrpart->crop;
+	partw = rrpart->rectx - 2 * rrpart->crop;
 
-	for (rlp = rrpart->layers.first; rlp; rlp = rlp->next) {
-		rl = RE_GetRenderLayer(rr, rlp->name);
+	if (rr->stream_exrhandle) {
+		/* all layers go into the output file at once */
+		IMB_exrtile_write_channels(rr->stream_exrhandle, partx, party, partw, parth, 0, viewname, false);
+	}
+	else {
+		for (rlp = rrpart->layers.first; rlp; rlp = rlp->next) {
+			rl = RE_GetRenderLayer(rr, rlp->name);
 
-		/* should never happen but prevents crash if it does */
-		BLI_assert(rl);
-		if (UNLIKELY(rl == NULL)) {
-			continue;
-		}
+			/* should never happen but prevents crash if it does */
+			BLI_assert(rl);
+			if (UNLIKELY(rl == NULL)) {
+				continue;
+			}
 
-		IMB_exrtile_write_channels(rl->exrhandle, partx, party, 0, viewname, false);
+			IMB_exrtile_write_channels(rl->exrhandle, partx, party, partw, parth, 0, viewname, false);
+		}
 	}
 
 	BLI_thread_unlock(LOCK_IMAGE);
@@ -1054,12 +1064,20 @@ void render_result_save_empty_result_tiles(Render *re)
 	RenderLayer *rl;
 
 	for (rr = re->result; rr; rr = rr->next) {
-		for (rl = rr->layers.first; rl; rl = rl->next) {
-			for (pa = re->parts.first; pa; pa = pa->next) {
-				if (pa->status != PART_STATUS_MERGED) {
-					int party = pa->disprect.ymin - re->disprect.ymin;
-					int partx = pa->disprect.xmin - re->disprect.xmin;
-					IMB_exrtile_write_channels(rl->exrhandle, partx, party, 0, re->viewname, true);
+		for (pa = re->parts.first; pa; pa = pa->next) {
+			if (pa->status != PART_STATUS_MERGED) {
+				int party = pa->disprect.ymin - re->disprect.ymin;
+				int partx = pa->disprect.xmin - re->disprect.xmin;
+				int parth = BLI_rcti_size_y(&pa->disprect);
+				int partw = BLI_rcti_size_x(&pa->disprect);
+
+				if (rr->stream_exrhandle) {
+					IMB_exrtile_write_channels(rr->stream_exrhandle, partx, party, partw, parth, 0, re->viewname, true);
+					continue;
+				}
+
+				for (rl = rr->layers.first; rl; rl = rl->next) {
+					IMB_exrtile_write_channels(rl->exrhandle, partx, party, partw, parth, 0, re->viewname, true);
 				}
 			}
 		}
@@ -1083,6 +1101,86 @@ static void render_result_create_all_passes(RenderEngine *engine, Render *re, Re
 	}
 }
 
+/* Tiles are streamed into a temporary file next to the output, it only replaces
+ * the output once the render is complete, so a cancelled render keeps an earlier result. */
+static void render_result_exr_stream_filepath_temp(const Render *re, char *r_filepath)
+{
+	BLI_snprintf(r_filepath, FILE_MAX, "%s@", re->stream_filepath);
+}
+
+/* Open the MultiLayer output file to write tiles into while rendering, in place
+ * of the temp files. Channels are added like RE_WriteRenderResult() does, and the
+ * file tiles subdivide the render tiles so they can be compressed in parallel.
+ * Only possible for a single render layer, since every file tile is written once. */
+static bool render_result_exr_stream_begin(Render *re, RenderResult *rr)
+{
+	ImageFormatData *imf = &re->r.im_format;
+	const bool half_float = (imf->depth == R_IMF_CHAN_DEPTH_16);
+	RenderView *rview;
+	RenderLayer *rl;
+	RenderPass *rp;
+	char filepath_temp[FILE_MAX];
+	int tilex = re->partx, tiley = re->party;
+
+	if (!BLI_listbase_is_single(&rr->layers)) {
+		return false;
+	}
+
+	rr->stream_exrhandle = IMB_exr_get_handle();
+
+	/* first add views since IMB_exr_add_channel checks number of views */
+	for (rview = rr->views.first; rview; rview = rview->next) {
+		IMB_exr_add_view(rr->stream_exrhandle, rview->name);
+	}
+
+	for (rl = rr->layers.first; rl; rl = rl->next) {
+		for (rp = rl->passes.first; rp; rp = rp->next) {
+			/* we only store RGBA passes as half float, see RE_WriteRenderResult() */
+			const bool pass_half_float = half_float &&
+			                             (STREQ(rp->chan_id, "RGB") ||
+			                              STREQ(rp->chan_id, "RGBA") ||
+			                              STREQ(rp->chan_id, "R") ||
+			                              STREQ(rp->chan_id, "G") ||
+			                              STREQ(rp->chan_id, "B") ||
+			                              STREQ(rp->chan_id, "A"));
+			int a;
+
+			for (a = 0; a < rp->channels; a++) {
+				char passname[EXR_PASS_MAXNAME];
+				IMB_exr_add_channel(rr->stream_exrhandle, rl->name, set_pass_name(passname, rp->name, a, rp->chan_id),
+				                    rp->view, 0, 0, NULL, pass_half_float);
+			}
+		}
+	}
+
+	BKE_render_result_stamp_info(re->scene, RE_GetCamera(re), rr, false);
+
+	while (tilex > 64 && (tilex % 2) == 0) {
+		tilex /= 2;
+	}
+	while (tiley > 64 && (tiley % 2) == 0) {
+		tiley /= 2;
+	}
+
+	render_result_exr_stream_filepath_temp(re, filepath_temp);
+	BLI_make_existing_file(filepath_temp);
+
+	printf("write exr output file, %dx%d, %s\n", rr->rectx, rr->recty, filepath_temp);
+	if (!IMB_exrtile_begin_write(rr->stream_exrhandle, filepath_temp, 0, rr->rectx, rr->recty,
+	                             tilex, tiley, imf->exr_codec, rr->stamp_data))
+	{
+		printf("cannot write: %s, using temp files\n", filepath_temp);
+		IMB_exr_close(rr->stream_exrhandle);
+		rr->stream_exrhandle = NULL;
+		if (BLI_exists(filepath_temp)) {
+			BLI_delete(filepath_temp, false, false);
+		}
+		return false;
+	}
+
+	return true;
+}
+
 /* begin write of exr tile file */
 void render_result_exr_file_begin(Render *re, RenderEngine *engine)
 {
@@ -1093,10 +1191,19 @@ void render_result_exr_file_begin(Render *re, RenderEngine *engine)
 	for (rr = re->result; rr; rr = rr->next) {
 		for (rl = rr->layers.first; rl; rl = rl->next) {
 			render_result_create_all_passes(engine, re, rl);
+		}
 
+		if (re->stream_filepath[0] && rr == re->result && rr->next == NULL) {
+			if (render_result_exr_stream_begin(re, rr)) {
+				continue;
+			}
+		}
+
+		for (rl = rr->layers.first; rl; rl = rl->next) {
 			render_result_exr_file_path(re->scene, rl->name, rr->sample_nr, str);
 			printf("write exr tmp file, %dx%d, %s\n", rr->rectx, rr->recty, str);
-			IMB_exrtile_begin_write(rl->exrhandle, str, 0, rr->rectx, rr->recty, re->partx, re->party);
+			IMB_exrtile_begin_write(rl->exrhandle, str, 0, rr->rectx, rr->recty, re->partx, re->party,
+			                        R_IMF_EXR_CODEC_RLE, NULL);
 		}
 	}
 }
@@ -1106,6 +1213,7 @@ void render_result_exr_file_end(Render *re, RenderEngine *engine)
 {
 	RenderResult *rr;
 	RenderLayer *rl;
+	bool streamed = false;
 
 	for (rr = re->result; rr; rr = rr->next) {
 		for (rl = rr->layers.first; rl; rl = rl->next) {
@@ -1113,13 +1221,51 @@ void render_result_exr_file_end(Render *re, RenderEngine *engine)
 			rl->exrhandle = NULL;
 		}
 
+		if (rr->stream_exrhandle) {
+			IMB_exr_close(rr->stream_exrhandle);
+			rr->stream_exrhandle = NULL;
+			streamed = true;
+		}
+
 		rr->do_exr_tile = false;
 	}
 
 	render_result_free_list(&re->fullresult, re->result);
 	re->result = NULL;
 
-	render_result_exr_file_read_sample(re, 0, engine);
+	if (streamed) {
+		char filepath_temp[FILE_MAX];
+
+		render_result_exr_stream_filepath_temp(re, filepath_temp);
+
+		/* the output file has the complete result, read it back for display and post-processing */
+		re->result = render_result_new(re, &re->disprect, 0, RR_USE_MEM, RR_ALL_LAYERS, RR_ALL_VIEWS);
+
+		for (rl = re->result->layers.first; rl; rl = rl->next) {
+			render_result_create_all_passes(engine, re, rl);
+		}
+
+		printf("read exr output file: %s\n", filepath_temp);
+		if (!render_result_exr_file_read_path(re->result, NULL, filepath_temp)) {
+			printf("cannot read: %s\n", filepath_temp);
+		}
+		else if (!re->test_break(re->tbh)) {
+			if (BLI_rename(filepath_temp, re->stream_filepath) == 0) {
+				re->stream_written = true;
+			}
+			else {
+				printf("cannot rename: %s to %s\n", filepath_temp, re->stream_filepath);
+			}
+		}
+
+		/* don't leave incomplete files behind, only the temporary file is ours to remove */
+		if (!re->stream_written) {
+			BLI_delete(filepath_temp, false, false);
+		}
+	}
+	else {
+		render_result_exr_file_read_sample(re, 0, engine);
+	}
 }
 
 /* save part into exr file */
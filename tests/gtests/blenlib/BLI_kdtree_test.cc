@@ -0,0 +1,166 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_compiler_attrs.h"
+#include "BLI_kdtree.h"
+#include "BLI_rand.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "MEM_guardedalloc.h"
+}
+
+/* -------------------------------------------------------------------- */
+/* Helper Functions */
+
+static KDTree *kdtree_from_coords(const float (*coords)[3], int coords_len)
+{
+	KDTree *tree = BLI_kdtree_new(coords_len);
+	for (int i = 0; i < coords_len; i++) {
+		BLI_kdtree_insert(tree, i, coords[i]);
+	}
+	BLI_kdtree_balance(tree);
+	return tree;
+}
+
+/**
+ * Points snapped to a coarse grid with small offsets, so many are in range of each other.
+ */
+static void kdtree_duplicates_parallel_compare(int coords_len, float range, int keep_step, unsigned int seed)
+{
+	float (*coords)[3] = (float (*)[3])MEM_mallocN(sizeof(*coords) * coords_len, __func__);
+	int *duplicates_fast = (int *)MEM_mallocN(sizeof(int) * coords_len, __func__);
+	int *duplicates_parallel = (int *)MEM_mallocN(sizeof(int) * coords_len, __func__);
+
+	RNG *rng = BLI_rng_new(seed);
+	for (int i = 0; i < coords_len; i++) {
+		for (int j = 0; j < 3; j++) {
+			coords[i][j] = (float)(BLI_rng_get_int(rng) % 16) + (BLI_rng_get_float(rng) * 0.01f);
+		}
+		duplicates_fast[i] = duplicates_parallel[i] = (keep_step && (i % keep_step) == 0) ? i : -1;
+	}
+	BLI_rng_free(rng);
+
+	KDTree *tree = kdtree_from_coords(coords, coords_len);
+	const int found_fast = BLI_kdtree_calc_duplicates_fast(tree, range, true, duplicates_fast);
+	const int found_parallel = BLI_kdtree_calc_duplicates_parallel(tree, range, duplicates_parallel);
+	BLI_kdtree_free(tree);
+
+	EXPECT_EQ(found_fast, found_parallel);
+	for (int i = 0; i < coords_len; i++) {
+		EXPECT_EQ(duplicates_fast[i], duplicates_parallel[i]);
+		/* no chains */
+		if (duplicates_parallel[i] != -1) {
+			EXPECT_EQ(duplicates_parallel[duplicates_parallel[i]], duplicates_parallel[i]);
+		}
+	}
+
+	MEM_freeN(coords);
+	MEM_freeN(duplicates_fast);
+	MEM_freeN(duplicates_parallel);
+}
+
+/**
+ * All points in range of each other, should all merge into the first.
+ */
+static void kdtree_duplicates_parallel_dense(int coords_len)
+{
+	float (*coords)[3] = (float (*)[3])MEM_mallocN(sizeof(*coords) * coords_len, __func__);
+	int *duplicates = (int *)MEM_mallocN(sizeof(int) * coords_len, __func__);
+	for (int i = 0; i < coords_len; i++) {
+		coords[i][0] = coords[i][1] = coords[i][2] = (i % 2) ? 1.0f : 1.0001f;
+		duplicates[i] = -1;
+	}
+
+	KDTree *tree = kdtree_from_coords(coords, coords_len);
+	EXPECT_EQ(coords_len - 1, BLI_kdtree_calc_duplicates_parallel(tree, 0.01f, duplicates));
+	BLI_kdtree_free(tree);
+
+	for (int i = 0; i < coords_len; i++) {
+		EXPECT_EQ(0, duplicates[i]);
+	}
+
+	MEM_freeN(coords);
+	MEM_freeN(duplicates);
+}
+
+/* -------------------------------------------------------------------- */
+/* Tests */
+
+TEST(kdtree, DuplicatesParallelEmpty)
+{
+	KDTree *tree = BLI_kdtree_new(0);
+	BLI_kdtree_balance(tree);
+	EXPECT_EQ(0, BLI_kdtree_calc_duplicates_parallel(tree, 0.1f, NULL));
+	BLI_kdtree_free(tree);
+}
+
+TEST(kdtree, DuplicatesParallelSimple)
+{
+	const float coords[4][3] = {
+		{0.0f, 0.0f, 0.0f},
+		{1.0f, 0.0f, 0.0f},
+		{0.0f, 0.0f, 0.0f},
+		{1.0f, 0.0f, 0.05f},
+	};
+	int duplicates[4] = {-1, -1, -1, -1};
+
+	KDTree *tree = kdtree_from_coords(coords, 4);
+	EXPECT_EQ(2, BLI_kdtree_calc_duplicates_parallel(tree, 0.1f, duplicates));
+	BLI_kdtree_free(tree);
+
+	EXPECT_EQ(0, duplicates[0]);
+	EXPECT_EQ(1, duplicates[1]);
+	EXPECT_EQ(0, duplicates[2]);
+	EXPECT_EQ(1, duplicates[3]);
+}
+
+TEST(kdtree, DuplicatesParallelZeroRange)
+{
+	const float coords[3][3] = {
+		{0.5f, 0.5f, 0.5f},
+		{0.5f, 0.5f, 0.5f},
+		{0.5f, 0.5f, 0.5f},
+	};
+	int duplicates[3] = {-1, -1, -1};
+
+	KDTree *tree = kdtree_from_coords(coords, 3);
+	EXPECT_EQ(2, BLI_kdtree_calc_duplicates_parallel(tree, 0.0f, duplicates));
+	BLI_kdtree_free(tree);
+
+	EXPECT_EQ(0, duplicates[0]);
+	EXPECT_EQ(0, duplicates[1]);
+	EXPECT_EQ(0, duplicates[2]);
+}
+
+TEST(kdtree, DuplicatesParallelUnbalancedDense)
+{
+	/* enough coincident points to use the serial search, on a tree that isn't balanced */
+	const int coords_len = 200;
+	int duplicates[coords_len];
+	KDTree *tree = BLI_kdtree_new(coords_len);
+	for (int i = 0; i < coords_len; i++) {
+		const float co[3] = {1.0f, 2.0f, 3.0f};
+		BLI_kdtree_insert(tree, i, co);
+		duplicates[i] = -1;
+	}
+
+	EXPECT_EQ(coords_len - 1, BLI_kdtree_calc_duplicates_parallel(tree, 0.01f, duplicates));
+	BLI_kdtree_free(tree);
+
+	for (int i = 0; i < coords_len; i++) {
+		EXPECT_EQ(0, duplicates[i]);
+	}
+}
+
+TEST(kdtree, DuplicatesParallelMatchFast)
+{
+	BLI_threadapi_init();
+	kdtree_duplicates_parallel_compare(10000, 0.005f, 0, 1);
+	kdtree_duplicates_parallel_compare(10000, 0.02f, 0, 2);
+	kdtree_duplicates_parallel_compare(10000, 0.02f, 7, 3);
+	/* all points in range of each other, uses the serial search */
+	kdtree_duplicates_parallel_dense(20000);
+	BLI_threadapi_exit();
+}
@@ -0,0 +1,140 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math_vector.h"
+#include "BLI_threads.h"
+#include "PIL_time_utildefines.h"
+
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+}
+
+/* Sizes similar to the callers: sequencer proxies (full HD), thumbnails and mipmaps of big textures. */
+#define PROXY_WIDTH 1920
+#define PROXY_HEIGHT 1080
+#define TEXTURE_SIZE 4096
+#define THUMB_SIZE 128
+
+/* threads and imbuf can only be initialized once per process */
+class ImbufScalingTest : public testing::Test
+{
+protected:
+	static void SetUpTestCase()
+	{
+		BLI_threadapi_init();
+		IMB_init();
+	}
+
+	static void TearDownTestCase()
+	{
+		IMB_exit();
+		BLI_threadapi_exit();
+	}
+};
+
+static ImBuf *scaling_test_ibuf(int width, int height, bool use_float)
+{
+	ImBuf *ibuf = IMB_allocImBuf(width, height, 32, use_float ? IB_rectfloat : IB_rect);
+
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			const size_t offset = ((size_t)y * width + x) * 4;
+			const float color[4] = {(float)x / width, (float)y / height, ((x ^ y) & 1) ? 1.0f : 0.0f, 1.0f};
+
+			if (use_float) {
+				copy_v4_v4(&ibuf->rect_float[offset], color);
+			}
+			else {
+				unsigned char *pixel = (unsigned char *)ibuf->rect + offset;
+				for (int i = 0; i < 4; i++) {
+					pixel[i] = (unsigned char)(color[i] * 255.0f);
+				}
+			}
+		}
+	}
+
+	return ibuf;
+}
+
+static void scaling_test_bench(const char *id, int width, int height, int newx, int newy, bool use_float)
+{
+	const eIMBScaleFilter filters[] = {IMB_SCALE_FILTER_BOX, IMB_SCALE_FILTER_BILINEAR, IMB_SCALE_FILTER_LANCZOS};
+	const char *filter_names[] = {"box", "bilinear", "lanczos"};
+
+	printf("\n========== %s (%dx%d -> %dx%d, %s) ==========\n",
+	       id, width, height, newx, newy, use_float ? "float" : "byte");
+
+	{
+		ImBuf *ibuf = scaling_test_ibuf(width, height, use_float);
+		TIMEIT_START(IMB_scaleImBuf);
+		IMB_scaleImBuf(ibuf, newx, newy);
+		TIMEIT_END(IMB_scaleImBuf);
+		IMB_freeImBuf(ibuf);
+	}
+	{
+		ImBuf *ibuf = scaling_test_ibuf(width, height, use_float);
+		TIMEIT_START(IMB_scalefastImBuf);
+		IMB_scalefastImBuf(ibuf, newx, newy);
+		TIMEIT_END(IMB_scalefastImBuf);
+		IMB_freeImBuf(ibuf);
+	}
+	for (int i = 0; i < ARRAY_SIZE(filters); i++) {
+		ImBuf *ibuf = scaling_test_ibuf(width, height, use_float);
+		printf("%s filter:\n", filter_names[i]);
+		TIMEIT_START(IMB_scaleImBuf_filter);
+		IMB_scaleImBuf_filter(ibuf, newx, newy, filters[i]);
+		TIMEIT_END(IMB_scaleImBuf_filter);
+		IMB_freeImBuf(ibuf);
+	}
+}
+
+TEST_F(ImbufScalingTest, SequencerProxy)
+{
+	scaling_test_bench("Proxy 25%", PROXY_WIDTH, PROXY_HEIGHT, PROXY_WIDTH / 4, PROXY_HEIGHT / 4, false);
+	scaling_test_bench("Proxy 50%", PROXY_WIDTH, PROXY_HEIGHT, PROXY_WIDTH / 2, PROXY_HEIGHT / 2, true);
+}
+
+TEST_F(ImbufScalingTest, SequencerUpscale)
+{
+	ImBuf *ibuf = scaling_test_ibuf(PROXY_WIDTH / 2, PROXY_HEIGHT / 2, false);
+	TIMEIT_START(IMB_scaleImBuf_threaded);
+	IMB_scaleImBuf_threaded(ibuf, PROXY_WIDTH, PROXY_HEIGHT);
+	TIMEIT_END(IMB_scaleImBuf_threaded);
+	IMB_freeImBuf(ibuf);
+
+	scaling_test_bench("Upscale", PROXY_WIDTH / 2, PROXY_HEIGHT / 2, PROXY_WIDTH, PROXY_HEIGHT, true);
+}
+
+TEST_F(ImbufScalingTest, Thumbnail)
+{
+	scaling_test_bench("Thumbnail", TEXTURE_SIZE, TEXTURE_SIZE, THUMB_SIZE, THUMB_SIZE, false);
+}
+
+TEST_F(ImbufScalingTest, Mipmaps)
+{
+	for (int use_float = 0; use_float < 2; use_float++) {
+		ImBuf *ibuf = scaling_test_ibuf(TEXTURE_SIZE, TEXTURE_SIZE, use_float);
+
+		printf("\n========== Mipmaps (%dx%d, %s) ==========\n", TEXTURE_SIZE, TEXTURE_SIZE, use_float ? "float" : "byte");
+		ImBuf *level = ibuf;
+		TIMEIT_START(IMB_onehalf);
+		while (level->x > 1 && level->y > 1) {
+			ImBuf *next = IMB_onehalf(level);
+			if (level != ibuf) {
+				IMB_freeImBuf(level);
+			}
+			level = next;
+		}
+		TIMEIT_END(IMB_onehalf);
+
+		EXPECT_EQ(level->x, 1);
+		if (level != ibuf) {
+			IMB_freeImBuf(level);
+		}
+		IMB_freeImBuf(ibuf);
+	}
+}
@@ -0,0 +1,64 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_utildefines.h"
+#include "BLI_math_vector.h"
+#include "BLI_threads.h"
+
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+}
+
+static void scaling_test_constant(eIMBScaleFilter filter, bool use_float, int newx, int newy)
+{
+	ImBuf *ibuf = IMB_allocImBuf(97, 61, 32, use_float ? IB_rectfloat : IB_rect);
+	const size_t len = (size_t)ibuf->x * ibuf->y;
+
+	for (size_t i = 0; i < len; i++) {
+		if (use_float) {
+			copy_v4_fl4(&ibuf->rect_float[i * 4], 0.25f, 0.5f, 0.75f, 1.0f);
+		}
+		else {
+			ibuf->rect[i] = 0xff3f7fbf;
+		}
+	}
+
+	EXPECT_TRUE(IMB_scaleImBuf_filter(ibuf, newx, newy, filter));
+	EXPECT_EQ(ibuf->x, newx);
+	EXPECT_EQ(ibuf->y, newy);
+
+	/* all filters are normalized, a constant image stays constant */
+	for (size_t i = 0; i < (size_t)newx * newy; i++) {
+		if (use_float) {
+			EXPECT_NEAR(ibuf->rect_float[i * 4 + 0], 0.25f, 1e-5f);
+			EXPECT_NEAR(ibuf->rect_float[i * 4 + 3], 1.0f, 1e-5f);
+		}
+		else {
+			EXPECT_EQ(ibuf->rect[i], 0xff3f7fbf);
+		}
+	}
+
+	IMB_freeImBuf(ibuf);
+}
+
+TEST(imbuf_scaling, ConstantImage)
+{
+	const eIMBScaleFilter filters[] = {IMB_SCALE_FILTER_BOX, IMB_SCALE_FILTER_BILINEAR, IMB_SCALE_FILTER_LANCZOS};
+
+	/* bigger sizes are scaled by the task scheduler */
+	BLI_threadapi_init();
+	IMB_init();
+
+	for (int i = 0; i < ARRAY_SIZE(filters); i++) {
+		for (int use_float = 0; use_float < 2; use_float++) {
+			scaling_test_constant(filters[i], use_float, 31, 17);
+			scaling_test_constant(filters[i], use_float, 250, 130);
+			scaling_test_constant(filters[i], use_float, 50, 200);
+		}
+	}
+
+	IMB_exit();
+	BLI_threadapi_exit();
+}
@@ -0,0 +1,95 @@
+/* Apache License, Version 2.0 */
+
+#ifndef __BLENDER_TESTING_BPH_CLOTH_GRID_H__
+#define __BLENDER_TESTING_BPH_CLOTH_GRID_H__
+
+/* A square piece of cloth pinned at one side, with structural and shear springs. */
+#define SPACING 0.02f
+#define MASS 0.01f
+#define STIFFNESS 50.0f
+#define DAMPING 0.1f
+#define DT (1.0f / 120.0f)
+
+static int cloth_grid_index(int res, int x, int y)
+{
+	return y * res + x;
+}
+
+static Implicit_Data *cloth_grid_create(int res)
+{
+	const int numsprings = 2 * res * (res - 1) + 2 * (res - 1) * (res - 1);
+	Implicit_Data *id = BPH_mass_spring_solver_create(res * res, numsprings);
+	const float zero[3] = {0.0f, 0.0f, 0.0f};
+	float unit[3][3];
+
+	unit_m3(unit);
+
+	for (int y = 0; y < res; y++) {
+		for (int x = 0; x < res; x++) {
+			const int i = cloth_grid_index(res, x, y);
+			const float co[3] = {x * SPACING, y * SPACING, 0.0f};
+
+			BPH_mass_spring_set_vertex_mass(id, i, MASS);
+			BPH_mass_spring_set_rest_transform(id, i, unit);
+			BPH_mass_spring_set_motion_state(id, i, co, zero);
+		}
+	}
+
+	return id;
+}
+
+static void cloth_grid_spring(Implicit_Data *id, int i, int j, float restlen)
+{
+	BPH_mass_spring_force_spring_linear(id, i, j, restlen, STIFFNESS, DAMPING, STIFFNESS, DAMPING, true, false, 0.0f);
+}
+
+static void cloth_grid_step(Implicit_Data *id, int res, ImplicitSolverResult *result)
+{
+	const float zero[3] = {0.0f, 0.0f, 0.0f};
+	const float gravity[3] = {0.0f, 0.0f, -9.81f};
+
+	BPH_mass_spring_clear_constraints(id);
+	for (int x = 0; x < res; x++) {
+		BPH_mass_spring_add_constraint_ndof0(id, cloth_grid_index(res, x, 0), zero);
+	}
+
+	BPH_mass_spring_clear_forces(id);
+	for (int i = 0; i < res * res; i++) {
+		BPH_mass_spring_force_gravity(id, i, MASS, gravity);
+	}
+
+	for (int y = 0; y < res; y++) {
+		for (int x = 0; x < res; x++) {
+			if (x + 1 < res) {
+				cloth_grid_spring(id, cloth_grid_index(res, x, y), cloth_grid_index(res, x + 1, y), SPACING);
+			}
+			if (y + 1 < res) {
+				cloth_grid_spring(id, cloth_grid_index(res, x, y), cloth_grid_index(res, x, y + 1), SPACING);
+			}
+			if (x + 1 < res && y + 1 < res) {
+				cloth_grid_spring(id, cloth_grid_index(res, x, y), cloth_grid_index(res, x + 1, y + 1), SPACING * M_SQRT2);
+				cloth_grid_spring(id, cloth_grid_index(res, x + 1, y), cloth_grid_index(res, x, y + 1), SPACING * M_SQRT2);
+			}
+		}
+	}
+
+	BPH_mass_spring_solve_velocities(id, DT, result);
+	BPH_mass_spring_solve_positions(id, DT);
+	BPH_mass_spring_apply_result(id);
+}
+
+static void cloth_grid_simulate(Implicit_Data *id, int res, int steps, int *r_iterations)
+{
+	*r_iterations = 0;
+
+	for (int step = 0; step < steps; step++) {
+		ImplicitSolverResult result;
+
+		cloth_grid_step(id, res, &result);
+
+		EXPECT_EQ(result.status, BPH_SOLVER_SUCCESS);
+		*r_iterations += result.iterations;
+	}
+}
+
+#endif  /* __BLENDER_TESTING_BPH_CLOTH_GRID_H__ */
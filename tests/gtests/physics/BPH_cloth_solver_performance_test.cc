@@ -0,0 +1,62 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_threads.h"
+#include "PIL_time_utildefines.h"
+
+#include "BPH_mass_spring.h"
+#include "intern/implicit.h"
+}
+
+#include "BPH_cloth_grid.h"
+
+/* the solver kernels run on the task scheduler, which can only be initialized once per process */
+class ClothSolverTest : public testing::Test
+{
+protected:
+	static void SetUpTestCase()
+	{
+		BLI_threadapi_init();
+	}
+
+	static void TearDownTestCase()
+	{
+		BLI_threadapi_exit();
+	}
+};
+
+static void cloth_solver_bench(int res, int steps, int preconditioner)
+{
+	Implicit_Data *id = cloth_grid_create(res);
+	int iterations;
+
+	printf("\n========== %dx%d vertices, %d steps, %s ==========\n",
+	       res, res, steps, preconditioner == BPH_PRECONDITIONER_BLOCK_JACOBI ? "block-Jacobi" : "no preconditioner");
+
+	BPH_mass_spring_solver_set_preconditioner(id, preconditioner);
+
+	TIMEIT_START(cloth_solve);
+	cloth_grid_simulate(id, res, steps, &iterations);
+	TIMEIT_END(cloth_solve);
+
+	printf("iterations: %d\n", iterations);
+
+	BPH_mass_spring_solver_free(id);
+}
+
+TEST_F(ClothSolverTest, Garment)
+{
+	cloth_solver_bench(100, 10, BPH_PRECONDITIONER_NONE);
+	cloth_solver_bench(100, 10, BPH_PRECONDITIONER_BLOCK_JACOBI);
+}
+
+TEST_F(ClothSolverTest, DenseGarment)
+{
+	cloth_solver_bench(320, 5, BPH_PRECONDITIONER_NONE);
+	cloth_solver_bench(320, 5, BPH_PRECONDITIONER_BLOCK_JACOBI);
+}
@@ -0,0 +1,92 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_threads.h"
+
+#include "BPH_mass_spring.h"
+#include "intern/implicit.h"
+}
+
+#include "BPH_cloth_grid.h"
+
+/* the solver kernels run on the task scheduler, which can only be initialized once per process */
+class ClothSolverTest : public testing::Test
+{
+protected:
+	static void SetUpTestCase()
+	{
+		BLI_threadapi_init();
+	}
+
+	static void TearDownTestCase()
+	{
+		BLI_threadapi_exit();
+	}
+};
+
+TEST_F(ClothSolverTest, Preconditioner)
+{
+	const int res = 48, steps = 10;
+	Implicit_Data *id = cloth_grid_create(res);
+	Implicit_Data *id_pre = cloth_grid_create(res);
+	int iterations, iterations_pre;
+
+	BPH_mass_spring_solver_set_preconditioner(id_pre, BPH_PRECONDITIONER_BLOCK_JACOBI);
+
+	cloth_grid_simulate(id, res, steps, &iterations);
+	cloth_grid_simulate(id_pre, res, steps, &iterations_pre);
+
+	/* the preconditioner must not cost iterations */
+	EXPECT_LE(iterations_pre, iterations);
+
+	for (int i = 0; i < res * res; i++) {
+		float x[3], x_pre[3];
+
+		BPH_mass_spring_get_position(id, i, x);
+		BPH_mass_spring_get_position(id_pre, i, x_pre);
+
+		EXPECT_NEAR(len_v3v3(x, x_pre), 0.0f, 1e-3f);
+
+		/* pinned row */
+		if (i < res) {
+			EXPECT_NEAR(x[1], 0.0f, 1e-6f);
+			EXPECT_NEAR(x[2], 0.0f, 1e-6f);
+		}
+	}
+
+	BPH_mass_spring_solver_free(id);
+	BPH_mass_spring_solver_free(id_pre);
+}
+
+TEST_F(ClothSolverTest, Deterministic)
+{
+	/* larger than one chunk of the parallel kernels */
+	const int res = 100, steps = 3;
+	Implicit_Data *id_a = cloth_grid_create(res);
+	Implicit_Data *id_b = cloth_grid_create(res);
+	int iterations_a, iterations_b;
+
+	cloth_grid_simulate(id_a, res, steps, &iterations_a);
+	cloth_grid_simulate(id_b, res, steps, &iterations_b);
+
+	EXPECT_EQ(iterations_a, iterations_b);
+
+	for (int i = 0; i < res * res; i++) {
+		float x_a[3], x_b[3];
+
+		BPH_mass_spring_get_position(id_a, i, x_a);
+		BPH_mass_spring_get_position(id_b, i, x_b);
+
+		EXPECT_EQ(x_a[0], x_b[0]);
+		EXPECT_EQ(x_a[1], x_b[1]);
+		EXPECT_EQ(x_a[2], x_b[2]);
+	}
+
+	BPH_mass_spring_solver_free(id_a);
+	BPH_mass_spring_solver_free(id_b);
+}
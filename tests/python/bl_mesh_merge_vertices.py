@@ -0,0 +1,66 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+# Check Mesh.merge_vertices welds coincident vertices.
+
+import bpy
+
+
+def mesh_two_quads(offset):
+    # Two quads sharing an edge, the shared edge is stored twice.
+    verts = (
+        (0.0, 0.0, 0.0), (1.0, 0.0, 0.0), (1.0, 1.0, 0.0), (0.0, 1.0, 0.0),
+        (1.0 + offset, 0.0, 0.0), (2.0, 0.0, 0.0), (2.0, 1.0, 0.0), (1.0 + offset, 1.0, 0.0),
+    )
+    faces = ((0, 1, 2, 3), (4, 5, 6, 7))
+    me = bpy.data.meshes.new("test_merge")
+    me.from_pydata(verts, (), faces)
+    me.update()
+    return me
+
+
+def test_merge():
+    me = mesh_two_quads(0.00001)
+    removed = me.merge_vertices(distance=0.0001)
+    assert removed == 2, removed
+    assert len(me.vertices) == 6, len(me.vertices)
+    assert len(me.polygons) == 2, len(me.polygons)
+    assert len(me.edges) == 7, len(me.edges)
+    assert not me.validate()
+    bpy.data.meshes.remove(me)
+
+
+def test_merge_none():
+    me = mesh_two_quads(0.1)
+    removed = me.merge_vertices(distance=0.0001)
+    assert removed == 0, removed
+    assert len(me.vertices) == 8, len(me.vertices)
+    assert len(me.polygons) == 2, len(me.polygons)
+    bpy.data.meshes.remove(me)
+
+
+def main():
+    test_merge()
+    test_merge_none()
+    print("All merge_vertices tests passed")
+
+
+if __name__ == "__main__":
+    main()